@@ -0,0 +1,444 @@
+/*
+ * CKBinaryCodec.cpp - this file implements the writer and reader for the
+ *                     compact binary encoding of the CKVariant and all the
+ *                     values it can hold. The numbers are always written
+ *                     little-endian, and on a little-endian host they are
+ *                     simply copied in and out of the buffer.
+ *
+ * $Id$
+ */
+
+//	System Headers
+#include <string.h>
+#include <sstream>
+
+//	Third-Party Headers
+
+//	Other Headers
+#include "CKBinaryCodec.h"
+#include "CKString.h"
+#include "CKException.h"
+
+//	Forward Declarations
+
+//	Private Constants
+
+//	Private Datatypes
+
+//	Private Data Constants
+/*
+ * The doubles are moved as their 64-bit patterns, so make sure that the
+ * compiler stops us if that's not the size of a double on this host.
+ */
+typedef char CKBinaryDoubleIs64Bits[(sizeof(double) == sizeof(unsigned long long)) ? 1 : -1];
+
+
+
+/*******************************************************************
+ *
+ *                     Binary Writer Class
+ *
+ *******************************************************************/
+/*
+ * This constructor takes the buffer that everything is going to
+ * be appended to. The writer doesn't clear it, so the caller can
+ * put several values in one buffer.
+ */
+CKBinaryWriter::CKBinaryWriter( std::string & aBuffer ) :
+	mBuffer(aBuffer)
+{
+}
+
+
+/*
+ * This is the standard destructor and it doesn't touch the buffer.
+ */
+CKBinaryWriter::~CKBinaryWriter()
+{
+}
+
+
+/*
+ * These methods append the simple values to the buffer - all the
+ * numbers little-endian, and the strings as the length and then
+ * the bytes with no terminating NULL.
+ */
+void CKBinaryWriter::putByte( unsigned char aValue )
+{
+	mBuffer.push_back((char)aValue);
+}
+
+
+void CKBinaryWriter::putUInt( unsigned int aValue )
+{
+	char	bytes[4];
+#ifdef CKBINARY_LITTLE_ENDIAN
+	memcpy(bytes, &aValue, 4);
+#else
+	bytes[0] = (char)(aValue & 0xff);
+	bytes[1] = (char)((aValue >> 8) & 0xff);
+	bytes[2] = (char)((aValue >> 16) & 0xff);
+	bytes[3] = (char)((aValue >> 24) & 0xff);
+#endif
+	mBuffer.append(bytes, 4);
+}
+
+
+void CKBinaryWriter::putInt( int aValue )
+{
+	putUInt((unsigned int)aValue);
+}
+
+
+void CKBinaryWriter::putDouble( double aValue )
+{
+	char	bytes[8];
+#ifdef CKBINARY_LITTLE_ENDIAN
+	memcpy(bytes, &aValue, 8);
+#else
+	unsigned long long	bits;
+	memcpy(&bits, &aValue, 8);
+	for (int i = 0; i < 8; ++i) {
+		bytes[i] = (char)(bits & 0xff);
+		bits >>= 8;
+	}
+#endif
+	mBuffer.append(bytes, 8);
+}
+
+
+void CKBinaryWriter::putBytes( const char *aData, int aLength )
+{
+	if (aLength > 0) {
+		mBuffer.append(aData, aLength);
+	}
+}
+
+
+void CKBinaryWriter::putString( const CKString & aString )
+{
+	int		len = aString.size();
+	putUInt((unsigned int)len);
+	putBytes(aString.c_str(), len);
+}
+
+
+/*
+ * This writes the header of a complete code with the given tag
+ * of the value that's going to follow it.
+ */
+void CKBinaryWriter::putHeader( CKBinaryTag aTag )
+{
+	mBuffer.append(CKBINARY_MAGIC, 2);
+	putByte(CKBINARY_VERSION);
+	putByte((unsigned char)aTag);
+}
+
+
+/*
+ * A nested value is written as a block - the length of its bytes
+ * and then the bytes - so that a reader can skip over it without
+ * having to decode it. The length isn't known until the value is
+ * written, so beginBlock() leaves room for it and returns where
+ * that is, and endBlock() fills it in.
+ */
+int CKBinaryWriter::beginBlock()
+{
+	int		mark = mBuffer.size();
+	putUInt(0);
+	return mark;
+}
+
+
+void CKBinaryWriter::endBlock( int aMark )
+{
+	unsigned int	len = mBuffer.size() - aMark - 4;
+	mBuffer[aMark] = (char)(len & 0xff);
+	mBuffer[aMark + 1] = (char)((len >> 8) & 0xff);
+	mBuffer[aMark + 2] = (char)((len >> 16) & 0xff);
+	mBuffer[aMark + 3] = (char)((len >> 24) & 0xff);
+}
+
+
+/*
+ * This makes sure the buffer has room for this many more bytes
+ * so that a big value isn't copied every time it grows.
+ */
+void CKBinaryWriter::reserve( int aLength )
+{
+	if (aLength > 0) {
+		mBuffer.reserve(mBuffer.size() + aLength);
+	}
+}
+
+
+/*
+ * This returns the number of bytes in the buffer.
+ */
+int CKBinaryWriter::size() const
+{
+	return mBuffer.size();
+}
+
+
+/*******************************************************************
+ *
+ *                     Binary Reader Class
+ *
+ *******************************************************************/
+/*
+ * This constructor takes the bytes of the code and how many there
+ * are. None of them are copied.
+ */
+CKBinaryReader::CKBinaryReader( const char *aData, int aLength ) :
+	mData((const unsigned char *)aData),
+	mLength(aLength),
+	mPosition(0)
+{
+	if ((mData == NULL) || (mLength < 0)) {
+		mData = (const unsigned char *)"";
+		mLength = 0;
+	}
+}
+
+
+/*
+ * This is the standard copy constructor - the copy starts at
+ * the same place in the same bytes.
+ */
+CKBinaryReader::CKBinaryReader( const CKBinaryReader & anOther ) :
+	mData(anOther.mData),
+	mLength(anOther.mLength),
+	mPosition(anOther.mPosition)
+{
+}
+
+
+/*
+ * This is the standard destructor and it doesn't touch the bytes.
+ */
+CKBinaryReader::~CKBinaryReader()
+{
+}
+
+
+CKBinaryReader & CKBinaryReader::operator=( const CKBinaryReader & anOther )
+{
+	mData = anOther.mData;
+	mLength = anOther.mLength;
+	mPosition = anOther.mPosition;
+	return *this;
+}
+
+
+/*
+ * These methods read the simple values from the code and move
+ * past them.
+ */
+unsigned char CKBinaryReader::getByte()
+{
+	need(1);
+	return mData[mPosition++];
+}
+
+
+unsigned int CKBinaryReader::getUInt()
+{
+	need(4);
+	unsigned int		retval;
+#ifdef CKBINARY_LITTLE_ENDIAN
+	memcpy(&retval, &mData[mPosition], 4);
+#else
+	const unsigned char	*p = &mData[mPosition];
+	retval = (unsigned int)p[0] | ((unsigned int)p[1] << 8) |
+			 ((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24);
+#endif
+	mPosition += 4;
+	return retval;
+}
+
+
+int CKBinaryReader::getInt()
+{
+	return (int)getUInt();
+}
+
+
+double CKBinaryReader::getDouble()
+{
+	need(8);
+	double		retval;
+#ifdef CKBINARY_LITTLE_ENDIAN
+	memcpy(&retval, &mData[mPosition], 8);
+#else
+	unsigned long long	bits = 0;
+	for (int i = 7; i >= 0; --i) {
+		bits = (bits << 8) | mData[mPosition + i];
+	}
+	memcpy(&retval, &bits, 8);
+#endif
+	mPosition += 8;
+	return retval;
+}
+
+
+/*
+ * This reads a count - an unsigned int that has to fit in an int
+ * and can't be more than the bytes left in the code, each value
+ * being at least 'aMinSize' bytes. That's how a bad code is caught
+ * before something huge is allocated for it.
+ */
+int CKBinaryReader::getCount( int aMinSize )
+{
+	int				start = mPosition;
+	unsigned int	cnt = getUInt();
+	if (aMinSize < 1) {
+		aMinSize = 1;
+	}
+	if (cnt > (unsigned int)(getRemaining() / aMinSize)) {
+		std::ostringstream	msg;
+		msg << "CKBinaryReader::getCount(int) - the count of " << cnt <<
+			" at byte " << start << " of the " << mLength << " byte code "
+			"can't fit in the rest of the code. This is a bad or truncated "
+			"binary code, and needs to be checked.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+	return (int)cnt;
+}
+
+
+/*
+ * This returns a pointer to the next 'aLength' bytes in the code
+ * and moves past them. The pointer is into the caller's code, so
+ * it's good as long as that is.
+ */
+const char *CKBinaryReader::getBytes( int aLength )
+{
+	need(aLength);
+	const char	*retval = (const char *)&mData[mPosition];
+	mPosition += aLength;
+	return retval;
+}
+
+
+/*
+ * This reads a string's length and returns a pointer to its bytes
+ * in the code, moving past them. This is how a string can be built
+ * right from the code without any copies in between.
+ */
+const char *CKBinaryReader::getStringBytes( int & aLength )
+{
+	aLength = getCount();
+	return getBytes(aLength);
+}
+
+
+/*
+ * This reads a string and puts it into the argument.
+ */
+void CKBinaryReader::getString( CKString & aString )
+{
+	int			len = 0;
+	const char	*bytes = getStringBytes(len);
+	aString.clear();
+	aString.append(bytes, len);
+}
+
+
+/*
+ * This reads and checks the header of a complete code and makes
+ * sure the value that follows it is of the kind we're expecting.
+ */
+void CKBinaryReader::getHeader( CKBinaryTag aTag )
+{
+	need(CKBINARY_HEADER_SIZE);
+	if (memcmp(&mData[mPosition], CKBINARY_MAGIC, 2) != 0) {
+		throw CKException(__FILE__, __LINE__, "CKBinaryReader::getHeader("
+			"CKBinaryTag) - the code doesn't start with the magic bytes of "
+			"a binary code. It's not something that a toBinary() method "
+			"wrote, and that needs to be looked into.");
+	}
+	mPosition += 2;
+	int		version = getByte();
+	if (version != CKBINARY_VERSION) {
+		std::ostringstream	msg;
+		msg << "CKBinaryReader::getHeader(CKBinaryTag) - the code is version " <<
+			version << " of the binary format, and this code can only read "
+			"version " << CKBINARY_VERSION << ".";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+	int		tag = getByte();
+	if (tag != aTag) {
+		std::ostringstream	msg;
+		msg << "CKBinaryReader::getHeader(CKBinaryTag) - the code holds a "
+			"value with tag " << tag << " but we were expecting tag " <<
+			aTag << ". The code is for a different kind of value.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+}
+
+
+/*
+ * This reads a block written by CKBinaryWriter::beginBlock() and
+ * endBlock() and returns a reader of just the bytes in it. This
+ * reader moves past the block.
+ */
+CKBinaryReader CKBinaryReader::getBlock()
+{
+	int				len = getCount();
+	const char		*bytes = getBytes(len);
+	return CKBinaryReader(bytes, len);
+}
+
+
+/*
+ * These return where we are in the code, how many bytes are left
+ * and if we're at the end of it.
+ */
+int CKBinaryReader::getPosition() const
+{
+	return mPosition;
+}
+
+
+int CKBinaryReader::getRemaining() const
+{
+	return (mLength - mPosition);
+}
+
+
+bool CKBinaryReader::atEnd() const
+{
+	return (mPosition >= mLength);
+}
+
+
+/*
+ * This throws a CKException if there's anything left in the code -
+ * a complete code has to be read all the way through.
+ */
+void CKBinaryReader::checkAtEnd() const
+{
+	if (!atEnd()) {
+		std::ostringstream	msg;
+		msg << "CKBinaryReader::checkAtEnd() - there are " << getRemaining() <<
+			" bytes left over at the end of the " << mLength << " byte code. "
+			"It's not a valid binary code for the value being read.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+}
+
+
+/*
+ * This throws a CKException if there are fewer than 'aLength'
+ * bytes left in the code.
+ */
+void CKBinaryReader::underrun( int aLength ) const
+{
+	std::ostringstream	msg;
+	msg << "CKBinaryReader::underrun(int) - a value of " << aLength <<
+		" bytes was to be read at byte " << mPosition << " of the " <<
+		mLength << " byte code, but there's not that much left. This is a "
+		"bad or truncated binary code, and needs to be checked.";
+	throw CKException(__FILE__, __LINE__, msg.str());
+}
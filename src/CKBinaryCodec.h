@@ -0,0 +1,253 @@
+/*
+ * CKBinaryCodec.h - this file defines the writer and reader for the compact
+ *                   binary encoding of the CKVariant and all the values it
+ *                   can hold. It's the binary cousin of the text codes from
+ *                   generateCodeFromValues() - everything is tagged and the
+ *                   strings and nested values are length-prefixed, so there's
+ *                   no formatting of numbers, no scanning for a delimiter, and
+ *                   no splitting of the code back into chunks to read it.
+ *
+ *                   All the numbers are written little-endian no matter what
+ *                   the host is, and the doubles are the raw IEEE-754 bits, so
+ *                   they come back exactly as they went out. A complete code
+ *                   from one of the toBinary() methods starts with a header of
+ *                   the magic "CK", the version of the format, and the tag of
+ *                   the kind of value that follows.
+ *
+ * $Id$
+ */
+#ifndef __CKBINARYCODEC_H
+#define __CKBINARYCODEC_H
+
+//	System Headers
+#include <string>
+
+//	Third-Party Headers
+
+//	Other Headers
+
+//	Forward Declarations
+class CKString;
+
+//	Public Constants
+/*
+ * These are the bytes that start every complete binary code, and the
+ * version of the format that this code writes and can read.
+ */
+#define	CKBINARY_MAGIC				"CK"
+#define	CKBINARY_VERSION			1
+#define	CKBINARY_HEADER_SIZE		4
+/*
+ * If we know the host is little-endian, the numbers can be copied in
+ * and out of the buffer directly. If not, they are done a byte at a
+ * time, which works everywhere.
+ */
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__)
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define	CKBINARY_LITTLE_ENDIAN
+#endif
+#elif defined(__i386__) || defined(__x86_64__)
+#define	CKBINARY_LITTLE_ENDIAN
+#endif
+
+//	Public Datatypes
+/*
+ * These are the tags that say what kind of value is next in the code.
+ * They are written as a single byte, and they are part of the format,
+ * so they can never be renumbered - only added to.
+ */
+enum CKBinaryTagEnum {
+	eBinaryUnknownTag = 0,
+	eBinaryStringTag = 1,
+	eBinaryNumberTag = 2,
+	eBinaryDateTag = 3,
+	eBinaryTableTag = 4,
+	eBinaryTimeSeriesTag = 5,
+	eBinaryPriceTag = 6,
+	eBinaryListTag = 7,
+	eBinaryTimeTableTag = 8
+};
+typedef CKBinaryTagEnum CKBinaryTag;
+
+//	Public Data Constants
+
+
+
+/*******************************************************************
+ *
+ *                     Binary Writer Class
+ *
+ *******************************************************************/
+/*
+ * This class appends the binary encoding of values to a std::string
+ * that the caller owns - a std::string as the codes can have any bytes
+ * in them, including NULLs.
+ */
+class CKBinaryWriter
+{
+	public:
+		/*
+		 * This constructor takes the buffer that everything is going to
+		 * be appended to. The writer doesn't clear it, so the caller can
+		 * put several values in one buffer.
+		 */
+		CKBinaryWriter( std::string & aBuffer );
+		/*
+		 * This is the standard destructor and it doesn't touch the buffer.
+		 */
+		virtual ~CKBinaryWriter();
+
+		/*
+		 * These methods append the simple values to the buffer - all the
+		 * numbers little-endian, and the strings as the length and then
+		 * the bytes with no terminating NULL.
+		 */
+		void putByte( unsigned char aValue );
+		void putUInt( unsigned int aValue );
+		void putInt( int aValue );
+		void putDouble( double aValue );
+		void putBytes( const char *aData, int aLength );
+		void putString( const CKString & aString );
+		/*
+		 * This writes the header of a complete code with the given tag
+		 * of the value that's going to follow it.
+		 */
+		void putHeader( CKBinaryTag aTag );
+		/*
+		 * A nested value is written as a block - the length of its bytes
+		 * and then the bytes - so that a reader can skip over it without
+		 * having to decode it. The length isn't known until the value is
+		 * written, so beginBlock() leaves room for it and returns where
+		 * that is, and endBlock() fills it in.
+		 */
+		int beginBlock();
+		void endBlock( int aMark );
+		/*
+		 * This makes sure the buffer has room for this many more bytes
+		 * so that a big value isn't copied every time it grows.
+		 */
+		void reserve( int aLength );
+		/*
+		 * This returns the number of bytes in the buffer.
+		 */
+		int size() const;
+
+	private:
+		CKBinaryWriter();
+		CKBinaryWriter( const CKBinaryWriter & anOther );
+		CKBinaryWriter & operator=( const CKBinaryWriter & anOther );
+
+		// this is the buffer we're appending to
+		std::string		& mBuffer;
+};
+
+
+/*******************************************************************
+ *
+ *                     Binary Reader Class
+ *
+ *******************************************************************/
+/*
+ * This class reads the values back out of a binary code. It doesn't
+ * copy the code, it just walks along it, so the caller has to keep it
+ * around while it's being read. If the code runs out before a value
+ * does, a CKException is thrown.
+ */
+class CKBinaryReader
+{
+	public:
+		/*
+		 * This constructor takes the bytes of the code and how many there
+		 * are. None of them are copied.
+		 */
+		CKBinaryReader( const char *aData, int aLength );
+		/*
+		 * This is the standard copy constructor - the copy starts at
+		 * the same place in the same bytes.
+		 */
+		CKBinaryReader( const CKBinaryReader & anOther );
+		/*
+		 * This is the standard destructor and it doesn't touch the bytes.
+		 */
+		virtual ~CKBinaryReader();
+		CKBinaryReader & operator=( const CKBinaryReader & anOther );
+
+		/*
+		 * These methods read the simple values from the code and move
+		 * past them.
+		 */
+		unsigned char getByte();
+		unsigned int getUInt();
+		int getInt();
+		double getDouble();
+		/*
+		 * This reads a count - an unsigned int that has to fit in an int
+		 * and can't be more than the bytes left in the code, each value
+		 * being at least 'aMinSize' bytes. That's how a bad code is caught
+		 * before something huge is allocated for it.
+		 */
+		int getCount( int aMinSize = 1 );
+		/*
+		 * This returns a pointer to the next 'aLength' bytes in the code
+		 * and moves past them. The pointer is into the caller's code, so
+		 * it's good as long as that is.
+		 */
+		const char *getBytes( int aLength );
+		/*
+		 * This reads a string's length and returns a pointer to its bytes
+		 * in the code, moving past them. This is how a string can be built
+		 * right from the code without any copies in between.
+		 */
+		const char *getStringBytes( int & aLength );
+		/*
+		 * This reads a string and puts it into the argument.
+		 */
+		void getString( CKString & aString );
+		/*
+		 * This reads and checks the header of a complete code and makes
+		 * sure the value that follows it is of the kind we're expecting.
+		 */
+		void getHeader( CKBinaryTag aTag );
+		/*
+		 * This reads a block written by CKBinaryWriter::beginBlock() and
+		 * endBlock() and returns a reader of just the bytes in it. This
+		 * reader moves past the block.
+		 */
+		CKBinaryReader getBlock();
+
+		/*
+		 * These return where we are in the code, how many bytes are left
+		 * and if we're at the end of it.
+		 */
+		int getPosition() const;
+		int getRemaining() const;
+		bool atEnd() const;
+		/*
+		 * This throws a CKException if there's anything left in the code -
+		 * a complete code has to be read all the way through.
+		 */
+		void checkAtEnd() const;
+
+	private:
+		CKBinaryReader();
+
+		/*
+		 * This throws a CKException if there are fewer than 'aLength'
+		 * bytes left in the code.
+		 */
+		inline void need( int aLength ) const
+		{
+			if ((aLength < 0) || (mLength - mPosition < aLength)) {
+				underrun(aLength);
+			}
+		}
+		void underrun( int aLength ) const;
+
+		// these are the bytes of the code and how many there are
+		const unsigned char		*mData;
+		int						mLength;
+		// ...and this is where we are in them
+		int						mPosition;
+};
+
+#endif	// __CKBINARYCODEC_H
@@ -0,0 +1,777 @@
+/*
+ * CKDelayQueue.h - this file defines a template class that is a queue of
+ *                  something where each element isn't available to be
+ *                  taken off the queue until its due time has arrived.
+ *                  This is very useful for things like retrying later
+ *                  and scheduled refreshes as there's no need to have a
+ *                  thread sleeping for each of them - the take() method
+ *                  will sleep only until the earliest element is due.
+ *
+ *                  The elements are kept in a binary heap ordered by the
+ *                  due time, then by the priority, and finally by the
+ *                  order they were added. Each scheduled element gets a
+ *                  handle that can be used to cancel it before it's taken
+ *                  off the queue. There is also a CKPriorityQueue defined
+ *                  here that is simply a delay queue where everything is
+ *                  due immediately, so the priority is all that matters.
+ *
+ * $Id$
+ */
+#ifndef __CKDELAYQUEUE_H
+#define __CKDELAYQUEUE_H
+
+//	System Headers
+#ifdef GPP2
+#include <ostream.h>
+#else
+#include <ostream>
+#endif
+#include <sstream>
+#include <sys/time.h>
+
+//	Third-Party Headers
+
+//	Other Headers
+#include "CKString.h"
+#include "CKFWMutex.h"
+#include "CKStackLocker.h"
+#include "CKFWConditional.h"
+#include "CKException.h"
+
+//	Forward Declarations
+template <class T> class CKDelayQueue;
+
+//	Public Constants
+
+//	Public Datatypes
+
+//	Public Data Constants
+/*
+ * This is the default starting number of elements that the queue will
+ * have room for. When the queue has to grow, it will double in size so
+ * that even with millions of pending elements there are only a handful
+ * of re-allocations.
+ */
+#define	CKDELAYQUEUE_DEFAULT_STARTING_SIZE		64
+
+
+/*******************************************************************
+ *
+ *                  Delay Queue Handle Class
+ *
+ *******************************************************************/
+/*
+ * When something is scheduled on a delay queue, the caller gets back
+ * one of these handles. It identifies the slot in the queue that holds
+ * the element as well as the 'generation' of that slot so that a stale
+ * handle - one for an element that's already been taken or cancelled -
+ * can never cancel something that was added later in the same slot.
+ */
+class CKDelayQueueHandle
+{
+	public:
+		CKDelayQueueHandle() :
+			mSlot(-1),
+			mGeneration(0)
+		{
+		}
+
+		CKDelayQueueHandle( int aSlot, unsigned int aGeneration ) :
+			mSlot(aSlot),
+			mGeneration(aGeneration)
+		{
+		}
+
+		// this returns true if this handle was ever given out by a queue
+		bool isValid() const
+		{
+			return (mSlot >= 0);
+		}
+
+		bool operator==( const CKDelayQueueHandle & anOther ) const
+		{
+			return ((mSlot == anOther.mSlot) && (mGeneration == anOther.mGeneration));
+		}
+
+		bool operator!=( const CKDelayQueueHandle & anOther ) const
+		{
+			return !operator==(anOther);
+		}
+
+		// this is the slot in the queue holding the element
+		int				mSlot;
+		// ...and this is the generation of that slot when it was given out
+		unsigned int	mGeneration;
+};
+
+
+/*******************************************************************
+ *
+ *                  Delay Queue Slot Class
+ *
+ *******************************************************************/
+/*
+ * Each element on the queue is held in one of these slots. The heap is
+ * then just an array of slot indexes, and each slot knows where it is
+ * in the heap so that a cancel can pull it out without searching.
+ */
+template <class T> class CKDelayQueueSlot
+{
+	public:
+		CKDelayQueueSlot() :
+			value(),
+			dueTime(0.0),
+			priority(0),
+			sequence(0),
+			heapIndex(-1),
+			generation(0),
+			nextFree(-1)
+		{
+		}
+
+		// this is the element the user scheduled
+		T				value;
+		// ...this is when it's due in seconds since the epoch
+		double			dueTime;
+		// ...higher priorities come off first when the due times are the same
+		int				priority;
+		// ...and this keeps it FIFO when all else is equal
+		unsigned long	sequence;
+		// this is where the slot is in the heap (-1 if it's not in use)
+		int				heapIndex;
+		// ...this is bumped each time the slot is re-used
+		unsigned int	generation;
+		// ...and this is the next free slot when this one is free
+		int				nextFree;
+};
+
+
+/*******************************************************************
+ *
+ *               Queue CKFWConditional Test Classes
+ *
+ *******************************************************************/
+/*
+ * In order to have take() wait as nicely as possible we need a test
+ * that keeps the waiter waiting while there's nothing due and nothing
+ * has changed at the head of the queue. If a new element shows up at
+ * the head, the waiter needs to wake up and re-compute how long it has
+ * to sleep, so the test remembers the number of head changes it saw.
+ */
+template <class T> class CKDelayQueueNotDueTest :
+	public ICKFWConditionalSpuriousTest
+{
+	public:
+		CKDelayQueueNotDueTest( CKDelayQueue<T> *aQueue, unsigned long aHeadChanges ) :
+			mQueuePtr(aQueue),
+			mHeadChanges(aHeadChanges)
+		{
+		}
+
+		virtual ~CKDelayQueueNotDueTest()
+		{
+			mQueuePtr = NULL;
+		}
+
+		virtual int test()
+		{
+			return ((mQueuePtr != NULL) &&
+					!mQueuePtr->headIsDue(CKDelayQueue<T>::now()) &&
+					(mQueuePtr->mHeadChanges == mHeadChanges));
+		}
+
+	private:
+		CKDelayQueue<T>		*mQueuePtr;
+		unsigned long		mHeadChanges;
+};
+
+
+/*
+ * This is the main class definition.
+ */
+template <class T> class CKDelayQueue
+{
+	friend class CKDelayQueueNotDueTest<T>;
+
+	public :
+		/********************************************************
+		 *
+		 *                Constructors/Destructor
+		 *
+		 ********************************************************/
+		/*
+		 * This form of the constructor allows the user to specify the
+		 * starting size of the queue. As the queue grows it doubles in
+		 * size, so this is really only a hint to save a few copies.
+		 */
+		CKDelayQueue( int anInitialCapacity = CKDELAYQUEUE_DEFAULT_STARTING_SIZE ) :
+			mSlots(NULL),
+			mHeap(NULL),
+			mSize(0),
+			mCapacity(0),
+			mFreeSlot(-1),
+			mUsedSlots(0),
+			mSequence(0),
+			mHeadChanges(0),
+			mMutex(),
+			mConditional(mMutex)
+		{
+			grow(anInitialCapacity > 0 ? anInitialCapacity : 1);
+		}
+
+
+		/*
+		 * This is the destructor for the queue and makes sure that
+		 * everything is cleaned up before leaving.
+		 */
+		virtual ~CKDelayQueue()
+		{
+			if (mSlots != NULL) {
+				delete [] mSlots;
+				mSlots = NULL;
+			}
+			if (mHeap != NULL) {
+				delete [] mHeap;
+				mHeap = NULL;
+			}
+		}
+
+
+		/********************************************************
+		 *
+		 *                Accessor Methods
+		 *
+		 ********************************************************/
+		/*
+		 * This pair of methods does what you'd expect - it returns the
+		 * number of pending elements in the queue - due or not.
+		 */
+		int size() const
+		{
+			return mSize;
+		}
+
+
+		int length() const
+		{
+			return mSize;
+		}
+
+
+		/*
+		 * This method returns the current capacity of the queue and
+		 * is NOT the size per se. The capacity is what this queue
+		 * will hold before having to resize it's contents.
+		 */
+		int capacity() const
+		{
+			return mCapacity;
+		}
+
+
+		/*
+		 * This method returns true if there's nothing pending on the
+		 * queue at all - due or not.
+		 */
+		bool empty() const
+		{
+			return (mSize == 0);
+		}
+
+
+		/*
+		 * This method returns the due time of the element at the head of
+		 * the queue in seconds since the epoch, or -1.0 if the queue is
+		 * empty. This is handy for a caller that wants to know how long
+		 * it could sleep.
+		 */
+		double getNextDueTime()
+		{
+			CKStackLocker	lockem(&mMutex);
+			return (mSize > 0 ? mSlots[mHeap[0]].dueTime : -1.0);
+		}
+
+
+		/*
+		 * This is the clock the queue runs on - the current time in
+		 * seconds since the epoch, to the microsecond.
+		 */
+		static double now()
+		{
+			timeval		tv;
+			gettimeofday(&tv, NULL);
+			return (double)tv.tv_sec + (double)tv.tv_usec/1000000.0;
+		}
+
+
+		/********************************************************
+		 *
+		 *                Element Accessing Methods
+		 *
+		 ********************************************************/
+		/*
+		 * This method places the element on the queue to be due in the
+		 * given number of milliseconds from now. The returned handle can
+		 * be used to cancel() the element before it's taken.
+		 */
+		CKDelayQueueHandle schedule( const T & anElem, int aDelayInMillis, int aPriority = 0 )
+		{
+			return scheduleAt(anElem, now() + aDelayInMillis/1000.0, aPriority);
+		}
+
+
+		/*
+		 * This method places the element on the queue to be due at the
+		 * given time in seconds since the epoch. If that's in the past,
+		 * the element is due right away.
+		 */
+		CKDelayQueueHandle scheduleAt( const T & anElem, double aDueTime, int aPriority = 0 )
+		{
+			// first, lock up this guy against changes
+			CKStackLocker	lockem(&mMutex);
+
+			// get a slot for this guy, growing if we have to
+			if (mFreeSlot < 0 && mUsedSlots >= mCapacity) {
+				grow(2 * mCapacity);
+			}
+			int		slot;
+			if (mFreeSlot >= 0) {
+				slot = mFreeSlot;
+				mFreeSlot = mSlots[slot].nextFree;
+			} else {
+				slot = mUsedSlots++;
+			}
+			CKDelayQueueSlot<T>		& s = mSlots[slot];
+			s.value = anElem;
+			s.dueTime = aDueTime;
+			s.priority = aPriority;
+			s.sequence = mSequence++;
+			s.nextFree = -1;
+
+			// put it at the bottom of the heap and let it find its place
+			mHeap[mSize] = slot;
+			s.heapIndex = mSize;
+			mSize++;
+			siftUp(s.heapIndex);
+
+			// if this is the new head, anyone waiting needs to re-think it
+			if (s.heapIndex == 0) {
+				mHeadChanges++;
+				mConditional.wakeWaiters();
+			}
+
+			return CKDelayQueueHandle(slot, s.generation);
+		}
+
+
+		/*
+		 * This method removes the element identified by the handle from
+		 * the queue if it's still pending. If it's already been taken or
+		 * cancelled, then this method returns false and does nothing.
+		 */
+		bool cancel( const CKDelayQueueHandle & aHandle )
+		{
+			bool		cancelled = false;
+
+			// first, lock up this guy against changes
+			CKStackLocker	lockem(&mMutex);
+
+			if ((aHandle.mSlot >= 0) && (aHandle.mSlot < mUsedSlots) &&
+				(mSlots[aHandle.mSlot].generation == aHandle.mGeneration) &&
+				(mSlots[aHandle.mSlot].heapIndex >= 0)) {
+				int		index = mSlots[aHandle.mSlot].heapIndex;
+				removeAt(index);
+				// if it was the head, the waiters need to re-think it
+				if (index == 0) {
+					mHeadChanges++;
+					mConditional.wakeWaiters();
+				}
+				cancelled = true;
+			}
+
+			return cancelled;
+		}
+
+
+		/*
+		 * When you want to take the next due element off the queue, and
+		 * are willing to wait for it, this is the method to call. It will
+		 * sleep until the earliest element on the queue is due - waking
+		 * up early only if something even earlier is scheduled - and then
+		 * return that element.
+		 */
+		T take()
+		{
+			T		retval;
+			take(retval, -1);
+			return retval;
+		}
+
+
+		/*
+		 * This form of take() waits no more than 'aTimeoutInMillis' for
+		 * an element to come due (-1 means forever, 0 means don't wait).
+		 * If one does, it's placed in 'anElem' and the method returns true,
+		 * otherwise the method returns false and 'anElem' is untouched.
+		 */
+		bool take( T & anElem, int aTimeoutInMillis )
+		{
+			bool		gotOne = false;
+			double		giveUpAt = (aTimeoutInMillis >= 0 ?
+									now() + aTimeoutInMillis/1000.0 : -1.0);
+
+			while (true) {
+				// see what's at the head of the queue right now
+				mMutex.lock();
+				double			due = (mSize > 0 ? mSlots[mHeap[0]].dueTime : -1.0);
+				unsigned long	changes = mHeadChanges;
+				mMutex.unlock();
+
+				// figure out how long we need to sleep - rounding up
+				double		rightNow = now();
+				int			wait = -1;
+				if (due >= 0.0) {
+					wait = millisUntil(due, rightNow);
+				}
+				if (giveUpAt >= 0.0) {
+					int		left = millisUntil(giveUpAt, rightNow);
+					if ((wait < 0) || (left < wait)) {
+						wait = left;
+					}
+				}
+
+				// now sleep until something is due, something changes, or we time out
+				CKDelayQueueNotDueTest<T>	tst(this, changes);
+				if (mConditional.lockAndTest(tst, wait) == FWCOND_LOCK_SUCCESS) {
+					// we have the lock, so see if the head is ready for us
+					if (headIsDue(now())) {
+						anElem = mSlots[mHeap[0]].value;
+						removeAt(0);
+						mHeadChanges++;
+						gotOne = true;
+					}
+					mMutex.unlock();
+					if (gotOne) {
+						break;
+					}
+				}
+
+				// if we've run out of time, then we're done
+				if ((giveUpAt >= 0.0) && (now() >= giveUpAt)) {
+					// ...but give it one last look without waiting
+					gotOne = poll(anElem);
+					break;
+				}
+			}
+
+			return gotOne;
+		}
+
+
+		/*
+		 * This method takes the head of the queue if it's due, and returns
+		 * true. If nothing is due, it returns false right away.
+		 */
+		bool poll( T & anElem )
+		{
+			bool		gotOne = false;
+
+			// first, lock up this guy against changes
+			CKStackLocker	lockem(&mMutex);
+
+			if (headIsDue(now())) {
+				anElem = mSlots[mHeap[0]].value;
+				removeAt(0);
+				mHeadChanges++;
+				gotOne = true;
+			}
+
+			return gotOne;
+		}
+
+
+		/*
+		 * This method allows the user to clear out the queue explicitly.
+		 * All outstanding handles become stale and cancel() will simply
+		 * return false for them.
+		 */
+		void clear()
+		{
+			CKStackLocker	lockem(&mMutex);
+
+			while (mSize > 0) {
+				removeAt(mSize - 1);
+			}
+			mHeadChanges++;
+			mConditional.wakeWaiters();
+		}
+
+
+		/********************************************************
+		 *
+		 *                Utility Methods
+		 *
+		 ********************************************************/
+		/*
+		 * Because there are times when it's useful to have a nice
+		 * human-readable form of the contents of this instance. Most of the
+		 * time this means that it's used for debugging, but it could be used
+		 * for just about anything. In these cases, it's nice not to have to
+		 * worry about the ownership of the representation, so this returns
+		 * a CKString. For this queue it's the size and when the head is
+		 * due - relative to now, so a negative number is overdue.
+		 */
+		CKString toString() const
+		{
+			std::ostringstream	buff;
+
+			CKStackLocker	lockem(&((CKDelayQueue<T> *)this)->mMutex);
+			buff << "CKDelayQueue: size=" << mSize << " capacity=" << mCapacity;
+			if (mSize > 0) {
+				const CKDelayQueueSlot<T>	& head = mSlots[mHeap[0]];
+				buff << " head due(sec)=" << (head.dueTime - now())
+					<< " priority=" << head.priority;
+			} else {
+				buff << " head due(sec)=none";
+			}
+
+			return CKString(buff.str());
+		}
+
+	protected:
+		/*
+		 * This method returns true if there's something on the queue and
+		 * the head of the queue is due at the provided time. The caller
+		 * needs to be holding the lock.
+		 */
+		bool headIsDue( double aTime ) const
+		{
+			return ((mSize > 0) && (mSlots[mHeap[0]].dueTime <= aTime));
+		}
+
+
+		/*
+		 * This is the number of milliseconds - rounded up so that we never
+		 * wake up a little early and spin - until the given time.
+		 */
+		static int millisUntil( double aTime, double aNow )
+		{
+			double		ms = (aTime - aNow) * 1000.0;
+			if (ms <= 0.0) {
+				return 0;
+			}
+			if (ms > 2000000000.0) {
+				return 2000000000;
+			}
+			int		retval = (int)ms;
+			return ((double)retval < ms ? retval + 1 : retval);
+		}
+
+
+		/*
+		 * This is the ordering of the heap - the earliest due time first,
+		 * then the highest priority, and then the order they were added.
+		 */
+		bool before( int aSlot, int anotherSlot ) const
+		{
+			const CKDelayQueueSlot<T>	& a = mSlots[aSlot];
+			const CKDelayQueueSlot<T>	& b = mSlots[anotherSlot];
+			if (a.dueTime != b.dueTime) {
+				return (a.dueTime < b.dueTime);
+			}
+			if (a.priority != b.priority) {
+				return (a.priority > b.priority);
+			}
+			return (a.sequence < b.sequence);
+		}
+
+
+		/*
+		 * These move the slot at the given heap index up or down the heap
+		 * until it's in the right place, keeping each slot's idea of where
+		 * it is in the heap up to date.
+		 */
+		void siftUp( int anIndex )
+		{
+			int		slot = mHeap[anIndex];
+			while (anIndex > 0) {
+				int		parent = (anIndex - 1)/2;
+				if (!before(slot, mHeap[parent])) {
+					break;
+				}
+				mHeap[anIndex] = mHeap[parent];
+				mSlots[mHeap[anIndex]].heapIndex = anIndex;
+				anIndex = parent;
+			}
+			mHeap[anIndex] = slot;
+			mSlots[slot].heapIndex = anIndex;
+		}
+
+
+		void siftDown( int anIndex )
+		{
+			int		slot = mHeap[anIndex];
+			while (true) {
+				int		child = 2*anIndex + 1;
+				if (child >= mSize) {
+					break;
+				}
+				if ((child + 1 < mSize) && before(mHeap[child + 1], mHeap[child])) {
+					child++;
+				}
+				if (!before(mHeap[child], slot)) {
+					break;
+				}
+				mHeap[anIndex] = mHeap[child];
+				mSlots[mHeap[anIndex]].heapIndex = anIndex;
+				anIndex = child;
+			}
+			mHeap[anIndex] = slot;
+			mSlots[slot].heapIndex = anIndex;
+		}
+
+
+		/*
+		 * This method pulls the element at the given heap index out of the
+		 * heap, releases its value and puts its slot on the free list. The
+		 * caller needs to be holding the lock.
+		 */
+		void removeAt( int anIndex )
+		{
+			int		slot = mHeap[anIndex];
+
+			// move the last one into this spot and fix up the heap
+			mSize--;
+			if (anIndex < mSize) {
+				mHeap[anIndex] = mHeap[mSize];
+				mSlots[mHeap[anIndex]].heapIndex = anIndex;
+				if ((anIndex > 0) && before(mHeap[anIndex], mHeap[(anIndex - 1)/2])) {
+					siftUp(anIndex);
+				} else {
+					siftDown(anIndex);
+				}
+			}
+
+			// now retire the slot so that stale handles can't hit it
+			CKDelayQueueSlot<T>		& s = mSlots[slot];
+			s.value = T();
+			s.heapIndex = -1;
+			s.generation++;
+			s.nextFree = mFreeSlot;
+			mFreeSlot = slot;
+		}
+
+
+		/*
+		 * This method grows the storage for the queue to hold the given
+		 * number of elements, copying over what's already there.
+		 */
+		void grow( int aNewCapacity )
+		{
+			CKDelayQueueSlot<T>	*slots = new CKDelayQueueSlot<T>[aNewCapacity];
+			int					*heap = new int[aNewCapacity];
+			if ((slots == NULL) || (heap == NULL)) {
+				std::ostringstream	msg;
+				msg << "CKDelayQueue<T>::grow(int) - while trying to create a new "
+					"buffer of " << aNewCapacity << " elements, an allocation error "
+					"occurred. Please look into this as soon as possible.";
+				throw CKException(__FILE__, __LINE__, msg.str());
+			}
+
+			// copy over what we have and then drop the old storage
+			for (int i = 0; i < mUsedSlots; ++i) {
+				slots[i] = mSlots[i];
+			}
+			for (int i = 0; i < mSize; ++i) {
+				heap[i] = mHeap[i];
+			}
+			if (mSlots != NULL) {
+				delete [] mSlots;
+			}
+			if (mHeap != NULL) {
+				delete [] mHeap;
+			}
+			mSlots = slots;
+			mHeap = heap;
+			mCapacity = aNewCapacity;
+		}
+
+	private:
+		/*
+		 * This is the storage for all the elements on the queue. Slots are
+		 * re-used through the free list, so the array only grows to the
+		 * largest number of elements ever pending at once.
+		 */
+		CKDelayQueueSlot<T>	*mSlots;
+		/*
+		 * This is the binary heap of slot indexes with the next element to
+		 * come due at index 0.
+		 */
+		int					*mHeap;
+		// this is the number of elements pending on the queue
+		int					mSize;
+		// ...this is the number of slots/heap entries we have room for
+		int					mCapacity;
+		// ...this is the head of the free slot list (-1 if empty)
+		int					mFreeSlot;
+		// ...and this is the number of slots ever handed out
+		int					mUsedSlots;
+		/*
+		 * This is the counter that keeps elements with the same due time
+		 * and priority in the order they were added.
+		 */
+		unsigned long		mSequence;
+		/*
+		 * Every time the head of the queue changes this is incremented so
+		 * that the waiters in take() know to re-compute how long to sleep.
+		 */
+		unsigned long		mHeadChanges;
+		/*
+		 * When it comes to messing with this queue, we're going to make
+		 * sure that it can play well in a multi-threaded environment. To
+		 * that end, we're going to cover the bases with a nice mutex.
+		 */
+		CKFWMutex			mMutex;
+		/*
+		 * The takers wait on this conditional until the head is due or
+		 * something new shows up at the head.
+		 */
+		CKFWConditional		mConditional;
+
+		// we can't allow copies as the handles are tied to this instance
+		CKDelayQueue( const CKDelayQueue<T> & anOther );
+		CKDelayQueue<T> & operator=( const CKDelayQueue<T> & anOther );
+};
+
+
+/*
+ * This is the priority form of the delay queue. Everything pushed onto it
+ * is due immediately, so the elements come off in priority order - the
+ * highest first - and in the order they were pushed within a priority.
+ * The take() methods, the handles and cancel() all work the same way.
+ */
+template <class T> class CKPriorityQueue :
+	public CKDelayQueue<T>
+{
+	public:
+		CKPriorityQueue( int anInitialCapacity = CKDELAYQUEUE_DEFAULT_STARTING_SIZE ) :
+			CKDelayQueue<T>(anInitialCapacity)
+		{
+		}
+
+		virtual ~CKPriorityQueue()
+		{
+		}
+
+		/*
+		 * This method places the element on the queue with the given
+		 * priority. Since the due time is the beginning of time, it's
+		 * available to take() right away.
+		 */
+		CKDelayQueueHandle push( const T & anElem, int aPriority = 0 )
+		{
+			return CKDelayQueue<T>::scheduleAt(anElem, 0.0, aPriority);
+		}
+};
+
+#endif	// __CKDELAYQUEUE_H
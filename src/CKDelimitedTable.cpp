@@ -0,0 +1,1108 @@
+/*
+ * CKDelimitedTable.cpp - this file implements the reading and writing of
+ *                        CKTables as delimited text - CSV, TSV and the
+ *                        like. The reader streams the file through a buffer,
+ *                        looks at the first rows to see what type each column
+ *                        is, and then parses every field right into the dense
+ *                        column it belongs in. The fields are found with AVX2
+ *                        thirty-two bytes at a time when the processor has it,
+ *                        and the numbers are made without strtod() when they
+ *                        can be made exactly. The writer streams the rows out
+ *                        through a buffer the same way.
+ *
+ * $Id$
+ */
+
+//	System Headers
+#include <string>
+#include <vector>
+#include <sstream>
+#include <errno.h>
+#include <fcntl.h>
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+//	Third-Party Headers
+#include <CKException.h>
+
+//	Other Headers
+#include "CKDelimitedTable.h"
+#include "CKVariant.h"
+#include "CKVectorMath.h"
+/*
+ * The intrinsics can only be pulled in once the vector math header
+ * has said if the AVX2 kernels can be built.
+ */
+#ifdef CKVECTOR_HAVE_AVX2
+#include <immintrin.h>
+#endif
+
+//	Forward Declarations
+
+//	Private Constants
+/*
+ * This is how much of the file the reader holds at once - it grows if
+ * a single row is bigger than this - and how much the writer holds
+ * before it's written out. The reader's buffer has room past the end
+ * for the scanner to read a whole block of it.
+ */
+#define	CKDELIMITEDTABLE_BUFFER_SIZE	(1024 * 1024)
+#define	CKDELIMITEDTABLE_PADDING		32
+/*
+ * These are how the reader makes each column - as a dense column of
+ * numbers or dates, as strings, or each cell typed on its own.
+ */
+#define	CKDELIMITEDTABLE_NUMBER_COLUMN	0
+#define	CKDELIMITEDTABLE_DATE_COLUMN	1
+#define	CKDELIMITEDTABLE_STRING_COLUMN	2
+#define	CKDELIMITEDTABLE_MIXED_COLUMN	3
+/*
+ * A number with no more than fifteen digits, times or over a power of
+ * ten no bigger than 1e22, is exactly the double strtod() would make -
+ * as long as the math is done in doubles, and not the x87's longer
+ * registers. If it isn't, only the plain integers are made here.
+ */
+#if !defined(FLT_EVAL_METHOD) || (FLT_EVAL_METHOD == 0)
+#define	CKDELIMITEDTABLE_MAX_FAST_EXPONENT	22
+#else
+#define	CKDELIMITEDTABLE_MAX_FAST_EXPONENT	0
+#endif
+
+#ifdef CKVECTOR_HAVE_AVX2
+#define CKDELIMITEDTABLE_AVX2	__attribute__((target("avx2")))
+#endif
+
+//	Private Datatypes
+/*
+ * This is one field of a row, right in the reader's buffer. A quoted
+ * field is just what's between the quotes, and once the row is done,
+ * its doubled quotes have been made single and it's NULL-terminated.
+ */
+struct CKDelimitedField {
+	char	*data;
+	int		length;
+	bool	quoted;
+	bool	escaped;
+};
+
+
+/*
+ * This is a field of one of the rows the column types are decided on -
+ * where it is in the copy of them, or -1 if the row didn't have it.
+ */
+struct CKDelimitedSampleField {
+	int		offset;
+	int		length;
+	bool	quoted;
+};
+
+
+/*
+ * These are the powers of ten that are exactly doubles.
+ */
+static const double	sPowersOfTen[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+
+/*
+ * This makes the number in the field, and returns false if it's not
+ * one - all of it, with nothing before or after. It takes what strtod()
+ * takes in decimal, and NaNs and infinities, but not hex. The usual
+ * numbers are made right here, and the long ones are left to strtod(),
+ * so the field has to be NULL-terminated.
+ */
+static bool parseNumber( const char *aField, int aLength, double & aValue )
+{
+	const char			*p = aField;
+	const char			*end = aField + aLength;
+	bool				negative = false;
+	if ((p < end) && ((*p == '-') || (*p == '+'))) {
+		negative = (*p == '-');
+		++p;
+	}
+
+	// the digits, keeping only as many as fit
+	unsigned long long	mantissa = 0;
+	int					digits = 0;
+	int					exponent = 0;
+	bool				any = false;
+	for (; (p < end) && ((unsigned int)(*p - '0') < 10); ++p) {
+		any = true;
+		if (digits < 19) {
+			mantissa = mantissa * 10 + (*p - '0');
+			digits += (mantissa != 0 ? 1 : 0);
+		} else {
+			++exponent;
+		}
+	}
+	if ((p < end) && (*p == '.')) {
+		for (++p; (p < end) && ((unsigned int)(*p - '0') < 10); ++p) {
+			any = true;
+			if (digits < 19) {
+				mantissa = mantissa * 10 + (*p - '0');
+				digits += (mantissa != 0 ? 1 : 0);
+				--exponent;
+			}
+		}
+	}
+	if (!any) {
+		// it could still be a NaN or infinity
+		if ((p == end) || ((*p != 'n') && (*p != 'N') && (*p != 'i') && (*p != 'I'))) {
+			return false;
+		}
+		char	*stop = NULL;
+		aValue = strtod(aField, &stop);
+		return (stop == end) && (isnan(aValue) || isinf(aValue));
+	}
+	if ((p < end) && ((*p == 'e') || (*p == 'E'))) {
+		bool	negativeExponent = false;
+		int		e = 0;
+		++p;
+		if ((p < end) && ((*p == '-') || (*p == '+'))) {
+			negativeExponent = (*p == '-');
+			++p;
+		}
+		if ((p == end) || ((unsigned int)(*p - '0') >= 10)) {
+			return false;
+		}
+		for (; (p < end) && ((unsigned int)(*p - '0') < 10); ++p) {
+			if (e < 100000) {
+				e = e * 10 + (*p - '0');
+			}
+		}
+		exponent += (negativeExponent ? -e : e);
+	}
+	if (p != end) {
+		return false;
+	}
+
+	if (mantissa == 0) {
+		aValue = (negative ? -0.0 : 0.0);
+	} else if ((digits <= 15) && (exponent >= -CKDELIMITEDTABLE_MAX_FAST_EXPONENT) &&
+			   (exponent <= CKDELIMITEDTABLE_MAX_FAST_EXPONENT)) {
+		double	v = (double)mantissa;
+		v = (exponent < 0 ? v / sPowersOfTen[-exponent] : v * sPowersOfTen[exponent]);
+		aValue = (negative ? -v : v);
+	} else {
+		aValue = strtod(aField, NULL);
+	}
+	return true;
+}
+
+
+/*
+ * This makes the date in the field - one that CKVariant::isDate() says
+ * is a date, so it's read back as one - and returns false if it's not.
+ * The field has to be NULL-terminated.
+ */
+static bool parseDate( const char *aField, int aLength, long & aValue )
+{
+	if (aLength != 8) {
+		return false;
+	}
+	long	v = 0;
+	for (int i = 0; i < 8; ++i) {
+		if ((unsigned int)(aField[i] - '0') >= 10) {
+			return false;
+		}
+		v = v * 10 + (aField[i] - '0');
+	}
+	if (!CKVariant::isDate(aField)) {
+		return false;
+	}
+	aValue = v;
+	return true;
+}
+
+
+/*
+ * This writes the number into the buffer - which has to hold at least
+ * 32 characters - as short as it can be and still be read back as the
+ * same number, and returns its length. The whole numbers are done
+ * right here, and the rest with snprintf().
+ */
+static int formatNumber( double aValue, char *aBuffer )
+{
+	if ((aValue == floor(aValue)) && (fabs(aValue) < 1e15)) {
+		long long	n = (long long)aValue;
+		char		digits[24];
+		int			cnt = 0;
+		int			len = 0;
+		unsigned long long	bits;
+		memcpy(&bits, &aValue, sizeof(bits));
+		if ((n < 0) || ((n == 0) && ((bits >> 63) != 0))) {
+			aBuffer[len++] = '-';
+			n = -n;
+		}
+		do {
+			digits[cnt++] = (char)('0' + (n % 10));
+			n /= 10;
+		} while (n > 0);
+		while (cnt > 0) {
+			aBuffer[len++] = digits[--cnt];
+		}
+		aBuffer[len] = '\0';
+		return len;
+	}
+
+	int		len = snprintf(aBuffer, 32, "%.15g", aValue);
+	if (!isnan(aValue) && (strtod(aBuffer, NULL) != aValue)) {
+		len = snprintf(aBuffer, 32, "%.17g", aValue);
+	}
+	return len;
+}
+
+
+/*
+ * This finds the next character that means something to the reader -
+ * the delimiter, a quote, or a line break - a character at a time. The
+ * reader puts a line break just past the end of what it's read, so it
+ * always stops there.
+ */
+class CKDelimitedPlainScanner
+{
+	public:
+		CKDelimitedPlainScanner( const unsigned char *aSpecial, char *anEnd ) :
+			mSpecial(aSpecial), mEnd(anEnd) { }
+		inline char *next( char *aPos )
+		{
+			while (!mSpecial[(unsigned char)*aPos]) {
+				++aPos;
+			}
+			return (aPos < mEnd ? aPos : mEnd);
+		}
+
+	private:
+		const unsigned char		*mSpecial;
+		char					*mEnd;
+};
+
+
+#ifdef CKVECTOR_HAVE_AVX2
+/*
+ * This returns a bit for each of the 32 bytes at the pointer that's the
+ * delimiter, a quote, or a line break.
+ */
+CKDELIMITEDTABLE_AVX2 static unsigned int specialMask( const char *aPos, char aDelimiter )
+{
+	__m256i		v = _mm256_loadu_si256((const __m256i *)aPos);
+	__m256i		a = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(aDelimiter)),
+									_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')));
+	__m256i		b = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')),
+									_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')));
+	return (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(a, b));
+}
+
+
+/*
+ * This finds the same characters as the plain scanner, but looks at 32
+ * bytes at once and keeps the bits of the ones it found, so the fields
+ * in them are found without looking at the bytes again. It has to be
+ * asked for positions that only go forward, as the reader does.
+ */
+class CKDelimitedAVX2Scanner
+{
+	public:
+		CKDelimitedAVX2Scanner( char aDelimiter, char *anEnd ) :
+			mDelimiter(aDelimiter), mEnd(anEnd), mBase(NULL), mMask(0) { }
+		inline char *next( char *aPos )
+		{
+			while (aPos < mEnd) {
+				if ((mBase == NULL) || (aPos >= mBase + 32)) {
+					mBase = aPos;
+					mMask = specialMask(aPos, mDelimiter);
+				}
+				unsigned int	m = mMask >> (aPos - mBase);
+				if (m != 0) {
+					char	*found = aPos + __builtin_ctz(m);
+					return (found < mEnd ? found : mEnd);
+				}
+				aPos = mBase + 32;
+			}
+			return mEnd;
+		}
+
+	private:
+		char			mDelimiter;
+		char			*mEnd;
+		char			*mBase;
+		unsigned int	mMask;
+};
+#endif
+
+
+/*
+ * This reads the file a row at a time through its buffer. Each row is
+ * found in the buffer without changing it, and if it runs off the end
+ * of what's been read, more is read and it's found again from the
+ * start. Only then are its fields fixed up in place.
+ */
+class CKDelimitedReader
+{
+	public:
+		CKDelimitedReader( int aFd, char aDelimiter ) :
+			mFd(aFd), mDelimiter(aDelimiter),
+			mBuffer(CKDELIMITEDTABLE_BUFFER_SIZE + CKDELIMITEDTABLE_PADDING),
+			mCapacity(CKDELIMITEDTABLE_BUFFER_SIZE), mBegin(0), mEnd(0),
+			mEOF(false), mRecords(0), mConsumed(0),
+			mUseSIMD(CKVectorMath::useSIMD()), mSkipEmpty(true)
+		{
+			memset(mSpecial, 0, sizeof(mSpecial));
+			mSpecial[(unsigned char)aDelimiter] = 1;
+			mSpecial[(unsigned char)'"'] = 1;
+			mSpecial[(unsigned char)'\n'] = 1;
+			mSpecial[(unsigned char)'\r'] = 1;
+		}
+
+		/*
+		 * This gets the fields of the next row - skipping the empty lines
+		 * unless it's been told not to - and returns false at the end of
+		 * the file. The fields are good until this is called again.
+		 */
+		bool nextRecord( std::vector<CKDelimitedField> & aFields )
+		{
+			while (true) {
+				if (mBegin == mEnd) {
+					if (mEOF) {
+						return false;
+					}
+					fill();
+					continue;
+				}
+				int		end = -1;
+#ifdef CKVECTOR_HAVE_AVX2
+				if (mUseSIMD) {
+					end = parseRecord(aFields, CKDelimitedAVX2Scanner(mDelimiter,
+								&mBuffer[0] + mEnd));
+				} else
+#endif
+				end = parseRecord(aFields, CKDelimitedPlainScanner(mSpecial,
+								&mBuffer[0] + mEnd));
+				if (end < 0) {
+					fill();
+					continue;
+				}
+				mConsumed += end - mBegin;
+				mBegin = end;
+				++mRecords;
+				if (mSkipEmpty && (aFields.size() == 1) && (aFields[0].length == 0) &&
+					!aFields[0].quoted) {
+					continue;
+				}
+
+				for (unsigned int k = 0; k < aFields.size(); ++k) {
+					CKDelimitedField	& field = aFields[k];
+					if (field.escaped) {
+						int		len = 0;
+						for (int i = 0; i < field.length; ++i) {
+							field.data[len++] = field.data[i];
+							i += (field.data[i] == '"' ? 1 : 0);
+						}
+						field.length = len;
+					}
+					field.data[field.length] = '\0';
+				}
+				return true;
+			}
+		}
+
+		/*
+		 * This says if the empty lines are skipped. With just one column,
+		 * they're the rows with an empty cell, so they can't be.
+		 */
+		void setSkipEmpty( bool aFlag )
+		{
+			mSkipEmpty = aFlag;
+		}
+
+		/*
+		 * This returns the number of rows read so far - the header and
+		 * the empty ones, too.
+		 */
+		int getRecordNumber() const
+		{
+			return mRecords;
+		}
+
+		/*
+		 * This returns the number of bytes of the file in all the rows
+		 * read so far.
+		 */
+		long long getBytesRead() const
+		{
+			return mConsumed;
+		}
+
+	private:
+		/*
+		 * This finds the row at the start of the buffer and returns where
+		 * it ends, or -1 if it runs past what's been read so far.
+		 */
+		template <class SCANNER> int parseRecord( std::vector<CKDelimitedField> & aFields,
+												  SCANNER aScanner )
+		{
+			char	*buff = &mBuffer[0];
+			char	*p = buff + mBegin;
+			char	*end = buff + mEnd;
+			*end = '\n';
+			aFields.clear();
+			while (true) {
+				CKDelimitedField	field;
+				char				*s = NULL;
+				field.quoted = false;
+				field.escaped = false;
+				if ((p < end) && (*p == '"')) {
+					// find the quote that closes it, skipping the doubled ones
+					field.quoted = true;
+					field.data = p + 1;
+					char	*q = p + 1;
+					while (true) {
+						s = aScanner.next(q);
+						if (s == end) {
+							if (!mEOF) {
+								return -1;
+							}
+							std::ostringstream	msg;
+							msg << "CKDelimitedReader::nextRecord(std::vector<CKDelimitedField> &) - "
+								"the quote at the start of a field in row " << (mRecords + 1) <<
+								" of the file is never closed.";
+							throw CKException(__FILE__, __LINE__, msg.str());
+						}
+						if (*s != '"') {
+							q = s + 1;
+						} else if ((s + 1 == end) && !mEOF) {
+							return -1;
+						} else if ((s + 1 < end) && (s[1] == '"')) {
+							field.escaped = true;
+							q = s + 2;
+						} else {
+							break;
+						}
+					}
+					field.length = s - field.data;
+					++s;
+					if ((s < end) && (*s != mDelimiter) && (*s != '\n') && (*s != '\r')) {
+						std::ostringstream	msg;
+						msg << "CKDelimitedReader::nextRecord(std::vector<CKDelimitedField> &) - "
+							"there's more to field " << (aFields.size() + 1) << " of row " <<
+							(mRecords + 1) << " of the file after the quote that closes it.";
+						throw CKException(__FILE__, __LINE__, msg.str());
+					}
+				} else {
+					// a quote in the middle of a field is just a quote
+					field.data = p;
+					s = aScanner.next(p);
+					while ((s < end) && (*s == '"')) {
+						s = aScanner.next(s + 1);
+					}
+					field.length = s - p;
+				}
+				aFields.push_back(field);
+
+				if (s == end) {
+					return (mEOF ? mEnd : -1);
+				} else if (*s == mDelimiter) {
+					p = s + 1;
+				} else if (*s == '\n') {
+					return (s + 1) - buff;
+				} else if ((s + 1 == end) && !mEOF) {
+					// it's a carriage return that might have a new line after it
+					return -1;
+				} else {
+					return ((s + 1 < end) && (s[1] == '\n') ? s + 2 : s + 1) - buff;
+				}
+			}
+		}
+
+		/*
+		 * This moves what's left of the buffer to the front - making it
+		 * bigger if it's all one row - and reads more of the file into it.
+		 */
+		void fill()
+		{
+			if (mBegin > 0) {
+				memmove(&mBuffer[0], &mBuffer[mBegin], mEnd - mBegin);
+				mEnd -= mBegin;
+				mBegin = 0;
+			}
+			if (mEnd == mCapacity) {
+				mCapacity *= 2;
+				mBuffer.resize(mCapacity + CKDELIMITEDTABLE_PADDING);
+			}
+			while (true) {
+				ssize_t		cnt = ::read(mFd, &mBuffer[mEnd], mCapacity - mEnd);
+				if (cnt > 0) {
+					mEnd += cnt;
+				} else if (cnt == 0) {
+					mEOF = true;
+				} else if (errno == EINTR) {
+					continue;
+				} else {
+					std::ostringstream	msg;
+					msg << "CKDelimitedReader::fill() - the file couldn't be read: " <<
+						strerror(errno);
+					throw CKException(__FILE__, __LINE__, msg.str());
+				}
+				break;
+			}
+		}
+
+		int						mFd;
+		char					mDelimiter;
+		std::vector<char>		mBuffer;
+		int						mCapacity;
+		int						mBegin;
+		int						mEnd;
+		bool					mEOF;
+		int						mRecords;
+		long long				mConsumed;
+		bool					mUseSIMD;
+		bool					mSkipEmpty;
+		unsigned char			mSpecial[256];
+};
+
+
+/*
+ * This writes the file through a buffer, so each field is just copied
+ * into it, and it's written out when it's full.
+ */
+class CKDelimitedWriter
+{
+	public:
+		CKDelimitedWriter( int aFd, char aDelimiter ) :
+			mFd(aFd), mDelimiter(aDelimiter),
+			mBuffer(CKDELIMITEDTABLE_BUFFER_SIZE), mSize(0)
+		{
+		}
+		inline void put( char aChar )
+		{
+			if (mSize == CKDELIMITEDTABLE_BUFFER_SIZE) {
+				flush();
+			}
+			mBuffer[mSize++] = aChar;
+		}
+		inline void put( const char *aData, int aLength )
+		{
+			if (mSize + aLength > CKDELIMITEDTABLE_BUFFER_SIZE) {
+				flush();
+				if (aLength > CKDELIMITEDTABLE_BUFFER_SIZE) {
+					writeOut(aData, aLength);
+					return;
+				}
+			}
+			memcpy(&mBuffer[mSize], aData, aLength);
+			mSize += aLength;
+		}
+		/*
+		 * This writes a string in quotes if it has to be - if it has a
+		 * delimiter, quote or line break in it - or if it's a cell that
+		 * would otherwise be read back as empty, or as a number or date.
+		 */
+		void putString( const char *aString, int aLength, bool isCell )
+		{
+			bool	quote = (isCell && (aLength == 0));
+			for (int i = 0; !quote && (i < aLength); ++i) {
+				char	c = aString[i];
+				quote = ((c == mDelimiter) || (c == '"') || (c == '\n') || (c == '\r'));
+			}
+			double	v;
+			if (!quote && isCell && parseNumber(aString, aLength, v)) {
+				quote = true;
+			}
+			if (!quote) {
+				put(aString, aLength);
+				return;
+			}
+			put('"');
+			const char	*start = aString;
+			const char	*end = aString + aLength;
+			for (const char *p = aString; p < end; ++p) {
+				if (*p == '"') {
+					put(start, p + 1 - start);
+					start = p;
+				}
+			}
+			put(start, end - start);
+			put('"');
+		}
+		void putNumber( double aValue )
+		{
+			char	buff[32];
+			put(buff, formatNumber(aValue, buff));
+		}
+		void putDate( long aValue )
+		{
+			char	buff[32];
+			put(buff, snprintf(buff, sizeof(buff), "%ld", aValue));
+		}
+		void flush()
+		{
+			writeOut(&mBuffer[0], mSize);
+			mSize = 0;
+		}
+
+	private:
+		void writeOut( const char *aData, int aLength )
+		{
+			while (aLength > 0) {
+				ssize_t		cnt = ::write(mFd, aData, aLength);
+				if (cnt < 0) {
+					if (errno == EINTR) {
+						continue;
+					}
+					std::ostringstream	msg;
+					msg << "CKDelimitedWriter::flush() - the table couldn't be "
+						"written to the file: " << strerror(errno);
+					throw CKException(__FILE__, __LINE__, msg.str());
+				}
+				aData += cnt;
+				aLength -= cnt;
+			}
+		}
+
+		int						mFd;
+		char					mDelimiter;
+		std::vector<char>		mBuffer;
+		int						mSize;
+};
+
+
+/*
+ * This decides how a column is made from the rows of the sample. If
+ * they're all numbers, or all dates, it's a dense column of them, and
+ * if none of them are, it's a column of strings. If it's a mix, each
+ * cell is typed on its own. A column with nothing in it is a dense
+ * column of numbers.
+ */
+static int kindOfColumn( const std::string & aStore,
+						 const std::vector<CKDelimitedSampleField> & aSample,
+						 int aFieldsPerRow, int aField )
+{
+	bool	hasNumber = false;
+	bool	hasDate = false;
+	bool	hasString = false;
+	for (unsigned int k = aField; k < aSample.size(); k += aFieldsPerRow) {
+		const CKDelimitedSampleField	& field = aSample[k];
+		const char						*data = aStore.data() + field.offset;
+		double							number;
+		long							date;
+		if ((field.offset < 0) || ((field.length == 0) && !field.quoted)) {
+			continue;
+		} else if (field.quoted) {
+			hasString = true;
+		} else if (parseDate(data, field.length, date)) {
+			hasDate = true;
+		} else if (parseNumber(data, field.length, number)) {
+			hasNumber = true;
+		} else {
+			hasString = true;
+		}
+	}
+
+	if (hasString) {
+		return ((hasNumber || hasDate) ? CKDELIMITEDTABLE_MIXED_COLUMN :
+				CKDELIMITEDTABLE_STRING_COLUMN);
+	} else if (hasDate) {
+		return (hasNumber ? CKDELIMITEDTABLE_MIXED_COLUMN : CKDELIMITEDTABLE_DATE_COLUMN);
+	}
+	return CKDELIMITEDTABLE_NUMBER_COLUMN;
+}
+
+
+/*
+ * This puts the field in the cell of the table, the way the column is
+ * made. If it doesn't fit a dense column, the column is changed to
+ * have each cell typed on its own from then on - putting a string in
+ * the table's dense column turns it into CKVariants, so the values
+ * already in it stay what they are. The field has to be NULL-terminated.
+ */
+static void setCell( CKTable & aTable, int aRow, int aCol, const char *aData,
+					 int aLength, bool isQuoted, int & aKind )
+{
+	double	number;
+	long	date;
+	if ((aLength == 0) && !isQuoted) {
+		return;
+	}
+	switch (aKind) {
+		case CKDELIMITEDTABLE_NUMBER_COLUMN:
+			if (!isQuoted && parseNumber(aData, aLength, number)) {
+				aTable.setDoubleValue(aRow, aCol, number);
+				return;
+			}
+			break;
+		case CKDELIMITEDTABLE_DATE_COLUMN:
+			if (!isQuoted && parseDate(aData, aLength, date)) {
+				aTable.setDateValue(aRow, aCol, date);
+				return;
+			}
+			break;
+		case CKDELIMITEDTABLE_STRING_COLUMN:
+			aTable.setStringValue(aRow, aCol, aData);
+			return;
+	}
+
+	aKind = CKDELIMITEDTABLE_MIXED_COLUMN;
+	if (isQuoted) {
+		aTable.setStringValue(aRow, aCol, aData);
+	} else if (parseDate(aData, aLength, date)) {
+		aTable.setDateValue(aRow, aCol, date);
+	} else if (parseNumber(aData, aLength, number)) {
+		aTable.setDoubleValue(aRow, aCol, number);
+	} else {
+		aTable.setStringValue(aRow, aCol, aData);
+	}
+}
+
+//	Private Data Constants
+
+
+/********************************************************
+ *
+ *                Reading Methods
+ *
+ ********************************************************/
+/*
+ * These read the delimited text from the file, or from the open
+ * file descriptor until the end of it, and return a columnar
+ * table of it. If 'aHasLabels' is true, the first field of each
+ * row is its label, and the first header is ignored. The first
+ * 'aSampleSize' rows decide the type of each column: a column
+ * with just numbers - or dates in the YYYYMMDD form of CKVariant
+ * - is made a dense column of them, and one with just strings is
+ * a column of strings. Anything else, or a column that turns out
+ * to have something else in it after the sample, has each cell
+ * typed on its own - as a date, a number, or else a string. The
+ * lines that are completely empty are skipped, unless there's
+ * just the one column, and a row with
+ * more fields than there are headers throws a CKException, as
+ * does anything else that isn't right about the file.
+ */
+CKTable CKDelimitedTable::read( const CKString & aFileName, char aDelimiter,
+								bool aHasLabels, int aSampleSize )
+{
+	int		fd = ::open(aFileName.c_str(), O_RDONLY);
+	if (fd < 0) {
+		std::ostringstream	msg;
+		msg << "CKDelimitedTable::read(const CKString &, char, bool, int) - the "
+			"file '" << aFileName << "' couldn't be opened: " << strerror(errno);
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	try {
+		CKTable		retval = read(fd, aDelimiter, aHasLabels, aSampleSize);
+		::close(fd);
+		return retval;
+	} catch (...) {
+		::close(fd);
+		throw;
+	}
+}
+
+
+CKTable CKDelimitedTable::read( int aFd, char aDelimiter, bool aHasLabels, int aSampleSize )
+{
+	checkDelimiter(aDelimiter, "read(int, char, bool, int)");
+	CKDelimitedReader				reader(aFd, aDelimiter);
+	std::vector<CKDelimitedField>	fields;
+
+	// first, get the headers
+	int		first = (aHasLabels ? 1 : 0);
+	if (!reader.nextRecord(fields) || ((int)fields.size() <= first)) {
+		std::ostringstream	msg;
+		msg << "CKDelimitedTable::read(int, char, bool, int) - the file doesn't "
+			"start with a line of column headers, so there's no table in it.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+	int						cols = fields.size() - first;
+	int						width = fields.size();
+	reader.setSkipEmpty(width > 1);
+	long long				headerBytes = reader.getBytesRead();
+	std::vector<CKString>	headers;
+	for (int j = 0; j < cols; ++j) {
+		headers.push_back(CKString(fields[first + j].data, 0, fields[first + j].length));
+	}
+
+	/*
+	 * The rows of the sample are copied out of the reader, as it only
+	 * holds one at a time, so each column's type can be decided from
+	 * all of them before any of them are put in the table.
+	 */
+	if (aSampleSize < 1) {
+		aSampleSize = 1;
+	}
+	std::string								store;
+	std::vector<CKDelimitedSampleField>		sample;
+	int										sampleRows = 0;
+	bool									more = true;
+	while ((sampleRows < aSampleSize) && (more = reader.nextRecord(fields))) {
+		if ((int)fields.size() > width) {
+			std::ostringstream	msg;
+			msg << "CKDelimitedTable::read(int, char, bool, int) - row " <<
+				reader.getRecordNumber() << " of the file has " << fields.size() <<
+				" fields, but there are only " << width << " columns in the table.";
+			throw CKException(__FILE__, __LINE__, msg.str());
+		}
+		for (int k = 0; k < width; ++k) {
+			CKDelimitedSampleField	field = { -1, 0, false };
+			if (k < (int)fields.size()) {
+				field.offset = store.size();
+				field.length = fields[k].length;
+				field.quoted = fields[k].quoted;
+				store.append(fields[k].data, fields[k].length + 1);
+			}
+			sample.push_back(field);
+		}
+		++sampleRows;
+	}
+
+	/*
+	 * The table starts with the rows of the sample - or one, if there
+	 * aren't any, that's dropped at the end - and a column of each type.
+	 */
+	std::vector<int>	kinds(cols);
+	CKTable				retval((sampleRows > 0 ? sampleRows : 1), cols);
+	retval.setColumnar(true);
+	for (int j = 0; j < cols; ++j) {
+		kinds[j] = kindOfColumn(store, sample, width, first + j);
+		switch (kinds[j]) {
+			case CKDELIMITEDTABLE_NUMBER_COLUMN:
+				retval.setColumnType(j, eNumberVariant);
+				break;
+			case CKDELIMITEDTABLE_DATE_COLUMN:
+				retval.setColumnType(j, eDateVariant);
+				break;
+			default:
+				retval.setColumnType(j, eUnknownVariant);
+				break;
+		}
+		retval.setColumnHeader(j, headers[j]);
+	}
+	for (int i = 0; i < sampleRows; ++i) {
+		const CKDelimitedSampleField	*row = &sample[i * width];
+		if (aHasLabels && (row[0].offset >= 0)) {
+			retval.setRowLabel(i, CKString(store.data() + row[0].offset, 0, row[0].length));
+		}
+		for (int j = 0; j < cols; ++j) {
+			const CKDelimitedSampleField	& field = row[first + j];
+			if (field.offset >= 0) {
+				setCell(retval, i, j, store.data() + field.offset, field.length,
+						field.quoted, kinds[j]);
+			}
+		}
+	}
+	store.clear();
+	sample.clear();
+
+	/*
+	 * If it's a file, and not a pipe, the rows that are left are about
+	 * as long as the ones in the sample, so there's room made for that
+	 * many - and a few more - so the table doesn't have to keep growing.
+	 */
+	struct stat		info;
+	long long		sampleBytes = reader.getBytesRead() - headerBytes;
+	if (more && (sampleRows > 0) && (sampleBytes > 0) && (::fstat(aFd, &info) == 0) &&
+		S_ISREG(info.st_mode) && (info.st_size > reader.getBytesRead())) {
+		double	left = (double)(info.st_size - reader.getBytesRead()) * sampleRows / sampleBytes;
+		double	guess = sampleRows + 1.05 * left + 16;
+		if (guess < INT_MAX / 2) {
+			retval.reserveRows((int)guess);
+		}
+	}
+
+	// ...and then the rest of the rows go right in as they're read
+	int		rows = sampleRows;
+	while (more && reader.nextRecord(fields)) {
+		int		cnt = fields.size();
+		if (cnt > width) {
+			std::ostringstream	msg;
+			msg << "CKDelimitedTable::read(int, char, bool, int) - row " <<
+				reader.getRecordNumber() << " of the file has " << cnt <<
+				" fields, but there are only " << width << " columns in the table.";
+			throw CKException(__FILE__, __LINE__, msg.str());
+		}
+		int		row = (aHasLabels ?
+				   retval.appendRow(CKString(fields[0].data, 0, fields[0].length)) :
+				   retval.appendRow());
+		for (int j = 0; first + j < cnt; ++j) {
+			const CKDelimitedField	& field = fields[first + j];
+			setCell(retval, row, j, field.data, field.length, field.quoted, kinds[j]);
+		}
+		++rows;
+	}
+
+	if (rows == 0) {
+		retval.selectRows(CKVector<int>());
+	}
+	return retval;
+}
+
+
+/********************************************************
+ *
+ *                Writing Methods
+ *
+ ********************************************************/
+/*
+ * These write the table as delimited text to the file, or to the
+ * open file descriptor, a row at a time through a buffer. If
+ * 'aWithLabels' is true, the row labels are written as the first
+ * field of each row. The numbers are written as short as they can
+ * be and still be read back as exactly the same number, and the
+ * strings that have to be - or that are empty, or would read back
+ * as a number or date - are quoted. The file is written to a new
+ * one that then takes its name, so it's never seen half-written.
+ */
+void CKDelimitedTable::write( const CKTable & aTable, const CKString & aFileName,
+							  char aDelimiter, bool aWithLabels )
+{
+	CKString	tempName(aFileName);
+	tempName.append(".tmp");
+	int			fd = ::open(tempName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		std::ostringstream	msg;
+		msg << "CKDelimitedTable::write(const CKTable &, const CKString &, char, bool) - "
+			"the file '" << tempName << "' couldn't be created: " << strerror(errno);
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	try {
+		write(aTable, fd, aDelimiter, aWithLabels);
+	} catch (...) {
+		::close(fd);
+		::unlink(tempName.c_str());
+		throw;
+	}
+
+	if ((::close(fd) != 0) || (::rename(tempName.c_str(), aFileName.c_str()) != 0)) {
+		std::ostringstream	msg;
+		msg << "CKDelimitedTable::write(const CKTable &, const CKString &, char, bool) - "
+			"the file '" << tempName << "' couldn't be renamed to '" << aFileName <<
+			"': " << strerror(errno);
+		::unlink(tempName.c_str());
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+}
+
+
+void CKDelimitedTable::write( const CKTable & aTable, int aFd, char aDelimiter,
+							  bool aWithLabels )
+{
+	checkDelimiter(aDelimiter, "write(const CKTable &, int, char, bool)");
+	int		rows = aTable.getNumRows();
+	int		cols = aTable.getNumColumns();
+	if ((rows < 0) || (cols < 0)) {
+		std::ostringstream	msg;
+		msg << "CKDelimitedTable::write(const CKTable &, int, char, bool) - there "
+			"is no currently defined table structure in the table, so there's "
+			"nothing to write. Please create the table before calling this method.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	/*
+	 * The headers, after an empty one over the labels. If there's just
+	 * the one empty header, it's quoted - an empty line would be skipped
+	 * on the way back in, and the first row taken for the headers.
+	 */
+	CKDelimitedWriter	out(aFd, aDelimiter);
+	for (int j = 0; j < cols; ++j) {
+		if ((j > 0) || aWithLabels) {
+			out.put(aDelimiter);
+		}
+		const CKString	& header = aTable.getColumnHeader(j);
+		if ((cols == 1) && !aWithLabels && (header.size() == 0)) {
+			out.put("\"\"", 2);
+		} else {
+			out.putString(header.c_str(), header.size(), false);
+		}
+	}
+	out.put('\n');
+
+	/*
+	 * The dense columns are read right from their arrays, and the rest
+	 * a cell at a time.
+	 */
+	std::vector<const double *>			doubles(cols);
+	std::vector<const long *>			dates(cols);
+	std::vector<const unsigned char *>	valid(cols);
+	for (int j = 0; j < cols; ++j) {
+		doubles[j] = aTable.getDoubleColumn(j);
+		dates[j] = aTable.getDateColumn(j);
+		valid[j] = aTable.getColumnValidity(j);
+	}
+	for (int i = 0; i < rows; ++i) {
+		if (aWithLabels) {
+			const CKString	& label = aTable.getRowLabel(i);
+			out.putString(label.c_str(), label.size(), false);
+		}
+		for (int j = 0; j < cols; ++j) {
+			if ((j > 0) || aWithLabels) {
+				out.put(aDelimiter);
+			}
+			if ((doubles[j] != NULL) || (dates[j] != NULL)) {
+				if (((valid[j][i >> 3] >> (i & 7)) & 1) == 0) {
+					// it's an empty cell
+				} else if (doubles[j] != NULL) {
+					out.putNumber(doubles[j][i]);
+				} else {
+					out.putDate(dates[j][i]);
+				}
+				continue;
+			}
+			switch (aTable.getType(i, j)) {
+				case eUnknownVariant:
+					break;
+				case eNumberVariant:
+					out.putNumber(aTable.getDoubleValue(i, j));
+					break;
+				case eDateVariant:
+					out.putDate(aTable.getDateValue(i, j));
+					break;
+				case eStringVariant:
+					{
+						const CKString	*str = aTable.getStringValue(i, j);
+						out.putString(str->c_str(), str->size(), true);
+					}
+					break;
+				default:
+					{
+						CKString	str = aTable.getValueAsString(i, j);
+						out.putString(str.c_str(), str.size(), true);
+					}
+					break;
+			}
+		}
+		out.put('\n');
+	}
+	out.flush();
+}
+
+
+/********************************************************
+ *
+ *                Private Methods
+ *
+ ********************************************************/
+/*
+ * This makes sure the delimiter is one that can be used - not a
+ * quote or a line break - and throws a CKException if it isn't.
+ */
+void CKDelimitedTable::checkDelimiter( char aDelimiter, const char *aMethod )
+{
+	if ((aDelimiter == '"') || (aDelimiter == '\n') || (aDelimiter == '\r') ||
+		(aDelimiter == '\0')) {
+		std::ostringstream	msg;
+		msg << "CKDelimitedTable::" << aMethod << " - the delimiter can't be a "
+			"quote, a line break or a NULL. Please use something else, like a "
+			"comma or a tab.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+}
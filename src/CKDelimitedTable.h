@@ -0,0 +1,101 @@
+/*
+ * CKDelimitedTable.h - this file defines the reading and writing of
+ *                      CKTables as delimited text - CSV, TSV and the like.
+ *                      The reader streams the file through a buffer, looks
+ *                      at the first rows to see what type each column is,
+ *                      and then parses every field right into the dense
+ *                      column it belongs in, without ever making a string
+ *                      of it unless it is one. The writer streams the rows
+ *                      out through a buffer the same way, so neither one
+ *                      ever has the whole file in memory.
+ *
+ * $Id$
+ */
+#ifndef __CKDELIMITEDTABLE_H
+#define __CKDELIMITEDTABLE_H
+
+//	System Headers
+
+//	Third-Party Headers
+
+//	Other Headers
+#include "CKTable.h"
+#include "CKString.h"
+
+//	Forward Declarations
+
+//	Public Constants
+/*
+ * This is the number of rows the reader looks at, by default, to see
+ * what type each column is before it makes the table.
+ */
+#define	CKDELIMITEDTABLE_SAMPLE_SIZE	1000
+
+//	Public Datatypes
+
+//	Public Data Constants
+
+
+
+/*
+ * This class is just a holder of the reader and writer - there's
+ * nothing to make an instance of. The format is the usual one: the
+ * first line has the column headers, each line after that is a row,
+ * and a field with the delimiter, a quote, or a line break in it is
+ * put in double quotes, with each quote in it doubled. The lines can
+ * end in a new line or a carriage return and new line.
+ *
+ * A field with nothing in it is an empty cell, and a field in quotes
+ * is always a string - so "" is an empty string and "12" is the
+ * string, not the number - which is just how the writer writes them,
+ * so a table of numbers, dates and strings comes back exactly as it
+ * went out.
+ */
+class CKDelimitedTable
+{
+	public:
+		/*
+		 * These read the delimited text from the file, or from the open
+		 * file descriptor until the end of it, and return a columnar
+		 * table of it. If 'aHasLabels' is true, the first field of each
+		 * row is its label, and the first header is ignored. The first
+		 * 'aSampleSize' rows decide the type of each column: a column
+		 * with just numbers - or dates in the YYYYMMDD form of CKVariant
+		 * - is made a dense column of them, and one with just strings is
+		 * a column of strings. Anything else, or a column that turns out
+		 * to have something else in it after the sample, has each cell
+		 * typed on its own - as a date, a number, or else a string. The
+		 * lines that are completely empty are skipped, unless there's
+		 * just the one column, and a row with more fields than there are
+		 * headers throws a CKException, as does anything else that isn't
+		 * right about the file.
+		 */
+		static CKTable read( const CKString & aFileName, char aDelimiter = ',',
+							 bool aHasLabels = false,
+							 int aSampleSize = CKDELIMITEDTABLE_SAMPLE_SIZE );
+		static CKTable read( int aFd, char aDelimiter = ',', bool aHasLabels = false,
+							 int aSampleSize = CKDELIMITEDTABLE_SAMPLE_SIZE );
+		/*
+		 * These write the table as delimited text to the file, or to the
+		 * open file descriptor, a row at a time through a buffer. If
+		 * 'aWithLabels' is true, the row labels are written as the first
+		 * field of each row. The numbers are written as short as they can
+		 * be and still be read back as exactly the same number, and the
+		 * strings that have to be - or that are empty, or would read back
+		 * as a number or date - are quoted. The file is written to a new
+		 * one that then takes its name, so it's never seen half-written.
+		 */
+		static void write( const CKTable & aTable, const CKString & aFileName,
+						   char aDelimiter = ',', bool aWithLabels = false );
+		static void write( const CKTable & aTable, int aFd, char aDelimiter = ',',
+						   bool aWithLabels = false );
+
+	private:
+		/*
+		 * This makes sure the delimiter is one that can be used - not a
+		 * quote or a line break - and throws a CKException if it isn't.
+		 */
+		static void checkDelimiter( char aDelimiter, const char *aMethod );
+};
+
+#endif	// __CKDELIMITEDTABLE_H
@@ -0,0 +1,868 @@
+/*
+ * CKExecutor.cpp - this file implements a fixed pool of worker threads that
+ *                  can run lots of small tasks without the cost of creating
+ *                  a thread for each one. Each worker has its own deque of
+ *                  tasks - it works on the newest of its own tasks, and when
+ *                  it runs out, it steals the oldest task from one of the
+ *                  other workers.
+ *
+ * $Id$
+ */
+
+//	System Headers
+#include <sstream>
+#include <unistd.h>
+#include <pthread.h>
+#include <exception>
+
+//	Third-Party Headers
+
+//	Other Headers
+#include "CKExecutor.h"
+#include "CKFWAtomic.h"
+#include "CKStackLocker.h"
+#include "CKException.h"
+
+//	Forward Declarations
+
+//	Private Constants
+
+//	Private Datatypes
+/*
+ * This is the state shared by the futures and the executor for one task.
+ * It's reference counted as the futures can be copied and the executor
+ * holds on to it until the task is done.
+ */
+class CKExecutorFutureState
+{
+	public:
+		CKExecutorFutureState() :
+			mReferences(1),
+			mDone(false),
+			mFailed(false),
+			mMessage(),
+			mMutex(),
+			mConditional(mMutex)
+		{
+		}
+
+		void retain()
+		{
+			CKFWAtomicAdd(&mReferences, 1);
+		}
+
+		void release()
+		{
+			if (CKFWAtomicAdd(&mReferences, -1) == 0) {
+				delete this;
+			}
+		}
+
+		// this is called by the worker when the task has finished
+		void finish( bool aFailed, const CKString & aMessage )
+		{
+			mMutex.lock();
+			mFailed = aFailed;
+			mMessage = aMessage;
+			mDone = true;
+			mConditional.wakeWaiters();
+			mMutex.unlock();
+		}
+
+		volatile long		mReferences;
+		volatile bool		mDone;
+		bool				mFailed;
+		CKString			mMessage;
+		CKFWMutex			mMutex;
+		CKFWConditional		mConditional;
+};
+
+
+/*
+ * This is the test the future uses to wait for the task to be done.
+ */
+class CKExecutorNotDoneTest :
+	public ICKFWConditionalSpuriousTest
+{
+	public:
+		CKExecutorNotDoneTest( CKExecutorFutureState *aState ) :
+			mState(aState)
+		{
+		}
+
+		virtual int test()
+		{
+			return !mState->mDone;
+		}
+
+	private:
+		CKExecutorFutureState	*mState;
+};
+
+
+/*
+ * This is the test the idle workers use to wait for something to do.
+ */
+class CKExecutorNoWorkTest :
+	public ICKFWConditionalSpuriousTest
+{
+	public:
+		CKExecutorNoWorkTest( volatile long *aPending, volatile long *aShutdown ) :
+			mPending(aPending),
+			mShutdown(aShutdown)
+		{
+		}
+
+		virtual int test()
+		{
+			return ((*mPending == 0) && (*mShutdown == 0));
+		}
+
+	private:
+		volatile long	*mPending;
+		volatile long	*mShutdown;
+};
+
+
+/*
+ * This is the countdown that parallelFor() waits on - one count for
+ * each chunk of the range - along with the first error any chunk hit.
+ */
+class CKExecutorLatch
+{
+	public:
+		CKExecutorLatch( int aCount ) :
+			mCount(aCount),
+			mFailed(false),
+			mMessage(),
+			mMutex(),
+			mConditional(mMutex)
+		{
+		}
+
+		void countDown( bool aFailed, const CKString & aMessage )
+		{
+			mMutex.lock();
+			if (aFailed && !mFailed) {
+				mFailed = true;
+				mMessage = aMessage;
+			}
+			if (--mCount == 0) {
+				mConditional.wakeWaiters();
+			}
+			mMutex.unlock();
+		}
+
+		volatile int		mCount;
+		bool				mFailed;
+		CKString			mMessage;
+		CKFWMutex			mMutex;
+		CKFWConditional		mConditional;
+};
+
+
+class CKExecutorLatchTest :
+	public ICKFWConditionalSpuriousTest
+{
+	public:
+		CKExecutorLatchTest( CKExecutorLatch *aLatch ) :
+			mLatch(aLatch)
+		{
+		}
+
+		virtual int test()
+		{
+			return (mLatch->mCount > 0);
+		}
+
+	private:
+		CKExecutorLatch		*mLatch;
+};
+
+
+/*
+ * This is one chunk of a parallelFor() - it runs the body over its part
+ * of the range and counts down the latch, no matter how it goes.
+ */
+class CKExecutorRangeChunk :
+	public ICKExecutorTask
+{
+	public:
+		CKExecutorRangeChunk( ICKExecutorRangeTask *aBody, int aBegin, int anEnd,
+							  CKExecutorLatch *aLatch ) :
+			mBody(aBody),
+			mBegin(aBegin),
+			mEnd(anEnd),
+			mLatch(aLatch)
+		{
+		}
+
+		virtual void execute()
+		{
+			bool		failed = true;
+			CKString	msg;
+			try {
+				mBody->execute(mBegin, mEnd);
+				failed = false;
+			} catch (CKException & e) {
+				msg = e.getMessage();
+			} catch (std::exception & e) {
+				msg = e.what();
+			} catch (...) {
+				msg = "an unknown exception was thrown";
+			}
+			mLatch->countDown(failed, msg);
+		}
+
+	private:
+		ICKExecutorRangeTask	*mBody;
+		int						mBegin;
+		int						mEnd;
+		CKExecutorLatch			*mLatch;
+};
+
+
+//	Private Data Constants
+/*
+ * This is the thread-specific key that holds the worker each thread in
+ * any of the pools is, so that tasks submitted from a worker go on its
+ * own deque.
+ */
+static pthread_key_t	sWorkerKey;
+static pthread_once_t	sWorkerKeyOnce = PTHREAD_ONCE_INIT;
+
+static void createWorkerKey()
+{
+	pthread_key_create(&sWorkerKey, NULL);
+}
+
+
+/*******************************************************************
+ *
+ *                    Executor Task Interfaces
+ *
+ *******************************************************************/
+ICKExecutorTask::ICKExecutorTask()
+{
+}
+
+
+ICKExecutorTask::~ICKExecutorTask()
+{
+}
+
+
+ICKExecutorRangeTask::ICKExecutorRangeTask()
+{
+}
+
+
+ICKExecutorRangeTask::~ICKExecutorRangeTask()
+{
+}
+
+
+/*******************************************************************
+ *
+ *                     Executor Future Class
+ *
+ *******************************************************************/
+/*
+ * The default constructor makes a future that isn't attached to
+ * any task - it's always done and never failed.
+ */
+CKExecutorFuture::CKExecutorFuture() :
+	mState(NULL)
+{
+}
+
+
+CKExecutorFuture::CKExecutorFuture( const CKExecutorFuture & anOther ) :
+	mState(anOther.mState)
+{
+	if (mState != NULL) {
+		mState->retain();
+	}
+}
+
+
+CKExecutorFuture::CKExecutorFuture( CKExecutorFutureState *aState ) :
+	mState(aState)
+{
+	if (mState != NULL) {
+		mState->retain();
+	}
+}
+
+
+CKExecutorFuture::~CKExecutorFuture()
+{
+	if (mState != NULL) {
+		mState->release();
+		mState = NULL;
+	}
+}
+
+
+CKExecutorFuture & CKExecutorFuture::operator=( const CKExecutorFuture & anOther )
+{
+	if (mState != anOther.mState) {
+		if (anOther.mState != NULL) {
+			anOther.mState->retain();
+		}
+		if (mState != NULL) {
+			mState->release();
+		}
+		mState = anOther.mState;
+	}
+	return *this;
+}
+
+
+/*
+ * This method returns true if the task has finished running -
+ * successfully or not.
+ */
+bool CKExecutorFuture::isDone() const
+{
+	return ((mState == NULL) || mState->mDone);
+}
+
+
+/*
+ * These methods wait for the task to finish. The second form waits
+ * no more than the given number of milliseconds and returns true if
+ * the task is done.
+ */
+void CKExecutorFuture::wait() const
+{
+	wait(-1);
+}
+
+
+bool CKExecutorFuture::wait( int aTimeoutInMillis ) const
+{
+	bool		done = true;
+	if ((mState != NULL) && !mState->mDone) {
+		CKExecutorNotDoneTest	tst(mState);
+		if (mState->mConditional.lockAndTest(tst, aTimeoutInMillis) == FWCOND_LOCK_SUCCESS) {
+			mState->mMutex.unlock();
+		}
+		done = mState->mDone;
+	}
+	return done;
+}
+
+
+/*
+ * This method waits for the task to finish and if the task threw
+ * an exception, it throws a CKException with the message from
+ * the original exception.
+ */
+void CKExecutorFuture::get() const
+{
+	wait();
+	if (failed()) {
+		std::ostringstream	msg;
+		msg << "CKExecutorFuture::get() - the task threw an exception: " <<
+			mState->mMessage;
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+}
+
+
+/*
+ * Once the task is done, these say if it threw an exception and
+ * what the message was.
+ */
+bool CKExecutorFuture::failed() const
+{
+	return ((mState != NULL) && mState->mDone && mState->mFailed);
+}
+
+
+CKString CKExecutorFuture::getErrorMessage() const
+{
+	CKString	retval;
+	if (failed()) {
+		retval = mState->mMessage;
+	}
+	return retval;
+}
+
+
+/*******************************************************************
+ *
+ *                     Executor Task Entry
+ *
+ *******************************************************************/
+CKExecutorEntry::CKExecutorEntry() :
+	task(NULL),
+	deleteWhenDone(false),
+	state(NULL)
+{
+}
+
+
+CKExecutorEntry::CKExecutorEntry( ICKExecutorTask *aTask, bool aDeleteWhenDone,
+								  CKExecutorFutureState *aState ) :
+	task(aTask),
+	deleteWhenDone(aDeleteWhenDone),
+	state(aState)
+{
+}
+
+
+/*******************************************************************
+ *
+ *                     Executor Worker Thread
+ *
+ *******************************************************************/
+CKExecutorWorker::CKExecutorWorker( CKExecutor *anExecutor, int anIndex ) :
+	CKFWThread(cDefaultPolicy, cDefaultPriority, cDefaultScope, 0),
+	mExecutor(anExecutor),
+	mIndex(anIndex),
+	mTasks(),
+	mTasksMutex()
+{
+	std::ostringstream	tag;
+	tag << "CKExecutor worker " << anIndex;
+	setTag(tag.str().c_str());
+}
+
+
+CKExecutorWorker::~CKExecutorWorker()
+{
+	mExecutor = NULL;
+}
+
+
+/*
+ * These are the deque operations. The owner pushes and pops at
+ * the back, and the thieves steal from the front, so the owner
+ * works on the freshest (cache-hot) tasks and the thieves get the
+ * oldest, which are usually the biggest pieces of work.
+ */
+void CKExecutorWorker::push( const CKExecutorEntry & anEntry )
+{
+	CKStackLocker	lockem(&mTasksMutex);
+	mTasks.push_back(anEntry);
+}
+
+
+bool CKExecutorWorker::pop( CKExecutorEntry & anEntry )
+{
+	bool		gotOne = false;
+	CKStackLocker	lockem(&mTasksMutex);
+	if (!mTasks.empty()) {
+		anEntry = mTasks.back();
+		mTasks.pop_back();
+		gotOne = true;
+	}
+	return gotOne;
+}
+
+
+bool CKExecutorWorker::steal( CKExecutorEntry & anEntry )
+{
+	bool		gotOne = false;
+	// don't wait on a busy deque - there are others to try
+	if (mTasksMutex.tryLock()) {
+		if (!mTasks.empty()) {
+			anEntry = mTasks.front();
+			mTasks.pop_front();
+			gotOne = true;
+		}
+		mTasksMutex.unlock();
+	}
+	return gotOne;
+}
+
+
+/*
+ * This method is called within a loop in the CKFWThread's run
+ * loop and runs one task, or waits for one to show up. When the
+ * executor is shut down and there's no more work, it returns cDone.
+ */
+int CKExecutorWorker::process()
+{
+	// make sure that tasks submitted from this thread come to us
+	pthread_once(&sWorkerKeyOnce, createWorkerKey);
+	if (pthread_getspecific(sWorkerKey) != this) {
+		pthread_setspecific(sWorkerKey, this);
+	}
+
+	int		retval = cSuccess;
+	if (!mExecutor->runOneTask(this)) {
+		if (mExecutor->isFinished()) {
+			retval = cDone;
+		} else {
+			mExecutor->waitForWork();
+		}
+	}
+	return retval;
+}
+
+
+/*******************************************************************
+ *
+ *                      Executor Class
+ *
+ *******************************************************************/
+/********************************************************
+ *
+ *                Constructors/Destructor
+ *
+ ********************************************************/
+/*
+ * This constructor creates and starts the given number of worker
+ * threads. If the number is zero or less, the number of on-line
+ * processors is used.
+ */
+CKExecutor::CKExecutor( int aNumberOfThreads ) :
+	mWorkers(),
+	mNextWorker(0),
+	mPending(0),
+	mSleepers(0),
+	mShutdown(0),
+	mIdleMutex(),
+	mIdleConditional(mIdleMutex)
+{
+	int		cnt = (aNumberOfThreads > 0 ? aNumberOfThreads : getNumberOfProcessors());
+	// make all the workers before starting any so the stealing is safe
+	for (int i = 0; i < cnt; ++i) {
+		mWorkers.addToEnd(new CKExecutorWorker(this, i));
+	}
+	for (int i = 0; i < cnt; ++i) {
+		mWorkers[i]->start();
+	}
+}
+
+
+/*
+ * This is the standard destructor and needs to be virtual to make
+ * sure that if we subclass off this the right destructor will be
+ * called. It shuts down the pool, finishing all the pending tasks.
+ */
+CKExecutor::~CKExecutor()
+{
+	shutdown();
+	for (int i = 0; i < mWorkers.size(); ++i) {
+		delete mWorkers[i];
+	}
+	mWorkers.clear();
+}
+
+
+/********************************************************
+ *
+ *                Accessor Methods
+ *
+ ********************************************************/
+/*
+ * This returns the number of worker threads in the pool.
+ */
+int CKExecutor::getNumberOfThreads() const
+{
+	return mWorkers.size();
+}
+
+
+/*
+ * This returns the number of tasks submitted but not yet started.
+ */
+int CKExecutor::getPendingCount() const
+{
+	return (int)mPending;
+}
+
+
+/*
+ * This is the process-wide executor that the library uses for its
+ * own parallel work. It's created on first use with one thread for
+ * each on-line processor.
+ */
+CKExecutor *CKExecutor::getDefault()
+{
+	static CKExecutor	*executor = new CKExecutor();
+	return executor;
+}
+
+
+/*
+ * This returns the number of on-line processors on this box.
+ */
+int CKExecutor::getNumberOfProcessors()
+{
+	long	cnt = sysconf(_SC_NPROCESSORS_ONLN);
+	return (cnt > 0 ? (int)cnt : 1);
+}
+
+
+/********************************************************
+ *
+ *                Task Methods
+ *
+ ********************************************************/
+/*
+ * This method places the task on the pool to be run and returns a
+ * future that can be used to wait for it. If 'aDeleteWhenDone' is
+ * true, the executor owns the task and will delete it once it has
+ * run, otherwise the caller needs to keep it around until the
+ * future is done.
+ */
+CKExecutorFuture CKExecutor::submit( ICKExecutorTask *aTask, bool aDeleteWhenDone )
+{
+	// first, make sure we have something to do
+	if (aTask == NULL) {
+		std::ostringstream	msg;
+		msg << "CKExecutor::submit(ICKExecutorTask *, bool) - the provided task "
+			"is NULL and that means there's nothing to do. Please make sure "
+			"that the argument is not NULL before calling.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+	/*
+	 * Count the task as pending *before* looking at the shutdown flag.
+	 * The workers only leave when they see the flag set and nothing
+	 * pending, so if shutdown() gets in after this, they'll stay until
+	 * this task is on a deque and run. If it got in before, we take the
+	 * count back and refuse the task.
+	 */
+	CKFWAtomicAdd(&mPending, 1);
+	if (mShutdown != 0) {
+		CKFWAtomicAdd(&mPending, -1);
+		std::ostringstream	msg;
+		msg << "CKExecutor::submit(ICKExecutorTask *, bool) - this executor "
+			"has been shut down and can't accept any more tasks.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// the state starts with one reference - the one on the deque
+	CKExecutorFutureState	*state = new CKExecutorFutureState();
+	CKExecutorFuture		retval(state);
+
+	// put it on our own deque if we're a worker, otherwise spread them out
+	CKExecutorWorker	*me = currentWorker();
+	if (me == NULL) {
+		unsigned long	next = (unsigned long)CKFWAtomicAdd(&mNextWorker, 1);
+		me = mWorkers[(int)(next % (unsigned long)mWorkers.size())];
+	}
+	me->push(CKExecutorEntry(aTask, aDeleteWhenDone, state));
+
+	// now wake one of the workers if any are parked
+	if (mSleepers > 0) {
+		mIdleMutex.lock();
+		mIdleConditional.wakeWaiter();
+		mIdleMutex.unlock();
+	}
+
+	return retval;
+}
+
+
+/*
+ * This method runs the body over the range [aBegin, anEnd) on the
+ * pool, in chunks of 'aGrainSize' indexes (if zero or less, the
+ * range is split into a few chunks per worker). The calling thread
+ * helps run the chunks, and the method returns when they are all
+ * done. If any of the chunks threw an exception, a CKException is
+ * thrown with the first message once they have all finished.
+ */
+void CKExecutor::parallelFor( int aBegin, int anEnd, ICKExecutorRangeTask & aBody,
+							  int aGrainSize )
+{
+	// first, see if we have anything to do
+	if (anEnd <= aBegin) {
+		return;
+	}
+
+	// figure out the size of the chunks - about four per worker
+	int		span = anEnd - aBegin;
+	int		grain = aGrainSize;
+	if (grain <= 0) {
+		grain = span / (4 * mWorkers.size());
+		if (grain < 1) {
+			grain = 1;
+		}
+	}
+	int		chunks = (span + grain - 1) / grain;
+
+	// if it's just one chunk, there's no sense in bothering the pool
+	if (chunks == 1) {
+		aBody.execute(aBegin, anEnd);
+		return;
+	}
+
+	// make all the chunks and submit them
+	CKExecutorLatch			latch(chunks);
+	CKExecutorRangeChunk	**work = new CKExecutorRangeChunk*[chunks];
+	for (int i = 0; i < chunks; ++i) {
+		int		b = aBegin + i * grain;
+		int		e = (b + grain < anEnd ? b + grain : anEnd);
+		work[i] = new CKExecutorRangeChunk(&aBody, b, e, &latch);
+		submit(work[i], true);
+	}
+	delete [] work;
+
+	// now help out as long as there's anything to run...
+	CKExecutorWorker	*me = currentWorker();
+	while ((latch.mCount > 0) && runOneTask(me)) {
+	}
+
+	/*
+	 * ...and then sleep until the stragglers are done - the last chunk
+	 * wakes us. Getting the lock also makes sure that it's out of the
+	 * latch before the latch goes away.
+	 */
+	CKExecutorLatchTest		tst(&latch);
+	if (latch.mConditional.lockAndTest(tst) == FWCOND_LOCK_SUCCESS) {
+		latch.mMutex.unlock();
+	}
+
+	// if anything went wrong, let the caller know
+	if (latch.mFailed) {
+		std::ostringstream	msg;
+		msg << "CKExecutor::parallelFor(int, int, ICKExecutorRangeTask &, int) - "
+			"one of the ranges threw an exception: " << latch.mMessage;
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+}
+
+
+/*
+ * This method stops the pool. All the tasks already submitted are
+ * run, and then the worker threads exit and are joined. Submitting
+ * a task after this throws a CKException. A worker can't join itself,
+ * so calling this from one of the pool's own tasks throws one, too.
+ */
+void CKExecutor::shutdown()
+{
+	if (currentWorker() != NULL) {
+		std::ostringstream	msg;
+		msg << "CKExecutor::shutdown() - this was called from one of the "
+			"executor's own worker threads, and it would wait forever for "
+			"itself to finish. Please shut the pool down from outside it.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	if (CKFWAtomicCompareAndSwap(&mShutdown, 0, 1)) {
+		// wake everyone up so they can finish up and leave
+		mIdleMutex.lock();
+		mIdleConditional.wakeWaiters();
+		mIdleMutex.unlock();
+		// ...and wait for them to go
+		for (int i = 0; i < mWorkers.size(); ++i) {
+			mWorkers[i]->join();
+		}
+	}
+}
+
+
+/*
+ * This method tries to find a task to run - from the given worker's
+ * own deque first (if it's a worker), and then by stealing from the
+ * others. If it finds one, it runs it and returns true.
+ */
+bool CKExecutor::runOneTask( CKExecutorWorker *aWorker )
+{
+	CKExecutorEntry		entry;
+	bool				gotOne = false;
+
+	// first, try our own deque
+	if (aWorker != NULL) {
+		gotOne = aWorker->pop(entry);
+	}
+	// ...then go around the others starting with our neighbor
+	if (!gotOne && (mPending > 0)) {
+		int		cnt = mWorkers.size();
+		int		start = (aWorker != NULL ? aWorker->mIndex + 1 : 0);
+		for (int i = 0; !gotOne && (i < cnt); ++i) {
+			CKExecutorWorker	*victim = mWorkers[(start + i) % cnt];
+			if (victim != aWorker) {
+				gotOne = victim->steal(entry);
+			}
+		}
+	}
+
+	if (gotOne) {
+		CKFWAtomicAdd(&mPending, -1);
+		runEntry(entry);
+	}
+	return gotOne;
+}
+
+
+/*
+ * This method runs the task in the entry, recording how it went in
+ * the future's state and cleaning up after it.
+ */
+void CKExecutor::runEntry( CKExecutorEntry & anEntry )
+{
+	bool		failed = true;
+	CKString	msg;
+	try {
+		anEntry.task->execute();
+		failed = false;
+	} catch (CKException & e) {
+		msg = e.getMessage();
+	} catch (std::exception & e) {
+		msg = e.what();
+	} catch (...) {
+		msg = "an unknown exception was thrown";
+	}
+
+	// clean up the task if it's ours
+	if (anEntry.deleteWhenDone) {
+		delete anEntry.task;
+	}
+	anEntry.task = NULL;
+	// ...and let anyone waiting know it's done
+	anEntry.state->finish(failed, msg);
+	anEntry.state->release();
+	anEntry.state = NULL;
+}
+
+
+/*
+ * This method parks the calling worker until there's something
+ * pending or the pool is shutting down.
+ */
+void CKExecutor::waitForWork()
+{
+	/*
+	 * We count ourselves as a sleeper *before* looking at the pending
+	 * count so that a submit() either sees us sleeping and wakes us, or
+	 * we see its task - the atomic add is a full barrier.
+	 */
+	CKFWAtomicAdd(&mSleepers, 1);
+	CKExecutorNoWorkTest	tst(&mPending, &mShutdown);
+	if (mIdleConditional.lockAndTest(tst) == FWCOND_LOCK_SUCCESS) {
+		mIdleMutex.unlock();
+	}
+	CKFWAtomicAdd(&mSleepers, -1);
+}
+
+
+/*
+ * This returns true when the pool is shutting down and all the
+ * work is done, so the workers can exit.
+ */
+bool CKExecutor::isFinished() const
+{
+	return ((mShutdown != 0) && (mPending == 0));
+}
+
+
+/*
+ * This returns the worker that the calling thread is, or NULL if
+ * it's not one of our workers.
+ */
+CKExecutorWorker *CKExecutor::currentWorker() const
+{
+	pthread_once(&sWorkerKeyOnce, createWorkerKey);
+	CKExecutorWorker	*me = (CKExecutorWorker *)pthread_getspecific(sWorkerKey);
+	if ((me != NULL) && (me->mExecutor != this)) {
+		me = NULL;
+	}
+	return me;
+}
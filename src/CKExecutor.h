@@ -0,0 +1,353 @@
+/*
+ * CKExecutor.h - this file defines a fixed pool of worker threads that can
+ *                run lots of small tasks without the cost of creating a
+ *                thread for each one. Each worker has its own deque of
+ *                tasks - it works on the newest of its own tasks, and when
+ *                it runs out, it steals the oldest task from one of the
+ *                other workers. Tasks submitted from outside the pool are
+ *                spread over the workers round-robin, and tasks submitted
+ *                by a task running on a worker go on that worker's deque.
+ *
+ *                A submitted task returns a CKExecutorFuture that can be
+ *                waited on, and parallelFor() splits a range of indexes
+ *                into chunks and runs them across the pool, waiting for
+ *                them all to finish before returning.
+ *
+ * $Id$
+ */
+#ifndef __CKEXECUTOR_H
+#define __CKEXECUTOR_H
+
+//	System Headers
+#include <deque>
+#ifdef GPP2
+#include <ostream.h>
+#else
+#include <ostream>
+#endif
+
+//	Third-Party Headers
+
+//	Other Headers
+#include "CKFWThread.h"
+#include "CKFWMutex.h"
+#include "CKFWConditional.h"
+#include "CKString.h"
+#include "CKVector.h"
+
+//	Forward Declarations
+class CKExecutor;
+class CKExecutorWorker;
+class CKExecutorFutureState;
+
+//	Public Constants
+
+//	Public Datatypes
+
+//	Public Data Constants
+
+
+/*******************************************************************
+ *
+ *                    Executor Task Interfaces
+ *
+ *******************************************************************/
+/*
+ * This is the interface for something that can be submitted to the
+ * executor. The execute() method will be called exactly once on one of
+ * the worker threads. Anything it throws is caught and reported through
+ * the CKExecutorFuture returned from submit().
+ */
+class ICKExecutorTask
+{
+	public:
+		ICKExecutorTask();
+		virtual ~ICKExecutorTask();
+		virtual void execute() = 0;
+};
+
+
+/*
+ * This is the interface for the body of a parallelFor(). The execute()
+ * method is called with a half-open range [aBegin, anEnd) of indexes,
+ * and will be called concurrently on several threads for different,
+ * non-overlapping ranges, so it needs to be thread-safe.
+ */
+class ICKExecutorRangeTask
+{
+	public:
+		ICKExecutorRangeTask();
+		virtual ~ICKExecutorRangeTask();
+		virtual void execute( int aBegin, int anEnd ) = 0;
+};
+
+
+/*******************************************************************
+ *
+ *                     Executor Future Class
+ *
+ *******************************************************************/
+/*
+ * This is what's returned when a task is submitted to the executor. It's
+ * a handle to the state of the task that can be copied around freely -
+ * the state is reference counted and goes away when the last handle and
+ * the executor are done with it. Since the task is the user's object,
+ * any results are simply left in the task for the user to look at once
+ * the future says it's done.
+ */
+class CKExecutorFuture
+{
+	public:
+		/*
+		 * The default constructor makes a future that isn't attached to
+		 * any task - it's always done and never failed.
+		 */
+		CKExecutorFuture();
+		CKExecutorFuture( const CKExecutorFuture & anOther );
+		virtual ~CKExecutorFuture();
+		CKExecutorFuture & operator=( const CKExecutorFuture & anOther );
+
+		/*
+		 * This method returns true if the task has finished running -
+		 * successfully or not.
+		 */
+		bool isDone() const;
+		/*
+		 * These methods wait for the task to finish. The second form waits
+		 * no more than the given number of milliseconds and returns true if
+		 * the task is done.
+		 */
+		void wait() const;
+		bool wait( int aTimeoutInMillis ) const;
+		/*
+		 * This method waits for the task to finish and if the task threw
+		 * an exception, it throws a CKException with the message from
+		 * the original exception.
+		 */
+		void get() const;
+		/*
+		 * Once the task is done, these say if it threw an exception and
+		 * what the message was.
+		 */
+		bool failed() const;
+		CKString getErrorMessage() const;
+
+	private:
+		friend class CKExecutor;
+		friend class CKExecutorWorker;
+
+		CKExecutorFuture( CKExecutorFutureState *aState );
+
+		// this is the shared state of the task
+		CKExecutorFutureState	*mState;
+};
+
+
+/*******************************************************************
+ *
+ *                     Executor Task Entry
+ *
+ *******************************************************************/
+/*
+ * This is what's actually kept on the worker's deques - the task, if
+ * the executor is supposed to delete it when it's done, and the state
+ * that the future is watching.
+ */
+class CKExecutorEntry
+{
+	public:
+		CKExecutorEntry();
+		CKExecutorEntry( ICKExecutorTask *aTask, bool aDeleteWhenDone,
+						 CKExecutorFutureState *aState );
+
+		ICKExecutorTask			*task;
+		bool					deleteWhenDone;
+		CKExecutorFutureState	*state;
+};
+
+
+/*******************************************************************
+ *
+ *                     Executor Worker Thread
+ *
+ *******************************************************************/
+/*
+ * This is one of the threads in the pool. It's a simple CKFWThread
+ * whose process() method runs one task - its own or a stolen one - or
+ * parks until there's work to do.
+ */
+class CKExecutorWorker :
+	public CKFWThread
+{
+	public:
+		CKExecutorWorker( CKExecutor *anExecutor, int anIndex );
+		virtual ~CKExecutorWorker();
+
+		/*
+		 * These are the deque operations. The owner pushes and pops at
+		 * the back, and the thieves steal from the front, so the owner
+		 * works on the freshest (cache-hot) tasks and the thieves get the
+		 * oldest, which are usually the biggest pieces of work.
+		 */
+		void push( const CKExecutorEntry & anEntry );
+		bool pop( CKExecutorEntry & anEntry );
+		bool steal( CKExecutorEntry & anEntry );
+
+	protected:
+		/*
+		 * This method is called within a loop in the CKFWThread's run
+		 * loop and runs one task, or waits for one to show up. When the
+		 * executor is shut down and there's no more work, it returns cDone.
+		 */
+		virtual int process();
+
+	private:
+		friend class CKExecutor;
+
+		CKExecutorWorker();
+		CKExecutorWorker( const CKExecutorWorker & anOther );
+		CKExecutorWorker & operator=( const CKExecutorWorker & anOther );
+
+		// this is the executor we work for
+		CKExecutor						*mExecutor;
+		// ...and this is our position in its list of workers
+		int								mIndex;
+		// this is our deque of tasks and the mutex protecting it
+		std::deque<CKExecutorEntry>		mTasks;
+		CKFWMutex						mTasksMutex;
+};
+
+
+/*
+ * This is the main class definition.
+ */
+class CKExecutor
+{
+	public:
+		/********************************************************
+		 *
+		 *                Constructors/Destructor
+		 *
+		 ********************************************************/
+		/*
+		 * This constructor creates and starts the given number of worker
+		 * threads. If the number is zero or less, the number of on-line
+		 * processors is used.
+		 */
+		CKExecutor( int aNumberOfThreads = 0 );
+		/*
+		 * This is the standard destructor and needs to be virtual to make
+		 * sure that if we subclass off this the right destructor will be
+		 * called. It shuts down the pool, finishing all the pending tasks.
+		 */
+		virtual ~CKExecutor();
+
+		/********************************************************
+		 *
+		 *                Accessor Methods
+		 *
+		 ********************************************************/
+		/*
+		 * This returns the number of worker threads in the pool.
+		 */
+		int getNumberOfThreads() const;
+		/*
+		 * This returns the number of tasks submitted but not yet started.
+		 */
+		int getPendingCount() const;
+		/*
+		 * This is the process-wide executor that the library uses for its
+		 * own parallel work. It's created on first use with one thread for
+		 * each on-line processor.
+		 */
+		static CKExecutor *getDefault();
+		/*
+		 * This returns the number of on-line processors on this box.
+		 */
+		static int getNumberOfProcessors();
+
+		/********************************************************
+		 *
+		 *                Task Methods
+		 *
+		 ********************************************************/
+		/*
+		 * This method places the task on the pool to be run and returns a
+		 * future that can be used to wait for it. If 'aDeleteWhenDone' is
+		 * true, the executor owns the task and will delete it once it has
+		 * run, otherwise the caller needs to keep it around until the
+		 * future is done.
+		 */
+		CKExecutorFuture submit( ICKExecutorTask *aTask, bool aDeleteWhenDone = false );
+		/*
+		 * This method runs the body over the range [aBegin, anEnd) on the
+		 * pool, in chunks of 'aGrainSize' indexes (if zero or less, the
+		 * range is split into a few chunks per worker). The calling thread
+		 * helps run the chunks, and the method returns when they are all
+		 * done. If any of the chunks threw an exception, a CKException is
+		 * thrown with the first message once they have all finished.
+		 */
+		void parallelFor( int aBegin, int anEnd, ICKExecutorRangeTask & aBody,
+						  int aGrainSize = 0 );
+		/*
+		 * This method stops the pool. All the tasks already submitted are
+		 * run, and then the worker threads exit and are joined. Submitting
+		 * a task after this throws a CKException. A worker can't join
+		 * itself, so calling this from one of the pool's own tasks throws
+		 * a CKException as well, and leaves the pool running.
+		 */
+		void shutdown();
+
+	protected:
+		friend class CKExecutorWorker;
+
+		/*
+		 * This method tries to find a task to run - from the given worker's
+		 * own deque first (if it's a worker), and then by stealing from the
+		 * others. If it finds one, it runs it and returns true.
+		 */
+		bool runOneTask( CKExecutorWorker *aWorker );
+		/*
+		 * This method runs the task in the entry, recording how it went in
+		 * the future's state and cleaning up after it.
+		 */
+		static void runEntry( CKExecutorEntry & anEntry );
+		/*
+		 * This method parks the calling worker until there's something
+		 * pending or the pool is shutting down.
+		 */
+		void waitForWork();
+		/*
+		 * This returns true when the pool is shutting down and all the
+		 * work is done, so the workers can exit.
+		 */
+		bool isFinished() const;
+		/*
+		 * This returns the worker that the calling thread is, or NULL if
+		 * it's not one of our workers.
+		 */
+		CKExecutorWorker *currentWorker() const;
+
+	private:
+		CKExecutor( const CKExecutor & anOther );
+		CKExecutor & operator=( const CKExecutor & anOther );
+
+		// these are the worker threads in the pool
+		CKVector<CKExecutorWorker *>	mWorkers;
+		// ...this is where the next outside submission goes
+		volatile long					mNextWorker;
+		// ...this is the number of tasks submitted and not yet started
+		volatile long					mPending;
+		// ...this is the number of workers parked waiting for work
+		volatile long					mSleepers;
+		// ...and this is set when we're shutting down
+		volatile long					mShutdown;
+		/*
+		 * The idle workers wait on this conditional until there's some
+		 * work to be done.
+		 */
+		CKFWMutex						mIdleMutex;
+		CKFWConditional					mIdleConditional;
+};
+
+#endif	// __CKEXECUTOR_H
@@ -7,6 +7,14 @@
  *                           allow subsequent push() calls to replace the data
  *                           but preserve the order.
  *
+ *                           The values are held in a std::map keyed by the
+ *                           user's key, and the map nodes are threaded into
+ *                           a doubly-linked list to keep the push order. This
+ *                           means that a push() of a key that's already in
+ *                           the queue is a simple in-place overwrite with no
+ *                           scanning of the pending keys, and the whole queue
+ *                           can be drained in one swap under the lock.
+ *
  * $Id: CKFIFOCoalescingQueue.h,v 1.3 2008/04/29 20:36:36 drbob Exp $
  */
 #ifndef __CKFIFOCOALESCINGQUEUE_H
@@ -24,12 +32,13 @@
 //	Third-Party Headers
 
 //	Other Headers
-#include "CKFIFOQueue.h"
 #include "CKString.h"
 #include "CKFWMutex.h"
 #include "CKStackLocker.h"
 #include "CKFWConditional.h"
 #include "CKException.h"
+#include "CKVector.h"
+#include "CKQueueStats.h"
 
 //	Forward Declarations
 template <class K, class T> class CKFIFOCoalescingQueue;
@@ -40,19 +49,12 @@ template <class K, class T> class CKFIFOCoalescingQueue;
 
 //	Public Data Constants
 /*
- * This is the default starting size of this queue as it's going to
- * simply be an allocated array of elements. When an operation adds more
- * that this to the size of the vector, we'll have to allocate more and
- * then this won't be the size. But for starters, this is a good size.
+ * These were the starting size and growth increment of the array of keys
+ * that used to preserve the order of this queue. The order is now kept
+ * in the map nodes themselves, so these are only here so that existing
+ * code that passes them to the constructor still compiles.
  */
 #define	CKFIFOCOALESCINGQUEUE_DEFAULT_STARTING_SIZE		8
-/*
- * When the buffer has to grow for this queue, this is the default
- * increment that it uses. Of course, this is *above* the necessary size
- * so if you're adding 2000 elements, we'll round it up to a factor of
- * the DEFAULT_INCREMENT_SIZE to make sure that we have at least a little
- * growing room.
- */
 #define	CKFIFOCOALESCINGQUEUE_DEFAULT_INCREMENT_SIZE		16
 
 
@@ -91,6 +93,51 @@ template <class K, class T> class CKFIFOCoalescingQueueNotEmptyTest :
 };
 
 
+/*******************************************************************
+ *
+ *                    Queue Order Node Class
+ *
+ *******************************************************************/
+/*
+ * Each value pushed onto the queue lives in one of these nodes as the
+ * value in the std::map. The nodes are then linked together in the order
+ * they were first pushed so that we never have to search for a key to
+ * know where it is in the queue. Since std::map never moves its nodes
+ * around, the pointers stay good until the entry is erased.
+ */
+template <class K, class T> class CKFIFOCoalescingQueueNode
+{
+	public:
+		CKFIFOCoalescingQueueNode() :
+			value(),
+			enqueuedAt(0.0),
+			key(NULL),
+			prev(NULL),
+			next(NULL)
+		{
+		}
+
+		CKFIFOCoalescingQueueNode( const T & aValue ) :
+			value(aValue),
+			enqueuedAt(0.0),
+			key(NULL),
+			prev(NULL),
+			next(NULL)
+		{
+		}
+
+		// this is the most recent value pushed for the key
+		T									value;
+		// ...this is when the key was first pushed (with statistics on)
+		double								enqueuedAt;
+		// ...this is the key in the map that holds this node
+		const K								*key;
+		// ...and these are the neighbors in the queue order
+		CKFIFOCoalescingQueueNode<K,T>		*prev;
+		CKFIFOCoalescingQueueNode<K,T>		*next;
+};
+
+
 /*
  * This is the main class definition.
  */
@@ -105,14 +152,17 @@ template <class K, class T> class CKFIFOCoalescingQueue
 		/*
 		 * This form of the constructor allows the user to specify the
 		 * starting size of the queue as well as the growth size when
-		 * the queue exceeds the starting size. Both of these default
-		 * to reasonable values, but it's nice to be able to set them
-		 * just the same.
+		 * the queue exceeds the starting size. Since the order of the
+		 * queue is now kept in the map nodes, these are ignored, but
+		 * they are still accepted so that existing code compiles.
 		 */
 		CKFIFOCoalescingQueue( int anInitialCapacity = CKFIFOCOALESCINGQUEUE_DEFAULT_STARTING_SIZE,
 							   int aResizeAmount = CKFIFOCOALESCINGQUEUE_DEFAULT_INCREMENT_SIZE ) :
 			mElements(),
-			mKeys(anInitialCapacity, aResizeAmount),
+			mHead(NULL),
+			mTail(NULL),
+			mStats(NULL),
+			mKeptStats(NULL),
 			mMutex(),
 			mConditional(mMutex)
 		{
@@ -126,7 +176,10 @@ template <class K, class T> class CKFIFOCoalescingQueue
 		 */
 		CKFIFOCoalescingQueue( CKFIFOCoalescingQueue<K,T> & anOther ) :
 			mElements(),
-			mKeys(),
+			mHead(NULL),
+			mTail(NULL),
+			mStats(NULL),
+			mKeptStats(NULL),
 			mMutex(),
 			mConditional(mMutex)
 		{
@@ -137,7 +190,10 @@ template <class K, class T> class CKFIFOCoalescingQueue
 
 		CKFIFOCoalescingQueue( const CKFIFOCoalescingQueue<K,T> & anOther ) :
 			mElements(),
-			mKeys(),
+			mHead(NULL),
+			mTail(NULL),
+			mStats(NULL),
+			mKeptStats(NULL),
 			mMutex(),
 			mConditional(mMutex)
 		{
@@ -152,7 +208,12 @@ template <class K, class T> class CKFIFOCoalescingQueue
 		 */
 		virtual ~CKFIFOCoalescingQueue()
 		{
-			// everything here takes care of itself.
+			// everything else here takes care of itself.
+			disableStatistics();
+			if (mKeptStats != NULL) {
+				delete mKeptStats;
+				mKeptStats = NULL;
+			}
 		}
 
 
@@ -169,9 +230,18 @@ template <class K, class T> class CKFIFOCoalescingQueue
 
 		CKFIFOCoalescingQueue<K,T> & operator=( CKFIFOCoalescingQueue<K,T> & anOther )
 		{
-			// first, copy in the easy values
-			mElements = anOther.mElements;
-			mKeys = anOther.mKeys;
+			// make sure that we don't do this to ourselves
+			if (this != & anOther) {
+				// lock up both queues for the copy
+				CKStackLocker	lockem(&mMutex);
+				CKStackLocker	lockOther(&anOther.mMutex);
+
+				// drop what we have and re-push the other's entries in order
+				clearNodes();
+				for (Node *n = anOther.mHead; n != NULL; n = n->next) {
+					appendNode(*n->key, n->value);
+				}
+			}
 
 			return *this;
 		}
@@ -191,24 +261,74 @@ template <class K, class T> class CKFIFOCoalescingQueue
 		 */
 		int size() const
 		{
-			return mKeys.size();
+			return (int)mElements.size();
 		}
 
 
 		int length() const
 		{
-			return mKeys.size();
+			return (int)mElements.size();
 		}
 
 
 		/*
 		 * This method returns the current capacity of the queue and
 		 * is NOT the size per se. The capacity is what this queue
-		 * will hold before having to resize it's contents.
+		 * will hold before having to resize it's contents. Since the
+		 * nodes are allocated as they are pushed, this is the size.
 		 */
 		int capacity() const
 		{
-			return mKeys.capacity();
+			return (int)mElements.size();
+		}
+
+
+		/*
+		 * These methods turn on and off the gathering of statistics for
+		 * this queue. When they are on, the depth, the counts of pushes,
+		 * coalesced pushes and pops, and the time each key spent in the
+		 * queue are all kept in a CKQueueStats registered under the
+		 * provided name so that it shows up in CKQueueStats::dumpAll().
+		 * When they are off, which is the default, none of this costs
+		 * anything. Turning them off just stops the counting - the
+		 * CKQueueStats is made the first time they're turned on and lasts
+		 * as long as the queue, so turning them back on carries on with it,
+		 * under the name it was made with.
+		 */
+		void enableStatistics( const CKString & aName )
+		{
+			CKStackLocker	lockem(&mMutex);
+			if (mStats == NULL) {
+				if (mKeptStats == NULL) {
+					mKeptStats = new CKQueueStats(aName);
+				}
+				mStats = mKeptStats;
+				// what's already here we'll say just showed up
+				double	now = CKQueueStats::now();
+				for (Node *n = mHead; n != NULL; n = n->next) {
+					n->enqueuedAt = now;
+				}
+				mStats->depthChanged(size());
+			}
+		}
+
+
+		void disableStatistics()
+		{
+			CKStackLocker	lockem(&mMutex);
+			mStats = NULL;
+		}
+
+
+		/*
+		 * This returns the statistics for this queue, or NULL if they
+		 * have never been turned on. The values can be read at any time
+		 * without locking the queue, and the pointer is good for as long
+		 * as the queue is - even after the statistics are turned off.
+		 */
+		const CKQueueStats *getStatistics() const
+		{
+			return mKeptStats;
 		}
 
 
@@ -236,7 +356,8 @@ template <class K, class T> class CKFIFOCoalescingQueue
 		 ********************************************************/
 		/*
 		 * There needs to be a simple way to add an element to the queue.
-		 * This is it.
+		 * This is it. If the key is already in the queue, the value is
+		 * replaced in place and the key keeps its position in the queue.
 		 */
 		void push( const K & aKey, const T & anElem )
 		{
@@ -244,11 +365,9 @@ template <class K, class T> class CKFIFOCoalescingQueue
 			CKStackLocker	lockem(&mMutex);
 
 			// add the data to the map - replacing or adding as it may be
-			mElements[aKey] = anElem;
-			// push the key onto the key stack - ignoring duplicates
-			mKeys.push(aKey);
+			pushNode(aKey, anElem);
 			// see if we need to wake any waiters
-			if (mKeys.size() == 1) {
+			if (mElements.size() == 1) {
 				mConditional.wakeWaiter();
 			}
 		}
@@ -263,18 +382,16 @@ template <class K, class T> class CKFIFOCoalescingQueue
 			// first, lock up this guy against changes
 			CKStackLocker	lockem(&mMutex);
 
-			// get the size of the keys right now
-			int		startingSize = mKeys.size();
+			// get the size of the queue right now
+			int		startingSize = size();
 			// now let's rip through the map of stuff and add what's needed
 			typename std::map<K,T>::const_iterator		i;
 			for (i = aMap.begin(); i != aMap.end(); ++i) {
 				// add the data to the map - replacing or adding as it may be
-				mElements[i->first] = i->second;
-				// push the key onto the key stack - ignoring duplicates
-				mKeys.push(i->first);
+				pushNode(i->first, i->second);
 			}
 			// see if we need to wake any waiters
-			if ((startingSize == 0) && (mKeys.size() > 0)) {
+			if ((startingSize == 0) && (size() > 0)) {
 				mConditional.wakeWaiter();
 			}
 		}
@@ -287,10 +404,11 @@ template <class K, class T> class CKFIFOCoalescingQueue
 		 */
 		T pop()
 		{
-			T		retval;
+			// first, lock up this guy against changes
+			CKStackLocker	lockem(&mMutex);
 
-			// first, see if we have anything to do
-			if (mKeys.empty()) {
+			// next, see if we have anything to do
+			if (mHead == NULL) {
 				std::ostringstream	msg;
 				msg << "CKFIFOCoalescingQueue<K,T>::pop() - there are no elements in this queue "
 					"to return. Please use the size() method to verify that there "
@@ -298,16 +416,8 @@ template <class K, class T> class CKFIFOCoalescingQueue
 				throw CKException(__FILE__, __LINE__, msg.str());
 			}
 
-			// next, lock up this guy against changes
-			CKStackLocker	lockem(&mMutex);
-
-			// grab the first one in the queue
-			K	key = mKeys.pop();
-			// ...now get the value out of the map and remove it from the map
-			retval = mElements[key];
-			mElements.erase(key);
-
-			return retval;
+			// grab the first one in the queue and remove it
+			return popHead();
 		}
 
 
@@ -320,8 +430,11 @@ template <class K, class T> class CKFIFOCoalescingQueue
 		{
 			CKVector<T>		retval;
 
-			// first, see if we have anything to do
-			if (mKeys.empty()) {
+			// first, lock up this guy against changes
+			CKStackLocker	lockem(&mMutex);
+
+			// next, see if we have anything to do
+			if (mHead == NULL) {
 				std::ostringstream	msg;
 				msg << "CKFIFOCoalescingQueue<K,T>::pop(int) - there are no elements "
 					"in this queue to return. Please use the size() method to verify "
@@ -329,23 +442,73 @@ template <class K, class T> class CKFIFOCoalescingQueue
 				throw CKException(__FILE__, __LINE__, msg.str());
 			}
 
-			// next, lock up this guy against changes
-			CKStackLocker	lockem(&mMutex);
-
 			// figure out how many to grab off the queue
-			int		cnt = (aNumber > mKeys.size() ? mKeys.size() : aNumber);
+			int		cnt = (aNumber > size() ? size() : aNumber);
 			for (int i = 0; i < cnt; ++i) {
-				// grab the first one in the queue
-				K	key = mKeys.pop();
-				// ...now get the value out of the map and remove it from the map
-				retval.addToEnd(mElements[key]);
-				mElements.erase(key);
+				retval.addToEnd(popHead());
 			}
 
 			return retval;
 		}
 
 
+		/*
+		 * This method is the bulk form of pop() for consumers that want
+		 * to process bursts of updates in batches. Up to 'aMaxCount' of
+		 * the values (all of them if 'aMaxCount' is negative) are taken
+		 * off the front of the queue with a single acquisition of the
+		 * lock and appended, in order, to the end of 'aBatch'. When the
+		 * entire queue is being taken, the storage is simply swapped out
+		 * and the copying to 'aBatch' happens after the lock is released
+		 * so that producers are held up as little as possible. The return
+		 * value is the number of values appended, and an empty queue is
+		 * not an error - it simply returns 0.
+		 */
+		int drain( CKVector<T> & aBatch, int aMaxCount = -1 )
+		{
+			int					cnt = 0;
+			std::map<K,Node>	taken;
+			Node				*head = NULL;
+
+			// lock up this guy only as long as it takes to detach the values
+			mMutex.lock();
+			CKQueueStats		*stats = mStats;
+			if ((aMaxCount < 0) || (aMaxCount >= size())) {
+				// take it all - the nodes don't move so the links are still good
+				mElements.swap(taken);
+				head = mHead;
+				mHead = NULL;
+				mTail = NULL;
+				if (stats != NULL) {
+					stats->depthChanged(0);
+				}
+			} else {
+				// just take the front of the queue off one at a time
+				try {
+					for (cnt = 0; cnt < aMaxCount; ++cnt) {
+						aBatch.addToEnd(popHead());
+					}
+				} catch (...) {
+					mMutex.unlock();
+					throw;
+				}
+			}
+			mMutex.unlock();
+
+			// now copy out anything we swapped out in the original order
+			double	now = (stats != NULL ? CKQueueStats::now() : 0.0);
+			for (Node *n = head; n != NULL; n = n->next) {
+				aBatch.addToEnd(n->value);
+				if (stats != NULL) {
+					stats->dequeued(-1, now - n->enqueuedAt);
+				}
+				++cnt;
+			}
+
+			return cnt;
+		}
+
+
 		/*
 		 * When you want to remove the next element off the queue,
 		 * this method will return that element and it will be removed
@@ -364,11 +527,8 @@ template <class K, class T> class CKFIFOCoalescingQueue
 			// wait until we get something in the queue
 			mConditional.lockAndTest(tst);
 
-			// grab the first one in the queue
-			K	key = mKeys.pop();
-			// ...now get the value out of the map and remove it from the map
-			retval = mElements[key];
-			mElements.erase(key);
+			// grab the first one in the queue and remove it
+			retval = popHead();
 
 			// now we can unlock this guy
 			mMutex.unlock();
@@ -391,11 +551,15 @@ template <class K, class T> class CKFIFOCoalescingQueue
 			 * we need to find the value, remove the keys from the queue, and
 			 * then remove the key/value from the map. Easy.
 			 */
-			typename std::map<K,T>::iterator	i;
+			CKStackLocker	lockem(&mMutex);
+			typename std::map<K,Node>::iterator		i;
 			for (i = mElements.begin(); i != mElements.end(); ++i) {
-				if (i->second == anOther) {
-					mKeys.remove(i->first);
+				if (i->second.value == anOther) {
+					unlinkNode(&(i->second));
 					mElements.erase(i);
+					if (mStats != NULL) {
+						mStats->depthChanged(size());
+					}
 					break;
 				}
 			}
@@ -420,9 +584,13 @@ template <class K, class T> class CKFIFOCoalescingQueue
 			 * we need to find the value, remove the keys from the queue, and
 			 * then remove the key/value from the map. Easy.
 			 */
-			if (mElements.find(aKey) != mElements.end()) {
-				mKeys.remove(aKey);
-				mElements.erase(aKey);
+			typename std::map<K,Node>::iterator		i = mElements.find(aKey);
+			if (i != mElements.end()) {
+				unlinkNode(&(i->second));
+				mElements.erase(i);
+				if (mStats != NULL) {
+					mStats->depthChanged(size());
+				}
 			}
 		}
 
@@ -435,13 +603,13 @@ template <class K, class T> class CKFIFOCoalescingQueue
 		 */
 		bool empty()
 		{
-			return mKeys.empty();
+			return (mHead == NULL);
 		}
 
 
 		bool empty() const
 		{
-			return mKeys.empty();
+			return (mHead == NULL);
 		}
 
 
@@ -454,8 +622,7 @@ template <class K, class T> class CKFIFOCoalescingQueue
 		{
 			CKStackLocker	lockem(&mMutex);
 
-			mElements.clear();
-			mKeys.clear();
+			clearNodes();
 		}
 
 
@@ -480,22 +647,20 @@ template <class K, class T> class CKFIFOCoalescingQueue
 
 			// check the sizes
 			if (equal) {
-				if (mKeys.size() != anOther.mKeys.size()) {
+				if (mElements.size() != anOther.mElements.size()) {
 					equal = false;
 				}
 			}
 
-			// check the elements
+			// check the keys and elements (including the order)
 			if (equal) {
-				if (mElements != anOther.mElements) {
-					equal = false;
-				}
-			}
-
-			// check the keys (including the order
-			if (equal) {
-				if (mKeys != anOther.mKeys) {
-					equal = false;
+				Node	*me = mHead;
+				Node	*him = anOther.mHead;
+				for (; (me != NULL) && (him != NULL); me = me->next, him = him->next) {
+					if (!(*me->key == *him->key) || !(me->value == him->value)) {
+						equal = false;
+						break;
+					}
 				}
 			}
 
@@ -569,20 +734,155 @@ template <class K, class T> class CKFIFOCoalescingQueue
 			return retval;
 		}
 
+	protected:
+		// this is the node type that holds each value and its place in line
+		typedef CKFIFOCoalescingQueueNode<K,T>	Node;
+
+		/*
+		 * This method adds the key/value to the map if it's not there
+		 * and links it onto the end of the queue. If the key is already
+		 * in the queue, the value is simply replaced and the position in
+		 * the queue is left alone. This is the coalescing. The caller
+		 * needs to be holding the lock.
+		 */
+		void pushNode( const K & aKey, const T & anElem )
+		{
+			// find the spot in the map for this key with one tree walk
+			typename std::map<K,Node>::iterator		i = mElements.lower_bound(aKey);
+			if ((i != mElements.end()) && !(aKey < i->first)) {
+				// coalesce - replace the value and keep the position
+				i->second.value = anElem;
+				if (mStats != NULL) {
+					mStats->coalesced();
+				}
+			} else {
+				// new key - add it to the map using the hint, and link it in
+				i = mElements.insert(i, std::make_pair(aKey, Node(anElem)));
+				linkNode(i);
+				if (mStats != NULL) {
+					i->second.enqueuedAt = CKQueueStats::now();
+					mStats->enqueued(size());
+				}
+			}
+		}
+
+
+		/*
+		 * This method is used when copying one queue to another and
+		 * simply adds the key/value to the end of the queue. The caller
+		 * needs to be holding the lock.
+		 */
+		void appendNode( const K & aKey, const T & anElem )
+		{
+			typename std::map<K,Node>::iterator		i =
+				mElements.insert(mElements.end(), std::make_pair(aKey, Node(anElem)));
+			linkNode(i);
+			if (mStats != NULL) {
+				i->second.enqueuedAt = CKQueueStats::now();
+				mStats->enqueued(size());
+			}
+		}
+
+
+		/*
+		 * This method takes the map entry and links its node onto the end
+		 * of the queue order. The caller needs to be holding the lock.
+		 */
+		void linkNode( typename std::map<K,Node>::iterator anEntry )
+		{
+			Node	*n = &(anEntry->second);
+			n->key = &(anEntry->first);
+			n->prev = mTail;
+			n->next = NULL;
+			if (mTail != NULL) {
+				mTail->next = n;
+			} else {
+				mHead = n;
+			}
+			mTail = n;
+		}
+
+
+		/*
+		 * This method removes the node from the queue order but leaves it
+		 * in the map. The caller needs to be holding the lock and then
+		 * erase the entry from the map.
+		 */
+		void unlinkNode( Node *aNode )
+		{
+			if (aNode->prev != NULL) {
+				aNode->prev->next = aNode->next;
+			} else {
+				mHead = aNode->next;
+			}
+			if (aNode->next != NULL) {
+				aNode->next->prev = aNode->prev;
+			} else {
+				mTail = aNode->prev;
+			}
+			aNode->prev = NULL;
+			aNode->next = NULL;
+		}
+
+
+		/*
+		 * This method removes the first value in the queue and returns
+		 * it. The caller needs to be holding the lock and have made sure
+		 * that the queue isn't empty.
+		 */
+		T popHead()
+		{
+			Node	*n = mHead;
+			T		retval = n->value;
+			K		key = *n->key;
+			if (mStats != NULL) {
+				mStats->dequeued(size() - 1, CKQueueStats::now() - n->enqueuedAt);
+			}
+			unlinkNode(n);
+			mElements.erase(key);
+			return retval;
+		}
+
+
+		/*
+		 * This method drops everything in the queue. The caller needs to
+		 * be holding the lock.
+		 */
+		void clearNodes()
+		{
+			mElements.clear();
+			mHead = NULL;
+			mTail = NULL;
+			if (mStats != NULL) {
+				mStats->depthChanged(0);
+			}
+		}
+
 	private:
 		/*
 		 * This is the std::map that is the core of the storage of the
 		 * CKFIFOCoalescingQueue. It's simple, but it's very effective as
 		 * I can put all the key,values pushed onto this queue here and
-		 * then use the 'keys' FIFOQueue to preserve the order.
+		 * then use the links in the nodes to preserve the order.
+		 */
+		std::map<K,Node>	mElements;
+		/*
+		 * This is the "FIFO" nature of the queue as these are the first
+		 * and last nodes in the order they were pushed onto this queue.
+		 * Each node points to its neighbors, so a duplicate push never
+		 * has to go looking for where the key is in the queue.
 		 */
-		std::map<K,T>	mElements;
+		Node				*mHead;
+		Node				*mTail;
 		/*
-		 * This is the "FIFO" nature of the queue as this guy will be
-		 * preserving the order of the elements as they are pushed onto
-		 * this queue and will be set to ignore duplicates.
+		 * When the user asks for statistics on this queue, this is where
+		 * they are kept. It's NULL when the statistics are off, but the
+		 * CKQueueStats itself is in mKeptStats from the first time they're
+		 * turned on until the queue is gone, so getStatistics() never hands
+		 * out a dead one.
 		 */
-		CKFIFOQueue<K>	mKeys;
+		CKQueueStats		*mStats;
+		CKQueueStats		*mKeptStats;
 		/*
 		 * When it comes to messing with this queue, we're going to make
 		 * sure that it can play well in a multi-threaded environment. To
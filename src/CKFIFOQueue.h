@@ -26,6 +26,7 @@
 #include "CKFWConditional.h"
 #include "CKException.h"
 #include "CKVector.h"
+#include "CKQueueStats.h"
 
 //	Forward Declarations
 template <class T> class CKFIFOQueue;
@@ -113,6 +114,9 @@ template <class T> class CKFIFOQueue
 			mInitialCapacity(anInitialCapacity),
 			mCapacityIncrement(aResizeAmount),
 			mElementsAreUnique(true),
+			mStats(NULL),
+			mKeptStats(NULL),
+			mEnqueueTimes(NULL),
 			mMutex(),
 			mConditional(mMutex)
 		{
@@ -140,6 +144,9 @@ template <class T> class CKFIFOQueue
 			mInitialCapacity(0),
 			mCapacityIncrement(0),
 			mElementsAreUnique(true),
+			mStats(NULL),
+			mKeptStats(NULL),
+			mEnqueueTimes(NULL),
 			mMutex(),
 			mConditional(mMutex)
 		{
@@ -155,6 +162,9 @@ template <class T> class CKFIFOQueue
 			mInitialCapacity(0),
 			mCapacityIncrement(0),
 			mElementsAreUnique(true),
+			mStats(NULL),
+			mKeptStats(NULL),
+			mEnqueueTimes(NULL),
 			mMutex(),
 			mConditional(mMutex)
 		{
@@ -173,6 +183,11 @@ template <class T> class CKFIFOQueue
 				delete [] mElements;
 				mElements = NULL;
 			}
+			disableStatistics();
+			if (mKeptStats != NULL) {
+				delete mKeptStats;
+				mKeptStats = NULL;
+			}
 		}
 
 
@@ -197,7 +212,10 @@ template <class T> class CKFIFOQueue
 			mElementsAreUnique = anOther.mElementsAreUnique;
 
 			// next, try to get the right sized array
-			mElements = new T[mSize];
+			if (mElements != NULL) {
+				delete [] mElements;
+			}
+			mElements = new T[mCapacity];
 			if (mElements == NULL) {
 				std::ostringstream	msg;
 				msg << "CKFIFOQueue<T>::CKFIFOQueue<T>(CKFIFOQueue<T> &) - the initial storage "
@@ -212,6 +230,17 @@ template <class T> class CKFIFOQueue
 				mElements[i] = anOther.mElements[i];
 			}
 
+			// the statistics are our own, but the time stamps need resizing
+			if (mEnqueueTimes != NULL) {
+				delete [] mEnqueueTimes;
+				mEnqueueTimes = new double[mCapacity];
+				double	now = CKQueueStats::now();
+				for (int i = 0; i < mSize; i++) {
+					mEnqueueTimes[i] = now;
+				}
+				mStats->depthChanged(mSize);
+			}
+
 			return *this;
 		}
 
@@ -278,6 +307,59 @@ template <class T> class CKFIFOQueue
 		}
 
 
+		/*
+		 * These methods turn on and off the gathering of statistics for
+		 * this queue. When they are on, the depth, the counts of pushes
+		 * and pops, and the time each element spent in the queue are all
+		 * kept in a CKQueueStats registered under the provided name so
+		 * that it shows up in CKQueueStats::dumpAll(). When they are off,
+		 * which is the default, none of this costs anything. Turning them
+		 * off just stops the counting - the CKQueueStats is made the first
+		 * time they're turned on and lasts as long as the queue, so turning
+		 * them back on carries on with it, under the name it was made with.
+		 */
+		void enableStatistics( const CKString & aName )
+		{
+			CKStackLocker	lockem(&mMutex);
+			if (mStats == NULL) {
+				if (mKeptStats == NULL) {
+					mKeptStats = new CKQueueStats(aName);
+				}
+				mStats = mKeptStats;
+				mEnqueueTimes = new double[mCapacity];
+				// what's already here we'll say just showed up
+				double	now = CKQueueStats::now();
+				for (int i = 0; i < mSize; i++) {
+					mEnqueueTimes[i] = now;
+				}
+				mStats->depthChanged(mSize);
+			}
+		}
+
+
+		void disableStatistics()
+		{
+			CKStackLocker	lockem(&mMutex);
+			mStats = NULL;
+			if (mEnqueueTimes != NULL) {
+				delete [] mEnqueueTimes;
+				mEnqueueTimes = NULL;
+			}
+		}
+
+
+		/*
+		 * This returns the statistics for this queue, or NULL if they
+		 * have never been turned on. The values can be read at any time
+		 * without locking the queue, and the pointer is good for as long
+		 * as the queue is - even after the statistics are turned off.
+		 */
+		const CKQueueStats *getStatistics() const
+		{
+			return mKeptStats;
+		}
+
+
 		/*
 		 * Because there may be times that the user wants to lock us up
 		 * for change, we're going to expose this here so it's easy for them
@@ -328,11 +410,15 @@ template <class T> class CKFIFOQueue
 				// put this guy where he belongs and up the count
 				mElements[mSize] = anElem;
 				mSize++;
-
-				// see if we need to wake any waiters
-				if (mSize == 1) {
-					mConditional.wakeWaiter();
-				}
+				noteEnqueued();
+
+				/*
+				 * Wake up a waiter on every push - not just when the queue
+				 * goes from empty to not-empty - as there can be several
+				 * consumers waiting in popSomething() or popBatch() and the
+				 * signal is cheap when no one is waiting.
+				 */
+				mConditional.wakeWaiter();
 			}
 		}
 
@@ -368,12 +454,13 @@ template <class T> class CKFIFOQueue
 					// put this guy where he belongs and up the count
 					mElements[mSize] = aVector[i];
 					mSize++;
+					noteEnqueued();
 				}
 			}
 
-			// see if we need to wake any waiters
-			if ((startingSize == 0) && (mSize > 0)) {
-				mConditional.wakeWaiter();
+			// if we added anything, wake all the waiters as there's enough for many
+			if (mSize > startingSize) {
+				mConditional.wakeWaiters();
 			}
 		}
 
@@ -408,6 +495,7 @@ template <class T> class CKFIFOQueue
 
 			// grab the first one in the list
 			retval = mElements[0];
+			noteDequeued(1);
 
 			// now we need to move everything over one to the left
 			mSize--;
@@ -452,6 +540,7 @@ template <class T> class CKFIFOQueue
 			for (int i = 0; i < cnt; ++i) {
 				retval.addToEnd(mElements[i]);
 			}
+			noteDequeued(cnt);
 
 			// now we need to move everything to the left
 			if (cnt == mSize) {
@@ -500,6 +589,7 @@ template <class T> class CKFIFOQueue
 
 			// grab the first one in the list
 			retval = mElements[0];
+			noteDequeued(1);
 
 			// now we need to move everything over one to the left
 			mSize--;
@@ -514,6 +604,61 @@ template <class T> class CKFIFOQueue
 		}
 
 
+		/*
+		 * This method is the blocking, batched form of pop(int) for the
+		 * consumers that want to process whatever is on the queue in one
+		 * go. It waits until there is at least one element on the queue,
+		 * or until 'aTimeoutInMillis' have passed (-1 means wait forever
+		 * and 0 means don't wait at all), and then removes up to
+		 * 'aMaxItems' of the elements with a single acquisition of the
+		 * lock. If the timeout expires, the returned CKVector is empty.
+		 */
+		CKVector<T> popBatch( int aMaxItems, int aTimeoutInMillis = -1 )
+		{
+			CKVector<T>		retval;
+
+			// first, see if we have anything to do
+			if (mElements == NULL) {
+				std::ostringstream	msg;
+				msg << "CKFIFOQueue<T>::popBatch(int, int) - the storage for this "
+					"queue is NULL and that is a data corruption problem that needs "
+					"to be looked into as soon as possible. This should never happen.";
+				throw CKException(__FILE__, __LINE__, msg.str());
+			}
+
+			// now make a test based on this queue
+			CKFIFOQueueNotEmptyTest<T>	tst(this);
+			// wait until we get something in the queue, or give up
+			if (mConditional.lockAndTest(tst, aTimeoutInMillis) == FWCOND_LOCK_SUCCESS) {
+				// we hold the lock now, so grab as many as we can
+				int		cnt = (aMaxItems > mSize ? mSize : aMaxItems);
+				try {
+					for (int i = 0; i < cnt; ++i) {
+						retval.addToEnd(mElements[i]);
+					}
+				} catch (...) {
+					mMutex.unlock();
+					throw;
+				}
+				noteDequeued(cnt);
+
+				// now we need to move everything to the left
+				if (cnt > 0) {
+					int		j = 0;
+					for (int i = cnt; i < mSize; ++i) {
+						mElements[j++] = mElements[i];
+					}
+					mSize -= cnt;
+				}
+
+				// now we can unlock this guy
+				mMutex.unlock();
+			}
+
+			return retval;
+		}
+
+
 		/*
 		 * This method removes ALL copies of the argument from the queue
 		 * and compresses out the empty spaces from the queue. If the
@@ -528,6 +673,12 @@ template <class T> class CKFIFOQueue
 					for (int j = i+1; j < mSize; j++) {
 						mElements[j-1] = mElements[j];
 					}
+					if (mEnqueueTimes != NULL) {
+						for (int j = i+1; j < mSize; j++) {
+							mEnqueueTimes[j-1] = mEnqueueTimes[j];
+						}
+						mStats->depthChanged(mSize - 1);
+					}
 					// we have one less thing in the list
 					mSize--;
 				} else {
@@ -564,6 +715,9 @@ template <class T> class CKFIFOQueue
 		void clear()
 		{
 			mSize = 0;
+			if (mStats != NULL) {
+				mStats->depthChanged(0);
+			}
 		}
 
 
@@ -711,6 +865,42 @@ template <class T> class CKFIFOQueue
 		}
 
 
+		/*
+		 * This method records the element just added to the end of the
+		 * queue in the statistics - if we're keeping them. The caller
+		 * needs to be holding the lock.
+		 */
+		void noteEnqueued()
+		{
+			if (mStats != NULL) {
+				mEnqueueTimes[mSize - 1] = CKQueueStats::now();
+				mStats->enqueued(mSize);
+			}
+		}
+
+
+		/*
+		 * This method records the first 'aCount' elements of the queue
+		 * as having been taken off in the statistics - if we're keeping
+		 * them. It needs to be called *before* the elements are shifted
+		 * down and the size reduced, and the caller needs to be holding
+		 * the lock.
+		 */
+		void noteDequeued( int aCount )
+		{
+			if (mStats != NULL) {
+				double	now = CKQueueStats::now();
+				for (int i = 0; i < aCount; i++) {
+					mStats->dequeued(mSize - i - 1, now - mEnqueueTimes[i]);
+				}
+				// shift the time stamps down just like the elements
+				for (int i = aCount; i < mSize; i++) {
+					mEnqueueTimes[i - aCount] = mEnqueueTimes[i];
+				}
+			}
+		}
+
+
 		/*
 		 * This method resizes the queue to contain exactly the
 		 * specified number of elements - no more no less. If there
@@ -750,6 +940,16 @@ template <class T> class CKFIFOQueue
 			mElements = resultant;
 			mSize = copyCnt;
 			mCapacity = aNewSize;
+
+			// ...and if we have time stamps, they need to grow as well
+			if (mEnqueueTimes != NULL) {
+				double	*times = new double[aNewSize];
+				for (int i = 0; i < copyCnt; i++) {
+					times[i] = mEnqueueTimes[i];
+				}
+				delete [] mEnqueueTimes;
+				mEnqueueTimes = times;
+			}
 		}
 
 
@@ -793,6 +993,17 @@ template <class T> class CKFIFOQueue
 		 * an element to the queue if there isn't already a match.
 		 */
 		bool			mElementsAreUnique;
+		/*
+		 * When the user asks for statistics on this queue, this is where
+		 * they are kept, and this is the time each element was pushed on
+		 * the queue - in the same order as the elements themselves. Both
+		 * are NULL when the statistics are off. The CKQueueStats itself is
+		 * in mKeptStats from the first time they're turned on until the
+		 * queue is gone, so getStatistics() never hands out a dead one.
+		 */
+		CKQueueStats	*mStats;
+		CKQueueStats	*mKeptStats;
+		double			*mEnqueueTimes;
 		/*
 		 * When it comes to messing with this queue, we're going to make
 		 * sure that it can play well in a multi-threaded environment. To
@@ -0,0 +1,174 @@
+/*
+ * CKFWAtomic.h - this file defines a few simple atomic operations on
+ *                word-sized integers that are used in the FeatherWeight
+ *                library for counters and flags that need to be updated
+ *                from several threads without taking a mutex. With GCC
+ *                these are the __sync builtins, and for compilers that
+ *                don't have them they fall back to a single process-wide
+ *                pthread mutex, which is slow, but correct.
+ *
+ * $Id$
+ */
+#ifndef __CKFW_ATOMIC_H
+#define __CKFW_ATOMIC_H
+
+//	System Headers
+#include <pthread.h>
+
+//	Third-Party Headers
+
+//	Other Headers
+
+//	Forward Declarations
+
+//	Public Constants
+#if defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 1)))
+#define CKFW_HAVE_SYNC_BUILTINS		1
+#endif
+
+//	Public Datatypes
+
+//	Public Data Constants
+
+
+#ifndef CKFW_HAVE_SYNC_BUILTINS
+/*
+ * Without the builtins, every atomic operation goes through this one
+ * mutex. It's only here so that the library still works on the older
+ * compilers - nobody should be running the hot paths on them.
+ */
+inline pthread_mutex_t *CKFWAtomicMutex()
+{
+	static pthread_mutex_t	mutex = PTHREAD_MUTEX_INITIALIZER;
+	return &mutex;
+}
+#endif
+
+
+/*
+ * This atomically adds 'aDelta' to the value and returns the new value.
+ */
+inline long CKFWAtomicAdd( volatile long *aValue, long aDelta )
+{
+#ifdef CKFW_HAVE_SYNC_BUILTINS
+	return __sync_add_and_fetch(aValue, aDelta);
+#else
+	pthread_mutex_lock(CKFWAtomicMutex());
+	long	retval = (*aValue += aDelta);
+	pthread_mutex_unlock(CKFWAtomicMutex());
+	return retval;
+#endif
+}
+
+
+inline unsigned long CKFWAtomicAdd( volatile unsigned long *aValue, unsigned long aDelta )
+{
+#ifdef CKFW_HAVE_SYNC_BUILTINS
+	return __sync_add_and_fetch(aValue, aDelta);
+#else
+	pthread_mutex_lock(CKFWAtomicMutex());
+	unsigned long	retval = (*aValue += aDelta);
+	pthread_mutex_unlock(CKFWAtomicMutex());
+	return retval;
+#endif
+}
+
+
+inline unsigned long long CKFWAtomicAdd( volatile unsigned long long *aValue,
+										 unsigned long long aDelta )
+{
+#ifdef CKFW_HAVE_SYNC_BUILTINS
+	return __sync_add_and_fetch(aValue, aDelta);
+#else
+	pthread_mutex_lock(CKFWAtomicMutex());
+	unsigned long long	retval = (*aValue += aDelta);
+	pthread_mutex_unlock(CKFWAtomicMutex());
+	return retval;
+#endif
+}
+
+
+/*
+ * This atomically replaces the value with 'aNewValue' if, and only if,
+ * it's currently 'anOldValue'. It returns true if the swap was made.
+ */
+inline bool CKFWAtomicCompareAndSwap( volatile long *aValue, long anOldValue, long aNewValue )
+{
+#ifdef CKFW_HAVE_SYNC_BUILTINS
+	return __sync_bool_compare_and_swap(aValue, anOldValue, aNewValue);
+#else
+	bool	swapped = false;
+	pthread_mutex_lock(CKFWAtomicMutex());
+	if (*aValue == anOldValue) {
+		*aValue = aNewValue;
+		swapped = true;
+	}
+	pthread_mutex_unlock(CKFWAtomicMutex());
+	return swapped;
+#endif
+}
+
+
+inline bool CKFWAtomicCompareAndSwap( void * volatile *aValue, void *anOldValue,
+									  void *aNewValue )
+{
+#ifdef CKFW_HAVE_SYNC_BUILTINS
+	return __sync_bool_compare_and_swap(aValue, anOldValue, aNewValue);
+#else
+	bool	swapped = false;
+	pthread_mutex_lock(CKFWAtomicMutex());
+	if (*aValue == anOldValue) {
+		*aValue = aNewValue;
+		swapped = true;
+	}
+	pthread_mutex_unlock(CKFWAtomicMutex());
+	return swapped;
+#endif
+}
+
+
+/*
+ * This raises the value to 'aCandidate' if that's larger than what's
+ * there now. It's used for the high-water marks.
+ */
+inline void CKFWAtomicMax( volatile long *aValue, long aCandidate )
+{
+	long	current = *aValue;
+	while ((aCandidate > current) &&
+		   !CKFWAtomicCompareAndSwap(aValue, current, aCandidate)) {
+		current = *aValue;
+	}
+}
+
+
+/*
+ * This is a full memory barrier - everything written before it will be
+ * seen by the other threads before anything that's written after it.
+ */
+inline void CKFWAtomicFence()
+{
+#ifdef CKFW_HAVE_SYNC_BUILTINS
+	__sync_synchronize();
+#else
+	pthread_mutex_lock(CKFWAtomicMutex());
+	pthread_mutex_unlock(CKFWAtomicMutex());
+#endif
+}
+
+
+/*
+ * This is what a thread does on each pass of a spin-wait loop. On x86
+ * it's the 'pause' instruction, which tells the CPU that we're spinning
+ * so it doesn't starve the other hyper-thread or flood the memory bus,
+ * and elsewhere it's nothing more than a compiler barrier.
+ */
+inline void CKFWAtomicPause()
+{
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+	__asm__ __volatile__("pause" ::: "memory");
+#elif defined(__GNUC__)
+	__asm__ __volatile__("" ::: "memory");
+#endif
+}
+
+#endif	// __CKFW_ATOMIC_H
@@ -88,14 +88,14 @@ int CKFWConditional::lockAndTest( const ICKFWConditionalSpuriousTest & aTest,
 	 */
 	timeval		lCurrentTimeval;
 	timespec	lTimeSpec;
-	if (aTimeoutInMillis > 0) {
+	if (aTimeoutInMillis >= 0) {
 		gettimeofday(&lCurrentTimeval, NULL);
 		// now populate when the timeout will occur based on the duration
 		lTimeSpec.tv_sec = lCurrentTimeval.tv_sec + aTimeoutInMillis/1000;
 		lTimeSpec.tv_nsec = ((aTimeoutInMillis % 1000)*1000
 							 + lCurrentTimeval.tv_usec) * 1000;
 		// if we crossed the second boundary correctly update the values
-		if (lTimeSpec.tv_nsec > 1000000000) {
+		if (lTimeSpec.tv_nsec >= 1000000000) {
 			lTimeSpec.tv_sec++;
 			lTimeSpec.tv_nsec -= 1000000000;
 		}
@@ -7,35 +7,242 @@
 
 //	System Headers
 #include <sys/errno.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+#include <sstream>
 
 //	Third-Party Headers
 
 //	Other Headers
 #include "CKFWMutex.h"
+#include "CKFWAtomic.h"
 #include "CKErrNoException.h"
+#include "CKString.h"
+#include "CKInstanceRegistry.h"
 
 //	Forward Declarations
 
 //	Private Constants
+/*
+ * This is the most 'pause' instructions we'll do between tries on a
+ * busy mutex - the back-off doubles up to this.
+ */
+#define	MAX_PAUSES_PER_SPIN		64
 
 //	Private Datatypes
 
 //	Private Data Constants
+/*
+ * This is the spin count the new mutexes get.
+ */
+static volatile long	sDefaultSpinCount = CKFW_MUTEX_DEFAULT_SPIN_COUNT;
+
+/*
+ * All the stats are in the process-wide registry so that dumpAll() can
+ * find them. Its lock is a plain pthread mutex, which matters here, as
+ * the stats are counting the locks of a CKFWMutex.
+ */
+typedef CKInstanceRegistry<CKFWMutexStats>	CKFWMutexStatsRegistry;
+
+
+/*
+ * This returns true if there's more than one CPU to spin against.
+ */
+static bool canSpin()
+{
+	static long		cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	return (cpus > 1);
+}
+
+
+/*
+ * This is a monotonic clock in nanoseconds for timing the waits.
+ */
+static unsigned long long nowNanos()
+{
+#ifdef CLOCK_MONOTONIC
+	timespec	ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#else
+	timeval		tv;
+	gettimeofday(&tv, NULL);
+	return (unsigned long long)tv.tv_sec * 1000000000ULL + tv.tv_usec * 1000ULL;
+#endif
+}
+
+
+/*******************************************************************
+ *
+ *                      Mutex Statistics
+ *
+ *******************************************************************/
+/*
+ * This is the constructor that takes the name the statistics are
+ * reported under and registers this instance in the process-wide
+ * list so that dumpAll() will include it.
+ */
+CKFWMutexStats::CKFWMutexStats( const char *aName ) :
+	mName(NULL),
+	mAcquisitionCount(0),
+	mContendedCount(0),
+	mSpinAcquisitionCount(0),
+	mTotalWaitNanos(0)
+{
+	const char	*name = (aName == NULL ? "" : aName);
+	mName = new char[strlen(name) + 1];
+	strcpy(mName, name);
+
+	// now add us to the list of all the stats
+	CKFWMutexStatsRegistry::add(this);
+}
+
+
+/*
+ * This is the standard destructor and needs to be virtual to make
+ * sure that if we subclass off this the right destructor will be
+ * called. It removes this instance from the process-wide list.
+ */
+CKFWMutexStats::~CKFWMutexStats()
+{
+	CKFWMutexStatsRegistry::remove(this);
+
+	delete [] mName;
+	mName = NULL;
+}
+
+
+/*
+ * This is the name that this mutex is reported under.
+ */
+const char *CKFWMutexStats::getName() const
+{
+	return mName;
+}
+
+
+/*
+ * These are the number of times the mutex was locked, the number
+ * of those times it was already locked by someone else, and the
+ * number of those that got the lock while spinning - without
+ * having to be put to sleep.
+ */
+unsigned long CKFWMutexStats::getAcquisitionCount() const
+{
+	return mAcquisitionCount;
+}
+
+
+unsigned long CKFWMutexStats::getContendedCount() const
+{
+	return mContendedCount;
+}
+
+
+unsigned long CKFWMutexStats::getSpinAcquisitionCount() const
+{
+	return mSpinAcquisitionCount;
+}
+
+
+/*
+ * This is the total time, in nanoseconds, that the callers have
+ * spent waiting on the contended locks.
+ */
+unsigned long long CKFWMutexStats::getTotalWaitNanos() const
+{
+	return mTotalWaitNanos;
+}
+
+
+/*
+ * The mutex calls this each time it's locked - with the time
+ * spent waiting if it was busy.
+ */
+void CKFWMutexStats::acquired( bool aContended, bool aSpun, unsigned long long aWaitNanos )
+{
+	CKFWAtomicAdd(&mAcquisitionCount, 1);
+	if (aContended) {
+		CKFWAtomicAdd(&mContendedCount, 1);
+		if (aSpun) {
+			CKFWAtomicAdd(&mSpinAcquisitionCount, 1);
+		}
+		CKFWAtomicAdd(&mTotalWaitNanos, aWaitNanos);
+	}
+}
+
 
+/*
+ * This method sets all the counts back to zero.
+ */
+void CKFWMutexStats::reset()
+{
+	mAcquisitionCount = 0;
+	mContendedCount = 0;
+	mSpinAcquisitionCount = 0;
+	mTotalWaitNanos = 0;
+}
+
+
+/*
+ * Because there are times when it's useful to have a nice
+ * human-readable form of the contents of this instance. Most of the
+ * time this means that it's used for debugging, but it could be used
+ * for just about anything. In these cases, it's nice not to have to
+ * worry about the ownership of the representation, so this returns
+ * a CKString.
+ */
+CKString CKFWMutexStats::toString() const
+{
+	std::ostringstream	buff;
+
+	buff << mName << ": locks=" << mAcquisitionCount << " contended=" <<
+		mContendedCount << " spun=" << mSpinAcquisitionCount << " wait(nsec)=" <<
+		mTotalWaitNanos;
+
+	return CKString(buff.str());
+}
+
+
+/*
+ * This method returns the toString() of every registered instance,
+ * one per line, in the order they were created.
+ */
+CKString CKFWMutexStats::dumpAll()
+{
+	return CKFWMutexStatsRegistry::dump(&CKFWMutexStats::toString);
+}
 
+
+/*******************************************************************
+ *
+ *                         Mutex
+ *
+ *******************************************************************/
 CKFWMutex::CKFWMutex() :
-	mLockingThread((pthread_t)-1)
+	mLockingThread((pthread_t)-1),
+	mSpinCount(0),
+	mStats(NULL),
+	mKeptStats(NULL)
 {
 	int lError = pthread_mutex_init(&mMutex,0);
 	if ( lError != 0 ) {
 		throw CKErrNoException( __FILE__, __LINE__, lError );
 	}
+	setSpinCount((int)sDefaultSpinCount);
 }
 
 CKFWMutex::~CKFWMutex()
 {
 	pthread_mutex_unlock( &mMutex );
 	pthread_mutex_destroy( &mMutex );
+	mStats = NULL;
+	if ( mKeptStats != NULL ) {
+		delete mKeptStats;
+		mKeptStats = NULL;
+	}
 }
 
 /**
@@ -54,32 +261,150 @@ bool CKFWMutex::tryLock()
 	}
 
 	mLockingThread = pthread_self( );
+	CKFWMutexStats	*stats = mStats;
+	if ( stats != NULL ) {
+		stats->acquired(false, false, 0);
+	}
 
 	return true;
 }
 
 /**
  * Attempts to lock the mutex.  If the mutex is already locked, this thread
- * will block until the mutex is available.  Throws a CKErrNoException if
- * there is some problem
+ * will spin for a bit, and then block until the mutex is available.
+ * Throws a CKErrNoException if there is some problem
  */
 void CKFWMutex::lock()
 {
-	int lError = pthread_mutex_lock( &mMutex );
-	if ( lError != 0 ) {
+	// the stats can be turned off at any time, so look just once
+	CKFWMutexStats	*stats = mStats;
+
+	// the plain mutex is just what it's always been
+	if ( (mSpinCount == 0) && (stats == NULL) ) {
+		int lError = pthread_mutex_lock( &mMutex );
+		if ( lError != 0 ) {
+			throw CKErrNoException( __FILE__, __LINE__, lError );
+		}
+		mLockingThread = pthread_self();
+		return;
+	}
+
+	// try for it once, and if we get it, that's all there is
+	int lError = pthread_mutex_trylock( &mMutex );
+	if ( lError == 0 ) {
+		mLockingThread = pthread_self();
+		if ( stats != NULL ) {
+			stats->acquired(false, false, 0);
+		}
+		return;
+	} else if ( lError != EBUSY ) {
 		throw CKErrNoException( __FILE__, __LINE__, lError );
 	}
 
+	// it's busy, so spin for a while backing off as we go
+	unsigned long long	start = (stats != NULL ? nowNanos() : 0);
+	bool				spun = false;
+	int					pauses = 1;
+	for ( int i = 0; !spun && (i < mSpinCount); ++i ) {
+		for ( int p = 0; p < pauses; ++p ) {
+			CKFWAtomicPause();
+		}
+		if ( pauses < MAX_PAUSES_PER_SPIN ) {
+			pauses <<= 1;
+		}
+		lError = pthread_mutex_trylock( &mMutex );
+		if ( lError == 0 ) {
+			spun = true;
+		} else if ( lError != EBUSY ) {
+			throw CKErrNoException( __FILE__, __LINE__, lError );
+		}
+	}
+
+	// ...and if we didn't get it, it's time to sleep on it
+	if ( !spun ) {
+		lError = pthread_mutex_lock( &mMutex );
+		if ( lError != 0 ) {
+			throw CKErrNoException( __FILE__, __LINE__, lError );
+		}
+	}
+
 	mLockingThread = pthread_self();
+	if ( stats != NULL ) {
+		stats->acquired(true, spun, nowNanos() - start);
+	}
 }
 
 void CKFWMutex::unlock()
 {
+	/*
+	 * The owner has to be cleared while we still hold it - once it's
+	 * unlocked, another thread can have it, or even have destroyed it.
+	 */
+	pthread_t	owner = mLockingThread;
+	mLockingThread = ( pthread_t )-1;
+
 	int lError = pthread_mutex_unlock( &mMutex );
 	if ( lError != 0 ) {
+		mLockingThread = owner;
 		throw CKErrNoException( __FILE__, __LINE__, lError );
 	}
+}
 
-	mLockingThread = ( pthread_t )-1;
+/**
+ * These set and get the number of times lock() will retry a busy
+ * mutex before it blocks. Zero means block right away. On a box with
+ * only one CPU there's no point in spinning, so it's always zero.
+ */
+void CKFWMutex::setSpinCount( int aCount )
+{
+	mSpinCount = ((aCount > 0) && canSpin() ? aCount : 0);
+}
+
+int CKFWMutex::getSpinCount() const
+{
+	return mSpinCount;
+}
+
+/**
+ * These set and get the spin count that all the mutexes created from
+ * now on will get.
+ */
+void CKFWMutex::setDefaultSpinCount( int aCount )
+{
+	sDefaultSpinCount = (aCount > 0 ? aCount : 0);
+}
+
+int CKFWMutex::getDefaultSpinCount()
+{
+	return (int)sDefaultSpinCount;
+}
+
+/**
+ * These turn the statistics on and off for this mutex. The name is
+ * what the mutex is called in CKFWMutexStats::dumpAll(). The stats
+ * are made the first time they're enabled - if two threads do that
+ * at once, only one of them gets installed - and they're kept until
+ * the mutex is destroyed, as a thread in lock() may still be using
+ * them. Disabling them just stops the counting.
+ */
+void CKFWMutex::enableStatistics( const char *aName )
+{
+	if ( mKeptStats == NULL ) {
+		CKFWMutexStats	*stats = new CKFWMutexStats(aName);
+		if ( !CKFWAtomicCompareAndSwap((void * volatile *)&mKeptStats, NULL, stats) ) {
+			delete stats;
+		}
+	}
+	mStats = mKeptStats;
+}
+
+void CKFWMutex::disableStatistics()
+{
+	mStats = NULL;
+}
+
+const CKFWMutexStats *CKFWMutex::getStatistics() const
+{
+	return mKeptStats;
 }
 // vim: set ts=2:
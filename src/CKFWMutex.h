@@ -2,6 +2,22 @@
  * CKFWMutex.h - this file defines the simple mutex that can be used in a
  *               large number of applications.
  *
+ *               Most of the critical sections in the library are only a
+ *               few dozen instructions long, so when the mutex is busy it's
+ *               often cheaper to spin for a moment than to have the kernel
+ *               put the thread to sleep. Each mutex can be given a spin
+ *               count - the number of times it will retry a busy lock,
+ *               backing off as it goes, before it parks on the pthread
+ *               mutex. The default for all new mutexes is set with the
+ *               CKFW_MUTEX_DEFAULT_SPIN_COUNT define at build time, or
+ *               with setDefaultSpinCount() at run time, and it's zero
+ *               - the plain pthread mutex - unless asked otherwise.
+ *
+ *               Each mutex can also be asked to keep statistics - the
+ *               number of times it was locked, how many of those found it
+ *               busy, and how long the callers waited for it - so we can
+ *               see which locks in the library are hot.
+ *
  * $Id: CKFWMutex.h,v 1.7 2004/09/20 16:19:30 drbob Exp $
  */
 #ifndef __CKFW_MUTEX_H
@@ -15,14 +31,106 @@
 //	Other Headers
 
 //	Forward Declarations
+class CKString;
 
 //	Public Constants
+/*
+ * This is the spin count given to all new mutexes unless it's changed
+ * with CKFWMutex::setDefaultSpinCount(). Zero means no spinning at all.
+ */
+#ifndef CKFW_MUTEX_DEFAULT_SPIN_COUNT
+#define	CKFW_MUTEX_DEFAULT_SPIN_COUNT		0
+#endif
 
 //	Public Datatypes
 
 //	Public Data Constants
 
 
+/*
+ * These are the statistics that a mutex keeps when asked. They are
+ * all updated atomically so they can be read at any time, and every
+ * instance is registered in a process-wide list so that dumpAll() can
+ * report on all the instrumented mutexes in the process.
+ */
+class CKFWMutexStats
+{
+	public:
+		/*
+		 * This is the constructor that takes the name the statistics are
+		 * reported under and registers this instance in the process-wide
+		 * list so that dumpAll() will include it.
+		 */
+		CKFWMutexStats( const char *aName );
+		/*
+		 * This is the standard destructor and needs to be virtual to make
+		 * sure that if we subclass off this the right destructor will be
+		 * called. It removes this instance from the process-wide list.
+		 */
+		virtual ~CKFWMutexStats();
+
+		/*
+		 * This is the name that this mutex is reported under.
+		 */
+		const char *getName() const;
+		/*
+		 * These are the number of times the mutex was locked, the number
+		 * of those times it was already locked by someone else, and the
+		 * number of those that got the lock while spinning - without
+		 * having to be put to sleep.
+		 */
+		unsigned long getAcquisitionCount() const;
+		unsigned long getContendedCount() const;
+		unsigned long getSpinAcquisitionCount() const;
+		/*
+		 * This is the total time, in nanoseconds, that the callers have
+		 * spent waiting on the contended locks.
+		 */
+		unsigned long long getTotalWaitNanos() const;
+
+		/*
+		 * The mutex calls this each time it's locked - with the time
+		 * spent waiting if it was busy.
+		 */
+		void acquired( bool aContended, bool aSpun, unsigned long long aWaitNanos );
+		/*
+		 * This method sets all the counts back to zero.
+		 */
+		void reset();
+
+		/*
+		 * Because there are times when it's useful to have a nice
+		 * human-readable form of the contents of this instance. Most of the
+		 * time this means that it's used for debugging, but it could be used
+		 * for just about anything. In these cases, it's nice not to have to
+		 * worry about the ownership of the representation, so this returns
+		 * a CKString.
+		 */
+		virtual CKString toString() const;
+		/*
+		 * This method returns the toString() of every registered instance,
+		 * one per line, in the order they were created.
+		 */
+		static CKString dumpAll();
+
+	private:
+		/*
+		 * We can't have these copied as they are registered by address.
+		 */
+		CKFWMutexStats();
+		CKFWMutexStats( const CKFWMutexStats & anOther );
+		CKFWMutexStats & operator=( const CKFWMutexStats & anOther );
+
+		// this is the name of the mutex in the reports
+		char							*mName;
+		// ...and these are the counts
+		volatile unsigned long			mAcquisitionCount;
+		volatile unsigned long			mContendedCount;
+		volatile unsigned long			mSpinAcquisitionCount;
+		volatile unsigned long long		mTotalWaitNanos;
+};
+
+
 /*
  * This is the main class definition.
  */
@@ -41,8 +149,8 @@ class CKFWMutex
 
 		/**
 		* Attempts to lock the mutex.  If the mutex is already locked, this thread
-		* will block until the mutex is available.  Throws a CKErrNoException if
-		* there is some problem
+		* will spin for a bit, and then block until the mutex is available.
+		* Throws a CKErrNoException if there is some problem
 		*/
 		void lock( );
 
@@ -54,6 +162,32 @@ class CKFWMutex
 
 		// void clear( );
 
+		/**
+		* These set and get the number of times lock() will retry a busy
+		* mutex before it blocks. Zero means block right away. On a box with
+		* only one CPU there's no point in spinning, so it's always zero.
+		*/
+		void setSpinCount( int aCount );
+		int getSpinCount( ) const;
+		/**
+		* These set and get the spin count that all the mutexes created from
+		* now on will get.
+		*/
+		static void setDefaultSpinCount( int aCount );
+		static int getDefaultSpinCount( );
+
+		/**
+		* These turn the statistics on and off for this mutex. The name is
+		* what the mutex is called in CKFWMutexStats::dumpAll(). The stats
+		* are owned by the mutex, and are NULL until they are first enabled.
+		* From then on they last as long as the mutex does - turning them
+		* off just stops the counting - so they can be turned on and off
+		* while other threads are locking it.
+		*/
+		void enableStatistics( const char *aName );
+		void disableStatistics( );
+		const CKFWMutexStats *getStatistics( ) const;
+
 	private :
 		friend class CKFWConditional;
 
@@ -61,6 +195,16 @@ class CKFWMutex
 
 		pthread_t mLockingThread;
 
+		int mSpinCount;
+
+		/**
+		* The stats are made just once, and kept in mKeptStats until the
+		* mutex is destroyed. mStats points to them while they're on, and
+		* lock() reads it just once, so it never sees them go away.
+		*/
+		CKFWMutexStats * volatile mStats;
+		CKFWMutexStats * volatile mKeptStats;
+
 		friend int CKFWMutexTest( char * argv[] = 0, int argc = 0 );
 };
 
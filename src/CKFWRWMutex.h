@@ -24,7 +24,9 @@
 
 
 /*
- * This is the main class definition.
+ * This is the main class definition. The locking methods are virtual so
+ * that CKFWShardedRWMutex can be used anywhere this one can - including
+ * with a CKStackLocker.
  */
 class CKFWRWMutex
 {
@@ -47,32 +49,32 @@ class CKFWRWMutex
 		 * locked with a write lock, this thread will block until the mutex is
 		 * available.  Throws a CKErrNoException if there is some problem.
 		 */
-		void readLock();
+		virtual void readLock();
 		/**
 		 * Attempts to lock the mutex with a read lock. Returns true if successful,
 		 * false if a write lock is already there. Throws a CKErrNoException if
 		 * there is some other problem. Does Not Block.
 		 */
-		bool tryReadLock();
+		virtual bool tryReadLock();
 
 		/**
 		 * Attempts to lock the mutex with a write lock. If the mutex is already
 		 * locked with a read or write lock, this thread will block until the mutex
 		 * is available.  Throws a CKErrNoException if there is some problem.
 		 */
-		void writeLock();
+		virtual void writeLock();
 		/**
 		 * Attempts to lock the mutex with a write lock. Returns true if successful,
 		 * false if a read or write lock is already there. Throws a CKErrNoException
 		 * if there is some other problem. Does Not Block.
 		 */
-		bool tryWriteLock();
+		virtual bool tryWriteLock();
 
 		/**
 		 * Attempts to unlock this mutex.  Throws a CKErrNoException if there is
 		 * some problem. See man pthread_mutex_unlock
 		 */
-		void unlock();
+		virtual void unlock();
 
 	private:
 		/*
@@ -0,0 +1,343 @@
+/*
+ * CKFWShardedRWMutex.cpp - this file implements a read/write mutex for data
+ *                          that is read far more often than it's written. The
+ *                          reader count is split into shards, each on its own
+ *                          cache line, so that the readers on different cores
+ *                          don't fight over the same line. A writer keeps new
+ *                          readers out and waits for all the shards to drain.
+ *
+ * $Id$
+ */
+
+//	System Headers
+#include <stdlib.h>
+#include <unistd.h>
+#include <sstream>
+
+//	Third-Party Headers
+
+//	Other Headers
+#include "CKFWShardedRWMutex.h"
+#include "CKFWAtomic.h"
+#include "CKException.h"
+
+//	Forward Declarations
+
+//	Private Constants
+/*
+ * This is the number of times a thread will look to see if the lock
+ * has become available before it parks on the conditional.
+ */
+#define	SPINS_BEFORE_PARKING		200
+
+//	Private Datatypes
+/*
+ * This is the test the readers use to wait for the writer to leave.
+ */
+class CKFWWriterPresentTest :
+	public ICKFWConditionalSpuriousTest
+{
+	public:
+		CKFWWriterPresentTest( volatile long *aWriter ) :
+			mWriter(aWriter)
+		{
+		}
+
+		virtual int test()
+		{
+			return (*mWriter != 0);
+		}
+
+	private:
+		volatile long	*mWriter;
+};
+
+
+/*
+ * This is the test the writer uses to wait for the readers to drain.
+ */
+class CKFWReadersPresentTest :
+	public ICKFWConditionalSpuriousTest
+{
+	public:
+		CKFWReadersPresentTest( const CKFWReaderShard *aShards, int aCount ) :
+			mShards(aShards),
+			mCount(aCount)
+		{
+		}
+
+		virtual int test()
+		{
+			for (int i = 0; i < mCount; ++i) {
+				if (mShards[i].readers != 0) {
+					return 1;
+				}
+			}
+			return 0;
+		}
+
+	private:
+		const CKFWReaderShard	*mShards;
+		int						mCount;
+};
+
+//	Private Data Constants
+/*
+ * Each thread is given a number the first time it takes a read lock,
+ * and it uses the shard for that number from then on - on every one of
+ * these mutexes. The number is kept in this thread-specific key.
+ */
+static pthread_key_t	sThreadNumberKey;
+static pthread_once_t	sThreadNumberOnce = PTHREAD_ONCE_INIT;
+static volatile long	sNextThreadNumber = 0;
+
+static void createThreadNumberKey()
+{
+	pthread_key_create(&sThreadNumberKey, NULL);
+}
+
+
+/*
+ * This is the default constructor that does all the work necessary
+ * to get this guy up to the point that he's ready to be used. The
+ * number of shards is rounded up to a power of two, and if it's
+ * zero or less, there's one shard for each on-line CPU.
+ */
+CKFWShardedRWMutex::CKFWShardedRWMutex( int aShardCount ) :
+	CKFWRWMutex(),
+	mShards(NULL),
+	mShardMask(0),
+	mWriter(0),
+	mWritingThread((pthread_t)-1),
+	mWriterMutex(),
+	mWaitMutex(),
+	mWaitConditional(mWaitMutex)
+{
+	// figure out how many shards we need - a power of two
+	int		want = aShardCount;
+	if (want <= 0) {
+		want = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	if (want > CKFW_SHARDED_RWMUTEX_MAX_SHARDS) {
+		want = CKFW_SHARDED_RWMUTEX_MAX_SHARDS;
+	}
+	int		cnt = 1;
+	while (cnt < want) {
+		cnt <<= 1;
+	}
+
+	// ...and get them on their own cache lines
+	void	*space = NULL;
+	if (posix_memalign(&space, CKFW_CACHE_LINE_SIZE, cnt * sizeof(CKFWReaderShard)) != 0) {
+		std::ostringstream	msg;
+		msg << "CKFWShardedRWMutex::CKFWShardedRWMutex(int) - the space for the " <<
+			cnt << " reader shards could not be created. This is a serious "
+			"allocation error.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+	mShards = (CKFWReaderShard *)space;
+	for (int i = 0; i < cnt; ++i) {
+		mShards[i].readers = 0;
+	}
+	mShardMask = cnt - 1;
+}
+
+
+/*
+ * This is the standard destructor and needs to be virtual to make
+ * sure that if we subclass off this the right destructor will be
+ * called.
+ */
+CKFWShardedRWMutex::~CKFWShardedRWMutex()
+{
+	if (mShards != NULL) {
+		free(mShards);
+		mShards = NULL;
+	}
+}
+
+
+/**
+ * Attempts to lock the mutex with a read lock. If the mutex is already
+ * locked with a write lock - or a writer is waiting for it - this
+ * thread will block until the mutex is available.
+ */
+void CKFWShardedRWMutex::readLock()
+{
+	CKFWReaderShard		*shard = myShard();
+	int					spins = 0;
+	while (true) {
+		if (mWriter == 0) {
+			/*
+			 * Say we're here, and then make sure a writer didn't sneak in
+			 * before we did - the atomic add is a full barrier, so if the
+			 * writer's flag isn't set now, it'll see our count.
+			 */
+			CKFWAtomicAdd(&shard->readers, 1);
+			if (mWriter == 0) {
+				break;
+			}
+			// back out and let the writer know he might be clear
+			CKFWAtomicAdd(&shard->readers, -1);
+			wakeAll();
+		}
+
+		// wait for the writer to go - spinning first, then parking
+		if (spins < SPINS_BEFORE_PARKING) {
+			CKFWAtomicPause();
+			++spins;
+		} else {
+			CKFWWriterPresentTest	tst(&mWriter);
+			if (mWaitConditional.lockAndTest(tst) == FWCOND_LOCK_SUCCESS) {
+				mWaitMutex.unlock();
+			}
+		}
+	}
+}
+
+
+/**
+ * Attempts to lock the mutex with a read lock. Returns true if successful,
+ * false if a write lock is already there, or a writer is waiting. Does
+ * Not Block.
+ */
+bool CKFWShardedRWMutex::tryReadLock()
+{
+	bool		retval = false;
+	if (mWriter == 0) {
+		CKFWReaderShard		*shard = myShard();
+		CKFWAtomicAdd(&shard->readers, 1);
+		if (mWriter == 0) {
+			retval = true;
+		} else {
+			CKFWAtomicAdd(&shard->readers, -1);
+			wakeAll();
+		}
+	}
+	return retval;
+}
+
+
+/**
+ * Attempts to lock the mutex with a write lock. If the mutex is already
+ * locked with a read or write lock, this thread will block until the mutex
+ * is available. New readers are held off while we wait.
+ */
+void CKFWShardedRWMutex::writeLock()
+{
+	// get in line with the other writers
+	mWriterMutex.lock();
+	// ...keep the new readers out
+	CKFWAtomicAdd(&mWriter, 1);
+	// ...and wait for the current readers to leave
+	int		spins = 0;
+	while (hasReaders()) {
+		if (spins < SPINS_BEFORE_PARKING) {
+			CKFWAtomicPause();
+			++spins;
+		} else {
+			CKFWReadersPresentTest	tst(mShards, mShardMask + 1);
+			if (mWaitConditional.lockAndTest(tst) == FWCOND_LOCK_SUCCESS) {
+				mWaitMutex.unlock();
+			}
+		}
+	}
+	mWritingThread = pthread_self();
+}
+
+
+/**
+ * Attempts to lock the mutex with a write lock. Returns true if successful,
+ * false if a read or write lock is already there. Does Not Block.
+ */
+bool CKFWShardedRWMutex::tryWriteLock()
+{
+	bool		retval = false;
+	if (mWriterMutex.tryLock()) {
+		CKFWAtomicAdd(&mWriter, 1);
+		if (!hasReaders()) {
+			mWritingThread = pthread_self();
+			retval = true;
+		} else {
+			// there are readers, so back out and let anyone we held off go
+			CKFWAtomicAdd(&mWriter, -1);
+			mWriterMutex.unlock();
+			wakeAll();
+		}
+	}
+	return retval;
+}
+
+
+/**
+ * Unlocks the mutex - the write lock if the calling thread holds it,
+ * and otherwise the calling thread's read lock.
+ */
+void CKFWShardedRWMutex::unlock()
+{
+	if ((mWriter != 0) && pthread_equal(mWritingThread, pthread_self())) {
+		mWritingThread = (pthread_t)-1;
+		CKFWAtomicAdd(&mWriter, -1);
+		mWriterMutex.unlock();
+		// let the readers that were held off go
+		wakeAll();
+	} else {
+		CKFWAtomicAdd(&myShard()->readers, -1);
+		// if a writer is waiting, we may be the last reader he's waiting on
+		if (mWriter != 0) {
+			wakeAll();
+		}
+	}
+}
+
+
+/*
+ * This returns the number of shards the reader count is split into.
+ */
+int CKFWShardedRWMutex::getShardCount() const
+{
+	return mShardMask + 1;
+}
+
+
+/*
+ * This returns the shard of the reader count that the calling
+ * thread uses - it's the same every time for a given thread.
+ */
+CKFWReaderShard *CKFWShardedRWMutex::myShard()
+{
+	pthread_once(&sThreadNumberOnce, createThreadNumberKey);
+	long	num = (long)pthread_getspecific(sThreadNumberKey);
+	if (num == 0) {
+		// the key holds the number plus one so we can tell it's unset
+		num = CKFWAtomicAdd(&sNextThreadNumber, 1);
+		pthread_setspecific(sThreadNumberKey, (void *)num);
+	}
+	return &mShards[(num - 1) & mShardMask];
+}
+
+
+/*
+ * This returns true if any of the shards has a reader in it.
+ */
+bool CKFWShardedRWMutex::hasReaders() const
+{
+	for (int i = 0; i <= mShardMask; ++i) {
+		if (mShards[i].readers != 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
+/*
+ * This wakes up everyone parked on the mutex - the readers waiting
+ * for the writer to leave and the writer waiting for the readers.
+ */
+void CKFWShardedRWMutex::wakeAll()
+{
+	mWaitMutex.lock();
+	mWaitConditional.wakeWaiters();
+	mWaitMutex.unlock();
+}
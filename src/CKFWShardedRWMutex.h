@@ -0,0 +1,164 @@
+/*
+ * CKFWShardedRWMutex.h - this file defines a read/write mutex for data that
+ *                        is read far more often than it's written - like the
+ *                        reference data trees that are read millions of times
+ *                        a second and rewritten once an hour. The trouble with
+ *                        the pthread read/write lock is that every reader has
+ *                        to update the same reader count, and that one cache
+ *                        line bounces between all the cores doing the reading.
+ *
+ *                        Here, the reader count is split into shards, each on
+ *                        its own cache line, and each thread always uses the
+ *                        same shard. So readers on different cores never touch
+ *                        the same line unless a writer shows up. A writer sets
+ *                        a flag that keeps new readers out - so the writers
+ *                        can't be starved - and then waits for all the shards
+ *                        to drain. The writers are serialized on a mutex.
+ *
+ *                        The price is that a write lock has to look at every
+ *                        shard, and each instance uses a cache line for each
+ *                        shard, so this is only worth it for the read-mostly
+ *                        data. It has the same interface as CKFWRWMutex and
+ *                        can be used anywhere that one can.
+ *
+ * $Id$
+ */
+#ifndef __CKFW_SHARDED_RW_MUTEX_H
+#define __CKFW_SHARDED_RW_MUTEX_H
+
+//	System Headers
+#include <pthread.h>
+
+//	Third-Party Headers
+
+//	Other Headers
+#include "CKFWRWMutex.h"
+#include "CKFWMutex.h"
+#include "CKFWConditional.h"
+
+//	Forward Declarations
+
+//	Public Constants
+/*
+ * This is the size of a cache line - each shard of the reader count is
+ * padded out to this so no two shards share a line.
+ */
+#define	CKFW_CACHE_LINE_SIZE			64
+/*
+ * This is the most shards a mutex will have, no matter how many CPUs
+ * the box has.
+ */
+#define	CKFW_SHARDED_RWMUTEX_MAX_SHARDS	64
+
+//	Public Datatypes
+/*
+ * This is one shard of the reader count on its own cache line.
+ */
+typedef struct {
+	volatile long	readers;
+	char			pad[CKFW_CACHE_LINE_SIZE - sizeof(long)];
+} CKFWReaderShard;
+
+//	Public Data Constants
+
+
+/*
+ * This is the main class definition.
+ */
+class CKFWShardedRWMutex :
+	public CKFWRWMutex
+{
+	public:
+		/*
+		 * This is the default constructor that does all the work necessary
+		 * to get this guy up to the point that he's ready to be used. The
+		 * number of shards is rounded up to a power of two, and if it's
+		 * zero or less, there's one shard for each on-line CPU.
+		 */
+		CKFWShardedRWMutex( int aShardCount = 0 );
+
+		/*
+		 * This is the standard destructor and needs to be virtual to make
+		 * sure that if we subclass off this the right destructor will be
+		 * called.
+		 */
+		virtual ~CKFWShardedRWMutex();
+
+		/**
+		 * Attempts to lock the mutex with a read lock. If the mutex is already
+		 * locked with a write lock - or a writer is waiting for it - this
+		 * thread will block until the mutex is available.
+		 */
+		virtual void readLock();
+		/**
+		 * Attempts to lock the mutex with a read lock. Returns true if successful,
+		 * false if a write lock is already there, or a writer is waiting. Does
+		 * Not Block.
+		 */
+		virtual bool tryReadLock();
+
+		/**
+		 * Attempts to lock the mutex with a write lock. If the mutex is already
+		 * locked with a read or write lock, this thread will block until the mutex
+		 * is available. New readers are held off while we wait.
+		 */
+		virtual void writeLock();
+		/**
+		 * Attempts to lock the mutex with a write lock. Returns true if successful,
+		 * false if a read or write lock is already there. Does Not Block.
+		 */
+		virtual bool tryWriteLock();
+
+		/**
+		 * Unlocks the mutex - the write lock if the calling thread holds it,
+		 * and otherwise the calling thread's read lock.
+		 */
+		virtual void unlock();
+
+		/*
+		 * This returns the number of shards the reader count is split into.
+		 */
+		int getShardCount() const;
+
+	protected:
+		/*
+		 * This returns the shard of the reader count that the calling
+		 * thread uses - it's the same every time for a given thread.
+		 */
+		CKFWReaderShard *myShard();
+		/*
+		 * This returns true if any of the shards has a reader in it.
+		 */
+		bool hasReaders() const;
+		/*
+		 * This wakes up everyone parked on the mutex - the readers waiting
+		 * for the writer to leave and the writer waiting for the readers.
+		 */
+		void wakeAll();
+
+	private:
+		CKFWShardedRWMutex( const CKFWShardedRWMutex & anOther );
+		CKFWShardedRWMutex & operator=( const CKFWShardedRWMutex & anOther );
+
+		/*
+		 * These are the cache-line aligned shards of the reader count and
+		 * the mask to turn a thread's number into a shard.
+		 */
+		CKFWReaderShard			*mShards;
+		int						mShardMask;
+		/*
+		 * This is non-zero when a writer has the lock or is waiting on
+		 * the readers, and this is the writer that has it.
+		 */
+		volatile long			mWriter;
+		pthread_t				mWritingThread;
+		/*
+		 * The writers are serialized on this mutex, and everyone that has
+		 * to wait parks on this conditional.
+		 */
+		CKFWMutex				mWriterMutex;
+		CKFWMutex				mWaitMutex;
+		CKFWConditional			mWaitConditional;
+};
+
+#endif	// __CKFW_SHARDED_RW_MUTEX_H
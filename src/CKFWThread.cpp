@@ -7,9 +7,13 @@
 
 //	System Headers
 #include <pthread.h>
+#include <sched.h>
 #include <math.h>
+#include <stdio.h>
 #include <iostream>
 #include <sstream>
+#include <list>
+#include <sys/time.h>
 #ifdef GPP2
 #include <exception>
 #endif
@@ -20,6 +24,7 @@
 //	Other Headers
 #include "CKFWThread.h"
 #include "CKErrNoException.h"
+#include "CKInstanceRegistry.h"
 
 //	Forward Declarations
 
@@ -28,6 +33,17 @@
 //	Private Datatypes
 
 //	Private Data Constants
+/*
+ * This is the number of bits in each word of the affinity mask.
+ */
+#define	BITS_PER_WORD		(8*sizeof(unsigned long))
+
+/*
+ * A thread is in the process-wide registry only while it's in run(),
+ * so the list is just the running threads - not every one constructed.
+ */
+typedef CKInstanceRegistry<CKFWThread>	CKFWThreadRegistry;
+
 const int CKFWThread::cDefaultPolicy = SCHED_OTHER;
 const double CKFWThread::cDefaultPriority =  0.5;
 const int CKFWThread::cDefaultScope = PTHREAD_SCOPE_SYSTEM;
@@ -46,13 +62,28 @@ CKFWThread::CKFWThread( int aPolicy,
 	mPriority( aPriority ),
 	mScope( aScope ),
 	mIsDetachable( aIsDetachable ),
-	mTag( NULL )
+	mTag( NULL ),
+	mNUMANode( -1 ),
+	mIterations( 0 ),
+	mProcessNanos( 0 ),
+	mStartNanos( 0 ),
+	mStopNanos( 0 ),
+	mCPUBaseNanos( 0 ),
+	mCPUStopNanos( 0 ),
+	mCPUClock( 0 ),
+	mIsRunning( 0 )
 {
+	clearAffinity();
+	for (int i = 0; i < CKFW_THREAD_HISTOGRAM_BUCKETS; ++i) {
+		mProcessCounts[i] = 0;
+	}
 	return;
 }
 
 CKFWThread::~CKFWThread( )
 {
+	// a thread that deletes itself while running is still in the list
+	unregisterLive();
 	setTag(NULL);
   return;
 }
@@ -66,6 +97,10 @@ CKFWThread & CKFWThread::operator=( CKFWThread & anOther )
 		mScope = anOther.mScope;
 		mIsDetachable = anOther.mIsDetachable;
 		setTag(anOther.mTag);
+		for (unsigned int i = 0; i < CKFW_THREAD_MAX_CPUS/BITS_PER_WORD; ++i) {
+			mAffinity[i] = anOther.mAffinity[i];
+		}
+		mNUMANode = anOther.mNUMANode;
 	}
 	return *this;
 }
@@ -73,7 +108,9 @@ CKFWThread & CKFWThread::operator=( CKFWThread & anOther )
 /*
  * This is used to 'tag' the thread so that the exception reports tell
  * us something more than nothing. It's about the only information we're
- * going to get in some cases.
+ * going to get in some cases. On Linux, the tag is also used as the
+ * name of the thread (the first 15 characters) that shows up in top,
+ * ps and gdb, so it's best set before start().
  */
 void CKFWThread::setTag( const char *aTag )
 {
@@ -97,10 +134,172 @@ void CKFWThread::setTag( const char *aTag )
 }
 
 
+const char *CKFWThread::getTag( ) const
+{
+	return mTag;
+}
+
+
+
+/*
+ * These methods control which CPUs the thread is allowed to run on.
+ * They need to be called before start() - the affinity is placed on
+ * the thread as it's created so it never runs anywhere else. If no
+ * CPUs are added, the thread can run on any of them, as usual. On
+ * platforms without thread affinity, these are quietly ignored.
+ */
+void CKFWThread::addToAffinity( int aCPU )
+{
+	// first, make sure it's a CPU we can hold
+	if ((aCPU < 0) || (aCPU >= CKFW_THREAD_MAX_CPUS)) {
+		std::ostringstream	msg;
+		msg << "CKFWThread::addToAffinity(int) - the CPU " << aCPU << " is not "
+			"in the range 0 to " << (CKFW_THREAD_MAX_CPUS - 1) << ". Please "
+			"make sure that the CPU number is valid before calling.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	mAffinity[aCPU/BITS_PER_WORD] |= (1UL << (aCPU % BITS_PER_WORD));
+}
+
+
+void CKFWThread::setAffinity( int aCPU )
+{
+	clearAffinity();
+	addToAffinity(aCPU);
+}
+
+
+void CKFWThread::clearAffinity( )
+{
+	for (unsigned int i = 0; i < CKFW_THREAD_MAX_CPUS/BITS_PER_WORD; ++i) {
+		mAffinity[i] = 0;
+	}
+	mNUMANode = -1;
+}
+
+
+bool CKFWThread::hasAffinity( ) const
+{
+	bool		retval = false;
+	for (unsigned int i = 0; !retval && (i < CKFW_THREAD_MAX_CPUS/BITS_PER_WORD); ++i) {
+		retval = (mAffinity[i] != 0);
+	}
+	return retval;
+}
+
+
+bool CKFWThread::isInAffinity( int aCPU ) const
+{
+	bool		retval = false;
+	if ((aCPU >= 0) && (aCPU < CKFW_THREAD_MAX_CPUS)) {
+		retval = ((mAffinity[aCPU/BITS_PER_WORD] & (1UL << (aCPU % BITS_PER_WORD))) != 0);
+	}
+	return retval;
+}
+
+
+/*
+ * This method places the thread on the given NUMA node by setting
+ * its affinity to all the CPUs on that node, so the memory it
+ * first touches comes from that node as well. It throws a
+ * CKException if the node doesn't exist on this box. A node of
+ * -1 clears the affinity.
+ */
+void CKFWThread::setNUMANode( int aNode )
+{
+	clearAffinity();
+	if (aNode < 0) {
+		return;
+	}
+
+#ifdef __linux__
+	/*
+	 * The kernel lists the CPUs of each node as ranges, like "0-7,16-23",
+	 * so we don't need libnuma just to find them.
+	 */
+	char	path[128];
+	snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", aNode);
+	FILE	*fp = fopen(path, "r");
+	if (fp == NULL) {
+		std::ostringstream	msg;
+		msg << "CKFWThread::setNUMANode(int) - the NUMA node " << aNode <<
+			" doesn't appear to exist on this box as we couldn't read '" <<
+			path << "'. Please check the node number.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+	int		first = 0;
+	while (fscanf(fp, "%d", &first) == 1) {
+		int		last = first;
+		int		c = fgetc(fp);
+		if (c == '-') {
+			if (fscanf(fp, "%d", &last) != 1) {
+				break;
+			}
+			c = fgetc(fp);
+		}
+		for (int cpu = first; (cpu <= last) && (cpu < CKFW_THREAD_MAX_CPUS); ++cpu) {
+			addToAffinity(cpu);
+		}
+		if (c != ',') {
+			break;
+		}
+	}
+	fclose(fp);
+#endif
+
+	mNUMANode = aNode;
+}
+
+
+int CKFWThread::getNUMANode( ) const
+{
+	return mNUMANode;
+}
+
+
+/*
+ * This is a simple helper for the common case of spreading a set
+ * of threads over a set of cores - thread 'i' is pinned to the
+ * CPU 'aCPUs[i % aCPUCount]'. Like the others, it needs to be
+ * called before the threads are started.
+ */
+void CKFWThread::pinRoundRobin( CKFWThread *aThreads[], int aThreadCount,
+								const int aCPUs[], int aCPUCount )
+{
+	// first, make sure we have something to do
+	if ((aThreads == NULL) || (aCPUs == NULL) || (aCPUCount <= 0)) {
+		std::ostringstream	msg;
+		msg << "CKFWThread::pinRoundRobin(CKFWThread *[], int, const int [], int) "
+			"- the threads and CPUs need to be non-NULL and there has to be at "
+			"least one CPU to pin the threads to.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	for (int i = 0; i < aThreadCount; ++i) {
+		if (aThreads[i] != NULL) {
+			aThreads[i]->setAffinity(aCPUs[i % aCPUCount]);
+		}
+	}
+}
+
+
 void CKFWThread::run( )
 {
 	bool		error = false;
 
+	// start the clocks and get on the list of running threads
+#ifdef CLOCK_THREAD_CPUTIME_ID
+	if (pthread_getcpuclockid(pthread_self(), &mCPUClock) != 0) {
+		mCPUClock = CLOCK_THREAD_CPUTIME_ID;
+	}
+#endif
+	mIsRunning = 1;
+	mCPUBaseNanos = cpuNanos();
+	mStartNanos = nowNanos();
+	mStopNanos = 0;
+	registerLive();
+
 	try {
 		if ( initialize( ) != cSuccess ) {
 			error = true;
@@ -138,7 +337,13 @@ void CKFWThread::run( )
 
 	try {
 		if ( !error ) {
-			while( process( ) == cSuccess );
+			unsigned long long	lStart = 0;
+			int					lCode = cSuccess;
+			while (lCode == cSuccess) {
+				lStart = nowNanos();
+				lCode = process( );
+				recordProcess(nowNanos() - lStart);
+			}
 		}
 	} catch ( CKException & lException ) {
 		error = true;
@@ -171,6 +376,15 @@ void CKFWThread::run( )
 			"running the thread an unknown exception was thrown." << std::endl;
 	}
 
+	/*
+	 * Stop the clocks and get off the list before terminate() as a lot
+	 * of threads delete themselves in there.
+	 */
+	mCPUStopNanos = cpuNanos();
+	mStopNanos = nowNanos();
+	mIsRunning = 0;
+	unregisterLive();
+
 	try {
 		terminate( );
 	} catch ( CKException & lException ) {
@@ -205,6 +419,235 @@ void CKFWThread::run( )
 	}
 }
 
+/*
+ * These are the metrics the thread keeps on its run loop - the
+ * number of times process() has been called, the histogram of how
+ * long those calls took, and the total wall time spent in them.
+ * The CPU time is what the kernel has charged to the thread, and
+ * the elapsed time is the wall time since the thread started (up
+ * to when it stopped, if it has). The busy ratio is the CPU time
+ * over the elapsed time, so a thread near 1.0 is saturated and one
+ * near 0.0 is mostly idle - blocked on a socket or a queue. All
+ * the times are in seconds, and they can be read from any thread.
+ */
+unsigned long CKFWThread::getIterationCount( ) const
+{
+	return mIterations;
+}
+
+
+unsigned long CKFWThread::getProcessCount( int aBucket ) const
+{
+	unsigned long	retval = 0;
+	if ((aBucket >= 0) && (aBucket < CKFW_THREAD_HISTOGRAM_BUCKETS)) {
+		retval = mProcessCounts[aBucket];
+	}
+	return retval;
+}
+
+
+double CKFWThread::getProcessTime( ) const
+{
+	return mProcessNanos/1.0e9;
+}
+
+
+double CKFWThread::getCPUTime( ) const
+{
+	double		retval = 0.0;
+	if (mStartNanos != 0) {
+		unsigned long long	now = cpuNanos();
+		if (now > mCPUBaseNanos) {
+			retval = (now - mCPUBaseNanos)/1.0e9;
+		}
+	}
+	return retval;
+}
+
+
+double CKFWThread::getElapsedTime( ) const
+{
+	double		retval = 0.0;
+	if (mStartNanos != 0) {
+		unsigned long long	end = (mIsRunning ? nowNanos() : mStopNanos);
+		if (end > mStartNanos) {
+			retval = (end - mStartNanos)/1.0e9;
+		}
+	}
+	return retval;
+}
+
+
+double CKFWThread::getBusyRatio( ) const
+{
+	double		retval = 0.0;
+	double		elapsed = getElapsedTime();
+	if (elapsed > 0.0) {
+		retval = getCPUTime()/elapsed;
+		// the two clocks aren't read at the same instant
+		if (retval > 1.0) {
+			retval = 1.0;
+		}
+	}
+	return retval;
+}
+
+
+/*
+ * This method sets the run loop metrics back to zero - the CPU
+ * and elapsed times start counting again from now.
+ */
+void CKFWThread::resetMetrics( )
+{
+	mIterations = 0;
+	for (int i = 0; i < CKFW_THREAD_HISTOGRAM_BUCKETS; ++i) {
+		mProcessCounts[i] = 0;
+	}
+	mProcessNanos = 0;
+	if (mIsRunning) {
+		mCPUBaseNanos = cpuNanos();
+		mStartNanos = nowNanos();
+	} else if (mStartNanos != 0) {
+		// it's stopped, so there's nothing more to count
+		mCPUBaseNanos = mCPUStopNanos;
+		mStartNanos = mStopNanos;
+	}
+}
+
+
+/*
+ * This returns a one-line, human-readable summary of the metrics
+ * for this thread, starting with its tag.
+ */
+CKString CKFWThread::getMetricsString( ) const
+{
+	std::ostringstream	buff;
+
+	buff << (mTag == NULL ? "(untagged)" : mTag) << ": " <<
+		(mIsRunning ? "running" : "stopped") << " iterations=" << mIterations <<
+		" busy=" << getBusyRatio() << " cpu(sec)=" << getCPUTime() <<
+		" elapsed(sec)=" << getElapsedTime() << " process(sec)=" <<
+		getProcessTime() << " process(usec)=[";
+	// only show the buckets that have something in them
+	bool	first = true;
+	for (int i = 0; i < CKFW_THREAD_HISTOGRAM_BUCKETS; ++i) {
+		if (mProcessCounts[i] > 0) {
+			if (!first) {
+				buff << " ";
+			}
+			if (i < CKFW_THREAD_HISTOGRAM_BUCKETS - 1) {
+				buff << "<" << (1UL << i) << ":" << mProcessCounts[i];
+			} else {
+				buff << ">=" << (1UL << (i - 1)) << ":" << mProcessCounts[i];
+			}
+			first = false;
+		}
+	}
+	buff << "]";
+
+	return CKString(buff.str());
+}
+
+
+/*
+ * Every thread is in a process-wide list while it's running. These
+ * return the number of them, their tags, and the metrics string of
+ * each, one per line - so we can see which of the listeners and
+ * loaders is the one that's saturated.
+ */
+int CKFWThread::getLiveThreadCount( )
+{
+	return CKFWThreadRegistry::size();
+}
+
+
+CKStringList CKFWThread::getLiveThreadTags( )
+{
+	CKStringList	retval;
+
+	CKFWThreadRegistry::lock();
+	std::list<CKFWThread *>::const_iterator		i;
+	for (i = CKFWThreadRegistry::getInstances().begin();
+		 i != CKFWThreadRegistry::getInstances().end(); ++i) {
+		retval.addToEnd(CKString((*i)->mTag == NULL ? "" : (*i)->mTag));
+	}
+	CKFWThreadRegistry::unlock();
+
+	return retval;
+}
+
+
+CKString CKFWThread::dumpAll( )
+{
+	return CKFWThreadRegistry::dump(&CKFWThread::getMetricsString);
+}
+
+
+/*
+ * These add and remove this thread from the list of running
+ * threads, and record the time spent in one call to process().
+ */
+void CKFWThread::registerLive( )
+{
+	CKFWThreadRegistry::add(this);
+}
+
+
+void CKFWThread::unregisterLive( )
+{
+	CKFWThreadRegistry::remove(this);
+}
+
+
+void CKFWThread::recordProcess( unsigned long long aNanos )
+{
+	/*
+	 * Only this thread ever records, so there's no need for the atomic
+	 * adds - a reset from another thread might just lose a count.
+	 */
+	unsigned long	usec = (unsigned long)(aNanos/1000);
+	int				bucket = 0;
+	while ((bucket < CKFW_THREAD_HISTOGRAM_BUCKETS - 1) &&
+		   ((usec >> bucket) > 0)) {
+		++bucket;
+	}
+	++mProcessCounts[bucket];
+	++mIterations;
+	mProcessNanos += aNanos;
+}
+
+
+// this reads the thread's CPU clock, or what it was when it stopped
+unsigned long long CKFWThread::cpuNanos( ) const
+{
+	unsigned long long	retval = mCPUStopNanos;
+#ifdef CLOCK_THREAD_CPUTIME_ID
+	if (mIsRunning) {
+		timespec	ts;
+		if (clock_gettime(mCPUClock, &ts) == 0) {
+			retval = (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+		}
+	}
+#endif
+	return retval;
+}
+
+
+// ...and this is the wall clock for all the metrics
+unsigned long long CKFWThread::nowNanos( )
+{
+#ifdef CLOCK_MONOTONIC
+	timespec	ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#else
+	timeval		tv;
+	gettimeofday(&tv, NULL);
+	return (unsigned long long)tv.tv_sec * 1000000000ULL + tv.tv_usec * 1000ULL;
+#endif
+}
+
+
 int CKFWThread::process( )
 {
   return 0;
@@ -262,6 +705,24 @@ int CKFWThread::start( )
     throw CKErrNoException( __FILE__, __LINE__, lError );
   }
 
+#ifdef __linux__
+	// pin the thread as it's created so it never runs anywhere else
+	if (hasAffinity()) {
+		cpu_set_t	lCPUs;
+		CPU_ZERO(&lCPUs);
+		for (int cpu = 0; (cpu < CKFW_THREAD_MAX_CPUS) && (cpu < CPU_SETSIZE); ++cpu) {
+			if (isInAffinity(cpu)) {
+				CPU_SET(cpu, &lCPUs);
+			}
+		}
+		if ((lError = pthread_attr_setaffinity_np(&lThreadAttribute,
+						sizeof(lCPUs), &lCPUs)) != 0) {
+			pthread_attr_destroy( &lThreadAttribute );
+			throw CKErrNoException( __FILE__, __LINE__, lError );
+		}
+	}
+#endif
+
   if ( (lError = pthread_create( &mThread,
                                  &lThreadAttribute,
                                  CKFWThread::threadFunction,
@@ -287,6 +748,15 @@ int CKFWThread::terminate( void )
 void *CKFWThread::threadFunction( void * aThread )
 {
   CKFWThread * lThread = (CKFWThread *)aThread;
+#ifdef __linux__
+	// name the thread after its tag - the kernel only keeps 15 chars
+	if (lThread->mTag != NULL) {
+		char	lName[16];
+		strncpy(lName, lThread->mTag, sizeof(lName) - 1);
+		lName[sizeof(lName) - 1] = '\0';
+		pthread_setname_np(pthread_self(), lName);
+	}
+#endif
   lThread->run( );
 
   return lThread;
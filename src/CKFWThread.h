@@ -9,14 +9,28 @@
 
 //	System Headers
 #include <pthread.h>
+#include <time.h>
 
 //	Third-Party Headers
 
 //	Other Headers
+#include "CKString.h"
 
 //	Forward Declarations
 
 //	Public Constants
+/*
+ * This is the most CPUs that a thread's affinity can name - it's the
+ * same as the Linux CPU_SETSIZE, and that's plenty for any box we have.
+ */
+#define	CKFW_THREAD_MAX_CPUS		1024
+/*
+ * The process() time histogram has power-of-two buckets in microseconds,
+ * just like the CKQueueStats - bucket 'i' counts the calls that took less
+ * than 2^i usec (and at least 2^(i-1) usec), and the last bucket is
+ * everything longer than that.
+ */
+#define	CKFW_THREAD_HISTOGRAM_BUCKETS		24
 
 //	Public Datatypes
 
@@ -60,9 +74,41 @@ class CKFWThread
 		/*
 		 * This is used to 'tag' the thread so that the exception reports tell
 		 * us something more than nothing. It's about the only information we're
-		 * going to get in some cases.
+		 * going to get in some cases. On Linux, the tag is also used as the
+		 * name of the thread (the first 15 characters) that shows up in top,
+		 * ps and gdb, so it's best set before start().
 		 */
 		void setTag( const char *aTag );
+		const char *getTag( ) const;
+		/*
+		 * These methods control which CPUs the thread is allowed to run on.
+		 * They need to be called before start() - the affinity is placed on
+		 * the thread as it's created so it never runs anywhere else. If no
+		 * CPUs are added, the thread can run on any of them, as usual. On
+		 * platforms without thread affinity, these are quietly ignored.
+		 */
+		void addToAffinity( int aCPU );
+		void setAffinity( int aCPU );
+		void clearAffinity( );
+		bool hasAffinity( ) const;
+		bool isInAffinity( int aCPU ) const;
+		/*
+		 * This method places the thread on the given NUMA node by setting
+		 * its affinity to all the CPUs on that node, so the memory it
+		 * first touches comes from that node as well. It throws a
+		 * CKException if the node doesn't exist on this box. A node of
+		 * -1 clears the affinity.
+		 */
+		void setNUMANode( int aNode );
+		int getNUMANode( ) const;
+		/*
+		 * This is a simple helper for the common case of spreading a set
+		 * of threads over a set of cores - thread 'i' is pinned to the
+		 * CPU 'aCPUs[i % aCPUCount]'. Like the others, it needs to be
+		 * called before the threads are started.
+		 */
+		static void pinRoundRobin( CKFWThread *aThreads[], int aThreadCount,
+								   const int aCPUs[], int aCPUCount );
 		/*
 		 *
 		 */
@@ -76,6 +122,43 @@ class CKFWThread
 		 */
 		void join( );
 
+		/*
+		 * These are the metrics the thread keeps on its run loop - the
+		 * number of times process() has been called, the histogram of how
+		 * long those calls took, and the total wall time spent in them.
+		 * The CPU time is what the kernel has charged to the thread, and
+		 * the elapsed time is the wall time since the thread started (up
+		 * to when it stopped, if it has). The busy ratio is the CPU time
+		 * over the elapsed time, so a thread near 1.0 is saturated and one
+		 * near 0.0 is mostly idle - blocked on a socket or a queue. All
+		 * the times are in seconds, and they can be read from any thread.
+		 */
+		unsigned long getIterationCount( ) const;
+		unsigned long getProcessCount( int aBucket ) const;
+		double getProcessTime( ) const;
+		double getCPUTime( ) const;
+		double getElapsedTime( ) const;
+		double getBusyRatio( ) const;
+		/*
+		 * This method sets the run loop metrics back to zero - the CPU
+		 * and elapsed times start counting again from now.
+		 */
+		void resetMetrics( );
+		/*
+		 * This returns a one-line, human-readable summary of the metrics
+		 * for this thread, starting with its tag.
+		 */
+		CKString getMetricsString( ) const;
+		/*
+		 * Every thread is in a process-wide list while it's running. These
+		 * return the number of them, their tags, and the metrics string of
+		 * each, one per line - so we can see which of the listeners and
+		 * loaders is the one that's saturated.
+		 */
+		static int getLiveThreadCount( );
+		static CKStringList getLiveThreadTags( );
+		static CKString dumpAll( );
+
 	protected:
 		/*
 		 *
@@ -100,6 +183,39 @@ class CKFWThread
 		pthread_t	mThread;
 		int				mIsDetachable;
 		char			*mTag;
+		/*
+		 * These are the CPUs the thread can run on, as a bitmask, and the
+		 * NUMA node they came from, if that's how they were set.
+		 */
+		unsigned long	mAffinity[CKFW_THREAD_MAX_CPUS/(8*sizeof(unsigned long))];
+		int				mNUMANode;
+		/*
+		 * These are the run loop metrics. The CPU clock is the thread's
+		 * own CPU-time clock while it's running, and the CPU time it had
+		 * at the last reset and when it stopped are kept so that the CPU
+		 * time can still be given after the thread is gone.
+		 */
+		volatile unsigned long			mIterations;
+		volatile unsigned long			mProcessCounts[CKFW_THREAD_HISTOGRAM_BUCKETS];
+		volatile unsigned long long		mProcessNanos;
+		volatile unsigned long long		mStartNanos;
+		volatile unsigned long long		mStopNanos;
+		volatile unsigned long long		mCPUBaseNanos;
+		volatile unsigned long long		mCPUStopNanos;
+		clockid_t						mCPUClock;
+		volatile int					mIsRunning;
+
+		/*
+		 * These add and remove this thread from the list of running
+		 * threads, and record the time spent in one call to process().
+		 */
+		void registerLive( );
+		void unregisterLive( );
+		void recordProcess( unsigned long long aNanos );
+		// this reads the thread's CPU clock, or what it was when it stopped
+		unsigned long long cpuNanos( ) const;
+		// ...and this is the wall clock for all the metrics
+		static unsigned long long nowNanos( );
 
   friend int CKFWThreadTest( char * argv[] = 0, int argc = 0 );
 };
@@ -0,0 +1,684 @@
+/*
+ * CKFWTimerWheel.cpp - this file implements a hashed, hierarchical timer
+ *                      wheel that can keep track of many thousands of timers
+ *                      with O(1) scheduling and cancelling. The expired tasks
+ *                      are run on a CKExecutor, if the wheel has one, or on
+ *                      the thread turning the wheel.
+ *
+ * $Id$
+ */
+
+//	System Headers
+#include <iostream>
+#include <sstream>
+#include <exception>
+#include <sys/time.h>
+#include <time.h>
+
+//	Third-Party Headers
+
+//	Other Headers
+#include "CKFWTimerWheel.h"
+#include "CKException.h"
+#include "CKStackLocker.h"
+
+//	Forward Declarations
+
+//	Private Constants
+/*
+ * This is the longest the wheel's thread will sleep when there are no
+ * timers at all - a new timer will wake it up anyway.
+ */
+#define	IDLE_WAIT_IN_MILLIS		1000
+
+/*
+ * These pick apart the ticks for the levels of the wheel. Level 0 is the
+ * root, and ROOT_MASK gets the slot in it. LEVEL_SHIFT(n) is the shift to
+ * get the slot in level 'n' (n > 0), and LEVEL_SPAN(n) is the number of
+ * ticks that all the levels up to and including 'n' can hold.
+ */
+#define	ROOT_MASK				(CKFW_TIMER_WHEEL_ROOT_SIZE - 1)
+#define	LEVEL_MASK				(CKFW_TIMER_WHEEL_LEVEL_SIZE - 1)
+#define	LEVEL_SHIFT(n)			(CKFW_TIMER_WHEEL_ROOT_BITS + ((n) - 1) * CKFW_TIMER_WHEEL_LEVEL_BITS)
+#define	LEVEL_SPAN(n)			(1ULL << (CKFW_TIMER_WHEEL_ROOT_BITS + (n) * CKFW_TIMER_WHEEL_LEVEL_BITS))
+#define	LEVEL_OFFSET(n)			(CKFW_TIMER_WHEEL_ROOT_SIZE + ((n) - 1) * CKFW_TIMER_WHEEL_LEVEL_SIZE)
+
+//	Private Datatypes
+/*
+ * This is the test the wheel's thread waits on - it sleeps until it's
+ * kicked by a sooner timer, or told to stop.
+ */
+class CKFWTimerWheelIdleTest :
+	public ICKFWConditionalSpuriousTest
+{
+	public:
+		CKFWTimerWheelIdleTest( volatile long *aKicked, volatile long *aStopping ) :
+			mKicked(aKicked),
+			mStopping(aStopping)
+		{
+		}
+
+		virtual int test()
+		{
+			return ((*mKicked == 0) && (*mStopping == 0));
+		}
+
+	private:
+		volatile long	*mKicked;
+		volatile long	*mStopping;
+};
+
+
+/*
+ * This is a timer that has fired and needs to be dispatched once the
+ * lock on the wheel has been released.
+ */
+struct CKFWFiredTimer
+{
+	ICKExecutorTask		*task;
+	bool				deleteWhenDone;
+};
+
+//	Private Data Constants
+
+
+/*******************************************************************
+ *
+ *                   Timer Wheel Thread Class
+ *
+ *******************************************************************/
+CKFWTimerWheelThread::CKFWTimerWheelThread( CKFWTimerWheel *aWheel ) :
+	CKFWThread(cDefaultPolicy, cDefaultPriority, cDefaultScope, 0),
+	mWheel(aWheel)
+{
+	setTag("CKFWTimerWheel");
+}
+
+
+CKFWTimerWheelThread::~CKFWTimerWheelThread()
+{
+	mWheel = NULL;
+}
+
+
+/*
+ * This method is called within a loop in the CKFWThread's run
+ * loop and waits for the next timer and fires it. When the wheel
+ * is stopped, it returns cDone.
+ */
+int CKFWTimerWheelThread::process()
+{
+	if (!mWheel->waitForNextTimer()) {
+		return cDone;
+	}
+	mWheel->runExpired();
+	return cSuccess;
+}
+
+
+/*******************************************************************
+ *
+ *                     Timer Wheel Class
+ *
+ *******************************************************************/
+/********************************************************
+ *
+ *                Constructors/Destructor
+ *
+ ********************************************************/
+/*
+ * This constructor creates an empty wheel with the given length of
+ * a tick in milliseconds - that's the resolution of the timers. If
+ * an executor is provided, the expired tasks are run on it, and if
+ * not, they are run on the thread turning the wheel.
+ */
+CKFWTimerWheel::CKFWTimerWheel( int aTickInMillis, CKExecutor *anExecutor ) :
+	mTickInMillis(aTickInMillis > 0 ? aTickInMillis : 1),
+	mStartMillis(nowInMillis()),
+	mExecutor(anExecutor),
+	mEntries(),
+	mFreeList(-1),
+	mCount(0),
+	mNextTick(0),
+	mMutex(),
+	mConditional(mMutex),
+	mKicked(0),
+	mWakeTick(0),
+	mStopping(0),
+	mThread(NULL)
+{
+	for (unsigned int i = 0; i < sizeof(mSlots)/sizeof(int); ++i) {
+		mSlots[i] = -1;
+	}
+}
+
+
+/*
+ * This is the standard destructor and needs to be virtual to make
+ * sure that if we subclass off this the right destructor will be
+ * called. It stops the wheel's thread, if it's running, and deletes
+ * the pending tasks that the wheel owns.
+ */
+CKFWTimerWheel::~CKFWTimerWheel()
+{
+	stop();
+
+	for (unsigned int i = 0; i < mEntries.size(); ++i) {
+		if ((mEntries[i].slot >= 0) && mEntries[i].deleteWhenDone) {
+			delete mEntries[i].task;
+		}
+		mEntries[i].task = NULL;
+	}
+}
+
+
+/********************************************************
+ *
+ *                Accessor Methods
+ *
+ ********************************************************/
+/*
+ * These set and get the executor that the expired tasks are
+ * submitted to. If it's NULL, they are run on the thread that's
+ * turning the wheel, so they had better be quick.
+ */
+void CKFWTimerWheel::setExecutor( CKExecutor *anExecutor )
+{
+	CKStackLocker	lockem(&mMutex);
+	mExecutor = anExecutor;
+}
+
+
+CKExecutor *CKFWTimerWheel::getExecutor() const
+{
+	return mExecutor;
+}
+
+
+/*
+ * This returns the length of a tick in milliseconds.
+ */
+int CKFWTimerWheel::getTickInMillis() const
+{
+	return mTickInMillis;
+}
+
+
+/*
+ * This returns the number of timers waiting to fire.
+ */
+int CKFWTimerWheel::size() const
+{
+	return mCount;
+}
+
+
+/********************************************************
+ *
+ *                Timer Methods
+ *
+ ********************************************************/
+/*
+ * This method schedules the task to run after the given delay in
+ * milliseconds - rounded up to the next tick. If the period is
+ * greater than zero, the task will run again every period until
+ * it's cancelled. If 'aDeleteWhenDone' is true, the wheel owns the
+ * task and deletes it after it runs - which is only allowed for
+ * timers that don't repeat. The returned handle can cancel it.
+ */
+CKFWTimerHandle CKFWTimerWheel::schedule( ICKExecutorTask *aTask, int aDelayInMillis,
+										  int aPeriodInMillis, bool aDeleteWhenDone )
+{
+	// first, make sure we have something to do
+	if (aTask == NULL) {
+		std::ostringstream	msg;
+		msg << "CKFWTimerWheel::schedule(ICKExecutorTask *, int, int, bool) - the "
+			"provided task is NULL and that means there's nothing to do. Please "
+			"make sure that the argument is not NULL before calling.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+	if ((aPeriodInMillis > 0) && aDeleteWhenDone) {
+		std::ostringstream	msg;
+		msg << "CKFWTimerWheel::schedule(ICKExecutorTask *, int, int, bool) - a "
+			"repeating timer can't be owned by the wheel as it's never done. "
+			"Please keep the task and delete it once the timer is cancelled.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// the period is a whole number of ticks - rounded up
+	unsigned long long	period = (aPeriodInMillis > 0 ?
+			(aPeriodInMillis + mTickInMillis - 1) / mTickInMillis : 0);
+
+	CKStackLocker	lockem(&mMutex);
+	int					e = allocEntry();
+	CKFWTimerEntry		& entry = mEntries[e];
+	entry.task = aTask;
+	entry.deleteWhenDone = aDeleteWhenDone;
+	/*
+	 * The first run is the first tick that starts at or after now plus
+	 * the delay. Counting the delay from the start of the current tick
+	 * would let it go off as much as a tick early - no good for the
+	 * timeouts and retries this is for.
+	 */
+	if (aDelayInMillis > 0) {
+		entry.expiration = (nowInMillis() - mStartMillis + aDelayInMillis +
+							mTickInMillis - 1) / mTickInMillis;
+	} else {
+		entry.expiration = currentTick();
+	}
+	entry.period = period;
+	file(e);
+	++mCount;
+
+	// if the wheel's thread is going to sleep past this, wake it up
+	if ((mThread != NULL) && (entry.expiration < mWakeTick)) {
+		mKicked = 1;
+		mConditional.wakeWaiter();
+	}
+
+	return CKFWTimerHandle(e, entry.generation);
+}
+
+
+/*
+ * This method cancels the timer and returns true if it was still
+ * waiting to fire. If the wheel owns the task, it's deleted. For
+ * a repeating timer, a run that's already been started will still
+ * finish, but there won't be any more.
+ */
+bool CKFWTimerWheel::cancel( const CKFWTimerHandle & aHandle )
+{
+	ICKExecutorTask		*doomed = NULL;
+	bool				cancelled = false;
+
+	{
+		CKStackLocker	lockem(&mMutex);
+		if ((aHandle.mEntry >= 0) && (aHandle.mEntry < (int)mEntries.size()) &&
+			(mEntries[aHandle.mEntry].generation == aHandle.mGeneration) &&
+			(mEntries[aHandle.mEntry].slot >= 0)) {
+			CKFWTimerEntry	& entry = mEntries[aHandle.mEntry];
+			if (entry.deleteWhenDone) {
+				doomed = entry.task;
+			}
+			unfile(aHandle.mEntry);
+			releaseEntry(aHandle.mEntry);
+			--mCount;
+			cancelled = true;
+		}
+	}
+
+	// delete the task outside the lock in case it's got its own ideas
+	if (doomed != NULL) {
+		delete doomed;
+	}
+	return cancelled;
+}
+
+
+/*
+ * This returns true if the timer is still waiting to fire.
+ */
+bool CKFWTimerWheel::isScheduled( const CKFWTimerHandle & aHandle ) const
+{
+	CKStackLocker	lockem(&mMutex);
+	return ((aHandle.mEntry >= 0) && (aHandle.mEntry < (int)mEntries.size()) &&
+			(mEntries[aHandle.mEntry].generation == aHandle.mGeneration) &&
+			(mEntries[aHandle.mEntry].slot >= 0));
+}
+
+
+/********************************************************
+ *
+ *                Driving Methods
+ *
+ ********************************************************/
+/*
+ * This method turns the wheel up to the current time and fires
+ * all the timers that have expired, returning how many that was.
+ * It's what an event loop calls if it's turning the wheel.
+ */
+int CKFWTimerWheel::runExpired()
+{
+	std::vector<CKFWFiredTimer>		fired;
+
+	mMutex.lock();
+	unsigned long long	now = currentTick();
+	while (mNextTick <= now) {
+		unsigned long long	tick = mNextTick;
+		int					idx = (int)(tick & ROOT_MASK);
+		// when the root wraps, bring down the next slot of the level above
+		if (idx == 0) {
+			for (int level = 1; level < CKFW_TIMER_WHEEL_LEVELS; ++level) {
+				if (cascade(level, (int)((tick >> LEVEL_SHIFT(level)) & LEVEL_MASK)) != 0) {
+					break;
+				}
+			}
+		}
+		++mNextTick;
+
+		// now fire everything in this slot
+		int		e = mSlots[idx];
+		mSlots[idx] = -1;
+		while (e >= 0) {
+			CKFWTimerEntry	& entry = mEntries[e];
+			int				next = entry.next;
+			entry.slot = -1;
+			entry.prev = -1;
+			entry.next = -1;
+			if (entry.expiration > tick) {
+				// not yet - this can't happen, but it's cheap to be sure
+				file(e);
+			} else {
+				CKFWFiredTimer	f;
+				f.task = entry.task;
+				f.deleteWhenDone = entry.deleteWhenDone;
+				fired.push_back(f);
+				if (entry.period > 0) {
+					// keep to the schedule unless we're too far behind
+					entry.expiration += entry.period;
+					if (entry.expiration <= tick) {
+						entry.expiration = tick + entry.period;
+					}
+					file(e);
+				} else {
+					releaseEntry(e);
+					--mCount;
+				}
+			}
+			e = next;
+		}
+	}
+	mMutex.unlock();
+
+	// run them all now that the wheel is free for them to use
+	for (unsigned int i = 0; i < fired.size(); ++i) {
+		dispatch(fired[i].task, fired[i].deleteWhenDone);
+	}
+	return (int)fired.size();
+}
+
+
+/*
+ * This returns the number of milliseconds until the next timer
+ * might fire - it's never later than the real time, but it may be
+ * sooner when the next timer is far out. An event loop can use
+ * this as its timeout. If there are no timers, it returns -1.
+ */
+int CKFWTimerWheel::getMillisUntilNextTimer() const
+{
+	CKStackLocker	lockem(&mMutex);
+	if (mCount == 0) {
+		return -1;
+	}
+
+	/*
+	 * Look through the root for the next slot with something in it, but
+	 * only up to where it wraps - at that point timers come down from the
+	 * levels above, so that's as far as we can be sure of.
+	 */
+	unsigned long long	target = (mNextTick | ROOT_MASK) + 1;
+	for (unsigned long long t = mNextTick; t < target; ++t) {
+		if (mSlots[t & ROOT_MASK] >= 0) {
+			target = t;
+			break;
+		}
+	}
+
+	long long	wait = (long long)(mStartMillis + target * mTickInMillis) -
+						(long long)nowInMillis();
+	return (wait > 0 ? (int)wait : 0);
+}
+
+
+/*
+ * These start and stop a thread that turns the wheel. Timers
+ * can be scheduled and cancelled whether it's running or not.
+ */
+void CKFWTimerWheel::start()
+{
+	CKStackLocker	lockem(&mMutex);
+	if (mThread == NULL) {
+		mStopping = 0;
+		mThread = new CKFWTimerWheelThread(this);
+		mThread->start();
+	}
+}
+
+
+void CKFWTimerWheel::stop()
+{
+	CKFWTimerWheelThread	*thread = NULL;
+
+	mMutex.lock();
+	if (mThread != NULL) {
+		thread = mThread;
+		mStopping = 1;
+		mConditional.wakeWaiters();
+	}
+	mMutex.unlock();
+
+	// wait for it to leave outside the lock so it can finish up
+	if (thread != NULL) {
+		thread->join();
+		delete thread;
+		mMutex.lock();
+		mThread = NULL;
+		mMutex.unlock();
+	}
+}
+
+
+bool CKFWTimerWheel::isRunning() const
+{
+	return (mThread != NULL);
+}
+
+
+/*
+ * This is the clock that the wheel uses - the milliseconds on the
+ * monotonic clock so it doesn't jump when the wall clock is set.
+ */
+unsigned long long CKFWTimerWheel::nowInMillis()
+{
+#ifdef CLOCK_MONOTONIC
+	timespec	ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000;
+#else
+	timeval		tv;
+	gettimeofday(&tv, NULL);
+	return (unsigned long long)tv.tv_sec * 1000ULL + tv.tv_usec / 1000;
+#endif
+}
+
+
+/*
+ * This returns the current tick according to the clock.
+ */
+unsigned long long CKFWTimerWheel::currentTick() const
+{
+	return (nowInMillis() - mStartMillis) / mTickInMillis;
+}
+
+
+/*
+ * These add and remove the entry from the slot in the wheel that
+ * its expiration goes in. They need the lock to be held.
+ */
+void CKFWTimerWheel::file( int anEntry )
+{
+	CKFWTimerEntry		& entry = mEntries[anEntry];
+	unsigned long long	expires = entry.expiration;
+	int					slot = 0;
+
+	if (expires < mNextTick) {
+		// it's already late, so it goes off on the very next tick
+		slot = (int)(mNextTick & ROOT_MASK);
+	} else {
+		unsigned long long	delta = expires - mNextTick;
+		if (delta < LEVEL_SPAN(0)) {
+			slot = (int)(expires & ROOT_MASK);
+		} else {
+			// too far out for the wheel? Park it at the end to be re-filed
+			if (delta >= LEVEL_SPAN(CKFW_TIMER_WHEEL_LEVELS - 1)) {
+				expires = mNextTick + LEVEL_SPAN(CKFW_TIMER_WHEEL_LEVELS - 1) - 1;
+				delta = expires - mNextTick;
+			}
+			int		level = 1;
+			while (delta >= LEVEL_SPAN(level)) {
+				++level;
+			}
+			slot = LEVEL_OFFSET(level) + (int)((expires >> LEVEL_SHIFT(level)) & LEVEL_MASK);
+		}
+	}
+
+	// put it at the head of the slot's list
+	entry.slot = slot;
+	entry.prev = -1;
+	entry.next = mSlots[slot];
+	if (entry.next >= 0) {
+		mEntries[entry.next].prev = anEntry;
+	}
+	mSlots[slot] = anEntry;
+}
+
+
+void CKFWTimerWheel::unfile( int anEntry )
+{
+	CKFWTimerEntry	& entry = mEntries[anEntry];
+	if (entry.prev >= 0) {
+		mEntries[entry.prev].next = entry.next;
+	} else {
+		mSlots[entry.slot] = entry.next;
+	}
+	if (entry.next >= 0) {
+		mEntries[entry.next].prev = entry.prev;
+	}
+	entry.slot = -1;
+	entry.prev = -1;
+	entry.next = -1;
+}
+
+
+/*
+ * This moves all the entries in the given slot of the given level
+ * down into the lower levels and returns the index of the slot.
+ */
+int CKFWTimerWheel::cascade( int aLevel, int anIndex )
+{
+	int		slot = LEVEL_OFFSET(aLevel) + anIndex;
+	int		e = mSlots[slot];
+	mSlots[slot] = -1;
+	while (e >= 0) {
+		int		next = mEntries[e].next;
+		file(e);
+		e = next;
+	}
+	return anIndex;
+}
+
+
+/*
+ * These get a free entry and put one back on the free list.
+ */
+int CKFWTimerWheel::allocEntry()
+{
+	int		e = mFreeList;
+	if (e >= 0) {
+		mFreeList = mEntries[e].next;
+		mEntries[e].next = -1;
+	} else {
+		mEntries.push_back(CKFWTimerEntry());
+		e = (int)mEntries.size() - 1;
+	}
+	return e;
+}
+
+
+void CKFWTimerWheel::releaseEntry( int anEntry )
+{
+	CKFWTimerEntry	& entry = mEntries[anEntry];
+	entry.task = NULL;
+	entry.deleteWhenDone = false;
+	entry.slot = -1;
+	entry.prev = -1;
+	++entry.generation;
+	entry.next = mFreeList;
+	mFreeList = anEntry;
+}
+
+
+/*
+ * This is the wait that the wheel's thread does between turns. It
+ * returns false when the thread needs to stop.
+ */
+bool CKFWTimerWheel::waitForNextTimer()
+{
+	/*
+	 * Until we know when we're waking up, any new timer has to kick us,
+	 * as we might have looked at the wheel before it was filed.
+	 */
+	mMutex.lock();
+	mKicked = 0;
+	mWakeTick = ~0ULL;
+	mMutex.unlock();
+
+	int		wait = getMillisUntilNextTimer();
+	if (wait < 0) {
+		wait = IDLE_WAIT_IN_MILLIS;
+	}
+
+	// now let schedule() know when we're planning on waking up
+	mMutex.lock();
+	mWakeTick = currentTick() + (wait + mTickInMillis - 1) / mTickInMillis;
+	mMutex.unlock();
+
+	if (wait > 0) {
+		CKFWTimerWheelIdleTest	tst(&mKicked, &mStopping);
+		if (mConditional.lockAndTest(tst, wait) == FWCOND_LOCK_SUCCESS) {
+			mMutex.unlock();
+		}
+	}
+
+	// we're awake - schedule() doesn't need to kick us until we sleep again
+	mMutex.lock();
+	mWakeTick = 0;
+	mMutex.unlock();
+
+	return (mStopping == 0);
+}
+
+
+/*
+ * This runs (or submits) a task that has fired.
+ */
+void CKFWTimerWheel::dispatch( ICKExecutorTask *aTask, bool aDeleteWhenDone )
+{
+	// if we have an executor, that's where it goes
+	if (mExecutor != NULL) {
+		try {
+			mExecutor->submit(aTask, aDeleteWhenDone);
+			return;
+		} catch (CKException & e) {
+			// the executor is shut down, so run it ourselves
+		}
+	}
+
+	try {
+		aTask->execute();
+	} catch (CKException & e) {
+		std::cerr << "CKFWTimerWheel::dispatch(ICKExecutorTask *, bool) - while "
+			"running a timer's task a CKException was thrown: " << e.getMessage() <<
+			std::endl;
+	} catch (std::exception & e) {
+		std::cerr << "CKFWTimerWheel::dispatch(ICKExecutorTask *, bool) - while "
+			"running a timer's task a std::exception was thrown: " << e.what() <<
+			std::endl;
+	} catch (...) {
+		std::cerr << "CKFWTimerWheel::dispatch(ICKExecutorTask *, bool) - while "
+			"running a timer's task an unknown exception was thrown." << std::endl;
+	}
+	if (aDeleteWhenDone) {
+		delete aTask;
+	}
+}
@@ -0,0 +1,365 @@
+/*
+ * CKFWTimerWheel.h - this file defines a hashed, hierarchical timer wheel
+ *                    that can keep track of many thousands of timers - the
+ *                    socket timeouts, retry delays and heartbeats for all the
+ *                    connections - without anyone having to poll a CKFWTimer.
+ *                    Scheduling and cancelling a timer are O(1), and the wheel
+ *                    only does work for the ticks that actually pass.
+ *
+ *                    The wheel has four levels, like the classic kernel timer
+ *                    wheel. The first has 256 slots of one tick each, and each
+ *                    of the next three has 64 slots, each covering a full turn
+ *                    of the level below it. A timer goes in the lowest level
+ *                    that can hold its expiration, and as the wheel turns, the
+ *                    timers in the higher levels are 'cascaded' down until they
+ *                    are in the first level and fire. With a 1 msec tick that's
+ *                    good for about 18 hours - anything further out is parked
+ *                    in the last slot and re-filed when it gets there.
+ *
+ *                    The callbacks are ICKExecutorTasks. If the wheel has been
+ *                    given a CKExecutor, the expired tasks are submitted to it,
+ *                    otherwise they are run on the thread that's turning the
+ *                    wheel. The wheel can be turned by its own thread - start()
+ *                    and stop() - or by an existing event loop that calls
+ *                    runExpired() with getMillisUntilNextTimer() as its timeout.
+ *
+ * $Id$
+ */
+#ifndef __CKFW_TIMER_WHEEL_H
+#define __CKFW_TIMER_WHEEL_H
+
+//	System Headers
+#include <vector>
+
+//	Third-Party Headers
+
+//	Other Headers
+#include "CKFWThread.h"
+#include "CKFWMutex.h"
+#include "CKFWConditional.h"
+#include "CKExecutor.h"
+
+//	Forward Declarations
+class CKFWTimerWheel;
+
+//	Public Constants
+/*
+ * These are the sizes of the levels of the wheel - the first level has
+ * 2^8 slots and the others have 2^6 each.
+ */
+#define	CKFW_TIMER_WHEEL_ROOT_BITS		8
+#define	CKFW_TIMER_WHEEL_ROOT_SIZE		(1 << CKFW_TIMER_WHEEL_ROOT_BITS)
+#define	CKFW_TIMER_WHEEL_LEVEL_BITS		6
+#define	CKFW_TIMER_WHEEL_LEVEL_SIZE		(1 << CKFW_TIMER_WHEEL_LEVEL_BITS)
+#define	CKFW_TIMER_WHEEL_LEVELS			4
+
+//	Public Datatypes
+
+//	Public Data Constants
+
+
+/*******************************************************************
+ *
+ *                     Timer Handle Class
+ *
+ *******************************************************************/
+/*
+ * When a timer is scheduled, the caller gets back one of these. It's
+ * the entry in the wheel holding the timer and the 'generation' of that
+ * entry so that a stale handle - for a timer that has already fired or
+ * been cancelled - can never cancel a timer that reused the entry.
+ */
+class CKFWTimerHandle
+{
+	public:
+		CKFWTimerHandle() :
+			mEntry(-1),
+			mGeneration(0)
+		{
+		}
+
+		CKFWTimerHandle( int anEntry, unsigned int aGeneration ) :
+			mEntry(anEntry),
+			mGeneration(aGeneration)
+		{
+		}
+
+		// this returns true if this handle was ever given out by a wheel
+		bool isValid() const
+		{
+			return (mEntry >= 0);
+		}
+
+		bool operator==( const CKFWTimerHandle & anOther ) const
+		{
+			return ((mEntry == anOther.mEntry) && (mGeneration == anOther.mGeneration));
+		}
+
+		bool operator!=( const CKFWTimerHandle & anOther ) const
+		{
+			return !operator==(anOther);
+		}
+
+		// this is the entry in the wheel holding the timer
+		int				mEntry;
+		// ...and this is the generation of that entry when it was given out
+		unsigned int	mGeneration;
+};
+
+
+/*******************************************************************
+ *
+ *                     Timer Entry Class
+ *
+ *******************************************************************/
+/*
+ * Each timer is held in one of these. The entries in a slot of the wheel
+ * are kept in a doubly-linked list through the indexes of the entries so
+ * a timer can be pulled out of its slot without searching for it.
+ */
+class CKFWTimerEntry
+{
+	public:
+		CKFWTimerEntry() :
+			task(NULL),
+			deleteWhenDone(false),
+			expiration(0),
+			period(0),
+			generation(0),
+			slot(-1),
+			prev(-1),
+			next(-1)
+		{
+		}
+
+		// this is the task to run when the timer fires
+		ICKExecutorTask			*task;
+		// ...and if we need to delete it after
+		bool					deleteWhenDone;
+		// this is the tick the timer fires on
+		unsigned long long		expiration;
+		// ...and the ticks between firings for a repeating timer (0 if not)
+		unsigned long long		period;
+		// this is bumped every time the entry is released
+		unsigned int			generation;
+		// this is the slot in the wheel we're in (-1 if we're free)
+		int						slot;
+		// ...and these are our neighbors in that slot, or the free list
+		int						prev;
+		int						next;
+};
+
+
+/*******************************************************************
+ *
+ *                   Timer Wheel Thread Class
+ *
+ *******************************************************************/
+/*
+ * This is the thread that turns the wheel when it's started with
+ * start(). It sleeps until the next timer is due - or until a timer
+ * that's due sooner is scheduled - and then fires what's expired.
+ */
+class CKFWTimerWheelThread :
+	public CKFWThread
+{
+	public:
+		CKFWTimerWheelThread( CKFWTimerWheel *aWheel );
+		virtual ~CKFWTimerWheelThread();
+
+	protected:
+		/*
+		 * This method is called within a loop in the CKFWThread's run
+		 * loop and waits for the next timer and fires it. When the wheel
+		 * is stopped, it returns cDone.
+		 */
+		virtual int process();
+
+	private:
+		CKFWTimerWheelThread();
+		CKFWTimerWheelThread( const CKFWTimerWheelThread & anOther );
+		CKFWTimerWheelThread & operator=( const CKFWTimerWheelThread & anOther );
+
+		// this is the wheel we're turning
+		CKFWTimerWheel		*mWheel;
+};
+
+
+/*
+ * This is the main class definition.
+ */
+class CKFWTimerWheel
+{
+	public:
+		/********************************************************
+		 *
+		 *                Constructors/Destructor
+		 *
+		 ********************************************************/
+		/*
+		 * This constructor creates an empty wheel with the given length of
+		 * a tick in milliseconds - that's the resolution of the timers. If
+		 * an executor is provided, the expired tasks are run on it, and if
+		 * not, they are run on the thread turning the wheel.
+		 */
+		CKFWTimerWheel( int aTickInMillis = 1, CKExecutor *anExecutor = NULL );
+		/*
+		 * This is the standard destructor and needs to be virtual to make
+		 * sure that if we subclass off this the right destructor will be
+		 * called. It stops the wheel's thread, if it's running, and deletes
+		 * the pending tasks that the wheel owns.
+		 */
+		virtual ~CKFWTimerWheel();
+
+		/********************************************************
+		 *
+		 *                Accessor Methods
+		 *
+		 ********************************************************/
+		/*
+		 * These set and get the executor that the expired tasks are
+		 * submitted to. If it's NULL, they are run on the thread that's
+		 * turning the wheel, so they had better be quick.
+		 */
+		void setExecutor( CKExecutor *anExecutor );
+		CKExecutor *getExecutor() const;
+		/*
+		 * This returns the length of a tick in milliseconds.
+		 */
+		int getTickInMillis() const;
+		/*
+		 * This returns the number of timers waiting to fire.
+		 */
+		int size() const;
+
+		/********************************************************
+		 *
+		 *                Timer Methods
+		 *
+		 ********************************************************/
+		/*
+		 * This method schedules the task to run after the given delay in
+		 * milliseconds - rounded up to the next tick. If the period is
+		 * greater than zero, the task will run again every period until
+		 * it's cancelled. If 'aDeleteWhenDone' is true, the wheel owns the
+		 * task and deletes it after it runs - which is only allowed for
+		 * timers that don't repeat. The returned handle can cancel it.
+		 */
+		CKFWTimerHandle schedule( ICKExecutorTask *aTask, int aDelayInMillis,
+								  int aPeriodInMillis = 0,
+								  bool aDeleteWhenDone = false );
+		/*
+		 * This method cancels the timer and returns true if it was still
+		 * waiting to fire. If the wheel owns the task, it's deleted. For
+		 * a repeating timer, a run that's already been started will still
+		 * finish, but there won't be any more.
+		 */
+		bool cancel( const CKFWTimerHandle & aHandle );
+		/*
+		 * This returns true if the timer is still waiting to fire.
+		 */
+		bool isScheduled( const CKFWTimerHandle & aHandle ) const;
+
+		/********************************************************
+		 *
+		 *                Driving Methods
+		 *
+		 ********************************************************/
+		/*
+		 * This method turns the wheel up to the current time and fires
+		 * all the timers that have expired, returning how many that was.
+		 * It's what an event loop calls if it's turning the wheel.
+		 */
+		int runExpired();
+		/*
+		 * This returns the number of milliseconds until the next timer
+		 * might fire - it's never later than the real time, but it may be
+		 * sooner when the next timer is far out. An event loop can use
+		 * this as its timeout. If there are no timers, it returns -1.
+		 */
+		int getMillisUntilNextTimer() const;
+		/*
+		 * These start and stop a thread that turns the wheel. Timers
+		 * can be scheduled and cancelled whether it's running or not.
+		 */
+		void start();
+		void stop();
+		bool isRunning() const;
+
+		/*
+		 * This is the clock that the wheel uses - the milliseconds on the
+		 * monotonic clock so it doesn't jump when the wall clock is set.
+		 */
+		static unsigned long long nowInMillis();
+
+	protected:
+		friend class CKFWTimerWheelThread;
+
+		/*
+		 * This returns the current tick according to the clock.
+		 */
+		unsigned long long currentTick() const;
+		/*
+		 * These add and remove the entry from the slot in the wheel that
+		 * its expiration goes in. They need the lock to be held.
+		 */
+		void file( int anEntry );
+		void unfile( int anEntry );
+		/*
+		 * This moves all the entries in the given slot of the given level
+		 * down into the lower levels and returns the index of the slot.
+		 */
+		int cascade( int aLevel, int anIndex );
+		/*
+		 * These get a free entry and put one back on the free list.
+		 */
+		int allocEntry();
+		void releaseEntry( int anEntry );
+		/*
+		 * This is the wait that the wheel's thread does between turns. It
+		 * returns false when the thread needs to stop.
+		 */
+		bool waitForNextTimer();
+		/*
+		 * This runs (or submits) a task that has fired.
+		 */
+		void dispatch( ICKExecutorTask *aTask, bool aDeleteWhenDone );
+
+	private:
+		CKFWTimerWheel( const CKFWTimerWheel & anOther );
+		CKFWTimerWheel & operator=( const CKFWTimerWheel & anOther );
+
+		// this is the length of a tick and the clock at tick zero
+		int								mTickInMillis;
+		unsigned long long				mStartMillis;
+		// this is where the expired tasks go, if anywhere
+		CKExecutor						*mExecutor;
+		/*
+		 * These are the timers and the head of the free list, and the
+		 * heads of the lists in each of the slots - the first level's
+		 * slots come first and then each of the others in turn.
+		 */
+		std::vector<CKFWTimerEntry>		mEntries;
+		int								mFreeList;
+		int								mSlots[CKFW_TIMER_WHEEL_ROOT_SIZE +
+											   (CKFW_TIMER_WHEEL_LEVELS - 1) *
+											   CKFW_TIMER_WHEEL_LEVEL_SIZE];
+		int								mCount;
+		// this is the next tick the wheel has yet to process
+		unsigned long long				mNextTick;
+		/*
+		 * This is the lock on all the above, and the conditional that the
+		 * wheel's thread sleeps on. 'mKicked' is set when a timer that's
+		 * due sooner than the thread was planning on waking - 'mWakeTick'
+		 * - is scheduled.
+		 */
+		mutable CKFWMutex				mMutex;
+		CKFWConditional					mConditional;
+		volatile long					mKicked;
+		unsigned long long				mWakeTick;
+		volatile long					mStopping;
+		// this is the thread turning the wheel, if we have one
+		CKFWTimerWheelThread			*mThread;
+};
+
+#endif	// __CKFW_TIMER_WHEEL_H
@@ -0,0 +1,144 @@
+/*
+ * CKInstanceRegistry.h - this file defines a template class that is the
+ *                        process-wide list of all the live instances of
+ *                        a class, and the lock that protects it. It's
+ *                        what lets the queue statistics, the mutex
+ *                        statistics and the running threads each have
+ *                        a dumpAll() that reports on every one of them
+ *                        in the process.
+ *
+ *                        The list and its lock are created on first use,
+ *                        and never destroyed, so an instance that is a
+ *                        static object can add and remove itself at any
+ *                        point in the life of the process. The lock is a
+ *                        plain pthread mutex - and not a CKFWMutex - so
+ *                        the mutex statistics can use it as well.
+ *
+ * $Id$
+ */
+#ifndef __CKINSTANCEREGISTRY_H
+#define __CKINSTANCEREGISTRY_H
+
+//	System Headers
+#include <list>
+#include <pthread.h>
+
+//	Third-Party Headers
+
+//	Other Headers
+#include "CKString.h"
+
+//	Forward Declarations
+
+//	Public Constants
+
+//	Public Datatypes
+
+//	Public Data Constants
+
+/*
+ * Main class definition
+ */
+template <class T> class CKInstanceRegistry
+{
+	public:
+		/*
+		 * These add an instance to the end of the list, and take it off
+		 * again. An instance is typically added in its constructor and
+		 * removed in its destructor.
+		 */
+		static void add( T *anInstance )
+		{
+			pthread_mutex_lock(getMutex());
+			getList()->push_back(anInstance);
+			pthread_mutex_unlock(getMutex());
+		}
+
+
+		static void remove( T *anInstance )
+		{
+			pthread_mutex_lock(getMutex());
+			getList()->remove(anInstance);
+			pthread_mutex_unlock(getMutex());
+		}
+
+
+		/*
+		 * This returns the number of instances in the list right now.
+		 */
+		static int size()
+		{
+			pthread_mutex_lock(getMutex());
+			int		retval = (int)getList()->size();
+			pthread_mutex_unlock(getMutex());
+			return retval;
+		}
+
+
+		/*
+		 * This calls the given method on each of the instances, in the
+		 * order they were added, and returns the results one per line.
+		 * This is the body of the dumpAll() methods.
+		 */
+		static CKString dump( CKString (T::*aMethod)() const )
+		{
+			CKString	retval;
+
+			pthread_mutex_lock(getMutex());
+			typename std::list<T *>::iterator	i;
+			for (i = getList()->begin(); i != getList()->end(); ++i) {
+				retval.append(((*i)->*aMethod)()).append("\n");
+			}
+			pthread_mutex_unlock(getMutex());
+
+			return retval;
+		}
+
+
+		/*
+		 * For anything else, the caller can lock the registry, walk the
+		 * list and then unlock it. The list can't be changed by the
+		 * caller, and it has to be unlocked before the caller returns.
+		 */
+		static void lock()
+		{
+			pthread_mutex_lock(getMutex());
+		}
+
+
+		static void unlock()
+		{
+			pthread_mutex_unlock(getMutex());
+		}
+
+
+		static const std::list<T *> & getInstances()
+		{
+			return *getList();
+		}
+
+	private:
+		/*
+		 * These are the lock and the list themselves. The mutex is
+		 * statically initialized so it's ready before any constructor
+		 * can run, and the list is built the first time it's asked for
+		 * and left for the process to clean up on exit.
+		 */
+		static pthread_mutex_t *getMutex()
+		{
+			static pthread_mutex_t	mutex = PTHREAD_MUTEX_INITIALIZER;
+			return &mutex;
+		}
+
+
+		static std::list<T *> *getList()
+		{
+			static std::list<T *>	*list = new std::list<T *>();
+			return list;
+		}
+
+		// there's nothing to make - it's all static
+		CKInstanceRegistry();
+};
+
+#endif	// __CKINSTANCEREGISTRY_H
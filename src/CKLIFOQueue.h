@@ -334,10 +334,13 @@ template <class T> class CKLIFOQueue
 				mElements[0] = anElem;
 				mSize++;
 
-				// see if we need to wake any waiters
-				if (mSize == 1) {
-					mConditional.wakeWaiter();
-				}
+				/*
+				 * Wake up a waiter on every push - not just when the queue
+				 * goes from empty to not-empty - as there can be several
+				 * consumers waiting in popSomething() or popBatch() and the
+				 * signal is cheap when no one is waiting.
+				 */
+				mConditional.wakeWaiter();
 			}
 		}
 
@@ -381,9 +384,9 @@ template <class T> class CKLIFOQueue
 				}
 			}
 
-			// see if we need to wake any waiters
-			if ((startingSize == 0) && (mSize > 0)) {
-				mConditional.wakeWaiter();
+			// if we added anything, wake all the waiters as there's enough for many
+			if (mSize > startingSize) {
+				mConditional.wakeWaiters();
 			}
 		}
 
@@ -524,6 +527,60 @@ template <class T> class CKLIFOQueue
 		}
 
 
+		/*
+		 * This method is the blocking, batched form of pop(int) for the
+		 * consumers that want to process whatever is on the queue in one
+		 * go. It waits until there is at least one element on the queue,
+		 * or until 'aTimeoutInMillis' have passed (-1 means wait forever
+		 * and 0 means don't wait at all), and then removes up to
+		 * 'aMaxItems' of the elements with a single acquisition of the
+		 * lock. If the timeout expires, the returned CKVector is empty.
+		 */
+		CKVector<T> popBatch( int aMaxItems, int aTimeoutInMillis = -1 )
+		{
+			CKVector<T>		retval;
+
+			// first, see if we have anything to do
+			if (mElements == NULL) {
+				std::ostringstream	msg;
+				msg << "CKLIFOQueue<T>::popBatch(int, int) - the storage for this "
+					"queue is NULL and that is a data corruption problem that needs "
+					"to be looked into as soon as possible. This should never happen.";
+				throw CKException(__FILE__, __LINE__, msg.str());
+			}
+
+			// now make a test based on this queue
+			CKLIFOQueueNotEmptyTest<T>	tst(this);
+			// wait until we get something in the queue, or give up
+			if (mConditional.lockAndTest(tst, aTimeoutInMillis) == FWCOND_LOCK_SUCCESS) {
+				// we hold the lock now, so grab as many as we can
+				int		cnt = (aMaxItems > mSize ? mSize : aMaxItems);
+				try {
+					for (int i = 0; i < cnt; ++i) {
+						retval.addToEnd(mElements[i]);
+					}
+				} catch (...) {
+					mMutex.unlock();
+					throw;
+				}
+
+				// now we need to move everything to the left
+				if (cnt > 0) {
+					int		j = 0;
+					for (int i = cnt; i < mSize; ++i) {
+						mElements[j++] = mElements[i];
+					}
+					mSize -= cnt;
+				}
+
+				// now we can unlock this guy
+				mMutex.unlock();
+			}
+
+			return retval;
+		}
+
+
 		/*
 		 * This method removes ALL copies of the argument from the queue
 		 * and compresses out the empty spaces from the queue. If the
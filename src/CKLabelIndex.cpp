@@ -0,0 +1,269 @@
+/*
+ * CKLabelIndex.cpp - this file implements a simple hash index of strings
+ *                    to integers. It's open-addressing with linear probing
+ *                    in an array that's always a power of two long and at
+ *                    most half full, and each slot keeps the hash of its
+ *                    key so the strings are only compared when the hashes
+ *                    match.
+ *
+ * $Id$
+ */
+
+//	System Headers
+#include <string.h>
+
+//	Third-Party Headers
+
+//	Other Headers
+#include "CKLabelIndex.h"
+
+//	Forward Declarations
+
+//	Private Constants
+/*
+ * This is the size of the array of slots the first time a key is put
+ * in the index.
+ */
+#define CKLABELINDEX_MIN_CAPACITY	16
+
+//	Private Datatypes
+
+//	Private Data Constants
+
+
+/********************************************************
+ *
+ *                Constructors/Destructor
+ *
+ ********************************************************/
+/*
+ * This is the default constructor that creates an empty index.
+ * Nothing is allocated until the first key is put in.
+ */
+CKLabelIndex::CKLabelIndex() :
+	mSlots(NULL),
+	mCapacity(0),
+	mSize(0)
+{
+}
+
+
+/*
+ * This is the standard copy constructor and needs to be in every
+ * class to make sure that we don't have too many things running
+ * around.
+ */
+CKLabelIndex::CKLabelIndex( const CKLabelIndex & anOther ) :
+	mSlots(NULL),
+	mCapacity(0),
+	mSize(0)
+{
+	// let the operator=() do all the work for me
+	*this = anOther;
+}
+
+
+/*
+ * This is the standard destructor and needs to be virtual to make
+ * sure that if we subclass off this, the right destructor will be
+ * called.
+ */
+CKLabelIndex::~CKLabelIndex()
+{
+	clear();
+}
+
+
+/*
+ * When we want to process the result of an equality we need to
+ * make sure that we do this right by always having an equals
+ * operator on all classes.
+ */
+CKLabelIndex & CKLabelIndex::operator=( const CKLabelIndex & anOther )
+{
+	// make sure that we don't do this to ourselves
+	if (this != & anOther) {
+		clear();
+		if (anOther.mSlots != NULL) {
+			// the slots are copied as they are - no need to hash them again
+			mSlots = new CKLabelIndexSlot[anOther.mCapacity];
+			for (int i = 0; i < anOther.mCapacity; ++i) {
+				mSlots[i] = anOther.mSlots[i];
+			}
+			mCapacity = anOther.mCapacity;
+			mSize = anOther.mSize;
+		}
+	}
+	return *this;
+}
+
+
+/********************************************************
+ *
+ *                Accessor Methods
+ *
+ ********************************************************/
+/*
+ * This puts the key in the index with the value. If the key is
+ * already there, its value is replaced - just like the operator[]
+ * on a std::map.
+ */
+void CKLabelIndex::put( const CKString & aKey, int aValue )
+{
+	// keep it at most half full so that the probes stay short
+	if (2 * (mSize + 1) > mCapacity) {
+		rehash(mCapacity < CKLABELINDEX_MIN_CAPACITY ?
+				CKLABELINDEX_MIN_CAPACITY : 2 * mCapacity);
+	}
+
+	const char		*key = aKey.c_str();
+	int				len = aKey.size();
+	unsigned int	h = hash(key, len);
+	CKLabelIndexSlot	& slot = mSlots[findSlot(key, len, h)];
+	if (slot.hash == 0) {
+		slot.hash = h;
+		slot.key.assign(key, len);
+		++mSize;
+	}
+	slot.value = aValue;
+}
+
+
+/*
+ * These return the value for the key, or -1 if the key isn't in
+ * the index.
+ */
+int CKLabelIndex::get( const CKString & aKey ) const
+{
+	return get(aKey.c_str(), aKey.size());
+}
+
+
+int CKLabelIndex::get( const char *aKey, int aLength ) const
+{
+	if (mSize == 0) {
+		return -1;
+	}
+	const CKLabelIndexSlot	& slot = mSlots[findSlot(aKey, aLength, hash(aKey, aLength))];
+	return (slot.hash == 0 ? -1 : slot.value);
+}
+
+
+/*
+ * This returns the number of keys in the index.
+ */
+int CKLabelIndex::size() const
+{
+	return mSize;
+}
+
+
+/*
+ * This makes room for 'aCount' keys in all, so that putting them
+ * in won't have to grow the index along the way.
+ */
+void CKLabelIndex::reserve( int aCount )
+{
+	int		cap = (mCapacity < CKLABELINDEX_MIN_CAPACITY ?
+					CKLABELINDEX_MIN_CAPACITY : mCapacity);
+	while (cap < 2 * aCount) {
+		cap *= 2;
+	}
+	if (cap > mCapacity) {
+		rehash(cap);
+	}
+}
+
+
+/*
+ * This empties the index and gives back all its memory.
+ */
+void CKLabelIndex::clear()
+{
+	if (mSlots != NULL) {
+		delete [] mSlots;
+		mSlots = NULL;
+	}
+	mCapacity = 0;
+	mSize = 0;
+}
+
+
+/********************************************************
+ *
+ *                Private Methods
+ *
+ ********************************************************/
+/*
+ * This is the hash of the bytes - FNV-1a, with zero, which marks
+ * an empty slot, moved to one.
+ */
+unsigned int CKLabelIndex::hash( const char *aKey, int aLength )
+{
+	unsigned int	h = 2166136261u;
+	for (int i = 0; i < aLength; ++i) {
+		h ^= (unsigned char)aKey[i];
+		h *= 16777619u;
+	}
+	return (h == 0 ? 1 : h);
+}
+
+
+/*
+ * This returns the slot the key is in or, if it's not there, the
+ * empty slot where it would go. There's always an empty slot, as
+ * the array is never more than half full.
+ */
+int CKLabelIndex::findSlot( const char *aKey, int aLength, unsigned int aHash ) const
+{
+	int		mask = mCapacity - 1;
+	int		i = (int)(aHash & mask);
+	while (true) {
+		const CKLabelIndexSlot	& slot = mSlots[i];
+		if (slot.hash == 0) {
+			break;
+		}
+		if ((slot.hash == aHash) && ((int)slot.key.size() == aLength) &&
+			(memcmp(slot.key.data(), aKey, aLength) == 0)) {
+			break;
+		}
+		i = (i + 1) & mask;
+	}
+	return i;
+}
+
+
+/*
+ * This makes the array of slots 'aCapacity' long - a power of two
+ * - and puts all the keys back in it. The keys are swapped into
+ * their new slots so none of the strings are copied.
+ */
+void CKLabelIndex::rehash( int aCapacity )
+{
+	CKLabelIndexSlot	*old = mSlots;
+	int					oldCapacity = mCapacity;
+
+	mSlots = new CKLabelIndexSlot[aCapacity];
+	mCapacity = aCapacity;
+	for (int i = 0; i < aCapacity; ++i) {
+		mSlots[i].hash = 0;
+	}
+
+	int		mask = aCapacity - 1;
+	for (int i = 0; i < oldCapacity; ++i) {
+		CKLabelIndexSlot	& from = old[i];
+		if (from.hash != 0) {
+			int		j = (int)(from.hash & mask);
+			while (mSlots[j].hash != 0) {
+				j = (j + 1) & mask;
+			}
+			mSlots[j].hash = from.hash;
+			mSlots[j].value = from.value;
+			mSlots[j].key.swap(from.key);
+		}
+	}
+
+	if (old != NULL) {
+		delete [] old;
+	}
+}
@@ -0,0 +1,139 @@
+/*
+ * CKLabelIndex.h - this file defines a simple hash index of strings to
+ *                  integers - the row labels and column headers of a
+ *                  CKTable to their positions, for instance. It's an
+ *                  open-addressing table with linear probing, so a lookup
+ *                  is a hash of the string and then, almost always, one
+ *                  compare of a slot that's right there in the array - and
+ *                  not the half-dozen string compares and pointer chases
+ *                  of a std::map.
+ *
+ * $Id$
+ */
+#ifndef __CKLABELINDEX_H
+#define __CKLABELINDEX_H
+
+//	System Headers
+#include <string>
+
+//	Third-Party Headers
+
+//	Other Headers
+#include "CKString.h"
+
+//	Forward Declarations
+
+//	Public Constants
+
+//	Public Datatypes
+/*
+ * This is one slot in the index. A hash of zero means the slot is
+ * empty, so the hash of every key is made non-zero. The key is an STL
+ * string because an empty one costs nothing, and most slots are empty.
+ */
+struct CKLabelIndexSlot {
+	unsigned int	hash;
+	int				value;
+	std::string		key;
+};
+
+//	Public Data Constants
+
+
+
+/*
+ * This is the main class definition.
+ */
+class CKLabelIndex
+{
+	public:
+		/********************************************************
+		 *
+		 *                Constructors/Destructor
+		 *
+		 ********************************************************/
+		/*
+		 * This is the default constructor that creates an empty index.
+		 * Nothing is allocated until the first key is put in.
+		 */
+		CKLabelIndex();
+		/*
+		 * This is the standard copy constructor and needs to be in every
+		 * class to make sure that we don't have too many things running
+		 * around.
+		 */
+		CKLabelIndex( const CKLabelIndex & anOther );
+		/*
+		 * This is the standard destructor and needs to be virtual to make
+		 * sure that if we subclass off this, the right destructor will be
+		 * called.
+		 */
+		virtual ~CKLabelIndex();
+
+		/*
+		 * When we want to process the result of an equality we need to
+		 * make sure that we do this right by always having an equals
+		 * operator on all classes.
+		 */
+		CKLabelIndex & operator=( const CKLabelIndex & anOther );
+
+		/********************************************************
+		 *
+		 *                Accessor Methods
+		 *
+		 ********************************************************/
+		/*
+		 * This puts the key in the index with the value. If the key is
+		 * already there, its value is replaced - just like the operator[]
+		 * on a std::map.
+		 */
+		void put( const CKString & aKey, int aValue );
+		/*
+		 * These return the value for the key, or -1 if the key isn't in
+		 * the index.
+		 */
+		int get( const CKString & aKey ) const;
+		int get( const char *aKey, int aLength ) const;
+
+		/*
+		 * This returns the number of keys in the index.
+		 */
+		int size() const;
+		/*
+		 * This makes room for 'aCount' keys in all, so that putting them
+		 * in won't have to grow the index along the way.
+		 */
+		void reserve( int aCount );
+		/*
+		 * This empties the index and gives back all its memory.
+		 */
+		void clear();
+
+	private:
+		/*
+		 * This is the hash of the bytes - FNV-1a, with zero, which marks
+		 * an empty slot, moved to one.
+		 */
+		static unsigned int hash( const char *aKey, int aLength );
+		/*
+		 * This returns the slot the key is in or, if it's not there, the
+		 * empty slot where it would go.
+		 */
+		int findSlot( const char *aKey, int aLength, unsigned int aHash ) const;
+		/*
+		 * This makes the array of slots 'aCapacity' long - a power of two
+		 * - and puts all the keys back in it.
+		 */
+		void rehash( int aCapacity );
+
+		/*
+		 * This is the array of slots, which is always a power of two
+		 * long and never more than half full, so a probe for a key that
+		 * isn't there is short.
+		 */
+		CKLabelIndexSlot	*mSlots;
+		int					mCapacity;
+		int					mSize;
+};
+
+#endif	// __CKLABELINDEX_H
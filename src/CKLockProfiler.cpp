@@ -0,0 +1,341 @@
+/*
+ * CKLockProfiler.cpp - this file implements a simple profiler for the locks
+ *                      taken with a CKStackLocker. Each thread records the
+ *                      wait and hold times for its call sites into its own
+ *                      table, and the report adds up all the tables to show
+ *                      the sites with the most waiting.
+ *
+ * $Id$
+ */
+
+//	System Headers
+#include <pthread.h>
+#include <sys/time.h>
+#include <time.h>
+#include <stdio.h>
+#include <string.h>
+#include <map>
+#include <vector>
+#include <list>
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+#ifdef __GNUC__
+#include <dlfcn.h>
+#endif
+
+//	Third-Party Headers
+
+//	Other Headers
+#include "CKLockProfiler.h"
+#include "CKString.h"
+
+//	Forward Declarations
+
+//	Private Constants
+
+//	Private Datatypes
+/*
+ * This is what's recorded for one call site in one thread. Only the
+ * thread that owns the table writes to it, so there's no locking - the
+ * report just reads the values as they are.
+ */
+struct CKLockSiteStats
+{
+	const void * volatile		site;
+	volatile int				line;
+	volatile unsigned long		count;
+	volatile unsigned long		contended;
+	volatile unsigned long long	waitNanos;
+	volatile unsigned long long	holdNanos;
+	volatile unsigned long long	maxWaitNanos;
+};
+
+
+/*
+ * This is the table of call sites for one thread. When the thread
+ * exits, the table is kept - so its numbers are still in the report -
+ * and it's handed to the next new thread to carry on with.
+ */
+struct CKLockProfilerTable
+{
+	CKLockSiteStats			sites[CKLOCKPROFILER_SITES_PER_THREAD];
+	volatile unsigned long	dropped;
+	volatile int			inUse;
+};
+
+
+/*
+ * This is one line of the report - the sum over all the threads.
+ */
+struct CKLockSiteTotals
+{
+	const void			*site;
+	int					line;
+	unsigned long		count;
+	unsigned long		contended;
+	unsigned long long	waitNanos;
+	unsigned long long	holdNanos;
+	unsigned long long	maxWaitNanos;
+};
+
+
+/*
+ * The report is sorted by the total wait, the most first.
+ */
+static bool moreWaiting( const CKLockSiteTotals & aLeft, const CKLockSiteTotals & aRight )
+{
+	return (aLeft.waitNanos > aRight.waitNanos);
+}
+
+//	Private Data Constants
+volatile int CKLockProfiler::sEnabled = 0;
+
+/*
+ * These are all the tables ever made, and the lock on the list. This
+ * can't be a CKFWMutex as a CKStackLocker might be profiling it.
+ */
+static pthread_mutex_t	sTablesMutex = PTHREAD_MUTEX_INITIALIZER;
+static std::list<CKLockProfilerTable *> *tables()
+{
+	static std::list<CKLockProfilerTable *>	*list = new std::list<CKLockProfilerTable *>();
+	return list;
+}
+
+/*
+ * Each thread's table is in this thread-specific key. When the thread
+ * goes away, its table is marked as free for the next thread.
+ */
+static pthread_key_t	sTableKey;
+static pthread_once_t	sTableKeyOnce = PTHREAD_ONCE_INIT;
+
+static void releaseTable( void *aTable )
+{
+	((CKLockProfilerTable *)aTable)->inUse = 0;
+}
+
+static void createTableKey()
+{
+	pthread_key_create(&sTableKey, releaseTable);
+}
+
+
+/*
+ * This returns the calling thread's table - getting one the first
+ * time the thread records anything.
+ */
+static CKLockProfilerTable *myTable()
+{
+	pthread_once(&sTableKeyOnce, createTableKey);
+	CKLockProfilerTable		*table = (CKLockProfilerTable *)pthread_getspecific(sTableKey);
+	if (table == NULL) {
+		pthread_mutex_lock(&sTablesMutex);
+		// see if there's one left by a thread that's gone
+		std::list<CKLockProfilerTable *>::iterator	i;
+		for (i = tables()->begin(); i != tables()->end(); ++i) {
+			if ((*i)->inUse == 0) {
+				table = *i;
+				break;
+			}
+		}
+		// ...and if not, make a new one
+		if (table == NULL) {
+			table = new CKLockProfilerTable();
+			memset(table, 0, sizeof(CKLockProfilerTable));
+			tables()->push_back(table);
+		}
+		table->inUse = 1;
+		pthread_mutex_unlock(&sTablesMutex);
+		pthread_setspecific(sTableKey, table);
+	}
+	return table;
+}
+
+
+/*
+ * These turn the profiling on and off for all the stack lockers in
+ * the process. Turning it off doesn't clear what's been recorded.
+ */
+void CKLockProfiler::enable()
+{
+	sEnabled = 1;
+}
+
+
+void CKLockProfiler::disable()
+{
+	sEnabled = 0;
+}
+
+
+/*
+ * This is the clock that the profiler uses - nanoseconds on the
+ * monotonic clock.
+ */
+unsigned long long CKLockProfiler::now()
+{
+#ifdef CLOCK_MONOTONIC
+	timespec	ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#else
+	timeval		tv;
+	gettimeofday(&tv, NULL);
+	return (unsigned long long)tv.tv_sec * 1000000000ULL + tv.tv_usec * 1000ULL;
+#endif
+}
+
+
+/*
+ * This records one lock at a call site. If 'aLine' is greater than
+ * zero, 'aSite' is the file name and that's the line. If it's zero,
+ * 'aSite' is a tag string, and if it's less than zero, 'aSite' is
+ * the address of the code that took the lock. The strings have to
+ * be constants - only the pointers are kept.
+ */
+void CKLockProfiler::record( const void *aSite, int aLine,
+							 unsigned long long aWaitNanos,
+							 unsigned long long aHoldNanos )
+{
+	CKLockProfilerTable		*table = myTable();
+
+	// find the site in the table with a simple open hash
+	unsigned long	hash = ((unsigned long)aSite >> 3) ^ ((unsigned long)aLine * 2654435761UL);
+	CKLockSiteStats	*stats = NULL;
+	for (int probe = 0; probe < CKLOCKPROFILER_SITES_PER_THREAD; ++probe) {
+		CKLockSiteStats	*s = &table->sites[(hash + probe) % CKLOCKPROFILER_SITES_PER_THREAD];
+		if (s->site == NULL) {
+			// the line goes in first so the report never sees half a key
+			s->line = aLine;
+			s->site = aSite;
+			stats = s;
+			break;
+		} else if ((s->site == aSite) && (s->line == aLine)) {
+			stats = s;
+			break;
+		}
+	}
+	if (stats == NULL) {
+		++table->dropped;
+		return;
+	}
+
+	++stats->count;
+	if (aWaitNanos > CKLOCKPROFILER_CONTENDED_NANOS) {
+		++stats->contended;
+	}
+	stats->waitNanos += aWaitNanos;
+	stats->holdNanos += aHoldNanos;
+	if (aWaitNanos > stats->maxWaitNanos) {
+		stats->maxWaitNanos = aWaitNanos;
+	}
+}
+
+
+/*
+ * This method sets all the counts back to zero. Anything being
+ * recorded by another thread right as this is done may be lost.
+ */
+void CKLockProfiler::reset()
+{
+	pthread_mutex_lock(&sTablesMutex);
+	std::list<CKLockProfilerTable *>::iterator	i;
+	for (i = tables()->begin(); i != tables()->end(); ++i) {
+		for (int s = 0; s < CKLOCKPROFILER_SITES_PER_THREAD; ++s) {
+			CKLockSiteStats	& stats = (*i)->sites[s];
+			stats.count = 0;
+			stats.contended = 0;
+			stats.waitNanos = 0;
+			stats.holdNanos = 0;
+			stats.maxWaitNanos = 0;
+		}
+		(*i)->dropped = 0;
+	}
+	pthread_mutex_unlock(&sTablesMutex);
+}
+
+
+/*
+ * This method returns a report of the call sites with the most
+ * total waiting time, the most first - each with the number of
+ * locks, how many were contended, and the total and longest wait
+ * and total hold times.
+ */
+CKString CKLockProfiler::getReport( int aTopCount )
+{
+	// add up all the threads' tables by site
+	std::map<std::pair<const void *, int>, CKLockSiteTotals>	sums;
+	unsigned long		dropped = 0;
+	pthread_mutex_lock(&sTablesMutex);
+	std::list<CKLockProfilerTable *>::iterator	i;
+	for (i = tables()->begin(); i != tables()->end(); ++i) {
+		for (int s = 0; s < CKLOCKPROFILER_SITES_PER_THREAD; ++s) {
+			const CKLockSiteStats	& stats = (*i)->sites[s];
+			if ((stats.site == NULL) || (stats.count == 0)) {
+				continue;
+			}
+			const void			*site = stats.site;
+			int					line = stats.line;
+			CKLockSiteTotals	& tot = sums[std::make_pair(site, line)];
+			if (tot.count == 0) {
+				tot.site = site;
+				tot.line = line;
+			}
+			tot.count += stats.count;
+			tot.contended += stats.contended;
+			tot.waitNanos += stats.waitNanos;
+			tot.holdNanos += stats.holdNanos;
+			if (stats.maxWaitNanos > tot.maxWaitNanos) {
+				tot.maxWaitNanos = stats.maxWaitNanos;
+			}
+		}
+		dropped += (*i)->dropped;
+	}
+	pthread_mutex_unlock(&sTablesMutex);
+
+	// sort them by the waiting
+	std::vector<CKLockSiteTotals>	sites;
+	std::map<std::pair<const void *, int>, CKLockSiteTotals>::iterator	j;
+	for (j = sums.begin(); j != sums.end(); ++j) {
+		sites.push_back(j->second);
+	}
+	std::sort(sites.begin(), sites.end(), moreWaiting);
+
+	// ...and write out the top ones
+	std::ostringstream	buff;
+	buff << std::setw(12) << "locks" << std::setw(12) << "contended" <<
+		std::setw(14) << "wait(usec)" << std::setw(14) << "max(usec)" <<
+		std::setw(14) << "hold(usec)" << "  site" << std::endl;
+	for (int n = 0; (n < (int)sites.size()) && ((aTopCount <= 0) || (n < aTopCount)); ++n) {
+		const CKLockSiteTotals	& tot = sites[n];
+		buff << std::setw(12) << tot.count << std::setw(12) << tot.contended <<
+			std::setw(14) << tot.waitNanos/1000 << std::setw(14) << tot.maxWaitNanos/1000 <<
+			std::setw(14) << tot.holdNanos/1000 << "  ";
+		if (tot.line > 0) {
+			buff << (const char *)tot.site << ":" << tot.line;
+		} else if (tot.line == 0) {
+			buff << (const char *)tot.site;
+		} else {
+			// it's the address of the code, so see what function it's in
+			bool	named = false;
+#ifdef __GNUC__
+			Dl_info		info;
+			if ((dladdr(tot.site, &info) != 0) && (info.dli_sname != NULL)) {
+				buff << info.dli_sname << "+0x" << std::hex <<
+					((const char *)tot.site - (const char *)info.dli_saddr) << std::dec;
+				named = true;
+			}
+#endif
+			if (!named) {
+				buff << tot.site;
+			}
+		}
+		buff << std::endl;
+	}
+	if (dropped > 0) {
+		buff << "(" << dropped << " locks at sites past the per-thread limit were not counted)" <<
+			std::endl;
+	}
+
+	return CKString(buff.str());
+}
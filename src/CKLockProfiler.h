@@ -0,0 +1,100 @@
+/*
+ * CKLockProfiler.h - this file defines a simple profiler for the locks taken
+ *                    with a CKStackLocker. When it's enabled, every stack
+ *                    locker records how long it waited for its lock and how
+ *                    long it held it, against its call site - the __FILE__
+ *                    and __LINE__ or tag it was given, or the address of the
+ *                    code that created it. The report then lists the sites
+ *                    with the most waiting, so we can see which locks in the
+ *                    library are limiting the scaling without needing an
+ *                    external profiler.
+ *
+ *                    Each thread records into its own table of sites, so the
+ *                    recording doesn't need any locks at all, and the report
+ *                    adds up all the tables. When it's disabled - which is
+ *                    the default - the cost to a stack locker is a single
+ *                    test of a flag.
+ *
+ * $Id$
+ */
+#ifndef __CKLOCKPROFILER_H
+#define __CKLOCKPROFILER_H
+
+//	System Headers
+
+//	Third-Party Headers
+
+//	Other Headers
+
+//	Forward Declarations
+class CKString;
+
+//	Public Constants
+/*
+ * This is the number of different call sites each thread can record. A
+ * thread that locks at more sites than this counts the rest as 'dropped'.
+ */
+#define	CKLOCKPROFILER_SITES_PER_THREAD			1024
+/*
+ * A lock that took longer than this (in nanoseconds) to get is counted as
+ * contended - anything less is just the cost of taking a free lock.
+ */
+#define	CKLOCKPROFILER_CONTENDED_NANOS			1000
+
+//	Public Datatypes
+
+//	Public Data Constants
+
+
+/*
+ * This is the main class definition. It's all static as there is only
+ * one profiler in the process.
+ */
+class CKLockProfiler
+{
+	public:
+		/*
+		 * These turn the profiling on and off for all the stack lockers in
+		 * the process. Turning it off doesn't clear what's been recorded.
+		 */
+		static void enable();
+		static void disable();
+		static inline bool isEnabled()
+		{
+			return (sEnabled != 0);
+		}
+
+		/*
+		 * This is the clock that the profiler uses - nanoseconds on the
+		 * monotonic clock.
+		 */
+		static unsigned long long now();
+		/*
+		 * This records one lock at a call site. If 'aLine' is greater than
+		 * zero, 'aSite' is the file name and that's the line. If it's zero,
+		 * 'aSite' is a tag string, and if it's less than zero, 'aSite' is
+		 * the address of the code that took the lock. The strings have to
+		 * be constants - only the pointers are kept.
+		 */
+		static void record( const void *aSite, int aLine,
+							unsigned long long aWaitNanos,
+							unsigned long long aHoldNanos );
+		/*
+		 * This method sets all the counts back to zero. Anything being
+		 * recorded by another thread right as this is done may be lost.
+		 */
+		static void reset();
+		/*
+		 * This method returns a report of the call sites with the most
+		 * total waiting time, the most first - each with the number of
+		 * locks, how many were contended, and the total and longest wait
+		 * and total hold times.
+		 */
+		static CKString getReport( int aTopCount = 20 );
+
+	private:
+		// this is the flag that turns it all on
+		static volatile int		sEnabled;
+};
+
+#endif	// __CKLOCKPROFILER_H
@@ -0,0 +1,1196 @@
+/*
+ * CKMappedTable.cpp - this file implements a read-only view of a CKTable
+ *                     that's been written to a file in a binary format that
+ *                     can be memory-mapped. Opening one is just checking the
+ *                     header and mapping the file - nothing is read or
+ *                     decoded - so even a table of gigabytes opens in a few
+ *                     milliseconds, the pages come in from the disk as
+ *                     they're used, and all the processes that open the same
+ *                     file share the same pages of memory. The columns of
+ *                     numbers are right there as arrays of doubles, and the
+ *                     strings are read right out of the file.
+ *
+ * $Id$
+ */
+
+//	System Headers
+#include <string>
+#include <vector>
+#include <sstream>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+//	Third-Party Headers
+#include <CKException.h>
+
+//	Other Headers
+#include "CKMappedTable.h"
+
+//	Forward Declarations
+
+//	Private Constants
+/*
+ * These start every table file - the magic bytes, the version of the
+ * format this code writes and reads, and a number that's only read
+ * back the same on a machine with the same byte order. The arrays in
+ * the file are in the byte order of the machine that wrote it, so they
+ * can be used right where they are.
+ */
+#define	CKMAPPEDTABLE_MAGIC			"CKTABLE"
+#define	CKMAPPEDTABLE_VERSION		1
+#define	CKMAPPEDTABLE_BYTE_ORDER	0x01020304
+/*
+ * These are how each column is stored. A column of just numbers, dates
+ * or strings is an array of doubles, 64-bit dates, or offsets into the
+ * string heap, with a bitmap of the cells that aren't empty. A mixed
+ * column has the type of each cell, and eight bytes for each that hold
+ * its number, date, or the offset of its string - or the binary code of
+ * anything else - in the heap.
+ */
+#define	CKMAPPEDTABLE_NUMBER_COLUMN	1
+#define	CKMAPPEDTABLE_DATE_COLUMN	2
+#define	CKMAPPEDTABLE_STRING_COLUMN	3
+#define	CKMAPPEDTABLE_MIXED_COLUMN	4
+/*
+ * This is how much the writer holds before it's written to the file.
+ */
+#define	CKMAPPEDTABLE_BUFFER_SIZE	(1024 * 1024)
+
+//	Private Datatypes
+/*
+ * This is the header at the start of the file. Everything in the file
+ * is found from here - each offset is from the start of the file, and
+ * is a multiple of eight, so the arrays are all aligned. The strings
+ * in the heap are each a 32-bit length, the bytes, and a NULL, and the
+ * offsets to them are from the start of the heap. The indexes are open
+ * hash tables of the row, or column, plus one - zero is an empty slot.
+ */
+struct CKMappedTableHeader {
+	char				magic[8];
+	unsigned int		version;
+	unsigned int		byteOrder;
+	unsigned long long	fileSize;
+	unsigned long long	numRows;
+	unsigned long long	numColumns;
+	unsigned long long	columnsOffset;
+	unsigned long long	labelsOffset;
+	unsigned long long	headersOffset;
+	unsigned long long	labelIndexOffset;
+	unsigned long long	labelSlots;
+	unsigned long long	headerIndexOffset;
+	unsigned long long	headerSlots;
+	unsigned long long	heapOffset;
+	unsigned long long	heapSize;
+};
+
+
+/*
+ * This is the block for each column - how it's stored, where its array
+ * of values is, and where its bitmap - or the types of its cells, for
+ * a mixed column - is.
+ */
+struct CKMappedTableColumn {
+	unsigned int		kind;
+	unsigned int		reserved;
+	unsigned long long	dataOffset;
+	unsigned long long	extraOffset;
+};
+
+
+/*
+ * This is the FNV-1a hash of the bytes for the indexes in the file.
+ */
+static unsigned int hashOfBytes( const char *aBytes, int aLength )
+{
+	unsigned int	hash = 2166136261U;
+	for (int i = 0; i < aLength; ++i) {
+		hash = (hash ^ (unsigned char)aBytes[i]) * 16777619U;
+	}
+	return hash;
+}
+
+
+/*
+ * This returns the number of slots for an index of 'aCount' keys - a
+ * power of two that's at least twice as many, so it's never more than
+ * half full.
+ */
+static unsigned long long slotsFor( int aCount )
+{
+	unsigned long long	slots = 2;
+	while (slots < 2 * (unsigned long long)aCount) {
+		slots *= 2;
+	}
+	return slots;
+}
+
+
+/*
+ * This returns the number of bytes 'aLength' is from a multiple of eight.
+ */
+static int paddingFor( unsigned long long aLength )
+{
+	return (int)((8 - (aLength % 8)) % 8);
+}
+
+
+/*
+ * This returns the number of bytes a string takes in the heap.
+ */
+static unsigned long long heapSizeOf( int aLength )
+{
+	return 4 + (unsigned long long)aLength + 1;
+}
+
+
+/*
+ * This writes the file a piece at a time through a buffer, and keeps
+ * track of how much has been written, so the offsets in the header can
+ * be checked against where everything actually went.
+ */
+class CKMappedTableWriter
+{
+	public:
+		CKMappedTableWriter( int aFd, const CKString & aFileName ) :
+			mFd(aFd), mFileName(aFileName), mBuffer(), mOffset(0)
+		{
+			mBuffer.reserve(CKMAPPEDTABLE_BUFFER_SIZE);
+		}
+		void put( const void *aData, unsigned long long aLength )
+		{
+			const char	*data = (const char *)aData;
+			mOffset += aLength;
+			while (aLength > 0) {
+				unsigned long long	room = CKMAPPEDTABLE_BUFFER_SIZE - mBuffer.size();
+				unsigned long long	cnt = (aLength < room ? aLength : room);
+				mBuffer.append(data, (size_t)cnt);
+				data += cnt;
+				aLength -= cnt;
+				if (mBuffer.size() >= CKMAPPEDTABLE_BUFFER_SIZE) {
+					flush();
+				}
+			}
+		}
+		void putOffset( unsigned long long aValue )
+		{
+			put(&aValue, sizeof(aValue));
+		}
+		void putString( const char *aBytes, int aLength )
+		{
+			unsigned int	len = aLength;
+			put(&len, sizeof(len));
+			put(aBytes, aLength);
+			put("", 1);
+		}
+		void pad()
+		{
+			static const char	zeros[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+			put(zeros, paddingFor(mOffset));
+		}
+		unsigned long long getOffset() const
+		{
+			return mOffset;
+		}
+		void flush()
+		{
+			const char	*data = mBuffer.data();
+			size_t		left = mBuffer.size();
+			while (left > 0) {
+				ssize_t		cnt = ::write(mFd, data, left);
+				if (cnt < 0) {
+					if (errno == EINTR) {
+						continue;
+					}
+					std::ostringstream	msg;
+					msg << "CKMappedTableWriter::flush() - the table couldn't be "
+						"written to the file '" << mFileName << "': " << strerror(errno);
+					throw CKException(__FILE__, __LINE__, msg.str());
+				}
+				data += cnt;
+				left -= cnt;
+			}
+			mBuffer.clear();
+		}
+
+	private:
+		int						mFd;
+		CKString				mFileName;
+		std::string				mBuffer;
+		unsigned long long		mOffset;
+};
+
+
+/*
+ * This returns how the column of the table is stored - a dense column
+ * as what it is, and anything else as a column of numbers, dates or
+ * strings if that's all it has. A column that's all empty is just a
+ * column of numbers without any.
+ */
+static unsigned int kindOfColumn( const CKTable & aTable, int aCol )
+{
+	CKVariantType	type = aTable.getColumnType(aCol);
+	if (type == eNumberVariant) {
+		return CKMAPPEDTABLE_NUMBER_COLUMN;
+	} else if (type == eDateVariant) {
+		return CKMAPPEDTABLE_DATE_COLUMN;
+	}
+
+	int		rows = aTable.getNumRows();
+	type = eUnknownVariant;
+	for (int i = 0; i < rows; ++i) {
+		CKVariantType	t = aTable.getType(i, aCol);
+		if (t == eUnknownVariant) {
+			continue;
+		}
+		if (type == eUnknownVariant) {
+			type = t;
+		} else if (t != type) {
+			return CKMAPPEDTABLE_MIXED_COLUMN;
+		}
+	}
+	switch (type) {
+		case eUnknownVariant:
+		case eNumberVariant:
+			return CKMAPPEDTABLE_NUMBER_COLUMN;
+		case eDateVariant:
+			return CKMAPPEDTABLE_DATE_COLUMN;
+		case eStringVariant:
+			return CKMAPPEDTABLE_STRING_COLUMN;
+		default:
+			return CKMAPPEDTABLE_MIXED_COLUMN;
+	}
+}
+
+
+/*
+ * This returns the bytes a cell of a mixed column has in the heap - the
+ * string, or the binary code of anything that isn't a number or date.
+ * A cell that's neither has none.
+ */
+static bool heapBytesOfCell( const CKTable & aTable, int aRow, int aCol,
+							 std::string & aBytes )
+{
+	CKVariantType	type = aTable.getType(aRow, aCol);
+	if ((type == eUnknownVariant) || (type == eNumberVariant) || (type == eDateVariant)) {
+		return false;
+	}
+	if (type == eStringVariant) {
+		const CKString	*str = aTable.getStringValue(aRow, aCol);
+		aBytes.assign(str->c_str(), str->size());
+	} else {
+		aBytes = aTable.getValue(aRow, aCol).toBinary();
+	}
+	return true;
+}
+
+
+/*
+ * This builds the open hash index of the strings, and writes it out.
+ * A string that's there more than once is left with the last of them
+ * and, like the index of a CKTable, the empty ones aren't in it.
+ */
+static void writeIndex( CKMappedTableWriter & aWriter,
+						const std::vector<const CKString *> & aKeys,
+						unsigned long long aSlots )
+{
+	int							count = aKeys.size();
+	std::vector<unsigned int>	slots((size_t)aSlots, 0);
+	unsigned long long			mask = aSlots - 1;
+	for (int i = 0; i < count; ++i) {
+		const CKString		& key = *aKeys[i];
+		if (key.size() == 0) {
+			continue;
+		}
+		unsigned long long	s = hashOfBytes(key.c_str(), key.size()) & mask;
+		while ((slots[s] != 0) && (*aKeys[slots[s] - 1] != key)) {
+			s = (s + 1) & mask;
+		}
+		slots[s] = i + 1;
+	}
+	aWriter.put(&slots[0], aSlots * sizeof(unsigned int));
+	aWriter.pad();
+}
+
+
+/*
+ * This returns true if 'aCount' things of 'aSize' bytes each, starting
+ * at the offset, are all in a file of 'aFileSize' bytes - without ever
+ * overflowing on the way.
+ */
+static bool isInFile( unsigned long long anOffset, unsigned long long aCount,
+					  unsigned long long aSize, unsigned long long aFileSize )
+{
+	if ((anOffset % 8 != 0) || (anOffset > aFileSize)) {
+		return false;
+	}
+	return (aCount <= (aFileSize - anOffset) / aSize);
+}
+
+//	Private Data Constants
+
+
+/********************************************************
+ *
+ *                Constructors/Destructor
+ *
+ ********************************************************/
+/*
+ * This opens the file written by writeTable() and maps it into
+ * memory, read-only. If the file can't be opened, or isn't a
+ * table file this code can read, a CKException is thrown. The
+ * file stays open - and the view stays good - even if it's
+ * replaced by a new one while it's in use.
+ */
+CKMappedTable::CKMappedTable( const CKString & aFileName ) :
+	mFileName(aFileName),
+	mFd(-1),
+	mData(NULL),
+	mSize(0),
+	mHeader(NULL),
+	mColumns(NULL),
+	mNumRows(0),
+	mNumColumns(0)
+{
+	mFd = ::open(aFileName.c_str(), O_RDONLY);
+	if (mFd < 0) {
+		std::ostringstream	msg;
+		msg << "CKMappedTable::CKMappedTable(const CKString &) - the file '" <<
+			aFileName << "' couldn't be opened: " << strerror(errno);
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+	mapFile();
+}
+
+
+/*
+ * This is the standard copy constructor and needs to be in every
+ * class to make sure that we don't have too many things running
+ * around. The copy maps the same open file, so it's the same
+ * table even if the file has been replaced since.
+ */
+CKMappedTable::CKMappedTable( const CKMappedTable & anOther ) :
+	mFileName(),
+	mFd(-1),
+	mData(NULL),
+	mSize(0),
+	mHeader(NULL),
+	mColumns(NULL),
+	mNumRows(0),
+	mNumColumns(0)
+{
+	// let the operator=() do all the work for me
+	*this = anOther;
+}
+
+
+/*
+ * This is the standard destructor and needs to be virtual to make
+ * sure that if we subclass off this, the right destructor will be
+ * called.
+ */
+CKMappedTable::~CKMappedTable()
+{
+	unmapFile();
+}
+
+
+/*
+ * When we want to process the result of an equality we need to
+ * make sure that we do this right by always having an equals
+ * operator on all classes.
+ */
+CKMappedTable & CKMappedTable::operator=( const CKMappedTable & anOther )
+{
+	// make sure that we don't do this to ourselves
+	if (this != & anOther) {
+		unmapFile();
+		mFileName = anOther.mFileName;
+		mFd = dup(anOther.mFd);
+		if (mFd < 0) {
+			std::ostringstream	msg;
+			msg << "CKMappedTable::operator=(const CKMappedTable &) - the file '" <<
+				mFileName << "' couldn't be opened again: " << strerror(errno);
+			throw CKException(__FILE__, __LINE__, msg.str());
+		}
+		mapFile();
+	}
+	return *this;
+}
+
+
+/********************************************************
+ *
+ *                File Methods
+ *
+ ********************************************************/
+/*
+ * This writes the table to the file in the format that can be
+ * mapped - a header, the row labels and column headers with a
+ * hash index of each, a block for each column, and then all the
+ * strings. A column of just numbers, dates or strings is written
+ * as an array of them with a bitmap of the cells that aren't
+ * empty, and anything else is written cell by cell with its type.
+ * It's written a piece at a time - never all in memory - to a new
+ * file that then takes the name, so a process that has the old
+ * one open is never left with a half-written table.
+ */
+void CKMappedTable::writeTable( const CKTable & aTable, const CKString & aFileName )
+{
+	int		rows = aTable.getNumRows();
+	int		cols = aTable.getNumColumns();
+	if ((rows < 0) || (cols < 0)) {
+		std::ostringstream	msg;
+		msg << "CKMappedTable::writeTable(const CKTable &, const CKString &) - "
+			"there is no currently defined table structure in the table, so "
+			"there's nothing to write. Please create the table before calling "
+			"this method.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	/*
+	 * Everything but the strings has a size we know, so the header and
+	 * the column blocks can be filled in right now. The strings all go
+	 * in the heap at the end, in the order they're come to.
+	 */
+	CKMappedTableHeader		header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, CKMAPPEDTABLE_MAGIC, sizeof(CKMAPPEDTABLE_MAGIC));
+	header.version = CKMAPPEDTABLE_VERSION;
+	header.byteOrder = CKMAPPEDTABLE_BYTE_ORDER;
+	header.numRows = rows;
+	header.numColumns = cols;
+	header.labelSlots = slotsFor(rows);
+	header.headerSlots = slotsFor(cols);
+
+	unsigned long long	off = sizeof(header) + paddingFor(sizeof(header));
+	header.columnsOffset = off;
+	off += cols * sizeof(CKMappedTableColumn);
+	off += paddingFor(off);
+	header.labelsOffset = off;
+	off += rows * sizeof(unsigned long long);
+	header.headersOffset = off;
+	off += cols * sizeof(unsigned long long);
+	header.labelIndexOffset = off;
+	off += header.labelSlots * sizeof(unsigned int);
+	off += paddingFor(off);
+	header.headerIndexOffset = off;
+	off += header.headerSlots * sizeof(unsigned int);
+	off += paddingFor(off);
+
+	std::vector<CKMappedTableColumn>	columns(cols);
+	unsigned long long					bitmapSize = (rows + 7) / 8;
+	for (int j = 0; j < cols; ++j) {
+		CKMappedTableColumn	& column = columns[j];
+		memset(&column, 0, sizeof(column));
+		column.kind = kindOfColumn(aTable, j);
+		column.dataOffset = off;
+		off += rows * sizeof(unsigned long long);
+		column.extraOffset = off;
+		off += (column.kind == CKMAPPEDTABLE_MIXED_COLUMN ? rows : bitmapSize);
+		off += paddingFor(off);
+	}
+	header.heapOffset = off;
+
+	// the new file is written next to the old one, and takes its place at the end
+	CKString	tempName(aFileName);
+	tempName.append(".tmp");
+	int			fd = ::open(tempName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		std::ostringstream	msg;
+		msg << "CKMappedTable::writeTable(const CKTable &, const CKString &) - "
+			"the file '" << tempName << "' couldn't be created: " << strerror(errno);
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	try {
+		CKMappedTableWriter		out(fd, tempName);
+		unsigned long long		heap = 0;
+		std::vector<const CKString *>	labels(rows);
+		std::vector<const CKString *>	headers(cols);
+		for (int i = 0; i < rows; ++i) {
+			labels[i] = &aTable.getRowLabel(i);
+		}
+		for (int j = 0; j < cols; ++j) {
+			headers[j] = &aTable.getColumnHeader(j);
+		}
+
+		// the header is written again at the end, once the heap is done
+		out.put(&header, sizeof(header));
+		out.pad();
+		if (cols > 0) {
+			out.put(&columns[0], cols * sizeof(CKMappedTableColumn));
+		}
+		out.pad();
+		for (int i = 0; i < rows; ++i) {
+			out.putOffset(heap);
+			heap += heapSizeOf(labels[i]->size());
+		}
+		for (int j = 0; j < cols; ++j) {
+			out.putOffset(heap);
+			heap += heapSizeOf(headers[j]->size());
+		}
+		writeIndex(out, labels, header.labelSlots);
+		writeIndex(out, headers, header.headerSlots);
+
+		/*
+		 * Each column is written from its dense array, if it has one, and
+		 * a cell at a time if it doesn't.
+		 */
+		std::vector<unsigned char>	bits((size_t)bitmapSize);
+		std::string					bytes;
+		for (int j = 0; j < cols; ++j) {
+			const CKMappedTableColumn	& column = columns[j];
+			if ((column.kind == CKMAPPEDTABLE_NUMBER_COLUMN) &&
+				(aTable.getDoubleColumn(j) != NULL)) {
+				out.put(aTable.getDoubleColumn(j), rows * sizeof(double));
+				out.put(aTable.getColumnValidity(j), bitmapSize);
+			} else if (column.kind == CKMAPPEDTABLE_MIXED_COLUMN) {
+				std::vector<signed char>	types(rows);
+				for (int i = 0; i < rows; ++i) {
+					unsigned long long	slot = 0;
+					types[i] = aTable.getType(i, j);
+					if (types[i] == eNumberVariant) {
+						double	x = aTable.getDoubleValue(i, j);
+						memcpy(&slot, &x, sizeof(x));
+					} else if (types[i] == eDateVariant) {
+						long long	d = aTable.getDateValue(i, j);
+						memcpy(&slot, &d, sizeof(d));
+					} else if (heapBytesOfCell(aTable, i, j, bytes)) {
+						slot = heap;
+						heap += heapSizeOf(bytes.size());
+					}
+					out.putOffset(slot);
+				}
+				if (rows > 0) {
+					out.put(&types[0], rows);
+				}
+			} else {
+				bits.assign(bits.size(), 0);
+				const long	*dates = aTable.getDateColumn(j);
+				for (int i = 0; i < rows; ++i) {
+					unsigned long long	slot = 0;
+					if ((column.kind == CKMAPPEDTABLE_DATE_COLUMN) && (dates != NULL)) {
+						if ((aTable.getColumnValidity(j)[i >> 3] >> (i & 7)) & 1) {
+							long long	d = dates[i];
+							memcpy(&slot, &d, sizeof(d));
+							bits[i >> 3] |= (1 << (i & 7));
+						}
+					} else if (aTable.getType(i, j) == eUnknownVariant) {
+						// an empty cell is just a clear bit
+					} else if (column.kind == CKMAPPEDTABLE_NUMBER_COLUMN) {
+						double	x = aTable.getDoubleValue(i, j);
+						memcpy(&slot, &x, sizeof(x));
+						bits[i >> 3] |= (1 << (i & 7));
+					} else if (column.kind == CKMAPPEDTABLE_DATE_COLUMN) {
+						long long	d = aTable.getDateValue(i, j);
+						memcpy(&slot, &d, sizeof(d));
+						bits[i >> 3] |= (1 << (i & 7));
+					} else {
+						slot = heap;
+						heap += heapSizeOf(aTable.getStringValue(i, j)->size());
+						bits[i >> 3] |= (1 << (i & 7));
+					}
+					out.putOffset(slot);
+				}
+				if (bitmapSize > 0) {
+					out.put(&bits[0], bitmapSize);
+				}
+			}
+			out.pad();
+		}
+
+		// now all the strings, in just the order their offsets were given out
+		if (out.getOffset() != header.heapOffset) {
+			std::ostringstream	msg;
+			msg << "CKMappedTable::writeTable(const CKTable &, const CKString &) - "
+				"the columns ended at " << out.getOffset() << " and not " <<
+				header.heapOffset << ". This is a serious problem in the writer.";
+			throw CKException(__FILE__, __LINE__, msg.str());
+		}
+		for (int i = 0; i < rows; ++i) {
+			out.putString(labels[i]->c_str(), labels[i]->size());
+		}
+		for (int j = 0; j < cols; ++j) {
+			out.putString(headers[j]->c_str(), headers[j]->size());
+		}
+		for (int j = 0; j < cols; ++j) {
+			unsigned int	kind = columns[j].kind;
+			for (int i = 0; (kind == CKMAPPEDTABLE_STRING_COLUMN) && (i < rows); ++i) {
+				if (aTable.getType(i, j) == eStringVariant) {
+					const CKString	*str = aTable.getStringValue(i, j);
+					out.putString(str->c_str(), str->size());
+				}
+			}
+			for (int i = 0; (kind == CKMAPPEDTABLE_MIXED_COLUMN) && (i < rows); ++i) {
+				if (heapBytesOfCell(aTable, i, j, bytes)) {
+					out.putString(bytes.data(), bytes.size());
+				}
+			}
+		}
+		header.heapSize = heap;
+		header.fileSize = header.heapOffset + heap;
+		out.pad();
+		out.flush();
+		if (out.getOffset() != header.fileSize + paddingFor(header.fileSize)) {
+			std::ostringstream	msg;
+			msg << "CKMappedTable::writeTable(const CKTable &, const CKString &) - "
+				"the strings ended at " << out.getOffset() << " and not " <<
+				header.fileSize << ". This is a serious problem in the writer.";
+			throw CKException(__FILE__, __LINE__, msg.str());
+		}
+		header.fileSize = out.getOffset();
+
+		// the header has it all now, so it goes back at the start
+		if ((::lseek(fd, 0, SEEK_SET) != 0) ||
+			(::write(fd, &header, sizeof(header)) != (ssize_t)sizeof(header)) ||
+			(::fsync(fd) != 0)) {
+			std::ostringstream	msg;
+			msg << "CKMappedTable::writeTable(const CKTable &, const CKString &) - "
+				"the header couldn't be written to the file '" << tempName <<
+				"': " << strerror(errno);
+			throw CKException(__FILE__, __LINE__, msg.str());
+		}
+	} catch (...) {
+		::close(fd);
+		::unlink(tempName.c_str());
+		throw;
+	}
+
+	::close(fd);
+	if (::rename(tempName.c_str(), aFileName.c_str()) != 0) {
+		std::ostringstream	msg;
+		msg << "CKMappedTable::writeTable(const CKTable &, const CKString &) - "
+			"the file '" << tempName << "' couldn't be renamed to '" <<
+			aFileName << "': " << strerror(errno);
+		::unlink(tempName.c_str());
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+}
+
+
+/*
+ * These return the name of the file that was opened, and the size
+ * of it in bytes.
+ */
+const CKString & CKMappedTable::getFileName() const
+{
+	return mFileName;
+}
+
+
+unsigned long long CKMappedTable::getFileSize() const
+{
+	return mSize;
+}
+
+
+/********************************************************
+ *
+ *                Accessor Methods
+ *
+ ********************************************************/
+/*
+ * These return the size of the table.
+ */
+int CKMappedTable::getNumRows() const
+{
+	return mNumRows;
+}
+
+
+int CKMappedTable::getNumColumns() const
+{
+	return mNumColumns;
+}
+
+
+/*
+ * These return the column header and the row label, and the index
+ * of a header or label - or -1 if it's not in the table. The look
+ * ups use the hash indexes in the file. If a label or header is
+ * there more than once, the index has the last of them, and an
+ * empty one is never found - just like a CKTable.
+ */
+CKString CKMappedTable::getColumnHeader( int aCol ) const
+{
+	checkColumn(aCol, "getColumnHeader(int)");
+	const unsigned long long	*offsets =
+			(const unsigned long long *)(mData + mHeader->headersOffset);
+	int							len = 0;
+	const char					*str = heapString(offsets[aCol], len);
+	return CKString(str, 0, len);
+}
+
+
+CKString CKMappedTable::getRowLabel( int aRow ) const
+{
+	// first, make sure we have the row they want
+	if ((aRow < 0) || (aRow >= mNumRows)) {
+		std::ostringstream	msg;
+		msg << "CKMappedTable::getRowLabel(int) - the provided row: " << aRow <<
+			" lies outside the table: " << mNumRows << " by " << mNumColumns;
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	const unsigned long long	*offsets =
+			(const unsigned long long *)(mData + mHeader->labelsOffset);
+	int							len = 0;
+	const char					*str = heapString(offsets[aRow], len);
+	return CKString(str, 0, len);
+}
+
+
+int CKMappedTable::getColumnForHeader( const CKString & aHeader ) const
+{
+	return findInIndex(mHeader->headerIndexOffset, mHeader->headerSlots,
+					   mHeader->headersOffset, mHeader->numColumns, aHeader);
+}
+
+
+int CKMappedTable::getRowForLabel( const CKString & aLabel ) const
+{
+	return findInIndex(mHeader->labelIndexOffset, mHeader->labelSlots,
+					   mHeader->labelsOffset, mHeader->numRows, aLabel);
+}
+
+
+/*
+ * These return the type of the value in the cell, and the value
+ * itself. Like the CKTable, asking for a number, date or string
+ * from a cell that doesn't hold one throws a CKException. The
+ * string is right in the mapped file, so it's good as long as
+ * this view is - and it's the bytes of the CKString that was
+ * written, with a NULL after them.
+ */
+CKVariantType CKMappedTable::getType( int aRow, int aCol ) const
+{
+	checkCell(aRow, aCol, "getType(int, int)");
+
+	const CKMappedTableColumn	& column = mColumns[aCol];
+	const unsigned char			*extra = (const unsigned char *)(mData + column.extraOffset);
+	if (column.kind == CKMAPPEDTABLE_MIXED_COLUMN) {
+		// the types are signed, as an empty cell is -1
+		return (CKVariantType)(signed char)extra[aRow];
+	}
+	if (((extra[aRow >> 3] >> (aRow & 7)) & 1) == 0) {
+		return eUnknownVariant;
+	}
+	switch (column.kind) {
+		case CKMAPPEDTABLE_NUMBER_COLUMN:	return eNumberVariant;
+		case CKMAPPEDTABLE_DATE_COLUMN:		return eDateVariant;
+		default:							return eStringVariant;
+	}
+}
+
+
+double CKMappedTable::getDoubleValue( int aRow, int aCol ) const
+{
+	// make sure the type matches - that checks the cell, too
+	if (getType(aRow, aCol) != eNumberVariant) {
+		std::ostringstream	msg;
+		msg << "CKMappedTable::getDoubleValue(int, int) - the provided location: " <<
+			aRow << ", " << aCol << " does not contain a numeric value: " <<
+			getValueAsString(aRow, aCol);
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	double	retval;
+	memcpy(&retval, mData + mColumns[aCol].dataOffset + aRow * sizeof(double), sizeof(double));
+	return retval;
+}
+
+
+long CKMappedTable::getDateValue( int aRow, int aCol ) const
+{
+	// make sure the type matches - that checks the cell, too
+	if (getType(aRow, aCol) != eDateVariant) {
+		std::ostringstream	msg;
+		msg << "CKMappedTable::getDateValue(int, int) - the provided location: " <<
+			aRow << ", " << aCol << " does not contain a date value: " <<
+			getValueAsString(aRow, aCol);
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	long long	retval;
+	memcpy(&retval, mData + mColumns[aCol].dataOffset + aRow * sizeof(long long),
+		   sizeof(long long));
+	return (long)retval;
+}
+
+
+const char *CKMappedTable::getStringValue( int aRow, int aCol ) const
+{
+	// make sure the type matches - that checks the cell, too
+	if (getType(aRow, aCol) != eStringVariant) {
+		std::ostringstream	msg;
+		msg << "CKMappedTable::getStringValue(int, int) - the provided location: " <<
+			aRow << ", " << aCol << " does not contain a string value: " <<
+			getValueAsString(aRow, aCol);
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	const unsigned long long	*offsets =
+			(const unsigned long long *)(mData + mColumns[aCol].dataOffset);
+	int							len = 0;
+	return heapString(offsets[aRow], len);
+}
+
+
+/*
+ * These return a copy of the value in the cell, and the value as
+ * a string, just like the CKTable. An empty cell is an empty
+ * variant, and an empty string.
+ */
+CKVariant CKMappedTable::getValue( int aRow, int aCol ) const
+{
+	CKVariant		retval;
+	CKVariantType	type = getType(aRow, aCol);
+	switch (type) {
+		case eUnknownVariant:
+			break;
+		case eNumberVariant:
+			retval.setDoubleValue(getDoubleValue(aRow, aCol));
+			break;
+		case eDateVariant:
+			retval.setDateValue(getDateValue(aRow, aCol));
+			break;
+		default:
+			{
+				const unsigned long long	*offsets =
+						(const unsigned long long *)(mData + mColumns[aCol].dataOffset);
+				int							len = 0;
+				const char					*bytes = heapString(offsets[aRow], len);
+				if (type == eStringVariant) {
+					CKString	str(bytes, 0, len);
+					retval.setStringValue(&str);
+				} else {
+					retval.fromBinary(bytes, len);
+				}
+			}
+			break;
+	}
+	return retval;
+}
+
+
+CKString CKMappedTable::getValueAsString( int aRow, int aCol ) const
+{
+	return getValue(aRow, aCol).getValueAsString();
+}
+
+
+/********************************************************
+ *
+ *                Column Methods
+ *
+ ********************************************************/
+/*
+ * This returns the type of the column as it's stored in the file
+ * - eNumberVariant, eDateVariant or eStringVariant for a column of
+ * just those, and eUnknownVariant for one with a mix of values.
+ */
+CKVariantType CKMappedTable::getColumnType( int aCol ) const
+{
+	checkColumn(aCol, "getColumnType(int)");
+	switch (mColumns[aCol].kind) {
+		case CKMAPPEDTABLE_NUMBER_COLUMN:	return eNumberVariant;
+		case CKMAPPEDTABLE_DATE_COLUMN:		return eDateVariant;
+		case CKMAPPEDTABLE_STRING_COLUMN:	return eStringVariant;
+		default:							return eUnknownVariant;
+	}
+}
+
+
+/*
+ * These return the arrays of a column of numbers - right in the
+ * mapped file - so it can be scanned without going through the
+ * accessors, just like the columns of a CKTable. There are
+ * getNumRows() values, and row i has one if bit (i % 8) of byte
+ * (i / 8) of the bitmap is set. If the column isn't a column of
+ * numbers, they return NULL.
+ */
+const double *CKMappedTable::getDoubleColumn( int aCol ) const
+{
+	checkColumn(aCol, "getDoubleColumn(int)");
+	if (mColumns[aCol].kind != CKMAPPEDTABLE_NUMBER_COLUMN) {
+		return NULL;
+	}
+	return (const double *)(mData + mColumns[aCol].dataOffset);
+}
+
+
+const unsigned char *CKMappedTable::getColumnValidity( int aCol ) const
+{
+	checkColumn(aCol, "getColumnValidity(int)");
+	if (mColumns[aCol].kind != CKMAPPEDTABLE_NUMBER_COLUMN) {
+		return NULL;
+	}
+	return (const unsigned char *)(mData + mColumns[aCol].extraOffset);
+}
+
+
+/*
+ * This makes a CKTable - columnar, with its columns of numbers
+ * and dates dense - of all the values in the file, for when the
+ * table has to be changed.
+ */
+CKTable CKMappedTable::getTable() const
+{
+	// a table with no rows is made with one, and then that's dropped
+	CKTable		retval((mNumRows > 0 ? mNumRows : 1), mNumColumns);
+	retval.setColumnar(true);
+	for (int j = 0; j < mNumColumns; ++j) {
+		CKVariantType	type = getColumnType(j);
+		if ((type == eNumberVariant) || (type == eDateVariant)) {
+			retval.setColumnType(j, type);
+		}
+		retval.setColumnHeader(j, getColumnHeader(j));
+	}
+	for (int i = 0; i < mNumRows; ++i) {
+		retval.setRowLabel(i, getRowLabel(i));
+	}
+
+	for (int j = 0; j < mNumColumns; ++j) {
+		switch (getColumnType(j)) {
+			case eNumberVariant:
+				{
+					const double		*values = getDoubleColumn(j);
+					const unsigned char	*valid = getColumnValidity(j);
+					for (int i = 0; i < mNumRows; ++i) {
+						if ((valid[i >> 3] >> (i & 7)) & 1) {
+							retval.setDoubleValue(i, j, values[i]);
+						}
+					}
+				}
+				break;
+			case eDateVariant:
+				for (int i = 0; i < mNumRows; ++i) {
+					if (getType(i, j) == eDateVariant) {
+						retval.setDateValue(i, j, getDateValue(i, j));
+					}
+				}
+				break;
+			default:
+				for (int i = 0; i < mNumRows; ++i) {
+					if (getType(i, j) != eUnknownVariant) {
+						retval.setValue(i, j, getValue(i, j));
+					}
+				}
+				break;
+		}
+	}
+
+	if (mNumRows == 0) {
+		retval.selectRows(CKVector<int>());
+	}
+	return retval;
+}
+
+
+/********************************************************
+ *
+ *                Private Methods
+ *
+ ********************************************************/
+/*
+ * These map the open file into memory and check that it's all
+ * there, and unmap and close it. mapFile() closes the file and
+ * throws a CKException if it's not a table file we can read.
+ */
+void CKMappedTable::mapFile()
+{
+	const char	*problem = NULL;
+	struct stat	info;
+	if (::fstat(mFd, &info) != 0) {
+		problem = strerror(errno);
+	} else if ((unsigned long long)info.st_size < sizeof(CKMappedTableHeader)) {
+		problem = "it's too small to be a table file";
+	} else if ((unsigned long long)info.st_size > (size_t)-1) {
+		problem = "it's too big to be mapped into memory";
+	} else {
+		mSize = info.st_size;
+		void	*data = ::mmap(NULL, (size_t)mSize, PROT_READ, MAP_SHARED, mFd, 0);
+		if (data == MAP_FAILED) {
+			problem = strerror(errno);
+		} else {
+			mData = (const char *)data;
+		}
+	}
+
+	/*
+	 * Everything in the file is checked against its size now, so none
+	 * of the accessors can ever read past the end of it - except for
+	 * the strings in the heap, which are each checked when they're read.
+	 */
+	const CKMappedTableHeader	*header = (const CKMappedTableHeader *)mData;
+	if (problem != NULL) {
+		// it's already been found
+	} else if (memcmp(header->magic, CKMAPPEDTABLE_MAGIC, sizeof(CKMAPPEDTABLE_MAGIC)) != 0) {
+		problem = "it's not a table file";
+	} else if (header->byteOrder != CKMAPPEDTABLE_BYTE_ORDER) {
+		problem = "it was written on a machine with a different byte order";
+	} else if (header->version != CKMAPPEDTABLE_VERSION) {
+		problem = "it's a version of the format this code can't read";
+	} else if (header->fileSize != mSize) {
+		problem = "it's not the size the header says it should be";
+	} else if ((header->numRows > INT_MAX) || (header->numColumns > INT_MAX)) {
+		problem = "the table is too big for a CKTable";
+	} else if ((header->labelSlots < 2 * header->numRows) ||
+			   ((header->labelSlots & (header->labelSlots - 1)) != 0) ||
+			   (header->headerSlots < 2 * header->numColumns) ||
+			   ((header->headerSlots & (header->headerSlots - 1)) != 0) ||
+			   !isInFile(header->columnsOffset, header->numColumns,
+						 sizeof(CKMappedTableColumn), mSize) ||
+			   !isInFile(header->labelsOffset, header->numRows, 8, mSize) ||
+			   !isInFile(header->headersOffset, header->numColumns, 8, mSize) ||
+			   !isInFile(header->labelIndexOffset, header->labelSlots, 4, mSize) ||
+			   !isInFile(header->headerIndexOffset, header->headerSlots, 4, mSize) ||
+			   !isInFile(header->heapOffset, header->heapSize, 1, mSize)) {
+		problem = "the header doesn't fit the file";
+	} else {
+		const CKMappedTableColumn	*columns =
+				(const CKMappedTableColumn *)(mData + header->columnsOffset);
+		for (unsigned long long j = 0; j < header->numColumns; ++j) {
+			unsigned int	kind = columns[j].kind;
+			if ((kind < CKMAPPEDTABLE_NUMBER_COLUMN) || (kind > CKMAPPEDTABLE_MIXED_COLUMN) ||
+				!isInFile(columns[j].dataOffset, header->numRows, 8, mSize) ||
+				!isInFile(columns[j].extraOffset, (kind == CKMAPPEDTABLE_MIXED_COLUMN ?
+							header->numRows : (header->numRows + 7) / 8), 1, mSize)) {
+				problem = "a column doesn't fit the file";
+				break;
+			}
+		}
+	}
+
+	if (problem != NULL) {
+		unmapFile();
+		std::ostringstream	msg;
+		msg << "CKMappedTable::mapFile() - the file '" << mFileName << "' couldn't "
+			"be used as a table because " << problem << ".";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	mHeader = header;
+	mColumns = (const CKMappedTableColumn *)(mData + header->columnsOffset);
+	mNumRows = (int)header->numRows;
+	mNumColumns = (int)header->numColumns;
+}
+
+
+void CKMappedTable::unmapFile()
+{
+	if (mData != NULL) {
+		::munmap((void *)mData, (size_t)mSize);
+		mData = NULL;
+	}
+	if (mFd >= 0) {
+		::close(mFd);
+		mFd = -1;
+	}
+	mSize = 0;
+	mHeader = NULL;
+	mColumns = NULL;
+	mNumRows = 0;
+	mNumColumns = 0;
+}
+
+
+/*
+ * These check that the cell, or column, is in the table, and
+ * throw a CKException for the method if it's not.
+ */
+void CKMappedTable::checkCell( int aRow, int aCol, const char *aMethod ) const
+{
+	if ((aRow < 0) || (aRow >= mNumRows) || (aCol < 0) || (aCol >= mNumColumns)) {
+		std::ostringstream	msg;
+		msg << "CKMappedTable::" << aMethod << " - the provided location: " <<
+			aRow << ", " << aCol << " lies outside the table: " << mNumRows <<
+			" by " << mNumColumns;
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+}
+
+
+void CKMappedTable::checkColumn( int aCol, const char *aMethod ) const
+{
+	if ((aCol < 0) || (aCol >= mNumColumns)) {
+		std::ostringstream	msg;
+		msg << "CKMappedTable::" << aMethod << " - the provided column: " <<
+			aCol << " lies outside the table: " << mNumRows << " by " << mNumColumns;
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+}
+
+
+/*
+ * This returns the string at the offset into the string heap -
+ * its bytes and their length - checking that it's all in the
+ * file.
+ */
+const char *CKMappedTable::heapString( unsigned long long anOffset, int & aLength ) const
+{
+	unsigned long long	size = mHeader->heapSize;
+	const char			*heap = mData + mHeader->heapOffset;
+	unsigned int		len = 0;
+	if ((size >= 5) && (anOffset <= size - 5)) {
+		memcpy(&len, heap + anOffset, sizeof(len));
+	}
+	if ((size < 5) || (anOffset > size - 5) || (len > size - 5 - anOffset) ||
+		(len > INT_MAX) || (heap[anOffset + 4 + len] != '\0')) {
+		std::ostringstream	msg;
+		msg << "CKMappedTable::heapString(unsigned long long, int &) - the string "
+			"at " << anOffset << " in the file '" << mFileName << "' isn't all "
+			"in the file. The file has been corrupted.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+	aLength = len;
+	return heap + anOffset + 4;
+}
+
+
+/*
+ * This looks up the string in one of the hash indexes in the file
+ * - of the 'aCount' labels or headers at 'aNamesOffset' - and
+ * returns the row, or column, it's for - or -1 if it's not there.
+ */
+int CKMappedTable::findInIndex( unsigned long long anIndexOffset,
+								unsigned long long aSlotCount,
+								unsigned long long aNamesOffset,
+								unsigned long long aCount,
+								const CKString & aKey ) const
+{
+	const unsigned int			*slots = (const unsigned int *)(mData + anIndexOffset);
+	const unsigned long long	*names = (const unsigned long long *)(mData + aNamesOffset);
+	unsigned long long			mask = aSlotCount - 1;
+	unsigned long long			s = hashOfBytes(aKey.c_str(), aKey.size()) & mask;
+	if (aKey.size() == 0) {
+		return -1;
+	}
+	// the index is never more than half full, so there's always an empty slot
+	for (unsigned long long probes = 0; probes < aSlotCount; ++probes) {
+		unsigned int	slot = slots[s];
+		if (slot == 0) {
+			return -1;
+		}
+		if (slot > aCount) {
+			std::ostringstream	msg;
+			msg << "CKMappedTable::findInIndex(...) - the index in the file '" <<
+				mFileName << "' has an entry for " << (slot - 1) << " in a table of " <<
+				aCount << ". The file has been corrupted.";
+			throw CKException(__FILE__, __LINE__, msg.str());
+		}
+		int			len = 0;
+		const char	*name = heapString(names[slot - 1], len);
+		if ((len == (int)aKey.size()) && (memcmp(name, aKey.c_str(), len) == 0)) {
+			return slot - 1;
+		}
+		s = (s + 1) & mask;
+	}
+	return -1;
+}
@@ -0,0 +1,221 @@
+/*
+ * CKMappedTable.h - this file defines a read-only view of a CKTable that's
+ *                   been written to a file in a binary format that can be
+ *                   memory-mapped. Opening one is just checking the header
+ *                   and mapping the file - nothing is read or decoded - so
+ *                   even a table of gigabytes opens in a few milliseconds,
+ *                   the pages come in from the disk as they're used, and
+ *                   all the processes that open the same file share the
+ *                   same pages of memory. The columns of numbers are right
+ *                   there as arrays of doubles, and the strings are read
+ *                   right out of the file.
+ *
+ * $Id$
+ */
+#ifndef __CKMAPPEDTABLE_H
+#define __CKMAPPEDTABLE_H
+
+//	System Headers
+
+//	Third-Party Headers
+
+//	Other Headers
+#include "CKTable.h"
+#include "CKString.h"
+#include "CKVariant.h"
+
+//	Forward Declarations
+struct CKMappedTableHeader;
+struct CKMappedTableColumn;
+
+//	Public Constants
+
+//	Public Datatypes
+
+//	Public Data Constants
+
+
+
+/*
+ * This is the main class definition.
+ */
+class CKMappedTable
+{
+	public:
+		/********************************************************
+		 *
+		 *                Constructors/Destructor
+		 *
+		 ********************************************************/
+		/*
+		 * This opens the file written by writeTable() and maps it into
+		 * memory, read-only. If the file can't be opened, or isn't a
+		 * table file this code can read, a CKException is thrown. The
+		 * file stays open - and the view stays good - even if it's
+		 * replaced by a new one while it's in use.
+		 */
+		CKMappedTable( const CKString & aFileName );
+		/*
+		 * This is the standard copy constructor and needs to be in every
+		 * class to make sure that we don't have too many things running
+		 * around. The copy maps the same open file, so it's the same
+		 * table even if the file has been replaced since.
+		 */
+		CKMappedTable( const CKMappedTable & anOther );
+		/*
+		 * This is the standard destructor and needs to be virtual to make
+		 * sure that if we subclass off this, the right destructor will be
+		 * called.
+		 */
+		virtual ~CKMappedTable();
+
+		/*
+		 * When we want to process the result of an equality we need to
+		 * make sure that we do this right by always having an equals
+		 * operator on all classes.
+		 */
+		CKMappedTable & operator=( const CKMappedTable & anOther );
+
+		/********************************************************
+		 *
+		 *                File Methods
+		 *
+		 ********************************************************/
+		/*
+		 * This writes the table to the file in the format that can be
+		 * mapped - a header, the row labels and column headers with a
+		 * hash index of each, a block for each column, and then all the
+		 * strings. A column of just numbers, dates or strings is written
+		 * as an array of them with a bitmap of the cells that aren't
+		 * empty, and anything else is written cell by cell with its type.
+		 * It's written a piece at a time - never all in memory - to a new
+		 * file that then takes the name, so a process that has the old
+		 * one open is never left with a half-written table.
+		 */
+		static void writeTable( const CKTable & aTable, const CKString & aFileName );
+		/*
+		 * These return the name of the file that was opened, and the size
+		 * of it in bytes.
+		 */
+		const CKString & getFileName() const;
+		unsigned long long getFileSize() const;
+
+		/********************************************************
+		 *
+		 *                Accessor Methods
+		 *
+		 ********************************************************/
+		/*
+		 * These return the size of the table.
+		 */
+		int getNumRows() const;
+		int getNumColumns() const;
+		/*
+		 * These return the column header and the row label, and the index
+		 * of a header or label - or -1 if it's not in the table. The look
+		 * ups use the hash indexes in the file. If a label or header is
+		 * there more than once, the index has the last of them, and an
+		 * empty one is never found - just like a CKTable.
+		 */
+		CKString getColumnHeader( int aCol ) const;
+		CKString getRowLabel( int aRow ) const;
+		int getColumnForHeader( const CKString & aHeader ) const;
+		int getRowForLabel( const CKString & aLabel ) const;
+
+		/*
+		 * These return the type of the value in the cell, and the value
+		 * itself. Like the CKTable, asking for a number, date or string
+		 * from a cell that doesn't hold one throws a CKException. The
+		 * string is right in the mapped file, so it's good as long as
+		 * this view is - and it's the bytes of the CKString that was
+		 * written, with a NULL after them.
+		 */
+		CKVariantType getType( int aRow, int aCol ) const;
+		double getDoubleValue( int aRow, int aCol ) const;
+		long getDateValue( int aRow, int aCol ) const;
+		const char *getStringValue( int aRow, int aCol ) const;
+		/*
+		 * These return a copy of the value in the cell, and the value as
+		 * a string, just like the CKTable. An empty cell is an empty
+		 * variant, and an empty string.
+		 */
+		CKVariant getValue( int aRow, int aCol ) const;
+		CKString getValueAsString( int aRow, int aCol ) const;
+
+		/********************************************************
+		 *
+		 *                Column Methods
+		 *
+		 ********************************************************/
+		/*
+		 * This returns the type of the column as it's stored in the file
+		 * - eNumberVariant, eDateVariant or eStringVariant for a column of
+		 * just those, and eUnknownVariant for one with a mix of values.
+		 */
+		CKVariantType getColumnType( int aCol ) const;
+		/*
+		 * These return the arrays of a column of numbers - right in the
+		 * mapped file - so it can be scanned without going through the
+		 * accessors, just like the columns of a CKTable. There are
+		 * getNumRows() values, and row i has one if bit (i % 8) of byte
+		 * (i / 8) of the bitmap is set. If the column isn't a column of
+		 * numbers, they return NULL.
+		 */
+		const double *getDoubleColumn( int aCol ) const;
+		const unsigned char *getColumnValidity( int aCol ) const;
+
+		/*
+		 * This makes a CKTable - columnar, with its columns of numbers
+		 * and dates dense - of all the values in the file, for when the
+		 * table has to be changed.
+		 */
+		CKTable getTable() const;
+
+	private:
+		/*
+		 * These map the open file into memory and check that it's all
+		 * there, and unmap and close it. mapFile() closes the file and
+		 * throws a CKException if it's not a table file we can read.
+		 */
+		void mapFile();
+		void unmapFile();
+		/*
+		 * These check that the cell, or column, is in the table, and
+		 * throw a CKException for the method if it's not.
+		 */
+		void checkCell( int aRow, int aCol, const char *aMethod ) const;
+		void checkColumn( int aCol, const char *aMethod ) const;
+		/*
+		 * This returns the string at the offset into the string heap -
+		 * its bytes and their length - checking that it's all in the
+		 * file.
+		 */
+		const char *heapString( unsigned long long anOffset, int & aLength ) const;
+		/*
+		 * This looks up the string in one of the hash indexes in the file
+		 * - of the 'aCount' labels or headers at 'aNamesOffset' - and
+		 * returns the row, or column, it's for - or -1 if it's not there.
+		 */
+		int findInIndex( unsigned long long anIndexOffset, unsigned long long aSlotCount,
+						 unsigned long long aNamesOffset, unsigned long long aCount,
+						 const CKString & aKey ) const;
+
+		/*
+		 * This is the name of the file, the open file, and where it's
+		 * mapped into memory.
+		 */
+		CKString						mFileName;
+		int								mFd;
+		const char						*mData;
+		unsigned long long				mSize;
+		/*
+		 * These are the header and column blocks in the mapped file, and
+		 * the size of the table.
+		 */
+		const CKMappedTableHeader		*mHeader;
+		const CKMappedTableColumn		*mColumns;
+		int								mNumRows;
+		int								mNumColumns;
+};
+
+#endif	// __CKMAPPEDTABLE_H
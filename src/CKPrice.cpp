@@ -17,6 +17,7 @@
 #include "CKException.h"
 #include "CKTable.h"
 #include "CKPrice.h"
+#include "CKBinaryCodec.h"
 
 //	Forward Declarations
 
@@ -449,6 +450,58 @@ void CKPrice::takeValuesFromCode( const CKString & aCode )
 	mNative = chunks[bit++].doubleValue();
 }
 
+/*
+ * These methods are the binary versions of the two above. The
+ * toBinary() method returns a complete code in the compact binary
+ * format - header and all - and fromBinary() takes one written by
+ * it and replaces what's in this price with it. The codes can
+ * have any bytes in them, so they are std::strings and not CKStrings.
+ */
+std::string CKPrice::toBinary() const
+{
+	std::string		buff;
+	CKBinaryWriter	writer(buff);
+	writer.putHeader(eBinaryPriceTag);
+	writeBinary(writer);
+	return buff;
+}
+
+
+void CKPrice::fromBinary( const std::string & aCode )
+{
+	fromBinary(aCode.data(), aCode.size());
+}
+
+
+void CKPrice::fromBinary( const char *aCode, int aLength )
+{
+	CKBinaryReader	reader(aCode, aLength);
+	reader.getHeader(eBinaryPriceTag);
+	readBinary(reader);
+	reader.checkAtEnd();
+}
+
+
+/*
+ * These methods write and read just the price's value - no
+ * header - so that it can be nested in the code of something
+ * bigger. It's simply the USD and then the native value.
+ */
+void CKPrice::writeBinary( CKBinaryWriter & aWriter ) const
+{
+	aWriter.putDouble(mUSD);
+	aWriter.putDouble(mNative);
+}
+
+
+void CKPrice::readBinary( CKBinaryReader & aReader )
+{
+	double	usd = aReader.getDouble();
+	mNative = aReader.getDouble();
+	mUSD = usd;
+}
+
+
 
 /*
  * This method checks to see if the two CKPrices are equal to one
@@ -57,6 +57,8 @@
 #include "CKString.h"
 
 //	Forward Declarations
+class CKBinaryWriter;
+class CKBinaryReader;
 
 //	Public Constants
 
@@ -241,6 +243,23 @@ class CKPrice
 		 * untouched, and is the responsible of the caller to free.
 		 */
 		virtual void takeValuesFromCode( const CKString & aCode );
+		/*
+		 * These methods are the binary versions of the two above. The
+		 * toBinary() method returns a complete code in the compact binary
+		 * format - header and all - and fromBinary() takes one written by
+		 * it and replaces what's in this price with it. The codes can
+		 * have any bytes in them, so they are std::strings and not CKStrings.
+		 */
+		std::string toBinary() const;
+		void fromBinary( const std::string & aCode );
+		void fromBinary( const char *aCode, int aLength );
+		/*
+		 * These methods write and read just the price's value - no
+		 * header - so that it can be nested in the code of something
+		 * bigger. This is what toBinary() and fromBinary() are built on.
+		 */
+		virtual void writeBinary( CKBinaryWriter & aWriter ) const;
+		virtual void readBinary( CKBinaryReader & aReader );
 		/*
 		 * This method checks to see if the two CKPrices are equal to one
 		 * another based on the values they represent and *not* on the actual
@@ -0,0 +1,303 @@
+/*
+ * CKQueueStats.cpp - this file implements a class that holds the statistics
+ *                    for one of the CKit queues - the current and high-water
+ *                    depth, the number of elements pushed and popped, the
+ *                    number of pushes that were coalesced, and a histogram of
+ *                    the time the elements spent in the queue. The queues only
+ *                    keep these if they are asked to, and the values are all
+ *                    updated atomically, so they can be read at any time
+ *                    without taking the lock on the queue.
+ *
+ * $Id$
+ */
+
+//	System Headers
+#include <sstream>
+#include <sys/time.h>
+
+//	Third-Party Headers
+
+//	Other Headers
+#include "CKQueueStats.h"
+#include "CKFWAtomic.h"
+#include "CKInstanceRegistry.h"
+
+//	Forward Declarations
+
+//	Private Constants
+
+//	Private Datatypes
+
+//	Private Data Constants
+/*
+ * Every instance is in the process-wide registry of queue stats from
+ * its constructor to its destructor, and that's what dumpAll() walks.
+ */
+typedef CKInstanceRegistry<CKQueueStats>	CKQueueStatsRegistry;
+
+
+/********************************************************
+ *
+ *                Constructors/Destructor
+ *
+ ********************************************************/
+/*
+ * This is the constructor that takes the name the statistics are
+ * reported under and registers this instance in the process-wide
+ * list so that dumpAll() will include it.
+ */
+CKQueueStats::CKQueueStats( const CKString & aName ) :
+	mName(aName),
+	mDepth(0),
+	mHighWaterDepth(0),
+	mEnqueueCount(0),
+	mDequeueCount(0),
+	mCoalesceCount(0),
+	mTotalWaitMicros(0)
+{
+	for (int i = 0; i < CKQUEUESTATS_HISTOGRAM_BUCKETS; ++i) {
+		mWaitCounts[i] = 0;
+	}
+
+	// now add us to the list of all the stats
+	CKQueueStatsRegistry::add(this);
+}
+
+
+/*
+ * This is the standard destructor and needs to be virtual to make
+ * sure that if we subclass off this the right destructor will be
+ * called. It removes this instance from the process-wide list.
+ */
+CKQueueStats::~CKQueueStats()
+{
+	CKQueueStatsRegistry::remove(this);
+}
+
+
+/********************************************************
+ *
+ *                Accessor Methods
+ *
+ ********************************************************/
+/*
+ * This is the name that this queue is reported under.
+ */
+const CKString & CKQueueStats::getName() const
+{
+	return mName;
+}
+
+
+/*
+ * These are the number of elements in the queue as of the last
+ * push or pop, and the most that have ever been in the queue.
+ */
+long CKQueueStats::getDepth() const
+{
+	return mDepth;
+}
+
+
+long CKQueueStats::getHighWaterDepth() const
+{
+	return mHighWaterDepth;
+}
+
+
+/*
+ * These are the counts of the elements pushed onto the queue, the
+ * elements taken off the queue, and the pushes that replaced an
+ * element already in the queue rather than adding a new one.
+ */
+unsigned long CKQueueStats::getEnqueueCount() const
+{
+	return mEnqueueCount;
+}
+
+
+unsigned long CKQueueStats::getDequeueCount() const
+{
+	return mDequeueCount;
+}
+
+
+unsigned long CKQueueStats::getCoalesceCount() const
+{
+	return mCoalesceCount;
+}
+
+
+/*
+ * This returns the count in the given bucket of the time-in-queue
+ * histogram. See CKQUEUESTATS_HISTOGRAM_BUCKETS for the layout.
+ */
+unsigned long CKQueueStats::getWaitCount( int aBucket ) const
+{
+	unsigned long	retval = 0;
+	if ((aBucket >= 0) && (aBucket < CKQUEUESTATS_HISTOGRAM_BUCKETS)) {
+		retval = mWaitCounts[aBucket];
+	}
+	return retval;
+}
+
+
+/*
+ * This is the total time, in seconds, that all the dequeued
+ * elements have spent in the queue - handy for the average.
+ */
+double CKQueueStats::getTotalWaitTime() const
+{
+	return mTotalWaitMicros/1000000.0;
+}
+
+
+/********************************************************
+ *
+ *                Recording Methods
+ *
+ ********************************************************/
+/*
+ * The queues call these as elements come and go. The depth is the
+ * depth of the queue *after* the operation - a negative depth means
+ * leave it alone - and the time in queue is in seconds - a negative
+ * value means it's not known, and it's not counted in the histogram.
+ */
+void CKQueueStats::enqueued( long aDepth )
+{
+	CKFWAtomicAdd(&mEnqueueCount, 1);
+	mDepth = aDepth;
+	CKFWAtomicMax(&mHighWaterDepth, aDepth);
+}
+
+
+void CKQueueStats::coalesced()
+{
+	CKFWAtomicAdd(&mEnqueueCount, 1);
+	CKFWAtomicAdd(&mCoalesceCount, 1);
+}
+
+
+void CKQueueStats::dequeued( long aDepth, double aTimeInQueue )
+{
+	CKFWAtomicAdd(&mDequeueCount, 1);
+	if (aDepth >= 0) {
+		mDepth = aDepth;
+	}
+
+	// now see where this falls in the histogram
+	if (aTimeInQueue >= 0.0) {
+		unsigned long long	usec = (unsigned long long)(aTimeInQueue * 1000000.0);
+		int					bucket = 0;
+		while ((bucket < CKQUEUESTATS_HISTOGRAM_BUCKETS - 1) &&
+			   ((usec >> bucket) > 0)) {
+			++bucket;
+		}
+		CKFWAtomicAdd(&mWaitCounts[bucket], 1);
+		CKFWAtomicAdd(&mTotalWaitMicros, usec);
+	}
+}
+
+
+/*
+ * When the depth changes without anything being pushed or popped -
+ * like when the queue is cleared - this updates the depth.
+ */
+void CKQueueStats::depthChanged( long aDepth )
+{
+	mDepth = aDepth;
+	CKFWAtomicMax(&mHighWaterDepth, aDepth);
+}
+
+
+/*
+ * This method sets all the counts back to zero - but leaves the
+ * current depth alone as that's still the depth of the queue.
+ */
+void CKQueueStats::reset()
+{
+	mHighWaterDepth = mDepth;
+	mEnqueueCount = 0;
+	mDequeueCount = 0;
+	mCoalesceCount = 0;
+	for (int i = 0; i < CKQUEUESTATS_HISTOGRAM_BUCKETS; ++i) {
+		mWaitCounts[i] = 0;
+	}
+	mTotalWaitMicros = 0;
+}
+
+
+/*
+ * This is the clock that the queues use to stamp their elements -
+ * the current time in seconds since the epoch, to the microsecond.
+ */
+double CKQueueStats::now()
+{
+	timeval		tv;
+	gettimeofday(&tv, NULL);
+	return (double)tv.tv_sec + (double)tv.tv_usec/1000000.0;
+}
+
+
+/********************************************************
+ *
+ *                Utility Methods
+ *
+ ********************************************************/
+/*
+ * Because there are times when it's useful to have a nice
+ * human-readable form of the contents of this instance. Most of the
+ * time this means that it's used for debugging, but it could be used
+ * for just about anything. In these cases, it's nice not to have to
+ * worry about the ownership of the representation, so this returns
+ * a CKString.
+ */
+CKString CKQueueStats::toString() const
+{
+	std::ostringstream	buff;
+
+	buff << mName << ": depth=" << mDepth << " high=" << mHighWaterDepth
+		<< " pushed=" << mEnqueueCount << " popped=" << mDequeueCount
+		<< " coalesced=" << mCoalesceCount << " wait(usec)=[";
+	// only show the buckets that have something in them
+	bool	first = true;
+	for (int i = 0; i < CKQUEUESTATS_HISTOGRAM_BUCKETS; ++i) {
+		if (mWaitCounts[i] > 0) {
+			if (!first) {
+				buff << " ";
+			}
+			if (i < CKQUEUESTATS_HISTOGRAM_BUCKETS - 1) {
+				buff << "<" << (1UL << i) << ":" << mWaitCounts[i];
+			} else {
+				buff << ">=" << (1UL << (i - 1)) << ":" << mWaitCounts[i];
+			}
+			first = false;
+		}
+	}
+	buff << "]";
+
+	return CKString(buff.str());
+}
+
+
+/*
+ * This method returns the toString() of every registered instance,
+ * one per line, in the order they were created. This is the common
+ * metrics dump for all the instrumented queues in the process.
+ */
+CKString CKQueueStats::dumpAll()
+{
+	return CKQueueStatsRegistry::dump(&CKQueueStats::toString);
+}
+
+
+/*
+ * For debugging purposes, let's make it easy for the user to stream
+ * out this guy. It basically is just the value of toString().
+ */
+std::ostream & operator<<( std::ostream & aStream, const CKQueueStats & aStats )
+{
+	aStream << aStats.toString();
+
+	return aStream;
+}
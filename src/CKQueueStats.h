@@ -0,0 +1,196 @@
+/*
+ * CKQueueStats.h - this file defines a class that holds the statistics
+ *                  for one of the CKit queues - the current and high-water
+ *                  depth, the number of elements pushed and popped, the
+ *                  number of pushes that were coalesced, and a histogram of
+ *                  the time the elements spent in the queue. The queues only
+ *                  keep these if they are asked to, and the values are all
+ *                  updated atomically, so they can be read at any time
+ *                  without taking the lock on the queue.
+ *
+ *                  Every instance is registered by name in a process-wide
+ *                  list so that dumpAll() can produce a report of all the
+ *                  instrumented queues in the process.
+ *
+ * $Id$
+ */
+#ifndef __CKQUEUESTATS_H
+#define __CKQUEUESTATS_H
+
+//	System Headers
+#ifdef GPP2
+#include <ostream.h>
+#else
+#include <ostream>
+#endif
+
+//	Third-Party Headers
+
+//	Other Headers
+#include "CKString.h"
+
+//	Forward Declarations
+
+//	Public Constants
+/*
+ * The time-in-queue histogram has power-of-two buckets in microseconds.
+ * Bucket 'i' counts the elements that waited less than 2^i usec (and at
+ * least 2^(i-1) usec), and the last bucket is everything longer than
+ * that - with 24 buckets that's about 4 sec and up.
+ */
+#define	CKQUEUESTATS_HISTOGRAM_BUCKETS		24
+
+//	Public Datatypes
+
+//	Public Data Constants
+
+
+/*
+ * This is the main class definition.
+ */
+class CKQueueStats
+{
+	public:
+		/********************************************************
+		 *
+		 *                Constructors/Destructor
+		 *
+		 ********************************************************/
+		/*
+		 * This is the constructor that takes the name the statistics are
+		 * reported under and registers this instance in the process-wide
+		 * list so that dumpAll() will include it.
+		 */
+		CKQueueStats( const CKString & aName );
+		/*
+		 * This is the standard destructor and needs to be virtual to make
+		 * sure that if we subclass off this the right destructor will be
+		 * called. It removes this instance from the process-wide list.
+		 */
+		virtual ~CKQueueStats();
+
+		/********************************************************
+		 *
+		 *                Accessor Methods
+		 *
+		 ********************************************************/
+		/*
+		 * This is the name that this queue is reported under.
+		 */
+		const CKString & getName() const;
+		/*
+		 * These are the number of elements in the queue as of the last
+		 * push or pop, and the most that have ever been in the queue.
+		 */
+		long getDepth() const;
+		long getHighWaterDepth() const;
+		/*
+		 * These are the counts of the elements pushed onto the queue, the
+		 * elements taken off the queue, and the pushes that replaced an
+		 * element already in the queue rather than adding a new one.
+		 */
+		unsigned long getEnqueueCount() const;
+		unsigned long getDequeueCount() const;
+		unsigned long getCoalesceCount() const;
+		/*
+		 * This returns the count in the given bucket of the time-in-queue
+		 * histogram. See CKQUEUESTATS_HISTOGRAM_BUCKETS for the layout.
+		 */
+		unsigned long getWaitCount( int aBucket ) const;
+		/*
+		 * This is the total time, in seconds, that all the dequeued
+		 * elements have spent in the queue - handy for the average.
+		 */
+		double getTotalWaitTime() const;
+
+		/********************************************************
+		 *
+		 *                Recording Methods
+		 *
+		 ********************************************************/
+		/*
+		 * The queues call these as elements come and go. The depth is the
+		 * depth of the queue *after* the operation - a negative depth means
+		 * leave it alone - and the time in queue is in seconds - a negative
+		 * value means it's not known, and it's not counted in the histogram.
+		 */
+		void enqueued( long aDepth );
+		void coalesced();
+		void dequeued( long aDepth, double aTimeInQueue );
+		/*
+		 * When the depth changes without anything being pushed or popped -
+		 * like when the queue is cleared - this updates the depth.
+		 */
+		void depthChanged( long aDepth );
+		/*
+		 * This method sets all the counts back to zero - but leaves the
+		 * current depth alone as that's still the depth of the queue.
+		 */
+		void reset();
+		/*
+		 * This is the clock that the queues use to stamp their elements -
+		 * the current time in seconds since the epoch, to the microsecond.
+		 */
+		static double now();
+
+		/********************************************************
+		 *
+		 *                Utility Methods
+		 *
+		 ********************************************************/
+		/*
+		 * Because there are times when it's useful to have a nice
+		 * human-readable form of the contents of this instance. Most of the
+		 * time this means that it's used for debugging, but it could be used
+		 * for just about anything. In these cases, it's nice not to have to
+		 * worry about the ownership of the representation, so this returns
+		 * a CKString.
+		 */
+		virtual CKString toString() const;
+		/*
+		 * This method returns the toString() of every registered instance,
+		 * one per line, in the order they were created. This is the common
+		 * metrics dump for all the instrumented queues in the process.
+		 */
+		static CKString dumpAll();
+
+	private:
+		/*
+		 * We can't have these copied as they are registered by address.
+		 */
+		CKQueueStats();
+		CKQueueStats( const CKQueueStats & anOther );
+		CKQueueStats & operator=( const CKQueueStats & anOther );
+
+		/*
+		 * This is the name of the queue in the reports.
+		 */
+		CKString						mName;
+		/*
+		 * These are the depth and the high-water mark of the depth.
+		 */
+		volatile long					mDepth;
+		volatile long					mHighWaterDepth;
+		/*
+		 * These are the counts of the operations on the queue.
+		 */
+		volatile unsigned long			mEnqueueCount;
+		volatile unsigned long			mDequeueCount;
+		volatile unsigned long			mCoalesceCount;
+		/*
+		 * This is the time-in-queue histogram and the total of the time
+		 * in queue in microseconds. The total is 64 bits as 32 bits of
+		 * microseconds is only about 71 minutes of waiting - and a few
+		 * idle consumers get there in no time.
+		 */
+		volatile unsigned long			mWaitCounts[CKQUEUESTATS_HISTOGRAM_BUCKETS];
+		volatile unsigned long long		mTotalWaitMicros;
+};
+
+/*
+ * For debugging purposes, let's make it easy for the user to stream
+ * out this guy. It basically is just the value of toString().
+ */
+std::ostream & operator<<( std::ostream & aStream, const CKQueueStats & aStats );
+
+#endif	// __CKQUEUESTATS_H
@@ -40,6 +40,17 @@
  *                Constructors/Destructor
  *
  ********************************************************/
+/*
+ * When the caller doesn't give us a site for the profiler, we use the
+ * address of the code that's creating us.
+ */
+#ifdef __GNUC__
+#define	CALLER_ADDRESS		__builtin_return_address(0)
+#else
+#define	CALLER_ADDRESS		NULL
+#endif
+
+
 /*
  * This form of the constructor takes a pointer to a CKFWMutex that
  * needs to be non-NULL. It then proceeds to lock this mutex and
@@ -48,18 +59,13 @@
 CKStackLocker::CKStackLocker( CKFWMutex *aMutex ) :
 	mMutex(NULL),
 	mRWMutex(NULL),
-	mSemaphore(NULL)
+	mSemaphore(NULL),
+	mSite(CALLER_ADDRESS),
+	mLine(-1),
+	mAcquiredAt(0),
+	mWaitNanos(0)
 {
-	if (aMutex == NULL) {
-		std::ostringstream	msg;
-		msg << "CKStackLocker::CKStackLocker(CKFWMutex *) - the passed-in mutex "
-			"is NULL and that means that there's nothing I can do. Please make "
-			"sure that the argument is not NULL before calling this constructor.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	} else {
-		mMutex = aMutex;
-		mMutex->lock();
-	}
+	lock(aMutex);
 }
 
 
@@ -72,23 +78,13 @@ CKStackLocker::CKStackLocker( CKFWMutex *aMutex ) :
 CKStackLocker::CKStackLocker( CKFWRWMutex *aRWMutex, bool aReadLock ) :
 	mMutex(NULL),
 	mRWMutex(NULL),
-	mSemaphore(NULL)
+	mSemaphore(NULL),
+	mSite(CALLER_ADDRESS),
+	mLine(-1),
+	mAcquiredAt(0),
+	mWaitNanos(0)
 {
-	if (aRWMutex == NULL) {
-		std::ostringstream	msg;
-		msg << "CKStackLocker::CKStackLocker(CKFWRWMutex *, bool) - the passed-in "
-			"mutex is NULL and that means that there's nothing I can do. Please "
-			"make sure that the argument is not NULL before calling this "
-			"constructor.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	} else {
-		mRWMutex = aRWMutex;
-		if (aReadLock) {
-			mRWMutex->readLock();
-		} else {
-			mRWMutex->writeLock();
-		}
-	}
+	lock(aRWMutex, aReadLock);
 }
 
 
@@ -101,18 +97,58 @@ CKStackLocker::CKStackLocker( CKFWRWMutex *aRWMutex, bool aReadLock ) :
 CKStackLocker::CKStackLocker( CKFWSemaphore *aSemaphore ) :
 	mMutex(NULL),
 	mRWMutex(NULL),
-	mSemaphore(NULL)
+	mSemaphore(NULL),
+	mSite(CALLER_ADDRESS),
+	mLine(-1),
+	mAcquiredAt(0),
+	mWaitNanos(0)
 {
-	if (aSemaphore == NULL) {
-		std::ostringstream	msg;
-		msg << "CKStackLocker::CKStackLocker(CKFWSemaphore *) - the passed-in semaphore "
-			"is NULL and that means that there's nothing I can do. Please make "
-			"sure that the argument is not NULL before calling this constructor.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	} else {
-		mSemaphore = aSemaphore;
-		mSemaphore->wait();
-	}
+	lock(aSemaphore);
+}
+
+
+/*
+ * These are the same as the constructors above, but they take the
+ * call site for the lock profiler - usually __FILE__ and __LINE__,
+ * but it can be any constant tag string with a line of zero.
+ */
+CKStackLocker::CKStackLocker( CKFWMutex *aMutex, const char *aFile, int aLine ) :
+	mMutex(NULL),
+	mRWMutex(NULL),
+	mSemaphore(NULL),
+	mSite(aFile),
+	mLine(aLine < 0 ? 0 : aLine),
+	mAcquiredAt(0),
+	mWaitNanos(0)
+{
+	lock(aMutex);
+}
+
+
+CKStackLocker::CKStackLocker( CKFWRWMutex *aRWMutex, bool aReadLock,
+							  const char *aFile, int aLine ) :
+	mMutex(NULL),
+	mRWMutex(NULL),
+	mSemaphore(NULL),
+	mSite(aFile),
+	mLine(aLine < 0 ? 0 : aLine),
+	mAcquiredAt(0),
+	mWaitNanos(0)
+{
+	lock(aRWMutex, aReadLock);
+}
+
+
+CKStackLocker::CKStackLocker( CKFWSemaphore *aSemaphore, const char *aFile, int aLine ) :
+	mMutex(NULL),
+	mRWMutex(NULL),
+	mSemaphore(NULL),
+	mSite(aFile),
+	mLine(aLine < 0 ? 0 : aLine),
+	mAcquiredAt(0),
+	mWaitNanos(0)
+{
+	lock(aSemaphore);
 }
 
 
@@ -140,6 +176,11 @@ CKStackLocker::~CKStackLocker()
 			mSemaphore->post();
 			mSemaphore = NULL;
 		}
+		// if we timed the lock, record how it went
+		if (mAcquiredAt != 0) {
+			CKLockProfiler::record(mSite, mLine, mWaitNanos,
+								   CKLockProfiler::now() - mAcquiredAt);
+		}
 	}
 }
 
@@ -152,6 +193,80 @@ CKStackLocker::~CKStackLocker()
  */
 CKStackLocker::CKStackLocker() :
 	mMutex(NULL),
-	mRWMutex(NULL)
+	mRWMutex(NULL),
+	mSemaphore(NULL),
+	mSite(NULL),
+	mLine(-1),
+	mAcquiredAt(0),
+	mWaitNanos(0)
+{
+}
+
+
+/*
+ * These do the real work of the constructors - check the argument
+ * and take the lock, timing it if the profiler is on.
+ */
+void CKStackLocker::lock( CKFWMutex *aMutex )
+{
+	if (aMutex == NULL) {
+		std::ostringstream	msg;
+		msg << "CKStackLocker::CKStackLocker(CKFWMutex *) - the passed-in mutex "
+			"is NULL and that means that there's nothing I can do. Please make "
+			"sure that the argument is not NULL before calling this constructor.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	} else {
+		unsigned long long	start = (CKLockProfiler::isEnabled() ? CKLockProfiler::now() : 0);
+		mMutex = aMutex;
+		mMutex->lock();
+		if (start != 0) {
+			mAcquiredAt = CKLockProfiler::now();
+			mWaitNanos = mAcquiredAt - start;
+		}
+	}
+}
+
+
+void CKStackLocker::lock( CKFWRWMutex *aRWMutex, bool aReadLock )
+{
+	if (aRWMutex == NULL) {
+		std::ostringstream	msg;
+		msg << "CKStackLocker::CKStackLocker(CKFWRWMutex *, bool) - the passed-in "
+			"mutex is NULL and that means that there's nothing I can do. Please "
+			"make sure that the argument is not NULL before calling this "
+			"constructor.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	} else {
+		unsigned long long	start = (CKLockProfiler::isEnabled() ? CKLockProfiler::now() : 0);
+		mRWMutex = aRWMutex;
+		if (aReadLock) {
+			mRWMutex->readLock();
+		} else {
+			mRWMutex->writeLock();
+		}
+		if (start != 0) {
+			mAcquiredAt = CKLockProfiler::now();
+			mWaitNanos = mAcquiredAt - start;
+		}
+	}
+}
+
+
+void CKStackLocker::lock( CKFWSemaphore *aSemaphore )
 {
+	if (aSemaphore == NULL) {
+		std::ostringstream	msg;
+		msg << "CKStackLocker::CKStackLocker(CKFWSemaphore *) - the passed-in semaphore "
+			"is NULL and that means that there's nothing I can do. Please make "
+			"sure that the argument is not NULL before calling this constructor.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	} else {
+		unsigned long long	start = (CKLockProfiler::isEnabled() ? CKLockProfiler::now() : 0);
+		mSemaphore = aSemaphore;
+		mSemaphore->wait();
+		if (start != 0) {
+			mAcquiredAt = CKLockProfiler::now();
+			mWaitNanos = mAcquiredAt - start;
+		}
+	}
 }
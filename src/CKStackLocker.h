@@ -14,6 +14,12 @@
  *                   no matter how the scope is exited - normally or by an
  *                   exception being thrown, the mutex will be unlocked.
  *
+ *                   When the CKLockProfiler is enabled, each locker records
+ *                   how long it waited for the lock and how long it held it
+ *                   against its call site. The constructors that take a file
+ *                   and line - or a tag and a line of zero - use those as the
+ *                   site, and the others use the address of the caller.
+ *
  * $Id: CKStackLocker.h,v 1.7 2005/10/27 19:25:33 drbob Exp $
  */
 #ifndef __CKSTACKLOCKER_H
@@ -27,6 +33,7 @@
 #include "CKFWMutex.h"
 #include "CKFWRWMutex.h"
 #include "CKFWSemaphore.h"
+#include "CKLockProfiler.h"
 
 //	Forward Declarations
 
@@ -68,6 +75,15 @@ class CKStackLocker
 		 * everything will be back the way it should be.
 		 */
 		CKStackLocker( CKFWSemaphore *aSemaphore );
+		/*
+		 * These are the same as the constructors above, but they take the
+		 * call site for the lock profiler - usually __FILE__ and __LINE__,
+		 * but it can be any constant tag string with a line of zero.
+		 */
+		CKStackLocker( CKFWMutex *aMutex, const char *aFile, int aLine );
+		CKStackLocker( CKFWRWMutex *aRWMutex, bool aReadLock,
+					   const char *aFile, int aLine );
+		CKStackLocker( CKFWSemaphore *aSemaphore, const char *aFile, int aLine );
 		/*
 		 * This is the standard destructor and needs to be virtual to make
 		 * sure that if we subclass off this the right destructor will be
@@ -84,6 +100,14 @@ class CKStackLocker
 		 */
 		CKStackLocker();
 
+		/*
+		 * These do the real work of the constructors - check the argument
+		 * and take the lock, timing it if the profiler is on.
+		 */
+		void lock( CKFWMutex *aMutex );
+		void lock( CKFWRWMutex *aRWMutex, bool aReadLock );
+		void lock( CKFWSemaphore *aSemaphore );
+
 		/*
 		 * This is the pointer to the actual mutex that will be passed in
 		 * to the public constructor. We didn't create this guy so we're
@@ -94,6 +118,15 @@ class CKStackLocker
 		CKFWRWMutex		*mRWMutex;
 		// ...and this is the pointer to the semaphore
 		CKFWSemaphore	*mSemaphore;
+		/*
+		 * These are for the lock profiler - the call site (see
+		 * CKLockProfiler::record()), the time we got the lock, and how
+		 * long we waited for it. If we're not profiling, the time is 0.
+		 */
+		const void			*mSite;
+		int					mLine;
+		unsigned long long	mAcquiredAt;
+		unsigned long long	mWaitNanos;
 };
 
 #endif	// __CKSTACKLOCKER_H
@@ -461,6 +461,37 @@ CKString & CKString::operator=( char aChar )
 }
 
 
+/*
+ * This method exchanges the contents of this string with the
+ * other one without copying any of the characters - just the
+ * buffers change hands.
+ */
+void CKString::swap( CKString & anOther )
+{
+	if (this != & anOther) {
+		char	*str = mString;
+		mString = anOther.mString;
+		anOther.mString = str;
+
+		int		val = mSize;
+		mSize = anOther.mSize;
+		anOther.mSize = val;
+
+		val = mCapacity;
+		mCapacity = anOther.mCapacity;
+		anOther.mCapacity = val;
+
+		val = mInitialCapacity;
+		mInitialCapacity = anOther.mInitialCapacity;
+		anOther.mInitialCapacity = val;
+
+		val = mCapacityIncrement;
+		mCapacityIncrement = anOther.mCapacityIncrement;
+		anOther.mCapacityIncrement = val;
+	}
+}
+
+
 /********************************************************
  *
  *                Accessor Methods
@@ -199,6 +199,12 @@ class CKString
 		CKString & operator=( char *aCString );
 		CKString & operator=( const char *aCString );
 		CKString & operator=( char aChar );
+		/*
+		 * This method exchanges the contents of this string with the
+		 * other one without copying any of the characters - just the
+		 * buffers change hands.
+		 */
+		void swap( CKString & anOther );
 
 		/********************************************************
 		 *
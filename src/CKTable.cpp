@@ -12,19 +12,86 @@
 #include <string>
 #include <iostream>
 #include <sstream>
+#include <vector>
+#include <algorithm>
+#include <string.h>
 #include <strings.h>
+#include <limits.h>
 
 //	Third-Party Headers
 #include <CKException.h>
 
 //	Other Headers
 #include "CKTable.h"
+#include "CKBinaryCodec.h"
+#include "CKVectorMath.h"
+#include "CKExecutor.h"
+#include "CKFWAtomic.h"
+#include "CKStackLocker.h"
 
 //	Forward Declarations
 
 //	Private Constants
+/*
+ * When the work on a big table is split up, it's split into blocks of
+ * this many rows. It's a multiple of eight so every block starts on a
+ * byte of the bitmaps of the dense columns.
+ */
+#define	CKTABLE_ROW_BLOCK			64
+/*
+ * This is the number of cells a table has to have before the work on
+ * it is split up, unless it's been set otherwise.
+ */
+#define	CKTABLE_PARALLEL_THRESHOLD	100000
+/*
+ * When the product for the matrix methods is split up, it's split into
+ * blocks of the result this many rows by this many columns. Each one is
+ * still big enough for the blocking in CKVectorMath to pay off.
+ */
+#define	CKTABLE_MATRIX_BLOCK		256
+/*
+ * This is the least room a table grows to when a row or column is
+ * appended and there's no room left for it.
+ */
+#define	CKTABLE_MIN_CAPACITY		16
+/*
+ * When rows are gathered out of order - as a sort does - the source
+ * rows are all over memory, so the cells of the row this far ahead are
+ * asked for while the current one is being copied. Where the compiler
+ * can't do that, it's nothing.
+ */
+#define	CKTABLE_PREFETCH_AHEAD		4
+#ifdef __GNUC__
+#define	CKTABLE_PREFETCH(addr)		__builtin_prefetch(addr)
+#else
+#define	CKTABLE_PREFETCH(addr)
+#endif
 
 //	Private Datatypes
+/*
+ * This is one column of a columnar table. A column of numbers or dates
+ * is a dense array of doubles or longs - one for each row - with a
+ * bitmap of the rows that actually have a value. An empty cell is just
+ * a clear bit, and its slot in the array means nothing. Any other column
+ * is an array of CKVariants, one for each row, and has no bitmap.
+ */
+struct CKTableColumn {
+	// eNumberVariant, eDateVariant, or eUnknownVariant for CKVariants
+	CKVariantType	type;
+	double			*doubles;
+	long			*dates;
+	CKVariant		*variants;
+	unsigned char	*valid;
+
+	CKTableColumn() :
+		type(eUnknownVariant),
+		doubles(NULL),
+		dates(NULL),
+		variants(NULL),
+		valid(NULL)
+	{
+	}
+};
 
 //	Private Data Constants
 /*
@@ -40,1237 +107,1734 @@
 #endif
 
 
-
-/********************************************************
- *
- *                Constructors/Destructor
- *
- ********************************************************/
 /*
- * The default constructor does *not* define the table's data
- * structure, but a call to resizeTable(int, int) will do that
- * once the instance is built. This constructor is here for
- * those times that you aren't sure what you're going to be
- * getting into and need to leave your options open.
+ * These read and set the bit for a row in the bitmap of a dense column.
  */
-CKTable::CKTable() :
-	mTable(NULL),
-	mColumnHeaders(NULL),
-	mColumnHeadersIndex(),
-	mRowLabels(NULL),
-	mRowLabelsIndex(),
-	mNumRows(-1),
-	mNumColumns(-1)
+static inline bool isRowValid( const unsigned char *aBits, int aRow )
 {
+	return (((aBits[aRow >> 3] >> (aRow & 7)) & 1) != 0);
 }
 
 
-/*
- * The preferred constructor for this class takes the number of
- * rows and columns and creates a table of values that can then
- * be individually accessed by the accessor methods of this
- * class.
- */
-CKTable::CKTable( int aNumRows, int aNumColumns ) :
-	mTable(NULL),
-	mColumnHeaders(NULL),
-	mColumnHeadersIndex(),
-	mRowLabels(NULL),
-	mRowLabelsIndex(),
-	mNumRows(-1),
-	mNumColumns(-1)
+static inline void markRow( unsigned char *aBits, int aRow, bool aValid )
 {
-	// see if the requestde size makes any sense
-	if ((aNumRows <= 0) || (aNumColumns <= 0)) {
-		std::ostringstream	msg;
-		msg << "CKTable::CKTable(int, int) - the requested size: "
-			<< aNumRows << " by " << aNumColumns << " doesn't make any sense. "
-			"Please try again.";
-		throw CKException(__FILE__, __LINE__, msg.str());
+	if (aValid) {
+		aBits[aRow >> 3] |= (unsigned char)(1 << (aRow & 7));
+	} else {
+		aBits[aRow >> 3] &= (unsigned char)~(1 << (aRow & 7));
 	}
-
-	// create the data table structure
-	createTable(aNumRows, aNumColumns);
 }
 
 
 /*
- * This version of the constructor for this class takes two lists -
- * one for the list of row labels and the other for the list of
- * column headers. These lists not only define the structure of the
- * table, but also the row labels and column headers.
+ * This returns true if every one of the first 'aRows' rows in the
+ * bitmap has a value.
  */
-CKTable::CKTable( const CKStringList aRowLabels,
-				  const CKStringList aColumnHeaders ) :
-	mTable(NULL),
-	mColumnHeaders(NULL),
-	mColumnHeadersIndex(),
-	mRowLabels(NULL),
-	mRowLabelsIndex(),
-	mNumRows(-1),
-	mNumColumns(-1)
+static bool isColumnFull( const unsigned char *aBits, int aRows )
 {
-	// see if the requestde size makes any sense
-	if (aRowLabels.empty() || aColumnHeaders.empty()) {
-		std::ostringstream	msg;
-		msg << "CKTable::CKTable(const CKStringList &, const "
-			"CKStringList &) - the requested size: "
-			<< aRowLabels.size() << " by " << aColumnHeaders.size() <<
-			" doesn't make any sense. Please try again.";
-		throw CKException(__FILE__, __LINE__, msg.str());
+	for (int b = 0; b < aRows / 8; ++b) {
+		if (aBits[b] != 0xff) {
+			return false;
+		}
 	}
-
-	// create the data table structure
-	createTable(aRowLabels, aColumnHeaders);
+	for (int i = aRows & ~7; i < aRows; ++i) {
+		if (!isRowValid(aBits, i)) {
+			return false;
+		}
+	}
+	return true;
 }
 
 
 /*
- * This constructor is interesting in that it takes the data as
- * it comes from another CKTable's generateCodeFromValues() method
- * and parses it into a table of values directly. This is very
- * useful for serializing the table's data from one host to
- * another across a socket, for instance.
+ * This frees all the data of a column and leaves it empty.
  */
-CKTable::CKTable( const CKString & aCode ) :
-	mTable(NULL),
-	mColumnHeaders(NULL),
-	mColumnHeadersIndex(),
-	mRowLabels(NULL),
-	mRowLabelsIndex(),
-	mNumRows(-1),
-	mNumColumns(-1)
+static void freeColumn( CKTableColumn & aColumn )
 {
-	// first, make sure we have something to do
-	if (aCode.empty()) {
-		std::ostringstream	msg;
-		msg << "CKTable::CKTable(const CKString &) - the provided argument is "
-			"empty and that means that nothing can be done. Please make sure "
-			"that the argument is not empty before calling this constructor.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	} else {
-		// load in the values from the code
-		takeValuesFromCode(aCode);
-	}
+	delete [] aColumn.doubles;
+	delete [] aColumn.dates;
+	delete [] aColumn.variants;
+	delete [] aColumn.valid;
+	aColumn = CKTableColumn();
 }
 
 
 /*
- * This is the standard copy constructor and needs to be in every
- * class to make sure that we don't have too many things running
- * around.
+ * This gives an empty column the storage for 'aRows' rows of the type,
+ * all of them empty.
  */
-CKTable::CKTable( const CKTable & anOther ) :
-	mTable(NULL),
-	mColumnHeaders(NULL),
-	mColumnHeadersIndex(),
-	mRowLabels(NULL),
-	mRowLabelsIndex(),
-	mNumRows(-1),
-	mNumColumns(-1)
+static void allocColumn( CKTableColumn & aColumn, CKVariantType aType, int aRows )
 {
-	*this = anOther;
+	int		bytes = (aRows + 7) / 8;
+	aColumn.type = aType;
+	switch (aType) {
+		case eNumberVariant:
+			aColumn.doubles = new double[aRows];
+			memset(aColumn.doubles, 0, aRows * sizeof(double));
+			break;
+		case eDateVariant:
+			aColumn.dates = new long[aRows];
+			memset(aColumn.dates, 0, aRows * sizeof(long));
+			break;
+		default:
+			aColumn.type = eUnknownVariant;
+			aColumn.variants = new CKVariant[aRows];
+			break;
+	}
+	if (aColumn.type != eUnknownVariant) {
+		aColumn.valid = new unsigned char[bytes];
+		memset(aColumn.valid, 0, bytes);
+	}
 }
 
 
 /*
- * This is the standard destructor and needs to be virtual to make
- * sure that if we subclass off this the right destructor will be
- * called.
+ * This makes the empty column 'aTarget' a column of 'aRows' rows of the
+ * same type as 'aSource', and copies the first 'aCopyRows' rows of it.
  */
-CKTable::~CKTable()
-{
-	// first, drop the table, if we have one
-	if (mTable != NULL) {
-		delete [] mTable;
-		mTable = NULL;
-	}
-	// next, drop the row and column labels, if we have them
-	if (mRowLabels != NULL) {
-		delete [] mRowLabels;
-		mRowLabels = NULL;
+static void copyColumn( CKTableColumn & aTarget, const CKTableColumn & aSource,
+						int aRows, int aCopyRows )
+{
+	allocColumn(aTarget, aSource.type, aRows);
+	switch (aSource.type) {
+		case eNumberVariant:
+			memcpy(aTarget.doubles, aSource.doubles, aCopyRows * sizeof(double));
+			break;
+		case eDateVariant:
+			memcpy(aTarget.dates, aSource.dates, aCopyRows * sizeof(long));
+			break;
+		default:
+			for (int i = 0; i < aCopyRows; ++i) {
+				aTarget.variants[i] = aSource.variants[i];
+			}
+			break;
 	}
-	if (mColumnHeaders != NULL) {
-		delete [] mColumnHeaders;
-		mColumnHeaders = NULL;
+	for (int i = 0; (aTarget.valid != NULL) && (i < aCopyRows); ++i) {
+		markRow(aTarget.valid, i, isRowValid(aSource.valid, i));
 	}
 }
 
 
 /*
- * When we want to process the result of an equality we need to
- * make sure that we do this right by always having an equals
- * operator on all classes.
+ * This turns a dense column of 'aRows' rows into a column of CKVariants
+ * holding the same values. It's what happens when a value that isn't of
+ * the column's type is put into it.
+ *
+ * If 'aKeepDense' is true, the dense arrays are left right where they
+ * are, and only the type says the column is CKVariants now - the type
+ * is set last, after a fence, so that a reader on another thread that
+ * has already seen the old type is still reading good data. They're
+ * freed with the rest of the column by freeColumn().
  */
-CKTable & CKTable::operator=( const CKTable & anOther )
-{
-	// make sure we don't do this to ourselves
-	if (this != & anOther) {
-		// now see if the requested size makes any sense to copy
-		if ((anOther.mNumRows > 0) && (anOther.mNumColumns > 0)) {
-			// create the data table structure
-			createTable(anOther.mNumRows, anOther.mNumColumns);
-
-			// now, copy over the row labels and column headers
-			mRowLabelsIndex = anOther.mRowLabelsIndex;
-			for (int r = 0; r < mNumRows; r++) {
-				mRowLabels[r] = anOther.mRowLabels[r];
-			}
-			mColumnHeadersIndex = anOther.mColumnHeadersIndex;
-			for (int c = 0; c < mNumColumns; c++) {
-				mColumnHeaders[c] = anOther.mColumnHeaders[c];
+static void makeVariantColumn( CKTableColumn & aColumn, int aRows,
+							   bool aKeepDense = false )
+{
+	if (aColumn.type != eUnknownVariant) {
+		CKTableColumn	column;
+		allocColumn(column, eUnknownVariant, aRows);
+		for (int i = 0; i < aRows; ++i) {
+			if (!isRowValid(aColumn.valid, i)) {
+				continue;
 			}
-
-			// finally we need to copy all the values from the table to us
-			int		cnt = mNumRows * mNumColumns;
-			for (int i = 0; i < cnt; i++) {
-				mTable[i] = anOther.mTable[i];
+			if (aColumn.type == eNumberVariant) {
+				column.variants[i].setDoubleValue(aColumn.doubles[i]);
+			} else {
+				column.variants[i].setDateValue(aColumn.dates[i]);
 			}
 		}
+		if (aKeepDense) {
+			aColumn.variants = column.variants;
+			CKFWAtomicFence();
+			aColumn.type = eUnknownVariant;
+		} else {
+			freeColumn(aColumn);
+			aColumn = column;
+		}
 	}
-	return *this;
 }
 
 
-/********************************************************
- *
- *                Accessor Methods
- *
- ********************************************************/
 /*
- * This method allows the user to set the *contents* of a given value
- * to the location specified in the table. It's important to note that
- * the actual object is *not* being placed into the table. Only it's
- * contents are being examined/copied into the table's datastructures.
+ * This does the simple math on a single CKVariant for mathRows() - the
+ * operation is one of '+', '-', '*', '/' or 'i' for the inverse.
  */
-void CKTable::setValue( int aRow, int aCol, const CKVariant & aValue )
+static void applyMath( CKVariant & aTarget, char anOp, double aValue )
 {
-	// first, make sure we have a place to put this data
-	if ((aRow < 0) || (aRow >= mNumRows) ||
-		(aCol < 0) || (aCol >= mNumColumns)) {
-		std::ostringstream	msg;
-		msg << "CKTable::setValue(int, int, const CKVariant &) - the provided "
-			"location: " << aRow << ", " << aCol << " lies outside the currently "
-			"defined table: " << mNumRows << " by " << mNumColumns;
-		throw CKException(__FILE__, __LINE__, msg.str());
+	switch (anOp) {
+		case '+':	aTarget += aValue;		break;
+		case '-':	aTarget -= aValue;		break;
+		case '*':	aTarget *= aValue;		break;
+		case '/':	aTarget /= aValue;		break;
+		case 'i':	aTarget.inverse();		break;
 	}
-	// ...and that we have a table structure that matches
-	if (mTable == NULL) {
-		std::ostringstream	msg;
-		msg << "CKTable::setValue(int, int, const CKVariant &) - there "
-			"is no currently defined table structure in this class. This is a "
-			"serious data integrity problem that needs to be looked into.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
-
-	// now set it intelligently
-	mTable[aRow * mNumColumns + aCol] = aValue;
 }
 
 
-void CKTable::setValue( int aRow, const CKString & aColHeader, const CKVariant & aValue )
+static void applyMath( CKVariant & aTarget, char anOp, const CKVariant & aValue )
 {
-	// convert the column header to a column index
-	int		col = getColumnForHeader(aColHeader);
-	if (col < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setValue(int, const CKString &, const CKVariant &)"
-			" - there is no currently defined column header '" << aColHeader <<
-			"' please make sure the column headers are properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
+	switch (anOp) {
+		case '+':	aTarget += aValue;		break;
+		case '-':	aTarget -= aValue;		break;
+		case '*':	aTarget *= aValue;		break;
+		case '/':	aTarget /= aValue;		break;
 	}
-
-	// then call the index-based method
-	setValue(aRow, col, aValue);
 }
 
 
-void CKTable::setValue( const CKString & aRowLabel, int aCol, const CKVariant & aValue )
-{
-	// convert the row label to a row index
-	int		row = getRowForLabel(aRowLabel);
-	if (row < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setValue(const CKString &, int, const CKVariant &)"
-			" - there is no currently defined row label '" << aRowLabel <<
-			"' please make sure the row labels are properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
-
-	// then call the index-based method
-	setValue(row, aCol, aValue);
-}
+/*
+ * This is the body of the parallelFor() for the work on a table. The
+ * range it's given is in blocks of CKTABLE_ROW_BLOCK rows, and this
+ * turns that into the rows for doRows() in the subclass - so the same
+ * doRows() is used whether the table is split up or not.
+ */
+class CKTableRowTask :
+	public ICKExecutorRangeTask
+{
+	public:
+		CKTableRowTask( int aNumRows ) : mNumRows(aNumRows) { }
+		virtual ~CKTableRowTask() { }
+		virtual void execute( int aBegin, int anEnd )
+		{
+			int		end = anEnd * CKTABLE_ROW_BLOCK;
+			doRows(aBegin * CKTABLE_ROW_BLOCK, (end < mNumRows ? end : mNumRows), aBegin);
+		}
+		/*
+		 * This does the rows from 'aBegin' up to, but not including,
+		 * 'anEnd'. 'aBlock' is the first block of them, which is handy for
+		 * keeping the results of each piece in order.
+		 */
+		virtual void doRows( int aBegin, int anEnd, int aBlock ) = 0;
+		/*
+		 * This is the number of rows the task does - usually all the
+		 * rows of the table.
+		 */
+		int getNumRows() const { return mNumRows; }
 
+	private:
+		int		mNumRows;
+};
 
-void CKTable::setValue( const CKString & aRowLabel, const CKString & aColHeader, const CKVariant & aValue )
-{
-	// convert the row label to a row index
-	int		row = getRowForLabel(aRowLabel);
-	if (row < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setValue(const CKString &, const CKString &, "
-			"const CKVariant &) - there is no currently defined row label '" <<
-			aRowLabel << "' please make sure the row labels are properly "
-			"defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
 
-	// convert the column header to a column index
-	int		col = getColumnForHeader(aColHeader);
-	if (col < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setValue(const CKString &, const CKString &, "
-			"const CKVariant &) - there is no currently defined column header '"
-			<< aColHeader << "' please make sure the column headers are "
-			"properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
+/*
+ * This does the simple math on the rows - with a value or with another
+ * table of the same size.
+ */
+class CKTableMathTask :
+	public CKTableRowTask
+{
+	public:
+		CKTableMathTask( CKTable *aTable, char anOp, double aValue ) :
+			CKTableRowTask(aTable->mNumRows), mTable(aTable), mOp(anOp),
+			mValue(aValue), mOther(NULL) { }
+		CKTableMathTask( CKTable *aTable, char anOp, const CKTable *anOther ) :
+			CKTableRowTask(aTable->mNumRows), mTable(aTable), mOp(anOp),
+			mValue(0.0), mOther(anOther) { }
+		virtual void doRows( int aBegin, int anEnd, int aBlock )
+		{
+			if (mOther == NULL) {
+				mTable->mathRows(mOp, mValue, aBegin, anEnd);
+			} else {
+				mTable->mathRows(mOp, *mOther, aBegin, anEnd);
+			}
+		}
 
-	// then call the index-based method
-	setValue(row, col, aValue);
-}
+	private:
+		CKTable			*mTable;
+		char			mOp;
+		double			mValue;
+		const CKTable	*mOther;
+};
 
 
 /*
- * This method sets the value at this location based on the type
- * of data that's represented in the supplied string. This string
- * will *not* be modified or retained in any way, as a copy will be
- * made for this instance, if it's necessary to have one. This is
- * the most general form of the setter for this instance.
+ * This copies the rows of the source table of a merge() into their
+ * places in the merged table. It's only split up when each source row
+ * has a row of its own in the merged table.
  */
-void CKTable::setValueAsType( int aRow, int aCol, CKVariantType aType,
-							  const char *aValue )
-{
-	// first, make sure we have a place to put this data
-	if ((aRow < 0) || (aRow >= mNumRows) ||
-		(aCol < 0) || (aCol >= mNumColumns)) {
-		std::ostringstream	msg;
-		msg << "CKTable::setValueAsType(int, int, CKVariantType, "
-			"const char *) - the provided location: " << aRow << ", " << aCol <<
-			" lies outside the currently defined table: " << mNumRows <<
-			" by " << mNumColumns;
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
-	// ...and that we have a table structure that matches
-	if (mTable == NULL) {
-		std::ostringstream	msg;
-		msg << "CKTable::setValueAsType(int, int, CKVariantType, "
-			"const char *) - there is no currently defined table structure in "
-			"this class. This is a serious data integrity problem that needs "
-			"to be looked into.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
+class CKTableMergeTask :
+	public CKTableRowTask
+{
+	public:
+		CKTableMergeTask( CKTable *aTable, const CKTable *aSource,
+						  const CKVector<int> *aTargetRow, const CKVector<int> *aTargetCol ) :
+			CKTableRowTask(aSource->mNumRows), mTable(aTable), mSource(aSource),
+			mTargetRow(aTargetRow), mTargetCol(aTargetCol) { }
+		virtual void doRows( int aBegin, int anEnd, int aBlock )
+		{
+			CKVariant	scratch;
+			int			cols = mSource->mNumColumns;
+			for (int row = aBegin; row < anEnd; row++) {
+				int		target = (*mTargetRow)[row];
+				for (int col = 0; col < cols; col++) {
+					if ((mTable->mColumns == NULL) && (mSource->mColumns == NULL)) {
+						mTable->mTable[target * mTable->mNumColumns + (*mTargetCol)[col]] =
+									mSource->mTable[row * cols + col];
+					} else {
+						mTable->setValue(target, (*mTargetCol)[col],
+										 mSource->readCell(row, col, scratch));
+					}
+				}
+			}
+		}
 
-	// now set it intelligently
-	mTable[aRow * mNumColumns + aCol].setValueAsType(aType, aValue);
-}
+	private:
+		CKTable					*mTable;
+		const CKTable			*mSource;
+		const CKVector<int>		*mTargetRow;
+		const CKVector<int>		*mTargetCol;
+};
 
 
-void CKTable::setValueAsType( int aRow, const CKString & aColHeader,
-							  CKVariantType aType, const char *aValue )
-{
-	// convert the column header to a column index
-	int		col = getColumnForHeader(aColHeader);
-	if (col < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setValueAsType(int, const CKString &, "
-			"CKVariantType, const char *) - there is no currently defined "
-			"column header '" << aColHeader << "' please make sure the column "
-			"headers are properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
+/*
+ * This writes the codes of the values in the rows, each followed by the
+ * placeholder delimiter. Each block of rows goes into a piece of its own
+ * so they can be put together in order at the end - and they're STL
+ * strings because a CKString grows by a fixed amount, and building up
+ * anything big that way is slow.
+ */
+class CKTableCodeTask :
+	public CKTableRowTask
+{
+	public:
+		CKTableCodeTask( const CKTable *aTable, std::vector<std::string> *aPieces ) :
+			CKTableRowTask(aTable->mNumRows), mTable(aTable), mPieces(aPieces) { }
+		virtual void doRows( int aBegin, int anEnd, int aBlock )
+		{
+			CKVariant	scratch;
+			for (int i = aBegin; i < anEnd; ++i) {
+				std::string	& buff = (*mPieces)[aBlock + (i - aBegin) / CKTABLE_ROW_BLOCK];
+				for (int j = 0; j < mTable->mNumColumns; ++j) {
+					const CKString	code = mTable->readCell(i, j, scratch).generateCodeFromValues();
+					buff.append(code.c_str(), code.size()).append(1, '\x01');
+				}
+			}
+		}
 
-	// then call the index-based method
-	setValueAsType(aRow, col, aType, aValue);
-}
+	private:
+		const CKTable				*mTable;
+		std::vector<std::string>	*mPieces;
+};
 
 
-void CKTable::setValueAsType( const CKString & aRowLabel, int aCol,
-							  CKVariantType aType, const char *aValue )
-{
-	// convert the row label to a row index
-	int		row = getRowForLabel(aRowLabel);
-	if (row < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setValueAsType(const CKString &, int, "
-			"CKVariantType, const char *) - there is no currently defined row "
-			"label '" << aRowLabel << "' please make sure the row labels are "
-			"properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
+/*
+ * This reads the values in the rows from their codes. 'aStarts' has
+ * where each value's code starts in the whole code, and the code of
+ * the value runs up to the delimiter before the next one's start.
+ */
+class CKTableParseTask :
+	public CKTableRowTask
+{
+	public:
+		CKTableParseTask( CKTable *aTable, const CKString *aCode,
+						  const std::vector<int> *aStarts, int aFirst ) :
+			CKTableRowTask(aTable->mNumRows), mTable(aTable), mCode(aCode),
+			mStarts(aStarts), mFirst(aFirst) { }
+		virtual void doRows( int aBegin, int anEnd, int aBlock )
+		{
+			const char	*code = mCode->c_str();
+			int			cols = mTable->mNumColumns;
+			for (int i = aBegin * cols; i < anEnd * cols; ++i) {
+				int		start = (*mStarts)[mFirst + i];
+				int		len = (*mStarts)[mFirst + i + 1] - 1 - start;
+				mTable->mTable[i].takeValuesFromCode(CKString(code, start, len));
+			}
+		}
 
-	// then call the index-based method
-	setValueAsType(row, aCol, aType, aValue);
-}
+	private:
+		CKTable					*mTable;
+		const CKString			*mCode;
+		const std::vector<int>	*mStarts;
+		int						mFirst;
+};
 
 
-void CKTable::setValueAsType( const CKString & aRowLabel, const CKString & aColHeader,
-							  CKVariantType aType, const char *aValue )
-{
-	// convert the row label to a row index
-	int		row = getRowForLabel(aRowLabel);
-	if (row < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setValueAsType(const CKString &, const CKString &, "
-			"CKVariantType, const char *) - there is no currently defined row "
-			"label '" << aRowLabel << "' please make sure the row labels are "
-			"properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
+/*
+ * This compares the values in the rows of the two tables, and marks
+ * it when any of them differ so all the other blocks can stop early.
+ */
+class CKTableCompareTask :
+	public CKTableRowTask
+{
+	public:
+		CKTableCompareTask( const CKTable *aTable, const CKTable *anOther ) :
+			CKTableRowTask(aTable->mNumRows), mTable(aTable), mOther(anOther),
+			mDiffers(0) { }
+		virtual void doRows( int aBegin, int anEnd, int aBlock )
+		{
+			int		cols = mTable->mNumColumns;
+			if ((mTable->mTable != NULL) && (mOther->mTable != NULL)) {
+				for (int i = aBegin * cols; (mDiffers == 0) && (i < anEnd * cols); ++i) {
+					if (mTable->mTable[i] != mOther->mTable[i]) {
+						CKFWAtomicAdd(&mDiffers, 1);
+					}
+				}
+			} else {
+				// one of them is columnar, so it's the values and not the layout
+				CKVariant	mine;
+				CKVariant	his;
+				for (int i = aBegin; (mDiffers == 0) && (i < anEnd); ++i) {
+					for (int j = 0; j < cols; ++j) {
+						if (mTable->readCell(i, j, mine) != mOther->readCell(i, j, his)) {
+							CKFWAtomicAdd(&mDiffers, 1);
+							break;
+						}
+					}
+				}
+			}
+		}
+		bool differs() const { return (mDiffers != 0); }
 
-	// convert the column header to a column index
-	int		col = getColumnForHeader(aColHeader);
-	if (col < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setValueAsType(const CKString &, const CKString &, "
-			"CKVariantType, const char *) - there is no currently defined "
-			"column header '" << aColHeader << "' please make sure the column "
-			"headers are properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
+	private:
+		const CKTable	*mTable;
+		const CKTable	*mOther;
+		volatile long	mDiffers;
+};
 
-	// then call the index-based method
-	setValueAsType(row, col, aType, aValue);
-}
+
+/*
+ * This is the sort key of one column - the kind of each cell, and its
+ * number or its string. Numbers and dates sort before strings, and the
+ * empty cells - and NaNs, that have no order - come after everything,
+ * which is why the kinds are numbered the way they are.
+ */
+#define	CKTABLE_NUMBER_KEY		0
+#define	CKTABLE_STRING_KEY		1
+#define	CKTABLE_EMPTY_KEY		2
+
+struct CKTableSortKey {
+	bool						ascending;
+	std::vector<char>			kinds;
+	std::vector<double>			numbers;
+	std::vector<std::string>	strings;
+};
 
 
 /*
- * This sets the value stored in this location as a string, but a local
- * copy will be made so that the caller doesn't have to worry about
- * holding on to the parameter, and is free to delete it.
+ * This puts the sort key of one cell into the key for the column.
  */
-void CKTable::setStringValue( int aRow, int aCol, const char *aStringValue )
-{
-	// first, make sure we have a place to put this data
-	if ((aRow < 0) || (aRow >= mNumRows) ||
-		(aCol < 0) || (aCol >= mNumColumns)) {
-		std::ostringstream	msg;
-		msg << "CKTable::setStringValue(int, int, const char *) - the "
-			"provided location: " << aRow << ", " << aCol << " lies outside "
-			"the currently defined table: " << mNumRows << " by " <<
-			mNumColumns;
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
-	// ...and that we have a table structure that matches
-	if (mTable == NULL) {
-		std::ostringstream	msg;
-		msg << "CKTable::setStringValue(int, int, const char *) - there "
-			"is no currently defined table structure in this class. This is a "
-			"serious data integrity problem that needs to be looked into.";
-		throw CKException(__FILE__, __LINE__, msg.str());
+static void sortKeyOfCell( const CKVariant & aCell, CKTableSortKey & aKey, int aRow )
+{
+	switch (aCell.getType()) {
+		case eUnknownVariant:
+			aKey.kinds[aRow] = CKTABLE_EMPTY_KEY;
+			break;
+		case eNumberVariant:
+			aKey.numbers[aRow] = aCell.getDoubleValue();
+			aKey.kinds[aRow] = (isnan(aKey.numbers[aRow]) ?
+								CKTABLE_EMPTY_KEY : CKTABLE_NUMBER_KEY);
+			break;
+		case eDateVariant:
+			aKey.numbers[aRow] = aCell.getDateValue();
+			aKey.kinds[aRow] = CKTABLE_NUMBER_KEY;
+			break;
+		case eStringVariant:
+			if (aCell.getStringValue() != NULL) {
+				const CKString	*str = aCell.getStringValue();
+				aKey.strings[aRow].assign(str->c_str(), str->size());
+			}
+			aKey.kinds[aRow] = CKTABLE_STRING_KEY;
+			break;
+		default:
+			{
+				CKString	str = aCell.getValueAsString();
+				aKey.strings[aRow].assign(str.c_str(), str.size());
+				aKey.kinds[aRow] = CKTABLE_STRING_KEY;
+			}
+			break;
 	}
-
-	// now set it intelligently
-	mTable[aRow * mNumColumns + aCol].setStringValue(aStringValue);
 }
 
 
-void CKTable::setStringValue( int aRow, const CKString & aColHeader, const char *aStringValue )
+/*
+ * The group key of a cell is its type, as one character, and then its
+ * value as a string - so the number 1, the date 1 and the string "1"
+ * are all different groups. An empty cell is the empty key, which no
+ * typed key can be, so it's a group of its own - and not the same as
+ * an empty string.
+ */
+#define	CKTABLE_GROUP_TAG(type)		((char)('A' + (type)))
+
+/*
+ * This puts the key a number is grouped by into the key - the value as
+ * short as it can be and still come back as the same number, so that
+ * two different numbers are never in the same group. As everywhere
+ * else, -0 is the same as 0, and all the NaNs are one group.
+ */
+static void groupKeyOfNumber( double aValue, std::string & aKey )
 {
-	// convert the column header to a column index
-	int		col = getColumnForHeader(aColHeader);
-	if (col < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setStringValue(int, const CKString &, "
-			"const char *) - there is no currently defined "
-			"column header '" << aColHeader << "' please make sure the column "
-			"headers are properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
+	char	buff[64];
+	buff[0] = CKTABLE_GROUP_TAG(eNumberVariant);
+	if (isnan(aValue)) {
+		strcpy(&buff[1], "nan");
+	} else {
+		if (aValue == 0.0) {
+			aValue = 0.0;
+		}
+		snprintf(&buff[1], sizeof(buff) - 1, "%.15g", aValue);
+		if (strtod(&buff[1], NULL) != aValue) {
+			snprintf(&buff[1], sizeof(buff) - 1, "%.17g", aValue);
+		}
 	}
-
-	// then call the index-based method
-	setStringValue(aRow, col, aStringValue);
+	aKey.assign(buff);
 }
 
 
-void CKTable::setStringValue( const CKString & aRowLabel, int aCol, const char *aStringValue )
-{
-	// convert the row label to a row index
-	int		row = getRowForLabel(aRowLabel);
-	if (row < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setStringValue(const CKString &, int, "
-			"const char *) - there is no currently defined row "
-			"label '" << aRowLabel << "' please make sure the row labels are "
-			"properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
+/*
+ * This puts the key a cell is grouped by into the key.
+ */
+static void groupKeyOfCell( const CKVariant & aCell, std::string & aKey )
+{
+	switch (aCell.getType()) {
+		case eUnknownVariant:
+			aKey.clear();
+			break;
+		case eNumberVariant:
+			groupKeyOfNumber(aCell.getDoubleValue(), aKey);
+			break;
+		case eStringVariant:
+			aKey.assign(1, CKTABLE_GROUP_TAG(eStringVariant));
+			if (aCell.getStringValue() != NULL) {
+				aKey.append(aCell.getStringValue()->c_str(),
+							aCell.getStringValue()->size());
+			}
+			break;
+		default:
+			{
+				CKString	str = aCell.getValueAsString();
+				aKey.assign(1, CKTABLE_GROUP_TAG(aCell.getType()));
+				aKey.append(str.c_str(), str.size());
+			}
+			break;
 	}
-
-	// then call the index-based method
-	setStringValue(row, aCol, aStringValue);
 }
 
 
-void CKTable::setStringValue( const CKString & aRowLabel, const CKString & aColHeader, const char *aStringValue )
+/*
+ * This is what's actually sorted for each row - its number, with the
+ * kind of its first key and either the number, or the first few bytes
+ * of the string, right there. Most of the time that's all it takes to
+ * put two rows in order, without going off to the keys for the row.
+ * If they're still tied, 'next' is the key to go on with - the second
+ * one, unless the string didn't all fit.
+ */
+struct CKTableSortEntry {
+	double		prefix;
+	int			row;
+	char		kind;
+	char		next;
+};
+
+
+/*
+ * This packs the first five bytes of the string - with zeros after the
+ * end - and its length, up to six, into a number that's exact in a
+ * double. They're in the same order as the strings, as far as they go,
+ * and if the string is five bytes or less, it's all there.
+ */
+static double prefixOfString( const std::string & aString, char & aNext )
 {
-	// convert the row label to a row index
-	int		row = getRowForLabel(aRowLabel);
-	if (row < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setStringValue(const CKString &, const CKString &, "
-			"const char *) - there is no currently defined row "
-			"label '" << aRowLabel << "' please make sure the row labels are "
-			"properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
+	double		retval = 0.0;
+	int			len = aString.size();
+	for (int i = 0; i < 5; ++i) {
+		retval = retval * 256.0 + (i < len ? (unsigned char)aString[i] : 0);
 	}
+	aNext = (len <= 5 ? 1 : 0);
+	return retval * 256.0 + (len <= 5 ? len : 6);
+}
 
-	// convert the column header to a column index
-	int		col = getColumnForHeader(aColHeader);
-	if (col < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setStringValue(const CKString &, const CKString &, "
-			"const char *) - there is no currently defined "
-			"column header '" << aColHeader << "' please make sure the column "
-			"headers are properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
 
-	// then call the index-based method
-	setStringValue(row, col, aStringValue);
-}
+/*
+ * This is the order of the rows for a sort - by each key in turn, and
+ * then by the row number, so no two rows are ever equal and the sort
+ * is stable however it's done.
+ */
+class CKTableRowOrder
+{
+	public:
+		CKTableRowOrder( const std::vector<CKTableSortKey> *aKeys ) : mKeys(aKeys) { }
+		bool operator()( const CKTableSortEntry & anEntry,
+						 const CKTableSortEntry & anOther ) const
+		{
+			// the first key is right there - if that decides it, we're done
+			if (anEntry.kind != anOther.kind) {
+				return (anEntry.kind < anOther.kind);
+			}
+			if ((anEntry.kind != CKTABLE_EMPTY_KEY) && (anEntry.prefix != anOther.prefix)) {
+				return ((*mKeys)[0].ascending ? (anEntry.prefix < anOther.prefix) :
+												(anEntry.prefix > anOther.prefix));
+			}
+			// ...a long string needs the rest of it, anything else the next key
+			return isBefore(anEntry.next, anEntry.row, anOther.row);
+		}
+		bool isBefore( unsigned int aKey, int aRow, int anOther ) const
+		{
+			for (unsigned int k = aKey; k < mKeys->size(); ++k) {
+				const CKTableSortKey	& key = (*mKeys)[k];
+				char	kind = key.kinds[aRow];
+				if (kind != key.kinds[anOther]) {
+					return (kind < key.kinds[anOther]);
+				}
+				if (kind == CKTABLE_NUMBER_KEY) {
+					double	a = key.numbers[aRow];
+					double	b = key.numbers[anOther];
+					if (a != b) {
+						return (key.ascending ? (a < b) : (a > b));
+					}
+				} else if (kind == CKTABLE_STRING_KEY) {
+					int		c = key.strings[aRow].compare(key.strings[anOther]);
+					if (c != 0) {
+						return (key.ascending ? (c < 0) : (c > 0));
+					}
+				}
+			}
+			return (aRow < anOther);
+		}
 
+	private:
+		const std::vector<CKTableSortKey>	*mKeys;
+};
 
-void CKTable::setStringValue( int aRow, int aCol, const CKString *aStringValue )
-{
-	// first, make sure we have a place to put this data
-	if ((aRow < 0) || (aRow >= mNumRows) ||
-		(aCol < 0) || (aCol >= mNumColumns)) {
-		std::ostringstream	msg;
-		msg << "CKTable::setStringValue(int, int, const CKString *) - the "
-			"provided location: " << aRow << ", " << aCol << " lies outside "
-			"the currently defined table: " << mNumRows << " by " <<
-			mNumColumns;
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
-	// ...and that we have a table structure that matches
-	if (mTable == NULL) {
-		std::ostringstream	msg;
-		msg << "CKTable::setStringValue(int, int, const CKString *) - there "
-			"is no currently defined table structure in this class. This is a "
-			"serious data integrity problem that needs to be looked into.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
 
-	// now set it intelligently
-	mTable[aRow * mNumColumns + aCol].setStringValue(aStringValue);
-}
+/*
+ * This sorts each of the runs of the rows given by the bounds - run
+ * 'i' is from bounds[i] up to bounds[i+1].
+ */
+class CKTableSortRunsTask :
+	public ICKExecutorRangeTask
+{
+	public:
+		CKTableSortRunsTask( CKTableSortEntry *aRows, const std::vector<int> *aBounds,
+							 const CKTableRowOrder *anOrder ) :
+			mRows(aRows), mBounds(aBounds), mOrder(anOrder) { }
+		virtual void execute( int aBegin, int anEnd )
+		{
+			for (int i = aBegin; i < anEnd; ++i) {
+				std::sort(mRows + (*mBounds)[i], mRows + (*mBounds)[i + 1], *mOrder);
+			}
+		}
 
+	private:
+		CKTableSortEntry			*mRows;
+		const std::vector<int>		*mBounds;
+		const CKTableRowOrder		*mOrder;
+};
 
-void CKTable::setStringValue( int aRow, const CKString & aColHeader, const CKString *aStringValue )
-{
-	// convert the column header to a column index
-	int		col = getColumnForHeader(aColHeader);
-	if (col < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setStringValue(int, const CKString &, "
-			"const CKString *) - there is no currently defined "
-			"column header '" << aColHeader << "' please make sure the column "
-			"headers are properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
 
-	// then call the index-based method
-	setStringValue(aRow, col, aStringValue);
-}
+/*
+ * This merges the sorted runs two at a time from one array to the
+ * other - pair 'i' is runs 2i and 2i+1 - and copies the last run over
+ * if it has no partner.
+ */
+class CKTableMergeRunsTask :
+	public ICKExecutorRangeTask
+{
+	public:
+		CKTableMergeRunsTask( const CKTableSortEntry *aSource, CKTableSortEntry *aTarget,
+							  const std::vector<int> *aBounds,
+							  const CKTableRowOrder *anOrder ) :
+			mSource(aSource), mTarget(aTarget), mBounds(aBounds), mOrder(anOrder) { }
+		virtual void execute( int aBegin, int anEnd )
+		{
+			int		runs = mBounds->size() - 1;
+			for (int i = aBegin; i < anEnd; ++i) {
+				int		b = (*mBounds)[2 * i];
+				int		m = (2 * i + 1 < runs ? (*mBounds)[2 * i + 1] : (*mBounds)[runs]);
+				int		e = (2 * i + 2 <= runs ? (*mBounds)[2 * i + 2] : (*mBounds)[runs]);
+				std::merge(mSource + b, mSource + m, mSource + m, mSource + e,
+						   mTarget + b, *mOrder);
+			}
+		}
 
-
-void CKTable::setStringValue( const CKString & aRowLabel, int aCol, const CKString *aStringValue )
-{
-	// convert the row label to a row index
-	int		row = getRowForLabel(aRowLabel);
-	if (row < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setStringValue(const CKString &, int, "
-			"const CKString *) - there is no currently defined row "
-			"label '" << aRowLabel << "' please make sure the row labels are "
-			"properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
-
-	// then call the index-based method
-	setStringValue(row, aCol, aStringValue);
-}
+	private:
+		const CKTableSortEntry		*mSource;
+		CKTableSortEntry			*mTarget;
+		const std::vector<int>		*mBounds;
+		const CKTableRowOrder		*mOrder;
+};
 
 
-void CKTable::setStringValue( const CKString & aRowLabel, const CKString & aColHeader, const CKString *aStringValue )
-{
-	// convert the row label to a row index
-	int		row = getRowForLabel(aRowLabel);
-	if (row < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setStringValue(const CKString &, const CKString &, "
-			"const CKString *) - there is no currently defined row "
-			"label '" << aRowLabel << "' please make sure the row labels are "
-			"properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
+/*
+ * This sorts the rows in the order. If it's worth splitting up, the
+ * rows are cut into a couple of runs for each thread in the pool, each
+ * run is sorted on its own, and then they're merged a pair at a time
+ * until there's just one.
+ */
+static void sortRows( std::vector<CKTableSortEntry> & aRows, const CKTableRowOrder & anOrder,
+					  bool aSplit )
+{
+	int		count = aRows.size();
+	int		runs = (aSplit ? 2 * CKTable::getParallelExecutor()->getNumberOfThreads() : 1);
+	if ((runs <= 1) || (count < 2 * runs)) {
+		std::sort(aRows.begin(), aRows.end(), anOrder);
+		return;
+	}
+
+	std::vector<int>	bounds(runs + 1);
+	for (int i = 0; i <= runs; ++i) {
+		bounds[i] = (int)((double)count * i / runs);
+	}
+	CKTableSortRunsTask		sorter(&aRows[0], &bounds, &anOrder);
+	CKTable::getParallelExecutor()->parallelFor(0, runs, sorter, 1);
+
+	std::vector<CKTableSortEntry>	other(count);
+	CKTableSortEntry				*source = &aRows[0];
+	CKTableSortEntry				*target = &other[0];
+	while (bounds.size() > 2) {
+		int		pairs = bounds.size() / 2;
+		CKTableMergeRunsTask	merger(source, target, &bounds, &anOrder);
+		CKTable::getParallelExecutor()->parallelFor(0, pairs, merger, 1);
+		// every other bound goes, but the end always stays
+		std::vector<int>	merged;
+		for (unsigned int i = 0; i < bounds.size() - 1; i += 2) {
+			merged.push_back(bounds[i]);
+		}
+		merged.push_back(count);
+		bounds.swap(merged);
+		CKTableSortEntry	*hold = source;
+		source = target;
+		target = hold;
 	}
-
-	// convert the column header to a column index
-	int		col = getColumnForHeader(aColHeader);
-	if (col < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setStringValue(const CKString &, const CKString &, "
-			"const CKString *) - there is no currently defined "
-			"column header '" << aColHeader << "' please make sure the column "
-			"headers are properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
+	if (source != &aRows[0]) {
+		aRows.swap(other);
 	}
-
-	// then call the index-based method
-	setStringValue(row, col, aStringValue);
 }
 
 
 /*
- * This method sets the value stored in this location as a date of the
- * form YYYYMMDD - stored as a long.
+ * This gets the sort key of each cell in the rows of one column.
  */
-void CKTable::setDateValue( int aRow, int aCol, long aDateValue )
-{
-	// first, make sure we have a place to put this data
-	if ((aRow < 0) || (aRow >= mNumRows) ||
-		(aCol < 0) || (aCol >= mNumColumns)) {
-		std::ostringstream	msg;
-		msg << "CKTable::setDateValue(int, int, long) - the "
-			"provided location: " << aRow << ", " << aCol << " lies outside "
-			"the currently defined table: " << mNumRows << " by " <<
-			mNumColumns;
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
-	// ...and that we have a table structure that matches
-	if (mTable == NULL) {
-		std::ostringstream	msg;
-		msg << "CKTable::setDateValue(int, int, long) - there "
-			"is no currently defined table structure in this class. This is a "
-			"serious data integrity problem that needs to be looked into.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
-
-	// now set it intelligently
-	mTable[aRow * mNumColumns + aCol].setDateValue(aDateValue);
-}
+class CKTableSortKeyTask :
+	public CKTableRowTask
+{
+	public:
+		CKTableSortKeyTask( const CKTable *aTable, int aCol, CKTableSortKey *aKey ) :
+			CKTableRowTask(aTable->mNumRows), mTable(aTable), mCol(aCol), mKey(aKey) { }
+		virtual void doRows( int aBegin, int anEnd, int aBlock )
+		{
+			if ((mTable->mColumns != NULL) &&
+				(mTable->mColumns[mCol].type != eUnknownVariant)) {
+				// a dense column is just the numbers - or dates - and the bits
+				const CKTableColumn	& column = mTable->mColumns[mCol];
+				for (int i = aBegin; i < anEnd; ++i) {
+					if (!isRowValid(column.valid, i)) {
+						mKey->kinds[i] = CKTABLE_EMPTY_KEY;
+					} else if (column.type == eDateVariant) {
+						mKey->numbers[i] = column.dates[i];
+						mKey->kinds[i] = CKTABLE_NUMBER_KEY;
+					} else {
+						mKey->numbers[i] = column.doubles[i];
+						mKey->kinds[i] = (isnan(column.doubles[i]) ?
+										  CKTABLE_EMPTY_KEY : CKTABLE_NUMBER_KEY);
+					}
+				}
+			} else {
+				CKVariant	scratch;
+				for (int i = aBegin; i < anEnd; ++i) {
+					sortKeyOfCell(mTable->readCell(i, mCol, scratch), *mKey, i);
+				}
+			}
+		}
 
+	private:
+		const CKTable		*mTable;
+		int					mCol;
+		CKTableSortKey		*mKey;
+};
 
-void CKTable::setDateValue( int aRow, const CKString & aColHeader, long aDateValue )
-{
-	// convert the column header to a column index
-	int		col = getColumnForHeader(aColHeader);
-	if (col < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setDateValue(int, const CKString &, "
-			"long) - there is no currently defined "
-			"column header '" << aColHeader << "' please make sure the column "
-			"headers are properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
 
-	// then call the index-based method
-	setDateValue(aRow, col, aDateValue);
-}
+/*
+ * This marks each of the rows that passes the test - the filter's, or
+ * the comparison of the numbers in the column with the value.
+ */
+class CKTableFilterTask :
+	public CKTableRowTask
+{
+	public:
+		CKTableFilterTask( const CKTable *aTable, const ICKTableRowFilter *aFilter,
+						   std::vector<char> *aMarks ) :
+			CKTableRowTask(aTable->mNumRows), mTable(aTable), mFilter(aFilter),
+			mCol(-1), mTest(eEqualTest), mValue(0.0), mMarks(aMarks) { }
+		CKTableFilterTask( const CKTable *aTable, int aCol, CKTableTest aTest,
+						   double aValue, std::vector<char> *aMarks ) :
+			CKTableRowTask(aTable->mNumRows), mTable(aTable), mFilter(NULL),
+			mCol(aCol), mTest(aTest), mValue(aValue), mMarks(aMarks) { }
+		virtual void doRows( int aBegin, int anEnd, int aBlock )
+		{
+			if (mFilter != NULL) {
+				for (int i = aBegin; i < anEnd; ++i) {
+					(*mMarks)[i] = mFilter->keepRow(*mTable, i);
+				}
+				return;
+			}
 
+			const CKTableColumn	*column = (mTable->mColumns == NULL ? NULL :
+											&mTable->mColumns[mCol]);
+			if ((column != NULL) && (column->type == eNumberVariant)) {
+				// a dense column of numbers is read right from the array
+				for (int i = aBegin; i < anEnd; ++i) {
+					(*mMarks)[i] = (isRowValid(column->valid, i) &&
+									passes(column->doubles[i]));
+				}
+			} else if ((column != NULL) && (column->type == eDateVariant)) {
+				for (int i = aBegin; i < anEnd; ++i) {
+					(*mMarks)[i] = (isRowValid(column->valid, i) &&
+									passes(column->dates[i]));
+				}
+			} else {
+				CKVariant	scratch;
+				for (int i = aBegin; i < anEnd; ++i) {
+					const CKVariant	& cell = mTable->readCell(i, mCol, scratch);
+					if (cell.getType() == eNumberVariant) {
+						(*mMarks)[i] = passes(cell.getDoubleValue());
+					} else if (cell.getType() == eDateVariant) {
+						(*mMarks)[i] = passes(cell.getDateValue());
+					} else {
+						(*mMarks)[i] = false;
+					}
+				}
+			}
+		}
 
-void CKTable::setDateValue( const CKString & aRowLabel, int aCol, long aDateValue )
-{
-	// convert the row label to a row index
-	int		row = getRowForLabel(aRowLabel);
-	if (row < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setDateValue(const CKString &, int, "
-			"long) - there is no currently defined row "
-			"label '" << aRowLabel << "' please make sure the row labels are "
-			"properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
+	private:
+		bool passes( double aNumber ) const
+		{
+			switch (mTest) {
+				case eLessThanTest:			return (aNumber < mValue);
+				case eLessOrEqualTest:		return (aNumber <= mValue);
+				case eEqualTest:			return (aNumber == mValue);
+				case eNotEqualTest:			return (aNumber != mValue);
+				case eGreaterOrEqualTest:	return (aNumber >= mValue);
+				case eGreaterThanTest:		return (aNumber > mValue);
+			}
+			return false;
+		}
 
-	// then call the index-based method
-	setDateValue(row, aCol, aDateValue);
-}
+		const CKTable				*mTable;
+		const ICKTableRowFilter		*mFilter;
+		int							mCol;
+		CKTableTest					mTest;
+		double						mValue;
+		std::vector<char>			*mMarks;
+};
 
 
-void CKTable::setDateValue( const CKString & aRowLabel, const CKString & aColHeader, long aDateValue )
-{
-	// convert the row label to a row index
-	int		row = getRowForLabel(aRowLabel);
-	if (row < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setDateValue(const CKString &, const CKString &, "
-			"long) - there is no currently defined row "
-			"label '" << aRowLabel << "' please make sure the row labels are "
-			"properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
+/*
+ * This fills in the new rows of gatherRows() from the rows of the table
+ * they come from. It's done in two passes - first the copies and then
+ * the moves - so a row that's given more than once is copied before it's
+ * moved away. The dense columns are always copied, in the first pass.
+ * Each block of new rows starts on a byte of the bitmaps, so the blocks
+ * never write the same byte.
+ */
+class CKTableGatherTask :
+	public CKTableRowTask
+{
+	public:
+		CKTableGatherTask( const CKTable *aTable, const std::vector<int> *aRows,
+						   const std::vector<char> *aMoves, bool aMovePass,
+						   CKVariant *aCells, CKTableColumn *aColumns,
+						   CKString *aLabels ) :
+			CKTableRowTask(aRows->size()), mTable(aTable), mRows(aRows),
+			mMoves(aMoves), mMovePass(aMovePass), mCells(aCells),
+			mColumns(aColumns), mLabels(aLabels) { }
+		virtual void doRows( int aBegin, int anEnd, int aBlock )
+		{
+			int		cols = mTable->mNumColumns;
+			int		rows = mRows->size();
+			for (int i = aBegin; i < anEnd; ++i) {
+				int		from = (*mRows)[i];
+				bool	move = ((*mMoves)[i] != 0);
+				if (i + CKTABLE_PREFETCH_AHEAD < rows) {
+					prefetchRow((*mRows)[i + CKTABLE_PREFETCH_AHEAD]);
+				}
+				if (mCells != NULL) {
+					if (move == mMovePass) {
+						CKVariant	*source = &mTable->mTable[from * cols];
+						CKVariant	*target = &mCells[i * cols];
+						for (int j = 0; j < cols; ++j) {
+							if (move) {
+								target[j].swap(source[j]);
+							} else {
+								target[j] = source[j];
+							}
+						}
+					}
+				} else {
+					for (int j = 0; j < cols; ++j) {
+						const CKTableColumn	& source = mTable->mColumns[j];
+						CKTableColumn		& target = mColumns[j];
+						if (source.type == eUnknownVariant) {
+							if (move != mMovePass) {
+								// not this pass
+							} else if (move) {
+								target.variants[i].swap(source.variants[from]);
+							} else {
+								target.variants[i] = source.variants[from];
+							}
+						} else if (!mMovePass && isRowValid(source.valid, from)) {
+							if (source.type == eNumberVariant) {
+								target.doubles[i] = source.doubles[from];
+							} else {
+								target.dates[i] = source.dates[from];
+							}
+							markRow(target.valid, i, true);
+						}
+					}
+				}
+				if (move == mMovePass) {
+					if (move) {
+						mLabels[i].swap(mTable->mRowLabels[from]);
+					} else {
+						mLabels[i] = mTable->mRowLabels[from];
+					}
+				}
+			}
+		}
 
-	// convert the column header to a column index
-	int		col = getColumnForHeader(aColHeader);
-	if (col < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setDateValue(const CKString &, const CKString &, "
-			"long) - there is no currently defined "
-			"column header '" << aColHeader << "' please make sure the column "
-			"headers are properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
+	private:
+		/*
+		 * This asks for the cells and label of a row that's coming up
+		 * so they're in the cache by the time it's gathered.
+		 */
+		void prefetchRow( int aRow ) const
+		{
+			int		cols = mTable->mNumColumns;
+			if (mCells != NULL) {
+				const CKVariant	*source = &mTable->mTable[aRow * cols];
+				for (int j = 0; j < cols; ++j) {
+					CKTABLE_PREFETCH(&source[j]);
+				}
+			} else {
+				for (int j = 0; j < cols; ++j) {
+					const CKTableColumn	& source = mTable->mColumns[j];
+					if (source.type == eUnknownVariant) {
+						CKTABLE_PREFETCH(&source.variants[aRow]);
+					} else if (source.type == eNumberVariant) {
+						CKTABLE_PREFETCH(&source.doubles[aRow]);
+					} else {
+						CKTABLE_PREFETCH(&source.dates[aRow]);
+					}
+				}
+			}
+			CKTABLE_PREFETCH(&mTable->mRowLabels[aRow]);
+		}
 
-	// then call the index-based method
-	setDateValue(row, col, aDateValue);
-}
+		const CKTable				*mTable;
+		const std::vector<int>		*mRows;
+		const std::vector<char>		*mMoves;
+		bool						mMovePass;
+		CKVariant					*mCells;
+		CKTableColumn				*mColumns;
+		CKString					*mLabels;
+};
 
 
 /*
- * This method sets the value stored in this location as a double.
+ * This gets the key each cell in the rows of one column is grouped by.
+ * The keys start out empty, which is right for the empty cells of a
+ * dense column.
  */
-void CKTable::setDoubleValue( int aRow, int aCol, double aDoubleValue )
-{
-	// first, make sure we have a place to put this data
-	if ((aRow < 0) || (aRow >= mNumRows) ||
-		(aCol < 0) || (aCol >= mNumColumns)) {
-		std::ostringstream	msg;
-		msg << "CKTable::setDoubleValue(int, int, long) - the "
-			"provided location: " << aRow << ", " << aCol << " lies outside "
-			"the currently defined table: " << mNumRows << " by " <<
-			mNumColumns;
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
-	// ...and that we have a table structure that matches
-	if (mTable == NULL) {
-		std::ostringstream	msg;
-		msg << "CKTable::setDoubleValue(int, int, long) - there "
-			"is no currently defined table structure in this class. This is a "
-			"serious data integrity problem that needs to be looked into.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
-
-	// now set it intelligently
-	mTable[aRow * mNumColumns + aCol].setDoubleValue(aDoubleValue);
-}
+class CKTableGroupKeyTask :
+	public CKTableRowTask
+{
+	public:
+		CKTableGroupKeyTask( const CKTable *aTable, int aCol,
+							 std::vector<std::string> *aKeys ) :
+			CKTableRowTask(aTable->mNumRows), mTable(aTable), mCol(aCol), mKeys(aKeys) { }
+		virtual void doRows( int aBegin, int anEnd, int aBlock )
+		{
+			if ((mTable->mColumns != NULL) &&
+				(mTable->mColumns[mCol].type == eNumberVariant)) {
+				const CKTableColumn	& column = mTable->mColumns[mCol];
+				for (int i = aBegin; i < anEnd; ++i) {
+					if (isRowValid(column.valid, i)) {
+						groupKeyOfNumber(column.doubles[i], (*mKeys)[i]);
+					}
+				}
+			} else {
+				CKVariant	scratch;
+				for (int i = aBegin; i < anEnd; ++i) {
+					groupKeyOfCell(mTable->readCell(i, mCol, scratch), (*mKeys)[i]);
+				}
+			}
+		}
 
+	private:
+		const CKTable				*mTable;
+		int							mCol;
+		std::vector<std::string>	*mKeys;
+};
 
-void CKTable::setDoubleValue( int aRow, const CKString & aColHeader, double aDoubleValue )
-{
-	// convert the column header to a column index
-	int		col = getColumnForHeader(aColHeader);
-	if (col < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setDoubleValue(int, const CKString &, "
-			"double) - there is no currently defined "
-			"column header '" << aColHeader << "' please make sure the column "
-			"headers are properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
 
-	// then call the index-based method
-	setDoubleValue(aRow, col, aDoubleValue);
-}
+/*
+ * These are the keys of the rows of a table for a join - the typed key
+ * of each of its key columns, just as for a sort, and the hash of them
+ * all for each row. A hash of zero means one of the keys is empty, so
+ * the row never matches anything.
+ */
+struct CKTableJoinKeys {
+	std::vector<CKTableSortKey>		keys;
+	std::vector<unsigned int>		hashes;
+};
 
 
-void CKTable::setDoubleValue( const CKString & aRowLabel, int aCol, double aDoubleValue )
+/*
+ * This returns true if the keys of the row of one table are the same
+ * as the keys of the row of the other. The hashes have to match first,
+ * so most rows that don't match are never compared.
+ */
+static bool isSameJoinKey( const CKTableJoinKeys & aKeys, int aRow,
+						   const CKTableJoinKeys & anOther, int anOtherRow )
 {
-	// convert the row label to a row index
-	int		row = getRowForLabel(aRowLabel);
-	if (row < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setDoubleValue(const CKString &, int, "
-			"double) - there is no currently defined row "
-			"label '" << aRowLabel << "' please make sure the row labels are "
-			"properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
+	if ((aKeys.hashes[aRow] == 0) || (aKeys.hashes[aRow] != anOther.hashes[anOtherRow])) {
+		return false;
 	}
-
-	// then call the index-based method
-	setDoubleValue(row, aCol, aDoubleValue);
+	for (unsigned int k = 0; k < aKeys.keys.size(); ++k) {
+		const CKTableSortKey	& key = aKeys.keys[k];
+		const CKTableSortKey	& other = anOther.keys[k];
+		if (key.kinds[aRow] != other.kinds[anOtherRow]) {
+			return false;
+		}
+		if (key.kinds[aRow] == CKTABLE_NUMBER_KEY) {
+			if (key.numbers[aRow] != other.numbers[anOtherRow]) {
+				return false;
+			}
+		} else if (key.strings[aRow] != other.strings[anOtherRow]) {
+			return false;
+		}
+	}
+	return true;
 }
 
 
-void CKTable::setDoubleValue( const CKString & aRowLabel, const CKString & aColHeader, double aDoubleValue )
-{
-	// convert the row label to a row index
-	int		row = getRowForLabel(aRowLabel);
-	if (row < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setDoubleValue(const CKString &, const CKString &, "
-			"double) - there is no currently defined row "
-			"label '" << aRowLabel << "' please make sure the row labels are "
-			"properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
-
-	// convert the column header to a column index
-	int		col = getColumnForHeader(aColHeader);
-	if (col < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setDoubleValue(const CKString &, const CKString &, "
-			"double) - there is no currently defined "
-			"column header '" << aColHeader << "' please make sure the column "
-			"headers are properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
+/*
+ * This is the hash table of the rows of one table for a join. Each
+ * bucket is a chain of rows, and the rows are added at the front, so
+ * adding them last to first leaves every chain in order. It's only
+ * read once it's made, so any number of threads can look in it.
+ */
+class CKTableJoinIndex
+{
+	public:
+		CKTableJoinIndex( const CKTableJoinKeys *aKeys, int aNumRows ) :
+			mKeys(aKeys), mMask(0), mHeads(), mNext(aNumRows, -1)
+		{
+			int		buckets = 1;
+			while (buckets < aNumRows) {
+				buckets *= 2;
+			}
+			mMask = buckets - 1;
+			mHeads.assign(buckets, -1);
+		}
+		void add( int aRow )
+		{
+			unsigned int	bucket = mKeys->hashes[aRow] & mMask;
+			mNext[aRow] = mHeads[bucket];
+			mHeads[bucket] = aRow;
+		}
+		/*
+		 * This returns the next row in the index - after 'aFrom', or the
+		 * first if that's -1 - with the same keys as the row of the other
+		 * table, or -1 if there are no more.
+		 */
+		int find( const CKTableJoinKeys & aProbe, int aRow, int aFrom ) const
+		{
+			unsigned int	hash = aProbe.hashes[aRow];
+			if (hash == 0) {
+				return -1;
+			}
+			int		row = (aFrom < 0 ? mHeads[hash & mMask] : mNext[aFrom]);
+			while ((row >= 0) && !isSameJoinKey(aProbe, aRow, *mKeys, row)) {
+				row = mNext[row];
+			}
+			return row;
+		}
 
-	// then call the index-based method
-	setDoubleValue(row, col, aDoubleValue);
-}
+	private:
+		const CKTableJoinKeys	*mKeys;
+		unsigned int			mMask;
+		std::vector<int>		mHeads;
+		std::vector<int>		mNext;
+};
 
 
 /*
- * This sets the value stored in this location as a table, but a local
- * copy will be made so that the caller doesn't have to worry about
- * holding on to the parameter, and is free to delete it.
+ * This gets the hash of the keys of each row for a join - FNV-1a of the
+ * bytes of each number, or string, and zero if any of them is empty.
  */
-void CKTable::setTableValue( int aRow, int aCol, const CKTable *aTableValue )
-{
-	// first, make sure we have a place to put this data
-	if ((aRow < 0) || (aRow >= mNumRows) ||
-		(aCol < 0) || (aCol >= mNumColumns)) {
-		std::ostringstream	msg;
-		msg << "CKTable::setTableValue(int, int, const CKTable *) - the "
-			"provided location: " << aRow << ", " << aCol << " lies outside "
-			"the currently defined table: " << mNumRows << " by " <<
-			mNumColumns;
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
-	// ...and that we have a table structure that matches
-	if (mTable == NULL) {
-		std::ostringstream	msg;
-		msg << "CKTable::setTableValue(int, int, const CKTable *) - there "
-			"is no currently defined table structure in this class. This is a "
-			"serious data integrity problem that needs to be looked into.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
+class CKTableJoinHashTask :
+	public CKTableRowTask
+{
+	public:
+		CKTableJoinHashTask( const CKTable *aTable, CKTableJoinKeys *aKeys ) :
+			CKTableRowTask(aTable->mNumRows), mKeys(aKeys) { }
+		virtual void doRows( int aBegin, int anEnd, int aBlock )
+		{
+			for (int i = aBegin; i < anEnd; ++i) {
+				unsigned int	hash = 2166136261U;
+				for (unsigned int k = 0; (hash != 0) && (k < mKeys->keys.size()); ++k) {
+					const CKTableSortKey	& key = mKeys->keys[k];
+					if (key.kinds[i] == CKTABLE_NUMBER_KEY) {
+						// zero and minus zero are the same number
+						double			x = (key.numbers[i] == 0.0 ? 0.0 : key.numbers[i]);
+						unsigned char	bytes[sizeof(double)];
+						memcpy(bytes, &x, sizeof(double));
+						hash = addToHash(hash, (const char *)bytes, sizeof(double));
+					} else if (key.kinds[i] == CKTABLE_STRING_KEY) {
+						hash = addToHash(hash, key.strings[i].data(), key.strings[i].size());
+					} else {
+						hash = 0;
+					}
+				}
+				mKeys->hashes[i] = hash;
+			}
+		}
 
-	// now set it intelligently
-	mTable[aRow * mNumColumns + aCol].setTableValue(aTableValue);
-}
+	private:
+		static unsigned int addToHash( unsigned int aHash, const char *aBytes, int aLength )
+		{
+			for (int b = 0; b < aLength; ++b) {
+				aHash = (aHash ^ (unsigned char)aBytes[b]) * 16777619U;
+			}
+			// the end of each key counts, so "ab","c" isn't "a","bc"
+			aHash = (aHash ^ 0xff) * 16777619U;
+			return (aHash == 0 ? 1 : aHash);
+		}
 
+		CKTableJoinKeys		*mKeys;
+};
 
-void CKTable::setTableValue( int aRow, const CKString & aColHeader, const CKTable *aTableValue )
-{
-	// convert the column header to a column index
-	int		col = getColumnForHeader(aColHeader);
-	if (col < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setTableValue(int, const CKString &, "
-			"const CKTable *) - there is no currently defined "
-			"column header '" << aColHeader << "' please make sure the column "
-			"headers are properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
 
-	// then call the index-based method
-	setTableValue(aRow, col, aTableValue);
-}
+/*
+ * This looks up each row of one table in the hash table of the other
+ * for join(), and puts the pairs of rows that match - the row, then the
+ * one in the index - in the list for the block the rows start at, so
+ * they can be put together in order. If 'aKeepAll' is true, a row that
+ * doesn't match anything is there once, with -1 for the other row.
+ */
+class CKTableJoinProbeTask :
+	public CKTableRowTask
+{
+	public:
+		CKTableJoinProbeTask( int aNumRows, const CKTableJoinKeys *aKeys,
+							  const CKTableJoinIndex *anIndex, bool aKeepAll,
+							  std::vector< std::vector<int> > *aPairs ) :
+			CKTableRowTask(aNumRows), mKeys(aKeys), mIndex(anIndex),
+			mKeepAll(aKeepAll), mPairs(aPairs) { }
+		virtual void doRows( int aBegin, int anEnd, int aBlock )
+		{
+			std::vector<int>	& pairs = (*mPairs)[aBlock];
+			for (int i = aBegin; i < anEnd; ++i) {
+				int		row = mIndex->find(*mKeys, i, -1);
+				if ((row < 0) && mKeepAll) {
+					pairs.push_back(i);
+					pairs.push_back(-1);
+				}
+				for (; row >= 0; row = mIndex->find(*mKeys, i, row)) {
+					pairs.push_back(i);
+					pairs.push_back(row);
+				}
+			}
+		}
 
+	private:
+		const CKTableJoinKeys				*mKeys;
+		const CKTableJoinIndex				*mIndex;
+		bool								mKeepAll;
+		std::vector< std::vector<int> >		*mPairs;
+};
 
-void CKTable::setTableValue( const CKString & aRowLabel, int aCol, const CKTable *aTableValue )
-{
-	// convert the row label to a row index
-	int		row = getRowForLabel(aRowLabel);
-	if (row < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setTableValue(const CKString &, int, "
-			"const CKTable *) - there is no currently defined row "
-			"label '" << aRowLabel << "' please make sure the row labels are "
-			"properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
 
-	// then call the index-based method
-	setTableValue(row, aCol, aTableValue);
-}
+/*
+ * This finds the row of the other table for each row of this one in
+ * asOfJoin(). The index is of the first row of each group of rows of
+ * the other table with the same keys, and the times of each group are
+ * sorted - with their rows - in its range of the list.
+ */
+class CKTableAsOfProbeTask :
+	public CKTableRowTask
+{
+	public:
+		CKTableAsOfProbeTask( const CKTable *aTable, const CKTableJoinKeys *aKeys,
+							  const CKTableSortKey *aTimes,
+							  const CKTableJoinIndex *anIndex,
+							  const std::vector<int> *aGroupOfRow,
+							  const std::vector<int> *aStarts,
+							  const std::vector< std::pair<double, int> > *anEntries,
+							  std::vector<int> *aMatches ) :
+			CKTableRowTask(aTable->mNumRows), mKeys(aKeys), mTimes(aTimes),
+			mIndex(anIndex), mGroupOfRow(aGroupOfRow), mStarts(aStarts),
+			mEntries(anEntries), mMatches(aMatches) { }
+		virtual void doRows( int aBegin, int anEnd, int aBlock )
+		{
+			for (int i = aBegin; i < anEnd; ++i) {
+				(*mMatches)[i] = -1;
+				if (mTimes->kinds[i] != CKTABLE_NUMBER_KEY) {
+					continue;
+				}
+				int		first = mIndex->find(*mKeys, i, -1);
+				if (first < 0) {
+					continue;
+				}
+				/*
+				 * The last entry of the group that isn't after the time is
+				 * just before the first one that is - and as the ties are
+				 * in row order, it's the furthest down of them.
+				 */
+				int		g = (*mGroupOfRow)[first];
+				std::vector< std::pair<double, int> >::const_iterator	begin =
+								mEntries->begin() + (*mStarts)[g];
+				std::vector< std::pair<double, int> >::const_iterator	end =
+								mEntries->begin() + (*mStarts)[g + 1];
+				std::vector< std::pair<double, int> >::const_iterator	it =
+								std::upper_bound(begin, end,
+									std::make_pair(mTimes->numbers[i], INT_MAX));
+				if (it != begin) {
+					(*mMatches)[i] = (it - 1)->second;
+				}
+			}
+		}
 
+	private:
+		const CKTableJoinKeys							*mKeys;
+		const CKTableSortKey							*mTimes;
+		const CKTableJoinIndex							*mIndex;
+		const std::vector<int>							*mGroupOfRow;
+		const std::vector<int>							*mStarts;
+		const std::vector< std::pair<double, int> >		*mEntries;
+		std::vector<int>								*mMatches;
+};
 
-void CKTable::setTableValue( const CKString & aRowLabel, const CKString & aColHeader, const CKTable *aTableValue )
-{
-	// convert the row label to a row index
-	int		row = getRowForLabel(aRowLabel);
-	if (row < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setTableValue(const CKString &, const CKString &, "
-			"const CKTable *) - there is no currently defined row "
-			"label '" << aRowLabel << "' please make sure the row labels are "
-			"properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
 
-	// convert the column header to a column index
-	int		col = getColumnForHeader(aColHeader);
-	if (col < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setTableValue(const CKString &, const CKString &, "
-			"const CKTable *) - there is no currently defined "
-			"column header '" << aColHeader << "' please make sure the column "
-			"headers are properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
+/*
+ * This is where one column of a joined table comes from - a column of
+ * one of the tables, and the row of it for each row of the result, or
+ * -1 to leave the cell empty.
+ */
+struct CKTableJoinSource {
+	const CKTable				*table;
+	int							col;
+	const std::vector<int>		*rows;
+};
 
-	// then call the index-based method
-	setTableValue(row, col, aTableValue);
-}
+
+/*
+ * This fills in the cells and labels of the rows of a joined table. A
+ * dense column comes from a dense column, so its numbers, or dates, are
+ * just copied over. Everything else is a copy of the CKVariant.
+ */
+class CKTableJoinGatherTask :
+	public CKTableRowTask
+{
+	public:
+		CKTableJoinGatherTask( CKTable *aTable, const std::vector<CKTableJoinSource> *aSources,
+							   const CKTable *aLabelTable, const std::vector<int> *aLabelRows ) :
+			CKTableRowTask(aTable->mNumRows), mTable(aTable), mSources(aSources),
+			mLabelTable(aLabelTable), mLabelRows(aLabelRows) { }
+		virtual void doRows( int aBegin, int anEnd, int aBlock )
+		{
+			int			cols = mTable->mNumColumns;
+			CKVariant	scratch;
+			for (int j = 0; j < cols; ++j) {
+				const CKTableJoinSource	& source = (*mSources)[j];
+				const CKTableColumn		*from = (source.table->mColumns == NULL ? NULL :
+												 &source.table->mColumns[source.col]);
+				CKTableColumn			*to = (mTable->mColumns == NULL ? NULL :
+											   &mTable->mColumns[j]);
+				for (int i = aBegin; i < anEnd; ++i) {
+					int		row = (*source.rows)[i];
+					if (row < 0) {
+						continue;
+					}
+					if ((to != NULL) && (to->type == eNumberVariant)) {
+						if (isRowValid(from->valid, row)) {
+							to->doubles[i] = from->doubles[row];
+							markRow(to->valid, i, true);
+						}
+					} else if ((to != NULL) && (to->type == eDateVariant)) {
+						if (isRowValid(from->valid, row)) {
+							to->dates[i] = from->dates[row];
+							markRow(to->valid, i, true);
+						}
+					} else {
+						const CKVariant	& cell = source.table->readCell(row, source.col, scratch);
+						if (cell.getType() == eUnknownVariant) {
+							// nothing to copy
+						} else if (to != NULL) {
+							to->variants[i] = cell;
+						} else {
+							mTable->mTable[i * cols + j] = cell;
+						}
+					}
+				}
+			}
+			for (int i = aBegin; i < anEnd; ++i) {
+				mTable->mRowLabels[i] = mLabelTable->mRowLabels[(*mLabelRows)[i]];
+			}
+		}
+
+	private:
+		CKTable									*mTable;
+		const std::vector<CKTableJoinSource>	*mSources;
+		const CKTable							*mLabelTable;
+		const std::vector<int>					*mLabelRows;
+};
 
 
 /*
- * This sets the value stored in this location as a time series, but
- * a local copy will be made so that the caller doesn't have to worry
- * about holding on to the parameter, and is free to delete it.
+ * This does the product for the matrix methods a block of the result
+ * at a time, so a big one can be split up over the parallel executor.
+ * The range it's given is of the blocks, going down each column of
+ * blocks in turn, and a block is just the pointers into the columns of
+ * the matrices that it needs. With 'aTransposeA', the first matrix is
+ * given as its columns, each one a row of the product.
  */
-void CKTable::setTimeSeriesValue( int aRow, int aCol, const CKTimeSeries *aTimeSeriesValue )
+class CKTableMatrixTask :
+	public ICKExecutorRangeTask
+{
+	public:
+		CKTableMatrixTask( CKTable *aResult, int anInner,
+						   const std::vector<const double *> *anA, bool aTransposeA,
+						   const std::vector<const double *> *aB ) :
+			mResult(aResult), mInner(anInner), mA(anA), mTransposeA(aTransposeA),
+			mB(aB)
+		{
+			mRowBlocks = (aResult->mNumRows + CKTABLE_MATRIX_BLOCK - 1) / CKTABLE_MATRIX_BLOCK;
+			mColBlocks = (aResult->mNumColumns + CKTABLE_MATRIX_BLOCK - 1) / CKTABLE_MATRIX_BLOCK;
+		}
+		int getNumBlocks() const { return mRowBlocks * mColBlocks; }
+		virtual void execute( int aBegin, int anEnd )
+		{
+			std::vector<const double *>	a;
+			std::vector<double *>		c;
+			for (int b = aBegin; b < anEnd; ++b) {
+				int		row = (b % mRowBlocks) * CKTABLE_MATRIX_BLOCK;
+				int		col = (b / mRowBlocks) * CKTABLE_MATRIX_BLOCK;
+				int		rows = MIN(CKTABLE_MATRIX_BLOCK, mResult->mNumRows - row);
+				int		cols = MIN(CKTABLE_MATRIX_BLOCK, mResult->mNumColumns - col);
+				// the rows of the block are further down each column
+				const double * const	*first = NULL;
+				if (mTransposeA) {
+					first = (mInner > 0 ? &(*mA)[row] : NULL);
+				} else {
+					a.resize(mInner);
+					for (int p = 0; p < mInner; ++p) {
+						a[p] = (*mA)[p] + row;
+					}
+					first = (mInner > 0 ? &a[0] : NULL);
+				}
+				c.resize(cols);
+				for (int j = 0; j < cols; ++j) {
+					c[j] = mResult->mColumns[col + j].doubles + row;
+				}
+				CKVectorMath::multiply(rows, cols, mInner, first, mTransposeA,
+									   (mInner > 0 ? &(*mB)[col] : NULL), &c[0]);
+			}
+		}
+
+	private:
+		CKTable								*mResult;
+		int									mInner;
+		const std::vector<const double *>	*mA;
+		bool								mTransposeA;
+		const std::vector<const double *>	*mB;
+		int									mRowBlocks;
+		int									mColBlocks;
+};
+
+
+/*
+ * This centers the column on its mean for covariance(). The mean is
+ * corrected by the mean of what's left after taking it away, so that
+ * a column that's all one number comes out all zeros, and not the bits
+ * left over from rounding in the sum.
+ */
+static void centerColumn( double *aValues, int aCount )
 {
-	// first, make sure we have a place to put this data
-	if ((aRow < 0) || (aRow >= mNumRows) ||
-		(aCol < 0) || (aCol >= mNumColumns)) {
-		std::ostringstream	msg;
-		msg << "CKTable::setTimeSeriesValue(int, int, const CKTimeSeries *) - the "
-			"provided location: " << aRow << ", " << aCol << " lies outside "
-			"the currently defined table: " << mNumRows << " by " <<
-			mNumColumns;
-		throw CKException(__FILE__, __LINE__, msg.str());
+	double	sum = 0.0;
+	for (int i = 0; i < aCount; ++i) {
+		sum += aValues[i];
 	}
-	// ...and that we have a table structure that matches
-	if (mTable == NULL) {
-		std::ostringstream	msg;
-		msg << "CKTable::setTimeSeriesValue(int, int, const CKTimeSeries *) - there "
-			"is no currently defined table structure in this class. This is a "
-			"serious data integrity problem that needs to be looked into.";
-		throw CKException(__FILE__, __LINE__, msg.str());
+	double	mean = sum / aCount;
+	double	left = 0.0;
+	for (int i = 0; i < aCount; ++i) {
+		left += aValues[i] - mean;
 	}
-
-	// now set it intelligently
-	mTable[aRow * mNumColumns + aCol].setTimeSeriesValue(aTimeSeriesValue);
+	mean += left / aCount;
+	CKVectorMath::apply('-', aValues, aCount, mean);
 }
 
 
-void CKTable::setTimeSeriesValue( int aRow, const CKString & aColHeader, const CKTimeSeries *aTimeSeriesValue )
-{
-	// convert the column header to a column index
-	int		col = getColumnForHeader(aColHeader);
-	if (col < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setTimeSeriesValue(int, const CKString &, "
-			"const CKTimeSeries *) - there is no currently defined "
-			"column header '" << aColHeader << "' please make sure the column "
-			"headers are properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
+/*
+ * These are the pool and threshold for splitting up the work on big
+ * tables. A NULL pool means the library's default one.
+ */
+CKExecutor			*CKTable::sParallelExecutor = NULL;
+volatile int		CKTable::sParallelThreshold = CKTABLE_PARALLEL_THRESHOLD;
 
-	// then call the index-based method
-	setTimeSeriesValue(aRow, col, aTimeSeriesValue);
-}
 
 
-void CKTable::setTimeSeriesValue( const CKString & aRowLabel, int aCol, const CKTimeSeries *aTimeSeriesValue )
+/********************************************************
+ *
+ *                Constructors/Destructor
+ *
+ ********************************************************/
+/*
+ * The default constructor does *not* define the table's data
+ * structure, but a call to resizeTable(int, int) will do that
+ * once the instance is built. This constructor is here for
+ * those times that you aren't sure what you're going to be
+ * getting into and need to leave your options open.
+ */
+CKTable::CKTable() :
+	mTable(NULL),
+	mColumns(NULL),
+	mColumnHeaders(NULL),
+	mColumnHeadersIndex(),
+	mRowLabels(NULL),
+	mRowLabelsIndex(),
+	mNumRows(-1),
+	mNumColumns(-1),
+	mRowCapacity(0),
+	mColumnCapacity(0)
 {
-	// convert the row label to a row index
-	int		row = getRowForLabel(aRowLabel);
-	if (row < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setTimeSeriesValue(const CKString &, int, "
-			"const CKTimeSeries *) - there is no currently defined row "
-			"label '" << aRowLabel << "' please make sure the row labels are "
-			"properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
-
-	// then call the index-based method
-	setTimeSeriesValue(row, aCol, aTimeSeriesValue);
 }
 
 
-void CKTable::setTimeSeriesValue( const CKString & aRowLabel, const CKString & aColHeader, const CKTimeSeries *aTimeSeriesValue )
+/*
+ * The preferred constructor for this class takes the number of
+ * rows and columns and creates a table of values that can then
+ * be individually accessed by the accessor methods of this
+ * class.
+ */
+CKTable::CKTable( int aNumRows, int aNumColumns ) :
+	mTable(NULL),
+	mColumns(NULL),
+	mColumnHeaders(NULL),
+	mColumnHeadersIndex(),
+	mRowLabels(NULL),
+	mRowLabelsIndex(),
+	mNumRows(-1),
+	mNumColumns(-1),
+	mRowCapacity(0),
+	mColumnCapacity(0)
 {
-	// convert the row label to a row index
-	int		row = getRowForLabel(aRowLabel);
-	if (row < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setTimeSeriesValue(const CKString &, const CKString &, "
-			"const CKTimeSeries *) - there is no currently defined row "
-			"label '" << aRowLabel << "' please make sure the row labels are "
-			"properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
-
-	// convert the column header to a column index
-	int		col = getColumnForHeader(aColHeader);
-	if (col < 0) {
+	// see if the requestde size makes any sense
+	if ((aNumRows <= 0) || (aNumColumns <= 0)) {
 		std::ostringstream	msg;
-		msg << "CKTable::setTimeSeriesValue(const CKString &, const CKString &, "
-			"const CKTimeSeries *) - there is no currently defined "
-			"column header '" << aColHeader << "' please make sure the column "
-			"headers are properly defined.";
+		msg << "CKTable::CKTable(int, int) - the requested size: "
+			<< aNumRows << " by " << aNumColumns << " doesn't make any sense. "
+			"Please try again.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
-	// then call the index-based method
-	setTimeSeriesValue(row, col, aTimeSeriesValue);
+	// create the data table structure
+	createTable(aNumRows, aNumColumns);
 }
 
 
 /*
- * This sets the value stored in this location as a price, but
- * a local copy will be made so that the caller doesn't have to worry
- * about holding on to the parameter, and is free to delete it.
+ * This constructor creates a columnar table where every column
+ * is of the given type - eNumberVariant or eDateVariant for the
+ * dense columns, or eUnknownVariant for columns of CKVariants -
+ * without ever making the row-major array of CKVariants.
  */
-void CKTable::setPriceValue( int aRow, int aCol, const CKPrice *aPriceValue )
+CKTable::CKTable( int aNumRows, int aNumColumns, CKVariantType aColumnType ) :
+	mTable(NULL),
+	mColumns(NULL),
+	mColumnHeaders(NULL),
+	mColumnHeadersIndex(),
+	mRowLabels(NULL),
+	mRowLabelsIndex(),
+	mNumRows(-1),
+	mNumColumns(-1),
+	mRowCapacity(0),
+	mColumnCapacity(0)
 {
-	// first, make sure we have a place to put this data
-	if ((aRow < 0) || (aRow >= mNumRows) ||
-		(aCol < 0) || (aCol >= mNumColumns)) {
+	// see if the requested size makes any sense
+	if ((aNumRows <= 0) || (aNumColumns <= 0)) {
 		std::ostringstream	msg;
-		msg << "CKTable::setPriceValue(int, int, const CKPrice *) - the "
-			"provided location: " << aRow << ", " << aCol << " lies outside "
-			"the currently defined table: " << mNumRows << " by " <<
-			mNumColumns;
+		msg << "CKTable::CKTable(int, int, CKVariantType) - the requested "
+			"size: " << aNumRows << " by " << aNumColumns << " doesn't make "
+			"any sense. Please try again.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
-	// ...and that we have a table structure that matches
-	if (mTable == NULL) {
+	// ...and that the type is one a column can be
+	if ((aColumnType != eNumberVariant) && (aColumnType != eDateVariant) &&
+		(aColumnType != eUnknownVariant)) {
 		std::ostringstream	msg;
-		msg << "CKTable::setPriceValue(int, int, const CKPrice *) - there "
-			"is no currently defined table structure in this class. This is a "
-			"serious data integrity problem that needs to be looked into.";
+		msg << "CKTable::CKTable(int, int, CKVariantType) - the type " <<
+			aColumnType << " can't be held in a dense column. Only numbers and "
+			"dates can, and eUnknownVariant makes columns of CKVariants.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
-	// now set it intelligently
-	mTable[aRow * mNumColumns + aCol].setPriceValue(aPriceValue);
+	// create the data table structure and give each column its storage
+	createTable(aNumRows, aNumColumns, true);
+	for (int col = 0; col < mNumColumns; ++col) {
+		allocColumn(mColumns[col], aColumnType, mRowCapacity);
+	}
 }
 
 
-void CKTable::setPriceValue( int aRow, const CKString & aColHeader, const CKPrice *aPriceValue )
-{
-	// convert the column header to a column index
-	int		col = getColumnForHeader(aColHeader);
-	if (col < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setPriceValue(int, const CKString &, "
-			"const CKPrice *) - there is no currently defined "
-			"column header '" << aColHeader << "' please make sure the column "
-			"headers are properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
-
-	// then call the index-based method
-	setPriceValue(aRow, col, aPriceValue);
-}
-
-
-void CKTable::setPriceValue( const CKString & aRowLabel, int aCol, const CKPrice *aPriceValue )
-{
-	// convert the row label to a row index
-	int		row = getRowForLabel(aRowLabel);
-	if (row < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setPriceValue(const CKString &, int, "
-			"const CKPrice *) - there is no currently defined row "
-			"label '" << aRowLabel << "' please make sure the row labels are "
-			"properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
-
-	// then call the index-based method
-	setPriceValue(row, aCol, aPriceValue);
-}
-
-
-void CKTable::setPriceValue( const CKString & aRowLabel, const CKString & aColHeader, const CKPrice *aPriceValue )
+/*
+ * This version of the constructor for this class takes two lists -
+ * one for the list of row labels and the other for the list of
+ * column headers. These lists not only define the structure of the
+ * table, but also the row labels and column headers.
+ */
+CKTable::CKTable( const CKStringList aRowLabels,
+				  const CKStringList aColumnHeaders ) :
+	mTable(NULL),
+	mColumns(NULL),
+	mColumnHeaders(NULL),
+	mColumnHeadersIndex(),
+	mRowLabels(NULL),
+	mRowLabelsIndex(),
+	mNumRows(-1),
+	mNumColumns(-1),
+	mRowCapacity(0),
+	mColumnCapacity(0)
 {
-	// convert the row label to a row index
-	int		row = getRowForLabel(aRowLabel);
-	if (row < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::setPriceValue(const CKString &, const CKString &, "
-			"const CKPrice *) - there is no currently defined row "
-			"label '" << aRowLabel << "' please make sure the row labels are "
-			"properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
-
-	// convert the column header to a column index
-	int		col = getColumnForHeader(aColHeader);
-	if (col < 0) {
+	// see if the requestde size makes any sense
+	if (aRowLabels.empty() || aColumnHeaders.empty()) {
 		std::ostringstream	msg;
-		msg << "CKTable::setPriceValue(const CKString &, const CKString &, "
-			"const CKPrice *) - there is no currently defined "
-			"column header '" << aColHeader << "' please make sure the column "
-			"headers are properly defined.";
+		msg << "CKTable::CKTable(const CKStringList &, const "
+			"CKStringList &) - the requested size: "
+			<< aRowLabels.size() << " by " << aColumnHeaders.size() <<
+			" doesn't make any sense. Please try again.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
-	// then call the index-based method
-	setPriceValue(row, col, aPriceValue);
+	// create the data table structure
+	createTable(aRowLabels, aColumnHeaders);
 }
 
 
 /*
- * This method takes the supplied column number and the header and
- * assuming the table is big enough to include that column, sets the
- * column header for that column to the supplied value. A copy is
- * made of the argument so the caller retains control of the memory.
+ * This constructor is interesting in that it takes the data as
+ * it comes from another CKTable's generateCodeFromValues() method
+ * and parses it into a table of values directly. This is very
+ * useful for serializing the table's data from one host to
+ * another across a socket, for instance.
  */
-void CKTable::setColumnHeader( int aCol, const CKString & aHeader )
+CKTable::CKTable( const CKString & aCode ) :
+	mTable(NULL),
+	mColumns(NULL),
+	mColumnHeaders(NULL),
+	mColumnHeadersIndex(),
+	mRowLabels(NULL),
+	mRowLabelsIndex(),
+	mNumRows(-1),
+	mNumColumns(-1),
+	mRowCapacity(0),
+	mColumnCapacity(0)
 {
-	// first, make sure we have a place to put this data
-	if ((aCol < 0) || (aCol >= mNumColumns)) {
+	// first, make sure we have something to do
+	if (aCode.empty()) {
 		std::ostringstream	msg;
-		msg << "CKTable::setColumnHeader(int, const char *) - the "
-			"provided column: " << aCol << " lies outside "
-			"the currently defined table: " << mNumRows << " by " <<
-			mNumColumns;
+		msg << "CKTable::CKTable(const CKString &) - the provided argument is "
+			"empty and that means that nothing can be done. Please make sure "
+			"that the argument is not empty before calling this constructor.";
 		throw CKException(__FILE__, __LINE__, msg.str());
+	} else {
+		// load in the values from the code
+		takeValuesFromCode(aCode);
 	}
-
-	// now set it intelligently
-	mColumnHeaders[aCol] = aHeader;
-	mColumnHeadersIndex[aHeader] = aCol;
 }
 
 
 /*
- * This method takes the supplied column number and the header and
- * assuming the table is big enough to include that column, sets the
- * column header for that column to the supplied value. The header
- * will be left untouched as we'll be making a copy of it for our
- * internal use.
+ * This is the standard copy constructor and needs to be in every
+ * class to make sure that we don't have too many things running
+ * around.
  */
-void CKTable::setColumnHeader( int aCol, const char *aHeader )
+CKTable::CKTable( const CKTable & anOther ) :
+	mTable(NULL),
+	mColumns(NULL),
+	mColumnHeaders(NULL),
+	mColumnHeadersIndex(),
+	mRowLabels(NULL),
+	mRowLabelsIndex(),
+	mNumRows(-1),
+	mNumColumns(-1),
+	mRowCapacity(0),
+	mColumnCapacity(0)
 {
-	// first, make sure we have a place to put this data
-	if ((aCol < 0) || (aCol >= mNumColumns)) {
-		std::ostringstream	msg;
-		msg << "CKTable::setColumnHeader(int, const char *) - the "
-			"provided column: " << aCol << " lies outside "
-			"the currently defined table: " << mNumRows << " by " <<
-			mNumColumns;
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
-
-	// now set it intelligently
-	mColumnHeaders[aCol] = aHeader;
-	mColumnHeadersIndex[aHeader] = aCol;
+	*this = anOther;
 }
 
 
 /*
- * This method takes the supplied row number and the label and
- * assuming the table is big enough to include that row, sets the
- * row label for that row to the supplied value. A copy is
- * made of the argument so the caller retains control of the memory.
+ * This is the standard destructor and needs to be virtual to make
+ * sure that if we subclass off this the right destructor will be
+ * called.
  */
-void CKTable::setRowLabel( int aRow, const CKString & aLabel )
+CKTable::~CKTable()
 {
-	// first, make sure we have a place to put this data
-	if ((aRow < 0) || (aRow >= mNumRows)) {
-		std::ostringstream	msg;
-		msg << "CKTable::setRowLabel(int, const char *) - the "
-			"provided row: " << aRow << " lies outside "
-			"the currently defined table: " << mNumRows << " by " <<
-			mNumColumns;
-		throw CKException(__FILE__, __LINE__, msg.str());
+	// first, drop the table, if we have one
+	if (mTable != NULL) {
+		delete [] mTable;
+		mTable = NULL;
+	}
+	// ...or the columns, if it's columnar
+	dropColumns();
+	// next, drop the row and column labels, if we have them
+	if (mRowLabels != NULL) {
+		delete [] mRowLabels;
+		mRowLabels = NULL;
+	}
+	if (mColumnHeaders != NULL) {
+		delete [] mColumnHeaders;
+		mColumnHeaders = NULL;
 	}
-
-	// now set it intelligently
-	mRowLabels[aRow] = aLabel;
-	mRowLabelsIndex[aLabel] = aRow;
 }
 
 
 /*
- * This method takes the supplied row number and the label and
- * assuming the table is big enough to include that row, sets the
- * row label for that row to the supplied value. The label
- * will be left untouched as we'll be making a copy of it for our
- * internal use.
+ * When we want to process the result of an equality we need to
+ * make sure that we do this right by always having an equals
+ * operator on all classes.
  */
-void CKTable::setRowLabel( int aRow, const char *aLabel )
+CKTable & CKTable::operator=( const CKTable & anOther )
 {
-	// first, make sure we have a place to put this data
-	if ((aRow < 0) || (aRow >= mNumRows)) {
-		std::ostringstream	msg;
-		msg << "CKTable::setRowLabel(int, const char *) - the "
-			"provided row: " << aRow << " lies outside "
-			"the currently defined table: " << mNumRows << " by " <<
-			mNumColumns;
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
+	// make sure we don't do this to ourselves
+	if (this != & anOther) {
+		// now see if the requested size makes any sense to copy
+		if (anOther.hasStorage() && (anOther.mNumRows >= 0) && (anOther.mNumColumns > 0)) {
+			/*
+			 * Create the data table structure in the same layout as his.
+			 * A table with no rows - what's left after a filter() that
+			 * nothing passed - is made with room for one, and then it's
+			 * emptied.
+			 */
+			createTable(MAX(anOther.mNumRows, 1), anOther.mNumColumns,
+						(anOther.mColumns != NULL));
+			mNumRows = anOther.mNumRows;
 
-	// now set it intelligently
-	mRowLabels[aRow] = aLabel;
-	mRowLabelsIndex[aLabel] = aRow;
+			// now, copy over the row labels and column headers
+			mRowLabelsIndex = anOther.mRowLabelsIndex;
+			for (int r = 0; r < mNumRows; r++) {
+				mRowLabels[r] = anOther.mRowLabels[r];
+			}
+			mColumnHeadersIndex = anOther.mColumnHeadersIndex;
+			for (int c = 0; c < mNumColumns; c++) {
+				mColumnHeaders[c] = anOther.mColumnHeaders[c];
+			}
+
+			// finally we need to copy all the values from the table to us
+			if (mColumns != NULL) {
+				for (int c = 0; c < mNumColumns; c++) {
+					copyColumn(mColumns[c], anOther.mColumns[c], mRowCapacity, mNumRows);
+				}
+			} else {
+				int		cnt = mNumRows * mNumColumns;
+				for (int i = 0; i < cnt; i++) {
+					mTable[i] = anOther.mTable[i];
+				}
+			}
+		}
+	}
+	return *this;
 }
 
 
+/********************************************************
+ *
+ *                Accessor Methods
+ *
+ ********************************************************/
 /*
- * This method returns a reference to the *actual* element in the
- * table's data structure and so the caller should be *VERY* careful
- * what he does with it. It's nice for scanning through the data and
- * seeing what's there, but the caller cannot delete it as it's
- * controlled by this table's methods.
+ * This method allows the user to set the *contents* of a given value
+ * to the location specified in the table. It's important to note that
+ * the actual object is *not* being placed into the table. Only it's
+ * contents are being examined/copied into the table's datastructures.
  */
-CKVariant & CKTable::getValue( int aRow, int aCol ) const
+void CKTable::setValue( int aRow, int aCol, const CKVariant & aValue )
 {
 	// first, make sure we have a place to put this data
 	if ((aRow < 0) || (aRow >= mNumRows) ||
 		(aCol < 0) || (aCol >= mNumColumns)) {
 		std::ostringstream	msg;
-		msg << "CKTable::getValue(int, int) - the provided location: " <<
-			aRow << ", " << aCol << " lies outside the currently defined table: " <<
-			mNumRows << " by " << mNumColumns;
+		msg << "CKTable::setValue(int, int, const CKVariant &) - the provided "
+			"location: " << aRow << ", " << aCol << " lies outside the currently "
+			"defined table: " << mNumRows << " by " << mNumColumns;
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 	// ...and that we have a table structure that matches
-	if (mTable == NULL) {
+	if (!hasStorage()) {
 		std::ostringstream	msg;
-		msg << "CKTable::getValue(int, int) - there is no currently "
-			"defined table structure in this class. This is a serious data "
-			"integrity problem that needs to be looked into.";
+		msg << "CKTable::setValue(int, int, const CKVariant &) - there "
+			"is no currently defined table structure in this class. This is a "
+			"serious data integrity problem that needs to be looked into.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
-	// now get what they want
-	return mTable[aRow * mNumColumns + aCol];
+	// now set it intelligently - a dense column takes its own kind
+	if (mColumns == NULL) {
+		mTable[aRow * mNumColumns + aCol] = aValue;
+	} else {
+		CKTableColumn	& column = mColumns[aCol];
+		CKVariantType	type = aValue.getType();
+		if ((column.type != eUnknownVariant) && (type == eUnknownVariant)) {
+			markRow(column.valid, aRow, false);
+		} else if ((column.type == eNumberVariant) && (type == eNumberVariant)) {
+			column.doubles[aRow] = aValue.getDoubleValue();
+			markRow(column.valid, aRow, true);
+		} else if ((column.type == eDateVariant) && (type == eDateVariant)) {
+			column.dates[aRow] = aValue.getDateValue();
+			markRow(column.valid, aRow, true);
+		} else {
+			variantCell(aRow, aCol) = aValue;
+		}
+	}
 }
 
 
-CKVariant & CKTable::getValue( int aRow, const CKString & aColHeader ) const
+void CKTable::setValue( int aRow, const CKString & aColHeader, const CKVariant & aValue )
 {
 	// convert the column header to a column index
 	int		col = getColumnForHeader(aColHeader);
 	if (col < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getValue(int, const CKString &) "
-			"- there is no currently defined column header '" << aColHeader <<
+		msg << "CKTable::setValue(int, const CKString &, const CKVariant &)"
+			" - there is no currently defined column header '" << aColHeader <<
 			"' please make sure the column headers are properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
 	// then call the index-based method
-	return getValue(aRow, col);
+	setValue(aRow, col, aValue);
 }
 
 
-CKVariant & CKTable::getValue( const CKString & aRowLabel, int aCol ) const
+void CKTable::setValue( const CKString & aRowLabel, int aCol, const CKVariant & aValue )
 {
 	// convert the row label to a row index
 	int		row = getRowForLabel(aRowLabel);
 	if (row < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getValue(const CKString &, const CKString &) "
-			"- there is no currently defined row label '" << aRowLabel <<
+		msg << "CKTable::setValue(const CKString &, int, const CKVariant &)"
+			" - there is no currently defined row label '" << aRowLabel <<
 			"' please make sure the row labels are properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
 	// then call the index-based method
-	return getValue(row, aCol);
+	setValue(row, aCol, aValue);
 }
 
 
-CKVariant & CKTable::getValue( const CKString & aRowLabel, const CKString & aColHeader ) const
+void CKTable::setValue( const CKString & aRowLabel, const CKString & aColHeader, const CKVariant & aValue )
 {
 	// convert the row label to a row index
 	int		row = getRowForLabel(aRowLabel);
 	if (row < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getValue(const CKString &, const CKString &) "
-			"- there is no currently defined row label '" << aRowLabel <<
-			"' please make sure the row labels are properly defined.";
+		msg << "CKTable::setValue(const CKString &, const CKString &, "
+			"const CKVariant &) - there is no currently defined row label '" <<
+			aRowLabel << "' please make sure the row labels are properly "
+			"defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
@@ -1278,89 +1842,108 @@ CKVariant & CKTable::getValue( const CKString & aRowLabel, const CKString & aCol
 	int		col = getColumnForHeader(aColHeader);
 	if (col < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getValue(const CKString &, const CKString &) "
-			"- there is no currently defined column header '" << aColHeader <<
-			"' please make sure the column headers are properly defined.";
+		msg << "CKTable::setValue(const CKString &, const CKString &, "
+			"const CKVariant &) - there is no currently defined column header '"
+			<< aColHeader << "' please make sure the column headers are "
+			"properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
 	// then call the index-based method
-	return getValue(row, col);
+	setValue(row, col, aValue);
 }
 
 
 /*
- * This method returns the enumerated type of the data that this
- * location is currently holding.
+ * This method sets the value at this location based on the type
+ * of data that's represented in the supplied string. This string
+ * will *not* be modified or retained in any way, as a copy will be
+ * made for this instance, if it's necessary to have one. This is
+ * the most general form of the setter for this instance.
  */
-CKVariantType CKTable::getType( int aRow, int aCol ) const
+void CKTable::setValueAsType( int aRow, int aCol, CKVariantType aType,
+							  const char *aValue )
 {
 	// first, make sure we have a place to put this data
 	if ((aRow < 0) || (aRow >= mNumRows) ||
 		(aCol < 0) || (aCol >= mNumColumns)) {
 		std::ostringstream	msg;
-		msg << "CKTable::getType(int, int) - the provided location: " <<
-			aRow << ", " << aCol << " lies outside the currently defined table: " <<
-			mNumRows << " by " << mNumColumns;
+		msg << "CKTable::setValueAsType(int, int, CKVariantType, "
+			"const char *) - the provided location: " << aRow << ", " << aCol <<
+			" lies outside the currently defined table: " << mNumRows <<
+			" by " << mNumColumns;
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 	// ...and that we have a table structure that matches
-	if (mTable == NULL) {
+	if (!hasStorage()) {
 		std::ostringstream	msg;
-		msg << "CKTable::getType(int, int) - there is no currently "
-			"defined table structure in this class. This is a serious data "
-			"integrity problem that needs to be looked into.";
+		msg << "CKTable::setValueAsType(int, int, CKVariantType, "
+			"const char *) - there is no currently defined table structure in "
+			"this class. This is a serious data integrity problem that needs "
+			"to be looked into.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
-	// now get what they are looking for
-	return mTable[aRow * mNumColumns + aCol].getType();
+	// now set it intelligently - a columnar table lets setValue() place it
+	if (mColumns == NULL) {
+		mTable[aRow * mNumColumns + aCol].setValueAsType(aType, aValue);
+	} else {
+		CKVariant	value;
+		value.setValueAsType(aType, aValue);
+		setValue(aRow, aCol, value);
+	}
 }
 
 
-CKVariantType CKTable::getType( int aRow, const CKString & aColHeader ) const
+void CKTable::setValueAsType( int aRow, const CKString & aColHeader,
+							  CKVariantType aType, const char *aValue )
 {
 	// convert the column header to a column index
 	int		col = getColumnForHeader(aColHeader);
 	if (col < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getType(int, const CKString &) "
-			"- there is no currently defined column header '" << aColHeader <<
-			"' please make sure the column headers are properly defined.";
+		msg << "CKTable::setValueAsType(int, const CKString &, "
+			"CKVariantType, const char *) - there is no currently defined "
+			"column header '" << aColHeader << "' please make sure the column "
+			"headers are properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
 	// then call the index-based method
-	return getType(aRow, col);
+	setValueAsType(aRow, col, aType, aValue);
 }
 
 
-CKVariantType CKTable::getType( const CKString & aRowLabel, int aCol ) const
+void CKTable::setValueAsType( const CKString & aRowLabel, int aCol,
+							  CKVariantType aType, const char *aValue )
 {
 	// convert the row label to a row index
 	int		row = getRowForLabel(aRowLabel);
 	if (row < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getType(const CKString &, int) "
-			"- there is no currently defined row label '" << aRowLabel <<
-			"' please make sure the row labels are properly defined.";
+		msg << "CKTable::setValueAsType(const CKString &, int, "
+			"CKVariantType, const char *) - there is no currently defined row "
+			"label '" << aRowLabel << "' please make sure the row labels are "
+			"properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
 	// then call the index-based method
-	return getType(row, aCol);
+	setValueAsType(row, aCol, aType, aValue);
 }
 
 
-CKVariantType CKTable::getType( const CKString & aRowLabel, const CKString & aColHeader ) const
+void CKTable::setValueAsType( const CKString & aRowLabel, const CKString & aColHeader,
+							  CKVariantType aType, const char *aValue )
 {
 	// convert the row label to a row index
 	int		row = getRowForLabel(aRowLabel);
 	if (row < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getType(const CKString &, const CKString &) "
-			"- there is no currently defined row label '" << aRowLabel <<
-			"' please make sure the row labels are properly defined.";
+		msg << "CKTable::setValueAsType(const CKString &, const CKString &, "
+			"CKVariantType, const char *) - there is no currently defined row "
+			"label '" << aRowLabel << "' please make sure the row labels are "
+			"properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
@@ -1368,99 +1951,95 @@ CKVariantType CKTable::getType( const CKString & aRowLabel, const CKString & aCo
 	int		col = getColumnForHeader(aColHeader);
 	if (col < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getType(const CKString &, const CKString &) "
-			"- there is no currently defined column header '" << aColHeader <<
-			"' please make sure the column headers are properly defined.";
+		msg << "CKTable::setValueAsType(const CKString &, const CKString &, "
+			"CKVariantType, const char *) - there is no currently defined "
+			"column header '" << aColHeader << "' please make sure the column "
+			"headers are properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
 	// then call the index-based method
-	return getType(row, col);
+	setValueAsType(row, col, aType, aValue);
 }
 
 
 /*
- * This method will return the integer value of the data stored in this
- * location - if the type is numeric. If the data isn't numeric an
- * exception will be thrown as it's assumed that the user should make
- * sure that this instance is numeric *before* calling this method.
+ * This sets the value stored in this location as a string, but a local
+ * copy will be made so that the caller doesn't have to worry about
+ * holding on to the parameter, and is free to delete it.
  */
-int CKTable::getIntValue( int aRow, int aCol ) const
+void CKTable::setStringValue( int aRow, int aCol, const char *aStringValue )
 {
 	// first, make sure we have a place to put this data
 	if ((aRow < 0) || (aRow >= mNumRows) ||
 		(aCol < 0) || (aCol >= mNumColumns)) {
 		std::ostringstream	msg;
-		msg << "CKTable::getIntValue(int, int) - the provided "
-			"location: " << aRow << ", " << aCol << " lies outside the currently "
-			"defined table: " << mNumRows << " by " << mNumColumns;
+		msg << "CKTable::setStringValue(int, int, const char *) - the "
+			"provided location: " << aRow << ", " << aCol << " lies outside "
+			"the currently defined table: " << mNumRows << " by " <<
+			mNumColumns;
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 	// ...and that we have a table structure that matches
-	if (mTable == NULL) {
-		std::ostringstream	msg;
-		msg << "CKTable::getIntValue(int, int) - there is no currently "
-			"defined table structure in this class. This is a serious data "
-			"integrity problem that needs to be looked into.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
-	// don't forget to make sure the type matches
-	if (getType(aRow, aCol) != eNumberVariant) {
+	if (!hasStorage()) {
 		std::ostringstream	msg;
-		msg << "CKTable::getIntValue(int, int) - the provided "
-			"location: " << aRow << ", " << aCol << " does not contain a numeric "
-			"value: " << mTable[aRow * mNumColumns + aCol];
+		msg << "CKTable::setStringValue(int, int, const char *) - there "
+			"is no currently defined table structure in this class. This is a "
+			"serious data integrity problem that needs to be looked into.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
-	// now get what they are looking for
-	return mTable[aRow * mNumColumns + aCol].getIntValue();
+	// now set it intelligently
+	variantCell(aRow, aCol).setStringValue(aStringValue);
 }
 
 
-int CKTable::getIntValue( int aRow, const CKString & aColHeader ) const
+void CKTable::setStringValue( int aRow, const CKString & aColHeader, const char *aStringValue )
 {
 	// convert the column header to a column index
 	int		col = getColumnForHeader(aColHeader);
 	if (col < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getIntValue(int, const CKString &) "
-			"- there is no currently defined column header '" << aColHeader <<
-			"' please make sure the column headers are properly defined.";
+		msg << "CKTable::setStringValue(int, const CKString &, "
+			"const char *) - there is no currently defined "
+			"column header '" << aColHeader << "' please make sure the column "
+			"headers are properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
 	// then call the index-based method
-	return getIntValue(aRow, col);
+	setStringValue(aRow, col, aStringValue);
 }
 
 
-int CKTable::getIntValue( const CKString & aRowLabel, int aCol ) const
+void CKTable::setStringValue( const CKString & aRowLabel, int aCol, const char *aStringValue )
 {
 	// convert the row label to a row index
 	int		row = getRowForLabel(aRowLabel);
 	if (row < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getIntValue(const CKString &, const CKString &) "
-			"- there is no currently defined row label '" << aRowLabel <<
-			"' please make sure the row labels are properly defined.";
+		msg << "CKTable::setStringValue(const CKString &, int, "
+			"const char *) - there is no currently defined row "
+			"label '" << aRowLabel << "' please make sure the row labels are "
+			"properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
 	// then call the index-based method
-	return getIntValue(row, aCol);
+	setStringValue(row, aCol, aStringValue);
 }
 
 
-int CKTable::getIntValue( const CKString & aRowLabel, const CKString & aColHeader ) const
+void CKTable::setStringValue( const CKString & aRowLabel, const CKString & aColHeader, const char *aStringValue )
 {
 	// convert the row label to a row index
 	int		row = getRowForLabel(aRowLabel);
 	if (row < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getIntValue(const CKString &, const CKString &) "
-			"- there is no currently defined row label '" << aRowLabel <<
-			"' please make sure the row labels are properly defined.";
+		msg << "CKTable::setStringValue(const CKString &, const CKString &, "
+			"const char *) - there is no currently defined row "
+			"label '" << aRowLabel << "' please make sure the row labels are "
+			"properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
@@ -1468,99 +2047,90 @@ int CKTable::getIntValue( const CKString & aRowLabel, const CKString & aColHeade
 	int		col = getColumnForHeader(aColHeader);
 	if (col < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getIntValue(const CKString &, const CKString &) "
-			"- there is no currently defined column header '" << aColHeader <<
-			"' please make sure the column headers are properly defined.";
+		msg << "CKTable::setStringValue(const CKString &, const CKString &, "
+			"const char *) - there is no currently defined "
+			"column header '" << aColHeader << "' please make sure the column "
+			"headers are properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
 	// then call the index-based method
-	return getIntValue(row, col);
+	setStringValue(row, col, aStringValue);
 }
 
 
-/*
- * This method will return the double value of the data stored in this
- * location - if the type is numeric. If the data isn't numeric an
- * exception will be thrown as it's assumed that the user should make
- * sure that this instance is numeric *before* calling this method.
- */
-double CKTable::getDoubleValue( int aRow, int aCol ) const
+void CKTable::setStringValue( int aRow, int aCol, const CKString *aStringValue )
 {
 	// first, make sure we have a place to put this data
 	if ((aRow < 0) || (aRow >= mNumRows) ||
 		(aCol < 0) || (aCol >= mNumColumns)) {
 		std::ostringstream	msg;
-		msg << "CKTable::getDoubleValue(int, int) - the provided "
-			"location: " << aRow << ", " << aCol << " lies outside the currently "
-			"defined table: " << mNumRows << " by " << mNumColumns;
+		msg << "CKTable::setStringValue(int, int, const CKString *) - the "
+			"provided location: " << aRow << ", " << aCol << " lies outside "
+			"the currently defined table: " << mNumRows << " by " <<
+			mNumColumns;
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 	// ...and that we have a table structure that matches
-	if (mTable == NULL) {
-		std::ostringstream	msg;
-		msg << "CKTable::getDoubleValue(int, int) - there is no currently "
-			"defined table structure in this class. This is a serious data "
-			"integrity problem that needs to be looked into.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
-	// don't forget to make sure the type matches
-	if (getType(aRow, aCol) != eNumberVariant) {
+	if (!hasStorage()) {
 		std::ostringstream	msg;
-		msg << "CKTable::getDoubleValue(int, int) - the provided "
-			"location: " << aRow << ", " << aCol << " does not contain a numeric "
-			"value: " << mTable[aRow * mNumColumns + aCol];
+		msg << "CKTable::setStringValue(int, int, const CKString *) - there "
+			"is no currently defined table structure in this class. This is a "
+			"serious data integrity problem that needs to be looked into.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
-	// now get what they are looking for
-	return mTable[aRow * mNumColumns + aCol].getDoubleValue();
+	// now set it intelligently
+	variantCell(aRow, aCol).setStringValue(aStringValue);
 }
 
 
-double CKTable::getDoubleValue( int aRow, const CKString & aColHeader ) const
+void CKTable::setStringValue( int aRow, const CKString & aColHeader, const CKString *aStringValue )
 {
 	// convert the column header to a column index
 	int		col = getColumnForHeader(aColHeader);
 	if (col < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getDoubleValue(int, const CKString &) "
-			"- there is no currently defined column header '" << aColHeader <<
-			"' please make sure the column headers are properly defined.";
+		msg << "CKTable::setStringValue(int, const CKString &, "
+			"const CKString *) - there is no currently defined "
+			"column header '" << aColHeader << "' please make sure the column "
+			"headers are properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
 	// then call the index-based method
-	return getDoubleValue(aRow, col);
+	setStringValue(aRow, col, aStringValue);
 }
 
 
-double CKTable::getDoubleValue( const CKString & aRowLabel, int aCol ) const
+void CKTable::setStringValue( const CKString & aRowLabel, int aCol, const CKString *aStringValue )
 {
 	// convert the row label to a row index
 	int		row = getRowForLabel(aRowLabel);
 	if (row < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getDoubleValue(const CKString &, int) "
-			"- there is no currently defined row label '" << aRowLabel <<
-			"' please make sure the row labels are properly defined.";
+		msg << "CKTable::setStringValue(const CKString &, int, "
+			"const CKString *) - there is no currently defined row "
+			"label '" << aRowLabel << "' please make sure the row labels are "
+			"properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
 	// then call the index-based method
-	return getDoubleValue(row, aCol);
+	setStringValue(row, aCol, aStringValue);
 }
 
 
-double CKTable::getDoubleValue( const CKString & aRowLabel, const CKString & aColHeader ) const
+void CKTable::setStringValue( const CKString & aRowLabel, const CKString & aColHeader, const CKString *aStringValue )
 {
 	// convert the row label to a row index
 	int		row = getRowForLabel(aRowLabel);
 	if (row < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getDoubleValue(const CKString &, const CKString &) "
-			"- there is no currently defined row label '" << aRowLabel <<
-			"' please make sure the row labels are properly defined.";
+		msg << "CKTable::setStringValue(const CKString &, const CKString &, "
+			"const CKString *) - there is no currently defined row "
+			"label '" << aRowLabel << "' please make sure the row labels are "
+			"properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
@@ -1568,100 +2138,99 @@ double CKTable::getDoubleValue( const CKString & aRowLabel, const CKString & aCo
 	int		col = getColumnForHeader(aColHeader);
 	if (col < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getDoubleValue(const CKString &, const CKString &) "
-			"- there is no currently defined column header '" << aColHeader <<
-			"' please make sure the column headers are properly defined.";
+		msg << "CKTable::setStringValue(const CKString &, const CKString &, "
+			"const CKString *) - there is no currently defined "
+			"column header '" << aColHeader << "' please make sure the column "
+			"headers are properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
 	// then call the index-based method
-	return getDoubleValue(row, col);
+	setStringValue(row, col, aStringValue);
 }
 
 
 /*
- * This method will return the date value of the data stored in this
- * location in a long of the form YYYYMMDD - if the type is date. If
- * the data isn't date an exception will be thrown as it's assumed
- * that the user should make sure that this instance is date *before*
- * calling this method.
+ * This method sets the value stored in this location as a date of the
+ * form YYYYMMDD - stored as a long.
  */
-long CKTable::getDateValue( int aRow, int aCol ) const
+void CKTable::setDateValue( int aRow, int aCol, long aDateValue )
 {
 	// first, make sure we have a place to put this data
 	if ((aRow < 0) || (aRow >= mNumRows) ||
 		(aCol < 0) || (aCol >= mNumColumns)) {
 		std::ostringstream	msg;
-		msg << "CKTable::getDateValue(int, int) - the provided "
-			"location: " << aRow << ", " << aCol << " lies outside the currently "
-			"defined table: " << mNumRows << " by " << mNumColumns;
+		msg << "CKTable::setDateValue(int, int, long) - the "
+			"provided location: " << aRow << ", " << aCol << " lies outside "
+			"the currently defined table: " << mNumRows << " by " <<
+			mNumColumns;
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 	// ...and that we have a table structure that matches
-	if (mTable == NULL) {
+	if (!hasStorage()) {
 		std::ostringstream	msg;
-		msg << "CKTable::getDateValue(int, int) - there is no currently "
-			"defined table structure in this class. This is a serious data "
-			"integrity problem that needs to be looked into.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
-	// don't forget to make sure the type matches
-	if (getType(aRow, aCol) != eDateVariant) {
-		std::ostringstream	msg;
-		msg << "CKTable::getDateValue(int, int) - the provided "
-			"location: " << aRow << ", " << aCol << " does not contain a date "
-			"value: " << mTable[aRow * mNumColumns + aCol];
+		msg << "CKTable::setDateValue(int, int, long) - there "
+			"is no currently defined table structure in this class. This is a "
+			"serious data integrity problem that needs to be looked into.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
-	// now get what they are looking for
-	return mTable[aRow * mNumColumns + aCol].getDateValue();
+	// now set it intelligently - right into a dense column of dates
+	if ((mColumns != NULL) && (mColumns[aCol].type == eDateVariant)) {
+		mColumns[aCol].dates[aRow] = aDateValue;
+		markRow(mColumns[aCol].valid, aRow, true);
+	} else {
+		variantCell(aRow, aCol).setDateValue(aDateValue);
+	}
 }
 
 
-long CKTable::getDateValue( int aRow, const CKString & aColHeader ) const
+void CKTable::setDateValue( int aRow, const CKString & aColHeader, long aDateValue )
 {
 	// convert the column header to a column index
 	int		col = getColumnForHeader(aColHeader);
 	if (col < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getDateValue(int, const CKString &) "
-			"- there is no currently defined column header '" << aColHeader <<
-			"' please make sure the column headers are properly defined.";
+		msg << "CKTable::setDateValue(int, const CKString &, "
+			"long) - there is no currently defined "
+			"column header '" << aColHeader << "' please make sure the column "
+			"headers are properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
 	// then call the index-based method
-	return getDateValue(aRow, col);
+	setDateValue(aRow, col, aDateValue);
 }
 
 
-long CKTable::getDateValue( const CKString & aRowLabel, int aCol ) const
+void CKTable::setDateValue( const CKString & aRowLabel, int aCol, long aDateValue )
 {
 	// convert the row label to a row index
 	int		row = getRowForLabel(aRowLabel);
 	if (row < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getDateValue(const CKString &, int) "
-			"- there is no currently defined row label '" << aRowLabel <<
-			"' please make sure the row labels are properly defined.";
+		msg << "CKTable::setDateValue(const CKString &, int, "
+			"long) - there is no currently defined row "
+			"label '" << aRowLabel << "' please make sure the row labels are "
+			"properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
 	// then call the index-based method
-	return getDateValue(row, aCol);
+	setDateValue(row, aCol, aDateValue);
 }
 
 
-long CKTable::getDateValue( const CKString & aRowLabel, const CKString & aColHeader ) const
+void CKTable::setDateValue( const CKString & aRowLabel, const CKString & aColHeader, long aDateValue )
 {
 	// convert the row label to a row index
 	int		row = getRowForLabel(aRowLabel);
 	if (row < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getDateValue(const CKString &, const CKString &) "
-			"- there is no currently defined row label '" << aRowLabel <<
-			"' please make sure the row labels are properly defined.";
+		msg << "CKTable::setDateValue(const CKString &, const CKString &, "
+			"long) - there is no currently defined row "
+			"label '" << aRowLabel << "' please make sure the row labels are "
+			"properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
@@ -1669,99 +2238,98 @@ long CKTable::getDateValue( const CKString & aRowLabel, const CKString & aColHea
 	int		col = getColumnForHeader(aColHeader);
 	if (col < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getDateValue(const CKString &, const CKString &) "
-			"- there is no currently defined column header '" << aColHeader <<
-			"' please make sure the column headers are properly defined.";
+		msg << "CKTable::setDateValue(const CKString &, const CKString &, "
+			"long) - there is no currently defined "
+			"column header '" << aColHeader << "' please make sure the column "
+			"headers are properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
 	// then call the index-based method
-	return getDateValue(row, col);
+	setDateValue(row, col, aDateValue);
 }
 
 
 /*
- * This method returns the actual string value of the data that
- * this location is holding. If the user wants to use this value
- * outside the scope of this class, then they need to make a copy,
- * or call the getValueAsString() method that returns a copy.
+ * This method sets the value stored in this location as a double.
  */
-const CKString *CKTable::getStringValue( int aRow, int aCol ) const
+void CKTable::setDoubleValue( int aRow, int aCol, double aDoubleValue )
 {
 	// first, make sure we have a place to put this data
 	if ((aRow < 0) || (aRow >= mNumRows) ||
 		(aCol < 0) || (aCol >= mNumColumns)) {
 		std::ostringstream	msg;
-		msg << "CKTable::getStringValue(int, int) - the provided "
-			"location: " << aRow << ", " << aCol << " lies outside the currently "
-			"defined table: " << mNumRows << " by " << mNumColumns;
+		msg << "CKTable::setDoubleValue(int, int, long) - the "
+			"provided location: " << aRow << ", " << aCol << " lies outside "
+			"the currently defined table: " << mNumRows << " by " <<
+			mNumColumns;
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 	// ...and that we have a table structure that matches
-	if (mTable == NULL) {
-		std::ostringstream	msg;
-		msg << "CKTable::getStringValue(int, int) - there is no currently "
-			"defined table structure in this class. This is a serious data "
-			"integrity problem that needs to be looked into.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
-	// don't forget to make sure the type matches
-	if (getType(aRow, aCol) != eStringVariant) {
+	if (!hasStorage()) {
 		std::ostringstream	msg;
-		msg << "CKTable::getStringValue(int, int) - the provided "
-			"location: " << aRow << ", " << aCol << " does not contain a string "
-			"value: " << mTable[aRow * mNumColumns + aCol];
+		msg << "CKTable::setDoubleValue(int, int, long) - there "
+			"is no currently defined table structure in this class. This is a "
+			"serious data integrity problem that needs to be looked into.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
-	// now get what they are looking for
-	return mTable[aRow * mNumColumns + aCol].getStringValue();
+	// now set it intelligently - right into a dense column of numbers
+	if ((mColumns != NULL) && (mColumns[aCol].type == eNumberVariant)) {
+		mColumns[aCol].doubles[aRow] = aDoubleValue;
+		markRow(mColumns[aCol].valid, aRow, true);
+	} else {
+		variantCell(aRow, aCol).setDoubleValue(aDoubleValue);
+	}
 }
 
 
-const CKString *CKTable::getStringValue( int aRow, const CKString & aColHeader ) const
+void CKTable::setDoubleValue( int aRow, const CKString & aColHeader, double aDoubleValue )
 {
 	// convert the column header to a column index
 	int		col = getColumnForHeader(aColHeader);
 	if (col < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getStringValue(int, const CKString &) "
-			"- there is no currently defined column header '" << aColHeader <<
-			"' please make sure the column headers are properly defined.";
+		msg << "CKTable::setDoubleValue(int, const CKString &, "
+			"double) - there is no currently defined "
+			"column header '" << aColHeader << "' please make sure the column "
+			"headers are properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
 	// then call the index-based method
-	return getStringValue(aRow, col);
+	setDoubleValue(aRow, col, aDoubleValue);
 }
 
 
-const CKString *CKTable::getStringValue( const CKString & aRowLabel, int aCol ) const
+void CKTable::setDoubleValue( const CKString & aRowLabel, int aCol, double aDoubleValue )
 {
 	// convert the row label to a row index
 	int		row = getRowForLabel(aRowLabel);
 	if (row < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getStringValue(const CKString &, int) "
-			"- there is no currently defined row label '" << aRowLabel <<
-			"' please make sure the row labels are properly defined.";
+		msg << "CKTable::setDoubleValue(const CKString &, int, "
+			"double) - there is no currently defined row "
+			"label '" << aRowLabel << "' please make sure the row labels are "
+			"properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
 	// then call the index-based method
-	return getStringValue(row, aCol);
+	setDoubleValue(row, aCol, aDoubleValue);
 }
 
 
-const CKString *CKTable::getStringValue( const CKString & aRowLabel, const CKString & aColHeader ) const
+void CKTable::setDoubleValue( const CKString & aRowLabel, const CKString & aColHeader, double aDoubleValue )
 {
 	// convert the row label to a row index
 	int		row = getRowForLabel(aRowLabel);
 	if (row < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getStringValue(const CKString &, const CKString &) "
-			"- there is no currently defined row label '" << aRowLabel <<
-			"' please make sure the row labels are properly defined.";
+		msg << "CKTable::setDoubleValue(const CKString &, const CKString &, "
+			"double) - there is no currently defined row "
+			"label '" << aRowLabel << "' please make sure the row labels are "
+			"properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
@@ -1769,98 +2337,95 @@ const CKString *CKTable::getStringValue( const CKString & aRowLabel, const CKStr
 	int		col = getColumnForHeader(aColHeader);
 	if (col < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getStringValue(const CKString &, const CKString &) "
-			"- there is no currently defined column header '" << aColHeader <<
-			"' please make sure the column headers are properly defined.";
+		msg << "CKTable::setDoubleValue(const CKString &, const CKString &, "
+			"double) - there is no currently defined "
+			"column header '" << aColHeader << "' please make sure the column "
+			"headers are properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
 	// then call the index-based method
-	return getStringValue(row, col);
+	setDoubleValue(row, col, aDoubleValue);
 }
 
 
 /*
- * This method returns the actual table value of the data that
- * this location is holding. If the user wants to use this value
- * outside the scope of this class, then they need to make a copy.
+ * This sets the value stored in this location as a table, but a local
+ * copy will be made so that the caller doesn't have to worry about
+ * holding on to the parameter, and is free to delete it.
  */
-const CKTable *CKTable::getTableValue( int aRow, int aCol ) const
+void CKTable::setTableValue( int aRow, int aCol, const CKTable *aTableValue )
 {
 	// first, make sure we have a place to put this data
 	if ((aRow < 0) || (aRow >= mNumRows) ||
 		(aCol < 0) || (aCol >= mNumColumns)) {
 		std::ostringstream	msg;
-		msg << "CKTable::getTableValue(int, int) - the provided "
-			"location: " << aRow << ", " << aCol << " lies outside the currently "
-			"defined table: " << mNumRows << " by " << mNumColumns;
+		msg << "CKTable::setTableValue(int, int, const CKTable *) - the "
+			"provided location: " << aRow << ", " << aCol << " lies outside "
+			"the currently defined table: " << mNumRows << " by " <<
+			mNumColumns;
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 	// ...and that we have a table structure that matches
-	if (mTable == NULL) {
-		std::ostringstream	msg;
-		msg << "CKTable::getTableValue(int, int) - there is no currently "
-			"defined table structure in this class. This is a serious data "
-			"integrity problem that needs to be looked into.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
-	// don't forget to make sure the type matches
-	if (getType(aRow, aCol) != eTableVariant) {
+	if (!hasStorage()) {
 		std::ostringstream	msg;
-		msg << "CKTable::getTableValue(int, int) - the provided "
-			"location: " << aRow << ", " << aCol << " does not contain a table "
-			"value: " << getValue(aRow, aCol);
+		msg << "CKTable::setTableValue(int, int, const CKTable *) - there "
+			"is no currently defined table structure in this class. This is a "
+			"serious data integrity problem that needs to be looked into.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
-	// now get what they are looking for
-	return mTable[aRow * mNumColumns + aCol].getTableValue();
+	// now set it intelligently
+	variantCell(aRow, aCol).setTableValue(aTableValue);
 }
 
 
-const CKTable *CKTable::getTableValue( int aRow, const CKString & aColHeader ) const
+void CKTable::setTableValue( int aRow, const CKString & aColHeader, const CKTable *aTableValue )
 {
 	// convert the column header to a column index
 	int		col = getColumnForHeader(aColHeader);
 	if (col < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getTableValue(int, const CKString &) "
-			"- there is no currently defined column header '" << aColHeader <<
-			"' please make sure the column headers are properly defined.";
+		msg << "CKTable::setTableValue(int, const CKString &, "
+			"const CKTable *) - there is no currently defined "
+			"column header '" << aColHeader << "' please make sure the column "
+			"headers are properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
 	// then call the index-based method
-	return getTableValue(aRow, col);
+	setTableValue(aRow, col, aTableValue);
 }
 
 
-const CKTable *CKTable::getTableValue( const CKString & aRowLabel, int aCol ) const
+void CKTable::setTableValue( const CKString & aRowLabel, int aCol, const CKTable *aTableValue )
 {
 	// convert the row label to a row index
 	int		row = getRowForLabel(aRowLabel);
 	if (row < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getTableValue(const CKString &, int) "
-			"- there is no currently defined row label '" << aRowLabel <<
-			"' please make sure the row labels are properly defined.";
+		msg << "CKTable::setTableValue(const CKString &, int, "
+			"const CKTable *) - there is no currently defined row "
+			"label '" << aRowLabel << "' please make sure the row labels are "
+			"properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
 	// then call the index-based method
-	return getTableValue(row, aCol);
+	setTableValue(row, aCol, aTableValue);
 }
 
 
-const CKTable *CKTable::getTableValue( const CKString & aRowLabel, const CKString & aColHeader ) const
+void CKTable::setTableValue( const CKString & aRowLabel, const CKString & aColHeader, const CKTable *aTableValue )
 {
 	// convert the row label to a row index
 	int		row = getRowForLabel(aRowLabel);
 	if (row < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getTableValue(const CKString &, const CKString &) "
-			"- there is no currently defined row label '" << aRowLabel <<
-			"' please make sure the row labels are properly defined.";
+		msg << "CKTable::setTableValue(const CKString &, const CKString &, "
+			"const CKTable *) - there is no currently defined row "
+			"label '" << aRowLabel << "' please make sure the row labels are "
+			"properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
@@ -1868,98 +2433,95 @@ const CKTable *CKTable::getTableValue( const CKString & aRowLabel, const CKStrin
 	int		col = getColumnForHeader(aColHeader);
 	if (col < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getTableValue(const CKString &, const CKString &) "
-			"- there is no currently defined column header '" << aColHeader <<
-			"' please make sure the column headers are properly defined.";
+		msg << "CKTable::setTableValue(const CKString &, const CKString &, "
+			"const CKTable *) - there is no currently defined "
+			"column header '" << aColHeader << "' please make sure the column "
+			"headers are properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
 	// then call the index-based method
-	return getTableValue(row, col);
+	setTableValue(row, col, aTableValue);
 }
 
 
 /*
- * This method returns the actual time series value of the data that
- * this location is holding. If the user wants to use this value
- * outside the scope of this class, then they need to make a copy.
+ * This sets the value stored in this location as a time series, but
+ * a local copy will be made so that the caller doesn't have to worry
+ * about holding on to the parameter, and is free to delete it.
  */
-const CKTimeSeries *CKTable::getTimeSeriesValue( int aRow, int aCol ) const
+void CKTable::setTimeSeriesValue( int aRow, int aCol, const CKTimeSeries *aTimeSeriesValue )
 {
 	// first, make sure we have a place to put this data
 	if ((aRow < 0) || (aRow >= mNumRows) ||
 		(aCol < 0) || (aCol >= mNumColumns)) {
 		std::ostringstream	msg;
-		msg << "CKTable::getTimeSeriesValue(int, int) - the provided "
-			"location: " << aRow << ", " << aCol << " lies outside the currently "
-			"defined table: " << mNumRows << " by " << mNumColumns;
+		msg << "CKTable::setTimeSeriesValue(int, int, const CKTimeSeries *) - the "
+			"provided location: " << aRow << ", " << aCol << " lies outside "
+			"the currently defined table: " << mNumRows << " by " <<
+			mNumColumns;
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 	// ...and that we have a table structure that matches
-	if (mTable == NULL) {
-		std::ostringstream	msg;
-		msg << "CKTable::getTimeSeriesValue(int, int) - there is no currently "
-			"defined table structure in this class. This is a serious data "
-			"integrity problem that needs to be looked into.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
-	// don't forget to make sure the type matches
-	if (getType(aRow, aCol) != eTimeSeriesVariant) {
+	if (!hasStorage()) {
 		std::ostringstream	msg;
-		msg << "CKTable::getTimeSeriesValue(int, int) - the provided "
-			"location: " << aRow << ", " << aCol << " does not contain a time "
-			"series value: " << getValue(aRow, aCol);
+		msg << "CKTable::setTimeSeriesValue(int, int, const CKTimeSeries *) - there "
+			"is no currently defined table structure in this class. This is a "
+			"serious data integrity problem that needs to be looked into.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
-	// now get what they are looking for
-	return mTable[aRow * mNumColumns + aCol].getTimeSeriesValue();
+	// now set it intelligently
+	variantCell(aRow, aCol).setTimeSeriesValue(aTimeSeriesValue);
 }
 
 
-const CKTimeSeries *CKTable::getTimeSeriesValue( int aRow, const CKString & aColHeader ) const
+void CKTable::setTimeSeriesValue( int aRow, const CKString & aColHeader, const CKTimeSeries *aTimeSeriesValue )
 {
 	// convert the column header to a column index
 	int		col = getColumnForHeader(aColHeader);
 	if (col < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getTimeSeriesValue(const CKString &, const CKString &) "
-			"- there is no currently defined column header '" << aColHeader <<
-			"' please make sure the column headers are properly defined.";
+		msg << "CKTable::setTimeSeriesValue(int, const CKString &, "
+			"const CKTimeSeries *) - there is no currently defined "
+			"column header '" << aColHeader << "' please make sure the column "
+			"headers are properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
 	// then call the index-based method
-	return getTimeSeriesValue(aRow, col);
+	setTimeSeriesValue(aRow, col, aTimeSeriesValue);
 }
 
 
-const CKTimeSeries *CKTable::getTimeSeriesValue( const CKString & aRowLabel, int aCol ) const
+void CKTable::setTimeSeriesValue( const CKString & aRowLabel, int aCol, const CKTimeSeries *aTimeSeriesValue )
 {
 	// convert the row label to a row index
 	int		row = getRowForLabel(aRowLabel);
 	if (row < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getTimeSeriesValue(const CKString &, const CKString &) "
-			"- there is no currently defined row label '" << aRowLabel <<
-			"' please make sure the row labels are properly defined.";
+		msg << "CKTable::setTimeSeriesValue(const CKString &, int, "
+			"const CKTimeSeries *) - there is no currently defined row "
+			"label '" << aRowLabel << "' please make sure the row labels are "
+			"properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
 	// then call the index-based method
-	return getTimeSeriesValue(row, aCol);
+	setTimeSeriesValue(row, aCol, aTimeSeriesValue);
 }
 
 
-const CKTimeSeries *CKTable::getTimeSeriesValue( const CKString & aRowLabel, const CKString & aColHeader ) const
+void CKTable::setTimeSeriesValue( const CKString & aRowLabel, const CKString & aColHeader, const CKTimeSeries *aTimeSeriesValue )
 {
 	// convert the row label to a row index
 	int		row = getRowForLabel(aRowLabel);
 	if (row < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getTimeSeriesValue(const CKString &, const CKString &) "
-			"- there is no currently defined row label '" << aRowLabel <<
-			"' please make sure the row labels are properly defined.";
+		msg << "CKTable::setTimeSeriesValue(const CKString &, const CKString &, "
+			"const CKTimeSeries *) - there is no currently defined row "
+			"label '" << aRowLabel << "' please make sure the row labels are "
+			"properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
@@ -1967,98 +2529,95 @@ const CKTimeSeries *CKTable::getTimeSeriesValue( const CKString & aRowLabel, con
 	int		col = getColumnForHeader(aColHeader);
 	if (col < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getTimeSeriesValue(const CKString &, const CKString &) "
-			"- there is no currently defined column header '" << aColHeader <<
-			"' please make sure the column headers are properly defined.";
+		msg << "CKTable::setTimeSeriesValue(const CKString &, const CKString &, "
+			"const CKTimeSeries *) - there is no currently defined "
+			"column header '" << aColHeader << "' please make sure the column "
+			"headers are properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
 	// then call the index-based method
-	return getTimeSeriesValue(row, col);
+	setTimeSeriesValue(row, col, aTimeSeriesValue);
 }
 
 
 /*
- * This method returns the actual price value of the data that
- * this location is holding. If the user wants to use this value
- * outside the scope of this class, then they need to make a copy.
+ * This sets the value stored in this location as a price, but
+ * a local copy will be made so that the caller doesn't have to worry
+ * about holding on to the parameter, and is free to delete it.
  */
-const CKPrice *CKTable::getPriceValue( int aRow, int aCol ) const
+void CKTable::setPriceValue( int aRow, int aCol, const CKPrice *aPriceValue )
 {
 	// first, make sure we have a place to put this data
 	if ((aRow < 0) || (aRow >= mNumRows) ||
 		(aCol < 0) || (aCol >= mNumColumns)) {
 		std::ostringstream	msg;
-		msg << "CKTable::getPriceValue(int, int) - the provided "
-			"location: " << aRow << ", " << aCol << " lies outside the currently "
-			"defined table: " << mNumRows << " by " << mNumColumns;
+		msg << "CKTable::setPriceValue(int, int, const CKPrice *) - the "
+			"provided location: " << aRow << ", " << aCol << " lies outside "
+			"the currently defined table: " << mNumRows << " by " <<
+			mNumColumns;
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 	// ...and that we have a table structure that matches
-	if (mTable == NULL) {
-		std::ostringstream	msg;
-		msg << "CKTable::getPriceValue(int, int) - there is no currently "
-			"defined table structure in this class. This is a serious data "
-			"integrity problem that needs to be looked into.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
-	// don't forget to make sure the type matches
-	if (getType(aRow, aCol) != ePriceVariant) {
+	if (!hasStorage()) {
 		std::ostringstream	msg;
-		msg << "CKTable::getPriceValue(int, int) - the provided "
-			"location: " << aRow << ", " << aCol << " does not contain a "
-			"price value: " << getValue(aRow, aCol);
+		msg << "CKTable::setPriceValue(int, int, const CKPrice *) - there "
+			"is no currently defined table structure in this class. This is a "
+			"serious data integrity problem that needs to be looked into.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
-	// now get what they are looking for
-	return mTable[aRow * mNumColumns + aCol].getPriceValue();
+	// now set it intelligently
+	variantCell(aRow, aCol).setPriceValue(aPriceValue);
 }
 
 
-const CKPrice *CKTable::getPriceValue( int aRow, const CKString & aColHeader ) const
+void CKTable::setPriceValue( int aRow, const CKString & aColHeader, const CKPrice *aPriceValue )
 {
 	// convert the column header to a column index
 	int		col = getColumnForHeader(aColHeader);
 	if (col < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getPriceValue(const CKString &, const CKString &) "
-			"- there is no currently defined column header '" << aColHeader <<
-			"' please make sure the column headers are properly defined.";
+		msg << "CKTable::setPriceValue(int, const CKString &, "
+			"const CKPrice *) - there is no currently defined "
+			"column header '" << aColHeader << "' please make sure the column "
+			"headers are properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
 	// then call the index-based method
-	return getPriceValue(aRow, col);
+	setPriceValue(aRow, col, aPriceValue);
 }
 
 
-const CKPrice *CKTable::getPriceValue( const CKString & aRowLabel, int aCol ) const
+void CKTable::setPriceValue( const CKString & aRowLabel, int aCol, const CKPrice *aPriceValue )
 {
 	// convert the row label to a row index
 	int		row = getRowForLabel(aRowLabel);
 	if (row < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getPriceValue(const CKString &, const CKString &) "
-			"- there is no currently defined row label '" << aRowLabel <<
-			"' please make sure the row labels are properly defined.";
+		msg << "CKTable::setPriceValue(const CKString &, int, "
+			"const CKPrice *) - there is no currently defined row "
+			"label '" << aRowLabel << "' please make sure the row labels are "
+			"properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
 	// then call the index-based method
-	return getPriceValue(row, aCol);
+	setPriceValue(row, aCol, aPriceValue);
 }
 
 
-const CKPrice *CKTable::getPriceValue( const CKString & aRowLabel, const CKString & aColHeader ) const
+void CKTable::setPriceValue( const CKString & aRowLabel, const CKString & aColHeader, const CKPrice *aPriceValue )
 {
 	// convert the row label to a row index
 	int		row = getRowForLabel(aRowLabel);
 	if (row < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getPriceValue(const CKString &, const CKString &) "
-			"- there is no currently defined row label '" << aRowLabel <<
-			"' please make sure the row labels are properly defined.";
+		msg << "CKTable::setPriceValue(const CKString &, const CKString &, "
+			"const CKPrice *) - there is no currently defined row "
+			"label '" << aRowLabel << "' please make sure the row labels are "
+			"properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
@@ -2066,348 +2625,1674 @@ const CKPrice *CKTable::getPriceValue( const CKString & aRowLabel, const CKStrin
 	int		col = getColumnForHeader(aColHeader);
 	if (col < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getPriceValue(const CKString &, const CKString &) "
-			"- there is no currently defined column header '" << aColHeader <<
-			"' please make sure the column headers are properly defined.";
+		msg << "CKTable::setPriceValue(const CKString &, const CKString &, "
+			"const CKPrice *) - there is no currently defined "
+			"column header '" << aColHeader << "' please make sure the column "
+			"headers are properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
 	// then call the index-based method
-	return getPriceValue(row, col);
+	setPriceValue(row, col, aPriceValue);
 }
 
 
 /*
- * This method returns the actual CKString value that is the
- * column header for the provided column number assuming that it
- * actually exists in the table. As such, if the user wants this
- * value outside the scope fo this class they need to make a copy
- * of it.
+ * This method takes the supplied column number and the header and
+ * assuming the table is big enough to include that column, sets the
+ * column header for that column to the supplied value. A copy is
+ * made of the argument so the caller retains control of the memory.
  */
-const CKString & CKTable::getColumnHeader( int aCol ) const
+void CKTable::setColumnHeader( int aCol, const CKString & aHeader )
 {
 	// first, make sure we have a place to put this data
 	if ((aCol < 0) || (aCol >= mNumColumns)) {
 		std::ostringstream	msg;
-		msg << "CKTable::getColumnHeader(int) - the provided column "
-			"number: " << aCol << " lies outside the currently "
-			"defined table: " << mNumRows << " by " << mNumColumns;
+		msg << "CKTable::setColumnHeader(int, const char *) - the "
+			"provided column: " << aCol << " lies outside "
+			"the currently defined table: " << mNumRows << " by " <<
+			mNumColumns;
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
-	// now get what they are looking for
-	return mColumnHeaders[aCol];
+	// now set it intelligently
+	mColumnHeaders[aCol] = aHeader;
+	mColumnHeadersIndex.put(aHeader, aCol);
 }
 
 
 /*
- * This method returns the actual CKString value that is the
- * row label for the provided row number assuming that it
- * actually exists in the table. As such, if the user wants this
- * value outside the scope fo this class they need to make a copy
- * of it.
+ * This method takes the supplied column number and the header and
+ * assuming the table is big enough to include that column, sets the
+ * column header for that column to the supplied value. The header
+ * will be left untouched as we'll be making a copy of it for our
+ * internal use.
  */
-const CKString & CKTable::getRowLabel( int aRow ) const
+void CKTable::setColumnHeader( int aCol, const char *aHeader )
 {
 	// first, make sure we have a place to put this data
-	if ((aRow < 0) || (aRow >= mNumRows)) {
+	if ((aCol < 0) || (aCol >= mNumColumns)) {
 		std::ostringstream	msg;
-		msg << "CKTable::getRowLabel(int) - the provided row "
-			"number: " << aRow << " lies outside the currently "
-			"defined table: " << mNumRows << " by " << mNumColumns;
+		msg << "CKTable::setColumnHeader(int, const char *) - the "
+			"provided column: " << aCol << " lies outside "
+			"the currently defined table: " << mNumRows << " by " <<
+			mNumColumns;
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
-	// now get what they are looking for
-	return mRowLabels[aRow];
-}
-
-
-/*
- * This method will return the current number of rows in the table.
- * If no table is defined at this time, this method will return a -1.
- */
-int CKTable::getNumRows() const
-{
-	return mNumRows;
-}
-
-
-/*
- * This method will return the current number of columns in the
- * table. If no table is defined at this time, this method will
- * return a -1.
- */
-int CKTable::getNumColumns() const
-{
-	return mNumColumns;
+	// now set it intelligently
+	mColumnHeaders[aCol] = aHeader;
+	mColumnHeadersIndex.put(aHeader, aCol);
 }
 
 
-/********************************************************
- *
- *                Table Methods
- *
- ********************************************************/
 /*
- * This method returns the column index for the specified header.
- * If this header is not a valid column header for this table, then
- * this method will return a -1, please check for it.
+ * This method takes the supplied row number and the label and
+ * assuming the table is big enough to include that row, sets the
+ * row label for that row to the supplied value. A copy is
+ * made of the argument so the caller retains control of the memory.
  */
-int CKTable::getColumnForHeader( const CKString & aHeader ) const
+void CKTable::setRowLabel( int aRow, const CKString & aLabel )
 {
-	int		retval = -1;
-
-	// see if the header is in the map
-	std::map<CKString, int>::const_iterator		i = mColumnHeadersIndex.find(aHeader);
-	if (i != mColumnHeadersIndex.end()) {
-		// found it... so get the column number
-		retval = i->second;
+	// first, make sure we have a place to put this data
+	if ((aRow < 0) || (aRow >= mNumRows)) {
+		std::ostringstream	msg;
+		msg << "CKTable::setRowLabel(int, const char *) - the "
+			"provided row: " << aRow << " lies outside "
+			"the currently defined table: " << mNumRows << " by " <<
+			mNumColumns;
+		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
-	return retval;
+	// now set it intelligently
+	mRowLabels[aRow] = aLabel;
+	mRowLabelsIndex.put(aLabel, aRow);
 }
 
 
 /*
- * This method returns the row index for the specified label.
- * If this label is not a valid row label for this table, then
- * this method will return a -1, please check for it.
+ * This method takes the supplied row number and the label and
+ * assuming the table is big enough to include that row, sets the
+ * row label for that row to the supplied value. The label
+ * will be left untouched as we'll be making a copy of it for our
+ * internal use.
  */
-int CKTable::getRowForLabel( const CKString & aLabel ) const
+void CKTable::setRowLabel( int aRow, const char *aLabel )
 {
-	int		retval = -1;
-
-	// see if the header is in the map
-	std::map<CKString, int>::const_iterator		i = mRowLabelsIndex.find(aLabel);
-	if (i != mRowLabelsIndex.end()) {
-		// found it... so get the row number
-		retval = i->second;
+	// first, make sure we have a place to put this data
+	if ((aRow < 0) || (aRow >= mNumRows)) {
+		std::ostringstream	msg;
+		msg << "CKTable::setRowLabel(int, const char *) - the "
+			"provided row: " << aRow << " lies outside "
+			"the currently defined table: " << mNumRows << " by " <<
+			mNumColumns;
+		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
-	return retval;
+	// now set it intelligently
+	mRowLabels[aRow] = aLabel;
+	mRowLabelsIndex.put(aLabel, aRow);
 }
 
 
 /*
- * This method returns a complete vector of the CKVariants that
- * make up the supplied row in the table. This is nice if you
- * want to take a 'slice' in the table and just return a vector
- * of data for processing. The management of the returned value
- * is up to the caller.
+ * This method returns a reference to the *actual* element in the
+ * table's data structure and so the caller should be *VERY* careful
+ * what he does with it. It's nice for scanning through the data and
+ * seeing what's there, but the caller cannot delete it as it's
+ * controlled by this table's methods.
  */
-CKVector<CKVariant> CKTable::getRow( int aRow ) const
+CKVariant & CKTable::getValue( int aRow, int aCol ) const
 {
-	// first, make sure we have data to grab
-	if ((aRow < 0) || (aRow >= mNumRows)) {
+	// first, make sure we have a place to put this data
+	if ((aRow < 0) || (aRow >= mNumRows) ||
+		(aCol < 0) || (aCol >= mNumColumns)) {
 		std::ostringstream	msg;
-		msg << "CKTable::getRow(int) - the provided row: " << aRow <<
-			" lies outside the currently defined table: " << mNumRows <<
-			" by " << mNumColumns;
+		msg << "CKTable::getValue(int, int) - the provided location: " <<
+			aRow << ", " << aCol << " lies outside the currently defined table: " <<
+			mNumRows << " by " << mNumColumns;
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 	// ...and that we have a table structure that matches
-	if (mTable == NULL) {
+	if (!hasStorage()) {
 		std::ostringstream	msg;
-		msg << "CKTable::getRow(int) - there is no currently defined table "
-			"structure in this class. This is a serious data integrity problem "
-			"that needs to be looked into.";
+		msg << "CKTable::getValue(int, int) - there is no currently "
+			"defined table structure in this class. This is a serious data "
+			"integrity problem that needs to be looked into.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
-	// make the return value first on the stack as it's easiest
-	CKVector<CKVariant>		retval;
+	// now get what they want - a dense column has to become variants for this
+	return variantCell(aRow, aCol);
+}
 
-	// now pick put the data and copy it to the returned vector
-	for (int i = 0; i < mNumColumns; ++i) {
-		retval.addToEnd( (CKVariant)mTable[aRow * mNumColumns + i] );
+
+CKVariant & CKTable::getValue( int aRow, const CKString & aColHeader ) const
+{
+	// convert the column header to a column index
+	int		col = getColumnForHeader(aColHeader);
+	if (col < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getValue(int, const CKString &) "
+			"- there is no currently defined column header '" << aColHeader <<
+			"' please make sure the column headers are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
-	return retval;
+	// then call the index-based method
+	return getValue(aRow, col);
 }
 
 
-/*
- * This method returns a complete vector of the CKVariants that
- * make up the supplied row label in the table. This is nice if you
- * want to take a 'slice' in the table and just return a vector
- * of data for processing. The management of the returned value
- * is up to the caller.
- */
-CKVector<CKVariant> CKTable::getRow( const CKString & aRowLabel ) const
+CKVariant & CKTable::getValue( const CKString & aRowLabel, int aCol ) const
 {
 	// convert the row label to a row index
 	int		row = getRowForLabel(aRowLabel);
 	if (row < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getRow(const CKString &) - there is no currently "
-			"defined row label '" << aRowLabel << "' please make sure the row "
-			"labels are properly defined.";
+		msg << "CKTable::getValue(const CKString &, const CKString &) "
+			"- there is no currently defined row label '" << aRowLabel <<
+			"' please make sure the row labels are properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
 	// then call the index-based method
-	return getRow(row);
+	return getValue(row, aCol);
+}
+
+
+CKVariant & CKTable::getValue( const CKString & aRowLabel, const CKString & aColHeader ) const
+{
+	// convert the row label to a row index
+	int		row = getRowForLabel(aRowLabel);
+	if (row < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getValue(const CKString &, const CKString &) "
+			"- there is no currently defined row label '" << aRowLabel <<
+			"' please make sure the row labels are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// convert the column header to a column index
+	int		col = getColumnForHeader(aColHeader);
+	if (col < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getValue(const CKString &, const CKString &) "
+			"- there is no currently defined column header '" << aColHeader <<
+			"' please make sure the column headers are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// then call the index-based method
+	return getValue(row, col);
 }
 
 
 /*
- * This method returns a complete vector of the CKVariants that
- * make up the supplied column in the table. This is nice if you
- * want to take a 'slice' in the table and just return a vector
- * of data for processing. The management of the returned value
- * is up to the caller.
+ * This method returns the enumerated type of the data that this
+ * location is currently holding.
  */
-CKVector<CKVariant> CKTable::getColumn( int aCol ) const
+CKVariantType CKTable::getType( int aRow, int aCol ) const
 {
-	// first, make sure we have data to grab
-	if ((aCol < 0) || (aCol >= mNumColumns)) {
+	// first, make sure we have a place to put this data
+	if ((aRow < 0) || (aRow >= mNumRows) ||
+		(aCol < 0) || (aCol >= mNumColumns)) {
 		std::ostringstream	msg;
-		msg << "CKTable::getColumn(int) - the provided column: " << aCol <<
-			" lies outside the currently defined table: " << mNumRows <<
-			" by " << mNumColumns;
+		msg << "CKTable::getType(int, int) - the provided location: " <<
+			aRow << ", " << aCol << " lies outside the currently defined table: " <<
+			mNumRows << " by " << mNumColumns;
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 	// ...and that we have a table structure that matches
-	if (mTable == NULL) {
+	if (!hasStorage()) {
 		std::ostringstream	msg;
-		msg << "CKTable::getColumn(int) - there is no currently defined table "
-			"structure in this class. This is a serious data integrity problem "
-			"that needs to be looked into.";
+		msg << "CKTable::getType(int, int) - there is no currently "
+			"defined table structure in this class. This is a serious data "
+			"integrity problem that needs to be looked into.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
-	// make the return value first on the stack as it's easiest
-	CKVector<CKVariant>		retval;
+	// now get what they are looking for - an empty dense cell is unknown
+	if (mColumns != NULL) {
+		const CKTableColumn	& column = mColumns[aCol];
+		if (column.type == eUnknownVariant) {
+			return column.variants[aRow].getType();
+		}
+		return (isRowValid(column.valid, aRow) ? column.type : eUnknownVariant);
+	}
+	return mTable[aRow * mNumColumns + aCol].getType();
+}
 
-	// now pick put the data and copy it to the returned vector
-	for (int i = 0; i < mNumRows; ++i) {
-		retval.addToEnd( (CKVariant)mTable[i * mNumColumns + aCol] );
+
+CKVariantType CKTable::getType( int aRow, const CKString & aColHeader ) const
+{
+	// convert the column header to a column index
+	int		col = getColumnForHeader(aColHeader);
+	if (col < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getType(int, const CKString &) "
+			"- there is no currently defined column header '" << aColHeader <<
+			"' please make sure the column headers are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
-	return retval;
+	// then call the index-based method
+	return getType(aRow, col);
 }
 
 
-/*
- * This method returns a complete vector of the CKVariants that
- * make up the supplied column headerin the table. This is nice
- * if you want to take a 'slice' in the table and just return a
- * vector of data for processing. The management of the returned
- * value is up to the caller.
- */
-CKVector<CKVariant> CKTable::getColumn( const CKString & aColumnHeader ) const
+CKVariantType CKTable::getType( const CKString & aRowLabel, int aCol ) const
+{
+	// convert the row label to a row index
+	int		row = getRowForLabel(aRowLabel);
+	if (row < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getType(const CKString &, int) "
+			"- there is no currently defined row label '" << aRowLabel <<
+			"' please make sure the row labels are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// then call the index-based method
+	return getType(row, aCol);
+}
+
+
+CKVariantType CKTable::getType( const CKString & aRowLabel, const CKString & aColHeader ) const
 {
+	// convert the row label to a row index
+	int		row = getRowForLabel(aRowLabel);
+	if (row < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getType(const CKString &, const CKString &) "
+			"- there is no currently defined row label '" << aRowLabel <<
+			"' please make sure the row labels are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
 	// convert the column header to a column index
-	int		col = getColumnForHeader(aColumnHeader);
+	int		col = getColumnForHeader(aColHeader);
 	if (col < 0) {
 		std::ostringstream	msg;
-		msg << "CKTable::getCol(const CKString &) - there is no currently "
-			"defined column header '" << aColumnHeader << "' please make sure "
-			"the row labels are properly defined.";
+		msg << "CKTable::getType(const CKString &, const CKString &) "
+			"- there is no currently defined column header '" << aColHeader <<
+			"' please make sure the column headers are properly defined.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
 	// then call the index-based method
-	return getColumn(col);
+	return getType(row, col);
 }
 
 
-/********************************************************
- *
- *            Table Manipulation Methods
- *
- ********************************************************/
 /*
- * This method allows the user to merge two tables into one larger
- * table by adding the rows and columns from the argument to the
- * main instance itself. This is very useful when you have several
- * tables that need to be combined into one table that share
- * either a common set of column headers and/or a common set of
- * row labels.
+ * This method will return the integer value of the data stored in this
+ * location - if the type is numeric. If the data isn't numeric an
+ * exception will be thrown as it's assumed that the user should make
+ * sure that this instance is numeric *before* calling this method.
  */
-bool CKTable::merge( const CKTable & aTable )
+int CKTable::getIntValue( int aRow, int aCol ) const
 {
-	bool		error = false;
-
-	/*
-	 * We need to save the old size of the table as well as have
-	 * a baseline for the new table. To do this, we make two copies
-	 * of the dimensions - one will remain the same, the other will
-	 * be increased for new rows and/or columns from the argument.
-	 */
-	int			oldRows = mNumRows;
-	int			oldCols = mNumColumns;
-	int			endingRows = mNumRows;
-	int			endingCols = mNumColumns;
-
-	/*
-	 * The first thing to do is to calculate what the new size of
-	 * the resulting table needs to be. We do this by seeing how
-	 * name of the row labels on aTable are empty, or not in the
-	 * row labels for this table. We then do the same for the
-	 * column headers.
-	 */
-	// do the new columns first...
-	CKStringList	newColumnHeaders;
-	if (!error) {
-		int		cnt = aTable.mNumColumns;
-		for (int i = 0; i < cnt; i++) {
-			CKString		label = aTable.mColumnHeaders[i];
-			if (label == "") {
-				endingCols++;
-			} else if (getColumnForHeader(label) == -1) {
-				endingCols++;
-				newColumnHeaders.addToEnd(label);
-			}
-		}
+	// first, make sure we have a place to put this data
+	if ((aRow < 0) || (aRow >= mNumRows) ||
+		(aCol < 0) || (aCol >= mNumColumns)) {
+		std::ostringstream	msg;
+		msg << "CKTable::getIntValue(int, int) - the provided "
+			"location: " << aRow << ", " << aCol << " lies outside the currently "
+			"defined table: " << mNumRows << " by " << mNumColumns;
+		throw CKException(__FILE__, __LINE__, msg.str());
 	}
-	// now do the new rows...
-	CKStringList	newRowLabels;
-	if (!error) {
-		int		cnt = aTable.mNumRows;
-		for (int i = 0; i < cnt; i++) {
-			CKString		label = aTable.mRowLabels[i];
-			if (label == "") {
-				endingRows++;
-			} else if (getRowForLabel(label) == -1) {
-				endingRows++;
-				newRowLabels.addToEnd(label);
-			}
-		}
+	// ...and that we have a table structure that matches
+	if (!hasStorage()) {
+		std::ostringstream	msg;
+		msg << "CKTable::getIntValue(int, int) - there is no currently "
+			"defined table structure in this class. This is a serious data "
+			"integrity problem that needs to be looked into.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+	// don't forget to make sure the type matches
+	if (getType(aRow, aCol) != eNumberVariant) {
+		std::ostringstream	msg;
+		CKVariant			scratch;
+		msg << "CKTable::getIntValue(int, int) - the provided "
+			"location: " << aRow << ", " << aCol << " does not contain a numeric "
+			"value: " << readCell(aRow, aCol, scratch);
+		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
-	// now we need to resize the table to be the right overall size
-	if (!error) {
-		resizeTable(endingRows, endingCols);
-		if ((mNumRows != endingRows) || (mNumColumns != endingCols)) {
-			error = true;
-			std::ostringstream	msg;
-			msg << "CKTable::mergeInTable(const CKTable &) - the end result should "
-				"have been a table " << endingRows << "x" << endingCols << " in size "
-				"yet the final size is not this. That suggests an allocation error "
-				"that needs to be looked into.";
-			throw CKException(__FILE__, __LINE__, msg.str());
-		}
+	// now get what they are looking for
+	if ((mColumns != NULL) && (mColumns[aCol].type == eNumberVariant)) {
+		return (int)mColumns[aCol].doubles[aRow];
 	}
+	return variantCell(aRow, aCol).getIntValue();
+}
 
-	// now we can put in the new column headers and row labels
-	if (!error) {
-		// do the column headers first
-		for (int i = 0; i < newColumnHeaders.size(); i++) {
-			CKString	& header = newColumnHeaders[i];
-			mColumnHeaders[oldCols + i] = header;
-			mColumnHeadersIndex[header] = oldCols + i;
-		}
-		// now do the row labels next
-		for (int i = 0; i < newRowLabels.size(); i++) {
-			CKString	& label = newRowLabels[i];
-			mRowLabels[oldRows + i] = label;
-			mRowLabelsIndex[label] = oldRows + i;
-		}
+
+int CKTable::getIntValue( int aRow, const CKString & aColHeader ) const
+{
+	// convert the column header to a column index
+	int		col = getColumnForHeader(aColHeader);
+	if (col < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getIntValue(int, const CKString &) "
+			"- there is no currently defined column header '" << aColHeader <<
+			"' please make sure the column headers are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
-	/*
+	// then call the index-based method
+	return getIntValue(aRow, col);
+}
+
+
+int CKTable::getIntValue( const CKString & aRowLabel, int aCol ) const
+{
+	// convert the row label to a row index
+	int		row = getRowForLabel(aRowLabel);
+	if (row < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getIntValue(const CKString &, const CKString &) "
+			"- there is no currently defined row label '" << aRowLabel <<
+			"' please make sure the row labels are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// then call the index-based method
+	return getIntValue(row, aCol);
+}
+
+
+int CKTable::getIntValue( const CKString & aRowLabel, const CKString & aColHeader ) const
+{
+	// convert the row label to a row index
+	int		row = getRowForLabel(aRowLabel);
+	if (row < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getIntValue(const CKString &, const CKString &) "
+			"- there is no currently defined row label '" << aRowLabel <<
+			"' please make sure the row labels are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// convert the column header to a column index
+	int		col = getColumnForHeader(aColHeader);
+	if (col < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getIntValue(const CKString &, const CKString &) "
+			"- there is no currently defined column header '" << aColHeader <<
+			"' please make sure the column headers are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// then call the index-based method
+	return getIntValue(row, col);
+}
+
+
+/*
+ * This method will return the double value of the data stored in this
+ * location - if the type is numeric. If the data isn't numeric an
+ * exception will be thrown as it's assumed that the user should make
+ * sure that this instance is numeric *before* calling this method.
+ */
+double CKTable::getDoubleValue( int aRow, int aCol ) const
+{
+	// first, make sure we have a place to put this data
+	if ((aRow < 0) || (aRow >= mNumRows) ||
+		(aCol < 0) || (aCol >= mNumColumns)) {
+		std::ostringstream	msg;
+		msg << "CKTable::getDoubleValue(int, int) - the provided "
+			"location: " << aRow << ", " << aCol << " lies outside the currently "
+			"defined table: " << mNumRows << " by " << mNumColumns;
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+	// ...and that we have a table structure that matches
+	if (!hasStorage()) {
+		std::ostringstream	msg;
+		msg << "CKTable::getDoubleValue(int, int) - there is no currently "
+			"defined table structure in this class. This is a serious data "
+			"integrity problem that needs to be looked into.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+	// don't forget to make sure the type matches
+	if (getType(aRow, aCol) != eNumberVariant) {
+		std::ostringstream	msg;
+		CKVariant			scratch;
+		msg << "CKTable::getDoubleValue(int, int) - the provided "
+			"location: " << aRow << ", " << aCol << " does not contain a numeric "
+			"value: " << readCell(aRow, aCol, scratch);
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// now get what they are looking for
+	if ((mColumns != NULL) && (mColumns[aCol].type == eNumberVariant)) {
+		return mColumns[aCol].doubles[aRow];
+	}
+	return variantCell(aRow, aCol).getDoubleValue();
+}
+
+
+double CKTable::getDoubleValue( int aRow, const CKString & aColHeader ) const
+{
+	// convert the column header to a column index
+	int		col = getColumnForHeader(aColHeader);
+	if (col < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getDoubleValue(int, const CKString &) "
+			"- there is no currently defined column header '" << aColHeader <<
+			"' please make sure the column headers are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// then call the index-based method
+	return getDoubleValue(aRow, col);
+}
+
+
+double CKTable::getDoubleValue( const CKString & aRowLabel, int aCol ) const
+{
+	// convert the row label to a row index
+	int		row = getRowForLabel(aRowLabel);
+	if (row < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getDoubleValue(const CKString &, int) "
+			"- there is no currently defined row label '" << aRowLabel <<
+			"' please make sure the row labels are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// then call the index-based method
+	return getDoubleValue(row, aCol);
+}
+
+
+double CKTable::getDoubleValue( const CKString & aRowLabel, const CKString & aColHeader ) const
+{
+	// convert the row label to a row index
+	int		row = getRowForLabel(aRowLabel);
+	if (row < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getDoubleValue(const CKString &, const CKString &) "
+			"- there is no currently defined row label '" << aRowLabel <<
+			"' please make sure the row labels are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// convert the column header to a column index
+	int		col = getColumnForHeader(aColHeader);
+	if (col < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getDoubleValue(const CKString &, const CKString &) "
+			"- there is no currently defined column header '" << aColHeader <<
+			"' please make sure the column headers are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// then call the index-based method
+	return getDoubleValue(row, col);
+}
+
+
+/*
+ * This method will return the date value of the data stored in this
+ * location in a long of the form YYYYMMDD - if the type is date. If
+ * the data isn't date an exception will be thrown as it's assumed
+ * that the user should make sure that this instance is date *before*
+ * calling this method.
+ */
+long CKTable::getDateValue( int aRow, int aCol ) const
+{
+	// first, make sure we have a place to put this data
+	if ((aRow < 0) || (aRow >= mNumRows) ||
+		(aCol < 0) || (aCol >= mNumColumns)) {
+		std::ostringstream	msg;
+		msg << "CKTable::getDateValue(int, int) - the provided "
+			"location: " << aRow << ", " << aCol << " lies outside the currently "
+			"defined table: " << mNumRows << " by " << mNumColumns;
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+	// ...and that we have a table structure that matches
+	if (!hasStorage()) {
+		std::ostringstream	msg;
+		msg << "CKTable::getDateValue(int, int) - there is no currently "
+			"defined table structure in this class. This is a serious data "
+			"integrity problem that needs to be looked into.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+	// don't forget to make sure the type matches
+	if (getType(aRow, aCol) != eDateVariant) {
+		std::ostringstream	msg;
+		CKVariant			scratch;
+		msg << "CKTable::getDateValue(int, int) - the provided "
+			"location: " << aRow << ", " << aCol << " does not contain a date "
+			"value: " << readCell(aRow, aCol, scratch);
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// now get what they are looking for
+	if ((mColumns != NULL) && (mColumns[aCol].type == eDateVariant)) {
+		return mColumns[aCol].dates[aRow];
+	}
+	return variantCell(aRow, aCol).getDateValue();
+}
+
+
+long CKTable::getDateValue( int aRow, const CKString & aColHeader ) const
+{
+	// convert the column header to a column index
+	int		col = getColumnForHeader(aColHeader);
+	if (col < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getDateValue(int, const CKString &) "
+			"- there is no currently defined column header '" << aColHeader <<
+			"' please make sure the column headers are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// then call the index-based method
+	return getDateValue(aRow, col);
+}
+
+
+long CKTable::getDateValue( const CKString & aRowLabel, int aCol ) const
+{
+	// convert the row label to a row index
+	int		row = getRowForLabel(aRowLabel);
+	if (row < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getDateValue(const CKString &, int) "
+			"- there is no currently defined row label '" << aRowLabel <<
+			"' please make sure the row labels are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// then call the index-based method
+	return getDateValue(row, aCol);
+}
+
+
+long CKTable::getDateValue( const CKString & aRowLabel, const CKString & aColHeader ) const
+{
+	// convert the row label to a row index
+	int		row = getRowForLabel(aRowLabel);
+	if (row < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getDateValue(const CKString &, const CKString &) "
+			"- there is no currently defined row label '" << aRowLabel <<
+			"' please make sure the row labels are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// convert the column header to a column index
+	int		col = getColumnForHeader(aColHeader);
+	if (col < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getDateValue(const CKString &, const CKString &) "
+			"- there is no currently defined column header '" << aColHeader <<
+			"' please make sure the column headers are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// then call the index-based method
+	return getDateValue(row, col);
+}
+
+
+/*
+ * This method returns the actual string value of the data that
+ * this location is holding. If the user wants to use this value
+ * outside the scope of this class, then they need to make a copy,
+ * or call the getValueAsString() method that returns a copy.
+ */
+const CKString *CKTable::getStringValue( int aRow, int aCol ) const
+{
+	// first, make sure we have a place to put this data
+	if ((aRow < 0) || (aRow >= mNumRows) ||
+		(aCol < 0) || (aCol >= mNumColumns)) {
+		std::ostringstream	msg;
+		msg << "CKTable::getStringValue(int, int) - the provided "
+			"location: " << aRow << ", " << aCol << " lies outside the currently "
+			"defined table: " << mNumRows << " by " << mNumColumns;
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+	// ...and that we have a table structure that matches
+	if (!hasStorage()) {
+		std::ostringstream	msg;
+		msg << "CKTable::getStringValue(int, int) - there is no currently "
+			"defined table structure in this class. This is a serious data "
+			"integrity problem that needs to be looked into.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+	// don't forget to make sure the type matches
+	if (getType(aRow, aCol) != eStringVariant) {
+		std::ostringstream	msg;
+		CKVariant			scratch;
+		msg << "CKTable::getStringValue(int, int) - the provided "
+			"location: " << aRow << ", " << aCol << " does not contain a string "
+			"value: " << readCell(aRow, aCol, scratch);
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// now get what they are looking for
+	return variantCell(aRow, aCol).getStringValue();
+}
+
+
+const CKString *CKTable::getStringValue( int aRow, const CKString & aColHeader ) const
+{
+	// convert the column header to a column index
+	int		col = getColumnForHeader(aColHeader);
+	if (col < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getStringValue(int, const CKString &) "
+			"- there is no currently defined column header '" << aColHeader <<
+			"' please make sure the column headers are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// then call the index-based method
+	return getStringValue(aRow, col);
+}
+
+
+const CKString *CKTable::getStringValue( const CKString & aRowLabel, int aCol ) const
+{
+	// convert the row label to a row index
+	int		row = getRowForLabel(aRowLabel);
+	if (row < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getStringValue(const CKString &, int) "
+			"- there is no currently defined row label '" << aRowLabel <<
+			"' please make sure the row labels are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// then call the index-based method
+	return getStringValue(row, aCol);
+}
+
+
+const CKString *CKTable::getStringValue( const CKString & aRowLabel, const CKString & aColHeader ) const
+{
+	// convert the row label to a row index
+	int		row = getRowForLabel(aRowLabel);
+	if (row < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getStringValue(const CKString &, const CKString &) "
+			"- there is no currently defined row label '" << aRowLabel <<
+			"' please make sure the row labels are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// convert the column header to a column index
+	int		col = getColumnForHeader(aColHeader);
+	if (col < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getStringValue(const CKString &, const CKString &) "
+			"- there is no currently defined column header '" << aColHeader <<
+			"' please make sure the column headers are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// then call the index-based method
+	return getStringValue(row, col);
+}
+
+
+/*
+ * This method returns the actual table value of the data that
+ * this location is holding. If the user wants to use this value
+ * outside the scope of this class, then they need to make a copy.
+ */
+const CKTable *CKTable::getTableValue( int aRow, int aCol ) const
+{
+	// first, make sure we have a place to put this data
+	if ((aRow < 0) || (aRow >= mNumRows) ||
+		(aCol < 0) || (aCol >= mNumColumns)) {
+		std::ostringstream	msg;
+		msg << "CKTable::getTableValue(int, int) - the provided "
+			"location: " << aRow << ", " << aCol << " lies outside the currently "
+			"defined table: " << mNumRows << " by " << mNumColumns;
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+	// ...and that we have a table structure that matches
+	if (!hasStorage()) {
+		std::ostringstream	msg;
+		msg << "CKTable::getTableValue(int, int) - there is no currently "
+			"defined table structure in this class. This is a serious data "
+			"integrity problem that needs to be looked into.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+	// don't forget to make sure the type matches
+	if (getType(aRow, aCol) != eTableVariant) {
+		std::ostringstream	msg;
+		CKVariant			scratch;
+		msg << "CKTable::getTableValue(int, int) - the provided "
+			"location: " << aRow << ", " << aCol << " does not contain a table "
+			"value: " << readCell(aRow, aCol, scratch);
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// now get what they are looking for
+	return variantCell(aRow, aCol).getTableValue();
+}
+
+
+const CKTable *CKTable::getTableValue( int aRow, const CKString & aColHeader ) const
+{
+	// convert the column header to a column index
+	int		col = getColumnForHeader(aColHeader);
+	if (col < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getTableValue(int, const CKString &) "
+			"- there is no currently defined column header '" << aColHeader <<
+			"' please make sure the column headers are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// then call the index-based method
+	return getTableValue(aRow, col);
+}
+
+
+const CKTable *CKTable::getTableValue( const CKString & aRowLabel, int aCol ) const
+{
+	// convert the row label to a row index
+	int		row = getRowForLabel(aRowLabel);
+	if (row < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getTableValue(const CKString &, int) "
+			"- there is no currently defined row label '" << aRowLabel <<
+			"' please make sure the row labels are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// then call the index-based method
+	return getTableValue(row, aCol);
+}
+
+
+const CKTable *CKTable::getTableValue( const CKString & aRowLabel, const CKString & aColHeader ) const
+{
+	// convert the row label to a row index
+	int		row = getRowForLabel(aRowLabel);
+	if (row < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getTableValue(const CKString &, const CKString &) "
+			"- there is no currently defined row label '" << aRowLabel <<
+			"' please make sure the row labels are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// convert the column header to a column index
+	int		col = getColumnForHeader(aColHeader);
+	if (col < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getTableValue(const CKString &, const CKString &) "
+			"- there is no currently defined column header '" << aColHeader <<
+			"' please make sure the column headers are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// then call the index-based method
+	return getTableValue(row, col);
+}
+
+
+/*
+ * This method returns the actual time series value of the data that
+ * this location is holding. If the user wants to use this value
+ * outside the scope of this class, then they need to make a copy.
+ */
+const CKTimeSeries *CKTable::getTimeSeriesValue( int aRow, int aCol ) const
+{
+	// first, make sure we have a place to put this data
+	if ((aRow < 0) || (aRow >= mNumRows) ||
+		(aCol < 0) || (aCol >= mNumColumns)) {
+		std::ostringstream	msg;
+		msg << "CKTable::getTimeSeriesValue(int, int) - the provided "
+			"location: " << aRow << ", " << aCol << " lies outside the currently "
+			"defined table: " << mNumRows << " by " << mNumColumns;
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+	// ...and that we have a table structure that matches
+	if (!hasStorage()) {
+		std::ostringstream	msg;
+		msg << "CKTable::getTimeSeriesValue(int, int) - there is no currently "
+			"defined table structure in this class. This is a serious data "
+			"integrity problem that needs to be looked into.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+	// don't forget to make sure the type matches
+	if (getType(aRow, aCol) != eTimeSeriesVariant) {
+		std::ostringstream	msg;
+		msg << "CKTable::getTimeSeriesValue(int, int) - the provided "
+			"location: " << aRow << ", " << aCol << " does not contain a time "
+			"series value: " << getValue(aRow, aCol);
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// now get what they are looking for
+	return variantCell(aRow, aCol).getTimeSeriesValue();
+}
+
+
+const CKTimeSeries *CKTable::getTimeSeriesValue( int aRow, const CKString & aColHeader ) const
+{
+	// convert the column header to a column index
+	int		col = getColumnForHeader(aColHeader);
+	if (col < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getTimeSeriesValue(const CKString &, const CKString &) "
+			"- there is no currently defined column header '" << aColHeader <<
+			"' please make sure the column headers are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// then call the index-based method
+	return getTimeSeriesValue(aRow, col);
+}
+
+
+const CKTimeSeries *CKTable::getTimeSeriesValue( const CKString & aRowLabel, int aCol ) const
+{
+	// convert the row label to a row index
+	int		row = getRowForLabel(aRowLabel);
+	if (row < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getTimeSeriesValue(const CKString &, const CKString &) "
+			"- there is no currently defined row label '" << aRowLabel <<
+			"' please make sure the row labels are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// then call the index-based method
+	return getTimeSeriesValue(row, aCol);
+}
+
+
+const CKTimeSeries *CKTable::getTimeSeriesValue( const CKString & aRowLabel, const CKString & aColHeader ) const
+{
+	// convert the row label to a row index
+	int		row = getRowForLabel(aRowLabel);
+	if (row < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getTimeSeriesValue(const CKString &, const CKString &) "
+			"- there is no currently defined row label '" << aRowLabel <<
+			"' please make sure the row labels are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// convert the column header to a column index
+	int		col = getColumnForHeader(aColHeader);
+	if (col < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getTimeSeriesValue(const CKString &, const CKString &) "
+			"- there is no currently defined column header '" << aColHeader <<
+			"' please make sure the column headers are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// then call the index-based method
+	return getTimeSeriesValue(row, col);
+}
+
+
+/*
+ * This method returns the actual price value of the data that
+ * this location is holding. If the user wants to use this value
+ * outside the scope of this class, then they need to make a copy.
+ */
+const CKPrice *CKTable::getPriceValue( int aRow, int aCol ) const
+{
+	// first, make sure we have a place to put this data
+	if ((aRow < 0) || (aRow >= mNumRows) ||
+		(aCol < 0) || (aCol >= mNumColumns)) {
+		std::ostringstream	msg;
+		msg << "CKTable::getPriceValue(int, int) - the provided "
+			"location: " << aRow << ", " << aCol << " lies outside the currently "
+			"defined table: " << mNumRows << " by " << mNumColumns;
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+	// ...and that we have a table structure that matches
+	if (!hasStorage()) {
+		std::ostringstream	msg;
+		msg << "CKTable::getPriceValue(int, int) - there is no currently "
+			"defined table structure in this class. This is a serious data "
+			"integrity problem that needs to be looked into.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+	// don't forget to make sure the type matches
+	if (getType(aRow, aCol) != ePriceVariant) {
+		std::ostringstream	msg;
+		msg << "CKTable::getPriceValue(int, int) - the provided "
+			"location: " << aRow << ", " << aCol << " does not contain a "
+			"price value: " << getValue(aRow, aCol);
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// now get what they are looking for
+	return variantCell(aRow, aCol).getPriceValue();
+}
+
+
+const CKPrice *CKTable::getPriceValue( int aRow, const CKString & aColHeader ) const
+{
+	// convert the column header to a column index
+	int		col = getColumnForHeader(aColHeader);
+	if (col < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getPriceValue(const CKString &, const CKString &) "
+			"- there is no currently defined column header '" << aColHeader <<
+			"' please make sure the column headers are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// then call the index-based method
+	return getPriceValue(aRow, col);
+}
+
+
+const CKPrice *CKTable::getPriceValue( const CKString & aRowLabel, int aCol ) const
+{
+	// convert the row label to a row index
+	int		row = getRowForLabel(aRowLabel);
+	if (row < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getPriceValue(const CKString &, const CKString &) "
+			"- there is no currently defined row label '" << aRowLabel <<
+			"' please make sure the row labels are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// then call the index-based method
+	return getPriceValue(row, aCol);
+}
+
+
+const CKPrice *CKTable::getPriceValue( const CKString & aRowLabel, const CKString & aColHeader ) const
+{
+	// convert the row label to a row index
+	int		row = getRowForLabel(aRowLabel);
+	if (row < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getPriceValue(const CKString &, const CKString &) "
+			"- there is no currently defined row label '" << aRowLabel <<
+			"' please make sure the row labels are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// convert the column header to a column index
+	int		col = getColumnForHeader(aColHeader);
+	if (col < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getPriceValue(const CKString &, const CKString &) "
+			"- there is no currently defined column header '" << aColHeader <<
+			"' please make sure the column headers are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// then call the index-based method
+	return getPriceValue(row, col);
+}
+
+
+/*
+ * This method returns the actual CKString value that is the
+ * column header for the provided column number assuming that it
+ * actually exists in the table. As such, if the user wants this
+ * value outside the scope fo this class they need to make a copy
+ * of it.
+ */
+const CKString & CKTable::getColumnHeader( int aCol ) const
+{
+	// first, make sure we have a place to put this data
+	if ((aCol < 0) || (aCol >= mNumColumns)) {
+		std::ostringstream	msg;
+		msg << "CKTable::getColumnHeader(int) - the provided column "
+			"number: " << aCol << " lies outside the currently "
+			"defined table: " << mNumRows << " by " << mNumColumns;
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// now get what they are looking for
+	return mColumnHeaders[aCol];
+}
+
+
+/*
+ * This method returns the actual CKString value that is the
+ * row label for the provided row number assuming that it
+ * actually exists in the table. As such, if the user wants this
+ * value outside the scope fo this class they need to make a copy
+ * of it.
+ */
+const CKString & CKTable::getRowLabel( int aRow ) const
+{
+	// first, make sure we have a place to put this data
+	if ((aRow < 0) || (aRow >= mNumRows)) {
+		std::ostringstream	msg;
+		msg << "CKTable::getRowLabel(int) - the provided row "
+			"number: " << aRow << " lies outside the currently "
+			"defined table: " << mNumRows << " by " << mNumColumns;
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// now get what they are looking for
+	return mRowLabels[aRow];
+}
+
+
+/*
+ * This method will return the current number of rows in the table.
+ * If no table is defined at this time, this method will return a -1.
+ */
+int CKTable::getNumRows() const
+{
+	return mNumRows;
+}
+
+
+/*
+ * This method will return the current number of columns in the
+ * table. If no table is defined at this time, this method will
+ * return a -1.
+ */
+int CKTable::getNumColumns() const
+{
+	return mNumColumns;
+}
+
+
+/********************************************************
+ *
+ *                Table Methods
+ *
+ ********************************************************/
+/*
+ * This method returns the column index for the specified header.
+ * If this header is not a valid column header for this table, then
+ * this method will return a -1, please check for it.
+ */
+int CKTable::getColumnForHeader( const CKString & aHeader ) const
+{
+	return mColumnHeadersIndex.get(aHeader);
+}
+
+
+int CKTable::getColumnForHeader( const char *aHeader ) const
+{
+	if (aHeader == NULL) {
+		return -1;
+	}
+	return mColumnHeadersIndex.get(aHeader, strlen(aHeader));
+}
+
+
+/*
+ * This method returns the row index for the specified label.
+ * If this label is not a valid row label for this table, then
+ * this method will return a -1, please check for it.
+ */
+int CKTable::getRowForLabel( const CKString & aLabel ) const
+{
+	return mRowLabelsIndex.get(aLabel);
+}
+
+
+int CKTable::getRowForLabel( const char *aLabel ) const
+{
+	if (aLabel == NULL) {
+		return -1;
+	}
+	return mRowLabelsIndex.get(aLabel, strlen(aLabel));
+}
+
+
+/*
+ * These methods look up all the headers or labels in the list
+ * at once, and return the column or row indexes in the same
+ * order - with a -1 for each that's not in the table.
+ */
+CKVector<int> CKTable::getColumnsForHeaders( const CKStringList & aHeaders ) const
+{
+	CKVector<int>	retval(aHeaders.size());
+	for (CKStringNode *i = aHeaders.getHead(); i != NULL; i = i->getNext()) {
+		retval.addToEnd(mColumnHeadersIndex.get(*i));
+	}
+	return retval;
+}
+
+
+CKVector<int> CKTable::getRowsForLabels( const CKStringList & aLabels ) const
+{
+	CKVector<int>	retval(aLabels.size());
+	for (CKStringNode *i = aLabels.getHead(); i != NULL; i = i->getNext()) {
+		retval.addToEnd(mRowLabelsIndex.get(*i));
+	}
+	return retval;
+}
+
+
+/*
+ * This method returns a complete vector of the CKVariants that
+ * make up the supplied row in the table. This is nice if you
+ * want to take a 'slice' in the table and just return a vector
+ * of data for processing. The management of the returned value
+ * is up to the caller.
+ */
+CKVector<CKVariant> CKTable::getRow( int aRow ) const
+{
+	// first, make sure we have data to grab
+	if ((aRow < 0) || (aRow >= mNumRows)) {
+		std::ostringstream	msg;
+		msg << "CKTable::getRow(int) - the provided row: " << aRow <<
+			" lies outside the currently defined table: " << mNumRows <<
+			" by " << mNumColumns;
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+	// ...and that we have a table structure that matches
+	if (!hasStorage()) {
+		std::ostringstream	msg;
+		msg << "CKTable::getRow(int) - there is no currently defined table "
+			"structure in this class. This is a serious data integrity problem "
+			"that needs to be looked into.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// make the return value first on the stack as it's easiest
+	CKVector<CKVariant>		retval;
+	CKVariant				scratch;
+
+	// now pick put the data and copy it to the returned vector
+	for (int i = 0; i < mNumColumns; ++i) {
+		retval.addToEnd( readCell(aRow, i, scratch) );
+	}
+
+	return retval;
+}
+
+
+/*
+ * This method returns a complete vector of the CKVariants that
+ * make up the supplied row label in the table. This is nice if you
+ * want to take a 'slice' in the table and just return a vector
+ * of data for processing. The management of the returned value
+ * is up to the caller.
+ */
+CKVector<CKVariant> CKTable::getRow( const CKString & aRowLabel ) const
+{
+	// convert the row label to a row index
+	int		row = getRowForLabel(aRowLabel);
+	if (row < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getRow(const CKString &) - there is no currently "
+			"defined row label '" << aRowLabel << "' please make sure the row "
+			"labels are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// then call the index-based method
+	return getRow(row);
+}
+
+
+/*
+ * This method returns a complete vector of the CKVariants that
+ * make up the supplied column in the table. This is nice if you
+ * want to take a 'slice' in the table and just return a vector
+ * of data for processing. The management of the returned value
+ * is up to the caller.
+ */
+CKVector<CKVariant> CKTable::getColumn( int aCol ) const
+{
+	// first, make sure we have data to grab
+	if ((aCol < 0) || (aCol >= mNumColumns)) {
+		std::ostringstream	msg;
+		msg << "CKTable::getColumn(int) - the provided column: " << aCol <<
+			" lies outside the currently defined table: " << mNumRows <<
+			" by " << mNumColumns;
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+	// ...and that we have a table structure that matches
+	if (!hasStorage()) {
+		std::ostringstream	msg;
+		msg << "CKTable::getColumn(int) - there is no currently defined table "
+			"structure in this class. This is a serious data integrity problem "
+			"that needs to be looked into.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// make the return value first on the stack as it's easiest
+	CKVector<CKVariant>		retval;
+	CKVariant				scratch;
+
+	// now pick put the data and copy it to the returned vector
+	for (int i = 0; i < mNumRows; ++i) {
+		retval.addToEnd( readCell(i, aCol, scratch) );
+	}
+
+	return retval;
+}
+
+
+/*
+ * This method returns a complete vector of the CKVariants that
+ * make up the supplied column headerin the table. This is nice
+ * if you want to take a 'slice' in the table and just return a
+ * vector of data for processing. The management of the returned
+ * value is up to the caller.
+ */
+CKVector<CKVariant> CKTable::getColumn( const CKString & aColumnHeader ) const
+{
+	// convert the column header to a column index
+	int		col = getColumnForHeader(aColumnHeader);
+	if (col < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getCol(const CKString &) - there is no currently "
+			"defined column header '" << aColumnHeader << "' please make sure "
+			"the row labels are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// then call the index-based method
+	return getColumn(col);
+}
+
+
+/********************************************************
+ *
+ *                Columnar Layout Methods
+ *
+ ********************************************************/
+/*
+ * This method turns the columnar layout on or off. Turning it on
+ * makes a dense column out of every one that holds just numbers or
+ * just dates, and turning it off puts everything back into the
+ * row-major array of CKVariants.
+ */
+void CKTable::setColumnar( bool aFlag )
+{
+	// first, make sure we have a table to lay out
+	if (!hasStorage()) {
+		std::ostringstream	msg;
+		msg << "CKTable::setColumnar(bool) - there is no currently defined "
+			"table structure in this class, so there's nothing to lay out. "
+			"Please create the table before calling this method.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	if (aFlag && (mColumns == NULL)) {
+		/*
+		 * A column that has nothing but numbers - or nothing but dates -
+		 * in it becomes dense, and all the others are CKVariants that
+		 * are swapped out of the table so nothing is copied.
+		 */
+		CKTableColumn	*columns = new CKTableColumn[mColumnCapacity];
+		for (int j = 0; j < mNumColumns; ++j) {
+			CKVariantType	type = eUnknownVariant;
+			for (int i = 0; i < mNumRows; ++i) {
+				CKVariantType	cellType = mTable[i * mNumColumns + j].getType();
+				if (cellType == eUnknownVariant) {
+					continue;
+				}
+				if (((cellType != eNumberVariant) && (cellType != eDateVariant)) ||
+					((type != eUnknownVariant) && (type != cellType))) {
+					type = eUnknownVariant;
+					break;
+				}
+				type = cellType;
+			}
+
+			CKTableColumn	& column = columns[j];
+			allocColumn(column, type, mRowCapacity);
+			for (int i = 0; i < mNumRows; ++i) {
+				CKVariant	& cell = mTable[i * mNumColumns + j];
+				if (cell.getType() == eUnknownVariant) {
+					// the new cell is already empty
+				} else if (column.type == eUnknownVariant) {
+					column.variants[i].swap(cell);
+				} else if (cell.getType() == eNumberVariant) {
+					column.doubles[i] = cell.getDoubleValue();
+					markRow(column.valid, i, true);
+				} else if (cell.getType() == eDateVariant) {
+					column.dates[i] = cell.getDateValue();
+					markRow(column.valid, i, true);
+				}
+			}
+		}
+		delete [] mTable;
+		mTable = NULL;
+		mColumns = columns;
+	} else if (!aFlag && (mColumns != NULL)) {
+		// put every value back where it goes in the row-major array
+		CKVariant	*table = new CKVariant[mRowCapacity * mNumColumns];
+		for (int j = 0; j < mNumColumns; ++j) {
+			CKTableColumn	& column = mColumns[j];
+			for (int i = 0; i < mNumRows; ++i) {
+				CKVariant	& cell = table[i * mNumColumns + j];
+				if (column.type == eUnknownVariant) {
+					if (column.variants[i].getType() != eUnknownVariant) {
+						cell.swap(column.variants[i]);
+					}
+				} else if (!isRowValid(column.valid, i)) {
+					continue;
+				} else if (column.type == eNumberVariant) {
+					cell.setDoubleValue(column.doubles[i]);
+				} else {
+					cell.setDateValue(column.dates[i]);
+				}
+			}
+		}
+		dropColumns();
+		mTable = table;
+	}
+}
+
+
+bool CKTable::isColumnar() const
+{
+	return (mColumns != NULL);
+}
+
+
+/*
+ * These methods declare the type of a column, making the table
+ * columnar if it isn't already. eNumberVariant and eDateVariant
+ * make the column dense, and eUnknownVariant makes it CKVariants.
+ * If there's a value in the column that can't be held in a dense
+ * column of that type, a CKException is thrown and the column is
+ * left as it was.
+ */
+void CKTable::setColumnType( int aCol, CKVariantType aType )
+{
+	// first, make sure we have a column to work with
+	if ((aCol < 0) || (aCol >= mNumColumns)) {
+		std::ostringstream	msg;
+		msg << "CKTable::setColumnType(int, CKVariantType) - the provided "
+			"column: " << aCol << " lies outside the currently defined table: " <<
+			mNumRows << " by " << mNumColumns;
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+	// ...and that it's something that can be dense
+	if ((aType != eNumberVariant) && (aType != eDateVariant) &&
+		(aType != eUnknownVariant)) {
+		std::ostringstream	msg;
+		msg << "CKTable::setColumnType(int, CKVariantType) - the type " <<
+			aType << " can't be held in a dense column. Only numbers and dates "
+			"can, and eUnknownVariant makes a column of CKVariants.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// this only makes sense for a columnar table
+	if (mColumns == NULL) {
+		setColumnar(true);
+	}
+
+	CKTableColumn	& column = mColumns[aCol];
+	if (column.type == aType) {
+		// it's already what they want
+	} else if (aType == eUnknownVariant) {
+		makeVariantColumn(column, mRowCapacity);
+	} else {
+		// make sure every value fits before anything is changed
+		for (int i = 0; i < mNumRows; ++i) {
+			CKVariantType	cellType = getType(i, aCol);
+			if ((cellType != eUnknownVariant) && (cellType != aType)) {
+				std::ostringstream	msg;
+				CKVariant			scratch;
+				msg << "CKTable::setColumnType(int, CKVariantType) - the value "
+					"at row " << i << " of column " << aCol << " is: " <<
+					readCell(i, aCol, scratch) << " and that can't be held in a "
+					"dense column of type " << aType << ". The column has been "
+					"left as it was.";
+				throw CKException(__FILE__, __LINE__, msg.str());
+			}
+		}
+		// now go through CKVariants to the new type
+		makeVariantColumn(column, mRowCapacity);
+		CKTableColumn	dense;
+		allocColumn(dense, aType, mRowCapacity);
+		for (int i = 0; i < mNumRows; ++i) {
+			CKVariant	& cell = column.variants[i];
+			if (cell.getType() == eNumberVariant) {
+				dense.doubles[i] = cell.getDoubleValue();
+				markRow(dense.valid, i, true);
+			} else if (cell.getType() == eDateVariant) {
+				dense.dates[i] = cell.getDateValue();
+				markRow(dense.valid, i, true);
+			}
+		}
+		freeColumn(column);
+		column = dense;
+	}
+}
+
+
+void CKTable::setColumnType( const CKString & aColHeader, CKVariantType aType )
+{
+	// convert the column header to a column index
+	int		col = getColumnForHeader(aColHeader);
+	if (col < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::setColumnType(const CKString &, CKVariantType) - "
+			"there is no currently defined column header '" << aColHeader <<
+			"' please make sure the column headers are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// then call the index-based method
+	setColumnType(col, aType);
+}
+
+
+/*
+ * This method returns the declared type of the column - either
+ * eNumberVariant or eDateVariant for a dense column, or else
+ * eUnknownVariant for one of CKVariants or a row-major table.
+ */
+CKVariantType CKTable::getColumnType( int aCol ) const
+{
+	// first, make sure we have a column to look at
+	if ((aCol < 0) || (aCol >= mNumColumns)) {
+		std::ostringstream	msg;
+		msg << "CKTable::getColumnType(int) - the provided column: " << aCol <<
+			" lies outside the currently defined table: " << mNumRows <<
+			" by " << mNumColumns;
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	return (mColumns == NULL ? eUnknownVariant : mColumns[aCol].type);
+}
+
+
+CKVariantType CKTable::getColumnType( const CKString & aColHeader ) const
+{
+	// convert the column header to a column index
+	int		col = getColumnForHeader(aColHeader);
+	if (col < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getColumnType(const CKString &) - there is no "
+			"currently defined column header '" << aColHeader << "' please "
+			"make sure the column headers are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// then call the index-based method
+	return getColumnType(col);
+}
+
+
+/*
+ * These methods return the actual dense array of a column so that
+ * it can be scanned without going through the accessors - there
+ * are getNumRows() values in it. If the column isn't a dense one of
+ * that type, they return NULL. The values of the rows that are
+ * empty are meaningless, so getColumnValidity() returns the bitmap
+ * that says which ones aren't - row i has a value if bit (i % 8)
+ * of byte (i / 8) is set. Like getValue(), these are the actual
+ * data and can change if the table does.
+ */
+const double *CKTable::getDoubleColumn( int aCol ) const
+{
+	if ((mColumns == NULL) || (aCol < 0) || (aCol >= mNumColumns)) {
+		return NULL;
+	}
+	return (mColumns[aCol].type == eNumberVariant ? mColumns[aCol].doubles : NULL);
+}
+
+
+const long *CKTable::getDateColumn( int aCol ) const
+{
+	if ((mColumns == NULL) || (aCol < 0) || (aCol >= mNumColumns)) {
+		return NULL;
+	}
+	return (mColumns[aCol].type == eDateVariant ? mColumns[aCol].dates : NULL);
+}
+
+
+const unsigned char *CKTable::getColumnValidity( int aCol ) const
+{
+	if ((mColumns == NULL) || (aCol < 0) || (aCol >= mNumColumns)) {
+		return NULL;
+	}
+	return (mColumns[aCol].type != eUnknownVariant ? mColumns[aCol].valid : NULL);
+}
+
+
+/********************************************************
+ *
+ *                Parallel Execution Methods
+ *
+ ********************************************************/
+/*
+ * These set and get the pool of threads that the big table operations
+ * are split up on. If none has been set, it's the library's default one.
+ */
+void CKTable::setParallelExecutor( CKExecutor *anExecutor )
+{
+	sParallelExecutor = anExecutor;
+}
+
+
+CKExecutor *CKTable::getParallelExecutor()
+{
+	CKExecutor	*pool = sParallelExecutor;
+	return (pool == NULL ? CKExecutor::getDefault() : pool);
+}
+
+
+/*
+ * These set and get the number of cells a table has to have before
+ * its operations are split up. Zero or less means never.
+ */
+void CKTable::setParallelThreshold( int aCellCount )
+{
+	sParallelThreshold = aCellCount;
+}
+
+
+int CKTable::getParallelThreshold()
+{
+	return sParallelThreshold;
+}
+
+
+/********************************************************
+ *
+ *            Table Manipulation Methods
+ *
+ ********************************************************/
+/*
+ * This method allows the user to merge two tables into one larger
+ * table by adding the rows and columns from the argument to the
+ * main instance itself. This is very useful when you have several
+ * tables that need to be combined into one table that share
+ * either a common set of column headers and/or a common set of
+ * row labels.
+ */
+bool CKTable::merge( const CKTable & aTable )
+{
+	bool		error = false;
+
+	/*
+	 * We need to save the old size of the table as well as have
+	 * a baseline for the new table. To do this, we make two copies
+	 * of the dimensions - one will remain the same, the other will
+	 * be increased for new rows and/or columns from the argument.
+	 */
+	int			oldRows = mNumRows;
+	int			oldCols = mNumColumns;
+	int			endingRows = mNumRows;
+	int			endingCols = mNumColumns;
+
+	/*
+	 * The first thing to do is to calculate what the new size of
+	 * the resulting table needs to be. We do this by seeing how
+	 * name of the row labels on aTable are empty, or not in the
+	 * row labels for this table. We then do the same for the
+	 * column headers.
+	 */
+	// do the new columns first...
+	CKStringList	newColumnHeaders;
+	if (!error) {
+		int		cnt = aTable.mNumColumns;
+		for (int i = 0; i < cnt; i++) {
+			CKString		label = aTable.mColumnHeaders[i];
+			if (label == "") {
+				endingCols++;
+			} else if (getColumnForHeader(label) == -1) {
+				endingCols++;
+				newColumnHeaders.addToEnd(label);
+			}
+		}
+	}
+	// now do the new rows...
+	CKStringList	newRowLabels;
+	if (!error) {
+		int		cnt = aTable.mNumRows;
+		for (int i = 0; i < cnt; i++) {
+			CKString		label = aTable.mRowLabels[i];
+			if (label == "") {
+				endingRows++;
+			} else if (getRowForLabel(label) == -1) {
+				endingRows++;
+				newRowLabels.addToEnd(label);
+			}
+		}
+	}
+
+	// now we need to resize the table to be the right overall size
+	if (!error) {
+		resizeTable(endingRows, endingCols);
+		if ((mNumRows != endingRows) || (mNumColumns != endingCols)) {
+			error = true;
+			std::ostringstream	msg;
+			msg << "CKTable::mergeInTable(const CKTable &) - the end result should "
+				"have been a table " << endingRows << "x" << endingCols << " in size "
+				"yet the final size is not this. That suggests an allocation error "
+				"that needs to be looked into.";
+			throw CKException(__FILE__, __LINE__, msg.str());
+		}
+	}
+
+	// now we can put in the new column headers and row labels
+	if (!error) {
+		// do the column headers first
+		for (int i = 0; i < newColumnHeaders.size(); i++) {
+			CKString	& header = newColumnHeaders[i];
+			mColumnHeaders[oldCols + i] = header;
+			mColumnHeadersIndex.put(header, oldCols + i);
+		}
+		// now do the row labels next
+		for (int i = 0; i < newRowLabels.size(); i++) {
+			CKString	& label = newRowLabels[i];
+			mRowLabels[oldRows + i] = label;
+			mRowLabelsIndex.put(label, oldRows + i);
+		}
+	}
+
+	/*
 	 * OK, to fill in all the data we need to be careful. Some tables
 	 * have all the rows and columns labeled so it's easy, look up the
 	 * row and column labels from the source and place it in the new
@@ -2420,841 +4305,2342 @@ bool CKTable::merge( const CKTable & aTable )
 	 * Thie should work for all cases.
 	 */
 	if (!error) {
-		// blank entries are past the original table
-		int	blankRow = oldRows;
-		int	blankCol = oldCols;
-		// these will be the new locations in the merged table
-		CKVector<int>	targetRow;
-		CKVector<int>	targetCol;
+		// blank entries are past the original table
+		int	blankRow = oldRows;
+		int	blankCol = oldCols;
+		// these will be the new locations in the merged table
+		CKVector<int>	targetRow;
+		CKVector<int>	targetCol;
+
+		// map all the rows from the source to the new table
+		for (int row = 0; row < aTable.mNumRows; row++) {
+			CKString	& label = aTable.mRowLabels[row];
+			if (label == "") {
+				targetRow.addToEnd(blankRow++);
+			} else {
+				targetRow.addToEnd(getRowForLabel(label));
+			}
+		}
+		// now do the same for all the columns in the source
+		for (int col = 0; col < aTable.mNumColumns; col++) {
+			CKString	& header = aTable.mColumnHeaders[col];
+			if (header == "") {
+				targetCol.addToEnd(blankCol++);
+			} else {
+				targetCol.addToEnd(getColumnForHeader(header));
+			}
+		}
+
+		/*
+		 * Now use these maps to go from the source to the new table. The
+		 * rows can be split up only if no two source rows go to the same
+		 * row of the merged table, and both are row-major so that setting
+		 * a cell can't turn a dense column into CKVariants.
+		 */
+		bool	canSplit = ((mColumns == NULL) && (aTable.mColumns == NULL));
+		if (canSplit) {
+			std::vector<bool>	used(mNumRows, false);
+			for (int row = 0; row < aTable.mNumRows; row++) {
+				int		target = targetRow[row];
+				if ((target < 0) || used[target]) {
+					canSplit = false;
+					break;
+				}
+				used[target] = true;
+			}
+		}
+		CKTableMergeTask	task(this, &aTable, &targetRow, &targetCol);
+		aTable.runOnRows(task, canSplit);
+	}
+
+	return !error;
+}
+
+
+/********************************************************
+ *
+ *            Sort, Filter and Group Methods
+ *
+ ********************************************************/
+/*
+ * These return the rows of the table in the order sorted by the
+ * values in the given columns - the first column first, then the
+ * second for the rows that tie in the first, and so on. Numbers
+ * and dates are sorted by value, and come before everything else,
+ * which is sorted by its string value. Empty cells always come
+ * last, whichever way the column is sorted. Rows that tie in all
+ * the columns stay in the order they were in, so the sort is
+ * stable.
+ */
+CKVector<int> CKTable::getSortedRows( int aCol, bool anAscending ) const
+{
+	CKVector<int>	cols(1);
+	CKVector<bool>	ascending(1);
+	cols.addToEnd(aCol);
+	ascending.addToEnd(anAscending);
+	return getSortedRows(cols, ascending);
+}
+
+
+CKVector<int> CKTable::getSortedRows( const CKVector<int> & aCols,
+									  const CKVector<bool> & anAscending ) const
+{
+	// first, make sure we have a table to sort
+	if (!hasStorage()) {
+		std::ostringstream	msg;
+		msg << "CKTable::getSortedRows(const CKVector<int> &, const "
+			"CKVector<bool> &) - there is no currently defined table structure "
+			"in this class, so there's nothing to sort. Please create the table "
+			"before calling this method.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+	// ...and that there's a direction for each column
+	int		keyCnt = aCols.size();
+	if ((keyCnt == 0) || (anAscending.size() != keyCnt)) {
+		std::ostringstream	msg;
+		msg << "CKTable::getSortedRows(const CKVector<int> &, const "
+			"CKVector<bool> &) - there were " << keyCnt << " columns and " <<
+			anAscending.size() << " directions given. There needs to be at least "
+			"one column, and a direction for each.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+	for (int k = 0; k < keyCnt; ++k) {
+		if ((aCols[k] < 0) || (aCols[k] >= mNumColumns)) {
+			std::ostringstream	msg;
+			msg << "CKTable::getSortedRows(const CKVector<int> &, const "
+				"CKVector<bool> &) - the provided column: " << aCols[k] << " lies "
+				"outside the currently defined table: " << mNumRows << " by " <<
+				mNumColumns;
+			throw CKException(__FILE__, __LINE__, msg.str());
+		}
+	}
+
+	// get the typed keys of all the columns, and then sort the row numbers
+	std::vector<CKTableSortKey>	keys(keyCnt);
+	for (int k = 0; k < keyCnt; ++k) {
+		getSortKey(aCols[k], anAscending[k], keys[k]);
+	}
+	const CKTableSortKey			& first = keys[0];
+	std::vector<CKTableSortEntry>	rows(mNumRows);
+	for (int i = 0; i < mNumRows; ++i) {
+		rows[i].row = i;
+		rows[i].kind = first.kinds[i];
+		rows[i].next = 1;
+		if (rows[i].kind == CKTABLE_NUMBER_KEY) {
+			rows[i].prefix = first.numbers[i];
+		} else if (rows[i].kind == CKTABLE_STRING_KEY) {
+			rows[i].prefix = prefixOfString(first.strings[i], rows[i].next);
+		} else {
+			rows[i].prefix = 0.0;
+		}
+	}
+	sortRows(rows, CKTableRowOrder(&keys), isWorthSplitting((double)mNumRows * keyCnt));
+
+	CKVector<int>	retval(MAX(mNumRows, 1));
+	for (int i = 0; i < mNumRows; ++i) {
+		retval.addToEnd(rows[i].row);
+	}
+	return retval;
+}
+
+
+/*
+ * These sort the rows of the table itself - with their labels -
+ * in the order getSortedRows() returns.
+ */
+void CKTable::sortBy( int aCol, bool anAscending )
+{
+	selectRows(getSortedRows(aCol, anAscending));
+}
+
+
+void CKTable::sortBy( const CKString & aColHeader, bool anAscending )
+{
+	// convert the column header to a column index
+	int		col = getColumnForHeader(aColHeader);
+	if (col < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::sortBy(const CKString &, bool) - there is no currently "
+			"defined column header '" << aColHeader << "' please make sure the "
+			"column headers are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// then call the index-based method
+	sortBy(col, anAscending);
+}
+
+
+void CKTable::sortBy( const CKVector<int> & aCols, const CKVector<bool> & anAscending )
+{
+	selectRows(getSortedRows(aCols, anAscending));
+}
+
+
+/*
+ * These return the rows, in order, that pass the test. The first
+ * form asks the filter about each row. The second compares the
+ * number - or date - in the column with the value, and a row
+ * without a number or date there never passes. It reads a dense
+ * column right from its array.
+ */
+CKVector<int> CKTable::getRowsMatching( const ICKTableRowFilter & aFilter ) const
+{
+	// first, make sure we have a table to look at
+	if (!hasStorage()) {
+		std::ostringstream	msg;
+		msg << "CKTable::getRowsMatching(const ICKTableRowFilter &) - there is "
+			"no currently defined table structure in this class, so there's "
+			"nothing to filter. Please create the table before calling this "
+			"method.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	std::vector<char>	marks(mNumRows);
+	CKTableFilterTask	task(this, &aFilter, &marks);
+	runOnRows(task);
+
+	int		cnt = 0;
+	for (int i = 0; i < mNumRows; ++i) {
+		cnt += marks[i];
+	}
+	CKVector<int>	retval(MAX(cnt, 1));
+	for (int i = 0; i < mNumRows; ++i) {
+		if (marks[i]) {
+			retval.addToEnd(i);
+		}
+	}
+	return retval;
+}
+
+
+CKVector<int> CKTable::getRowsMatching( int aCol, CKTableTest aTest, double aValue ) const
+{
+	// first, make sure we have a column to look at
+	if ((aCol < 0) || (aCol >= mNumColumns)) {
+		std::ostringstream	msg;
+		msg << "CKTable::getRowsMatching(int, CKTableTest, double) - the "
+			"provided column: " << aCol << " lies outside the currently defined "
+			"table: " << mNumRows << " by " << mNumColumns;
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	std::vector<char>	marks(mNumRows);
+	CKTableFilterTask	task(this, aCol, aTest, aValue, &marks);
+	runOnRows(task);
+
+	int		cnt = 0;
+	for (int i = 0; i < mNumRows; ++i) {
+		cnt += marks[i];
+	}
+	CKVector<int>	retval(MAX(cnt, 1));
+	for (int i = 0; i < mNumRows; ++i) {
+		if (marks[i]) {
+			retval.addToEnd(i);
+		}
+	}
+	return retval;
+}
+
+
+/*
+ * These drop all the rows of the table that don't pass the test,
+ * keeping the rest in order. If none pass, the table is left with
+ * its columns and no rows, and rows can be appended to it again.
+ */
+void CKTable::filter( const ICKTableRowFilter & aFilter )
+{
+	selectRows(getRowsMatching(aFilter));
+}
+
+
+void CKTable::filter( int aCol, CKTableTest aTest, double aValue )
+{
+	selectRows(getRowsMatching(aCol, aTest, aValue));
+}
+
+
+/*
+ * These take the rows given, in the order given, with their labels.
+ * selectRows() makes them the only rows in this table - moving the
+ * cells, and not copying them, unless a row is given more than
+ * once. getRows() returns a new table of copies of them, and leaves
+ * this one alone. The row numbers are usually from the methods
+ * above.
+ */
+void CKTable::selectRows( const CKVector<int> & aRows )
+{
+	std::vector<int>	rows;
+	checkRows(aRows, "selectRows(const CKVector<int> &)", rows);
+
+	CKVariant		*table = NULL;
+	CKTableColumn	*columns = NULL;
+	CKString		*labels = NULL;
+	gatherRows(rows, true, table, columns, labels);
+
+	// what's left of the old rows goes, and the new ones take their place
+	if (mTable != NULL) {
+		delete [] mTable;
+	}
+	dropColumns();
+	delete [] mRowLabels;
+	mTable = table;
+	mColumns = columns;
+	mRowLabels = labels;
+	mNumRows = rows.size();
+	mRowCapacity = mNumRows;
+
+	// ...and the labels are all in new places
+	mRowLabelsIndex.clear();
+	mRowLabelsIndex.reserve(mNumRows);
+	for (int i = 0; i < mNumRows; ++i) {
+		mRowLabelsIndex.put(mRowLabels[i], i);
+	}
+}
+
+
+CKTable CKTable::getRows( const CKVector<int> & aRows ) const
+{
+	std::vector<int>	rows;
+	checkRows(aRows, "getRows(const CKVector<int> &)", rows);
+
+	CKTable		retval;
+	gatherRows(rows, false, retval.mTable, retval.mColumns, retval.mRowLabels);
+	retval.mNumRows = rows.size();
+	retval.mNumColumns = mNumColumns;
+	retval.mRowCapacity = retval.mNumRows;
+	retval.mColumnCapacity = mColumnCapacity;
+	// the columns keep their headers
+	retval.mColumnHeaders = new CKString[mColumnCapacity];
+	for (int j = 0; j < mNumColumns; ++j) {
+		retval.mColumnHeaders[j] = mColumnHeaders[j];
+	}
+	retval.mColumnHeadersIndex = mColumnHeadersIndex;
+	retval.mRowLabelsIndex.reserve(retval.mNumRows);
+	for (int i = 0; i < retval.mNumRows; ++i) {
+		retval.mRowLabelsIndex.put(retval.mRowLabels[i], i);
+	}
+	return retval;
+}
+
+
+/*
+ * These group the rows of the table by the value in the column -
+ * as a string - so that the other columns can be summed up for
+ * each group with aggregate(). The groups refer to this table, so
+ * it has to be left alone while they're being used.
+ */
+CKTableGroups CKTable::groupBy( int aCol ) const
+{
+	return CKTableGroups(*this, aCol);
+}
+
+
+CKTableGroups CKTable::groupBy( const CKString & aColHeader ) const
+{
+	// convert the column header to a column index
+	int		col = getColumnForHeader(aColHeader);
+	if (col < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::groupBy(const CKString &) - there is no currently "
+			"defined column header '" << aColHeader << "' please make sure the "
+			"column headers are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// then call the index-based method
+	return groupBy(col);
+}
+
+
+/********************************************************
+ *
+ *                Join Methods
+ *
+ ********************************************************/
+/*
+ * These return a new table of the rows of this table joined with
+ * the rows of the other table that have the same values in the key
+ * columns - the columns of this table, and then the columns of the
+ * other table but its keys, with the row labels of this table. The
+ * rows are in the order of this table and, for each, the order of
+ * the other. A number or date only matches the same number or date,
+ * a string the same string, and an empty cell never matches. An
+ * inner join drops the rows that don't match anything, and a left
+ * join keeps them, with the other table's columns empty.
+ *
+ * It's a hash join - the smaller table is put in a hash table and
+ * the rows of the other are looked up in it, split up over the
+ * parallel executor on a big table - and the result is always the
+ * same whichever table that is. The result has the layout of this
+ * table, and the dense columns of a columnar one are copied as
+ * numbers and dates, and not through CKVariants. The second form
+ * joins on the column with the same header in both tables.
+ */
+CKTable CKTable::join( const CKTable & aTable, int aCol, int anOtherCol,
+					   CKTableJoinType aType ) const
+{
+	CKVector<int>	cols(1);
+	CKVector<int>	otherCols(1);
+	cols.addToEnd(aCol);
+	otherCols.addToEnd(anOtherCol);
+	return join(aTable, cols, otherCols, aType);
+}
+
+
+CKTable CKTable::join( const CKTable & aTable, const CKString & aColHeader,
+					   CKTableJoinType aType ) const
+{
+	// convert the column header to a column index in each table
+	int		col = getColumnForHeader(aColHeader);
+	int		otherCol = aTable.getColumnForHeader(aColHeader);
+	if ((col < 0) || (otherCol < 0)) {
+		std::ostringstream	msg;
+		msg << "CKTable::join(const CKTable &, const CKString &, CKTableJoinType) - "
+			"the column header '" << aColHeader << "' isn't defined in " <<
+			(col < 0 ? "this" : "the other") << " table. Please make sure the "
+			"column headers are properly defined in both.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// then call the index-based method
+	return join(aTable, col, otherCol, aType);
+}
+
+
+CKTable CKTable::join( const CKTable & aTable, const CKVector<int> & aCols,
+					   const CKVector<int> & anOtherCols, CKTableJoinType aType ) const
+{
+	// first, make sure we have the keys to join on
+	std::vector<int>	cols;
+	std::vector<int>	otherCols;
+	checkJoinColumns(aTable, aCols, anOtherCols, "join(const CKTable &, const "
+					 "CKVector<int> &, const CKVector<int> &, CKTableJoinType)",
+					 cols, otherCols);
+	if (cols.empty()) {
+		std::ostringstream	msg;
+		msg << "CKTable::join(const CKTable &, const CKVector<int> &, const "
+			"CKVector<int> &, CKTableJoinType) - there are no key columns to "
+			"join on. There has to be at least one in each table.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// get the typed keys, and their hashes, of both tables
+	CKTableJoinKeys		keys;
+	CKTableJoinKeys		otherKeys;
+	getJoinKeys(cols, keys);
+	aTable.getJoinKeys(otherCols, otherKeys);
+
+	/*
+	 * The smaller table goes in the hash table, and the rows of the other
+	 * are looked up in it. Each block of rows that's looked up has its own
+	 * list of the pairs of rows that match, so they can be put together in
+	 * order once they're all done.
+	 */
+	int					rowCnt = mNumRows;
+	int					otherRowCnt = aTable.mNumRows;
+	bool				probeThis = (otherRowCnt <= rowCnt);
+	const CKTableJoinKeys	& built = (probeThis ? otherKeys : keys);
+	const CKTableJoinKeys	& probed = (probeThis ? keys : otherKeys);
+	int					builtCnt = (probeThis ? otherRowCnt : rowCnt);
+	int					probedCnt = (probeThis ? rowCnt : otherRowCnt);
+	CKTableJoinIndex	index(&built, builtCnt);
+	for (int i = builtCnt - 1; i >= 0; --i) {
+		if (built.hashes[i] != 0) {
+			index.add(i);
+		}
+	}
+	std::vector< std::vector<int> >	pairs((probedCnt + CKTABLE_ROW_BLOCK - 1) / CKTABLE_ROW_BLOCK);
+	CKTableJoinProbeTask	task(probedCnt, &probed, &index,
+								 (probeThis && (aType == eLeftJoin)), &pairs);
+	if (probeThis) {
+		runOnRows(task);
+	} else {
+		aTable.runOnRows(task);
+	}
+
+	std::vector<int>	rows;
+	std::vector<int>	otherRows;
+	if (probeThis) {
+		// the pairs are already in the order of this table's rows
+		for (unsigned int b = 0; b < pairs.size(); ++b) {
+			for (unsigned int p = 0; p < pairs[b].size(); p += 2) {
+				rows.push_back(pairs[b][p]);
+				otherRows.push_back(pairs[b][p + 1]);
+			}
+		}
+	} else {
+		/*
+		 * The pairs are in the order of the other table's rows, so they're
+		 * put in the order of this table's rows by counting how many each
+		 * has, and then dropping them into place - which keeps them in
+		 * order for each row. A left join gives the rows without any one
+		 * place of their own.
+		 */
+		std::vector<int>	starts(rowCnt + 1, 0);
+		for (unsigned int b = 0; b < pairs.size(); ++b) {
+			for (unsigned int p = 0; p < pairs[b].size(); p += 2) {
+				++starts[pairs[b][p + 1] + 1];
+			}
+		}
+		for (int i = 0; i < rowCnt; ++i) {
+			if ((aType == eLeftJoin) && (starts[i + 1] == 0)) {
+				starts[i + 1] = 1;
+			}
+			starts[i + 1] += starts[i];
+		}
+		rows.resize(starts[rowCnt]);
+		otherRows.assign(starts[rowCnt], -1);
+		for (int i = 0; i < rowCnt; ++i) {
+			for (int k = starts[i]; k < starts[i + 1]; ++k) {
+				rows[k] = i;
+			}
+		}
+		std::vector<int>	next(starts.begin(), starts.end() - 1);
+		for (unsigned int b = 0; b < pairs.size(); ++b) {
+			for (unsigned int p = 0; p < pairs[b].size(); p += 2) {
+				otherRows[next[pairs[b][p + 1]]++] = pairs[b][p];
+			}
+		}
+	}
+
+	// the other table's keys are the same as ours, so they're left out
+	std::vector<int>	keep;
+	for (int j = 0; j < aTable.mNumColumns; ++j) {
+		if (std::find(otherCols.begin(), otherCols.end(), j) == otherCols.end()) {
+			keep.push_back(j);
+		}
+	}
+	return joinedTable(aTable, rows, otherRows, keep);
+}
+
+
+/*
+ * These are the as-of merge of the other table into this one. For
+ * each row of this table, it's the last row of the other table,
+ * with the same values in the key columns, whose time - a number
+ * or date - isn't after the time of this row. Ties in time go to
+ * the one furthest down the other table. Every row of this table
+ * is in the result, in order, with the columns of the other table
+ * but its keys - the time column stays, so it's clear how old the
+ * match was - and they're empty if there's no match. The first
+ * form has no key columns, just the times.
+ */
+CKTable CKTable::asOfJoin( const CKTable & aTable, int aTimeCol,
+						   int anOtherTimeCol ) const
+{
+	return asOfJoin(aTable, CKVector<int>(), CKVector<int>(), aTimeCol, anOtherTimeCol);
+}
+
+
+CKTable CKTable::asOfJoin( const CKTable & aTable, const CKVector<int> & aCols,
+						   const CKVector<int> & anOtherCols, int aTimeCol,
+						   int anOtherTimeCol ) const
+{
+	// first, make sure we have the keys and times to join on
+	std::vector<int>	cols;
+	std::vector<int>	otherCols;
+	checkJoinColumns(aTable, aCols, anOtherCols, "asOfJoin(const CKTable &, const "
+					 "CKVector<int> &, const CKVector<int> &, int, int)",
+					 cols, otherCols);
+	if ((aTimeCol < 0) || (aTimeCol >= mNumColumns) ||
+		(anOtherTimeCol < 0) || (anOtherTimeCol >= aTable.mNumColumns)) {
+		std::ostringstream	msg;
+		msg << "CKTable::asOfJoin(const CKTable &, const CKVector<int> &, const "
+			"CKVector<int> &, int, int) - the provided time columns: " << aTimeCol <<
+			" and " << anOtherTimeCol << " lie outside the currently defined "
+			"tables: " << mNumRows << " by " << mNumColumns << " and " <<
+			aTable.mNumRows << " by " << aTable.mNumColumns;
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// get the keys and the times of both tables
+	CKTableJoinKeys		keys;
+	CKTableJoinKeys		otherKeys;
+	CKTableSortKey		times;
+	CKTableSortKey		otherTimes;
+	getJoinKeys(cols, keys);
+	aTable.getJoinKeys(otherCols, otherKeys);
+	getSortKey(aTimeCol, true, times);
+	aTable.getSortKey(anOtherTimeCol, true, otherTimes);
+
+	/*
+	 * The rows of the other table are put in groups with the same keys -
+	 * the first row of each is in the hash table - and a row without a
+	 * time is never matched, so it's left out. Then the times of each
+	 * group, with their rows, are sorted in its own range of the list.
+	 */
+	int					otherRowCnt = aTable.mNumRows;
+	CKTableJoinIndex	index(&otherKeys, otherRowCnt);
+	std::vector<int>	groupOfRow(otherRowCnt, -1);
+	std::vector<int>	starts(1, 0);
+	for (int i = 0; i < otherRowCnt; ++i) {
+		if ((otherKeys.hashes[i] == 0) || (otherTimes.kinds[i] != CKTABLE_NUMBER_KEY)) {
+			continue;
+		}
+		int		first = index.find(otherKeys, i, -1);
+		if (first < 0) {
+			index.add(i);
+			groupOfRow[i] = starts.size() - 1;
+			starts.push_back(0);
+		} else {
+			groupOfRow[i] = groupOfRow[first];
+		}
+		++starts[groupOfRow[i] + 1];
+	}
+	int		groups = starts.size() - 1;
+	for (int g = 0; g < groups; ++g) {
+		starts[g + 1] += starts[g];
+	}
+	std::vector< std::pair<double, int> >	entries(starts[groups]);
+	std::vector<int>						next(starts.begin(), starts.end() - 1);
+	for (int i = 0; i < otherRowCnt; ++i) {
+		if (groupOfRow[i] >= 0) {
+			entries[next[groupOfRow[i]]++] = std::make_pair(otherTimes.numbers[i], i);
+		}
+	}
+	for (int g = 0; g < groups; ++g) {
+		std::sort(entries.begin() + starts[g], entries.begin() + starts[g + 1]);
+	}
+
+	// now each row of this table can find its match
+	std::vector<int>		rows(mNumRows);
+	std::vector<int>		matches(mNumRows);
+	for (int i = 0; i < mNumRows; ++i) {
+		rows[i] = i;
+	}
+	CKTableAsOfProbeTask	task(this, &keys, &times, &index, &groupOfRow,
+								 &starts, &entries, &matches);
+	runOnRows(task);
+
+	// the other table's keys are the same as ours, so they're left out
+	std::vector<int>	keep;
+	for (int j = 0; j < aTable.mNumColumns; ++j) {
+		if (std::find(otherCols.begin(), otherCols.end(), j) == otherCols.end()) {
+			keep.push_back(j);
+		}
+	}
+	return joinedTable(aTable, rows, matches, keep);
+}
+
+
+/********************************************************
+ *
+ *                Matrix Methods
+ *
+ ********************************************************/
+/*
+ * This returns the matrix product of this table and the other -
+ * not the element by element product of multiply() - so the other
+ * table has to have as many rows as this one has columns. The
+ * result has the row labels of this table and the column headers
+ * of the other.
+ */
+CKTable CKTable::matrixMultiply( const CKTable & aTable ) const
+{
+	static const char	*method = "matrixMultiply(const CKTable &)";
+	std::vector<const double *>	a;
+	std::vector<double>			aCopy;
+	std::vector<const double *>	b;
+	std::vector<double>			bCopy;
+	getMatrixColumns(method, false, a, aCopy);
+	aTable.getMatrixColumns(method, false, b, bCopy);
+	if (mNumColumns != aTable.mNumRows) {
+		std::ostringstream	msg;
+		msg << "CKTable::" << method << " - this table has " << mNumColumns <<
+			" columns, but the other table has " << aTable.mNumRows << " rows. "
+			"They have to be the same to multiply the matrices.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	CKTable		retval = matrixTable(mNumRows, aTable.mNumColumns);
+	multiplyInto(retval, mNumColumns, a, false, b);
+	for (int i = 0; i < mNumRows; ++i) {
+		retval.mRowLabels[i] = mRowLabels[i];
+		retval.mRowLabelsIndex.put(mRowLabels[i], i);
+	}
+	for (int j = 0; j < aTable.mNumColumns; ++j) {
+		retval.mColumnHeaders[j] = aTable.mColumnHeaders[j];
+		retval.mColumnHeadersIndex.put(aTable.mColumnHeaders[j], j);
+	}
+	return retval;
+}
+
+
+/*
+ * This returns the transpose of the table - a row for each column
+ * and a column for each row - with the column headers as the row
+ * labels, and the row labels as the column headers.
+ */
+CKTable CKTable::transpose() const
+{
+	std::vector<const double *>	cols;
+	std::vector<double>			copy;
+	getMatrixColumns("transpose()", false, cols, copy);
+
+	CKTable					retval = matrixTable(mNumColumns, mNumRows);
+	std::vector<double *>	out(mNumRows);
+	for (int i = 0; i < mNumRows; ++i) {
+		out[i] = retval.mColumns[i].doubles;
+	}
+	if ((mNumRows > 0) && (mNumColumns > 0)) {
+		CKVectorMath::transpose(mNumRows, mNumColumns, &cols[0], &out[0]);
+	}
+	for (int j = 0; j < mNumColumns; ++j) {
+		retval.mRowLabels[j] = mColumnHeaders[j];
+		retval.mRowLabelsIndex.put(mColumnHeaders[j], j);
+	}
+	for (int i = 0; i < mNumRows; ++i) {
+		retval.mColumnHeaders[i] = mRowLabels[i];
+		retval.mColumnHeadersIndex.put(mRowLabels[i], i);
+	}
+	return retval;
+}
+
+
+/*
+ * These return the sample covariance - over N-1 - and correlation
+ * of the columns of the table, each as a square table with a row
+ * and a column for each column of this one, with its header as the
+ * label of both. The columns are centered on their means before
+ * they're multiplied, so nothing is lost to big means, and there
+ * have to be at least two rows.
+ */
+CKTable CKTable::covariance() const
+{
+	static const char	*method = "covariance()";
+	std::vector<const double *>	cols;
+	std::vector<double>			centered;
+	if (hasStorage() && (mNumRows < 2)) {
+		std::ostringstream	msg;
+		msg << "CKTable::" << method << " - the table has " << mNumRows <<
+			" rows, and there have to be at least two for a covariance.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+	getMatrixColumns(method, true, cols, centered);
+	for (int j = 0; j < mNumColumns; ++j) {
+		centerColumn(&centered[(size_t)j * mNumRows], mNumRows);
+	}
+
+	/*
+	 * The product of the transpose of the centered columns with them
+	 * is the sum of the products of each pair, and it's exactly the
+	 * same sum both ways around, so the result is exactly symmetric.
+	 */
+	CKTable		retval = matrixTable(mNumColumns, mNumColumns);
+	multiplyInto(retval, mNumRows, cols, true, cols);
+	for (int j = 0; j < mNumColumns; ++j) {
+		CKVectorMath::apply('/', retval.mColumns[j].doubles, mNumColumns,
+							(double)(mNumRows - 1));
+		retval.mRowLabels[j] = mColumnHeaders[j];
+		retval.mRowLabelsIndex.put(mColumnHeaders[j], j);
+		retval.mColumnHeaders[j] = mColumnHeaders[j];
+		retval.mColumnHeadersIndex.put(mColumnHeaders[j], j);
+	}
+	return retval;
+}
+
+
+/*
+ * The correlation is the covariance over the standard deviations of
+ * the two columns. It can't be more than one either way, so what the
+ * rounding might put past that is pulled back, and a column is always
+ * exactly correlated with itself - unless it's all one number, and
+ * then its row and column are NAN as there's nothing to correlate.
+ */
+CKTable CKTable::correlation() const
+{
+	CKTable				retval = covariance();
+	int					cnt = mNumColumns;
+	std::vector<double>	sd(cnt);
+	for (int j = 0; j < cnt; ++j) {
+		sd[j] = sqrt(retval.mColumns[j].doubles[j]);
+	}
+	for (int j = 0; j < cnt; ++j) {
+		double	*col = retval.mColumns[j].doubles;
+		for (int i = 0; i < cnt; ++i) {
+			double	r = col[i] / (sd[i] * sd[j]);
+			if (r > 1.0) {
+				r = 1.0;
+			} else if (r < -1.0) {
+				r = -1.0;
+			}
+			col[i] = r;
+		}
+		if (sd[j] > 0.0) {
+			col[j] = 1.0;
+		}
+	}
+	return retval;
+}
+
+
+/********************************************************
+ *
+ *                Simple Math Methods
+ *
+ ********************************************************/
+/*
+ * These methods allow the user to add values to each applicable
+ * element in this table. In the first case, it's a constant value
+ * but in the second it's another table. The values updated in the
+ * methods are only those that make sense.
+ */
+bool CKTable::add( double anOffset )
+{
+	bool		error = false;
+
+	// see if we have anything to do
+	if (!error) {
+		if (!hasStorage()) {
+			error = true;
+			std::ostringstream	msg;
+			msg << "CKTable::add(double) - the main table structure is not where "
+				"it should be and this is a serious data integrity error that needs "
+				"to be looked into as soon as possible.";
+			throw CKException(__FILE__, __LINE__, msg.str());
+		}
+	}
+
+	// do all the cells where it makes sense - splitting it up if it's big
+	if (!error) {
+		doMath('+', anOffset);
+	}
+
+	return !error;
+}
+
+
+bool CKTable::add( CKTable & anOther )
+{
+	bool		error = false;
+
+	// see if we have anything to do
+	if (!error) {
+		if (!hasStorage()) {
+			error = true;
+			std::ostringstream	msg;
+			msg << "CKTable::add(CKTable &) - the main table structure is not where "
+				"it should be and this is a serious data integrity error that needs "
+				"to be looked into as soon as possible.";
+			throw CKException(__FILE__, __LINE__, msg.str());
+		}
+	}
+
+	// see if the sizes are the same - they have to be for this
+	if (!error) {
+		if ((mNumRows != anOther.mNumRows) ||
+			(mNumColumns != anOther.mNumColumns)) {
+			error = true;
+			std::ostringstream	msg;
+			msg << "CKTable::add(CKTable &) - this table is " << mNumRows << "x" <<
+				mNumColumns << " and the passed-in table is " << anOther.mNumRows <<
+				"x" << anOther.mNumColumns << " and this mistatch is not allowed for "
+				"the addition operation. Please make sure that the sizes match.";
+			throw CKException(__FILE__, __LINE__, msg.str());
+		}
+	}
+
+	// do all the cells where it makes sense - splitting it up if it's big
+	if (!error) {
+		doMath('+', anOther);
+	}
+
+	return !error;
+}
+
+
+bool CKTable::add( const CKTable & anOther )
+{
+	return add((CKTable &)anOther);
+}
+
+
+/*
+ * These methods allow the user to subtract values from each applicable
+ * element in this table. In the first case, it's a constant value
+ * but in the second it's another table. The values updated in the
+ * methods are only those that make sense.
+ */
+bool CKTable::subtract( double anOffset )
+{
+	bool		error = false;
+
+	// see if we have anything to do
+	if (!error) {
+		if (!hasStorage()) {
+			error = true;
+			std::ostringstream	msg;
+			msg << "CKTable::subtract(double) - the main table structure is not where "
+				"it should be and this is a serious data integrity error that needs "
+				"to be looked into as soon as possible.";
+			throw CKException(__FILE__, __LINE__, msg.str());
+		}
+	}
+
+	// do all the cells where it makes sense - splitting it up if it's big
+	if (!error) {
+		doMath('-', anOffset);
+	}
+
+	return !error;
+}
+
+
+bool CKTable::subtract( CKTable & anOther )
+{
+	bool		error = false;
+
+	// see if we have anything to do
+	if (!error) {
+		if (!hasStorage()) {
+			error = true;
+			std::ostringstream	msg;
+			msg << "CKTable::subtract(CKTable &) - the main table structure is not where "
+				"it should be and this is a serious data integrity error that needs "
+				"to be looked into as soon as possible.";
+			throw CKException(__FILE__, __LINE__, msg.str());
+		}
+	}
+
+	// see if the sizes are the same - they have to be for this
+	if (!error) {
+		if ((mNumRows != anOther.mNumRows) ||
+			(mNumColumns != anOther.mNumColumns)) {
+			error = true;
+			std::ostringstream	msg;
+			msg << "CKTable::subtract(CKTable &) - this table is " << mNumRows << "x" <<
+				mNumColumns << " and the passed-in table is " << anOther.mNumRows <<
+				"x" << anOther.mNumColumns << " and this mistatch is not allowed for "
+				"the addition operation. Please make sure that the sizes match.";
+			throw CKException(__FILE__, __LINE__, msg.str());
+		}
+	}
+
+	// do all the cells where it makes sense - splitting it up if it's big
+	if (!error) {
+		doMath('-', anOther);
+	}
+
+	return !error;
+}
+
+
+bool CKTable::subtract( const CKTable & anOther )
+{
+	return subtract((CKTable &)anOther);
+}
+
+
+/*
+ * These method allows the user to multiply a constant value to
+ * all elements in the table where such an activity would produce
+ * reasonable results. The second form of the method allows for the
+ * element-by-element multiplication of the tables.
+ */
+bool CKTable::multiply( double aFactor )
+{
+	bool		error = false;
+
+	// see if we have anything to do
+	if (!error) {
+		if (!hasStorage()) {
+			error = true;
+			std::ostringstream	msg;
+			msg << "CKTable::multiply(double) - the main table structure is not where "
+				"it should be and this is a serious data integrity error that needs "
+				"to be looked into as soon as possible.";
+			throw CKException(__FILE__, __LINE__, msg.str());
+		}
+	}
+
+	// do all the cells where it makes sense - splitting it up if it's big
+	if (!error) {
+		doMath('*', aFactor);
+	}
+
+	return !error;
+}
+
+
+bool CKTable::multiply( CKTable & anOther )
+{
+	bool		error = false;
+
+	// see if we have anything to do
+	if (!error) {
+		if (!hasStorage()) {
+			error = true;
+			std::ostringstream	msg;
+			msg << "CKTable::multiply(CKTable &) - the main table structure is not where "
+				"it should be and this is a serious data integrity error that needs "
+				"to be looked into as soon as possible.";
+			throw CKException(__FILE__, __LINE__, msg.str());
+		}
+	}
 
-		// map all the rows from the source to the new table
-		for (int row = 0; row < aTable.mNumRows; row++) {
-			CKString	& label = aTable.mRowLabels[row];
-			if (label == "") {
-				targetRow.addToEnd(blankRow++);
-			} else {
-				targetRow.addToEnd(getRowForLabel(label));
-			}
+	// see if the sizes are the same - they have to be for this
+	if (!error) {
+		if ((mNumRows != anOther.mNumRows) ||
+			(mNumColumns != anOther.mNumColumns)) {
+			error = true;
+			std::ostringstream	msg;
+			msg << "CKTable::multiply(CKTable &) - this table is " << mNumRows << "x" <<
+				mNumColumns << " and the passed-in table is " << anOther.mNumRows <<
+				"x" << anOther.mNumColumns << " and this mistatch is not allowed for "
+				"the addition operation. Please make sure that the sizes match.";
+			throw CKException(__FILE__, __LINE__, msg.str());
 		}
-		// now do the same for all the columns in the source
-		for (int col = 0; col < aTable.mNumColumns; col++) {
-			CKString	& header = aTable.mColumnHeaders[col];
-			if (header == "") {
-				targetCol.addToEnd(blankCol++);
-			} else {
-				targetCol.addToEnd(getColumnForHeader(header));
-			}
+	}
+
+	// do all the cells where it makes sense - splitting it up if it's big
+	if (!error) {
+		doMath('*', anOther);
+	}
+
+	return !error;
+}
+
+
+bool CKTable::multiply( const CKTable & anOther )
+{
+	return multiply((CKTable &)anOther);
+}
+
+
+/*
+ * These method allows the user to divide each element in this
+ * table by a constant value where such an activity would produce
+ * reasonable results. The second form of the method allows for the
+ * element-by-element division of the tables.
+ */
+bool CKTable::divide( double aDivisor )
+{
+	bool		error = false;
+
+	// see if we have anything to do
+	if (!error) {
+		if (!hasStorage()) {
+			error = true;
+			std::ostringstream	msg;
+			msg << "CKTable::divide(double) - the main table structure is not where "
+				"it should be and this is a serious data integrity error that needs "
+				"to be looked into as soon as possible.";
+			throw CKException(__FILE__, __LINE__, msg.str());
 		}
+	}
 
-		// now use these maps to go from the source to the new table
-		for (int row = 0; row < aTable.mNumRows; row++) {
-			for (int col = 0; col < aTable.mNumColumns; col++) {
-				mTable[targetRow[row] * mNumColumns + targetCol[col]] =
-							aTable.mTable[row * aTable.mNumColumns + col];
-			}
+	// do all the cells where it makes sense - splitting it up if it's big
+	if (!error) {
+		doMath('/', aDivisor);
+	}
+
+	return !error;
+}
+
+
+bool CKTable::divide( CKTable & anOther )
+{
+	bool		error = false;
+
+	// see if we have anything to do
+	if (!error) {
+		if (!hasStorage()) {
+			error = true;
+			std::ostringstream	msg;
+			msg << "CKTable::divide(CKTable &) - the main table structure is not where "
+				"it should be and this is a serious data integrity error that needs "
+				"to be looked into as soon as possible.";
+			throw CKException(__FILE__, __LINE__, msg.str());
+		}
+	}
+
+	// see if the sizes are the same - they have to be for this
+	if (!error) {
+		if ((mNumRows != anOther.mNumRows) ||
+			(mNumColumns != anOther.mNumColumns)) {
+			error = true;
+			std::ostringstream	msg;
+			msg << "CKTable::divide(CKTable &) - this table is " << mNumRows << "x" <<
+				mNumColumns << " and the passed-in table is " << anOther.mNumRows <<
+				"x" << anOther.mNumColumns << " and this mistatch is not allowed for "
+				"the addition operation. Please make sure that the sizes match.";
+			throw CKException(__FILE__, __LINE__, msg.str());
+		}
+	}
+
+	// do all the cells where it makes sense - splitting it up if it's big
+	if (!error) {
+		doMath('/', anOther);
+	}
+
+	return !error;
+}
+
+
+bool CKTable::divide( const CKTable & anOther )
+{
+	return divide((CKTable &)anOther);
+}
+
+
+/*
+ * This method simply takes the inverse of each value in the table
+ * so that x -> 1/x for all points. This is marginally useful
+ * I'm thinking, but I added it here to be a little more complete.
+ */
+bool CKTable::inverse()
+{
+	bool		error = false;
+
+	// see if we have anything to do
+	if (!error) {
+		if (!hasStorage()) {
+			error = true;
+			std::ostringstream	msg;
+			msg << "CKTable::inverse() - the main table structure is not where "
+				"it should be and this is a serious data integrity error that needs "
+				"to be looked into as soon as possible.";
+			throw CKException(__FILE__, __LINE__, msg.str());
 		}
 	}
 
-	return !error;
+	// do all the cells where it makes sense - splitting it up if it's big
+	if (!error) {
+		doMath('i', 0.0);
+	}
+
+	return !error;
+}
+
+
+/*
+ * These are the operator equivalents of the simple mathematical
+ * operations on the table. They are here as an aid to the
+ * developer of analytic functions based on these guys.
+ */
+CKTable & CKTable::operator+=( double anOffset )
+{
+	add(anOffset);
+	return *this;
+}
+
+
+CKTable & CKTable::operator+=( CKTable & aTable )
+{
+	add(aTable);
+	return *this;
+}
+
+
+CKTable & CKTable::operator+=( const CKTable & aTable )
+{
+	add((CKTable &)aTable);
+	return *this;
+}
+
+
+CKTable & CKTable::operator-=( double anOffset )
+{
+	subtract(anOffset);
+	return *this;
+}
+
+
+CKTable & CKTable::operator-=( CKTable & aTable )
+{
+	subtract(aTable);
+	return *this;
+}
+
+
+CKTable & CKTable::operator-=( const CKTable & aTable )
+{
+	subtract((CKTable &)aTable);
+	return *this;
+}
+
+
+CKTable & CKTable::operator*=( double aFactor )
+{
+	multiply(aFactor);
+	return *this;
+}
+
+
+CKTable & CKTable::operator/=( double aDivisor )
+{
+	divide(aDivisor);
+	return *this;
+}
+
+
+/********************************************************
+ *
+ *                Utility Methods
+ *
+ ********************************************************/
+/*
+ * This method returns a copy of the current value as contained in
+ * a string. This is returned as a CKString as it's easy to use.
+ */
+CKString CKTable::getValueAsString( int aRow, int aCol ) const
+{
+	// first, make sure we have a place to put this data
+	if ((aRow < 0) || (aRow >= mNumRows) ||
+		(aCol < 0) || (aCol >= mNumColumns)) {
+		std::ostringstream	msg;
+		msg << "CKTable::getValueAsString(int, int) - the provided "
+			"location: " << aRow << ", " << aCol << " lies outside the currently "
+			"defined table: " << mNumRows << " by " << mNumColumns;
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+	// ...and that we have a table structure that matches
+	if (!hasStorage()) {
+		std::ostringstream	msg;
+		msg << "CKTable::getValueAsString(int, int) - there is no "
+			"currently defined table structure in this class. This is a "
+			"serious data integrity problem that needs to be looked into.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// now get what they are looking for
+	CKVariant	scratch;
+	return readCell(aRow, aCol, scratch).getValueAsString();
+}
+
+
+CKString CKTable::getValueAsString( int aRow, const CKString & aColHeader ) const
+{
+	// convert the column header to a column index
+	int		col = getColumnForHeader(aColHeader);
+	if (col < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getValueAsString(int, const CKString &) "
+			"- there is no currently defined column header '" << aColHeader <<
+			"' please make sure the column headers are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// then call the index-based method
+	return getValueAsString(aRow, col);
 }
 
 
-/********************************************************
- *
- *                Simple Math Methods
- *
- ********************************************************/
-/*
- * These methods allow the user to add values to each applicable
- * element in this table. In the first case, it's a constant value
- * but in the second it's another table. The values updated in the
- * methods are only those that make sense.
- */
-bool CKTable::add( double anOffset )
+CKString CKTable::getValueAsString( const CKString & aRowLabel, int aCol ) const
 {
-	bool		error = false;
+	// convert the row label to a row index
+	int		row = getRowForLabel(aRowLabel);
+	if (row < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getValueAsString(const CKString &, int) "
+			"- there is no currently defined row label '" << aRowLabel <<
+			"' please make sure the row labels are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
 
-	// see if we have anything to do
-	if (!error) {
-		if (mTable == NULL) {
-			error = true;
-			std::ostringstream	msg;
-			msg << "CKTable::add(double) - the main table structure is not where "
-				"it should be and this is a serious data integrity error that needs "
-				"to be looked into as soon as possible.";
-			throw CKException(__FILE__, __LINE__, msg.str());
-		}
+	// then call the index-based method
+	return getValueAsString(row, aCol);
+}
+
+
+CKString CKTable::getValueAsString( const CKString & aRowLabel, const CKString & aColHeader ) const
+{
+	// convert the row label to a row index
+	int		row = getRowForLabel(aRowLabel);
+	if (row < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getValueAsString(const CKString &, const CKString &) "
+			"- there is no currently defined row label '" << aRowLabel <<
+			"' please make sure the row labels are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
-	// now do the math an element at a time
-	if (!error) {
-		for (int row = 0; row < mNumRows; row++) {
-			for (int col = 0; col < mNumColumns; col++) {
-				try {
-					mTable[row * mNumColumns + col] += anOffset;
-				} catch (CKException & e) {
-					/*
-					 * At this point we really don't want to throw an
-					 * exception because we said that we'd only do those
-					 * elements where it made sense. So, let's eat this
-					 * exception and trust that it being logged is enough.
-					 */
-				}
-			}
-		}
+	// convert the column header to a column index
+	int		col = getColumnForHeader(aColHeader);
+	if (col < 0) {
+		std::ostringstream	msg;
+		msg << "CKTable::getValueAsString(const CKString &, const CKString &) "
+			"- there is no currently defined column header '" << aColHeader <<
+			"' please make sure the column headers are properly defined.";
+		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
-	return !error;
+	// then call the index-based method
+	return getValueAsString(row, col);
 }
 
 
-bool CKTable::add( CKTable & anOther )
+/*
+ * In order to simplify the move of this object from C++ to Java
+ * it makes sense to encode the table's data into a (char *) that
+ * can be converted to a Java String and then the Java object can
+ * interpret it and "reconstitue" the object from this coding.
+ */
+CKString CKTable::generateCodeFromValues() const
 {
-	bool		error = false;
+	/*
+	 * OK... this is interesting because I happen to like the idea
+	 * that Bloomberg had for delimiting the data - have the first
+	 * character be the delimiter for the entire string. The trick
+	 * is that we'll generate the terminated string with a placeholder
+	 * and then see what character we can place in the string as the
+	 * delimiter that's from our list of accecptable values. It's
+	 * interesting and pretty fun.
+	 */
 
-	// see if we have anything to do
-	if (!error) {
-		if (mTable == NULL) {
-			error = true;
-			std::ostringstream	msg;
-			msg << "CKTable::add(CKTable &) - the main table structure is not where "
-				"it should be and this is a serious data integrity error that needs "
-				"to be looked into as soon as possible.";
-			throw CKException(__FILE__, __LINE__, msg.str());
+	/*
+	 * Start with all the data, as that's the bulk of it. For a big table,
+	 * the blocks of rows are written into pieces on the executor, and then
+	 * the pieces are put on in order - so the code is the same either way.
+	 */
+	std::vector<std::string>	pieces;
+	int							length = 32;
+	if (hasStorage()) {
+		pieces.resize((mNumRows + CKTABLE_ROW_BLOCK - 1) / CKTABLE_ROW_BLOCK);
+		CKTableCodeTask		task(this, &pieces);
+		runOnRows(task);
+		for (unsigned int i = 0; i < pieces.size(); ++i) {
+			length += pieces[i].size();
 		}
 	}
+	for (int j = 0; j < mNumColumns; ++j) {
+		length += mColumnHeaders[j].size() + 1;
+	}
+	for (int j = 0; j < mNumRows; ++j) {
+		length += mRowLabels[j].size() + 1;
+	}
 
-	// see if the sizes are the same - they have to be for this
-	if (!error) {
-		if ((mNumRows != anOther.mNumRows) ||
-			(mNumColumns != anOther.mNumColumns)) {
-			error = true;
-			std::ostringstream	msg;
-			msg << "CKTable::add(CKTable &) - this table is " << mNumRows << "x" <<
-				mNumColumns << " and the passed-in table is " << anOther.mNumRows <<
-				"x" << anOther.mNumColumns << " and this mistatch is not allowed for "
-				"the addition operation. Please make sure that the sizes match.";
-			throw CKException(__FILE__, __LINE__, msg.str());
-		}
+	// get a buffer big enough to build up this value
+	CKString buff(length + 1);
+
+	// first, send out the row and column counts
+	buff.append("\x01").append(mNumRows).append("\x01").append(mNumColumns).
+		append("\x01");
+
+	// next, loop over all the column headers and write them out as well
+	for (int j = 0; j < mNumColumns; ++j) {
+		buff.append(mColumnHeaders[j]).append("\x01");
 	}
 
-	// now do the math an element at a time
-	if (!error) {
-		for (int row = 0; row < mNumRows; row++) {
-			for (int col = 0; col < mNumColumns; col++) {
-				try {
-					mTable[row * mNumColumns + col] += anOther.mTable[row * mNumColumns + col];
-				} catch (CKException & e) {
-					/*
-					 * At this point we really don't want to throw an
-					 * exception because we said that we'd only do those
-					 * elements where it made sense. So, let's eat this
-					 * exception and trust that it being logged is enough.
-					 */
-				}
-			}
-		}
+	// next, loop over all the row labels and write them out as well
+	for (int j = 0; j < mNumRows; ++j) {
+		buff.append(mRowLabels[j]).append("\x01");
 	}
 
-	return !error;
-}
+	// now put on all the data
+	for (unsigned int i = 0; i < pieces.size(); ++i) {
+		buff.append(pieces[i]);
+	}
 
+	/*
+	 * OK, it's now in a simple character array that we can scan to check
+	 * for acceptable delimiter values. What we'll do is to check the string
+	 * for the existence of a series of possible delimiters, and as soon as
+	 * we find one that's not used in the string we'll use that guy.
+	 */
+	if (!chooseAndApplyDelimiter(buff)) {
+		throw CKException(__FILE__, __LINE__, "CKTable::generateCodeFrom"
+			"Values() - while trying to find an acceptable delimiter for "
+			"the data in the table we ran out of possibles before finding "
+			"one that wasn't being used in the text of the code. This is "
+			"a serious problem that the developers need to look into.");
+	}
 
-bool CKTable::add( const CKTable & anOther )
-{
-	return add((CKTable &)anOther);
+	return buff;
 }
 
 
 /*
- * These methods allow the user to subtract values from each applicable
- * element in this table. In the first case, it's a constant value
- * but in the second it's another table. The values updated in the
- * methods are only those that make sense.
+ * This method takes a code that could have been written with the
+ * generateCodeFromValues() method on either the C++ or Java
+ * versions of this class and extracts all the values from the code
+ * that are needed to populate this table. The argument is left
+ * untouched, and is the responsible of the caller to free.
  */
-bool CKTable::subtract( double anOffset )
+void CKTable::takeValuesFromCode( const CKString & aCode )
 {
-	bool		error = false;
+	// first, see if we have anything to do
+	if (aCode.empty()) {
+		throw CKException(__FILE__, __LINE__, "CKTable::takeValuesFromCode("
+			"const CKString &) - the passed-in code is empty which means that "
+			"there's nothing I can do. Please make sure that the argument is "
+			"not empty before calling this method.");
+	}
 
-	// see if we have anything to do
-	if (!error) {
-		if (mTable == NULL) {
-			error = true;
-			std::ostringstream	msg;
-			msg << "CKTable::subtract(double) - the main table structure is not where "
-				"it should be and this is a serious data integrity error that needs "
-				"to be looked into as soon as possible.";
-			throw CKException(__FILE__, __LINE__, msg.str());
+	/*
+	 * The data is character-delimited and the delimiter is
+	 * the first character of the field data. All subsequent
+	 * values will be delimited by this character. We need to
+	 * get it.
+	 */
+	char	delim = aCode[0];
+	/*
+	 * ...and find where each chunk starts. The code is the delimiter,
+	 * the chunks each followed by the delimiter, so chunk 'k' starts just
+	 * past the k-th delimiter and runs up to the one before start 'k+1'.
+	 * Finding them with one pass, and not making a list of them all,
+	 * means the values can be parsed right out of the code - and in
+	 * pieces on the executor if the table is big.
+	 */
+	const char			*code = aCode.c_str();
+	int					len = aCode.size();
+	std::vector<int>	starts;
+	starts.push_back(1);
+	for (int i = 1; i < len - 1; ++i) {
+		if (code[i] == delim) {
+			starts.push_back(i + 1);
 		}
 	}
+	starts.push_back(len);
+	int		chunkCnt = starts.size() - 1;
+	if (chunkCnt < 3) {
+		std::ostringstream	msg;
+		msg << "CKTable::takeValuesFromCode(const CKString &) - the code: '" <<
+			aCode << "' does not represent a valid table encoding. Please check "
+			"on it's source as soon as possible.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
 
-	// now do the math an element at a time
-	if (!error) {
-		for (int row = 0; row < mNumRows; row++) {
-			for (int col = 0; col < mNumColumns; col++) {
-				try {
-					mTable[row * mNumColumns + col] -= anOffset;
-				} catch (CKException & e) {
-					/*
-					 * At this point we really don't want to throw an
-					 * exception because we said that we'd only do those
-					 * elements where it made sense. So, let's eat this
-					 * exception and trust that it being logged is enough.
-					 */
-				}
-			}
-		}
+	/*
+	 * Next thing is the row count and then the columnn count.
+	 * Get them right off...
+	 */
+	int rowCnt = CKString(code, starts[0], starts[1] - 1 - starts[0]).intValue();
+	int colCnt = CKString(code, starts[1], starts[2] - 1 - starts[1]).intValue();
+	// see if we have enough to fill in this table
+	if ((rowCnt < 0) || (colCnt < 0) ||
+		(chunkCnt < (2 + rowCnt + colCnt + (double)rowCnt * colCnt))) {
+		std::ostringstream	msg;
+		msg << "CKTable::takeValuesFromCode(const CKString &) - the code: '" <<
+			aCode << "' does not represent a valid table encoding. Please check "
+			"on it's source as soon as possible.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	} else {
+		// OK, we have a good size, create the table for this guy
+		createTable( rowCnt, colCnt );
+	}
+
+	/*
+	 * Next, we need to read off the column headers that we need to
+	 * apply to this newly constructed table
+	 */
+	int		bit = 2;
+	mColumnHeadersIndex.clear();
+	mColumnHeadersIndex.reserve(colCnt);
+	for (int j = 0; j < colCnt; j++, bit++) {
+		CKString	header(code, starts[bit], starts[bit + 1] - 1 - starts[bit]);
+		mColumnHeaders[j] = header;
+		mColumnHeadersIndex.put(header, j);
+	}
+
+	/*
+	 * Next, we need to read off the row labels that we need to
+	 * apply to this newly constructed table
+	 */
+	mRowLabelsIndex.clear();
+	mRowLabelsIndex.reserve(rowCnt);
+	for (int i = 0; i < rowCnt; i++, bit++) {
+		CKString	label(code, starts[bit], starts[bit + 1] - 1 - starts[bit]);
+		mRowLabels[i] = label;
+		mRowLabelsIndex.put(label, i);
 	}
 
-	return !error;
+	/*
+	 * Now we get into the actual data for this field.
+	 */
+	CKTableParseTask	task(this, &aCode, &starts, bit);
+	runOnRows(task);
+}
+
+/*
+ * These methods are the binary versions of the two above. The
+ * toBinary() method returns a complete code in the compact binary
+ * format - header and all - and fromBinary() takes one written by
+ * it and replaces what's in this table with it. The codes can
+ * have any bytes in them, so they are std::strings and not CKStrings.
+ */
+std::string CKTable::toBinary() const
+{
+	std::string		buff;
+	CKBinaryWriter	writer(buff);
+	writer.putHeader(eBinaryTableTag);
+	writeBinary(writer);
+	return buff;
 }
 
 
-bool CKTable::subtract( CKTable & anOther )
+void CKTable::fromBinary( const std::string & aCode )
 {
-	bool		error = false;
+	fromBinary(aCode.data(), aCode.size());
+}
 
-	// see if we have anything to do
-	if (!error) {
-		if (mTable == NULL) {
-			error = true;
-			std::ostringstream	msg;
-			msg << "CKTable::subtract(CKTable &) - the main table structure is not where "
-				"it should be and this is a serious data integrity error that needs "
-				"to be looked into as soon as possible.";
-			throw CKException(__FILE__, __LINE__, msg.str());
-		}
-	}
 
-	// see if the sizes are the same - they have to be for this
-	if (!error) {
-		if ((mNumRows != anOther.mNumRows) ||
-			(mNumColumns != anOther.mNumColumns)) {
-			error = true;
-			std::ostringstream	msg;
-			msg << "CKTable::subtract(CKTable &) - this table is " << mNumRows << "x" <<
-				mNumColumns << " and the passed-in table is " << anOther.mNumRows <<
-				"x" << anOther.mNumColumns << " and this mistatch is not allowed for "
-				"the addition operation. Please make sure that the sizes match.";
-			throw CKException(__FILE__, __LINE__, msg.str());
-		}
-	}
+void CKTable::fromBinary( const char *aCode, int aLength )
+{
+	CKBinaryReader	reader(aCode, aLength);
+	reader.getHeader(eBinaryTableTag);
+	readBinary(reader);
+	reader.checkAtEnd();
+}
 
-	// now do the math an element at a time
-	if (!error) {
-		for (int row = 0; row < mNumRows; row++) {
-			for (int col = 0; col < mNumColumns; col++) {
-				try {
-					mTable[row * mNumColumns + col] -= anOther.mTable[row * mNumColumns + col];
-				} catch (CKException & e) {
-					/*
-					 * At this point we really don't want to throw an
-					 * exception because we said that we'd only do those
-					 * elements where it made sense. So, let's eat this
-					 * exception and trust that it being logged is enough.
-					 */
+
+/*
+ * These methods write and read just the table's value - no
+ * header - so that it can be nested in the code of something
+ * bigger. It's laid out like the text code - the row and column
+ * counts, the column headers, the row labels, and then each of
+ * the values in row-major order.
+ */
+void CKTable::writeBinary( CKBinaryWriter & aWriter ) const
+{
+	// an empty table has no rows or columns
+	int		rowCnt = (hasStorage() ? mNumRows : 0);
+	int		colCnt = (hasStorage() ? mNumColumns : 0);
+	aWriter.putUInt(rowCnt);
+	aWriter.putUInt(colCnt);
+	for (int j = 0; j < colCnt; ++j) {
+		aWriter.putString(mColumnHeaders[j]);
+	}
+	for (int i = 0; i < rowCnt; ++i) {
+		aWriter.putString(mRowLabels[i]);
+	}
+	if (mColumns == NULL) {
+		int		cnt = rowCnt * colCnt;
+		for (int i = 0; i < cnt; ++i) {
+			mTable[i].writeBinary(aWriter);
+		}
+	} else {
+		// the dense cells are written just as their CKVariants would be
+		for (int i = 0; i < rowCnt; ++i) {
+			for (int j = 0; j < colCnt; ++j) {
+				const CKTableColumn	& column = mColumns[j];
+				if (column.type == eUnknownVariant) {
+					column.variants[i].writeBinary(aWriter);
+				} else if (!isRowValid(column.valid, i)) {
+					aWriter.putByte(eBinaryUnknownTag);
+				} else if (column.type == eNumberVariant) {
+					aWriter.putByte(eBinaryNumberTag);
+					aWriter.putDouble(column.doubles[i]);
+				} else {
+					aWriter.putByte(eBinaryDateTag);
+					aWriter.putInt((int)column.dates[i]);
 				}
 			}
 		}
 	}
-
-	return !error;
 }
 
 
-bool CKTable::subtract( const CKTable & anOther )
+void CKTable::readBinary( CKBinaryReader & aReader )
 {
-	return subtract((CKTable &)anOther);
+	/*
+	 * Each header, label and value is at least one byte, so the counts
+	 * are checked against what's left before anything is created.
+	 */
+	int		rowCnt = aReader.getCount();
+	int		colCnt = aReader.getCount();
+	if ((rowCnt == 0) || (colCnt == 0)) {
+		dropTable();
+		return;
+	}
+	if ((double)rowCnt * colCnt > aReader.getRemaining()) {
+		std::ostringstream	msg;
+		msg << "CKTable::readBinary(CKBinaryReader &) - the table is said to "
+			"be " << rowCnt << " by " << colCnt << " but there are only " <<
+			aReader.getRemaining() << " bytes left in the code. This is a bad "
+			"or truncated binary code, and needs to be checked.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+	createTable(rowCnt, colCnt);
+
+	// read in the column headers and index them
+	mColumnHeadersIndex.clear();
+	mColumnHeadersIndex.reserve(colCnt);
+	for (int j = 0; j < colCnt; ++j) {
+		aReader.getString(mColumnHeaders[j]);
+		mColumnHeadersIndex.put(mColumnHeaders[j], j);
+	}
+	// ...and then the row labels
+	mRowLabelsIndex.clear();
+	mRowLabelsIndex.reserve(rowCnt);
+	for (int i = 0; i < rowCnt; ++i) {
+		aReader.getString(mRowLabels[i]);
+		mRowLabelsIndex.put(mRowLabels[i], i);
+	}
+
+	// now read the values right into the table
+	int		cnt = rowCnt * colCnt;
+	for (int i = 0; i < cnt; ++i) {
+		mTable[i].readBinary(aReader);
+	}
 }
 
 
+
 /*
- * These method allows the user to multiply a constant value to
- * all elements in the table where such an activity would produce
- * reasonable results. The second form of the method allows for the
- * element-by-element multiplication of the tables.
+ * When this table needs to be resized, a call to this method will
+ * do the trick. It's important to note that all the data that can
+ * survive the change will survive the change. This means that if the
+ * resize is such that the new table is bigger then all the data will
+ * be preserved, but if the new dimensions are smaller than the
+ * current ones then data will be lost.
  */
-bool CKTable::multiply( double aFactor )
+void CKTable::resizeTable( int aNumRows, int aNumColumns )
 {
-	bool		error = false;
-
-	// see if we have anything to do
-	if (!error) {
-		if (mTable == NULL) {
-			error = true;
-			std::ostringstream	msg;
-			msg << "CKTable::multiply(double) - the main table structure is not where "
-				"it should be and this is a serious data integrity error that needs "
-				"to be looked into as soon as possible.";
-			throw CKException(__FILE__, __LINE__, msg.str());
-		}
+	// first, see if we have anything to do - really
+	if ((aNumRows <= 0) || (aNumColumns <= 0)) {
+		std::ostringstream	msg;
+		msg << "CKTable::resizeTable(int, int) - the requested new table "
+			"size of: " << aNumRows << " by " << aNumColumns <<
+			" makes no sense. Please send reasonable values.";
+		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
-	// now do the math an element at a time
-	if (!error) {
-		for (int row = 0; row < mNumRows; row++) {
-			for (int col = 0; col < mNumColumns; col++) {
-				try {
-					mTable[row * mNumColumns + col] *= aFactor;
-				} catch (CKException & e) {
-					/*
-					 * At this point we really don't want to throw an
-					 * exception because we said that we'd only do those
-					 * elements where it made sense. So, let's eat this
-					 * exception and trust that it being logged is enough.
-					 */
-				}
-			}
+	/*
+	 * If it's just more rows, then there's nothing to copy - the rows
+	 * past the end are already empty, and if there aren't enough of
+	 * them, growing like appendRow() does keeps a run of these cheap.
+	 */
+	if (hasStorage() && (aNumColumns == mNumColumns) && (aNumRows >= mNumRows)) {
+		if (aNumRows > mRowCapacity) {
+			growRows(MAX(aNumRows, 2 * mRowCapacity));
 		}
+		mNumRows = aNumRows;
+		return;
 	}
 
-	return !error;
-}
-
-
-bool CKTable::multiply( CKTable & anOther )
-{
-	bool		error = false;
+	/*
+	 * First, we need to create a new, duplicate, table structure of
+	 * the correct size. Then, we'll copy in all the values from the
+	 * existing table that we can, and then drop the old table. Finally,
+	 * we'll set this new table to be the 'current' table.
+	 *
+	 * Nice and simple.
+	 *
+	 * Now we're just going to start ripping through the structure
+	 * and if we run into an allocation problem the system will throw
+	 * an exception for us and we're done. Otherwise, we're going to
+	 * finish what we've started.
+	 */
+	// create the array of values - or columns, if we're columnar
+	CKVariant		*table = NULL;
+	CKTableColumn	*columns = NULL;
+	if (mColumns != NULL) {
+		columns = new CKTableColumn[aNumColumns];
+	} else {
+		table = new CKVariant[aNumRows * aNumColumns];
+	}
+	if ((table == NULL) && (columns == NULL)) {
+		std::ostringstream	msg;
+		msg << "CKTable::resizeTable(int, int) - the array of " <<
+			aNumRows << "x" << aNumColumns << " (" << aNumRows * aNumColumns <<
+			" elements) values could not be created for this new table. "
+			"This is a serious allocation problem.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
 
-	// see if we have anything to do
-	if (!error) {
-		if (mTable == NULL) {
-			error = true;
-			std::ostringstream	msg;
-			msg << "CKTable::multiply(CKTable &) - the main table structure is not where "
-				"it should be and this is a serious data integrity error that needs "
-				"to be looked into as soon as possible.";
-			throw CKException(__FILE__, __LINE__, msg.str());
+	/*
+	 * If we're still here then we need to create the array of CKString
+	 * values that will be the column headers.
+	 */
+	CKLabelIndex	headersIndex;
+	CKString		*headers = new CKString[aNumColumns];
+	if (headers == NULL) {
+		std::ostringstream	msg;
+		msg << "CKTable::resizeTable(int, int) - the array of " <<
+			aNumColumns << " column headers could not be created for this "
+			"new table. This is a serious allocation problem.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	} else {
+		for (int i = 0; i < aNumColumns; i++) {
+			headers[i] = "";
 		}
 	}
 
-	// see if the sizes are the same - they have to be for this
-	if (!error) {
-		if ((mNumRows != anOther.mNumRows) ||
-			(mNumColumns != anOther.mNumColumns)) {
-			error = true;
-			std::ostringstream	msg;
-			msg << "CKTable::multiply(CKTable &) - this table is " << mNumRows << "x" <<
-				mNumColumns << " and the passed-in table is " << anOther.mNumRows <<
-				"x" << anOther.mNumColumns << " and this mistatch is not allowed for "
-				"the addition operation. Please make sure that the sizes match.";
-			throw CKException(__FILE__, __LINE__, msg.str());
+	/*
+	 * If we're still here then we need to create the array of CKString
+	 * values that will be the row labels.
+	 */
+	CKLabelIndex	labelsIndex;
+	CKString		*labels = new CKString[aNumRows];
+	if (labels == NULL) {
+		std::ostringstream	msg;
+		msg << "CKTable::resizeTable(int, int) - the array of " <<
+			aNumRows << " row labels could not be created for this "
+			"new table. This is a serious allocation problem.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	} else {
+		for (int i = 0; i < aNumRows; i++) {
+			labels[i] = "";
 		}
 	}
 
-	// now do the math an element at a time
-	if (!error) {
-		for (int row = 0; row < mNumRows; row++) {
-			for (int col = 0; col < mNumColumns; col++) {
-				try {
-					mTable[row * mNumColumns + col] *= anOther.mTable[row * mNumColumns + col];
-				} catch (CKException & e) {
-					/*
-					 * At this point we really don't want to throw an
-					 * exception because we said that we'd only do those
-					 * elements where it made sense. So, let's eat this
-					 * exception and trust that it being logged is enough.
-					 */
+	/*
+	 * OK, now we need to go through and copy in all the data from the
+	 * current table to this new guy. We have to be careful of the limits
+	 * and don't forget to copy over the column headers and row labels
+	 * too. HOWEVER, make sure that we really have something to do.
+	 */
+	if (hasStorage()) {
+		int		copyCols = MIN(mNumColumns, aNumColumns);
+		int		copyRows = MIN(mNumRows, aNumRows);
+		int		i;
+		int		j;
+		if (columns != NULL) {
+			// the columns keep their types and the new ones are variants
+			for (j = 0; j < aNumColumns; ++j) {
+				if (j < copyCols) {
+					copyColumn(columns[j], mColumns[j], aNumRows, copyRows);
+				} else {
+					allocColumn(columns[j], eUnknownVariant, aNumRows);
+				}
+			}
+		} else {
+			for (i = 0; i < copyRows; ++i) {
+				for (j = 0; j < copyCols; ++j) {
+					table[i * aNumColumns + j] = mTable[i * mNumColumns + j];
 				}
 			}
 		}
+		// ...now the column headers
+		headersIndex.reserve(copyCols);
+		for (i = 0; i < copyCols; ++i) {
+			CKString	& header = mColumnHeaders[i];
+			headers[i] = header;
+			headersIndex.put(header, i);
+		}
+		// ...and finally the row labels
+		labelsIndex.reserve(copyRows);
+		for (j = 0; j < copyRows; ++j) {
+			CKString	& label = mRowLabels[j];
+			labels[j] = label;
+			labelsIndex.put(label, j);
+		}
 	}
 
-	return !error;
-}
-
-
-bool CKTable::multiply( const CKTable & anOther )
-{
-	return multiply((CKTable &)anOther);
+	/*
+	 * If we're still here, then it means that we've created all new
+	 * data structures and it's OK to drop the old table and then set
+	 * all the new values properly. The setters (for the most part)
+	 * take care of the allocation issues. The holdout is the table
+	 * itself which is why we have to drop it first.
+	 */
+	dropTable();
+	mNumRows = aNumRows;
+	mNumColumns = aNumColumns;
+	mRowCapacity = aNumRows;
+	mColumnCapacity = aNumColumns;
+	mTable = table;
+	mColumns = columns;
+	mColumnHeaders = headers;
+	mColumnHeadersIndex = headersIndex;
+	mRowLabels = labels;
+	mRowLabelsIndex = labelsIndex;
 }
 
 
 /*
- * These method allows the user to divide each element in this
- * table by a constant value where such an activity would produce
- * reasonable results. The second form of the method allows for the
- * element-by-element division of the tables.
+ * These methods add one empty row, or column, to the end of the
+ * table and return its index - with the label or header, if one
+ * is given. The table keeps room for more rows than it has, and
+ * when it runs out, that room is doubled, so building a table a
+ * row at a time moves each cell only a couple of times in all. A
+ * columnar table keeps room for more columns the same way, but a
+ * row-major table has to move all its cells to add a column.
  */
-bool CKTable::divide( double aDivisor )
+int CKTable::appendRow()
 {
-	bool		error = false;
-
-	// see if we have anything to do
-	if (!error) {
-		if (mTable == NULL) {
-			error = true;
-			std::ostringstream	msg;
-			msg << "CKTable::divide(double) - the main table structure is not where "
-				"it should be and this is a serious data integrity error that needs "
-				"to be looked into as soon as possible.";
-			throw CKException(__FILE__, __LINE__, msg.str());
-		}
+	// first, make sure we have a table to add to
+	if (!hasStorage()) {
+		std::ostringstream	msg;
+		msg << "CKTable::appendRow() - there is no currently defined table "
+			"structure in this class, so there's nothing to add a row to. "
+			"Please create the table before calling this method.";
+		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
-	// now do the math an element at a time
-	if (!error) {
-		for (int row = 0; row < mNumRows; row++) {
-			for (int col = 0; col < mNumColumns; col++) {
-				try {
-					mTable[row * mNumColumns + col] /= aDivisor;
-				} catch (CKException & e) {
-					/*
-					 * At this point we really don't want to throw an
-					 * exception because we said that we'd only do those
-					 * elements where it made sense. So, let's eat this
-					 * exception and trust that it being logged is enough.
-					 */
-				}
-			}
-		}
+	// the rows past the end are all empty, so we just need one more
+	if (mNumRows == mRowCapacity) {
+		growRows(MAX(2 * mRowCapacity, CKTABLE_MIN_CAPACITY));
 	}
-
-	return !error;
+	return mNumRows++;
 }
 
 
-bool CKTable::divide( CKTable & anOther )
+int CKTable::appendRow( const CKString & aLabel )
 {
-	bool		error = false;
+	int		row = appendRow();
+	mRowLabels[row] = aLabel;
+	mRowLabelsIndex.put(aLabel, row);
+	return row;
+}
 
-	// see if we have anything to do
-	if (!error) {
-		if (mTable == NULL) {
-			error = true;
-			std::ostringstream	msg;
-			msg << "CKTable::divide(CKTable &) - the main table structure is not where "
-				"it should be and this is a serious data integrity error that needs "
-				"to be looked into as soon as possible.";
-			throw CKException(__FILE__, __LINE__, msg.str());
-		}
-	}
 
-	// see if the sizes are the same - they have to be for this
-	if (!error) {
-		if ((mNumRows != anOther.mNumRows) ||
-			(mNumColumns != anOther.mNumColumns)) {
-			error = true;
-			std::ostringstream	msg;
-			msg << "CKTable::divide(CKTable &) - this table is " << mNumRows << "x" <<
-				mNumColumns << " and the passed-in table is " << anOther.mNumRows <<
-				"x" << anOther.mNumColumns << " and this mistatch is not allowed for "
-				"the addition operation. Please make sure that the sizes match.";
-			throw CKException(__FILE__, __LINE__, msg.str());
-		}
+int CKTable::appendColumn()
+{
+	// first, make sure we have a table to add to
+	if (!hasStorage()) {
+		std::ostringstream	msg;
+		msg << "CKTable::appendColumn() - there is no currently defined table "
+			"structure in this class, so there's nothing to add a column to. "
+			"Please create the table before calling this method.";
+		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
-	// now do the math an element at a time
-	if (!error) {
-		for (int row = 0; row < mNumRows; row++) {
-			for (int col = 0; col < mNumColumns; col++) {
-				try {
-					mTable[row * mNumColumns + col] /= anOther.mTable[row * mNumColumns + col];
-				} catch (CKException & e) {
-					/*
-					 * At this point we really don't want to throw an
-					 * exception because we said that we'd only do those
-					 * elements where it made sense. So, let's eat this
-					 * exception and trust that it being logged is enough.
-					 */
-				}
+	if (mNumColumns == mColumnCapacity) {
+		growColumns(MAX(2 * mColumnCapacity, CKTABLE_MIN_CAPACITY));
+	}
+	if (mColumns != NULL) {
+		// a new column of CKVariants, just like resizeTable() makes
+		allocColumn(mColumns[mNumColumns], eUnknownVariant, mRowCapacity);
+	} else {
+		/*
+		 * The row-major array is exactly mNumColumns across, so every
+		 * row moves over by one. The cells are swapped into the new
+		 * array so none of them are copied.
+		 */
+		int			cols = mNumColumns + 1;
+		CKVariant	*table = new CKVariant[mRowCapacity * cols];
+		for (int i = 0; i < mNumRows; ++i) {
+			for (int j = 0; j < mNumColumns; ++j) {
+				table[i * cols + j].swap(mTable[i * mNumColumns + j]);
 			}
 		}
+		delete [] mTable;
+		mTable = table;
 	}
+	return mNumColumns++;
+}
 
-	return !error;
+
+int CKTable::appendColumn( const CKString & aHeader )
+{
+	int		col = appendColumn();
+	mColumnHeaders[col] = aHeader;
+	mColumnHeadersIndex.put(aHeader, col);
+	return col;
 }
 
 
-bool CKTable::divide( const CKTable & anOther )
+/*
+ * This method makes room for 'aNumRows' rows in all, so that rows
+ * can be appended up to that many without anything being moved.
+ * The number of rows in the table isn't changed. The capacity is
+ * the number of rows there's room for right now.
+ */
+void CKTable::reserveRows( int aNumRows )
 {
-	return divide((CKTable &)anOther);
+	// first, make sure we have a table to make room in
+	if (!hasStorage()) {
+		std::ostringstream	msg;
+		msg << "CKTable::reserveRows(int) - there is no currently defined "
+			"table structure in this class, so there's nothing to make room "
+			"in. Please create the table before calling this method.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	if (aNumRows > mRowCapacity) {
+		growRows(aNumRows);
+	}
+}
+
+
+int CKTable::getRowCapacity() const
+{
+	return mRowCapacity;
 }
 
 
 /*
- * This method simply takes the inverse of each value in the table
- * so that x -> 1/x for all points. This is marginally useful
- * I'm thinking, but I added it here to be a little more complete.
+ * This method checks to see if the two CKTables are equal to one
+ * another based on the values they represent and *not* on the actual
+ * pointers themselves. If they are equal, then this method returns a
+ * value of true, otherwise, it returns a false.
  */
-bool CKTable::inverse()
+bool CKTable::operator==( const CKTable & anOther ) const
 {
-	bool		error = false;
+	bool		equal = true;
 
-	// see if we have anything to do
-	if (!error) {
-		if (mTable == NULL) {
-			error = true;
-			std::ostringstream	msg;
-			msg << "CKTable::inverse() - the main table structure is not where "
-				"it should be and this is a serious data integrity error that needs "
-				"to be looked into as soon as possible.";
-			throw CKException(__FILE__, __LINE__, msg.str());
+	// first, see if the sizes match
+	if ((mNumRows != anOther.mNumRows) ||
+		(mNumColumns != anOther.mNumColumns)) {
+		equal = false;
+	}
+
+	// check the row labels
+	if (equal) {
+		for (int i = 0; equal && (i < mNumRows); i++) {
+			if (mRowLabels[i] != anOther.mRowLabels[i]) {
+				equal = false;
+				break;
+			}
 		}
 	}
 
-	// now invert each element in the table skipping problems
-	if (!error) {
-		for (int row = 0; row < mNumRows; row++) {
-			for (int col = 0; col < mNumColumns; col++) {
-				try {
-					mTable[row * mNumColumns + col].inverse();
-				} catch (CKException & e) {
-					/*
-					 * At this point we really don't want to throw an
-					 * exception because we said that we'd only do those
-					 * elements where it made sense. So, let's eat this
-					 * exception and trust that it being logged is enough.
-					 */
-				}
+	// check the column headers
+	if (equal) {
+		for (int i = 0; equal && (i < mNumColumns); i++) {
+			if (mColumnHeaders[i] != anOther.mColumnHeaders[i]) {
+				equal = false;
+				break;
 			}
 		}
 	}
 
-	return !error;
+	// now, see if ALL the values match - an empty table has none
+	if (equal && hasStorage() && anOther.hasStorage()) {
+		CKTableCompareTask	task(this, &anOther);
+		runOnRows(task);
+		equal = !task.differs();
+	}
+
+	return equal;
 }
 
 
 /*
- * These are the operator equivalents of the simple mathematical
- * operations on the table. They are here as an aid to the
- * developer of analytic functions based on these guys.
+ * This method checks to see if the two CKTables are not equal to
+ * one another based on the values they represent and *not* on the
+ * actual pointers themselves. If they are not equal, then this method
+ * returns true, otherwise it returns false.
  */
-CKTable & CKTable::operator+=( double anOffset )
+bool CKTable::operator!=( const CKTable & anOther ) const
 {
-	add(anOffset);
-	return *this;
+	return !(this->operator==(anOther));
 }
 
 
-CKTable & CKTable::operator+=( CKTable & aTable )
+/*
+ * To make it a little easier on the user of this table, I have
+ * created these operators so that elements in the table can be
+ * referenced like simply indexes: tbl(0,5) - for both the RHS
+ * and LHS of the equation. This requires the CKVariant to handle
+ * a lot of the work, but that's not horrible, really.
+ */
+CKVariant & CKTable::operator()( int aRow, int aCol )
 {
-	add(aTable);
-	return *this;
+	return getValue(aRow, aCol);
 }
 
 
-CKTable & CKTable::operator+=( const CKTable & aTable )
+CKVariant & CKTable::operator()( int aRow, const CKString & aColHeader )
 {
-	add((CKTable &)aTable);
-	return *this;
+	return getValue(aRow, aColHeader);
 }
 
 
-CKTable & CKTable::operator-=( double anOffset )
+CKVariant & CKTable::operator()( const CKString & aRowLabel, int aCol )
 {
-	subtract(anOffset);
-	return *this;
+	return getValue(aRowLabel, aCol);
 }
 
 
-CKTable & CKTable::operator-=( CKTable & aTable )
+CKVariant & CKTable::operator()( const CKString & aRowLabel, const CKString & aColHeader )
 {
-	subtract(aTable);
-	return *this;
+	return getValue(aRowLabel, aColHeader);
 }
 
 
-CKTable & CKTable::operator-=( const CKTable & aTable )
+/*
+ * Because there are times when it's useful to have a nice
+ * human-readable form of the contents of this table. Most of the
+ * time this means that it's used for debugging, but it could be used
+ * for just about anything. In these cases, it's nice not to have to
+ * worry about the ownership of the representation, so this returns
+ * a CKString.
+ */
+CKString CKTable::toString() const
 {
-	subtract((CKTable &)aTable);
-	return *this;
+	CKString		retval = "";
+
+	// make sure we have something to show...
+	if ((mNumRows > 0) && (mNumColumns > 0) && hasStorage()) {
+		CKVariant	scratch;
+		// first, put out the column headers
+		retval += "\t";
+		for (int j = 0; j < mNumColumns; j++) {
+			retval += (j == 0 ? "" : "\t");
+			retval += mColumnHeaders[j];
+		}
+		retval += "\n";
+
+		// now put out the data in the table
+		for (int i = 0; i < mNumRows; i++) {
+			// slap the row label first
+			retval += mRowLabels[i] + "\t";
+			// ...and then the rest of the data for the row
+			for (int j = 0; j < mNumColumns; j++) {
+				retval += (j == 0 ? "" : "\t");
+				retval += readCell(i, j, scratch).toString();
+			}
+			retval += "\n";
+		}
+	}
+
+	return retval;
 }
 
 
-CKTable & CKTable::operator*=( double aFactor )
+/********************************************************
+ *
+ *               Text/String Parsing Methods
+ *
+ ********************************************************/
+/*
+ * This method is used in the creation of the encoded strings that
+ * assist in the translation of the objects from the C++ to Java
+ * environments. Basically, the CKString buffer that's passed in
+ * contains delimiters that are '\x01' but that need to be changed
+ * to a printable ASCII character. This method scans the entire
+ * string for the presence of delimiters and then selects one
+ * character that's not used in the string and replaces all the
+ * "placeholder" delimiters with this value and returns. If it was
+ * impossible to find a delimiter, this method will return false
+ * otherwise it will return true.
+ */
+bool CKTable::chooseAndApplyDelimiter( CKString & aBuff )
 {
-	multiply(aFactor);
-	return *this;
-}
+	bool	error = false;
+
+	// first, see if we have anything to do
+	if (!error) {
+		if (aBuff.empty()) {
+			error = true;
+			throw CKException(__FILE__, __LINE__, "CKTable::chooseAndApplyDelimiter"
+				"(char *) - the passed-in buffer is empty and that means that "
+				"there's nothing I can do. Please make sure that the argument to "
+				"this method is not empty before calling.");
+		}
+	}
 
+	/*
+	 * Let's check each of the possible delimiters in turn, and if
+	 * one passes, then let's flag that and we can replace it next.
+	 */
+	if (!error) {
+		bool	replaced = false;
+		// these are out list of possible delimiters in a reasonable order
+		const char	*delimiters = ";|!~`_@#^*/'=.+-<>[]{}1234567890abcde";
+		int		passCnt = (int)strlen(delimiters);
+		// check each and replace if it's not found
+		for (int pass = 0; pass < passCnt; ++pass) {
+			if (aBuff.find(delimiters[pass]) == -1) {
+				aBuff.replace('\x01', delimiters[pass]);
+				replaced = true;
+				break;
+			}
+		}
+		// see if we failed
+		if (!replaced) {
+			error = true;
+			throw CKException(__FILE__, __LINE__, "CKTable::chooseAndApplyDelimiter"
+				"(char *) - while trying to find an acceptable delimiter for the "
+				"data in this string we ran out of possibles before finding one "
+				"that wasn't being used in the text of the code. This is a serious "
+				"problem that the developers need to look into.");
+		}
+	}
 
-CKTable & CKTable::operator/=( double aDivisor )
-{
-	divide(aDivisor);
-	return *this;
+	return !error;
 }
 
 
-/********************************************************
- *
- *                Utility Methods
- *
- ********************************************************/
 /*
- * This method returns a copy of the current value as contained in
- * a string. This is returned as a CKString as it's easy to use.
+ * This method sets the datastructure of the array of arrays of
+ * pointers of CKVariants to the proper location in this class
+ * instance so that it's safe to use. This is not something most
+ * users need to use, so it's protected, but because we like to
+ * stick with setters and getters, this is here for this class'
+ * code. This method assumes that the passed in variable was
+ * created for this class. No copy is made, but control of the
+ * deallocation of this guy will now become the job of this
+ * instance and the caller is absolved of any responsibility there.
  */
-CKString CKTable::getValueAsString( int aRow, int aCol ) const
+void CKTable::setTable( CKVariant *aTable )
 {
-	// first, make sure we have a place to put this data
-	if ((aRow < 0) || (aRow >= mNumRows) ||
-		(aCol < 0) || (aCol >= mNumColumns)) {
-		std::ostringstream	msg;
-		msg << "CKTable::getValueAsString(int, int) - the provided "
-			"location: " << aRow << ", " << aCol << " lies outside the currently "
-			"defined table: " << mNumRows << " by " << mNumColumns;
-		throw CKException(__FILE__, __LINE__, msg.str());
+	dropColumns();
+	if (mTable != NULL) {
+		delete [] mTable;
+		mTable = NULL;
 	}
-	// ...and that we have a table structure that matches
-	if (mTable == NULL) {
-		std::ostringstream	msg;
-		msg << "CKTable::getValueAsString(int, int) - there is no "
-			"currently defined table structure in this class. This is a "
-			"serious data integrity problem that needs to be looked into.";
-		throw CKException(__FILE__, __LINE__, msg.str());
+	if (aTable != NULL) {
+		mTable = aTable;
 	}
-
-	// now get what they are looking for
-	return mTable[aRow * mNumColumns + aCol].getValueAsString();
+	// the new array is taken to be just the size of the table
+	mRowCapacity = MAX(mNumRows, 0);
+	mColumnCapacity = MAX(mNumColumns, 0);
 }
 
 
-CKString CKTable::getValueAsString( int aRow, const CKString & aColHeader ) const
+/*
+ * This method sets an array of CKString values to be the column
+ * headers for the current table. It's important to note that there
+ * needs to be getNumColumns() of them and it won't be checked, so...
+ * this class will take care of making sure they are there, and it's
+ * probably best to let this class to this.
+ */
+void CKTable::setColumnHeaders( const CKStringList & aList )
 {
-	// convert the column header to a column index
-	int		col = getColumnForHeader(aColHeader);
-	if (col < 0) {
+	// first, check to see that we have something to do
+	if (aList.size() != mNumColumns) {
 		std::ostringstream	msg;
-		msg << "CKTable::getValueAsString(int, const CKString &) "
-			"- there is no currently defined column header '" << aColHeader <<
-			"' please make sure the column headers are properly defined.";
+		msg << "CKTable::setColumnHeaders(const CKStringList &) - "
+			"the passed-in vector of strings did not contain " << mNumColumns <<
+			" elements which is the number of headers in this table. Please make "
+			"sure the data matches before setting.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
-	// then call the index-based method
-	return getValueAsString(aRow, col);
+	// now copy in all the values
+	for (int i = 0; i < mNumColumns; i++) {
+		CKString	& header = aList[i];
+		mColumnHeaders[i] = header;
+		mColumnHeadersIndex.put(header, i);
+	}
 }
 
 
-CKString CKTable::getValueAsString( const CKString & aRowLabel, int aCol ) const
+/*
+ * This method sets an array of CKString values to be the row
+ * labels for the current table. It's important to note that there
+ * needs to be getNumRows() of them and it won't be checked, so...
+ * this class will take care of making sure they are there, and it's
+ * probably best to let this class to this.
+ */
+void CKTable::setRowLabels( const CKStringList & aList )
 {
-	// convert the row label to a row index
-	int		row = getRowForLabel(aRowLabel);
-	if (row < 0) {
+	// first, check to see that we have something to do
+	if (aList.size() != mNumRows) {
 		std::ostringstream	msg;
-		msg << "CKTable::getValueAsString(const CKString &, int) "
-			"- there is no currently defined row label '" << aRowLabel <<
-			"' please make sure the row labels are properly defined.";
+		msg << "CKTable::setRowLabels(const CKStringList &) - "
+			"the passed-in vector of strings did not contain " << mNumRows <<
+			" elements which is the number of labels in this table. Please make "
+			"sure the data matches before setting.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
-	// then call the index-based method
-	return getValueAsString(row, aCol);
+	// now copy in all the values
+	for (int i = 0; i < mNumRows; i++) {
+		CKString	& label = aList[i];
+		mRowLabels[i] = label;
+		mRowLabelsIndex.put(label, i);
+	}
 }
 
 
-CKString CKTable::getValueAsString( const CKString & aRowLabel, const CKString & aColHeader ) const
+/*
+ * This method is really here to encapsulate the number of rows
+ * that this data source represents. Since it's possible to have
+ * the data and these sizes not match, special care should be
+ * taken to ensure that the data is consistent.
+ */
+void CKTable::setNumRows( int aCount )
 {
-	// convert the row label to a row index
-	int		row = getRowForLabel(aRowLabel);
-	if (row < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::getValueAsString(const CKString &, const CKString &) "
-			"- there is no currently defined row label '" << aRowLabel <<
-			"' please make sure the row labels are properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
-
-	// convert the column header to a column index
-	int		col = getColumnForHeader(aColHeader);
-	if (col < 0) {
-		std::ostringstream	msg;
-		msg << "CKTable::getValueAsString(const CKString &, const CKString &) "
-			"- there is no currently defined column header '" << aColHeader <<
-			"' please make sure the column headers are properly defined.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	}
-
-	// then call the index-based method
-	return getValueAsString(row, col);
+	mNumRows = aCount;
+	// there's no telling what's past the end now, so don't count on it
+	mRowCapacity = aCount;
 }
 
 
 /*
- * In order to simplify the move of this object from C++ to Java
- * it makes sense to encode the table's data into a (char *) that
- * can be converted to a Java String and then the Java object can
- * interpret it and "reconstitue" the object from this coding.
+ * This method is really here to encapsulate the number of columns
+ * that this data source represents. Since it's possible to have
+ * the data and these sizes not match, special care should be
+ * taken to ensure that the data is consistent.
  */
-CKString CKTable::generateCodeFromValues() const
+void CKTable::setNumColumns( int aCount )
 {
-	/*
-	 * OK... this is interesting because I happen to like the idea
-	 * that Bloomberg had for delimiting the data - have the first
-	 * character be the delimiter for the entire string. The trick
-	 * is that we'll generate the terminated string with a placeholder
-	 * and then see what character we can place in the string as the
-	 * delimiter that's from our list of accecptable values. It's
-	 * interesting and pretty fun.
-	 */
-
-	// start by getting a buffer to build up this value
-	CKString buff;
+	mNumColumns = aCount;
+	mColumnCapacity = aCount;
+}
 
-	// first, send out the row and column counts
-	buff.append("\x01").append(mNumRows).append("\x01").append(mNumColumns).
-		append("\x01");
 
-	// next, loop over all the column headers and write them out as well
-	for (int j = 0; j < mNumColumns; ++j) {
-		buff.append(mColumnHeaders[j]).append("\x01");
-	}
+/*
+ * This method returns the array of CKVariants that comprises the
+ * table's row-major data storage so that it can be used in this
+ * class. In general, this is a dangerous thing, and it needs to
+ * be used carefully, but it's important as we're trying to stick
+ * to using just the setters and getters. This method returns a
+ * pointer to the actual data and sould therefore be used very
+ * carefully as it could change underneath the caller if they aren't
+ * careful.
+ */
+CKVariant *CKTable::getTable() const
+{
+	return mTable;
+}
 
-	// next, loop over all the row labels and write them out as well
-	for (int j = 0; j < mNumRows; ++j) {
-		buff.append(mRowLabels[j]).append("\x01");
-	}
 
-	// now loop over the data and write it all out in an easy manner
-	int		cnt = mNumRows * mNumColumns;
-	for (int i = 0; i < cnt; ++i)  {
-		buff.append(mTable[i].generateCodeFromValues()).append("\x01");
-	}
+/*
+ * This method returns the actual array of CKString values that
+ * are the column headers for this table. The number of elements
+ * in the array is given my getNumColumns() and if the user wants
+ * to have this list outside the scopr of this class they need to
+ * make a copy of it and that includes all the strings in it.
+ */
+const CKString *CKTable::getColumnHeaders() const
+{
+	return mColumnHeaders;
+}
 
-	/*
-	 * OK, it's now in a simple character array that we can scan to check
-	 * for acceptable delimiter values. What we'll do is to check the string
-	 * for the existence of a series of possible delimiters, and as soon as
-	 * we find one that's not used in the string we'll use that guy.
-	 */
-	if (!chooseAndApplyDelimiter(buff)) {
-		throw CKException(__FILE__, __LINE__, "CKTable::generateCodeFrom"
-			"Values() - while trying to find an acceptable delimiter for "
-			"the data in the table we ran out of possibles before finding "
-			"one that wasn't being used in the text of the code. This is "
-			"a serious problem that the developers need to look into.");
-	}
 
-	return buff;
+/*
+ * This method returns the actual array of CKString values that
+ * are the row labels for this table. The number of elements
+ * in the array is given my getNumRows() and if the user wants
+ * to have this list outside the scopr of this class they need to
+ * make a copy of it and that includes all the strings in it.
+ */
+const CKString *CKTable::getRowLabels() const
+{
+	return mRowLabels;
 }
 
 
 /*
- * This method takes a code that could have been written with the
- * generateCodeFromValues() method on either the C++ or Java
- * versions of this class and extracts all the values from the code
- * that are needed to populate this table. The argument is left
- * untouched, and is the responsible of the caller to free.
+ * For debugging purposes, let's make it easy for the user to stream
+ * out this value. It basically is just the value of toString() which
+ * will indicate the data type and the value.
  */
-void CKTable::takeValuesFromCode( const CKString & aCode )
+std::ostream & operator<<( std::ostream & aStream, const CKTable & aTable )
 {
-	// first, see if we have anything to do
-	if (aCode.empty()) {
-		throw CKException(__FILE__, __LINE__, "CKTable::takeValuesFromCode("
-			"const CKString &) - the passed-in code is empty which means that "
-			"there's nothing I can do. Please make sure that the argument is "
-			"not empty before calling this method.");
-	}
+	aStream << aTable.toString();
 
-	/*
-	 * The data is character-delimited and the delimiter is
-	 * the first character of the field data. All subsequent
-	 * values will be delimited by this character. We need to
-	 * get it.
-	 */
-	char	delim = aCode[0];
-	// ...and parse this guy into chunks
-	int		bit = 0;
-	CKStringList	chunks = CKStringList::parseIntoChunks(
-									aCode.substr(1, aCode.size()-2), delim);
-	if (chunks.size() < 3) {
+	return aStream;
+}
+
+
+/********************************************************
+ *
+ *                Private Allocation Methods
+ *
+ ********************************************************/
+/*
+ * This private method takes care of dealing with the intelligent
+ * allocation of the table's data. It's not all that complex, but
+ * it's nice to have it in one place that's insulated from all the
+ * other methods in this class. This method will throw an exception
+ * if the number of rows and/or columns make no sense, or if there's
+ * an error in the allocation of the storage.
+ */
+void CKTable::createTable( int aNumRows, int aNumColumns, bool aColumnar )
+{
+	// first, see if we have anything to do - really
+	if ((aNumRows <= 0) || (aNumColumns <= 0)) {
 		std::ostringstream	msg;
-		msg << "CKTable::takeValuesFromCode(const CKString &) - the code: '" <<
-			aCode << "' does not represent a valid table encoding. Please check "
-			"on it's source as soon as possible.";
+		msg << "CKTable::createTable(int, int, bool) - the requested table "
+			"size of: " << aNumRows << " by " << aNumColumns <<
+			" makes no sense. Please send reasonable values.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
+	// next, make sure that we drop what might already be there
+	dropTable();
+
 	/*
-	 * Next thing is the row count and then the columnn count.
-	 * Get them right off...
+	 * Now we're just going to start ripping through the structure
+	 * and if we run into an allocation problem the system will throw
+	 * an exception for us and we're done. Otherwise, we're going to
+	 * finish what we've started.
 	 */
-	int rowCnt = chunks[bit++].intValue();
-	int colCnt = chunks[bit++].intValue();
-	// see if we have enough to fill in this table
-	if (chunks.size() < (2 + rowCnt + colCnt + rowCnt * colCnt)) {
+	if (aColumnar) {
+		mColumns = new CKTableColumn[aNumColumns];
+	} else {
+		mTable = new CKVariant[aNumRows * aNumColumns];
+	}
+	if (!hasStorage()) {
 		std::ostringstream	msg;
-		msg << "CKTable::takeValuesFromCode(const CKString &) - the code: '" <<
-			aCode << "' does not represent a valid table encoding. Please check "
-			"on it's source as soon as possible.";
+		msg << "CKTable::createTable(int, int, bool) - the array of " <<
+			aNumRows << "x" << aNumColumns << " (" << aNumRows*aNumColumns <<
+			" elements) values could not be created for this table. "
+			"This is a serious allocation problem.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	} else {
-		// OK, we have a good size, create the table for this guy
-		createTable( rowCnt, colCnt );
-	}
-
-	/*
-	 * Next, we need to read off the column headers that we need to
-	 * apply to this newly constructed table
-	 */
-	mColumnHeadersIndex.clear();
-	for (int j = 0; j < colCnt; j++) {
-		CKString	& header = chunks[bit++];
-		mColumnHeaders[j] = header;
-		mColumnHeadersIndex[header] = j;
+		/*
+		 * If we're still here, then it means that we've allocated all the
+		 * storage and it's OK to set the size as we've created it.
+		 */
+		mNumRows = aNumRows;
+		mNumColumns = aNumColumns;
+		mRowCapacity = aNumRows;
+		mColumnCapacity = aNumColumns;
 	}
 
 	/*
-	 * Next, we need to read off the row labels that we need to
-	 * apply to this newly constructed table
+	 * If we're still here then we need to create the array of CKString
+	 * values that will be the column headers.
 	 */
-	mRowLabelsIndex.clear();
-	for (int i = 0; i < rowCnt; i++) {
-		CKString	& label = chunks[bit++];
-		mRowLabels[i] = label;
-		mRowLabelsIndex[label] = i;
+	mColumnHeaders = new CKString[mNumColumns];
+	if (mColumnHeaders == NULL) {
+		std::ostringstream	msg;
+		msg << "CKTable::createTable(int, int, bool) - the array of " <<
+			mNumColumns << " column headers could not be created for this "
+			"new table. This is a serious allocation problem.";
+		throw CKException(__FILE__, __LINE__, msg.str());
 	}
+	// clear out the index of these column headers
+	mColumnHeadersIndex.clear();
 
 	/*
-	 * Now we get into the actual data for this field.
+	 * If we're still here then we need to create the array of CKString
+	 * values that will be the row labels.
 	 */
-	int		cnt = rowCnt * colCnt;
-	for (int i = 0; i < cnt; i++)  {
-		mTable[i].takeValuesFromCode(chunks[bit++]);
+	mRowLabels = new CKString[mNumRows];
+	if (mRowLabels == NULL) {
+		std::ostringstream	msg;
+		msg << "CKTable::createTable(int, int, bool) - the array of " <<
+			mNumRows << " row labels could not be created for this "
+			"new table. This is a serious allocation problem.";
+		throw CKException(__FILE__, __LINE__, msg.str());
 	}
+	// clear out the index of these row labels
+	mRowLabelsIndex.clear();
 }
 
 
 /*
- * When this table needs to be resized, a call to this method will
- * do the trick. It's important to note that all the data that can
- * survive the change will survive the change. This means that if the
- * resize is such that the new table is bigger then all the data will
- * be preserved, but if the new dimensions are smaller than the
- * current ones then data will be lost.
+ * This private method takes care of dealing with the intelligent
+ * allocation of the table's data. It's not all that complex, but
+ * it's nice to have it in one place that's insulated from all the
+ * other methods in this class. This method will throw an exception
+ * if the number of row labels or column headers make no sense, or
+ * if there's an error in the allocation of the storage.
  */
-void CKTable::resizeTable( int aNumRows, int aNumColumns )
+void CKTable::createTable( const CKStringList & aRowLabels,
+						   const CKStringList & aColHeaders )
 {
 	// first, see if we have anything to do - really
-	if ((aNumRows <= 0) || (aNumColumns <= 0)) {
+	if (aRowLabels.empty() || aColHeaders.empty()) {
 		std::ostringstream	msg;
-		msg << "CKTable::resizeTable(int, int) - the requested new table "
-			"size of: " << aNumRows << " by " << aNumColumns <<
-			" makes no sense. Please send reasonable values.";
+		msg << "CKTable::createTable(const CKStringList &, "
+			"const CKStringList &) - the requested table "
+			"size makes no sense. Please send non-empty lists.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
+	// next, make sure that we drop what might already be there
+	dropTable();
+
+	// now let's get the row labels, column headers and sizes
+	mNumRows = aRowLabels.size();
+	mNumColumns = aColHeaders.size();
+	mRowCapacity = mNumRows;
+	mColumnCapacity = mNumColumns;
+
 	/*
-	 * First, we need to create a new, duplicate, table structure of
-	 * the correct size. Then, we'll copy in all the values from the
-	 * existing table that we can, and then drop the old table. Finally,
-	 * we'll set this new table to be the 'current' table.
-	 *
-	 * Nice and simple.
-	 *
-	 * Now we're just going to start ripping through the structure
-	 * and if we run into an allocation problem the system will throw
-	 * an exception for us and we're done. Otherwise, we're going to
-	 * finish what we've started.
+	 * Now we just make what we need and if it fails back this out.
 	 */
-	// create the array of row pointers
-	CKVariant	*table = new CKVariant[aNumRows * aNumColumns];
-	if (table == NULL) {
+	mTable = new CKVariant[mNumRows * mNumColumns];
+	if (mTable == NULL) {
+		// clear out what we've already set
+		dropTable();
+		// ...and then throw the exception
 		std::ostringstream	msg;
-		msg << "CKTable::resizeTable(int, int) - the array of " <<
-			aNumRows << "x" << aNumColumns << " (" << aNumRows * aNumColumns <<
-			" elements) values could not be created for this new table. "
+		msg << "CKTable::createTable(const CKStringList &, "
+			"const CKStringList &) - the array of " <<
+			mNumRows << "x" << mNumColumns << " (" << mNumRows*mNumColumns <<
+			" elements) values could not be created for this table. "
 			"This is a serious allocation problem.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
@@ -3263,17 +6649,23 @@ void CKTable::resizeTable( int aNumRows, int aNumColumns )
 	 * If we're still here then we need to create the array of CKString
 	 * values that will be the column headers.
 	 */
-	std::map<CKString, int>		headersIndex;
-	CKString		*headers = new CKString[aNumColumns];
-	if (headers == NULL) {
+	mColumnHeaders = new CKString[mNumColumns];
+	if (mColumnHeaders == NULL) {
 		std::ostringstream	msg;
-		msg << "CKTable::resizeTable(int, int) - the array of " <<
-			aNumColumns << " column headers could not be created for this "
+		msg << "CKTable::createTable(const CKStringList &, "
+			"const CKStringList &) - the array of " <<
+			mNumColumns << " column headers could not be created for this "
 			"new table. This is a serious allocation problem.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	} else {
-		for (int i = 0; i < aNumColumns; i++) {
-			headers[i] = "";
+		// clear out the existing index of column headers
+		mColumnHeadersIndex.clear();
+		mColumnHeadersIndex.reserve(mNumColumns);
+		// now populate the new headers from the list
+		for (int i = 0; i < mNumColumns; i++) {
+			CKString	& header = aColHeaders[i];
+			mColumnHeaders[i] = header;
+			mColumnHeadersIndex.put(header, i);
 		}
 	}
 
@@ -3281,630 +6673,848 @@ void CKTable::resizeTable( int aNumRows, int aNumColumns )
 	 * If we're still here then we need to create the array of CKString
 	 * values that will be the row labels.
 	 */
-	std::map<CKString, int>		labelsIndex;
-	CKString		*labels = new CKString[aNumRows];
-	if (labels == NULL) {
+	mRowLabels = new CKString[mNumRows];
+	if (mRowLabels == NULL) {
 		std::ostringstream	msg;
-		msg << "CKTable::resizeTable(int, int) - the array of " <<
-			aNumRows << " row labels could not be created for this "
+		msg << "CKTable::createTable(const CKStringList &, "
+			"const CKStringList &) - the array of " <<
+			mNumRows << " row labels could not be created for this "
 			"new table. This is a serious allocation problem.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	} else {
-		for (int i = 0; i < aNumRows; i++) {
-			labels[i] = "";
-		}
-	}
-
-	/*
-	 * OK, now we need to go through and copy in all the data from the
-	 * current table to this new guy. We have to be careful of the limits
-	 * and don't forget to copy over the column headers and row labels
-	 * too. HOWEVER, make sure that we really have something to do.
-	 */
-	if (mTable != NULL) {
-		int		copyCols = MIN(mNumColumns, aNumColumns);
-		int		copyRows = MIN(mNumRows, aNumRows);
-		int		i;
-		int		j;
-		for (i = 0; i < copyRows; ++i) {
-			for (j = 0; j < copyCols; ++j) {
-				table[i * aNumColumns + j] = mTable[i * mNumColumns + j];
-			}
-		}
-		// ...now the column headers
-		for (i = 0; i < copyCols; ++i) {
-			CKString	& header = mColumnHeaders[i];
-			headers[i] = header;
-			headersIndex[header] = i;
-		}
-		// ...and finally the row labels
-		for (j = 0; j < copyRows; ++j) {
-			CKString	& label = mRowLabels[j];
-			labels[j] = label;
-			labelsIndex[label] = j;
+		// clear out the existing index of row labels
+		mRowLabelsIndex.clear();
+		mRowLabelsIndex.reserve(mNumRows);
+		// now populate the new labels from the list
+		for (int i = 0; i < mNumRows; i++) {
+			CKString	& label = aRowLabels[i];
+			mRowLabels[i] = label;
+			mRowLabelsIndex.put(label, i);
 		}
 	}
-
-	/*
-	 * If we're still here, then it means that we've created all new
-	 * data structures and it's OK to drop the old table and then set
-	 * all the new values properly. The setters (for the most part)
-	 * take care of the allocation issues. The holdout is the table
-	 * itself which is why we have to drop it first.
-	 */
-	dropTable();
-	mNumRows = aNumRows;
-	mNumColumns = aNumColumns;
-	mTable = table;
-	mColumnHeaders = headers;
-	mColumnHeadersIndex = headersIndex;
-	mRowLabels = labels;
-	mRowLabelsIndex = labelsIndex;
 }
 
 
 /*
- * This method checks to see if the two CKTables are equal to one
- * another based on the values they represent and *not* on the actual
- * pointers themselves. If they are equal, then this method returns a
- * value of true, otherwise, it returns a false.
+ * This private method takes care of dealing with the careful
+ * deallocation of the pointers of pointers of pointers. It's not all
+ * that complex, but it's nice to have it in one place that's
+ * insulated from all the other methods in this class.
  */
-bool CKTable::operator==( const CKTable & anOther ) const
+void CKTable::dropTable()
 {
-	bool		equal = true;
-
-	// first, see if the sizes match
-	if ((mNumRows != anOther.mNumRows) ||
-		(mNumColumns != anOther.mNumColumns)) {
-		equal = false;
-	}
-
-	// check the row labels
-	if (equal) {
-		for (int i = 0; equal && (i < mNumRows); i++) {
-			if (mRowLabels[i] != anOther.mRowLabels[i]) {
-				equal = false;
-				break;
-			}
-		}
+	// first, see if we have anything to do
+	if (mTable != NULL) {
+		delete [] mTable;
+		mTable = NULL;
 	}
+	// ...and the columns, if we're columnar
+	dropColumns();
 
-	// check the column headers
-	if (equal) {
-		for (int i = 0; equal && (i < mNumColumns); i++) {
-			if (mColumnHeaders[i] != anOther.mColumnHeaders[i]) {
-				equal = false;
-				break;
-			}
-		}
+	// also drop the array of column headers
+	if (mColumnHeaders != NULL) {
+		delete [] mColumnHeaders;
+		mColumnHeaders = NULL;
 	}
-
-	// now, see if ALL the values match
-	if (equal) {
-		int		cnt = mNumRows * mNumColumns;
-		for (int i = 0; equal && (i < cnt); i++) {
-			if (mTable[i] != anOther.mTable[i]) {
-				equal = false;
-				break;
-			}
-		}
+	// ...and clear out the index
+	mColumnHeadersIndex.clear();
+
+	// ...and the array of row labels
+	if (mRowLabels != NULL) {
+		delete [] mRowLabels;
+		mRowLabels = NULL;
 	}
+	// ...and clear out the index
+	mRowLabelsIndex.clear();
 
-	return equal;
+	// also, set the size to 'undefined'
+	mNumRows = -1;
+	mNumColumns = -1;
+	mRowCapacity = 0;
+	mColumnCapacity = 0;
 }
 
 
 /*
- * This method checks to see if the two CKTables are not equal to
- * one another based on the values they represent and *not* on the
- * actual pointers themselves. If they are not equal, then this method
- * returns true, otherwise it returns false.
+ * This private method drops all the columns of a columnar table
+ * and their data, leaving the rest of the table alone.
  */
-bool CKTable::operator!=( const CKTable & anOther ) const
+void CKTable::dropColumns()
 {
-	return !(this->operator==(anOther));
+	if (mColumns != NULL) {
+		for (int j = 0; j < mNumColumns; ++j) {
+			freeColumn(mColumns[j]);
+		}
+		delete [] mColumns;
+		mColumns = NULL;
+	}
 }
 
 
 /*
- * To make it a little easier on the user of this table, I have
- * created these operators so that elements in the table can be
- * referenced like simply indexes: tbl(0,5) - for both the RHS
- * and LHS of the equation. This requires the CKVariant to handle
- * a lot of the work, but that's not horrible, really.
+ * This moves everything into new storage with room for 'aCapacity'
+ * rows. Only the rows that are in the table are moved - the rest of
+ * the new storage is empty, which is what appendRow() counts on. The
+ * CKVariants and labels are swapped, and the dense columns copied,
+ * into their new places.
  */
-CKVariant & CKTable::operator()( int aRow, int aCol )
-{
-	return getValue(aRow, aCol);
-}
-
-
-CKVariant & CKTable::operator()( int aRow, const CKString & aColHeader )
-{
-	return getValue(aRow, aColHeader);
-}
-
-
-CKVariant & CKTable::operator()( const CKString & aRowLabel, int aCol )
-{
-	return getValue(aRowLabel, aCol);
-}
+void CKTable::growRows( int aCapacity )
+{
+	if (mColumns != NULL) {
+		for (int j = 0; j < mNumColumns; ++j) {
+			CKTableColumn	& column = mColumns[j];
+			CKTableColumn	grown;
+			allocColumn(grown, column.type, aCapacity);
+			switch (column.type) {
+				case eNumberVariant:
+					memcpy(grown.doubles, column.doubles, mNumRows * sizeof(double));
+					break;
+				case eDateVariant:
+					memcpy(grown.dates, column.dates, mNumRows * sizeof(long));
+					break;
+				default:
+					for (int i = 0; i < mNumRows; ++i) {
+						grown.variants[i].swap(column.variants[i]);
+					}
+					break;
+			}
+			// the bits past the last row are all clear, so whole bytes will do
+			if (grown.valid != NULL) {
+				memcpy(grown.valid, column.valid, (mNumRows + 7) / 8);
+			}
+			freeColumn(column);
+			column = grown;
+		}
+	} else {
+		int			cnt = mNumRows * mNumColumns;
+		CKVariant	*table = new CKVariant[aCapacity * mNumColumns];
+		for (int i = 0; i < cnt; ++i) {
+			table[i].swap(mTable[i]);
+		}
+		delete [] mTable;
+		mTable = table;
+	}
 
+	// ...and the row labels - the index doesn't change at all
+	CKString	*labels = new CKString[aCapacity];
+	for (int i = 0; i < mNumRows; ++i) {
+		labels[i].swap(mRowLabels[i]);
+	}
+	delete [] mRowLabels;
+	mRowLabels = labels;
 
-CKVariant & CKTable::operator()( const CKString & aRowLabel, const CKString & aColHeader )
-{
-	return getValue(aRowLabel, aColHeader);
+	mRowCapacity = aCapacity;
 }
 
 
 /*
- * Because there are times when it's useful to have a nice
- * human-readable form of the contents of this table. Most of the
- * time this means that it's used for debugging, but it could be used
- * for just about anything. In these cases, it's nice not to have to
- * worry about the ownership of the representation, so this returns
- * a CKString.
+ * This moves the column headers, and the columns of a columnar
+ * table, into arrays with room for 'aCapacity' columns. The new
+ * columns have no storage - that's given to each as it's appended.
+ * The cells of a row-major table aren't touched at all.
  */
-CKString CKTable::toString() const
+void CKTable::growColumns( int aCapacity )
 {
-	CKString		retval = "";
-
-	// make sure we have something to show...
-	if ((mNumRows > 0) && (mNumColumns > 0) && (mTable != NULL)) {
-		// first, put out the column headers
-		retval += "\t";
-		for (int j = 0; j < mNumColumns; j++) {
-			retval += (j == 0 ? "" : "\t");
-			retval += mColumnHeaders[j];
-		}
-		retval += "\n";
+	CKString	*headers = new CKString[aCapacity];
+	for (int j = 0; j < mNumColumns; ++j) {
+		headers[j].swap(mColumnHeaders[j]);
+	}
+	delete [] mColumnHeaders;
+	mColumnHeaders = headers;
 
-		// now put out the data in the table
-		for (int i = 0; i < mNumRows; i++) {
-			// slap the row label first
-			retval += mRowLabels[i] + "\t";
-			// ...and then the rest of the data for the row
-			for (int j = 0; j < mNumColumns; j++) {
-				retval += (j == 0 ? "" : "\t");
-				retval += mTable[i * mNumColumns + j].toString();
-			}
-			retval += "\n";
+	if (mColumns != NULL) {
+		// the columns just hold pointers, so they can be moved as they are
+		CKTableColumn	*columns = new CKTableColumn[aCapacity];
+		for (int j = 0; j < mNumColumns; ++j) {
+			columns[j] = mColumns[j];
 		}
+		delete [] mColumns;
+		mColumns = columns;
 	}
 
-	return retval;
+	mColumnCapacity = aCapacity;
 }
 
 
-/********************************************************
- *
- *               Text/String Parsing Methods
- *
- ********************************************************/
 /*
- * This method is used in the creation of the encoded strings that
- * assist in the translation of the objects from the C++ to Java
- * environments. Basically, the CKString buffer that's passed in
- * contains delimiters that are '\x01' but that need to be changed
- * to a printable ASCII character. This method scans the entire
- * string for the presence of delimiters and then selects one
- * character that's not used in the string and replaces all the
- * "placeholder" delimiters with this value and returns. If it was
- * impossible to find a delimiter, this method will return false
- * otherwise it will return true.
+ * This makes new storage for the rows given - the cells, or the
+ * columns, and the labels - in the same layout as this table. Each
+ * row that's given once is moved out of this table if 'aMove' is
+ * true - leaving it for the caller to drop - and everything else is
+ * copied. The caller owns what's made.
  */
-bool CKTable::chooseAndApplyDelimiter( CKString & aBuff )
-{
-	bool	error = false;
-
-	// first, see if we have anything to do
-	if (!error) {
-		if (aBuff.empty()) {
-			error = true;
-			throw CKException(__FILE__, __LINE__, "CKTable::chooseAndApplyDelimiter"
-				"(char *) - the passed-in buffer is empty and that means that "
-				"there's nothing I can do. Please make sure that the argument to "
-				"this method is not empty before calling.");
+void CKTable::gatherRows( const std::vector<int> & aRows, bool aMove,
+						  CKVariant * & aTable, CKTableColumn * & aColumns,
+						  CKString * & aLabels ) const
+{
+	int		cnt = aRows.size();
+
+	// a row can only be moved the first time it's given
+	std::vector<char>	moves(cnt, 0);
+	if (aMove) {
+		std::vector<char>	used(mNumRows, 0);
+		for (int i = 0; i < cnt; ++i) {
+			if (!used[aRows[i]]) {
+				used[aRows[i]] = 1;
+				moves[i] = 1;
+			}
 		}
 	}
 
-	/*
-	 * Let's check each of the possible delimiters in turn, and if
-	 * one passes, then let's flag that and we can replace it next.
-	 */
-	if (!error) {
-		bool	replaced = false;
-		// these are out list of possible delimiters in a reasonable order
-		const char	*delimiters = ";|!~`_@#^*/'=.+-<>[]{}1234567890abcde";
-		int		passCnt = (int)strlen(delimiters);
-		// check each and replace if it's not found
-		for (int pass = 0; pass < passCnt; ++pass) {
-			if (aBuff.find(delimiters[pass]) == -1) {
-				aBuff.replace('\x01', delimiters[pass]);
-				replaced = true;
-				break;
-			}
-		}
-		// see if we failed
-		if (!replaced) {
-			error = true;
-			throw CKException(__FILE__, __LINE__, "CKTable::chooseAndApplyDelimiter"
-				"(char *) - while trying to find an acceptable delimiter for the "
-				"data in this string we ran out of possibles before finding one "
-				"that wasn't being used in the text of the code. This is a serious "
-				"problem that the developers need to look into.");
+	// the new storage is just big enough, with the columns' types
+	aTable = NULL;
+	aColumns = NULL;
+	if (mColumns != NULL) {
+		aColumns = new CKTableColumn[mColumnCapacity];
+		for (int j = 0; j < mNumColumns; ++j) {
+			allocColumn(aColumns[j], mColumns[j].type, cnt);
 		}
+	} else {
+		aTable = new CKVariant[cnt * mNumColumns];
 	}
+	aLabels = new CKString[cnt];
 
-	return !error;
+	// the copies go first, before any of their rows are moved away
+	CKTableGatherTask	copies(this, &aRows, &moves, false, aTable, aColumns, aLabels);
+	runOnRows(copies);
+	if (aMove) {
+		CKTableGatherTask	moved(this, &aRows, &moves, true, aTable, aColumns, aLabels);
+		runOnRows(moved);
+	}
 }
 
 
 /*
- * This method sets the datastructure of the array of arrays of
- * pointers of CKVariants to the proper location in this class
- * instance so that it's safe to use. This is not something most
- * users need to use, so it's protected, but because we like to
- * stick with setters and getters, this is here for this class'
- * code. This method assumes that the passed in variable was
- * created for this class. No copy is made, but control of the
- * deallocation of this guy will now become the job of this
- * instance and the caller is absolved of any responsibility there.
+ * This checks that all the row numbers are in the table, and puts
+ * them in the STL vector for gatherRows().
  */
-void CKTable::setTable( CKVariant *aTable )
+void CKTable::checkRows( const CKVector<int> & aRows, const char *aMethod,
+						 std::vector<int> & aList ) const
 {
-	if (mTable != NULL) {
-		delete [] mTable;
-		mTable = NULL;
+	// first, make sure we have a table to take rows from
+	if (!hasStorage()) {
+		std::ostringstream	msg;
+		msg << "CKTable::" << aMethod << " - there is no currently defined "
+			"table structure in this class, so there are no rows to take. "
+			"Please create the table before calling this method.";
+		throw CKException(__FILE__, __LINE__, msg.str());
 	}
-	if (aTable != NULL) {
-		mTable = aTable;
+
+	int		cnt = aRows.size();
+	aList.resize(cnt);
+	for (int i = 0; i < cnt; ++i) {
+		int		row = aRows[i];
+		if ((row < 0) || (row >= mNumRows)) {
+			std::ostringstream	msg;
+			msg << "CKTable::" << aMethod << " - the provided row: " << row <<
+				" lies outside the currently defined table: " << mNumRows <<
+				" by " << mNumColumns;
+			throw CKException(__FILE__, __LINE__, msg.str());
+		}
+		aList[i] = row;
 	}
 }
 
 
+/********************************************************
+ *
+ *                Private Cell Methods
+ *
+ ********************************************************/
 /*
- * This method sets an array of CKString values to be the column
- * headers for the current table. It's important to note that there
- * needs to be getNumColumns() of them and it won't be checked, so...
- * this class will take care of making sure they are there, and it's
- * probably best to let this class to this.
+ * This returns the value in the cell for reading, whatever the
+ * layout. A CKVariant is returned right from the table, but the
+ * value in a dense column is put into the scratch variant and that
+ * is returned. Either way, it's only good until the next call.
  */
-void CKTable::setColumnHeaders( const CKStringList & aList )
+const CKVariant & CKTable::readCell( int aRow, int aCol, CKVariant & aScratch ) const
 {
-	// first, check to see that we have something to do
-	if (aList.size() != mNumColumns) {
-		std::ostringstream	msg;
-		msg << "CKTable::setColumnHeaders(const CKStringList &) - "
-			"the passed-in vector of strings did not contain " << mNumColumns <<
-			" elements which is the number of headers in this table. Please make "
-			"sure the data matches before setting.";
-		throw CKException(__FILE__, __LINE__, msg.str());
+	if (mColumns == NULL) {
+		return mTable[aRow * mNumColumns + aCol];
 	}
 
-	// now copy in all the values
-	for (int i = 0; i < mNumColumns; i++) {
-		CKString	& header = aList[i];
-		mColumnHeaders[i] = header;
-		mColumnHeadersIndex[header] = i;
+	const CKTableColumn	& column = mColumns[aCol];
+	if (column.type == eUnknownVariant) {
+		return column.variants[aRow];
+	}
+	if (!isRowValid(column.valid, aRow)) {
+		aScratch.clearValue();
+	} else if (column.type == eNumberVariant) {
+		aScratch.setDoubleValue(column.doubles[aRow]);
+	} else {
+		aScratch.setDateValue(column.dates[aRow]);
 	}
+	return aScratch;
 }
 
 
 /*
- * This method sets an array of CKString values to be the row
- * labels for the current table. It's important to note that there
- * needs to be getNumRows() of them and it won't be checked, so...
- * this class will take care of making sure they are there, and it's
- * probably best to let this class to this.
+ * This returns the actual CKVariant in the cell so that it can be
+ * changed. If the cell is in a dense column, that column is turned
+ * into CKVariants first. As this can be called by the const getValue(),
+ * and so by several readers at once, the change is made holding the
+ * table's mutex and checked again once we have it, and the dense arrays
+ * are kept until the column is freed, as another reader may still be
+ * in them.
  */
-void CKTable::setRowLabels( const CKStringList & aList )
+CKVariant & CKTable::variantCell( int aRow, int aCol ) const
 {
-	// first, check to see that we have something to do
-	if (aList.size() != mNumRows) {
-		std::ostringstream	msg;
-		msg << "CKTable::setRowLabels(const CKStringList &) - "
-			"the passed-in vector of strings did not contain " << mNumRows <<
-			" elements which is the number of labels in this table. Please make "
-			"sure the data matches before setting.";
-		throw CKException(__FILE__, __LINE__, msg.str());
+	if (mColumns == NULL) {
+		return mTable[aRow * mNumColumns + aCol];
 	}
 
-	// now copy in all the values
-	for (int i = 0; i < mNumRows; i++) {
-		CKString	& label = aList[i];
-		mRowLabels[i] = label;
-		mRowLabelsIndex[label] = i;
+	CKTableColumn	& column = mColumns[aCol];
+	if (column.type != eUnknownVariant) {
+		CKStackLocker	lockem(&mColumnMutex);
+		if (column.type != eUnknownVariant) {
+			makeVariantColumn(column, mRowCapacity, true);
+		}
 	}
+	return column.variants[aRow];
 }
 
 
+/********************************************************
+ *
+ *                Private Row Block Methods
+ *
+ ********************************************************/
 /*
- * This method is really here to encapsulate the number of rows
- * that this data source represents. Since it's possible to have
- * the data and these sizes not match, special care should be
- * taken to ensure that the data is consistent.
+ * This runs the task over all the rows of the table. If the table
+ * is big enough, and 'aCanSplit' is true, the rows are split into
+ * blocks that are run on the parallel executor. Otherwise, it's
+ * all done right here on the calling thread.
  */
-void CKTable::setNumRows( int aCount )
+void CKTable::runOnRows( CKTableRowTask & aTask, bool aCanSplit ) const
 {
-	mNumRows = aCount;
+	int		rows = aTask.getNumRows();
+	int		blocks = (rows + CKTABLE_ROW_BLOCK - 1) / CKTABLE_ROW_BLOCK;
+	if (aCanSplit && (blocks > 1) && isWorthSplitting((double)rows * mNumColumns)) {
+		getParallelExecutor()->parallelFor(0, blocks, aTask);
+	} else {
+		aTask.execute(0, blocks);
+	}
 }
 
 
 /*
- * This method is really here to encapsulate the number of columns
- * that this data source represents. Since it's possible to have
- * the data and these sizes not match, special care should be
- * taken to ensure that the data is consistent.
+ * This returns true if work on this many cells is worth splitting
+ * up over the parallel executor.
  */
-void CKTable::setNumColumns( int aCount )
+bool CKTable::isWorthSplitting( double aCellCount )
 {
-	mNumColumns = aCount;
+	int		threshold = sParallelThreshold;
+	return ((threshold > 0) && (aCellCount >= threshold));
 }
 
 
 /*
- * This method returns the array of CKVariants that comprises the
- * table's row-major data storage so that it can be used in this
- * class. In general, this is a dangerous thing, and it needs to
- * be used carefully, but it's important as we're trying to stick
- * to using just the setters and getters. This method returns a
- * pointer to the actual data and sould therefore be used very
- * carefully as it could change underneath the caller if they aren't
- * careful.
+ * These get what the sorting and grouping work from - the typed
+ * key of each cell in the column for sorting, and the string
+ * value of each for grouping - splitting it up if it's big.
  */
-CKVariant *CKTable::getTable() const
+void CKTable::getSortKey( int aCol, bool anAscending, CKTableSortKey & aKey ) const
 {
-	return mTable;
+	aKey.ascending = anAscending;
+	aKey.kinds.assign(mNumRows, CKTABLE_EMPTY_KEY);
+	aKey.numbers.assign(mNumRows, 0.0);
+	// only a column that can hold strings needs room for them
+	if ((mColumns == NULL) || (mColumns[aCol].type == eUnknownVariant)) {
+		aKey.strings.resize(mNumRows);
+	}
+	CKTableSortKeyTask	task(this, aCol, &aKey);
+	runOnRows(task);
 }
 
 
-/*
- * This method returns the actual array of CKString values that
- * are the column headers for this table. The number of elements
- * in the array is given my getNumColumns() and if the user wants
- * to have this list outside the scopr of this class they need to
- * make a copy of it and that includes all the strings in it.
- */
-const CKString *CKTable::getColumnHeaders() const
+void CKTable::getGroupKeys( int aCol, std::vector<std::string> & aKeys ) const
 {
-	return mColumnHeaders;
+	aKeys.clear();
+	aKeys.resize(mNumRows);
+	CKTableGroupKeyTask	task(this, aCol, &aKeys);
+	runOnRows(task);
 }
 
 
 /*
- * This method returns the actual array of CKString values that
- * are the row labels for this table. The number of elements
- * in the array is given my getNumRows() and if the user wants
- * to have this list outside the scopr of this class they need to
- * make a copy of it and that includes all the strings in it.
+ * This sums up the numbers in the column for each group of rows,
+ * for CKTableGroups::aggregate(). 'aValid' says which groups have
+ * a value - the ones without a number for the mean, minimum and
+ * maximum don't. It's always done on the calling thread, as it's
+ * the columns that are split up.
  */
-const CKString *CKTable::getRowLabels() const
+void CKTable::aggregateColumn( int aCol, const std::vector<int> & aGroupOfRow,
+							   int aNumGroups, CKTableAggregate anOp,
+							   std::vector<double> & aValues,
+							   std::vector<char> & aValid ) const
 {
-	return mRowLabels;
+	std::vector<int>	counts(aNumGroups, 0);
+	aValues.assign(aNumGroups, 0.0);
+
+	/*
+	 * Each number goes into its group's value as it's found - a dense
+	 * column right from its array, and anything else a cell at a time,
+	 * skipping all that aren't numbers.
+	 */
+	const CKTableColumn	*column = (mColumns == NULL ? NULL : &mColumns[aCol]);
+	bool				dense = ((column != NULL) && (column->type == eNumberVariant));
+	CKVariant			scratch;
+	for (int i = 0; i < mNumRows; ++i) {
+		double	x;
+		if (dense) {
+			if (!isRowValid(column->valid, i)) {
+				continue;
+			}
+			x = column->doubles[i];
+		} else {
+			const CKVariant	& cell = readCell(i, aCol, scratch);
+			if (cell.getType() != eNumberVariant) {
+				continue;
+			}
+			x = cell.getDoubleValue();
+		}
+
+		int		g = aGroupOfRow[i];
+		double	& value = aValues[g];
+		switch (anOp) {
+			case eSumAggregate:
+			case eMeanAggregate:
+				value += x;
+				break;
+			case eMinAggregate:
+				if ((counts[g] == 0) || (x < value)) {
+					value = x;
+				}
+				break;
+			case eMaxAggregate:
+				if ((counts[g] == 0) || (x > value)) {
+					value = x;
+				}
+				break;
+			case eCountAggregate:
+				break;
+		}
+		++counts[g];
+	}
+
+	// now finish up each group
+	aValid.assign(aNumGroups, 1);
+	for (int g = 0; g < aNumGroups; ++g) {
+		if (anOp == eCountAggregate) {
+			aValues[g] = counts[g];
+		} else if (anOp == eSumAggregate) {
+			// a sum of nothing is zero
+		} else if (counts[g] == 0) {
+			aValid[g] = 0;
+		} else if (anOp == eMeanAggregate) {
+			aValues[g] /= counts[g];
+		}
+	}
 }
 
 
 /*
- * For debugging purposes, let's make it easy for the user to stream
- * out this value. It basically is just the value of toString() which
- * will indicate the data type and the value.
+ * These are the pieces of the joins. checkJoinColumns() checks the
+ * key columns of both tables and puts them in STL vectors, and
+ * getJoinKeys() gets the typed keys, and their hash, for every row.
+ * joinedTable() makes the result from the row of this table and
+ * of the other - or -1 for none - that goes in each of its rows,
+ * with the columns of the other table that are given.
  */
-std::ostream & operator<<( std::ostream & aStream, const CKTable & aTable )
+void CKTable::checkJoinColumns( const CKTable & aTable, const CKVector<int> & aCols,
+								const CKVector<int> & anOtherCols, const char *aMethod,
+								std::vector<int> & aList,
+								std::vector<int> & anOtherList ) const
 {
-	aStream << aTable.toString();
+	// first, make sure we have tables to join
+	if (!hasStorage() || !aTable.hasStorage()) {
+		std::ostringstream	msg;
+		msg << "CKTable::" << aMethod << " - there is no currently defined "
+			"table structure in " << (hasStorage() ? "the other table" : "this "
+			"table") << ", so there's nothing to join. Please create the table "
+			"before calling this method.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+	// ...and that each key column has one to go with it
+	int		cnt = aCols.size();
+	if (anOtherCols.size() != cnt) {
+		std::ostringstream	msg;
+		msg << "CKTable::" << aMethod << " - there were " << cnt << " key "
+			"columns in this table and " << anOtherCols.size() << " in the "
+			"other. There needs to be the same number in each.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
 
-	return aStream;
+	aList.resize(cnt);
+	anOtherList.resize(cnt);
+	for (int k = 0; k < cnt; ++k) {
+		aList[k] = aCols[k];
+		anOtherList[k] = anOtherCols[k];
+		if ((aList[k] < 0) || (aList[k] >= mNumColumns) ||
+			(anOtherList[k] < 0) || (anOtherList[k] >= aTable.mNumColumns)) {
+			std::ostringstream	msg;
+			msg << "CKTable::" << aMethod << " - the provided key columns: " <<
+				aList[k] << " and " << anOtherList[k] << " lie outside the "
+				"currently defined tables: " << mNumRows << " by " << mNumColumns <<
+				" and " << aTable.mNumRows << " by " << aTable.mNumColumns;
+			throw CKException(__FILE__, __LINE__, msg.str());
+		}
+	}
 }
 
 
-/********************************************************
- *
- *                Private Allocation Methods
- *
- ********************************************************/
-/*
- * This private method takes care of dealing with the intelligent
- * allocation of the table's data. It's not all that complex, but
- * it's nice to have it in one place that's insulated from all the
- * other methods in this class. This method will throw an exception
- * if the number of rows and/or columns make no sense, or if there's
- * an error in the allocation of the storage.
- */
-void CKTable::createTable( int aNumRows, int aNumColumns )
+void CKTable::getJoinKeys( const std::vector<int> & aCols, CKTableJoinKeys & aKeys ) const
 {
-	// first, see if we have anything to do - really
-	if ((aNumRows <= 0) || (aNumColumns <= 0)) {
-		std::ostringstream	msg;
-		msg << "CKTable::createTable(int, int) - the requested table "
-			"size of: " << aNumRows << " by " << aNumColumns <<
-			" makes no sense. Please send reasonable values.";
-		throw CKException(__FILE__, __LINE__, msg.str());
+	aKeys.keys.resize(aCols.size());
+	for (unsigned int k = 0; k < aCols.size(); ++k) {
+		getSortKey(aCols[k], true, aKeys.keys[k]);
 	}
+	aKeys.hashes.resize(mNumRows);
+	CKTableJoinHashTask	task(this, &aKeys);
+	runOnRows(task);
+}
 
-	// next, make sure that we drop what might already be there
-	dropTable();
 
-	/*
-	 * Now we're just going to start ripping through the structure
-	 * and if we run into an allocation problem the system will throw
-	 * an exception for us and we're done. Otherwise, we're going to
-	 * finish what we've started.
-	 */
-	mTable = new CKVariant[aNumRows * aNumColumns];
-	if (mTable == NULL) {
-		std::ostringstream	msg;
-		msg << "CKTable::createTable(int, int) - the array of " <<
-			aNumRows << "x" << aNumColumns << " (" << aNumRows*aNumColumns <<
-			" elements) values could not be created for this table. "
-			"This is a serious allocation problem.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	} else {
-		/*
-		 * If we're still here, then it means that we've allocated all the
-		 * storage and it's OK to set the size as we've created it.
-		 */
-		mNumRows = aNumRows;
-		mNumColumns = aNumColumns;
+CKTable CKTable::joinedTable( const CKTable & aTable, const std::vector<int> & aRows,
+							  const std::vector<int> & anOtherRows,
+							  const std::vector<int> & anOtherCols ) const
+{
+	// each column of the result is one of ours, or one of the other's
+	int								rowCnt = aRows.size();
+	int								colCnt = mNumColumns + anOtherCols.size();
+	std::vector<CKTableJoinSource>	sources(colCnt);
+	for (int j = 0; j < colCnt; ++j) {
+		bool	ours = (j < mNumColumns);
+		sources[j].table = (ours ? this : &aTable);
+		sources[j].col = (ours ? j : anOtherCols[j - mNumColumns]);
+		sources[j].rows = (ours ? &aRows : &anOtherRows);
 	}
 
 	/*
-	 * If we're still here then we need to create the array of CKString
-	 * values that will be the column headers.
+	 * The result has our layout and, if it's columnar, each column that
+	 * comes from a dense column is just as dense. The headers are all
+	 * there, but one of the other's that's the same as one of ours isn't
+	 * in the index, so ours is the one that's found.
 	 */
-	mColumnHeaders = new CKString[mNumColumns];
-	if (mColumnHeaders == NULL) {
-		std::ostringstream	msg;
-		msg << "CKTable::createTable(int, int) - the array of " <<
-			mNumColumns << " column headers could not be created for this "
-			"new table. This is a serious allocation problem.";
-		throw CKException(__FILE__, __LINE__, msg.str());
+	CKTable		retval;
+	retval.mNumRows = rowCnt;
+	retval.mNumColumns = colCnt;
+	retval.mRowCapacity = rowCnt;
+	retval.mColumnCapacity = colCnt;
+	if (mColumns != NULL) {
+		retval.mColumns = new CKTableColumn[colCnt];
+		for (int j = 0; j < colCnt; ++j) {
+			const CKTable	*from = sources[j].table;
+			allocColumn(retval.mColumns[j], (from->mColumns == NULL ? eUnknownVariant :
+								from->mColumns[sources[j].col].type), rowCnt);
+		}
+	} else {
+		retval.mTable = new CKVariant[rowCnt * colCnt];
+	}
+	retval.mRowLabels = new CKString[rowCnt];
+	retval.mColumnHeaders = new CKString[colCnt];
+	retval.mColumnHeadersIndex.reserve(colCnt);
+	for (int j = 0; j < colCnt; ++j) {
+		const CKString	& header = sources[j].table->mColumnHeaders[sources[j].col];
+		retval.mColumnHeaders[j] = header;
+		if ((j < mNumColumns) || (retval.mColumnHeadersIndex.get(header) < 0)) {
+			retval.mColumnHeadersIndex.put(header, j);
+		}
 	}
-	// clear out the index of these column headers
-	mColumnHeadersIndex.clear();
 
-	/*
-	 * If we're still here then we need to create the array of CKString
-	 * values that will be the row labels.
-	 */
-	mRowLabels = new CKString[mNumRows];
-	if (mRowLabels == NULL) {
-		std::ostringstream	msg;
-		msg << "CKTable::createTable(int, int) - the array of " <<
-			mNumRows << " row labels could not be created for this "
-			"new table. This is a serious allocation problem.";
-		throw CKException(__FILE__, __LINE__, msg.str());
+	// now copy in the cells and labels, and index the labels
+	CKTableJoinGatherTask	task(&retval, &sources, this, &aRows);
+	retval.runOnRows(task);
+	retval.mRowLabelsIndex.reserve(rowCnt);
+	for (int i = 0; i < rowCnt; ++i) {
+		retval.mRowLabelsIndex.put(retval.mRowLabels[i], i);
 	}
-	// clear out the index of these row labels
-	mRowLabelsIndex.clear();
+	return retval;
 }
 
 
 /*
- * This private method takes care of dealing with the intelligent
- * allocation of the table's data. It's not all that complex, but
- * it's nice to have it in one place that's insulated from all the
- * other methods in this class. This method will throw an exception
- * if the number of row labels or column headers make no sense, or
- * if there's an error in the allocation of the storage.
+ * This gets a pointer to each column of numbers for the matrix
+ * methods. A dense column of numbers with a value in every row is used
+ * right where it is, and any other column is copied into 'aCopy' - or
+ * every column is, if 'aCopyAll' is true, so they can be changed. If a
+ * cell isn't a number, a CKException is thrown.
  */
-void CKTable::createTable( const CKStringList & aRowLabels,
-						   const CKStringList & aColHeaders )
+void CKTable::getMatrixColumns( const char *aMethod, bool aCopyAll,
+								std::vector<const double *> & aColumns,
+								std::vector<double> & aCopy ) const
 {
-	// first, see if we have anything to do - really
-	if (aRowLabels.empty() || aColHeaders.empty()) {
+	if (!hasStorage()) {
 		std::ostringstream	msg;
-		msg << "CKTable::createTable(const CKStringList &, "
-			"const CKStringList &) - the requested table "
-			"size makes no sense. Please send non-empty lists.";
+		msg << "CKTable::" << aMethod << " - the table has no structure "
+			"yet, so there's no matrix to work on. Please make sure that the "
+			"table has been created before calling this method.";
 		throw CKException(__FILE__, __LINE__, msg.str());
 	}
 
-	// next, make sure that we drop what might already be there
-	dropTable();
-
-	// now let's get the row labels, column headers and sizes
-	mNumRows = aRowLabels.size();
-	mNumColumns = aColHeaders.size();
-
-	/*
-	 * Now we just make what we need and if it fails back this out.
-	 */
-	mTable = new CKVariant[mNumRows * mNumColumns];
-	if (mTable == NULL) {
-		// clear out what we've already set
-		dropTable();
-		// ...and then throw the exception
-		std::ostringstream	msg;
-		msg << "CKTable::createTable(const CKStringList &, "
-			"const CKStringList &) - the array of " <<
-			mNumRows << "x" << mNumColumns << " (" << mNumRows*mNumColumns <<
-			" elements) values could not be created for this table. "
-			"This is a serious allocation problem.";
-		throw CKException(__FILE__, __LINE__, msg.str());
+	// first, see what columns can be used as they are
+	aColumns.assign(mNumColumns, (const double *)NULL);
+	int		copies = 0;
+	for (int j = 0; j < mNumColumns; ++j) {
+		const CKTableColumn	*column = (mColumns == NULL ? NULL : &mColumns[j]);
+		if (!aCopyAll && (column != NULL) && (column->type == eNumberVariant) &&
+			isColumnFull(column->valid, mNumRows)) {
+			aColumns[j] = column->doubles;
+		} else {
+			++copies;
+		}
 	}
 
-	/*
-	 * If we're still here then we need to create the array of CKString
-	 * values that will be the column headers.
-	 */
-	mColumnHeaders = new CKString[mNumColumns];
-	if (mColumnHeaders == NULL) {
-		std::ostringstream	msg;
-		msg << "CKTable::createTable(const CKStringList &, "
-			"const CKStringList &) - the array of " <<
-			mNumColumns << " column headers could not be created for this "
-			"new table. This is a serious allocation problem.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	} else {
-		// clear out the existing index of column headers
-		mColumnHeadersIndex.clear();
-		// now populate the new headers from the list
-		for (int i = 0; i < mNumColumns; i++) {
-			CKString	& header = aColHeaders[i];
-			mColumnHeaders[i] = header;
-			mColumnHeadersIndex[header] = i;
+	// ...and then copy the numbers out of the rest
+	aCopy.assign((size_t)copies * mNumRows, 0.0);
+	int			next = 0;
+	CKVariant	scratch;
+	for (int j = 0; (j < mNumColumns) && (mNumRows > 0); ++j) {
+		if (aColumns[j] != NULL) {
+			continue;
+		}
+		double	*to = &aCopy[(size_t)next * mNumRows];
+		++next;
+		aColumns[j] = to;
+		const CKTableColumn	*column = (mColumns == NULL ? NULL : &mColumns[j]);
+		if ((column != NULL) && (column->type == eNumberVariant)) {
+			for (int i = 0; i < mNumRows; ++i) {
+				if (!isRowValid(column->valid, i)) {
+					notANumber(aMethod, i, j);
+				}
+				to[i] = column->doubles[i];
+			}
+		} else {
+			for (int i = 0; i < mNumRows; ++i) {
+				const CKVariant	& cell = readCell(i, j, scratch);
+				if (cell.getType() != eNumberVariant) {
+					notANumber(aMethod, i, j);
+				}
+				to[i] = cell.getDoubleValue();
+			}
 		}
 	}
+}
 
-	/*
-	 * If we're still here then we need to create the array of CKString
-	 * values that will be the row labels.
-	 */
-	mRowLabels = new CKString[mNumRows];
-	if (mRowLabels == NULL) {
-		std::ostringstream	msg;
-		msg << "CKTable::createTable(const CKStringList &, "
-			"const CKStringList &) - the array of " <<
-			mNumRows << " row labels could not be created for this "
-			"new table. This is a serious allocation problem.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	} else {
-		// clear out the existing index of row labels
-		mRowLabelsIndex.clear();
-		// now populate the new labels from the list
-		for (int i = 0; i < mNumRows; i++) {
-			CKString	& label = aRowLabels[i];
-			mRowLabels[i] = label;
-			mRowLabelsIndex[label] = i;
+
+/*
+ * This makes the columnar table for the result of a matrix method,
+ * with a dense column of numbers for each column, and every row of
+ * each one marked as having a value, as it will. It's made right
+ * here, and not by createTable(), so a matrix with no rows or
+ * columns comes back as one.
+ */
+CKTable CKTable::matrixTable( int aNumRows, int aNumColumns )
+{
+	CKTable		retval;
+	retval.mNumRows = aNumRows;
+	retval.mNumColumns = aNumColumns;
+	retval.mRowCapacity = aNumRows;
+	retval.mColumnCapacity = aNumColumns;
+	retval.mColumns = new CKTableColumn[aNumColumns];
+	for (int j = 0; j < aNumColumns; ++j) {
+		allocColumn(retval.mColumns[j], eNumberVariant, aNumRows);
+		memset(retval.mColumns[j].valid, 0xff, aNumRows / 8);
+		if ((aNumRows % 8) != 0) {
+			retval.mColumns[j].valid[aNumRows / 8] = (unsigned char)((1 << (aNumRows % 8)) - 1);
 		}
 	}
+	retval.mRowLabels = new CKString[aNumRows];
+	retval.mColumnHeaders = new CKString[aNumColumns];
+	retval.mRowLabelsIndex.reserve(aNumRows);
+	retval.mColumnHeadersIndex.reserve(aNumColumns);
+	return retval;
 }
 
 
 /*
- * This private method takes care of dealing with the careful
- * deallocation of the pointers of pointers of pointers. It's not all
- * that complex, but it's nice to have it in one place that's
- * insulated from all the other methods in this class.
+ * This does the product of CKVectorMath::multiply() into the table
+ * from matrixTable(), splitting it up by blocks of the result if it's
+ * big enough. Each multiply and add counts as a cell for deciding if
+ * it is, as that's what the work really is.
  */
-void CKTable::dropTable()
+void CKTable::multiplyInto( CKTable & aResult, int anInner,
+							const std::vector<const double *> & anA, bool aTransposeA,
+							const std::vector<const double *> & aB )
 {
-	// first, see if we have anything to do
-	if (mTable != NULL) {
-		delete [] mTable;
-		mTable = NULL;
+	CKTableMatrixTask	task(&aResult, anInner, &anA, aTransposeA, &aB);
+	int					blocks = task.getNumBlocks();
+	if ((blocks > 1) &&
+		isWorthSplitting((double)aResult.mNumRows * aResult.mNumColumns * anInner)) {
+		getParallelExecutor()->parallelFor(0, blocks, task);
+	} else if (blocks > 0) {
+		task.execute(0, blocks);
 	}
+}
 
-	// also drop the array of column headers
-	if (mColumnHeaders != NULL) {
-		delete [] mColumnHeaders;
-		mColumnHeaders = NULL;
+
+/*
+ * This throws the CKException for a cell of a matrix that isn't a
+ * number.
+ */
+void CKTable::notANumber( const char *aMethod, int aRow, int aCol )
+{
+	std::ostringstream	msg;
+	msg << "CKTable::" << aMethod << " - the cell at (" << aRow << ", " <<
+		aCol << ") isn't a number, and every cell has to be one for the "
+		"table to be a matrix. Please make sure that it is.";
+	throw CKException(__FILE__, __LINE__, msg.str());
+}
+
+
+/*
+ * These do the simple math on all the cells of the table, splitting
+ * it up by rows if it's big enough. The only time the rows can't be
+ * split up is when a dense column of ours is getting values from
+ * something other than a dense column of numbers, as the result might
+ * turn it into CKVariants - and that can't happen on several threads.
+ */
+void CKTable::doMath( char anOp, double aValue )
+{
+	CKTableMathTask		task(this, anOp, aValue);
+	runOnRows(task);
+}
+
+
+void CKTable::doMath( char anOp, const CKTable & anOther )
+{
+	bool	canSplit = true;
+	for (int col = 0; (mColumns != NULL) && (col < mNumColumns); ++col) {
+		if ((mColumns[col].type != eUnknownVariant) &&
+			((mColumns[col].type != eNumberVariant) || (anOther.mColumns == NULL) ||
+			 (anOther.mColumns[col].type != eNumberVariant))) {
+			canSplit = false;
+			break;
+		}
 	}
-	// ...and clear out the index
-	mColumnHeadersIndex.clear();
 
-	// ...and the array of row labels
-	if (mRowLabels != NULL) {
-		delete [] mRowLabels;
-		mRowLabels = NULL;
+	CKTableMathTask		task(this, anOp, &anOther);
+	runOnRows(task, canSplit);
+}
+
+
+/*
+ * These do the simple math on all the cells in the rows from
+ * 'aBegin' up to, but not including, 'anEnd' - in either layout.
+ * The operation is one of '+', '-', '*', '/' or 'i' for the
+ * inverse, and the cells where it makes no sense are simply
+ * skipped.
+ */
+void CKTable::mathRows( char anOp, double aValue, int aBegin, int anEnd )
+{
+	// a row-major table is done a row at a time
+	if (mColumns == NULL) {
+		for (int i = aBegin * mNumColumns; i < anEnd * mNumColumns; ++i) {
+			try {
+				applyMath(mTable[i], anOp, aValue);
+			} catch (CKException & e) {
+				/*
+				 * At this point we really don't want to throw an
+				 * exception because we said that we'd only do those
+				 * elements where it made sense. So, let's eat this
+				 * exception and trust that it being logged is enough.
+				 */
+			}
+		}
+		return;
+	}
+
+	for (int col = 0; col < mNumColumns; ++col) {
+		CKTableColumn	& column = mColumns[col];
+		if (column.type == eNumberVariant) {
+			/*
+			 * A dense column of numbers is done in one pass of the vector
+			 * kernels. The empty rows are done too, as their values don't
+			 * matter and it's faster than checking the bitmap for each one.
+			 */
+			if (anOp == 'i') {
+				CKVectorMath::inverse(column.doubles + aBegin, anEnd - aBegin);
+			} else {
+				CKVectorMath::apply(anOp, column.doubles + aBegin, anEnd - aBegin, aValue);
+			}
+		} else if (column.type == eUnknownVariant) {
+			for (int row = aBegin; row < anEnd; ++row) {
+				try {
+					applyMath(column.variants[row], anOp, aValue);
+				} catch (CKException & e) {
+					/*
+					 * At this point we really don't want to throw an
+					 * exception because we said that we'd only do those
+					 * elements where it made sense. So, let's eat this
+					 * exception and trust that it being logged is enough.
+					 */
+				}
+			}
+		}
+		// ...and there's no math that makes sense on a column of dates
 	}
-	// ...and clear out the index
-	mRowLabelsIndex.clear();
+}
 
-	// also, set the size to 'undefined'
-	mNumRows = -1;
-	mNumColumns = -1;
+
+void CKTable::mathRows( char anOp, const CKTable & anOther, int aBegin, int anEnd )
+{
+	// two row-major tables are done a row at a time
+	if ((mColumns == NULL) && (anOther.mColumns == NULL)) {
+		for (int i = aBegin * mNumColumns; i < anEnd * mNumColumns; ++i) {
+			try {
+				applyMath(mTable[i], anOp, anOther.mTable[i]);
+			} catch (CKException & e) {
+				/*
+				 * At this point we really don't want to throw an
+				 * exception because we said that we'd only do those
+				 * elements where it made sense. So, let's eat this
+				 * exception and trust that it being logged is enough.
+				 */
+			}
+		}
+		return;
+	}
+
+	CKVariant	scratch;
+	CKVariant	value;
+	for (int col = 0; col < mNumColumns; ++col) {
+		CKTableColumn	*mine = (mColumns == NULL ? NULL : &mColumns[col]);
+		CKTableColumn	*his = (anOther.mColumns == NULL ? NULL : &anOther.mColumns[col]);
+
+		/*
+		 * Two dense columns of numbers are done in one pass, and just as
+		 * with CKVariants, a cell that's empty in either one is skipped.
+		 * The blocks of rows always start on a byte of the bitmaps.
+		 */
+		if ((mine != NULL) && (his != NULL) &&
+			(mine->type == eNumberVariant) && (his->type == eNumberVariant)) {
+			CKVectorMath::apply(anOp, mine->doubles + aBegin, mine->valid + (aBegin >> 3),
+								his->doubles + aBegin, his->valid + (aBegin >> 3),
+								anEnd - aBegin);
+			continue;
+		}
+
+		/*
+		 * Anything else is done a cell at a time with CKVariants. A dense
+		 * cell of ours is done on a copy that's put back with setValue()
+		 * so that if the result isn't of the column's type, the column
+		 * becomes CKVariants.
+		 */
+		for (int row = aBegin; row < anEnd; ++row) {
+			const CKVariant	& arg = anOther.readCell(row, col, scratch);
+			try {
+				if ((mine == NULL) || (mine->type == eUnknownVariant)) {
+					applyMath(variantCell(row, col), anOp, arg);
+				} else {
+					readCell(row, col, value);
+					applyMath(value, anOp, arg);
+					setValue(row, col, value);
+				}
+			} catch (CKException & e) {
+				/*
+				 * At this point we really don't want to throw an
+				 * exception because we said that we'd only do those
+				 * elements where it made sense. So, let's eat this
+				 * exception and trust that it being logged is enough.
+				 */
+			}
+		}
+	}
 }
 
 
@@ -12,6 +12,8 @@
 
 //	System Headers
 #include <map>
+#include <vector>
+#include <string>
 /*
  * Because we're using the NAN value in some places in this object,
  * we need to make sure that it's defined for all the platforms that
@@ -53,12 +55,70 @@
 #include "CKVariant.h"
 #include "CKString.h"
 #include "CKVector.h"
+#include "CKLabelIndex.h"
+#include "CKFWMutex.h"
 
 //	Forward Declarations
+class CKBinaryWriter;
+class CKBinaryReader;
+class CKExecutor;
+class CKTable;
+class CKTableGroups;
+struct CKTableColumn;
+struct CKTableSortKey;
+struct CKTableJoinKeys;
+class CKTableRowTask;
 
 //	Public Constants
 
 //	Public Datatypes
+/*
+ * These are the tests getRowsMatching() and filter() can do on the
+ * numbers in a column.
+ */
+enum CKTableTest {
+	eLessThanTest = 0,
+	eLessOrEqualTest,
+	eEqualTest,
+	eNotEqualTest,
+	eGreaterOrEqualTest,
+	eGreaterThanTest
+};
+
+/*
+ * These are the ways the values in a column can be summed up for each
+ * group of rows by CKTableGroups::aggregate().
+ */
+enum CKTableAggregate {
+	eSumAggregate = 0,
+	eMeanAggregate,
+	eMinAggregate,
+	eMaxAggregate,
+	eCountAggregate
+};
+
+/*
+ * These are the kinds of join() - just the rows of this table that
+ * match a row of the other, or all of them, with the other table's
+ * columns left empty where there's no match.
+ */
+enum CKTableJoinType {
+	eInnerJoin = 0,
+	eLeftJoin
+};
+
+/*
+ * This is the interface for the test of a row in getRowsMatching() and
+ * filter(). keepRow() is called once for every row of the table, and on
+ * a big table it's called on several threads at once for different
+ * rows, so it needs to be thread-safe and can't change the table.
+ */
+class ICKTableRowFilter
+{
+	public:
+		virtual ~ICKTableRowFilter() { }
+		virtual bool keepRow( const CKTable & aTable, int aRow ) const = 0;
+};
 
 //	Public Data Constants
 
@@ -88,6 +148,14 @@ class CKTable {
 		 * class.
 		 */
 		CKTable( int aNumRows, int aNumColumns );
+		/*
+		 * This constructor creates a columnar table where every column
+		 * is of the given type - eNumberVariant or eDateVariant for the
+		 * dense columns, or eUnknownVariant for columns of CKVariants -
+		 * without ever making the row-major array of CKVariants. It's
+		 * the way to make a big table of numbers.
+		 */
+		CKTable( int aNumRows, int aNumColumns, CKVariantType aColumnType );
 		/*
 		 * This version of the constructor for this class takes two lists -
 		 * one for the list of row labels and the other for the list of
@@ -246,7 +314,15 @@ class CKTable {
 		 * table's data structure and so the caller should be *VERY* careful
 		 * what he does with it. It's nice for scanning through the data and
 		 * seeing what's there, but the caller cannot delete it as it's
-		 * controlled by this table's methods.
+		 * controlled by this table's methods. In a columnar table there
+		 * is no CKVariant in a dense column to refer to, so asking for
+		 * one turns that column back into CKVariants. That's done under
+		 * the table's own lock, and the dense data is kept until the
+		 * column is next reallocated, so any number of threads can call
+		 * this, and the other const readers, on a table at once - as long
+		 * as nobody is changing it. Use getDoubleValue(), getDateValue()
+		 * or getDoubleColumn() to read a dense column without changing it
+		 * at all.
 		 */
 		CKVariant & getValue( int aRow, int aCol ) const;
 		CKVariant & getValue( int aRow, const CKString & aColHeader ) const;
@@ -367,14 +443,30 @@ class CKTable {
 		 * This method returns the column index for the specified header.
 		 * If this header is not a valid column header for this table, then
 		 * this method will return a -1, please check for it.
+		 *
+		 * The index is the handle for the column - look it up once and
+		 * then use it with the index-based accessors, and each access is
+		 * just indexing into the table. It stays good until the table is
+		 * resized or recreated.
 		 */
 		int getColumnForHeader( const CKString & aHeader ) const;
+		int getColumnForHeader( const char *aHeader ) const;
 		/*
 		 * This method returns the row index for the specified label.
 		 * If this label is not a valid row label for this table, then
-		 * this method will return a -1, please check for it.
+		 * this method will return a -1, please check for it. Just like
+		 * the column index, it's the handle for the row.
 		 */
 		int getRowForLabel( const CKString & aLabel ) const;
+		int getRowForLabel( const char *aLabel ) const;
+		/*
+		 * These methods look up all the headers or labels in the list
+		 * at once, and return the column or row indexes in the same
+		 * order - with a -1 for each that's not in the table. It's the
+		 * easy way to resolve the handles for a whole batch of lookups.
+		 */
+		CKVector<int> getColumnsForHeaders( const CKStringList & aHeaders ) const;
+		CKVector<int> getRowsForLabels( const CKStringList & aLabels ) const;
 		/*
 		 * This method returns a complete vector of the CKVariants that
 		 * make up the supplied row in the table. This is nice if you
@@ -408,6 +500,85 @@ class CKTable {
 		 */
 		CKVector<CKVariant> getColumn( const CKString & aColumnHeader ) const;
 
+		/********************************************************
+		 *
+		 *                Columnar Layout Methods
+		 *
+		 ********************************************************/
+		/*
+		 * By default a table is a row-major array of CKVariants, and that
+		 * is the most general thing there is. But a table of numbers pays
+		 * for a whole CKVariant in every cell and a switch on its type in
+		 * every access. A columnar table keeps each column by itself - a
+		 * column of numbers is a dense array of doubles, a column of dates
+		 * a dense array of longs, each with a bitmap of the rows that have
+		 * a value, and any other column is still an array of CKVariants.
+		 *
+		 * All the other methods work the same on either layout. Putting a
+		 * value in a dense column that isn't of its type simply turns that
+		 * column into CKVariants, so mixed data always has a home.
+		 *
+		 * This method turns the columnar layout on or off. Turning it on
+		 * makes a dense column out of every one that holds just numbers or
+		 * just dates, and turning it off puts everything back into the
+		 * row-major array of CKVariants.
+		 */
+		void setColumnar( bool aFlag );
+		bool isColumnar() const;
+		/*
+		 * These methods declare the type of a column, making the table
+		 * columnar if it isn't already. eNumberVariant and eDateVariant
+		 * make the column dense, and eUnknownVariant makes it CKVariants.
+		 * If there's a value in the column that can't be held in a dense
+		 * column of that type, a CKException is thrown and the column is
+		 * left as it was.
+		 */
+		void setColumnType( int aCol, CKVariantType aType );
+		void setColumnType( const CKString & aColHeader, CKVariantType aType );
+		/*
+		 * This method returns the declared type of the column - either
+		 * eNumberVariant or eDateVariant for a dense column, or else
+		 * eUnknownVariant for one of CKVariants or a row-major table.
+		 */
+		CKVariantType getColumnType( int aCol ) const;
+		CKVariantType getColumnType( const CKString & aColHeader ) const;
+		/*
+		 * These methods return the actual dense array of a column so that
+		 * it can be scanned without going through the accessors - there
+		 * are getNumRows() values in it. If the column isn't a dense one of
+		 * that type, they return NULL. The values of the rows that are
+		 * empty are meaningless, so getColumnValidity() returns the bitmap
+		 * that says which ones aren't - row i has a value if bit (i % 8)
+		 * of byte (i / 8) is set. Like getValue(), these are the actual
+		 * data and can change if the table does.
+		 */
+		const double *getDoubleColumn( int aCol ) const;
+		const long *getDateColumn( int aCol ) const;
+		const unsigned char *getColumnValidity( int aCol ) const;
+
+		/********************************************************
+		 *
+		 *                Parallel Execution Methods
+		 *
+		 ********************************************************/
+		/*
+		 * The simple math, merge(), generateCodeFromValues(),
+		 * takeValuesFromCode() and operator==() on a big table are split
+		 * up into blocks of rows and run on a pool of threads. Each block
+		 * is done exactly as it would be on one thread, so the results are
+		 * always the same as doing it all on the calling thread.
+		 *
+		 * These set the pool to use - NULL means CKExecutor::getDefault() -
+		 * and the number of cells a table has to have before it's worth
+		 * splitting up. A threshold of zero or less keeps everything on
+		 * the calling thread. Both are for the whole process, and the pool
+		 * has to outlive any table operations that might be using it.
+		 */
+		static void setParallelExecutor( CKExecutor *anExecutor );
+		static CKExecutor *getParallelExecutor();
+		static void setParallelThreshold( int aCellCount );
+		static int getParallelThreshold();
+
 		/********************************************************
 		 *
 		 *            Table Manipulation Methods
@@ -423,6 +594,169 @@ class CKTable {
 		 */
 		bool merge( const CKTable & aTable );
 
+		/********************************************************
+		 *
+		 *            Sort, Filter and Group Methods
+		 *
+		 ********************************************************/
+		/*
+		 * None of these make a table along the way. They work with the
+		 * row numbers - the order the rows should be in, or the ones that
+		 * pass a test - and the cells are moved just once, at the end, if
+		 * the table itself is changed. Like the simple math, a big table
+		 * is split up over the parallel executor, and the answers are
+		 * always the same as doing it on the calling thread.
+		 */
+		/*
+		 * These return the rows of the table in the order sorted by the
+		 * values in the given columns - the first column first, then the
+		 * second for the rows that tie in the first, and so on. Numbers
+		 * and dates are sorted by value, and come before everything else,
+		 * which is sorted by its string value. Empty cells always come
+		 * last, whichever way the column is sorted. Rows that tie in all
+		 * the columns stay in the order they were in, so the sort is
+		 * stable.
+		 */
+		CKVector<int> getSortedRows( int aCol, bool anAscending = true ) const;
+		CKVector<int> getSortedRows( const CKVector<int> & aCols,
+									 const CKVector<bool> & anAscending ) const;
+		/*
+		 * These sort the rows of the table itself - with their labels -
+		 * in the order getSortedRows() returns.
+		 */
+		void sortBy( int aCol, bool anAscending = true );
+		void sortBy( const CKString & aColHeader, bool anAscending = true );
+		void sortBy( const CKVector<int> & aCols, const CKVector<bool> & anAscending );
+
+		/*
+		 * These return the rows, in order, that pass the test. The first
+		 * form asks the filter about each row. The second compares the
+		 * number - or date - in the column with the value, and a row
+		 * without a number or date there never passes. It reads a dense
+		 * column right from its array.
+		 */
+		CKVector<int> getRowsMatching( const ICKTableRowFilter & aFilter ) const;
+		CKVector<int> getRowsMatching( int aCol, CKTableTest aTest, double aValue ) const;
+		/*
+		 * These drop all the rows of the table that don't pass the test,
+		 * keeping the rest in order. If none pass, the table is left with
+		 * its columns and no rows, and rows can be appended to it again.
+		 */
+		void filter( const ICKTableRowFilter & aFilter );
+		void filter( int aCol, CKTableTest aTest, double aValue );
+
+		/*
+		 * These take the rows given, in the order given, with their labels.
+		 * selectRows() makes them the only rows in this table - moving the
+		 * cells, and not copying them, unless a row is given more than
+		 * once. getRows() returns a new table of copies of them, and leaves
+		 * this one alone. The row numbers are usually from the methods
+		 * above.
+		 */
+		void selectRows( const CKVector<int> & aRows );
+		CKTable getRows( const CKVector<int> & aRows ) const;
+
+		/*
+		 * These group the rows of the table by the value in the column -
+		 * its type and value, so the number 1 and the string "1" are not
+		 * the same group - so that the other columns can be summed up for
+		 * each group with aggregate(). The groups refer to this table, so
+		 * it has to be left alone while they're being used.
+		 */
+		CKTableGroups groupBy( int aCol ) const;
+		CKTableGroups groupBy( const CKString & aColHeader ) const;
+
+		/********************************************************
+		 *
+		 *                Join Methods
+		 *
+		 ********************************************************/
+		/*
+		 * These return a new table of the rows of this table joined with
+		 * the rows of the other table that have the same values in the key
+		 * columns - the columns of this table, and then the columns of the
+		 * other table but its keys, with the row labels of this table. The
+		 * rows are in the order of this table and, for each, the order of
+		 * the other. A number or date only matches the same number or date,
+		 * a string the same string, and an empty cell never matches. An
+		 * inner join drops the rows that don't match anything, and a left
+		 * join keeps them, with the other table's columns empty.
+		 *
+		 * It's a hash join - the smaller table is put in a hash table and
+		 * the rows of the other are looked up in it, split up over the
+		 * parallel executor on a big table - and the result is always the
+		 * same whichever table that is. The result has the layout of this
+		 * table, and the dense columns of a columnar one are copied as
+		 * numbers and dates, and not through CKVariants. The second form
+		 * joins on the column with the same header in both tables.
+		 */
+		CKTable join( const CKTable & aTable, int aCol, int anOtherCol,
+					  CKTableJoinType aType = eInnerJoin ) const;
+		CKTable join( const CKTable & aTable, const CKString & aColHeader,
+					  CKTableJoinType aType = eInnerJoin ) const;
+		CKTable join( const CKTable & aTable, const CKVector<int> & aCols,
+					  const CKVector<int> & anOtherCols,
+					  CKTableJoinType aType = eInnerJoin ) const;
+		/*
+		 * These are the as-of merge of the other table into this one. For
+		 * each row of this table, it's the last row of the other table,
+		 * with the same values in the key columns, whose time - a number
+		 * or date - isn't after the time of this row. Ties in time go to
+		 * the one furthest down the other table. Every row of this table
+		 * is in the result, in order, with the columns of the other table
+		 * but its keys - the time column stays, so it's clear how old the
+		 * match was - and they're empty if there's no match. The first
+		 * form has no key columns, just the times.
+		 */
+		CKTable asOfJoin( const CKTable & aTable, int aTimeCol,
+						  int anOtherTimeCol ) const;
+		CKTable asOfJoin( const CKTable & aTable, const CKVector<int> & aCols,
+						  const CKVector<int> & anOtherCols, int aTimeCol,
+						  int anOtherTimeCol ) const;
+
+		/********************************************************
+		 *
+		 *                Matrix Methods
+		 *
+		 ********************************************************/
+		/*
+		 * These treat a table of numbers as a matrix - every cell has to
+		 * have a number in it, and an empty cell, or anything else, throws
+		 * a CKException. They work right on the dense number columns of a
+		 * columnar table, and copy the numbers out of any other kind of
+		 * column first. The result is always a new columnar table of dense
+		 * number columns. The products are done in blocks that fit in the
+		 * caches, with AVX2 when it's there, and a big one is split up by
+		 * blocks of the result over the parallel executor. Each number in
+		 * the result is summed in the same order however it's done, so the
+		 * answers are always exactly the same.
+		 */
+		/*
+		 * This returns the matrix product of this table and the other -
+		 * not the element by element product of multiply() - so the other
+		 * table has to have as many rows as this one has columns. The
+		 * result has the row labels of this table and the column headers
+		 * of the other.
+		 */
+		CKTable matrixMultiply( const CKTable & aTable ) const;
+		/*
+		 * This returns the transpose of the table - a row for each column
+		 * and a column for each row - with the column headers as the row
+		 * labels, and the row labels as the column headers.
+		 */
+		CKTable transpose() const;
+		/*
+		 * These return the sample covariance - over N-1 - and correlation
+		 * of the columns of the table, each as a square table with a row
+		 * and a column for each column of this one, with its header as the
+		 * label of both. The columns are centered on their means before
+		 * they're multiplied, so nothing is lost to big means, and there
+		 * have to be at least two rows. A column that's all one number has
+		 * no correlation with anything, so its row and column are NAN.
+		 */
+		CKTable covariance() const;
+		CKTable correlation() const;
+
 		/********************************************************
 		 *
 		 *                Simple Math Methods
@@ -533,15 +867,54 @@ class CKTable {
 		 * untouched, and is the responsible of the caller to free.
 		 */
 		virtual void takeValuesFromCode( const CKString & aCode );
+		/*
+		 * These methods are the binary versions of the two above. The
+		 * toBinary() method returns a complete code in the compact binary
+		 * format - header and all - and fromBinary() takes one written by
+		 * it and replaces what's in this table with it. The codes can
+		 * have any bytes in them, so they are std::strings and not CKStrings.
+		 */
+		std::string toBinary() const;
+		void fromBinary( const std::string & aCode );
+		void fromBinary( const char *aCode, int aLength );
+		/*
+		 * These methods write and read just the table's value - no
+		 * header - so that it can be nested in the code of something
+		 * bigger. This is what toBinary() and fromBinary() are built on.
+		 */
+		virtual void writeBinary( CKBinaryWriter & aWriter ) const;
+		virtual void readBinary( CKBinaryReader & aReader );
 		/*
 		 * When this table needs to be resized, a call to this method will
 		 * do the trick. It's important to note that all the data that can
 		 * survive the change will survive the change. This means that if the
 		 * resize is such that the new table is bigger then all the data will
 		 * be preserved, but if the new dimensions are smaller than the
-		 * current ones then data will be lost.
+		 * current ones then data will be lost. Adding rows and leaving the
+		 * columns alone is done just like appendRow(), so it's cheap too.
 		 */
 		void resizeTable( int aNumRows, int aNumColumns );
+		/*
+		 * These methods add one empty row, or column, to the end of the
+		 * table and return its index - with the label or header, if one
+		 * is given. The table keeps room for more rows than it has, and
+		 * when it runs out, that room is doubled, so building a table a
+		 * row at a time moves each cell only a couple of times in all. A
+		 * columnar table keeps room for more columns the same way, but a
+		 * row-major table has to move all its cells to add a column.
+		 */
+		int appendRow();
+		int appendRow( const CKString & aLabel );
+		int appendColumn();
+		int appendColumn( const CKString & aHeader );
+		/*
+		 * This method makes room for 'aNumRows' rows in all, so that rows
+		 * can be appended up to that many without anything being moved.
+		 * The number of rows in the table isn't changed. The capacity is
+		 * the number of rows there's room for right now.
+		 */
+		void reserveRows( int aNumRows );
+		int getRowCapacity() const;
 		/*
 		 * This method checks to see if the two CKTables are equal to one
 		 * another based on the values they represent and *not* on the actual
@@ -650,7 +1023,8 @@ class CKTable {
 		 * to using just the setters and getters. This method returns a
 		 * pointer to the actual data and sould therefore be used very
 		 * carefully as it could change underneath the caller if they aren't
-		 * careful.
+		 * careful. A columnar table has no such array, and this returns
+		 * NULL for one.
 		 */
 		CKVariant *getTable() const;
 		/*
@@ -671,6 +1045,27 @@ class CKTable {
 		const CKString *getRowLabels() const;
 
 	private:
+		/*
+		 * The tasks that work on blocks of rows for the parallel methods
+		 * need to get at the cells just like the methods themselves.
+		 */
+		friend class CKTableMathTask;
+		friend class CKTableMergeTask;
+		friend class CKTableCodeTask;
+		friend class CKTableParseTask;
+		friend class CKTableCompareTask;
+		friend class CKTableSortKeyTask;
+		friend class CKTableFilterTask;
+		friend class CKTableGatherTask;
+		friend class CKTableGroupKeyTask;
+		friend class CKTableGroups;
+		friend class CKTableAggregateTask;
+		friend class CKTableJoinHashTask;
+		friend class CKTableJoinProbeTask;
+		friend class CKTableAsOfProbeTask;
+		friend class CKTableJoinGatherTask;
+		friend class CKTableMatrixTask;
+
 		/*
 		 * This is the pointer to a row-major storage of the data in the
 		 * table. The index of any element in the table (i,j) is simply
@@ -681,6 +1076,14 @@ class CKTable {
 		 * pretty nicely.
 		 */
 		CKVariant					*mTable;
+		/*
+		 * When the table is columnar, mTable is NULL and this is the array
+		 * of mNumColumns columns that holds the data instead. Each one is
+		 * either a dense array of numbers or dates, or an array of CKVariants,
+		 * as described in CKTable.cpp. When the table is row-major, this is
+		 * NULL.
+		 */
+		CKTableColumn				*mColumns;
 		/*
 		 * This is a array of CKString values that are the column
 		 * headers. The reason for picking the CKString is that it allows
@@ -693,9 +1096,10 @@ class CKTable {
 		 * This is the 'index' of the column headers so that it will be
 		 * very fast converting a column header into it's numerical column
 		 * position. This is populated at the same time as the mColumnHeaders
-		 * so it stays in sync at all times.
+		 * so it stays in sync at all times. It's a hash index, so a lookup
+		 * is a hash and a compare, and not a walk down a tree of them.
 		 */
-		std::map<CKString, int>		mColumnHeadersIndex;
+		CKLabelIndex				mColumnHeadersIndex;
 		/*
 		 * This is a array of CKString values that are the row
 		 * labels. The reason for picking the CKString is that it allows
@@ -708,9 +1112,10 @@ class CKTable {
 		 * This is the 'index' of the row labels so that it will be
 		 * very fast converting a row label into it's numerical row
 		 * position. This is populated at the same time as the mRowLabels
-		 * so it stays in sync at all times.
+		 * so it stays in sync at all times. Like the column headers, it's
+		 * a hash index.
 		 */
-		std::map<CKString, int>		mRowLabelsIndex;
+		CKLabelIndex				mRowLabelsIndex;
 		/*
 		 * This is the current number of rows expressed in the table's
 		 * data structure. It has been used in the creation of the data
@@ -725,6 +1130,29 @@ class CKTable {
 		 * no table has been defined.
 		 */
 		int							mNumColumns;
+		/*
+		 * These are the number of rows and columns there's room for. The
+		 * rows past mNumRows are all empty - in the row-major array, the
+		 * columns, and the row labels - so adding a row is just counting
+		 * it. The columns past mNumColumns are only in mColumns and the
+		 * column headers, as the row-major array is always exactly
+		 * mNumColumns across.
+		 */
+		int							mRowCapacity;
+		int							mColumnCapacity;
+		/*
+		 * This is held while a const reader turns a dense column into
+		 * CKVariants, so that two of them don't do it at the same time.
+		 * It's never copied - each table has its own.
+		 */
+		mutable CKFWMutex			mColumnMutex;
+		/*
+		 * These are the pool and threshold for splitting up the work on
+		 * big tables, as set by setParallelExecutor() and
+		 * setParallelThreshold().
+		 */
+		static CKExecutor			*sParallelExecutor;
+		static volatile int			sParallelThreshold;
 
 		/********************************************************
 		 *
@@ -737,9 +1165,11 @@ class CKTable {
 		 * it's nice to have it in one place that's insulated from all the
 		 * other methods in this class. This method will throw an exception
 		 * if the number of rows and/or columns make no sense, or if there's
-		 * an error in the allocation of the storage.
+		 * an error in the allocation of the storage. If it's to be columnar,
+		 * the columns are created empty, and it's up to the caller to fill
+		 * in each one.
 		 */
-		void createTable( int aNumRows, int aNumColumns );
+		void createTable( int aNumRows, int aNumColumns, bool aColumnar = false );
 		/*
 		 * This private method takes care of dealing with the intelligent
 		 * allocation of the table's data. It's not all that complex, but
@@ -757,6 +1187,146 @@ class CKTable {
 		 * insulated from all the other methods in this class.
 		 */
 		void dropTable();
+		/*
+		 * This private method drops all the columns of a columnar table
+		 * and their data, leaving the rest of the table alone.
+		 */
+		void dropColumns();
+		/*
+		 * These move everything into new storage with room for 'aCapacity'
+		 * rows, or columns. The cells are swapped, and not copied, into
+		 * their new places. Growing the columns doesn't touch the cells of
+		 * a row-major table - that's up to appendColumn().
+		 */
+		void growRows( int aCapacity );
+		void growColumns( int aCapacity );
+		/*
+		 * This makes new storage for the rows given - the cells, or the
+		 * columns, and the labels - in the same layout as this table. Each
+		 * row that's given once is moved out of this table if 'aMove' is
+		 * true - leaving it for the caller to drop - and everything else is
+		 * copied. The caller owns what's made.
+		 */
+		void gatherRows( const std::vector<int> & aRows, bool aMove,
+						 CKVariant * & aTable, CKTableColumn * & aColumns,
+						 CKString * & aLabels ) const;
+		/*
+		 * This checks that all the row numbers are in the table, and puts
+		 * them in the STL vector for gatherRows().
+		 */
+		void checkRows( const CKVector<int> & aRows, const char *aMethod,
+						std::vector<int> & aList ) const;
+
+		/********************************************************
+		 *
+		 *                Private Cell Methods
+		 *
+		 ********************************************************/
+		/*
+		 * This returns true if there's storage for the values - in either
+		 * layout. It's what says if the table has been defined.
+		 */
+		inline bool hasStorage() const
+		{
+			return ((mTable != NULL) || (mColumns != NULL));
+		}
+		/*
+		 * This returns the value in the cell for reading, whatever the
+		 * layout. A CKVariant is returned right from the table, but the
+		 * value in a dense column is put into the scratch variant and that
+		 * is returned. Either way, it's only good until the next call.
+		 */
+		const CKVariant & readCell( int aRow, int aCol, CKVariant & aScratch ) const;
+		/*
+		 * This returns the actual CKVariant in the cell so that it can be
+		 * changed. If the cell is in a dense column, that column is turned
+		 * into CKVariants first.
+		 */
+		CKVariant & variantCell( int aRow, int aCol ) const;
+
+		/********************************************************
+		 *
+		 *                Private Row Block Methods
+		 *
+		 ********************************************************/
+		/*
+		 * This runs the task over all the rows of the table. If the table
+		 * is big enough, and 'aCanSplit' is true, the rows are split into
+		 * blocks that are run on the parallel executor. Otherwise, it's
+		 * all done right here on the calling thread.
+		 */
+		void runOnRows( CKTableRowTask & aTask, bool aCanSplit = true ) const;
+		/*
+		 * This returns true if work on this many cells is worth splitting
+		 * up over the parallel executor.
+		 */
+		static bool isWorthSplitting( double aCellCount );
+		/*
+		 * These get what the sorting and grouping work from - the typed
+		 * key of each cell in the column for sorting, and for grouping
+		 * the type of each, as one character, followed by its value as
+		 * a string, with an empty cell the empty string. They split it
+		 * up if it's big.
+		 */
+		void getSortKey( int aCol, bool anAscending, CKTableSortKey & aKey ) const;
+		void getGroupKeys( int aCol, std::vector<std::string> & aKeys ) const;
+		/*
+		 * This sums up the numbers in the column for each group of rows,
+		 * for CKTableGroups::aggregate(). 'aValid' says which groups have
+		 * a value - the ones without a number for the mean, minimum and
+		 * maximum don't. It's always done on the calling thread, as it's
+		 * the columns that are split up.
+		 */
+		void aggregateColumn( int aCol, const std::vector<int> & aGroupOfRow,
+							  int aNumGroups, CKTableAggregate anOp,
+							  std::vector<double> & aValues,
+							  std::vector<char> & aValid ) const;
+		/*
+		 * These are the pieces of the joins. checkJoinColumns() checks the
+		 * key columns of both tables and puts them in STL vectors, and
+		 * getJoinKeys() gets the typed keys, and their hash, for every row.
+		 * joinedTable() makes the result from the row of this table and
+		 * of the other - or -1 for none - that goes in each of its rows,
+		 * with the columns of the other table that are given.
+		 */
+		void checkJoinColumns( const CKTable & aTable, const CKVector<int> & aCols,
+							   const CKVector<int> & anOtherCols, const char *aMethod,
+							   std::vector<int> & aList,
+							   std::vector<int> & anOtherList ) const;
+		void getJoinKeys( const std::vector<int> & aCols, CKTableJoinKeys & aKeys ) const;
+		CKTable joinedTable( const CKTable & aTable, const std::vector<int> & aRows,
+							 const std::vector<int> & anOtherRows,
+							 const std::vector<int> & anOtherCols ) const;
+		/*
+		 * These are the pieces of the matrix methods. getMatrixColumns()
+		 * gets a pointer to each column of numbers - right into a dense
+		 * column, or into 'aCopy' for any other, or for all of them with
+		 * 'aCopyAll' - and notANumber() throws the CKException for a cell
+		 * that isn't a number. matrixTable() makes the columnar table
+		 * of dense number columns, all with values, for the result, and
+		 * multiplyInto() does the product of CKVectorMath::multiply() into
+		 * it, split up by blocks of the result if it's big.
+		 */
+		void getMatrixColumns( const char *aMethod, bool aCopyAll,
+							   std::vector<const double *> & aColumns,
+							   std::vector<double> & aCopy ) const;
+		static CKTable matrixTable( int aNumRows, int aNumColumns );
+		static void multiplyInto( CKTable & aResult, int anInner,
+								  const std::vector<const double *> & anA, bool aTransposeA,
+								  const std::vector<const double *> & aB );
+		static void notANumber( const char *aMethod, int aRow, int aCol );
+		/*
+		 * These do the simple math on all the cells in the rows from
+		 * 'aBegin' up to, but not including, 'anEnd' - in either layout.
+		 * The operation is one of '+', '-', '*', '/' or 'i' for the
+		 * inverse, and the cells where it makes no sense are simply
+		 * skipped. doMath() does the whole table, splitting it up if
+		 * it can.
+		 */
+		void doMath( char anOp, double aValue );
+		void doMath( char anOp, const CKTable & anOther );
+		void mathRows( char anOp, double aValue, int aBegin, int anEnd );
+		void mathRows( char anOp, const CKTable & anOther, int aBegin, int anEnd );
 };
 
 /*
@@ -786,4 +1356,10 @@ CKTable operator*( double aValue, CKTable & aTable );
 CKTable operator/( CKTable & aTable, double aValue );
 CKTable operator/( double aValue, CKTable & aTable );
 
+/*
+ * The groups from groupBy() need the table to be defined, so they come
+ * in here - after it - so that the one header does for both.
+ */
+#include "CKTableGroups.h"
+
 #endif	// __CKTABLE_H
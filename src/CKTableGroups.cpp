@@ -0,0 +1,373 @@
+/*
+ * CKTableGroups.cpp - this file implements the grouping of the rows of a
+ *                     CKTable by the values in one of its columns, as made
+ *                     by CKTable::groupBy(). It's just the group number of
+ *                     each row and the value each group is for - nothing is
+ *                     copied out of the table - and aggregate() sums up the
+ *                     other columns of the table for each group into a new
+ *                     table with one row for each group.
+ *
+ * $Id$
+ */
+
+//	System Headers
+#include <string>
+#include <vector>
+#include <sstream>
+
+//	Third-Party Headers
+#include <CKException.h>
+
+//	Other Headers
+#include "CKTableGroups.h"
+#include "CKLabelIndex.h"
+#include "CKExecutor.h"
+
+//	Forward Declarations
+
+//	Private Constants
+
+//	Private Datatypes
+/*
+ * This sums up each of the columns in a range for aggregate(). Each one
+ * is done on its own, start to finish, so it's exactly what it would be
+ * on the calling thread.
+ */
+class CKTableAggregateTask :
+	public ICKExecutorRangeTask
+{
+	public:
+		CKTableAggregateTask( const CKTable *aTable, const std::vector<int> *aCols,
+							  const std::vector<int> *aGroupOfRow, int aNumGroups,
+							  CKTableAggregate anOp,
+							  std::vector< std::vector<double> > *aValues,
+							  std::vector< std::vector<char> > *aValid ) :
+			mTable(aTable), mCols(aCols), mGroupOfRow(aGroupOfRow),
+			mNumGroups(aNumGroups), mOp(anOp), mValues(aValues), mValid(aValid) { }
+		virtual void execute( int aBegin, int anEnd )
+		{
+			for (int k = aBegin; k < anEnd; ++k) {
+				mTable->aggregateColumn((*mCols)[k], *mGroupOfRow, mNumGroups,
+										mOp, (*mValues)[k], (*mValid)[k]);
+			}
+		}
+
+	private:
+		const CKTable						*mTable;
+		const std::vector<int>				*mCols;
+		const std::vector<int>				*mGroupOfRow;
+		int									mNumGroups;
+		CKTableAggregate					mOp;
+		std::vector< std::vector<double> >	*mValues;
+		std::vector< std::vector<char> >	*mValid;
+};
+
+//	Private Data Constants
+
+/*
+ * The keys from CKTable::getGroupKeys() start with a character for the
+ * type of the value, so that values of different types are different
+ * groups. This is the value without it - what the group is shown as.
+ */
+static CKString valueOfKey( const std::string & aKey )
+{
+	return (aKey.empty() ? CKString() : CKString(aKey.substr(1)));
+}
+
+
+/********************************************************
+ *
+ *                Constructors/Destructor
+ *
+ ********************************************************/
+/*
+ * This groups the rows of the table by the value in the column,
+ * and it's what CKTable::groupBy() uses. The groups are numbered
+ * in the order their first rows are in the table. Values of
+ * different types - the number 1 and the string "1" - are in
+ * different groups, -0 and 0 are in the same one, and the empty
+ * cells are a group of their own - apart from any empty strings.
+ * The table isn't copied, so it has to be left alone while the
+ * groups are used.
+ */
+CKTableGroups::CKTableGroups( const CKTable & aTable, int aCol ) :
+	mTable(&aTable),
+	mColumn(aCol),
+	mGroupOfRow(),
+	mKeys(),
+	mSizes()
+{
+	// first, make sure we have a column to group by
+	if ((aCol < 0) || (aCol >= aTable.getNumColumns())) {
+		std::ostringstream	msg;
+		msg << "CKTableGroups::CKTableGroups(const CKTable &, int) - the "
+			"provided column: " << aCol << " lies outside the currently "
+			"defined table: " << aTable.getNumRows() << " by " <<
+			aTable.getNumColumns();
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	/*
+	 * The strings are made for all the rows at once - on several threads
+	 * if there are a lot of them - and then each one is looked up in an
+	 * index of the groups so far, in order, so the groups are numbered
+	 * by their first rows.
+	 */
+	int							rows = aTable.getNumRows();
+	std::vector<std::string>	keys;
+	aTable.getGroupKeys(aCol, keys);
+
+	CKLabelIndex	index;
+	mGroupOfRow.resize(rows);
+	for (int i = 0; i < rows; ++i) {
+		std::string	& key = keys[i];
+		int			g = index.get(key.data(), key.size());
+		if (g < 0) {
+			g = mKeys.size();
+			index.put(CKString(key), g);
+			mKeys.push_back(std::string());
+			mKeys.back().swap(key);
+			mSizes.push_back(0);
+		}
+		mGroupOfRow[i] = g;
+		++mSizes[g];
+	}
+}
+
+
+/*
+ * This is the standard copy constructor and needs to be in every
+ * class to make sure that we don't have too many things running
+ * around.
+ */
+CKTableGroups::CKTableGroups( const CKTableGroups & anOther ) :
+	mTable(NULL),
+	mColumn(-1),
+	mGroupOfRow(),
+	mKeys(),
+	mSizes()
+{
+	// let the operator=() do all the work for me
+	*this = anOther;
+}
+
+
+/*
+ * This is the standard destructor and needs to be virtual to make
+ * sure that if we subclass off this, the right destructor will be
+ * called.
+ */
+CKTableGroups::~CKTableGroups()
+{
+	// the table isn't ours, so there's nothing to drop
+}
+
+
+/*
+ * When we want to process the result of an equality we need to
+ * make sure that we do this right by always having an equals
+ * operator on all classes.
+ */
+CKTableGroups & CKTableGroups::operator=( const CKTableGroups & anOther )
+{
+	// make sure that we don't do this to ourselves
+	if (this != & anOther) {
+		mTable = anOther.mTable;
+		mColumn = anOther.mColumn;
+		mGroupOfRow = anOther.mGroupOfRow;
+		mKeys = anOther.mKeys;
+		mSizes = anOther.mSizes;
+	}
+	return *this;
+}
+
+
+/********************************************************
+ *
+ *                Accessor Methods
+ *
+ ********************************************************/
+/*
+ * These return the table and the column the rows are grouped
+ * by.
+ */
+const CKTable & CKTableGroups::getTable() const
+{
+	return *mTable;
+}
+
+
+int CKTableGroups::getColumn() const
+{
+	return mColumn;
+}
+
+
+/*
+ * This returns the number of groups - the number of different
+ * values in the column.
+ */
+int CKTableGroups::getNumGroups() const
+{
+	return mKeys.size();
+}
+
+
+/*
+ * These return the value the group is for, and the number of
+ * rows in it.
+ */
+CKString CKTableGroups::getGroupKey( int aGroup ) const
+{
+	// first, make sure we have the group they want
+	if ((aGroup < 0) || (aGroup >= (int)mKeys.size())) {
+		std::ostringstream	msg;
+		msg << "CKTableGroups::getGroupKey(int) - the provided group: " <<
+			aGroup << " isn't one of the " << mKeys.size() << " groups.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	return valueOfKey(mKeys[aGroup]);
+}
+
+
+int CKTableGroups::getGroupSize( int aGroup ) const
+{
+	// first, make sure we have the group they want
+	if ((aGroup < 0) || (aGroup >= (int)mSizes.size())) {
+		std::ostringstream	msg;
+		msg << "CKTableGroups::getGroupSize(int) - the provided group: " <<
+			aGroup << " isn't one of the " << mSizes.size() << " groups.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	return mSizes[aGroup];
+}
+
+
+/*
+ * These return the group a row is in, and all the rows, in order,
+ * that are in a group.
+ */
+int CKTableGroups::getGroupOfRow( int aRow ) const
+{
+	// first, make sure we have the row they want
+	if ((aRow < 0) || (aRow >= (int)mGroupOfRow.size())) {
+		std::ostringstream	msg;
+		msg << "CKTableGroups::getGroupOfRow(int) - the provided row: " <<
+			aRow << " isn't one of the " << mGroupOfRow.size() << " rows "
+			"that were grouped.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	return mGroupOfRow[aRow];
+}
+
+
+CKVector<int> CKTableGroups::getRowsInGroup( int aGroup ) const
+{
+	CKVector<int>	retval(getGroupSize(aGroup));
+	int				rows = mGroupOfRow.size();
+	for (int i = 0; i < rows; ++i) {
+		if (mGroupOfRow[i] == aGroup) {
+			retval.addToEnd(i);
+		}
+	}
+	return retval;
+}
+
+
+/********************************************************
+ *
+ *                Aggregation Methods
+ *
+ ********************************************************/
+/*
+ * These sum up the numbers in the columns for each group, and
+ * return a table with a row for each group - labelled with its
+ * value - and a column of numbers for each column, with the same
+ * header. Only the numbers in a column are counted. The sum and
+ * count of a group without any are zero, and its mean, minimum
+ * and maximum are left empty. The first form does every column
+ * but the one the rows are grouped by. On a big table, the
+ * columns are done at the same time on the table's parallel
+ * executor, each just as it would be on the calling thread.
+ */
+CKTable CKTableGroups::aggregate( CKTableAggregate anOp ) const
+{
+	int				cnt = mTable->getNumColumns();
+	CKVector<int>	cols(cnt);
+	for (int j = 0; j < cnt; ++j) {
+		if (j != mColumn) {
+			cols.addToEnd(j);
+		}
+	}
+	return aggregate(cols, anOp);
+}
+
+
+CKTable CKTableGroups::aggregate( int aCol, CKTableAggregate anOp ) const
+{
+	CKVector<int>	cols(1);
+	cols.addToEnd(aCol);
+	return aggregate(cols, anOp);
+}
+
+
+CKTable CKTableGroups::aggregate( const CKVector<int> & aCols, CKTableAggregate anOp ) const
+{
+	// first, make sure we have columns to sum up
+	int		colCnt = aCols.size();
+	if (colCnt == 0) {
+		std::ostringstream	msg;
+		msg << "CKTableGroups::aggregate(const CKVector<int> &, CKTableAggregate) - "
+			"there are no columns to sum up. There has to be at least one.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+	std::vector<int>	cols(colCnt);
+	for (int k = 0; k < colCnt; ++k) {
+		cols[k] = aCols[k];
+		if ((cols[k] < 0) || (cols[k] >= mTable->getNumColumns())) {
+			std::ostringstream	msg;
+			msg << "CKTableGroups::aggregate(const CKVector<int> &, CKTableAggregate) - "
+				"the provided column: " << cols[k] << " lies outside the "
+				"currently defined table: " << mTable->getNumRows() << " by " <<
+				mTable->getNumColumns();
+			throw CKException(__FILE__, __LINE__, msg.str());
+		}
+	}
+
+	// sum up each column, several at once if the table is big enough
+	int									groups = mKeys.size();
+	std::vector< std::vector<double> >	values(colCnt);
+	std::vector< std::vector<char> >	valid(colCnt);
+	CKTableAggregateTask	task(mTable, &cols, &mGroupOfRow, groups, anOp, &values, &valid);
+	if ((colCnt > 1) &&
+		CKTable::isWorthSplitting((double)mGroupOfRow.size() * colCnt)) {
+		CKTable::getParallelExecutor()->parallelFor(0, colCnt, task, 1);
+	} else {
+		task.execute(0, colCnt);
+	}
+
+	/*
+	 * The answer has a dense column of numbers for each column, and a
+	 * row for each group. If there are no groups - the table has no rows
+	 * - it's made with one, and then that's dropped.
+	 */
+	CKTable		retval((groups > 0 ? groups : 1), colCnt, eNumberVariant);
+	if (groups == 0) {
+		retval.selectRows(CKVector<int>());
+	}
+	for (int k = 0; k < colCnt; ++k) {
+		retval.setColumnHeader(k, mTable->getColumnHeader(cols[k]));
+		for (int g = 0; g < groups; ++g) {
+			if (valid[k][g]) {
+				retval.setDoubleValue(g, k, values[k][g]);
+			}
+		}
+	}
+	for (int g = 0; g < groups; ++g) {
+		retval.setRowLabel(g, valueOfKey(mKeys[g]));
+	}
+	return retval;
+}
@@ -0,0 +1,143 @@
+/*
+ * CKTableGroups.h - this file defines the grouping of the rows of a
+ *                   CKTable by the values in one of its columns, as made
+ *                   by CKTable::groupBy(). It's just the group number of
+ *                   each row and the value each group is for - nothing is
+ *                   copied out of the table - and aggregate() sums up the
+ *                   other columns of the table for each group into a new
+ *                   table with one row for each group.
+ *
+ * $Id$
+ */
+#ifndef __CKTABLEGROUPS_H
+#define __CKTABLEGROUPS_H
+
+//	System Headers
+#include <string>
+#include <vector>
+
+//	Third-Party Headers
+
+//	Other Headers
+#include "CKTable.h"
+#include "CKString.h"
+#include "CKVector.h"
+
+//	Forward Declarations
+
+//	Public Constants
+
+//	Public Datatypes
+
+//	Public Data Constants
+
+
+
+/*
+ * This is the main class definition.
+ */
+class CKTableGroups
+{
+	public:
+		/********************************************************
+		 *
+		 *                Constructors/Destructor
+		 *
+		 ********************************************************/
+		/*
+		 * This groups the rows of the table by the value in the column,
+		 * and it's what CKTable::groupBy() uses. The groups are numbered
+		 * in the order their first rows are in the table. Values of
+		 * different types - the number 1 and the string "1" - are in
+		 * different groups, -0 and 0 are in the same one, and the empty
+		 * cells are a group of their own - apart from any empty strings.
+		 * The table isn't copied, so it has to be left alone while the
+		 * groups are used.
+		 */
+		CKTableGroups( const CKTable & aTable, int aCol );
+		/*
+		 * This is the standard copy constructor and needs to be in every
+		 * class to make sure that we don't have too many things running
+		 * around.
+		 */
+		CKTableGroups( const CKTableGroups & anOther );
+		/*
+		 * This is the standard destructor and needs to be virtual to make
+		 * sure that if we subclass off this, the right destructor will be
+		 * called.
+		 */
+		virtual ~CKTableGroups();
+
+		/*
+		 * When we want to process the result of an equality we need to
+		 * make sure that we do this right by always having an equals
+		 * operator on all classes.
+		 */
+		CKTableGroups & operator=( const CKTableGroups & anOther );
+
+		/********************************************************
+		 *
+		 *                Accessor Methods
+		 *
+		 ********************************************************/
+		/*
+		 * These return the table and the column the rows are grouped
+		 * by.
+		 */
+		const CKTable & getTable() const;
+		int getColumn() const;
+		/*
+		 * This returns the number of groups - the number of different
+		 * values in the column.
+		 */
+		int getNumGroups() const;
+		/*
+		 * These return the value the group is for, and the number of
+		 * rows in it.
+		 */
+		CKString getGroupKey( int aGroup ) const;
+		int getGroupSize( int aGroup ) const;
+		/*
+		 * These return the group a row is in, and all the rows, in order,
+		 * that are in a group.
+		 */
+		int getGroupOfRow( int aRow ) const;
+		CKVector<int> getRowsInGroup( int aGroup ) const;
+
+		/********************************************************
+		 *
+		 *                Aggregation Methods
+		 *
+		 ********************************************************/
+		/*
+		 * These sum up the numbers in the columns for each group, and
+		 * return a table with a row for each group - labelled with its
+		 * value - and a column of numbers for each column, with the same
+		 * header. Only the numbers in a column are counted. The sum and
+		 * count of a group without any are zero, and its mean, minimum
+		 * and maximum are left empty. The first form does every column
+		 * but the one the rows are grouped by. On a big table, the
+		 * columns are done at the same time on the table's parallel
+		 * executor, each just as it would be on the calling thread.
+		 */
+		CKTable aggregate( CKTableAggregate anOp ) const;
+		CKTable aggregate( int aCol, CKTableAggregate anOp ) const;
+		CKTable aggregate( const CKVector<int> & aCols, CKTableAggregate anOp ) const;
+
+	private:
+		/*
+		 * This is the table the rows are in, and the column they're
+		 * grouped by.
+		 */
+		const CKTable				*mTable;
+		int							mColumn;
+		/*
+		 * This is the group number of each row of the table, and the
+		 * value and number of rows of each group.
+		 */
+		std::vector<int>			mGroupOfRow;
+		std::vector<std::string>	mKeys;
+		std::vector<int>			mSizes;
+};
+
+#endif	// __CKTABLEGROUPS_H
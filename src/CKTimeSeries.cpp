@@ -24,6 +24,8 @@
 #include "CKException.h"
 #include "CKTable.h"
 #include "CKTimeSeries.h"
+#include "CKStackLocker.h"
+#include "CKBinaryCodec.h"
 
 //	Forward Declarations
 
@@ -32,6 +34,26 @@
 //	Public Datatypes
 
 //	Public Data Constants
+/*
+ * When two series are combined point by point, his dates are taken in
+ * order and my series is walked right along with them, so it's one
+ * pass over each instead of a lookup in mine for every one of his.
+ * This moves 'aPos' up to the first of my points at or after 'aDate',
+ * stepping along for a few points and then jumping with a lookup, so
+ * a short series against a long one doesn't walk all of the long one.
+ */
+static std::map<double, double>::iterator seekDate( std::map<double, double> & aSeries,
+													std::map<double, double>::iterator aPos,
+													double aDate )
+{
+	for (int steps = 0; (aPos != aSeries.end()) && ((*aPos).first < aDate); ++steps) {
+		if (steps == 8) {
+			return aSeries.lower_bound(aDate);
+		}
+		++aPos;
+	}
+	return aPos;
+}
 
 
 /********************************************************
@@ -1165,17 +1187,17 @@ bool CKTimeSeries::add( CKTimeSeries & aSeries )
 
 		// loop over all his data
 		std::map<double, double>::iterator	i;
-		std::map<double, double>::iterator	j;
+		std::map<double, double>::iterator	j = mTimeseries.begin();
 		for (i = aSeries.mTimeseries.begin();
 			 i != aSeries.mTimeseries.end(); ++i) {
-			// try to find this date in *my* series
-			j = mTimeseries.find((*i).first);
-			if (j != mTimeseries.end()) {
+			// walk *my* series up to this date
+			j = seekDate(mTimeseries, j, (*i).first);
+			if ((j != mTimeseries.end()) && ((*j).first == (*i).first)) {
 				// OK, we have something that matches
 				(*j).second += (*i).second;
 			} else {
-				// no match, so add the point as-is to my series
-				mTimeseries[(*i).first] = (*i).second;
+				// no match, so add the point as-is to my series right here
+				j = mTimeseries.insert(j, std::pair<const double, double>((*i).first, (*i).second));
 			}
 		}
 
@@ -1238,17 +1260,17 @@ bool CKTimeSeries::subtract( CKTimeSeries & aSeries )
 
 		// loop over all his data
 		std::map<double, double>::iterator	i;
-		std::map<double, double>::iterator	j;
+		std::map<double, double>::iterator	j = mTimeseries.begin();
 		for (i = aSeries.mTimeseries.begin();
 			 i != aSeries.mTimeseries.end(); ++i) {
-			// try to find this date in *my* series
-			j = mTimeseries.find((*i).first);
-			if (j != mTimeseries.end()) {
+			// walk *my* series up to this date
+			j = seekDate(mTimeseries, j, (*i).first);
+			if ((j != mTimeseries.end()) && ((*j).first == (*i).first)) {
 				// OK, we have something that matches
 				(*j).second -= (*i).second;
 			} else {
-				// no match, so put the point in with the right sign
-				mTimeseries[(*i).first] = -1.0 * (*i).second;
+				// no match, so put the point in right here with the right sign
+				j = mTimeseries.insert(j, std::pair<const double, double>((*i).first, -1.0 * (*i).second));
 			}
 		}
 
@@ -1311,12 +1333,12 @@ bool CKTimeSeries::multiply( CKTimeSeries & aSeries )
 
 		// loop over all his data
 		std::map<double, double>::iterator	i;
-		std::map<double, double>::iterator	j;
+		std::map<double, double>::iterator	j = mTimeseries.begin();
 		for (i = aSeries.mTimeseries.begin();
 			 i != aSeries.mTimeseries.end(); ++i) {
-			// try to find this date in *my* series
-			j = mTimeseries.find((*i).first);
-			if (j != mTimeseries.end()) {
+			// walk *my* series up to this date
+			j = seekDate(mTimeseries, j, (*i).first);
+			if ((j != mTimeseries.end()) && ((*j).first == (*i).first)) {
 				// OK, we have something that matches
 				(*j).second *= (*i).second;
 			}
@@ -1381,12 +1403,12 @@ bool CKTimeSeries::divide( CKTimeSeries & aSeries )
 
 		// loop over all his data
 		std::map<double, double>::iterator	i;
-		std::map<double, double>::iterator	j;
+		std::map<double, double>::iterator	j = mTimeseries.begin();
 		for (i = aSeries.mTimeseries.begin();
 			 i != aSeries.mTimeseries.end(); ++i) {
-			// try to find this date in *my* series
-			j = mTimeseries.find((*i).first);
-			if (j != mTimeseries.end()) {
+			// walk *my* series up to this date
+			j = seekDate(mTimeseries, j, (*i).first);
+			if ((j != mTimeseries.end()) && ((*j).first == (*i).first)) {
 				// OK, we have something that matches
 				(*j).second /= (*i).second;
 			}
@@ -2176,6 +2198,76 @@ void CKTimeSeries::takeValuesFromCode( const CKString & aCode )
 	mTimeseriesMutex.unlock();
 }
 
+/*
+ * These methods are the binary versions of the two above. The
+ * toBinary() method returns a complete code in the compact binary
+ * format - header and all - and fromBinary() takes one written by
+ * it and replaces what's in this time series with it. The codes can
+ * have any bytes in them, so they are std::strings and not CKStrings.
+ */
+std::string CKTimeSeries::toBinary() const
+{
+	std::string		buff;
+	CKBinaryWriter	writer(buff);
+	writer.putHeader(eBinaryTimeSeriesTag);
+	writeBinary(writer);
+	return buff;
+}
+
+
+void CKTimeSeries::fromBinary( const std::string & aCode )
+{
+	fromBinary(aCode.data(), aCode.size());
+}
+
+
+void CKTimeSeries::fromBinary( const char *aCode, int aLength )
+{
+	CKBinaryReader	reader(aCode, aLength);
+	reader.getHeader(eBinaryTimeSeriesTag);
+	readBinary(reader);
+	reader.checkAtEnd();
+}
+
+
+/*
+ * These methods write and read just the time series' value - no
+ * header - so that it can be nested in the code of something
+ * bigger. It's the count of the points and then the timestamp and
+ * value of each as raw doubles - so unlike the text code, nothing
+ * is lost to the formatting of the timestamps.
+ */
+void CKTimeSeries::writeBinary( CKBinaryWriter & aWriter ) const
+{
+	// lock up the map against change
+	CKStackLocker	lockem(&(((CKTimeSeries *)this)->mTimeseriesMutex));
+
+	aWriter.reserve(4 + 16 * mTimeseries.size());
+	aWriter.putUInt(mTimeseries.size());
+	std::map<double, double>::const_iterator	i;
+	for (i = mTimeseries.begin(); i != mTimeseries.end(); ++i) {
+		aWriter.putDouble(i->first);
+		aWriter.putDouble(i->second);
+	}
+}
+
+
+void CKTimeSeries::readBinary( CKBinaryReader & aReader )
+{
+	// lock up the map against change
+	CKStackLocker	lockem(&mTimeseriesMutex);
+
+	mTimeseries.clear();
+	int		cnt = aReader.getCount(16);
+	for (int i = 0; i < cnt; ++i) {
+		double	when = aReader.getDouble();
+		double	value = aReader.getDouble();
+		// they were written in order, so they all go on the end of the map
+		mTimeseries.insert(mTimeseries.end(), std::make_pair(when, value));
+	}
+}
+
+
 
 /*
  * This method checks to see if the two CKTimeSeries are equal to one
@@ -19,6 +19,7 @@
 //	Other Headers
 #include "CKTimeTable.h"
 #include "CKStackLocker.h"
+#include "CKBinaryCodec.h"
 
 //	Forward Declarations
 
@@ -2989,6 +2990,112 @@ void CKTimeTable::takeValuesFromCode( const CKString & aCode )
 	mDefaultColumnHeaders = defaultColHeaders;
 }
 
+/*
+ * These methods are the binary versions of the two above. The
+ * toBinary() method returns a complete code in the compact binary
+ * format - header and all - and fromBinary() takes one written by
+ * it and replaces what's in this time table with it. The codes can
+ * have any bytes in them, so they are std::strings and not CKStrings.
+ */
+std::string CKTimeTable::toBinary() const
+{
+	std::string		buff;
+	CKBinaryWriter	writer(buff);
+	writer.putHeader(eBinaryTimeTableTag);
+	writeBinary(writer);
+	return buff;
+}
+
+
+void CKTimeTable::fromBinary( const std::string & aCode )
+{
+	fromBinary(aCode.data(), aCode.size());
+}
+
+
+void CKTimeTable::fromBinary( const char *aCode, int aLength )
+{
+	CKBinaryReader	reader(aCode, aLength);
+	reader.getHeader(eBinaryTimeTableTag);
+	readBinary(reader);
+	reader.checkAtEnd();
+}
+
+
+/*
+ * These methods write and read just the time table's value - no
+ * header - so that it can be nested in the code of something
+ * bigger. It's laid out like the text code - the default sizes,
+ * the default column headers and row labels, and then the date
+ * and table for each of the tables.
+ */
+void CKTimeTable::writeBinary( CKBinaryWriter & aWriter ) const
+{
+	// lock up the map against change
+	CKStackLocker	lockem(&(((CKTimeTable *)this)->mTablesMutex));
+
+	aWriter.putInt(mDefaultRowCount);
+	aWriter.putInt(mDefaultColumnCount);
+
+	int		cnt = mDefaultColumnHeaders.size();
+	aWriter.putUInt(cnt);
+	for (int i = 0; i < cnt; ++i) {
+		aWriter.putString(mDefaultColumnHeaders[i]);
+	}
+	cnt = mDefaultRowLabels.size();
+	aWriter.putUInt(cnt);
+	for (int i = 0; i < cnt; ++i) {
+		aWriter.putString(mDefaultRowLabels[i]);
+	}
+
+	aWriter.putUInt(mTables.size());
+	for (CKDateTableMap::const_iterator i = mTables.begin(); i != mTables.end(); ++i) {
+		aWriter.putInt((int)i->first);
+		i->second.writeBinary(aWriter);
+	}
+}
+
+
+void CKTimeTable::readBinary( CKBinaryReader & aReader )
+{
+	// lock up the map against change
+	CKStackLocker	lockem(&mTablesMutex);
+
+	// read the defaults into locals in case the code is bad
+	int		defaultRowCnt = aReader.getInt();
+	int		defaultColCnt = aReader.getInt();
+	CKStringList	defaultColHeaders;
+	int		cnt = aReader.getCount(4);
+	for (int i = 0; i < cnt; ++i) {
+		CKString	header;
+		aReader.getString(header);
+		defaultColHeaders.addToEnd(header);
+	}
+	CKStringList	defaultRowLabels;
+	cnt = aReader.getCount(4);
+	for (int i = 0; i < cnt; ++i) {
+		CKString	label;
+		aReader.getString(label);
+		defaultRowLabels.addToEnd(label);
+	}
+
+	// now read each of the tables right into the map
+	mTables.clear();
+	cnt = aReader.getCount(12);
+	for (int i = 0; i < cnt; ++i) {
+		long	when = aReader.getInt();
+		CKDateTableMap::iterator	t = mTables.insert(mTables.end(),
+											std::make_pair(when, CKTable()));
+		t->second.readBinary(aReader);
+	}
+
+	mDefaultRowCount = defaultRowCnt;
+	mDefaultColumnCount = defaultColCnt;
+	mDefaultRowLabels = defaultRowLabels;
+	mDefaultColumnHeaders = defaultColHeaders;
+}
+
+
 
 /*
  * Because there may be times that the user wants to lock us up
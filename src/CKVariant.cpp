@@ -17,6 +17,7 @@
 #include <math.h>
 #include <stdio.h>
 #include <strings.h>
+#include <new>
 
 //	Third-Party Headers
 
@@ -28,14 +29,93 @@
 #include "CKPrice.h"
 #include "CKException.h"
 #include "CKStackLocker.h"
+#include "CKBinaryCodec.h"
+#include "CKFWAtomic.h"
 
 //	Forward Declarations
 
 //	Private Constants
+/*
+ * This is the number of locks that the decoding of the lazy values is
+ * spread over. A variant uses the one picked by its address.
+ */
+#define	CKVARIANT_LAZY_LOCKS		64
 
 //	Private Datatypes
+/*
+ * This is a table, time series or time table that's still in the code
+ * it was read from, waiting for someone to need it.
+ */
+struct CKVariantLazyValue
+{
+	// this is the code - text or binary - without its type prefix
+	std::string		code;
+	// ...and this is true if it's a binary code
+	bool			binary;
+};
 
 //	Private Data Constants
+bool CKVariant::sLazyDecoding = false;
+
+/*
+ * The prices are built in the same inline space as the strings, so make
+ * sure that the compiler stops us if a CKPrice ever outgrows a CKString.
+ */
+typedef char CKVariantPriceFitsInline[(sizeof(CKPrice) <= sizeof(CKString)) ? 1 : -1];
+
+/*
+ * This reads one of the nested values - a table, time series, list
+ * or time table - out of its block in a binary code into a new one
+ * and makes sure the whole block was used. If anything goes wrong
+ * the new value is deleted before the exception goes on.
+ */
+template <class T> static T *readNestedValue( CKBinaryReader & aReader )
+{
+	T		*retval = new T();
+	try {
+		retval->readBinary(aReader);
+		aReader.checkAtEnd();
+	} catch (...) {
+		delete retval;
+		throw;
+	}
+	return retval;
+}
+
+
+/*
+ * This decodes one of the lazy values into a new one of the right
+ * type - using the binary or text decoding as the code calls for.
+ */
+template <class T> static T *decodeLazyValue( const CKVariantLazyValue & aLazy )
+{
+	if (aLazy.binary) {
+		CKBinaryReader	reader(aLazy.code.data(), aLazy.code.size());
+		return readNestedValue<T>(reader);
+	}
+
+	T		*retval = new T();
+	try {
+		retval->takeValuesFromCode(CKString(aLazy.code.data(), 0, aLazy.code.size()));
+	} catch (...) {
+		delete retval;
+		throw;
+	}
+	return retval;
+}
+
+
+/*
+ * This returns the lock that guards the decoding of the lazy value
+ * in the given variant. The lock can't be in the lazy value itself as
+ * that's deleted once it's decoded, while another thread might still
+ * be waiting to get in.
+ */
+static CKFWMutex *lazyLock( const void *aVariant )
+{
+	static CKFWMutex	*locks = new CKFWMutex[CKVARIANT_LAZY_LOCKS];
+	return &locks[((unsigned long)aVariant >> 4) % CKVARIANT_LAZY_LOCKS];
+}
 
 
 
@@ -51,7 +131,9 @@
  */
 CKVariant::CKVariant() :
 	mType(eUnknownVariant),
-	mStringValue(NULL)
+	mInlineBuilt(false),
+	mLazy(false),
+	mTableValue(NULL)
 {
 }
 
@@ -67,7 +149,9 @@ CKVariant::CKVariant() :
  */
 CKVariant::CKVariant( CKVariantType aType, const char *aValue ) :
 	mType(eUnknownVariant),
-	mStringValue(NULL)
+	mInlineBuilt(false),
+	mLazy(false),
+	mTableValue(NULL)
 {
 	setValueAsType(aType, aValue);
 }
@@ -82,7 +166,9 @@ CKVariant::CKVariant( CKVariantType aType, const char *aValue ) :
  */
 CKVariant::CKVariant( const char *aStringValue ) :
 	mType(eUnknownVariant),
-	mStringValue(NULL)
+	mInlineBuilt(false),
+	mLazy(false),
+	mTableValue(NULL)
 {
 	setStringValue(aStringValue);
 }
@@ -90,7 +176,9 @@ CKVariant::CKVariant( const char *aStringValue ) :
 
 CKVariant::CKVariant( const CKString *aStringValue ) :
 	mType(eUnknownVariant),
-	mStringValue(NULL)
+	mInlineBuilt(false),
+	mLazy(false),
+	mTableValue(NULL)
 {
 	setStringValue(aStringValue);
 }
@@ -103,7 +191,9 @@ CKVariant::CKVariant( const CKString *aStringValue ) :
  */
 CKVariant::CKVariant( int anIntValue ) :
 	mType(eUnknownVariant),
-	mStringValue(NULL)
+	mInlineBuilt(false),
+	mLazy(false),
+	mTableValue(NULL)
 {
 	setDoubleValue((double)anIntValue);
 }
@@ -116,7 +206,9 @@ CKVariant::CKVariant( int anIntValue ) :
  */
 CKVariant::CKVariant( long aDateValue ) :
 	mType(eUnknownVariant),
-	mStringValue(NULL)
+	mInlineBuilt(false),
+	mLazy(false),
+	mTableValue(NULL)
 {
 	setDateValue(aDateValue);
 }
@@ -129,7 +221,9 @@ CKVariant::CKVariant( long aDateValue ) :
  */
 CKVariant::CKVariant( double aDoubleValue ) :
 	mType(eUnknownVariant),
-	mStringValue(NULL)
+	mInlineBuilt(false),
+	mLazy(false),
+	mTableValue(NULL)
 {
 	setDoubleValue(aDoubleValue);
 }
@@ -144,7 +238,9 @@ CKVariant::CKVariant( double aDoubleValue ) :
  */
 CKVariant::CKVariant( const CKTable *aTableValue ) :
 	mType(eUnknownVariant),
-	mStringValue(NULL)
+	mInlineBuilt(false),
+	mLazy(false),
+	mTableValue(NULL)
 {
 	setTableValue(aTableValue);
 }
@@ -159,7 +255,9 @@ CKVariant::CKVariant( const CKTable *aTableValue ) :
  */
 CKVariant::CKVariant( const CKTimeSeries *aTimeSeriesValue ) :
 	mType(eUnknownVariant),
-	mStringValue(NULL)
+	mInlineBuilt(false),
+	mLazy(false),
+	mTableValue(NULL)
 {
 	setTimeSeriesValue(aTimeSeriesValue);
 }
@@ -174,7 +272,9 @@ CKVariant::CKVariant( const CKTimeSeries *aTimeSeriesValue ) :
  */
 CKVariant::CKVariant( const CKPrice *aPriceValue ) :
 	mType(eUnknownVariant),
-	mStringValue(NULL)
+	mInlineBuilt(false),
+	mLazy(false),
+	mTableValue(NULL)
 {
 	setPriceValue(aPriceValue);
 }
@@ -189,7 +289,9 @@ CKVariant::CKVariant( const CKPrice *aPriceValue ) :
  */
 CKVariant::CKVariant( const CKVariantList *aListValue ) :
 	mType(eUnknownVariant),
-	mStringValue(NULL)
+	mInlineBuilt(false),
+	mLazy(false),
+	mTableValue(NULL)
 {
 	setListValue(aListValue);
 }
@@ -204,7 +306,9 @@ CKVariant::CKVariant( const CKVariantList *aListValue ) :
  */
 CKVariant::CKVariant( const CKTimeTable *aTimeTableValue ) :
 	mType(eUnknownVariant),
-	mStringValue(NULL)
+	mInlineBuilt(false),
+	mLazy(false),
+	mTableValue(NULL)
 {
 	setTimeTableValue(aTimeTableValue);
 }
@@ -217,12 +321,31 @@ CKVariant::CKVariant( const CKTimeTable *aTimeTableValue ) :
  */
 CKVariant::CKVariant( const CKVariant & anOther ) :
 	mType(eUnknownVariant),
-	mStringValue(NULL)
+	mInlineBuilt(false),
+	mLazy(false),
+	mTableValue(NULL)
 {
 	*this = anOther;
 }
 
 
+#if __cplusplus >= 201103L
+/*
+ * This is the move constructor that takes the value right out of
+ * the other variant - the tables, series and lists just change
+ * hands - and leaves the other one empty (eUnknownVariant).
+ */
+CKVariant::CKVariant( CKVariant && anOther ) :
+	mType(eUnknownVariant),
+	mInlineBuilt(false),
+	mLazy(false),
+	mTableValue(NULL)
+{
+	takeValueFrom(anOther);
+}
+#endif
+
+
 /*
  * This is the standard destructor and needs to be virtual to make
  * sure that if we subclass off this the right destructor will be
@@ -248,12 +371,20 @@ CKVariant & CKVariant::operator=( CKVariant & anOther )
 	 * the variable. This is bad. So we protect against it.
 	 */
 	if (this != & anOther) {
+		// a value that's still in its code is copied as the code
+		std::string		code;
+		bool			binary = false;
+		if (anOther.copyLazyCode(code, binary)) {
+			setLazyValue(anOther.mType, code.data(), code.size(), binary);
+			return *this;
+		}
+
 		switch (anOther.mType) {
 			case eUnknownVariant:
 				clearValue();
 				break;
 			case eStringVariant:
-				setStringValue(anOther.mStringValue);
+				setStringValue(anOther.stringValue());
 				break;
 			case eNumberVariant:
 				setDoubleValue(anOther.mDoubleValue);
@@ -268,7 +399,7 @@ CKVariant & CKVariant::operator=( CKVariant & anOther )
 				setTimeSeriesValue(anOther.mTimeSeriesValue);
 				break;
 			case ePriceVariant:
-				setPriceValue(anOther.mPriceValue);
+				setPriceValue(anOther.priceValue());
 				break;
 			case eListVariant:
 				setListValue(anOther.mListValue);
@@ -289,6 +420,41 @@ CKVariant & CKVariant::operator=( const CKVariant & anOther )
 }
 
 
+#if __cplusplus >= 201103L
+CKVariant & CKVariant::operator=( CKVariant && anOther )
+{
+	if (this != & anOther) {
+		takeValueFrom(anOther);
+	}
+	return *this;
+}
+#endif
+
+
+/*
+ * This method exchanges the values of the two variants without
+ * copying any of the tables, series, lists or strings.
+ */
+void CKVariant::swap( CKVariant & anOther )
+{
+	if (this == & anOther) {
+		return;
+	}
+
+	if ((mType == eStringVariant) && (anOther.mType == eStringVariant) &&
+		(stringValue() != NULL) && (anOther.stringValue() != NULL)) {
+		// the most common case is easy - the strings swap buffers
+		stringValue()->swap(*anOther.stringValue());
+	} else {
+		// ...otherwise move them around through an empty variant
+		CKVariant	hold;
+		hold.takeValueFrom(*this);
+		takeValueFrom(anOther);
+		anOther.takeValueFrom(hold);
+	}
+}
+
+
 /*
  * When we want to make a simple assignment to a CKVariant, these
  * operators will make it easy to put the important data types in
@@ -432,7 +598,10 @@ void CKVariant::setValueAsType( CKVariantType aType, const char *aValue )
 			setDateValue(strtol(aValue, (char **)NULL, 10));
 			break;
 		case eTableVariant:
-			{
+			if (sLazyDecoding && (aValue != NULL)) {
+				// just hold on to the code until it's needed
+				setLazyValue(eTableVariant, aValue, strlen(aValue), false);
+			} else {
 				// make a table from the string representation
 				CKTable	tbl(aValue);
 				// ...and use that as the value
@@ -440,7 +609,10 @@ void CKVariant::setValueAsType( CKVariantType aType, const char *aValue )
 			}
 			break;
 		case eTimeSeriesVariant:
-			{
+			if (sLazyDecoding && (aValue != NULL)) {
+				// just hold on to the code until it's needed
+				setLazyValue(eTimeSeriesVariant, aValue, strlen(aValue), false);
+			} else {
 				// make a time series from the string representation
 				CKTimeSeries	ts(aValue);
 				// ...and use that as the value
@@ -464,7 +636,10 @@ void CKVariant::setValueAsType( CKVariantType aType, const char *aValue )
 			}
 			break;
 		case eTimeTableVariant:
-			{
+			if (sLazyDecoding && (aValue != NULL)) {
+				// just hold on to the code until it's needed
+				setLazyValue(eTimeTableVariant, aValue, strlen(aValue), false);
+			} else {
 				// make a time table from the string representation
 				CKTimeTable		timetable(aValue);
 				// ...and use that as the value
@@ -490,18 +665,14 @@ void CKVariant::setStringValue( const char *aStringValue )
 	 * we'll just clear out this data. That's bad. So protect us from
 	 * it happening.
 	 */
-	if ((mType != eStringVariant) || (mStringValue == NULL) ||
-		(mStringValue->c_str() != aStringValue)) {
+	if ((mType != eStringVariant) || (stringValue() == NULL) ||
+		(stringValue()->c_str() != aStringValue)) {
 		// first, see if we need to delete what's might already be here
 		clearValue();
 		// next, if we have something to set, then create space for it
 		if (aStringValue != NULL) {
-			mStringValue = new CKString(aStringValue);
-			if (mStringValue == NULL) {
-				throw CKException(__FILE__, __LINE__, "CKVariant::setStringValue"
-					"(const char *) - the space to hold this string value could "
-					"not be created. This is a serious allocation error.");
-			}
+			new (mInlineValue) CKString(aStringValue);
+			mInlineBuilt = true;
 		}
 	}
 	// ...and don't forget to set the type of data we have now
@@ -519,17 +690,13 @@ void CKVariant::setStringValue( const CKString *aStringValue )
 	 * we'll just clear out this data. That's bad. So protect us from
 	 * it happening.
 	 */
-	if ((mType != eStringVariant) || (mStringValue != aStringValue)) {
+	if ((mType != eStringVariant) || (stringValue() != aStringValue)) {
 		// first, see if we need to delete what's might already be here
 		clearValue();
 		// next, if we have something to set, then create space for it
 		if (aStringValue != NULL) {
-			mStringValue = new CKString(*aStringValue);
-			if (mStringValue == NULL) {
-				throw CKException(__FILE__, __LINE__, "CKVariant::setStringValue"
-					"(const char *) - the space to hold this string value could "
-					"not be created. This is a serious allocation error.");
-			}
+			new (mInlineValue) CKString(*aStringValue);
+			mInlineBuilt = true;
 		}
 	}
 	// ...and don't forget to set the type of data we have now
@@ -650,17 +817,13 @@ void CKVariant::setPriceValue( const CKPrice *aPriceValue )
 	 * we'll just clear out this data. That's bad. So protect us from
 	 * it happening.
 	 */
-	if ((mType != ePriceVariant) || (mPriceValue != aPriceValue)) {
+	if ((mType != ePriceVariant) || (priceValue() != aPriceValue)) {
 		// first, see if we need to delete what's might already be here
 		clearValue();
 		// next, if we have something to set, then create space for it
 		if (aPriceValue != NULL) {
-			mPriceValue = new CKPrice(*aPriceValue);
-			if (mPriceValue == NULL) {
-				throw CKException(__FILE__, __LINE__, "CKVariant::setPriceValue("
-					"const CKPrice *) - the copy of this price value could not be "
-					"created. This is a serious allocation error.");
-			}
+			new (mInlineValue) CKPrice(*aPriceValue);
+			mInlineBuilt = true;
 		}
 	}
 	// ...and don't forget to set the type of data we have now
@@ -816,7 +979,7 @@ const CKString *CKVariant::getStringValue() const
 			"the data contained in this instance is not a string and therefore "
 			"we can't get a string value from it.");
 	}
-	return mStringValue;
+	return stringValue();
 }
 
 
@@ -833,6 +996,7 @@ const CKTable *CKVariant::getTableValue() const
 			"the data contained in this instance is not a table and therefore "
 			"we can't get a table value from it.");
 	}
+	resolve();
 	return mTableValue;
 }
 
@@ -850,6 +1014,7 @@ const CKTimeSeries *CKVariant::getTimeSeriesValue() const
 			"the data contained in this instance is not a time series and "
 			"therefore we can't get a time series value from it.");
 	}
+	resolve();
 	return mTimeSeriesValue;
 }
 
@@ -867,7 +1032,7 @@ const CKPrice *CKVariant::getPriceValue() const
 			"the data contained in this instance is not a price and "
 			"therefore we can't get a price value from it.");
 	}
-	return mPriceValue;
+	return priceValue();
 }
 
 
@@ -901,6 +1066,7 @@ const CKTimeTable *CKVariant::getTimeTableValue() const
 			"the data contained in this instance is not a time table and "
 			"therefore we can't get a time table value from it.");
 	}
+	resolve();
 	return mTimeTableValue;
 }
 
@@ -1009,14 +1175,22 @@ CKVariant::operator CKTimeTable *() const
  */
 void CKVariant::clearValue()
 {
+	// a value that's still in its code just needs the code dropped
+	if (!isDecoded()) {
+		delete mLazyValue;
+		mLazyValue = NULL;
+		mLazy = false;
+	}
+
 	// first, free up any memory used by the current value
 	switch(mType) {
 		case eUnknownVariant:
 			break;
 		case eStringVariant:
-			if (mStringValue != NULL) {
-				delete mStringValue;
-				mStringValue = NULL;
+			if (stringValue() != NULL) {
+				// it's in our inline space, so just destroy it
+				stringValue()->~CKString();
+				mInlineBuilt = false;
 			}
 			break;
 		case eNumberVariant:
@@ -1036,9 +1210,10 @@ void CKVariant::clearValue()
 			}
 			break;
 		case ePriceVariant:
-			if (mPriceValue != NULL) {
-				delete mPriceValue;
-				mPriceValue = NULL;
+			if (priceValue() != NULL) {
+				// it's in our inline space, so just destroy it
+				priceValue()->~CKPrice();
+				mInlineBuilt = false;
 			}
 			break;
 		case eListVariant:
@@ -1061,6 +1236,41 @@ void CKVariant::clearValue()
 
 	// don't forget to set it to 'unknown'
 	mType = eUnknownVariant;
+	mInlineBuilt = false;
+	mTableValue = NULL;
+}
+
+
+/*
+ * When lazy decoding is turned on, the tables, time series and
+ * time tables that are read from a code - text or binary - are
+ * kept as their codes until something actually needs them, and
+ * then they are decoded - just once, even if several threads ask
+ * for them at the same time. Loading a big tree where most of the
+ * values are never looked at is then a lot cheaper. It's off by
+ * default, and it's for the whole process. The catch is that a bad
+ * code isn't found until the value is first used.
+ */
+void CKVariant::setLazyDecoding( bool aFlag )
+{
+	sLazyDecoding = aFlag;
+}
+
+
+bool CKVariant::isLazyDecoding()
+{
+	return sLazyDecoding;
+}
+
+
+/*
+ * This returns false if this variant is holding a value that's
+ * still waiting to be decoded from its code, and true otherwise.
+ */
+bool CKVariant::isDecoded() const
+{
+	return !(((mType == eTableVariant) || (mType == eTimeSeriesVariant) ||
+			  (mType == eTimeTableVariant)) && mLazy);
 }
 
 
@@ -1269,6 +1479,8 @@ bool CKVariant::isList( const char *aValue )
  */
 CKString CKVariant::getValueAsString() const
 {
+	resolve();
+
 	// first, create a string and then set it's value
 	CKString		retval;
 	switch (mType) {
@@ -1276,7 +1488,7 @@ CKString CKVariant::getValueAsString() const
 			retval += "<unknown>";
 			break;
 		case eStringVariant:
-			retval += *mStringValue;
+			retval += *stringValue();
 			break;
 		case eNumberVariant:
 			retval += mDoubleValue;
@@ -1299,10 +1511,10 @@ CKString CKVariant::getValueAsString() const
 			}
 			break;
 		case ePriceVariant:
-			if (mPriceValue == NULL) {
+			if (priceValue() == NULL) {
 				retval += "NULL";
 			} else {
-				retval += mPriceValue->toString();
+				retval += priceValue()->toString();
 			}
 			break;
 		case eListVariant:
@@ -1347,12 +1559,24 @@ std::string CKVariant::getValueAsSTLString() const
 CKString CKVariant::generateCodeFromValues() const
 {
 	CKString buff;
+
+	// a value that's still in its text code can just be passed along
+	std::string		code;
+	bool			binary = false;
+	if (copyLazyCode(code, binary) && !binary) {
+		buff.append(mType == eTableVariant ? "T:" :
+			(mType == eTimeSeriesVariant ? "L:" : "R:"));
+		buff.append(code.data(), code.size());
+		return buff;
+	}
+	resolve();
+
 	switch (getType()) {
 		case eUnknownVariant:
 			buff.append("U:");
 			break;
 		case eStringVariant:
-			buff.append("S:").append(*mStringValue);
+			buff.append("S:").append(*stringValue());
 			break;
 		case eNumberVariant:
 			buff.append("N:").append(mDoubleValue);
@@ -1375,10 +1599,10 @@ CKString CKVariant::generateCodeFromValues() const
 			}
 			break;
 		case ePriceVariant:
-			if (mPriceValue == NULL) {
+			if (priceValue() == NULL) {
 				buff.append("U:");
 			} else {
-				buff.append("P:").append(mPriceValue->generateCodeFromValues());
+				buff.append("P:").append(priceValue()->generateCodeFromValues());
 			}
 			break;
 		case eListVariant:
@@ -1446,6 +1670,228 @@ void CKVariant::takeValuesFromCode( const CKString & aCode )
 	}
 }
 
+/*
+ * These methods are the binary versions of the two above. The
+ * toBinary() method returns a complete code in the compact binary
+ * format - header and all - and fromBinary() takes one written by
+ * it and replaces what's in this variant with it. The codes can
+ * have any bytes in them, so they are std::strings and not CKStrings.
+ */
+std::string CKVariant::toBinary() const
+{
+	std::string		buff;
+	CKBinaryWriter	writer(buff);
+	writer.putHeader(eBinaryUnknownTag);
+	writeBinary(writer);
+	return buff;
+}
+
+
+void CKVariant::fromBinary( const std::string & aCode )
+{
+	fromBinary(aCode.data(), aCode.size());
+}
+
+
+void CKVariant::fromBinary( const char *aCode, int aLength )
+{
+	CKBinaryReader	reader(aCode, aLength);
+	reader.getHeader(eBinaryUnknownTag);
+	readBinary(reader);
+	reader.checkAtEnd();
+}
+
+
+/*
+ * These methods write and read just the variant's value - no
+ * header - so that it can be nested in the code of something
+ * bigger. This is what toBinary() and fromBinary() are built on.
+ * Each value starts with its tag, and the tables, time series,
+ * lists and time tables are written as blocks so that a reader
+ * can step over them without decoding them.
+ */
+void CKVariant::writeBinary( CKBinaryWriter & aWriter ) const
+{
+	// a value that's still in its binary code can just be passed along
+	std::string		code;
+	bool			binary = false;
+	if (copyLazyCode(code, binary) && binary) {
+		aWriter.putByte(mType == eTableVariant ? eBinaryTableTag :
+			(mType == eTimeSeriesVariant ? eBinaryTimeSeriesTag : eBinaryTimeTableTag));
+		aWriter.putUInt(code.size());
+		aWriter.putBytes(code.data(), code.size());
+		return;
+	}
+	resolve();
+
+	int		mark = 0;
+	switch (getType()) {
+		case eStringVariant:
+			if (stringValue() == NULL) {
+				aWriter.putByte(eBinaryUnknownTag);
+			} else {
+				aWriter.putByte(eBinaryStringTag);
+				aWriter.putString(*stringValue());
+			}
+			break;
+		case eNumberVariant:
+			aWriter.putByte(eBinaryNumberTag);
+			aWriter.putDouble(mDoubleValue);
+			break;
+		case eDateVariant:
+			aWriter.putByte(eBinaryDateTag);
+			aWriter.putInt((int)mDateValue);
+			break;
+		case eTableVariant:
+			if (mTableValue == NULL) {
+				aWriter.putByte(eBinaryUnknownTag);
+			} else {
+				aWriter.putByte(eBinaryTableTag);
+				mark = aWriter.beginBlock();
+				mTableValue->writeBinary(aWriter);
+				aWriter.endBlock(mark);
+			}
+			break;
+		case eTimeSeriesVariant:
+			if (mTimeSeriesValue == NULL) {
+				aWriter.putByte(eBinaryUnknownTag);
+			} else {
+				aWriter.putByte(eBinaryTimeSeriesTag);
+				mark = aWriter.beginBlock();
+				mTimeSeriesValue->writeBinary(aWriter);
+				aWriter.endBlock(mark);
+			}
+			break;
+		case ePriceVariant:
+			if (priceValue() == NULL) {
+				aWriter.putByte(eBinaryUnknownTag);
+			} else {
+				aWriter.putByte(eBinaryPriceTag);
+				priceValue()->writeBinary(aWriter);
+			}
+			break;
+		case eListVariant:
+			if (mListValue == NULL) {
+				aWriter.putByte(eBinaryUnknownTag);
+			} else {
+				aWriter.putByte(eBinaryListTag);
+				mark = aWriter.beginBlock();
+				mListValue->writeBinary(aWriter);
+				aWriter.endBlock(mark);
+			}
+			break;
+		case eTimeTableVariant:
+			if (mTimeTableValue == NULL) {
+				aWriter.putByte(eBinaryUnknownTag);
+			} else {
+				aWriter.putByte(eBinaryTimeTableTag);
+				mark = aWriter.beginBlock();
+				mTimeTableValue->writeBinary(aWriter);
+				aWriter.endBlock(mark);
+			}
+			break;
+		default:
+			aWriter.putByte(eBinaryUnknownTag);
+			break;
+	}
+}
+
+
+void CKVariant::readBinary( CKBinaryReader & aReader )
+{
+	int				tag = aReader.getByte();
+	int				len = 0;
+	const char		*bytes = NULL;
+	switch (tag) {
+		case eBinaryUnknownTag:
+			clearValue();
+			break;
+		case eBinaryStringTag:
+			// build the string right from the bytes in the code
+			bytes = aReader.getStringBytes(len);
+			clearValue();
+			new (mInlineValue) CKString(bytes, 0, len);
+			mInlineBuilt = true;
+			mType = eStringVariant;
+			break;
+		case eBinaryNumberTag:
+			setDoubleValue(aReader.getDouble());
+			break;
+		case eBinaryDateTag:
+			setDateValue(aReader.getInt());
+			break;
+		case eBinaryTableTag:
+			{
+				CKBinaryReader	block = aReader.getBlock();
+				if (sLazyDecoding) {
+					len = block.getRemaining();
+					setLazyValue(eTableVariant, block.getBytes(len), len, true);
+					break;
+				}
+				CKTable			*table = readNestedValue<CKTable>(block);
+				clearValue();
+				mTableValue = table;
+				mType = eTableVariant;
+			}
+			break;
+		case eBinaryTimeSeriesTag:
+			{
+				CKBinaryReader	block = aReader.getBlock();
+				if (sLazyDecoding) {
+					len = block.getRemaining();
+					setLazyValue(eTimeSeriesVariant, block.getBytes(len), len, true);
+					break;
+				}
+				CKTimeSeries	*series = readNestedValue<CKTimeSeries>(block);
+				clearValue();
+				mTimeSeriesValue = series;
+				mType = eTimeSeriesVariant;
+			}
+			break;
+		case eBinaryPriceTag:
+			clearValue();
+			new (mInlineValue) CKPrice();
+			mInlineBuilt = true;
+			mType = ePriceVariant;
+			priceValue()->readBinary(aReader);
+			break;
+		case eBinaryListTag:
+			{
+				CKBinaryReader	block = aReader.getBlock();
+				CKVariantList	*list = readNestedValue<CKVariantList>(block);
+				clearValue();
+				mListValue = list;
+				mType = eListVariant;
+			}
+			break;
+		case eBinaryTimeTableTag:
+			{
+				CKBinaryReader	block = aReader.getBlock();
+				if (sLazyDecoding) {
+					len = block.getRemaining();
+					setLazyValue(eTimeTableVariant, block.getBytes(len), len, true);
+					break;
+				}
+				CKTimeTable		*timeTable = readNestedValue<CKTimeTable>(block);
+				clearValue();
+				mTimeTableValue = timeTable;
+				mType = eTimeTableVariant;
+			}
+			break;
+		default:
+			{
+				std::ostringstream	msg;
+				msg << "CKVariant::readBinary(CKBinaryReader &) - the tag " <<
+					tag << " at byte " << (aReader.getPosition() - 1) << " of the "
+					"code isn't one that a variant can hold. This is a bad binary "
+					"code and needs to be looked into.";
+				throw CKException(__FILE__, __LINE__, msg.str());
+			}
+			break;
+	}
+}
+
+
 
 /*
  * This method checks to see if the two CKVariants are equal to one
@@ -1455,6 +1901,9 @@ void CKVariant::takeValuesFromCode( const CKString & aCode )
  */
 bool CKVariant::operator==( const CKVariant & anOther ) const
 {
+	resolve();
+	anOther.resolve();
+
 	bool		equal = true;
 
 	// first, see if the types match
@@ -1470,15 +1919,15 @@ bool CKVariant::operator==( const CKVariant & anOther ) const
 				break;
 			case eStringVariant:
 				// two NULLs match in my opinion
-				if (mStringValue == NULL) {
-					if (anOther.mStringValue != NULL) {
+				if (stringValue() == NULL) {
+					if (anOther.stringValue() != NULL) {
 						equal = false;
 					}
 				} else {
-					if (anOther.mStringValue == NULL) {
+					if (anOther.stringValue() == NULL) {
 						equal = false;
 					} else {
-						if ((*mStringValue) != (*anOther.mStringValue)) {
+						if ((*stringValue()) != (*anOther.stringValue())) {
 							equal = false;
 						}
 					}
@@ -1528,15 +1977,15 @@ bool CKVariant::operator==( const CKVariant & anOther ) const
 				break;
 			case ePriceVariant:
 				// two NULLs match in my opinion
-				if (mPriceValue == NULL) {
-					if (anOther.mPriceValue != NULL) {
+				if (priceValue() == NULL) {
+					if (anOther.priceValue() != NULL) {
 						equal = false;
 					}
 				} else {
-					if (anOther.mPriceValue == NULL) {
+					if (anOther.priceValue() == NULL) {
 						equal = false;
 					} else {
-						if ((*mPriceValue) != (*anOther.mPriceValue)) {
+						if ((*priceValue()) != (*anOther.priceValue())) {
 							equal = false;
 						}
 					}
@@ -1617,8 +2066,8 @@ bool CKVariant::operator<( const CKVariant & anOther ) const
 			case eUnknownVariant:
 				break;
 			case eStringVariant:
-				if ((mStringValue != NULL) && (anOther.mStringValue != NULL)) {
-					less = mStringValue->operator<(*anOther.mStringValue);
+				if ((stringValue() != NULL) && (anOther.stringValue() != NULL)) {
+					less = stringValue()->operator<(*anOther.stringValue());
 				}
 				break;
 			case eNumberVariant:
@@ -1636,9 +2085,9 @@ bool CKVariant::operator<( const CKVariant & anOther ) const
 			case eTimeSeriesVariant:
 				break;
 			case ePriceVariant:
-				if ((mPriceValue != NULL) && (anOther.mPriceValue != NULL)) {
-					if ((mPriceValue->getUSD() < anOther.mPriceValue->getUSD()) &&
-						(mPriceValue->getNative() < anOther.mPriceValue->getNative())) {
+				if ((priceValue() != NULL) && (anOther.priceValue() != NULL)) {
+					if ((priceValue()->getUSD() < anOther.priceValue()->getUSD()) &&
+						(priceValue()->getNative() < anOther.priceValue()->getNative())) {
 						less = true;
 					}
 				}
@@ -1681,6 +2130,8 @@ bool CKVariant::operator>=( const CKVariant & anOther ) const
  */
 CKString CKVariant::toString() const
 {
+	resolve();
+
 	CKString		retval;
 	char			buff[128];
 	// first, send out the type as if it were a 'cast' of the data
@@ -1690,10 +2141,10 @@ CKString CKVariant::toString() const
 			break;
 		case eStringVariant:
 			retval = "(String)";
-			if (mStringValue == NULL) {
+			if (stringValue() == NULL) {
 				retval.append("NULL");
 			} else {
-				retval.append(*mStringValue);
+				retval.append(*stringValue());
 			}
 			break;
 		case eNumberVariant:
@@ -1714,7 +2165,7 @@ CKString CKVariant::toString() const
 			break;
 		case ePriceVariant:
 			retval = "(CKPrice)";
-			retval.append(mPriceValue->toString());
+			retval.append(priceValue()->toString());
 			break;
 		case eListVariant:
 			retval = "(CKVariantList)";
@@ -1738,6 +2189,8 @@ CKString CKVariant::toString() const
  */
 bool CKVariant::inverse()
 {
+	resolve();
+
 	// what we do is based on what we are
 	switch (mType) {
 		case eUnknownVariant:
@@ -1760,8 +2213,8 @@ bool CKVariant::inverse()
 			}
 			break;
 		case ePriceVariant:
-			if (mPriceValue != NULL) {
-				mPriceValue->inverse();
+			if (priceValue() != NULL) {
+				priceValue()->inverse();
 			}
 			break;
 		case eListVariant:
@@ -1791,8 +2244,8 @@ bool CKVariant::operator==( const char *aCString ) const
 {
 	bool		equal = false;
 	if (mType == eStringVariant) {
-		if ((mStringValue != NULL) && (aCString != NULL)) {
-			equal = mStringValue->operator==(aCString);
+		if ((stringValue() != NULL) && (aCString != NULL)) {
+			equal = stringValue()->operator==(aCString);
 		}
 	}
 	return equal;
@@ -1803,8 +2256,8 @@ bool CKVariant::operator==( const std::string & anSTLString ) const
 {
 	bool		equal = false;
 	if (mType == eStringVariant) {
-		if (mStringValue != NULL) {
-			equal = mStringValue->operator==(anSTLString);
+		if (stringValue() != NULL) {
+			equal = stringValue()->operator==(anSTLString);
 		}
 	}
 	return equal;
@@ -1815,8 +2268,8 @@ bool CKVariant::operator==( const CKString & aString ) const
 {
 	bool		equal = false;
 	if (mType == eStringVariant) {
-		if (mStringValue != NULL) {
-			equal = mStringValue->operator==(aString);
+		if (stringValue() != NULL) {
+			equal = stringValue()->operator==(aString);
 		}
 	}
 	return equal;
@@ -1861,6 +2314,8 @@ bool CKVariant::operator==( double aValue ) const
 
 bool CKVariant::operator==( const CKTable & aTable ) const
 {
+	resolve();
+
 	bool		equal = false;
 	if (mType == eTableVariant) {
 		if (mTableValue != NULL) {
@@ -1873,6 +2328,8 @@ bool CKVariant::operator==( const CKTable & aTable ) const
 
 bool CKVariant::operator==( const CKTimeSeries & aSeries ) const
 {
+	resolve();
+
 	bool		equal = false;
 	if (mType == eTimeSeriesVariant) {
 		if (mTimeSeriesValue != NULL) {
@@ -1887,8 +2344,8 @@ bool CKVariant::operator==( const CKPrice & aPrice ) const
 {
 	bool		equal = false;
 	if (mType == ePriceVariant) {
-		if (mPriceValue != NULL) {
-			equal = mPriceValue->operator==(aPrice);
+		if (priceValue() != NULL) {
+			equal = priceValue()->operator==(aPrice);
 		}
 	}
 	return equal;
@@ -1909,6 +2366,8 @@ bool CKVariant::operator==( const CKVariantList & aList ) const
 
 bool CKVariant::operator==( const CKTimeTable & aTimeTable ) const
 {
+	resolve();
+
 	bool		equal = false;
 	if (mType == eTimeTableVariant) {
 		if (mTimeTableValue != NULL) {
@@ -1989,8 +2448,8 @@ bool CKVariant::operator<( const char *aCString ) const
 {
 	bool		less = false;
 	if (mType == eStringVariant) {
-		if ((mStringValue != NULL) && (aCString != NULL)) {
-			less = mStringValue->operator<(aCString);
+		if ((stringValue() != NULL) && (aCString != NULL)) {
+			less = stringValue()->operator<(aCString);
 		}
 	}
 	return less;
@@ -2001,8 +2460,8 @@ bool CKVariant::operator<( const std::string & anSTLString ) const
 {
 	bool		less = false;
 	if (mType == eStringVariant) {
-		if (mStringValue != NULL) {
-			less = mStringValue->operator<(anSTLString);
+		if (stringValue() != NULL) {
+			less = stringValue()->operator<(anSTLString);
 		}
 	}
 	return less;
@@ -2013,8 +2472,8 @@ bool CKVariant::operator<( const CKString & aString ) const
 {
 	bool		less = false;
 	if (mType == eStringVariant) {
-		if (mStringValue != NULL) {
-			less = mStringValue->operator<(aString);
+		if (stringValue() != NULL) {
+			less = stringValue()->operator<(aString);
 		}
 	}
 	return less;
@@ -2077,9 +2536,9 @@ bool CKVariant::operator<( const CKPrice & aPrice ) const
 {
 	bool		less = false;
 	if (mType == ePriceVariant) {
-		if (mPriceValue != NULL) {
-			if ((mPriceValue->getUSD() < aPrice.getUSD()) &&
-				(mPriceValue->getNative() < aPrice.getNative())) {
+		if (priceValue() != NULL) {
+			if ((priceValue()->getUSD() < aPrice.getUSD()) &&
+				(priceValue()->getNative() < aPrice.getNative())) {
 				less = true;
 			}
 		}
@@ -2320,8 +2779,8 @@ CKVariant & CKVariant::operator+=( const char *aCString )
 			case eUnknownVariant:
 				break;
 			case eStringVariant:
-				if (mStringValue != NULL) {
-					mStringValue->append(aCString);
+				if (stringValue() != NULL) {
+					stringValue()->append(aCString);
 				}
 				break;
 			case eNumberVariant:
@@ -2384,8 +2843,8 @@ CKVariant & CKVariant::operator+=( const std::string & anSTLString )
 		case eUnknownVariant:
 			break;
 		case eStringVariant:
-			if (mStringValue != NULL) {
-				mStringValue->append(anSTLString);
+			if (stringValue() != NULL) {
+				stringValue()->append(anSTLString);
 			}
 			break;
 		case eNumberVariant:
@@ -2447,8 +2906,8 @@ CKVariant & CKVariant::operator+=( const CKString & aString )
 		case eUnknownVariant:
 			break;
 		case eStringVariant:
-			if (mStringValue != NULL) {
-				mStringValue->append(aString);
+			if (stringValue() != NULL) {
+				stringValue()->append(aString);
 			}
 			break;
 		case eNumberVariant:
@@ -2505,13 +2964,15 @@ CKVariant & CKVariant::operator+=( const CKString & aString )
 
 CKVariant & CKVariant::operator+=( int aValue )
 {
+	resolve();
+
 	// what we do is based on what we are
 	switch (mType) {
 		case eUnknownVariant:
 			break;
 		case eStringVariant:
-			if (mStringValue != NULL) {
-				mStringValue->append(aValue);
+			if (stringValue() != NULL) {
+				stringValue()->append(aValue);
 			}
 			break;
 		case eNumberVariant:
@@ -2531,8 +2992,8 @@ CKVariant & CKVariant::operator+=( int aValue )
 			}
 			break;
 		case ePriceVariant:
-			if (mPriceValue != NULL) {
-				mPriceValue->add((double)aValue);
+			if (priceValue() != NULL) {
+				priceValue()->add((double)aValue);
 			}
 			break;
 		case eListVariant:
@@ -2561,7 +3022,7 @@ CKVariant & CKVariant::operator+=( long aDateValue )
 		case eUnknownVariant:
 			break;
 		case eStringVariant:
-			if (mStringValue != NULL) {
+			if (stringValue() != NULL) {
 				// pull apart the components of the date
 				int		yr = (int)(aDateValue/10000);
 				int		mo = (int)((aDateValue - yr*10000)/100);
@@ -2570,7 +3031,7 @@ CKVariant & CKVariant::operator+=( long aDateValue )
 				char	buff[80];
 				snprintf(buff, 79, "%02d/%02d/%04d", mo, da, yr);
 				// now append it to the string we have
-				mStringValue->append(buff);
+				stringValue()->append(buff);
 			}
 			break;
 		case eNumberVariant:
@@ -2631,13 +3092,15 @@ CKVariant & CKVariant::operator+=( long aDateValue )
 
 CKVariant & CKVariant::operator+=( double aValue )
 {
+	resolve();
+
 	// what we do is based on what we are
 	switch (mType) {
 		case eUnknownVariant:
 			break;
 		case eStringVariant:
-			if (mStringValue != NULL) {
-				mStringValue->append(aValue);
+			if (stringValue() != NULL) {
+				stringValue()->append(aValue);
 			}
 			break;
 		case eNumberVariant:
@@ -2661,8 +3124,8 @@ CKVariant & CKVariant::operator+=( double aValue )
 			}
 			break;
 		case ePriceVariant:
-			if (mPriceValue != NULL) {
-				mPriceValue->add(aValue);
+			if (priceValue() != NULL) {
+				priceValue()->add(aValue);
 			}
 			break;
 		case eListVariant:
@@ -2686,6 +3149,8 @@ CKVariant & CKVariant::operator+=( double aValue )
 
 CKVariant & CKVariant::operator+=( const CKTable & aTable )
 {
+	resolve();
+
 	// what we do is based on what we are
 	switch (mType) {
 		case eUnknownVariant:
@@ -2751,6 +3216,8 @@ CKVariant & CKVariant::operator+=( const CKTable & aTable )
 
 CKVariant & CKVariant::operator+=( const CKTimeSeries & aSeries )
 {
+	resolve();
+
 	// what we do is based on what we are
 	switch (mType) {
 		case eUnknownVariant:
@@ -2858,8 +3325,8 @@ CKVariant & CKVariant::operator+=( const CKPrice & aPrice )
 				"math.");
 			break;
 		case ePriceVariant:
-			if (mPriceValue != NULL) {
-				mPriceValue->add(aPrice);
+			if (priceValue() != NULL) {
+				priceValue()->add(aPrice);
 			}
 			break;
 		case eListVariant:
@@ -2885,13 +3352,16 @@ CKVariant & CKVariant::operator+=( const CKPrice & aPrice )
 
 CKVariant & CKVariant::operator+=( const CKVariant & aVar )
 {
+	aVar.resolve();
+	resolve();
+
 	// what we do is based on what *he* is
 	switch (aVar.mType) {
 		case eUnknownVariant:
 			break;
 		case eStringVariant:
-			if (aVar.mStringValue != NULL) {
-				operator+=(*aVar.mStringValue);
+			if (aVar.stringValue() != NULL) {
+				operator+=(*aVar.stringValue());
 			}
 			break;
 		case eNumberVariant:
@@ -2911,8 +3381,8 @@ CKVariant & CKVariant::operator+=( const CKVariant & aVar )
 			}
 			break;
 		case ePriceVariant:
-			if (aVar.mPriceValue != NULL) {
-				operator+=(*aVar.mPriceValue);
+			if (aVar.priceValue() != NULL) {
+				operator+=(*aVar.priceValue());
 			}
 			break;
 		case eListVariant:
@@ -3001,6 +3471,8 @@ CKVariant & CKVariant::operator+=( const CKVariantList & aList )
 
 CKVariant & CKVariant::operator+=( const CKTimeTable & aTimeTable )
 {
+	resolve();
+
 	// what we do is based on what we are
 	switch (mType) {
 		case eUnknownVariant:
@@ -3068,6 +3540,8 @@ CKVariant & CKVariant::operator+=( const CKTimeTable & aTimeTable )
 
 CKVariant & CKVariant::operator-=( int aValue )
 {
+	resolve();
+
 	// what we do is based on what we are
 	switch (mType) {
 		case eUnknownVariant:
@@ -3096,8 +3570,8 @@ CKVariant & CKVariant::operator-=( int aValue )
 			}
 			break;
 		case ePriceVariant:
-			if (mPriceValue != NULL) {
-				mPriceValue->subtract((double)aValue);
+			if (priceValue() != NULL) {
+				priceValue()->subtract((double)aValue);
 			}
 			break;
 		case eListVariant:
@@ -3190,6 +3664,8 @@ CKVariant & CKVariant::operator-=( long aDateValue )
 
 CKVariant & CKVariant::operator-=( double aValue )
 {
+	resolve();
+
 	// what we do is based on what we are
 	switch (mType) {
 		case eUnknownVariant:
@@ -3222,8 +3698,8 @@ CKVariant & CKVariant::operator-=( double aValue )
 			}
 			break;
 		case ePriceVariant:
-			if (mPriceValue != NULL) {
-				mPriceValue->subtract(aValue);
+			if (priceValue() != NULL) {
+				priceValue()->subtract(aValue);
 			}
 			break;
 		case eListVariant:
@@ -3247,6 +3723,8 @@ CKVariant & CKVariant::operator-=( double aValue )
 
 CKVariant & CKVariant::operator-=( const CKTable & aTable )
 {
+	resolve();
+
 	// what we do is based on what we are
 	switch (mType) {
 		case eUnknownVariant:
@@ -3313,6 +3791,8 @@ CKVariant & CKVariant::operator-=( const CKTable & aTable )
 
 CKVariant & CKVariant::operator-=( const CKTimeSeries & aSeries )
 {
+	resolve();
+
 	// what we do is based on what we are
 	switch (mType) {
 		case eUnknownVariant:
@@ -3422,8 +3902,8 @@ CKVariant & CKVariant::operator-=( const CKPrice & aPrice )
 				"math.");
 			break;
 		case ePriceVariant:
-			if (mPriceValue != NULL) {
-				mPriceValue->subtract(aPrice);
+			if (priceValue() != NULL) {
+				priceValue()->subtract(aPrice);
 			}
 			break;
 		case eListVariant:
@@ -3449,6 +3929,9 @@ CKVariant & CKVariant::operator-=( const CKPrice & aPrice )
 
 CKVariant & CKVariant::operator-=( const CKVariant & aVar )
 {
+	aVar.resolve();
+	resolve();
+
 	// what we do is based on what *he* is
 	switch (aVar.mType) {
 		case eUnknownVariant:
@@ -3477,8 +3960,8 @@ CKVariant & CKVariant::operator-=( const CKVariant & aVar )
 			}
 			break;
 		case ePriceVariant:
-			if (aVar.mPriceValue != NULL) {
-				operator-=(*aVar.mPriceValue);
+			if (aVar.priceValue() != NULL) {
+				operator-=(*aVar.priceValue());
 			}
 			break;
 		case eListVariant:
@@ -3569,6 +4052,8 @@ CKVariant & CKVariant::operator-=( const CKVariantList & aList )
 
 CKVariant & CKVariant::operator-=( const CKTimeTable & aTimeTable )
 {
+	resolve();
+
 	// what we do is based on what we are
 	switch (mType) {
 		case eUnknownVariant:
@@ -3637,6 +4122,8 @@ CKVariant & CKVariant::operator-=( const CKTimeTable & aTimeTable )
 
 CKVariant & CKVariant::operator*=( int aValue )
 {
+	resolve();
+
 	// what we do is based on what we are
 	switch (mType) {
 		case eUnknownVariant:
@@ -3669,8 +4156,8 @@ CKVariant & CKVariant::operator*=( int aValue )
 			}
 			break;
 		case ePriceVariant:
-			if (mPriceValue != NULL) {
-				mPriceValue->multiply((double)aValue);
+			if (priceValue() != NULL) {
+				priceValue()->multiply((double)aValue);
 			}
 			break;
 		case eListVariant:
@@ -3763,6 +4250,8 @@ CKVariant & CKVariant::operator*=( long aDateValue )
 
 CKVariant & CKVariant::operator*=( double aValue )
 {
+	resolve();
+
 	// what we do is based on what we are
 	switch (mType) {
 		case eUnknownVariant:
@@ -3795,8 +4284,8 @@ CKVariant & CKVariant::operator*=( double aValue )
 			}
 			break;
 		case ePriceVariant:
-			if (mPriceValue != NULL) {
-				mPriceValue->multiply(aValue);
+			if (priceValue() != NULL) {
+				priceValue()->multiply(aValue);
 			}
 			break;
 		case eListVariant:
@@ -3820,6 +4309,8 @@ CKVariant & CKVariant::operator*=( double aValue )
 
 CKVariant & CKVariant::operator*=( const CKTable & aTable )
 {
+	resolve();
+
 	// what we do is based on what we are
 	switch (mType) {
 		case eUnknownVariant:
@@ -3885,6 +4376,8 @@ CKVariant & CKVariant::operator*=( const CKTable & aTable )
 
 CKVariant & CKVariant::operator*=( const CKTimeSeries & aSeries )
 {
+	resolve();
+
 	// what we do is based on what we are
 	switch (mType) {
 		case eUnknownVariant:
@@ -3992,8 +4485,8 @@ CKVariant & CKVariant::operator*=( const CKPrice & aPrice )
 				"math.");
 			break;
 		case ePriceVariant:
-			if (mPriceValue != NULL) {
-				mPriceValue->multiply(aPrice);
+			if (priceValue() != NULL) {
+				priceValue()->multiply(aPrice);
 			}
 			break;
 		case eListVariant:
@@ -4019,6 +4512,9 @@ CKVariant & CKVariant::operator*=( const CKPrice & aPrice )
 
 CKVariant & CKVariant::operator*=( const CKVariant & aVar )
 {
+	aVar.resolve();
+	resolve();
+
 	// what we do is based on what *he* is
 	switch (aVar.mType) {
 		case eUnknownVariant:
@@ -4047,8 +4543,8 @@ CKVariant & CKVariant::operator*=( const CKVariant & aVar )
 			}
 			break;
 		case ePriceVariant:
-			if (aVar.mPriceValue != NULL) {
-				operator*=(*aVar.mPriceValue);
+			if (aVar.priceValue() != NULL) {
+				operator*=(*aVar.priceValue());
 			}
 			break;
 		case eListVariant:
@@ -4139,6 +4635,8 @@ CKVariant & CKVariant::operator*=( const CKVariantList & aList )
 
 CKVariant & CKVariant::operator*=( const CKTimeTable & aTimeTable )
 {
+	resolve();
+
 	// what we do is based on what we are
 	switch (mType) {
 		case eUnknownVariant:
@@ -4206,6 +4704,8 @@ CKVariant & CKVariant::operator*=( const CKTimeTable & aTimeTable )
 
 CKVariant & CKVariant::operator/=( int aValue )
 {
+	resolve();
+
 	// what we do is based on what we are
 	switch (mType) {
 		case eUnknownVariant:
@@ -4238,8 +4738,8 @@ CKVariant & CKVariant::operator/=( int aValue )
 			}
 			break;
 		case ePriceVariant:
-			if (mPriceValue != NULL) {
-				mPriceValue->divide((double)aValue);
+			if (priceValue() != NULL) {
+				priceValue()->divide((double)aValue);
 			}
 			break;
 		case eListVariant:
@@ -4332,6 +4832,8 @@ CKVariant & CKVariant::operator/=( long aDateValue )
 
 CKVariant & CKVariant::operator/=( double aValue )
 {
+	resolve();
+
 	// what we do is based on what we are
 	switch (mType) {
 		case eUnknownVariant:
@@ -4364,8 +4866,8 @@ CKVariant & CKVariant::operator/=( double aValue )
 			}
 			break;
 		case ePriceVariant:
-			if (mPriceValue != NULL) {
-				mPriceValue->divide(aValue);
+			if (priceValue() != NULL) {
+				priceValue()->divide(aValue);
 			}
 			break;
 		case eListVariant:
@@ -4389,6 +4891,8 @@ CKVariant & CKVariant::operator/=( double aValue )
 
 CKVariant & CKVariant::operator/=( const CKTable & aTable )
 {
+	resolve();
+
 	// what we do is based on what we are
 	switch (mType) {
 		case eUnknownVariant:
@@ -4455,6 +4959,8 @@ CKVariant & CKVariant::operator/=( const CKTable & aTable )
 
 CKVariant & CKVariant::operator/=( const CKTimeSeries & aSeries )
 {
+	resolve();
+
 	// what we do is based on what we are
 	switch (mType) {
 		case eUnknownVariant:
@@ -4564,8 +5070,8 @@ CKVariant & CKVariant::operator/=( const CKPrice & aPrice )
 				"math.");
 			break;
 		case ePriceVariant:
-			if (mPriceValue != NULL) {
-				mPriceValue->divide(aPrice);
+			if (priceValue() != NULL) {
+				priceValue()->divide(aPrice);
 			}
 			break;
 		case eListVariant:
@@ -4591,6 +5097,9 @@ CKVariant & CKVariant::operator/=( const CKPrice & aPrice )
 
 CKVariant & CKVariant::operator/=( const CKVariant & aVar )
 {
+	aVar.resolve();
+	resolve();
+
 	// what we do is based on what *he* is
 	switch (aVar.mType) {
 		case eUnknownVariant:
@@ -4619,8 +5128,8 @@ CKVariant & CKVariant::operator/=( const CKVariant & aVar )
 			}
 			break;
 		case ePriceVariant:
-			if (aVar.mPriceValue != NULL) {
-				operator/=(*aVar.mPriceValue);
+			if (aVar.priceValue() != NULL) {
+				operator/=(*aVar.priceValue());
 			}
 			break;
 		case eListVariant:
@@ -4711,6 +5220,8 @@ CKVariant & CKVariant::operator/=( const CKVariantList & aList )
 
 CKVariant & CKVariant::operator/=( const CKTimeTable & aTimeTable )
 {
+	resolve();
+
 	// what we do is based on what we are
 	switch (mType) {
 		case eUnknownVariant:
@@ -4803,6 +5314,150 @@ void CKVariant::setType( CKVariantType aType )
 }
 
 
+/*
+ * This method clears out this variant and moves the value of the
+ * other one into it, leaving the other one empty. It's the heart
+ * of the moves and swaps.
+ */
+void CKVariant::takeValueFrom( CKVariant & anOther )
+{
+	clearValue();
+	switch (anOther.mType) {
+		case eUnknownVariant:
+			break;
+		case eStringVariant:
+			/*
+			 * The string lives in the other variant's inline space, so we
+			 * need one of our own, and then the buffers can change hands.
+			 */
+			if (anOther.stringValue() != NULL) {
+				new (mInlineValue) CKString();
+				mInlineBuilt = true;
+				stringValue()->swap(*anOther.stringValue());
+			}
+			break;
+		case eNumberVariant:
+			mDoubleValue = anOther.mDoubleValue;
+			break;
+		case eDateVariant:
+			mDateValue = anOther.mDateValue;
+			break;
+		case ePriceVariant:
+			if (anOther.priceValue() != NULL) {
+				new (mInlineValue) CKPrice(*anOther.priceValue());
+				mInlineBuilt = true;
+			}
+			break;
+		case eTableVariant:
+		case eTimeSeriesVariant:
+		case eListVariant:
+		case eTimeTableVariant:
+			// all these are pointers to the heap, so they just change hands
+			mTableValue = anOther.mTableValue;
+			anOther.mTableValue = NULL;
+			// ...and so is the code of a value that's not decoded yet
+			mLazy = anOther.mLazy;
+			anOther.mLazy = false;
+			break;
+		default:
+			throw CKException(__FILE__, __LINE__, "CKVariant::takeValueFrom("
+				"CKVariant &) - the data contained in the other instance is "
+				"unknown and that's a serious data corruption problem. Please "
+				"look into it.");
+	}
+	mType = anOther.mType;
+	// ...and leave the other one empty
+	anOther.clearValue();
+}
+
+
+/*
+ * This sets this variant to hold a table, time series or time
+ * table that's still in its code - 'aBinary' says if it's a binary
+ * code or a text one. It's decoded the first time it's needed.
+ */
+void CKVariant::setLazyValue( CKVariantType aType, const char *aCode,
+							  int aLength, bool aBinary )
+{
+	// make sure it's something that can be done
+	if ((aType != eTableVariant) && (aType != eTimeSeriesVariant) &&
+		(aType != eTimeTableVariant)) {
+		std::ostringstream	msg;
+		msg << "CKVariant::setLazyValue(CKVariantType, const char *, int, bool) - "
+			"the type " << aType << " can't be decoded lazily. Only the tables, "
+			"time series and time tables can.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// copy the code before clearing, in case it's our own
+	CKVariantLazyValue	*lazy = new CKVariantLazyValue();
+	lazy->code.assign(aCode, aLength);
+	lazy->binary = aBinary;
+
+	clearValue();
+	mLazyValue = lazy;
+	mLazy = true;
+	mType = aType;
+}
+
+
+/*
+ * This decodes the value if it's still waiting in its code. Many
+ * threads can be reading the same variant, so the decoding is done
+ * under the variant's lock, and the pointer to the value is set and
+ * seen before the code is dropped - so anyone that sees no code sees
+ * the value.
+ */
+void CKVariant::materialize() const
+{
+	CKStackLocker	lockem(lazyLock(this));
+
+	// another thread may have decoded it while we waited for the lock
+	if (isDecoded()) {
+		return;
+	}
+	CKVariantLazyValue	*lazy = mLazyValue;
+
+	CKVariant	*me = (CKVariant *)this;
+	switch (mType) {
+		case eTableVariant:
+			me->mTableValue = decodeLazyValue<CKTable>(*lazy);
+			break;
+		case eTimeSeriesVariant:
+			me->mTimeSeriesValue = decodeLazyValue<CKTimeSeries>(*lazy);
+			break;
+		case eTimeTableVariant:
+			me->mTimeTableValue = decodeLazyValue<CKTimeTable>(*lazy);
+			break;
+		default:
+			break;
+	}
+	CKFWAtomicFence();
+	me->mLazy = false;
+	delete lazy;
+}
+
+
+/*
+ * If the value is still waiting in its code, this copies the code
+ * into the arguments and returns true so that it can be copied or
+ * written out without being decoded. Otherwise it returns false.
+ */
+bool CKVariant::copyLazyCode( std::string & aCode, bool & aBinary ) const
+{
+	bool		copied = false;
+	if (!isDecoded()) {
+		CKStackLocker	lockem(lazyLock(this));
+		if (!isDecoded()) {
+			aCode = mLazyValue->code;
+			aBinary = mLazyValue->binary;
+			copied = true;
+		}
+	}
+	return copied;
+}
+
+
 /*
  * For debugging purposes, let's make it easy for the user to stream
  * out this value. It basically is just the value of toString() which
@@ -5329,7 +5984,8 @@ CKVariant operator/( const CKPrice & aPrice, CKVariant & aVar )
 CKVariantNode::CKVariantNode() :
 	CKVariant(),
 	mPrev(NULL),
-	mNext(NULL)
+	mNext(NULL),
+	mInList(false)
 {
 }
 
@@ -5345,7 +6001,8 @@ CKVariantNode::CKVariantNode( const CKVariant & anOther,
 							  CKVariantNode *aNext ) :
 	CKVariant(anOther),
 	mPrev(aPrev),
-	mNext(aNext)
+	mNext(aNext),
+	mInList(false)
 {
 }
 
@@ -5358,7 +6015,8 @@ CKVariantNode::CKVariantNode( const CKVariant & anOther,
 CKVariantNode::CKVariantNode( const CKVariantNode & anOther ) :
 	CKVariant(),
 	mPrev(NULL),
-	mNext(NULL)
+	mNext(NULL),
+	mInList(false)
 {
 	// let the '=' operator do all the work for me
 	*this = anOther;
@@ -5385,9 +6043,11 @@ CKVariantNode & CKVariantNode::operator=( const CKVariantNode & anOther )
 {
 	// start by letting the super do it's thing
 	CKVariant::operator=(anOther);
-	// now we can do the rest
-	mPrev = anOther.mPrev;
-	mNext = anOther.mNext;
+	// now we can do the rest - unless the links are a list's
+	if (!mInList) {
+		mPrev = anOther.mPrev;
+		mNext = anOther.mNext;
+	}
 
 	return *this;
 }
@@ -5418,12 +6078,14 @@ CKVariantNode & CKVariantNode::operator=( const CKVariant & anOther )
  */
 void CKVariantNode::setPrev( CKVariantNode *aNode )
 {
+	checkNotInList("setPrev(CKVariantNode *)");
 	mPrev = aNode;
 }
 
 
 void CKVariantNode::setNext( CKVariantNode *aNode )
 {
+	checkNotInList("setNext(CKVariantNode *)");
 	mNext = aNode;
 }
 
@@ -5453,6 +6115,7 @@ CKVariantNode *CKVariantNode::getNext()
  */
 void CKVariantNode::removeFromList()
 {
+	checkNotInList("removeFromList()");
 	// first, point the next's "prev" to the prev
 	if (mNext != NULL) {
 		mNext->mPrev = mPrev;
@@ -5467,6 +6130,16 @@ void CKVariantNode::removeFromList()
 }
 
 
+/*
+ * This returns true if the node is one of the nodes in the array
+ * of a CKVariantList.
+ */
+bool CKVariantNode::isInList() const
+{
+	return mInList;
+}
+
+
 /********************************************************
  *
  *                Utility Methods
@@ -5530,6 +6203,22 @@ CKString CKVariantNode::toString() const
 }
 
 
+/*
+ * This throws a CKException if the node is in the array of a list,
+ * as its links are the list's and can't be changed from out here.
+ */
+void CKVariantNode::checkNotInList( const char *aMethod ) const
+{
+	if (mInList) {
+		std::ostringstream	msg;
+		msg << "CKVariantNode::" << aMethod << " - this node is in the array "
+			"of a CKVariantList, and its links can only be changed by the list. "
+			"Please use the list's methods instead.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+}
+
+
 /*
  * For debugging purposes, let's make it easy for the user to stream
  * out this value. It basically is just the value of toString() which
@@ -5548,11 +6237,19 @@ std::ostream & operator<<( std::ostream & aStream, const CKVariantNode & aNode )
 /*
  * ----------------------------------------------------------------------------
  * This is the high-level interface to a list of CKVariant objects. It
- * is organized as a doubly-linked list of CKVariantNodes and the interface
- * to the list if controlled by a nice CKFWMutex. This is a nice and clean
- * replacement to the STL std::list.
+ * is organized as a contiguous array of CKVariantNodes - with room at both
+ * ends so adding to the front or the end is cheap - and the interface to
+ * the list if controlled by a nice CKFWMutex. The nodes are still linked
+ * to one another so that the getHead() and getNext() way of walking the
+ * list works as it always has, but they can also be gotten by index.
  * ----------------------------------------------------------------------------
  */
+/*
+ * This is the smallest array we'll make for the nodes - there's no
+ * sense in growing one node at a time.
+ */
+#define	CKVARIANTLIST_MIN_CAPACITY		8
+
 /********************************************************
  *
  *                Constructors/Destructor
@@ -5564,8 +6261,10 @@ std::ostream & operator<<( std::ostream & aStream, const CKVariantNode & aNode )
  * populate this guy later with anything that you could want.
  */
 CKVariantList::CKVariantList() :
-	mHead(NULL),
-	mTail(NULL),
+	mNodes(NULL),
+	mCapacity(0),
+	mFirst(0),
+	mCount(0),
 	mMutex()
 {
 }
@@ -5577,8 +6276,10 @@ CKVariantList::CKVariantList() :
  * around.
  */
 CKVariantList::CKVariantList( const CKVariantList & anOther ) :
-	mHead(NULL),
-	mTail(NULL),
+	mNodes(NULL),
+	mCapacity(0),
+	mFirst(0),
+	mCount(0),
 	mMutex()
 {
 	// let's let the '=' operator handle this for us
@@ -5593,8 +6294,10 @@ CKVariantList::CKVariantList( const CKVariantList & anOther ) :
  * connection.
  */
 CKVariantList::CKVariantList( const CKString & aCodedList ) :
-	mHead(NULL),
-	mTail(NULL),
+	mNodes(NULL),
+	mCapacity(0),
+	mFirst(0),
+	mCount(0),
 	mMutex()
 {
 	// we jjust need to take the values from the code itself
@@ -5609,8 +6312,12 @@ CKVariantList::CKVariantList( const CKString & aCodedList ) :
  */
 CKVariantList::~CKVariantList()
 {
-	// simply clear out the list and we're done.
+	// clear out the list and then drop the array
 	clear();
+	if (mNodes != NULL) {
+		::operator delete(mNodes);
+		mNodes = NULL;
+	}
 }
 
 
@@ -5653,13 +6360,13 @@ CKVariantList & CKVariantList::operator=( const CKVariantList & anOther )
  */
 CKVariantNode *CKVariantList::getHead() const
 {
-	return mHead;
+	return (mCount > 0 ? &mNodes[mFirst] : NULL);
 }
 
 
 CKVariantNode *CKVariantList::getTail() const
 {
-	return mTail;
+	return (mCount > 0 ? &mNodes[mFirst + mCount - 1] : NULL);
 }
 
 
@@ -5694,13 +6401,7 @@ int CKVariantList::size()
 {
 	// first, lock up this guy against changes
 	CKStackLocker	lockem(&mMutex);
-	// all we need to do is count them all up
-	int		cnt = 0;
-	for (CKVariantNode *node = mHead; node != NULL; node = node->mNext) {
-		cnt++;
-	}
-
-	return cnt;
+	return mCount;
 }
 
 
@@ -5718,13 +6419,7 @@ bool CKVariantList::empty()
 {
 	// first, lock up this guy against changes
 	CKStackLocker	lockem(&mMutex);
-	// all we need to do is count them all up
-	bool	empty = false;
-	if (mHead == NULL) {
-		empty = true;
-	}
-
-	return empty;
+	return (mCount == 0);
 }
 
 
@@ -5743,18 +6438,8 @@ void CKVariantList::clear()
 {
 	// first, lock up this guy against changes
 	CKStackLocker	lockem(&mMutex);
-	// we need to delete the head as long as there is one
-	while (mHead != NULL) {
-		CKVariantNode	*next = mHead->mNext;
-		delete mHead;
-		mHead = next;
-		if (mHead != NULL) {
-			mHead->mPrev = NULL;
-		}
-	}
-	// now make sure to reset the head and tail
-	mHead = NULL;
-	mTail = NULL;
+	// ...and then get rid of all the nodes
+	destroyNodes();
 }
 
 
@@ -5769,24 +6454,12 @@ void CKVariantList::addToFront( const CKVariant & aPoint )
 	// first, lock up this guy against changes
 	CKStackLocker	lockem(&mMutex);
 
-	// we need to create a new data point node based on this guy
-	CKVariantNode	*node = new CKVariantNode(aPoint, NULL, mHead);
-	if (node == NULL) {
-		std::ostringstream	msg;
-		msg << "CKVariantList::addToFront(const CKVariant &) - a "
-			"new variant node could not be created for the passed in value: " <<
-			aPoint << " and that's a serious allocation problem that needs to "
-			"be looked into.";
-		throw CKException(__FILE__, __LINE__, msg.str());
-	} else {
-		// finish linking this guy into the list properly
-		if (mHead == NULL) {
-			mTail = node;
-		} else {
-			mHead->mPrev = node;
-		}
-		mHead = node;
-	}
+	// make room for the new node in the array and build it there
+	makeRoom(1, 0);
+	new (&mNodes[mFirst - 1]) CKVariantNode(aPoint);
+	--mFirst;
+	++mCount;
+	relink(mFirst, mFirst + 1);
 }
 
 
@@ -5795,33 +6468,98 @@ void CKVariantList::addToEnd( const CKVariant & aPoint )
 	// first, lock up this guy against changes
 	CKStackLocker	lockem(&mMutex);
 
-	// we need to create a new data point node based on this guy
-	CKVariantNode	*node = new CKVariantNode(aPoint, mTail, NULL);
-	if (node == NULL) {
+	// make room for the new node in the array and build it there
+	makeRoom(0, 1);
+	int		last = mFirst + mCount;
+	new (&mNodes[last]) CKVariantNode(aPoint);
+	++mCount;
+	relink(last - 1, last);
+}
+
+
+/*
+ * This method adds copies of all the values in the array to the
+ * end of the list in one go - it's the fast way to load a list.
+ */
+void CKVariantList::addToEnd( const CKVariant *aPoints, int aCount )
+{
+	// first, make sure we have something to do
+	if ((aPoints == NULL) || (aCount <= 0)) {
+		return;
+	}
+
+	// next, lock up this guy against changes
+	CKStackLocker	lockem(&mMutex);
+
+	// make room for all of them at once and then build them in place
+	makeRoom(0, aCount);
+	int		last = mFirst + mCount;
+	for (int i = 0; i < aCount; ++i) {
+		new (&mNodes[last + i]) CKVariantNode(aPoints[i]);
+		++mCount;
+	}
+	relink(last - 1, last + aCount - 1);
+}
+
+
+/*
+ * This method makes sure that the list has room for at least the
+ * given number of values so that adding them to the end of the list
+ * won't have to move the ones that are already there.
+ */
+void CKVariantList::reserve( int aCapacity )
+{
+	// first, lock up this guy against changes
+	CKStackLocker	lockem(&mMutex);
+
+	if (aCapacity <= mCapacity) {
+		// it's big enough, so it's just the room at the end
+		if (mCapacity - mFirst < aCapacity) {
+			moveNodes(0);
+		}
+	} else {
+		makeRoom(0, aCapacity - mCount);
+	}
+}
+
+
+int CKVariantList::capacity() const
+{
+	return mCapacity;
+}
+
+
+/*
+ * These return the value at the given (zero-based) index in the
+ * list in constant time. They do not lock the list - so that a loop
+ * over the list doesn't take the lock on every element - so if the
+ * list can be changed by another thread, use lock() and unlock()
+ * around the loop. An index out of range throws a CKException.
+ */
+CKVariant & CKVariantList::operator[]( int anIndex )
+{
+	if ((anIndex < 0) || (anIndex >= mCount)) {
 		std::ostringstream	msg;
-		msg << "CKVariantList::addToEnd(const CKVariant &) - a "
-			"new variant node could not be created for the passed in value: " <<
-			aPoint << " and that's a serious allocation problem that needs to "
-			"be looked into.";
+		msg << "CKVariantList::operator[](int) - the requested index: " <<
+			anIndex << " is not in the list of " << mCount << " values. Please "
+			"make sure the index is valid before calling this method.";
 		throw CKException(__FILE__, __LINE__, msg.str());
-	} else {
-		// finish linking this guy into the list properly
-		if (mTail == NULL) {
-			mHead = node;
-		} else {
-			mTail->mNext = node;
-		}
-		mTail = node;
 	}
+
+	return mNodes[mFirst + anIndex];
+}
+
+
+const CKVariant & CKVariantList::operator[]( int anIndex ) const
+{
+	return ((CKVariantList *)this)->operator[](anIndex);
 }
 
 
 /*
- * These methods take control of the passed-in arguments and place
- * them in the proper place in the list. This is different in that
- * the control of the node is passed to the list, but that's why
- * we've created them... to make it easy to add in nodes by just
- * changing the links.
+ * These methods are DEPRECATED - use addToFront() and addToEnd().
+ * The value is moved out of the node into the list's array, and then
+ * the node is deleted, so the caller must not use it after the call.
  */
 void CKVariantList::putOnFront( CKVariantNode *aNode )
 {
@@ -5830,15 +6568,15 @@ void CKVariantList::putOnFront( CKVariantNode *aNode )
 		// next, lock up this guy against changes
 		CKStackLocker	lockem(&mMutex);
 
-		// we simply need to link this bad boy into the list
-		aNode->mPrev = NULL;
-		aNode->mNext = mHead;
-		if (mHead == NULL) {
-			mTail = aNode;
-		} else {
-			mHead->mPrev = aNode;
-		}
-		mHead = aNode;
+		// make an empty node at the front and move the value into it
+		makeRoom(1, 0);
+		new (&mNodes[mFirst - 1]) CKVariantNode();
+		--mFirst;
+		++mCount;
+		mNodes[mFirst].swap(*aNode);
+		relink(mFirst, mFirst + 1);
+		// ...and the node is now ours to get rid of
+		delete aNode;
 	}
 }
 
@@ -5850,15 +6588,15 @@ void CKVariantList::putOnEnd( CKVariantNode *aNode )
 		// next, lock up this guy against changes
 		CKStackLocker	lockem(&mMutex);
 
-		// we simply need to link this bad boy into the list
-		aNode->mPrev = mTail;
-		aNode->mNext = NULL;
-		if (mTail == NULL) {
-			mHead = aNode;
-		} else {
-			mTail->mNext = aNode;
-		}
-		mTail = aNode;
+		// make an empty node at the end and move the value into it
+		makeRoom(0, 1);
+		int		last = mFirst + mCount;
+		new (&mNodes[last]) CKVariantNode();
+		++mCount;
+		mNodes[last].swap(*aNode);
+		relink(last - 1, last);
+		// ...and the node is now ours to get rid of
+		delete aNode;
 	}
 }
 
@@ -5875,6 +6613,18 @@ void CKVariantList::copyToFront( CKVariantList & aList )
 	mMutex.lock();
 	aList.mMutex.lock();
 
+	/*
+	 * Make room for all of them at once - if this fails, we need to
+	 * release the locks before the exception goes on up.
+	 */
+	int		cnt = aList.mCount;
+	try {
+		makeRoom(cnt, 0);
+	} catch (...) {
+		aList.mMutex.unlock();
+		mMutex.unlock();
+		throw;
+	}
 	/*
 	 * I need to go through all the source data, but backwards because
 	 * I'll be putting these new nodes on the *front* of the list, and
@@ -5882,30 +6632,12 @@ void CKVariantList::copyToFront( CKVariantList & aList )
 	 * order of the elements in the source as I add them. So I'll go
 	 * backwards... no biggie...
 	 */
-	for (CKVariantNode *src = aList.mTail; src != NULL; src = src->mPrev) {
-		// first, make a copy of this guy
-		CKVariantNode	*node = new CKVariantNode(*src, NULL, mHead);
-		if (node == NULL) {
-			// first we need to release the locks
-			aList.mMutex.unlock();
-			mMutex.unlock();
-			// now we can throw the exception
-			std::ostringstream	msg;
-			msg << "CKVariantList::copyToFront(CKVariantList &) - a "
-				"new variant node could not be created for the value: " <<
-				(*src) << " and that's a serious allocation problem that needs to "
-				"be looked into.";
-			throw CKException(__FILE__, __LINE__, msg.str());
-		}
-
-		// now, add this guy to the front of the list
-		if (mHead == NULL) {
-			mTail = node;
-		} else {
-			mHead->mPrev = node;
-		}
-		mHead = node;
+	for (int i = cnt - 1; i >= 0; --i) {
+		new (&mNodes[mFirst - 1]) CKVariantNode(aList.mNodes[aList.mFirst + i]);
+		--mFirst;
+		++mCount;
 	}
+	relink(mFirst, mFirst + cnt);
 
 	// now I can release both locks
 	aList.mMutex.unlock();
@@ -5925,34 +6657,28 @@ void CKVariantList::copyToEnd( CKVariantList & aList )
 	mMutex.lock();
 	aList.mMutex.lock();
 
+	/*
+	 * Make room for all of them at once - if this fails, we need to
+	 * release the locks before the exception goes on up.
+	 */
+	int		cnt = aList.mCount;
+	try {
+		makeRoom(0, cnt);
+	} catch (...) {
+		aList.mMutex.unlock();
+		mMutex.unlock();
+		throw;
+	}
 	/*
 	 * I need to go through all the source data. I'll be putting these new
 	 * nodes on the *end* of the list so the order is preserved.
 	 */
-	for (CKVariantNode *src = aList.mHead; src != NULL; src = src->mNext) {
-		// first, make a copy of this guy
-		CKVariantNode	*node = new CKVariantNode(*src, mTail, NULL);
-		if (node == NULL) {
-			// first we need to release the locks
-			aList.mMutex.unlock();
-			mMutex.unlock();
-			// now we can throw the exception
-			std::ostringstream	msg;
-			msg << "CKVariantList::copyToEnd(CKVariantList &) - a "
-				"new variant node could not be created for the value: " <<
-				(*src) << " and that's a serious allocation problem that needs to "
-				"be looked into.";
-			throw CKException(__FILE__, __LINE__, msg.str());
-		}
-
-		// now, add this guy to the end of the list
-		if (mTail == NULL) {
-			mHead = node;
-		} else {
-			mTail->mNext = node;
-		}
-		mTail = node;
+	int		last = mFirst + mCount;
+	for (int i = 0; i < cnt; ++i) {
+		new (&mNodes[last + i]) CKVariantNode(aList.mNodes[aList.mFirst + i]);
+		++mCount;
 	}
+	relink(last - 1, last + cnt - 1);
 
 	// now I can release both locks
 	aList.mMutex.unlock();
@@ -5970,7 +6696,8 @@ void CKVariantList::copyToEnd( const CKVariantList & aList )
  * When you have a list that you want to merge into this list, these
  * are the methods to use. It's important to note that the argument
  * lists will be EMPTIED - which is why this is called the 'splice'
- * as opposed to the 'copy'.
+ * as opposed to the 'copy'. The values are moved, not copied, but
+ * they do have to be moved into this list's array.
  */
 void CKVariantList::spliceOnFront( CKVariantList & aList )
 {
@@ -5978,23 +6705,38 @@ void CKVariantList::spliceOnFront( CKVariantList & aList )
 	mMutex.lock();
 	aList.mMutex.lock();
 
-	// add the source, in total, to the head of this list
-	if (mHead == NULL) {
-		// take their list in toto - mine is empty
-		mHead = aList.mHead;
-		mTail = aList.mTail;
+	int		cnt = aList.mCount;
+	if ((mCount == 0) && (mCapacity <= aList.mCapacity)) {
+		// mine is empty, so take their array in toto
+		CKVariantNode	*nodes = mNodes;
+		int				cap = mCapacity;
+		mNodes = aList.mNodes;
+		mCapacity = aList.mCapacity;
+		mFirst = aList.mFirst;
+		mCount = cnt;
+		aList.mNodes = nodes;
+		aList.mCapacity = cap;
+		aList.mFirst = cap / 2;
+		aList.mCount = 0;
 	} else {
-		mHead->mPrev = aList.mTail;
-		if (aList.mTail != NULL) {
-			aList.mTail->mNext = mHead;
+		try {
+			makeRoom(cnt, 0);
+		} catch (...) {
+			aList.mMutex.unlock();
+			mMutex.unlock();
+			throw;
 		}
-		if (aList.mHead != NULL) {
-			mHead = aList.mHead;
+		// move them over from the back so the order is preserved
+		for (int i = cnt - 1; i >= 0; --i) {
+			new (&mNodes[mFirst - 1]) CKVariantNode();
+			--mFirst;
+			++mCount;
+			mNodes[mFirst].swap(aList.mNodes[aList.mFirst + i]);
 		}
+		relink(mFirst, mFirst + cnt);
+		// ...and empty the source list
+		aList.destroyNodes();
 	}
-	// ...and empty the source list
-	aList.mHead = NULL;
-	aList.mTail = NULL;
 
 	// now I can release both locks
 	aList.mMutex.unlock();
@@ -6008,23 +6750,38 @@ void CKVariantList::spliceOnEnd( CKVariantList & aList )
 	mMutex.lock();
 	aList.mMutex.lock();
 
-	// add the source, in total, to the end of this list
-	if (mTail == NULL) {
-		// take their list in toto - mine is empty
-		mHead = aList.mHead;
-		mTail = aList.mTail;
+	int		cnt = aList.mCount;
+	if ((mCount == 0) && (mCapacity <= aList.mCapacity)) {
+		// mine is empty, so take their array in toto
+		CKVariantNode	*nodes = mNodes;
+		int				cap = mCapacity;
+		mNodes = aList.mNodes;
+		mCapacity = aList.mCapacity;
+		mFirst = aList.mFirst;
+		mCount = cnt;
+		aList.mNodes = nodes;
+		aList.mCapacity = cap;
+		aList.mFirst = cap / 2;
+		aList.mCount = 0;
 	} else {
-		mTail->mNext = aList.mHead;
-		if (aList.mHead != NULL) {
-			aList.mHead->mPrev = mTail;
+		try {
+			makeRoom(0, cnt);
+		} catch (...) {
+			aList.mMutex.unlock();
+			mMutex.unlock();
+			throw;
 		}
-		if (aList.mTail != NULL) {
-			mTail = aList.mTail;
+		// move them over in order
+		int		last = mFirst + mCount;
+		for (int i = 0; i < cnt; ++i) {
+			new (&mNodes[last + i]) CKVariantNode();
+			++mCount;
+			mNodes[last + i].swap(aList.mNodes[aList.mFirst + i]);
 		}
+		relink(last - 1, last + cnt - 1);
+		// ...and empty the source list
+		aList.destroyNodes();
 	}
-	// ...and empty the source list
-	aList.mHead = NULL;
-	aList.mTail = NULL;
 
 	// now I can release both locks
 	aList.mMutex.unlock();
@@ -6063,8 +6820,8 @@ CKString CKVariantList::generateCodeFromValues() const
 	buff.append("\x01").append(cnt).append("\x01");
 
 	// next, loop over all the elements and write them out as well
-	for (CKVariantNode *n = getHead(); n != NULL; n = n->getNext()) {
-		buff.append(n->generateCodeFromValues()).append("\x01");
+	for (int i = 0; i < cnt; ++i) {
+		buff.append(mNodes[mFirst + i].generateCodeFromValues()).append("\x01");
 	}
 
 	/*
@@ -6129,6 +6886,7 @@ void CKVariantList::takeValuesFromCode( const CKString & aCode )
 	 * need it, but go ahead and get it off...
 	 */
 	int cnt = chunks[bit++].intValue();
+	reserve(cnt);
 	/*
 	 * Now we get into the actual data for this field.
 	 */
@@ -6139,6 +6897,79 @@ void CKVariantList::takeValuesFromCode( const CKString & aCode )
 	}
 }
 
+/*
+ * These methods are the binary versions of the two above. The
+ * toBinary() method returns a complete code in the compact binary
+ * format - header and all - and fromBinary() takes one written by
+ * it and replaces what's in this list with it. The codes can
+ * have any bytes in them, so they are std::strings and not CKStrings.
+ */
+std::string CKVariantList::toBinary() const
+{
+	std::string		buff;
+	CKBinaryWriter	writer(buff);
+	writer.putHeader(eBinaryListTag);
+	writeBinary(writer);
+	return buff;
+}
+
+
+void CKVariantList::fromBinary( const std::string & aCode )
+{
+	fromBinary(aCode.data(), aCode.size());
+}
+
+
+void CKVariantList::fromBinary( const char *aCode, int aLength )
+{
+	CKBinaryReader	reader(aCode, aLength);
+	reader.getHeader(eBinaryListTag);
+	readBinary(reader);
+	reader.checkAtEnd();
+}
+
+
+/*
+ * These methods write and read just the list's value - no
+ * header - so that it can be nested in the code of something
+ * bigger. It's the count of the values and then each value.
+ */
+void CKVariantList::writeBinary( CKBinaryWriter & aWriter ) const
+{
+	// lock up this guy against changes
+	CKStackLocker	lockem(&(((CKVariantList *)this)->mMutex));
+
+	aWriter.putUInt(mCount);
+	for (int i = 0; i < mCount; ++i) {
+		mNodes[mFirst + i].writeBinary(aWriter);
+	}
+}
+
+
+void CKVariantList::readBinary( CKBinaryReader & aReader )
+{
+	// lock up this guy against changes
+	CKStackLocker	lockem(&mMutex);
+
+	// clear out what we have and make room for them all at once
+	destroyNodes();
+	int		cnt = aReader.getCount();
+	makeRoom(0, cnt);
+	// ...and then build each one right in place
+	try {
+		for (int i = 0; i < cnt; ++i) {
+			new (&mNodes[mFirst + i]) CKVariantNode();
+			++mCount;
+			mNodes[mFirst + i].readBinary(aReader);
+		}
+	} catch (...) {
+		relink(mFirst, mFirst + mCount - 1);
+		throw;
+	}
+	relink(mFirst, mFirst + mCount - 1);
+}
+
+
 
 /*
  * This method checks to see if the two CKVariantLists are equal to
@@ -6154,35 +6985,21 @@ bool CKVariantList::operator==( CKVariantList & anOther )
 	mMutex.lock();
 	anOther.mMutex.lock();
 
+	// see if the two lists are of different lengths
+	if (mCount != anOther.mCount) {
+		equal = false;
+	}
+
 	/*
 	 * We need to compare each element in the list as data points and
 	 * NOT as data point nodes as the pointers will never be the same
 	 * but the data will.
 	 */
-	CKVariantNode	*me = mHead;
-	CKVariantNode	*him = anOther.mHead;
-	while (equal) {
-		// see if we're at the end
-		if ((me == NULL) && (him == NULL)) {
-			break;
-		}
-
-		// see if the two lists are of different lengths
-		if (((me == NULL) && (him != NULL)) ||
-			((me != NULL) && (him == NULL))) {
+	for (int i = 0; equal && (i < mCount); ++i) {
+		if (!mNodes[mFirst + i].CKVariant::operator==(
+				*(CKVariant*)&anOther.mNodes[anOther.mFirst + i])) {
 			equal = false;
-			break;
 		}
-
-		// compare the values by data contents only
-		if (!me->CKVariant::operator==(*(CKVariant*)him)) {
-			equal = false;
-			break;
-		}
-
-		// now move to the next point in each list
-		me = me->mNext;
-		him = him->mNext;
 	}
 
 	// now we're OK to unlock these lists and let them be free
@@ -6244,8 +7061,8 @@ CKString CKVariantList::toString()
 
 	CKString		retval = "[";
 	// put each data point out on the output
-	for (CKVariantNode *node = mHead; node != NULL; node = node->mNext) {
-		retval += node->CKVariant::toString();
+	for (int i = 0; i < mCount; ++i) {
+		retval += mNodes[mFirst + i].CKVariant::toString();
 		retval += "\n";
 	}
 	retval += "]";
@@ -6255,18 +7072,144 @@ CKString CKVariantList::toString()
 
 
 /*
- * Setting the head or the tail is a bit dicey and so we're not
- * going to let just anyone change these guys.
+ * This makes sure there's room in the array for the given number
+ * of new nodes before the first one and after the last one. If it
+ * has to, it moves the nodes to the middle of the array, or to a
+ * new, bigger one. The caller needs to hold the lock.
+ */
+void CKVariantList::makeRoom( int aFrontCount, int anEndCount )
+{
+	// see if we already have the room we need
+	if ((mFirst >= aFrontCount) &&
+		(mCapacity - mFirst - mCount >= anEndCount)) {
+		return;
+	}
+
+	/*
+	 * If the array is no more than half full with the new ones, it's
+	 * just the wrong end that's out of room, so the nodes are moved to
+	 * the middle of it. Otherwise, the new array is sized from what's
+	 * in the list - room for the new ones plus as many again as there
+	 * are now - so a list built a node at a time is only moved a few
+	 * times, and one that's cleared and used again never grows past
+	 * what it's really held. If it's the front that needs the room,
+	 * leave half the extra space there, as they're likely to keep coming.
+	 */
+	int		cnt = mCount;
+	int		need = cnt + aFrontCount + anEndCount;
+	if (need <= mCapacity / 2) {
+		moveNodes(aFrontCount + (mCapacity - need)/2);
+		return;
+	}
+	int		cap = cnt + need;
+	if (cap < CKVARIANTLIST_MIN_CAPACITY) {
+		cap = CKVARIANTLIST_MIN_CAPACITY;
+	}
+	int		first = aFrontCount;
+	if (aFrontCount > 0) {
+		first += (cap - need)/2;
+	}
+	CKVariantNode	*nodes = (CKVariantNode *)::operator new(cap * sizeof(CKVariantNode));
+	if (nodes == NULL) {
+		std::ostringstream	msg;
+		msg << "CKVariantList::makeRoom(int, int) - the space for " << cap <<
+			" nodes could not be created. This is a serious allocation error.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+
+	// move the values over - swapping them so nothing is deep copied
+	for (int i = 0; i < cnt; ++i) {
+		new (&nodes[first + i]) CKVariantNode();
+		nodes[first + i].swap(mNodes[mFirst + i]);
+	}
+	destroyNodes();
+	if (mNodes != NULL) {
+		::operator delete(mNodes);
+	}
+
+	// ...and start using the new array
+	mNodes = nodes;
+	mCapacity = cap;
+	mFirst = first;
+	mCount = cnt;
+	relink(mFirst, mFirst + mCount - 1);
+}
+
+
+/*
+ * This moves the nodes in the list so the first one is at the given
+ * index of the array. The slots they move into are made into nodes,
+ * the values are swapped over, and the slots they leave are destroyed.
+ * The caller needs to hold the lock.
  */
-void CKVariantList::setHead( CKVariantNode *aNode )
+void CKVariantList::moveNodes( int aFirst )
 {
-	mHead = aNode;
+	int		from = mFirst;
+	int		cnt = mCount;
+	if (aFirst < from) {
+		// moving down, so start with the first one
+		for (int i = 0; i < cnt; ++i) {
+			if (aFirst + i < from) {
+				new (&mNodes[aFirst + i]) CKVariantNode();
+			}
+			mNodes[aFirst + i].swap(mNodes[from + i]);
+		}
+		for (int i = (aFirst + cnt > from ? aFirst + cnt : from); i < from + cnt; ++i) {
+			mNodes[i].~CKVariantNode();
+		}
+	} else if (aFirst > from) {
+		// moving up, so start with the last one
+		for (int i = cnt - 1; i >= 0; --i) {
+			if (aFirst + i >= from + cnt) {
+				new (&mNodes[aFirst + i]) CKVariantNode();
+			}
+			mNodes[aFirst + i].swap(mNodes[from + i]);
+		}
+		for (int i = from; i < (aFirst < from + cnt ? aFirst : from + cnt); ++i) {
+			mNodes[i].~CKVariantNode();
+		}
+	}
+	mFirst = aFirst;
+	relink(mFirst, mFirst + mCount - 1);
+}
+
+
+/*
+ * This sets the prev and next links of the nodes from the first
+ * index to the last index (both array indexes) so that the nodes
+ * can be walked like a linked list.
+ */
+void CKVariantList::relink( int aFirst, int aLast )
+{
+	// only the nodes in the list can be linked
+	if (aFirst < mFirst) {
+		aFirst = mFirst;
+	}
+	int		end = mFirst + mCount - 1;
+	if (aLast > end) {
+		aLast = end;
+	}
+
+	for (int i = aFirst; i <= aLast; ++i) {
+		mNodes[i].mPrev = (i > mFirst ? &mNodes[i - 1] : NULL);
+		mNodes[i].mNext = (i < end ? &mNodes[i + 1] : NULL);
+		mNodes[i].mInList = true;
+	}
 }
 
 
-void CKVariantList::setTail( CKVariantNode *aNode )
+/*
+ * This destroys all the nodes in the list, but keeps the array.
+ * The caller needs to hold the lock.
+ */
+void CKVariantList::destroyNodes()
 {
-	mTail = aNode;
+	for (int i = 0; i < mCount; ++i) {
+		mNodes[mFirst + i].~CKVariantNode();
+	}
+	// start again in the middle, so either end has room to grow
+	mFirst = mCapacity / 2;
+	mCount = 0;
 }
 
 
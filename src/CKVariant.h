@@ -29,8 +29,22 @@ class CKTable;
 class CKPrice;
 class CKVariantList;
 class CKTimeTable;
+class CKBinaryWriter;
+class CKBinaryReader;
+struct CKVariantLazyValue;
 
 //	Public Constants
+/*
+ * The methods of CKVariantList that can't work the way they did when it
+ * was a linked list are marked with this so the compiler points out
+ * where they're still being used.
+ */
+#if defined(__GNUC__)
+#define	CKVARIANT_DEPRECATED	__attribute__((deprecated))
+#else
+#define	CKVARIANT_DEPRECATED
+#endif
+
 /*
  * Since this data element can have different types of values, we need to
  * define what those different types are, and what their coded values will
@@ -154,6 +168,14 @@ class CKVariant
 		 * around.
 		 */
 		CKVariant( const CKVariant & anOther );
+#if __cplusplus >= 201103L
+		/*
+		 * This is the move constructor that takes the value right out of
+		 * the other variant - the tables, series and lists just change
+		 * hands - and leaves the other one empty (eUnknownVariant).
+		 */
+		CKVariant( CKVariant && anOther );
+#endif
 		/*
 		 * This is the standard destructor and needs to be virtual to make
 		 * sure that if we subclass off this the right destructor will be
@@ -168,6 +190,14 @@ class CKVariant
 		 */
 		CKVariant & operator=( CKVariant & anOther );
 		CKVariant & operator=( const CKVariant & anOther );
+#if __cplusplus >= 201103L
+		CKVariant & operator=( CKVariant && anOther );
+#endif
+		/*
+		 * This method exchanges the values of the two variants without
+		 * copying any of the tables, series, lists or strings.
+		 */
+		void swap( CKVariant & anOther );
 
 		/*
 		 * When we want to make a simple assignment to a CKVariant, these
@@ -349,6 +379,23 @@ class CKVariant
 		 * for setting it to a new value.
 		 */
 		void clearValue();
+		/*
+		 * When lazy decoding is turned on, the tables, time series and
+		 * time tables that are read from a code - text or binary - are
+		 * kept as their codes until something actually needs them, and
+		 * then they are decoded - just once, even if several threads ask
+		 * for them at the same time. Loading a big tree where most of the
+		 * values are never looked at is then a lot cheaper. It's off by
+		 * default, and it's for the whole process. The catch is that a bad
+		 * code isn't found until the value is first used.
+		 */
+		static void setLazyDecoding( bool aFlag );
+		static bool isLazyDecoding();
+		/*
+		 * This returns false if this variant is holding a value that's
+		 * still waiting to be decoded from its code, and true otherwise.
+		 */
+		bool isDecoded() const;
 
 		/********************************************************
 		 *
@@ -420,6 +467,23 @@ class CKVariant
 		 * untouched, and is the responsible of the caller to free.
 		 */
 		virtual void takeValuesFromCode( const CKString & aCode );
+		/*
+		 * These methods are the binary versions of the two above. The
+		 * toBinary() method returns a complete code in the compact binary
+		 * format - header and all - and fromBinary() takes one written by
+		 * it and replaces what's in this variant with it. The codes can
+		 * have any bytes in them, so they are std::strings and not CKStrings.
+		 */
+		std::string toBinary() const;
+		void fromBinary( const std::string & aCode );
+		void fromBinary( const char *aCode, int aLength );
+		/*
+		 * These methods write and read just the variant's value - no
+		 * header - so that it can be nested in the code of something
+		 * bigger. This is what toBinary() and fromBinary() are built on.
+		 */
+		virtual void writeBinary( CKBinaryWriter & aWriter ) const;
+		virtual void readBinary( CKBinaryReader & aReader );
 		/*
 		 * This method checks to see if the two CKVariants are equal to one
 		 * another based on the values they represent and *not* on the actual
@@ -706,6 +770,50 @@ class CKVariant
 		 * of encapsulation, I wanted to add this setter to the class.
 		 */
 		void setType( CKVariantType aType );
+		/*
+		 * This method clears out this variant and moves the value of the
+		 * other one into it, leaving the other one empty. It's the heart
+		 * of the moves and swaps.
+		 */
+		void takeValueFrom( CKVariant & anOther );
+		/*
+		 * This sets this variant to hold a table, time series or time
+		 * table that's still in its code - 'aBinary' says if it's a binary
+		 * code or a text one. It's decoded the first time it's needed.
+		 */
+		void setLazyValue( CKVariantType aType, const char *aCode,
+						   int aLength, bool aBinary );
+		/*
+		 * These return the string or price that's been built in the
+		 * inline space, or NULL if there isn't one.
+		 */
+		inline CKString *stringValue() const
+		{
+			return (mInlineBuilt ? (CKString *)mInlineValue : NULL);
+		}
+		inline CKPrice *priceValue() const
+		{
+			return (mInlineBuilt ? (CKPrice *)mInlineValue : NULL);
+		}
+		/*
+		 * This decodes the value if it's still waiting in its code, and
+		 * it's called by everything that needs the value itself. When
+		 * there's nothing to decode, it's just a couple of tests.
+		 */
+		inline void resolve() const
+		{
+			if (((mType == eTableVariant) || (mType == eTimeSeriesVariant) ||
+				 (mType == eTimeTableVariant)) && mLazy) {
+				materialize();
+			}
+		}
+		void materialize() const;
+		/*
+		 * If the value is still waiting in its code, this copies the code
+		 * into the arguments and returns true so that it can be copied or
+		 * written out without being decoded. Otherwise it returns false.
+		 */
+		bool copyLazyCode( std::string & aCode, bool & aBinary ) const;
 
 	private:
 		/*
@@ -713,21 +821,37 @@ class CKVariant
 		 * in this instance under one of the values in the union.
 		 */
 		CKVariantType	mType;
+		/*
+		 * These fit in the space after the type that would otherwise be
+		 * padding. The first is true when a string or price has been built
+		 * in the inline space of the union, and the second is true when a
+		 * table, time series or time table is still waiting in its code,
+		 * and so the union holds mLazyValue and not the value itself.
+		 */
+		bool			mInlineBuilt;
+		volatile bool	mLazy;
 		/*
 		 * These are the different possible data elements that this object
 		 * can hold, and will be set differently based on how the user
-		 * sets this data.
+		 * sets this data. The string and price values are small enough
+		 * that they don't need to be allocated on their own - they are
+		 * built right here in mInlineValue. That saves an allocation for
+		 * every string (the CKString still has its own buffer) and all of
+		 * them for a price, and it's no bigger than it has to be for the
+		 * CKString.
 		 */
 		union {
-			CKString		*mStringValue;
-			long			mDateValue;
-			double			mDoubleValue;
-			CKTable			*mTableValue;
-			CKTimeSeries	*mTimeSeriesValue;
-			CKPrice			*mPriceValue;
-			CKVariantList	*mListValue;
-			CKTimeTable		*mTimeTableValue;
+			long				mDateValue;
+			double				mDoubleValue;
+			CKTable				*mTableValue;
+			CKTimeSeries		*mTimeSeriesValue;
+			CKVariantList		*mListValue;
+			CKTimeTable			*mTimeTableValue;
+			CKVariantLazyValue	*mLazyValue;
+			char				mInlineValue[sizeof(CKString)];
 		};
+		// this is true if the nested values are to be decoded lazily
+		static bool		sLazyDecoding;
 };
 
 /*
@@ -917,8 +1041,9 @@ class CKVariantNode :
 		 ********************************************************/
 		/*
 		 * These are the simple setters for the links to the previous and
-		 * next nodes in the list. There's nothing special here, so we're
-		 * exposing them directly.
+		 * next nodes in the list. They're only for free-standing nodes -
+		 * the links of a node in a CKVariantList are the list's, and
+		 * changing them throws a CKException.
 		 */
 		void setPrev( CKVariantNode *aNode );
 		void setNext( CKVariantNode *aNode );
@@ -932,12 +1057,19 @@ class CKVariantNode :
 		CKVariantNode *getNext();
 
 		/*
-		 * This method is used to 'unlink' the node from the list it's in.
-		 * This will NOT delete the node, merely take it out the the list
-		 * and now it becomes the responsibility of the caller to delete
-		 * this node, or add him to another list.
+		 * This method is used to 'unlink' the node from the nodes around
+		 * it. This will NOT delete the node. It's only for free-standing
+		 * nodes - the nodes in a CKVariantList live in the list's array, so
+		 * they can't be taken out of it and handed to the caller, and this
+		 * throws a CKException for one of them. Use clear(), or build a new
+		 * list without the value, instead.
 		 */
 		void removeFromList();
+		/*
+		 * This returns true if the node is one of the nodes in the array
+		 * of a CKVariantList.
+		 */
+		bool isInList() const;
 
 		/********************************************************
 		 *
@@ -971,12 +1103,23 @@ class CKVariantNode :
 	private:
 		friend class CKVariantList;
 
+		/*
+		 * This throws a CKException if the node is in the array of a
+		 * list, as its links are the list's.
+		 */
+		void checkNotInList( const char *aMethod ) const;
+
 		/*
 		 * Since we're a doubly-linked list, I'm just going to have a
 		 * prev and next pointers and that will take care of the linking.
 		 */
 		CKVariantNode		*mPrev;
 		CKVariantNode		*mNext;
+		/*
+		 * This is true when the node is in the array of a list, and so
+		 * its links belong to the list. It's never copied from another.
+		 */
+		bool				mInList;
 };
 
 /*
@@ -992,9 +1135,15 @@ std::ostream & operator<<( std::ostream & aStream, const CKVariantNode & aNode )
 /*
  * ----------------------------------------------------------------------------
  * This is the high-level interface to a list of CKVariant objects. It
- * is organized as a doubly-linked list of CKVariantNodes and the interface
- * to the list if controlled by a nice CKFWMutex. This is a nice and clean
- * replacement to the STL std::list.
+ * is organized as a contiguous array of CKVariantNodes - with room at both
+ * ends so adding to the front or the end is cheap - and the interface to
+ * the list if controlled by a nice CKFWMutex. The nodes are still linked
+ * to one another so that the getHead() and getNext() way of walking the
+ * list works as it always has, but they can also be gotten by index.
+ *
+ * Since the nodes are in the array, anything that adds to the list can
+ * move them, so a node pointer is only good until the next change to the
+ * list - just like an iterator into a std::vector.
  * ----------------------------------------------------------------------------
  */
 class CKVariantList
@@ -1095,16 +1244,38 @@ class CKVariantList
 		 */
 		void addToFront( const CKVariant & aPoint );
 		void addToEnd( const CKVariant & aPoint );
+		/*
+		 * This method adds copies of all the values in the array to the
+		 * end of the list in one go - it's the fast way to load a list.
+		 */
+		void addToEnd( const CKVariant *aPoints, int aCount );
+		/*
+		 * This method makes sure that the list has room for at least the
+		 * given number of values so that adding them to the end of the list
+		 * won't have to move the ones that are already there.
+		 */
+		void reserve( int aCapacity );
+		int capacity() const;
+
+		/*
+		 * These return the value at the given (zero-based) index in the
+		 * list in constant time. They do not lock the list - so that a loop
+		 * over the list doesn't take the lock on every element - so if the
+		 * list can be changed by another thread, use lock() and unlock()
+		 * around the loop. An index out of range throws a CKException.
+		 */
+		CKVariant & operator[]( int anIndex );
+		const CKVariant & operator[]( int anIndex ) const;
 
 		/*
-		 * These methods take control of the passed-in arguments and place
-		 * them in the proper place in the list. This is different in that
-		 * the control of the node is passed to the list, but that's why
-		 * we've created them... to make it easy to add in nodes by just
-		 * changing the links.
+		 * These methods are DEPRECATED - use addToFront() and addToEnd().
+		 * They used to link the caller's node right into the list, but the
+		 * list's nodes are in its array now, so the value is moved out of
+		 * the node into the array, and then the node is deleted - the
+		 * caller must not use it after the call.
 		 */
-		void putOnFront( CKVariantNode *aNode );
-		void putOnEnd( CKVariantNode *aNode );
+		void putOnFront( CKVariantNode *aNode ) CKVARIANT_DEPRECATED;
+		void putOnEnd( CKVariantNode *aNode ) CKVARIANT_DEPRECATED;
 
 		/*
 		 * When you have a list that you want to add to this list, these
@@ -1121,7 +1292,8 @@ class CKVariantList
 		 * When you have a list that you want to merge into this list, these
 		 * are the methods to use. It's important to note that the argument
 		 * lists will be EMPTIED - which is why this is called the 'splice'
-		 * as opposed to the 'copy'.
+		 * as opposed to the 'copy'. The values are moved, not copied, but
+		 * they do have to be moved into this list's array.
 		 */
 		void spliceOnFront( CKVariantList & aList );
 		void spliceOnEnd( CKVariantList & aList );
@@ -1146,6 +1318,23 @@ class CKVariantList
 		 * untouched, and is the responsible of the caller to free.
 		 */
 		virtual void takeValuesFromCode( const CKString & aCode );
+		/*
+		 * These methods are the binary versions of the two above. The
+		 * toBinary() method returns a complete code in the compact binary
+		 * format - header and all - and fromBinary() takes one written by
+		 * it and replaces what's in this list with it. The codes can
+		 * have any bytes in them, so they are std::strings and not CKStrings.
+		 */
+		std::string toBinary() const;
+		void fromBinary( const std::string & aCode );
+		void fromBinary( const char *aCode, int aLength );
+		/*
+		 * These methods write and read just the list's value - no
+		 * header - so that it can be nested in the code of something
+		 * bigger. This is what toBinary() and fromBinary() are built on.
+		 */
+		virtual void writeBinary( CKBinaryWriter & aWriter ) const;
+		virtual void readBinary( CKBinaryReader & aReader );
 		/*
 		 * This method checks to see if the two CKVariantLists are equal to
 		 * one another based on the values they represent and *not* on the
@@ -1176,19 +1365,40 @@ class CKVariantList
 
 	protected:
 		/*
-		 * Setting the head or the tail is a bit dicey and so we're not
-		 * going to let just anyone change these guys.
+		 * This makes sure there's room in the array for the given number
+		 * of new nodes before the first one and after the last one. If it
+		 * has to, it moves the nodes to the middle of the array, or to a
+		 * new, bigger one. The caller needs to hold the lock.
+		 */
+		void makeRoom( int aFrontCount, int anEndCount );
+		/*
+		 * This moves the nodes within the array so that the first one is
+		 * at the given index, for when there's room enough in the array,
+		 * but at the wrong end. The caller needs to hold the lock.
+		 */
+		void moveNodes( int aFirst );
+		/*
+		 * This sets the prev and next links of the nodes from the first
+		 * index to the last index (both array indexes) so that the nodes
+		 * can be walked like a linked list.
+		 */
+		void relink( int aFirst, int aLast );
+		/*
+		 * This destroys all the nodes in the list, but keeps the array.
+		 * The caller needs to hold the lock.
 		 */
-		void setHead( CKVariantNode *aNode );
-		void setTail( CKVariantNode *aNode );
+		void destroyNodes();
 
 	private:
 		/*
-		 * A Doubly-linked list is pretty easy - there's a head and a
-		 * tail and that's about it.
+		 * This is the array of nodes and how many it can hold. The nodes
+		 * in the list are from 'mFirst' for 'mCount' nodes - the space on
+		 * either side of them is empty and ready to be used.
 		 */
-		CKVariantNode		*mHead;
-		CKVariantNode		*mTail;
+		CKVariantNode		*mNodes;
+		int					mCapacity;
+		int					mFirst;
+		int					mCount;
 		/*
 		 * This is the mutex that is going to protect all the dangerous
 		 * operations so that this list is thread-safe.
@@ -0,0 +1,762 @@
+/*
+ * CKVectorMath.cpp - this file implements the kernels that do the simple
+ *                    math on contiguous arrays of doubles. Each operation
+ *                    is a little struct that the kernels are templated on,
+ *                    so there's one loop for each kind of pass, and the
+ *                    AVX2 versions are built for just those functions with
+ *                    the 'target' attribute so the rest of the library can
+ *                    still run on any x86. The matrix kernels are built the
+ *                    same way, around one small kernel that does a block
+ *                    of the product in registers.
+ *
+ * $Id$
+ */
+
+//	System Headers
+#include <sstream>
+#include <vector>
+
+//	Third-Party Headers
+
+//	Other Headers
+#include "CKVectorMath.h"
+#include "CKException.h"
+/*
+ * The intrinsics can only be pulled in once the header has said if
+ * the AVX2 kernels can be built.
+ */
+#ifdef CKVECTOR_HAVE_AVX2
+#include <immintrin.h>
+#endif
+
+//	Forward Declarations
+
+//	Private Constants
+#ifdef CKVECTOR_HAVE_AVX2
+#define CKVECTOR_AVX2	__attribute__((target("avx2")))
+#endif
+/*
+ * These are the sizes of the blocks for multiply(). The kernel keeps
+ * an MR x NR block of the result in registers while it goes down KC of
+ * the inner dimension. A KC deep slice of MC rows of the first matrix
+ * is packed so that it stays in the L2 cache while it's used against
+ * every column, and a slice of NC columns of the second so it stays in
+ * the L3 while it's used against every row.
+ */
+#define	CKVECTOR_MR					8
+#define	CKVECTOR_NR					4
+#define	CKVECTOR_KC					256
+#define	CKVECTOR_MC					128
+#define	CKVECTOR_NC					1024
+/*
+ * This is the size of the square blocks that transpose() moves at a
+ * time, so that what it reads and what it writes both stay in the L1.
+ */
+#define	CKVECTOR_TRANSPOSE_BLOCK	32
+
+//	Private Datatypes
+/*
+ * These are the operations. run() does one double, and with AVX2,
+ * vrun() does four. The inverse is done as the second argument over
+ * the first so it can use the same kernels with an argument of 1.0.
+ */
+struct CKVectorAdd {
+	static inline double run( double a, double b ) { return a + b; }
+#ifdef CKVECTOR_HAVE_AVX2
+	static inline CKVECTOR_AVX2 __m256d vrun( __m256d a, __m256d b ) { return _mm256_add_pd(a, b); }
+#endif
+};
+
+struct CKVectorSubtract {
+	static inline double run( double a, double b ) { return a - b; }
+#ifdef CKVECTOR_HAVE_AVX2
+	static inline CKVECTOR_AVX2 __m256d vrun( __m256d a, __m256d b ) { return _mm256_sub_pd(a, b); }
+#endif
+};
+
+struct CKVectorMultiply {
+	static inline double run( double a, double b ) { return a * b; }
+#ifdef CKVECTOR_HAVE_AVX2
+	static inline CKVECTOR_AVX2 __m256d vrun( __m256d a, __m256d b ) { return _mm256_mul_pd(a, b); }
+#endif
+};
+
+struct CKVectorDivide {
+	static inline double run( double a, double b ) { return a / b; }
+#ifdef CKVECTOR_HAVE_AVX2
+	static inline CKVECTOR_AVX2 __m256d vrun( __m256d a, __m256d b ) { return _mm256_div_pd(a, b); }
+#endif
+};
+
+struct CKVectorInverse {
+	static inline double run( double a, double b ) { return b / a; }
+#ifdef CKVECTOR_HAVE_AVX2
+	static inline CKVECTOR_AVX2 __m256d vrun( __m256d a, __m256d b ) { return _mm256_div_pd(b, a); }
+#endif
+};
+
+/*
+ * This is the kernel for multiply() - it adds the product of the packed
+ * panels of 'aDepth' rows of CKVECTOR_MR and 'aDepth' columns of
+ * CKVECTOR_NR to the block of the result in 'aBlock', column by column.
+ */
+typedef void (*CKVectorKernel)( int aDepth, const double *anA, const double *aB,
+								double *aBlock );
+
+//	Private Data Constants
+/*
+ * The AVX2 kernels are on until someone turns them off.
+ */
+volatile bool CKVectorMath::mUseSIMD = true;
+
+
+
+/*
+ * These are the plain loops that work everywhere.
+ */
+template <class OP> static void plainScalar( double *aValues, int aCount, double anArg )
+{
+	for (int i = 0; i < aCount; ++i) {
+		aValues[i] = OP::run(aValues[i], anArg);
+	}
+}
+
+
+template <class OP> static void plainArray( double *aValues, const double *anArgs, int aCount )
+{
+	for (int i = 0; i < aCount; ++i) {
+		aValues[i] = OP::run(aValues[i], anArgs[i]);
+	}
+}
+
+
+template <class OP> static void plainMasked( double *aValues, const unsigned char *aValid,
+											 const double *anArgs, const unsigned char *anArgsValid,
+											 int aCount )
+{
+	int		blocks = aCount >> 3;
+	for (int b = 0; b < blocks; ++b) {
+		unsigned char	mask = (unsigned char)(aValid[b] & anArgsValid[b]);
+		double			*v = aValues + (b << 3);
+		const double	*a = anArgs + (b << 3);
+		if (mask == 0xff) {
+			for (int j = 0; j < 8; ++j) {
+				v[j] = OP::run(v[j], a[j]);
+			}
+		} else if (mask != 0) {
+			for (int j = 0; j < 8; ++j) {
+				if ((mask >> j) & 1) {
+					v[j] = OP::run(v[j], a[j]);
+				}
+			}
+		}
+	}
+	// ...and the last few that don't make a whole byte of the bitmap
+	for (int i = (blocks << 3); i < aCount; ++i) {
+		if ((aValid[i >> 3] & anArgsValid[i >> 3] & (1 << (i & 7))) != 0) {
+			aValues[i] = OP::run(aValues[i], anArgs[i]);
+		}
+	}
+}
+
+
+#ifdef CKVECTOR_HAVE_AVX2
+/*
+ * These are the AVX2 versions of the same loops. They're only called
+ * when the processor has AVX2, and they don't care how the arrays are
+ * aligned. Each does eight doubles a trip to keep two of the vector
+ * units busy, and finishes up the stragglers one at a time.
+ */
+static bool haveAVX2()
+{
+	static int	sHave = -1;
+	if (sHave < 0) {
+		__builtin_cpu_init();
+		sHave = (__builtin_cpu_supports("avx2") ? 1 : 0);
+	}
+	return (sHave == 1);
+}
+
+
+template <class OP> CKVECTOR_AVX2 static void avxScalar( double *aValues, int aCount, double anArg )
+{
+	__m256d		arg = _mm256_set1_pd(anArg);
+	int			i = 0;
+	for (; i + 8 <= aCount; i += 8) {
+		__m256d		a = _mm256_loadu_pd(aValues + i);
+		__m256d		b = _mm256_loadu_pd(aValues + i + 4);
+		_mm256_storeu_pd(aValues + i, OP::vrun(a, arg));
+		_mm256_storeu_pd(aValues + i + 4, OP::vrun(b, arg));
+	}
+	for (; i < aCount; ++i) {
+		aValues[i] = OP::run(aValues[i], anArg);
+	}
+}
+
+
+template <class OP> CKVECTOR_AVX2 static void avxArray( double *aValues, const double *anArgs, int aCount )
+{
+	int			i = 0;
+	for (; i + 8 <= aCount; i += 8) {
+		__m256d		a = _mm256_loadu_pd(aValues + i);
+		__m256d		b = _mm256_loadu_pd(aValues + i + 4);
+		_mm256_storeu_pd(aValues + i, OP::vrun(a, _mm256_loadu_pd(anArgs + i)));
+		_mm256_storeu_pd(aValues + i + 4, OP::vrun(b, _mm256_loadu_pd(anArgs + i + 4)));
+	}
+	for (; i < aCount; ++i) {
+		aValues[i] = OP::run(aValues[i], anArgs[i]);
+	}
+}
+
+
+template <class OP> CKVECTOR_AVX2 static void avxMasked( double *aValues, const unsigned char *aValid,
+														 const double *anArgs, const unsigned char *anArgsValid,
+														 int aCount )
+{
+	int		blocks = aCount >> 3;
+	for (int b = 0; b < blocks; ++b) {
+		unsigned char	mask = (unsigned char)(aValid[b] & anArgsValid[b]);
+		double			*v = aValues + (b << 3);
+		const double	*a = anArgs + (b << 3);
+		if (mask == 0xff) {
+			__m256d		lo = OP::vrun(_mm256_loadu_pd(v), _mm256_loadu_pd(a));
+			__m256d		hi = OP::vrun(_mm256_loadu_pd(v + 4), _mm256_loadu_pd(a + 4));
+			_mm256_storeu_pd(v, lo);
+			_mm256_storeu_pd(v + 4, hi);
+		} else if (mask != 0) {
+			for (int j = 0; j < 8; ++j) {
+				if ((mask >> j) & 1) {
+					v[j] = OP::run(v[j], a[j]);
+				}
+			}
+		}
+	}
+	for (int i = (blocks << 3); i < aCount; ++i) {
+		if ((aValid[i >> 3] & anArgsValid[i >> 3] & (1 << (i & 7))) != 0) {
+			aValues[i] = OP::run(aValues[i], anArgs[i]);
+		}
+	}
+}
+#endif
+
+
+
+/*
+ * These pack the slices of the matrices for multiply() so the kernel
+ * reads them straight through. The rows of the first matrix are packed
+ * in panels of CKVECTOR_MR, and the columns of the second in panels of
+ * CKVECTOR_NR, each panel a row of the panel after another as the inner
+ * dimension goes down. The panel at the edge is padded with zeros.
+ */
+static void packRows( const double * const *anA, bool aTransposeA, int aRow,
+					  int aCount, int anInner, int aDepth, double *aPack )
+{
+	for (int r = 0; r < aCount; r += CKVECTOR_MR) {
+		int		n = (aCount - r < CKVECTOR_MR ? aCount - r : CKVECTOR_MR);
+		double	*panel = aPack + r * aDepth;
+		if (aTransposeA) {
+			// each row is a column, so it's read straight down
+			for (int i = 0; i < n; ++i) {
+				const double	*row = anA[aRow + r + i] + anInner;
+				for (int p = 0; p < aDepth; ++p) {
+					panel[p * CKVECTOR_MR + i] = row[p];
+				}
+			}
+		} else {
+			for (int p = 0; p < aDepth; ++p) {
+				const double	*col = anA[anInner + p] + aRow + r;
+				for (int i = 0; i < n; ++i) {
+					panel[p * CKVECTOR_MR + i] = col[i];
+				}
+			}
+		}
+		for (int i = n; i < CKVECTOR_MR; ++i) {
+			for (int p = 0; p < aDepth; ++p) {
+				panel[p * CKVECTOR_MR + i] = 0.0;
+			}
+		}
+	}
+}
+
+
+static void packColumns( const double * const *aB, int aCol, int aCount,
+						 int anInner, int aDepth, double *aPack )
+{
+	for (int c = 0; c < aCount; c += CKVECTOR_NR) {
+		int		n = (aCount - c < CKVECTOR_NR ? aCount - c : CKVECTOR_NR);
+		double	*panel = aPack + c * aDepth;
+		for (int j = 0; j < CKVECTOR_NR; ++j) {
+			const double	*col = (j < n ? aB[aCol + c + j] + anInner : NULL);
+			for (int p = 0; p < aDepth; ++p) {
+				panel[p * CKVECTOR_NR + j] = (col != NULL ? col[p] : 0.0);
+			}
+		}
+	}
+}
+
+
+/*
+ * This is the plain kernel. Each element of the block has a product
+ * added to it for each step down the inner dimension, in order, and
+ * that's all the AVX2 kernel does too - four rows at a time.
+ */
+static void plainKernel( int aDepth, const double *anA, const double *aB, double *aBlock )
+{
+	for (int p = 0; p < aDepth; ++p) {
+		const double	*a = anA + p * CKVECTOR_MR;
+		const double	*b = aB + p * CKVECTOR_NR;
+		for (int j = 0; j < CKVECTOR_NR; ++j) {
+			double	*block = aBlock + j * CKVECTOR_MR;
+			for (int i = 0; i < CKVECTOR_MR; ++i) {
+				block[i] = block[i] + a[i] * b[j];
+			}
+		}
+	}
+}
+
+
+/*
+ * This is the plain transpose - a block at a time, so the reads down
+ * the columns and the writes across the rows both stay in the cache.
+ */
+static void plainTranspose( int aRows, int aCols, const double * const *aColumns,
+							double * const *aResult )
+{
+	for (int jb = 0; jb < aCols; jb += CKVECTOR_TRANSPOSE_BLOCK) {
+		int		je = (jb + CKVECTOR_TRANSPOSE_BLOCK < aCols ? jb + CKVECTOR_TRANSPOSE_BLOCK : aCols);
+		for (int ib = 0; ib < aRows; ib += CKVECTOR_TRANSPOSE_BLOCK) {
+			int		ie = (ib + CKVECTOR_TRANSPOSE_BLOCK < aRows ? ib + CKVECTOR_TRANSPOSE_BLOCK : aRows);
+			for (int i = ib; i < ie; ++i) {
+				double	*out = aResult[i];
+				for (int j = jb; j < je; ++j) {
+					out[j] = aColumns[j][i];
+				}
+			}
+		}
+	}
+}
+
+
+#ifdef CKVECTOR_HAVE_AVX2
+/*
+ * This is the AVX2 kernel. The 8 x 4 block of the result is in eight
+ * registers, and each step down the inner dimension is two loads of
+ * the rows, four broadcasts of the columns, and a multiply and an add
+ * for each register. It's not fused, as that would round differently
+ * than the plain kernel.
+ */
+CKVECTOR_AVX2 static void avxKernel( int aDepth, const double *anA, const double *aB,
+									 double *aBlock )
+{
+	__m256d		c00 = _mm256_loadu_pd(aBlock);
+	__m256d		c01 = _mm256_loadu_pd(aBlock + 4);
+	__m256d		c10 = _mm256_loadu_pd(aBlock + 8);
+	__m256d		c11 = _mm256_loadu_pd(aBlock + 12);
+	__m256d		c20 = _mm256_loadu_pd(aBlock + 16);
+	__m256d		c21 = _mm256_loadu_pd(aBlock + 20);
+	__m256d		c30 = _mm256_loadu_pd(aBlock + 24);
+	__m256d		c31 = _mm256_loadu_pd(aBlock + 28);
+	for (int p = 0; p < aDepth; ++p) {
+		__m256d		a0 = _mm256_loadu_pd(anA);
+		__m256d		a1 = _mm256_loadu_pd(anA + 4);
+		__m256d		b = _mm256_broadcast_sd(aB);
+		c00 = _mm256_add_pd(c00, _mm256_mul_pd(a0, b));
+		c01 = _mm256_add_pd(c01, _mm256_mul_pd(a1, b));
+		b = _mm256_broadcast_sd(aB + 1);
+		c10 = _mm256_add_pd(c10, _mm256_mul_pd(a0, b));
+		c11 = _mm256_add_pd(c11, _mm256_mul_pd(a1, b));
+		b = _mm256_broadcast_sd(aB + 2);
+		c20 = _mm256_add_pd(c20, _mm256_mul_pd(a0, b));
+		c21 = _mm256_add_pd(c21, _mm256_mul_pd(a1, b));
+		b = _mm256_broadcast_sd(aB + 3);
+		c30 = _mm256_add_pd(c30, _mm256_mul_pd(a0, b));
+		c31 = _mm256_add_pd(c31, _mm256_mul_pd(a1, b));
+		anA += CKVECTOR_MR;
+		aB += CKVECTOR_NR;
+	}
+	_mm256_storeu_pd(aBlock, c00);
+	_mm256_storeu_pd(aBlock + 4, c01);
+	_mm256_storeu_pd(aBlock + 8, c10);
+	_mm256_storeu_pd(aBlock + 12, c11);
+	_mm256_storeu_pd(aBlock + 16, c20);
+	_mm256_storeu_pd(aBlock + 20, c21);
+	_mm256_storeu_pd(aBlock + 24, c30);
+	_mm256_storeu_pd(aBlock + 28, c31);
+}
+
+
+/*
+ * This is the AVX2 transpose. Each block is done 4 x 4 at a time in
+ * registers - four columns in, four rows out - with the edges of the
+ * block that don't make a whole 4 x 4 done one at a time.
+ */
+CKVECTOR_AVX2 static void avxTranspose( int aRows, int aCols, const double * const *aColumns,
+										double * const *aResult )
+{
+	for (int jb = 0; jb < aCols; jb += CKVECTOR_TRANSPOSE_BLOCK) {
+		int		je = (jb + CKVECTOR_TRANSPOSE_BLOCK < aCols ? jb + CKVECTOR_TRANSPOSE_BLOCK : aCols);
+		for (int ib = 0; ib < aRows; ib += CKVECTOR_TRANSPOSE_BLOCK) {
+			int		ie = (ib + CKVECTOR_TRANSPOSE_BLOCK < aRows ? ib + CKVECTOR_TRANSPOSE_BLOCK : aRows);
+			int		j = jb;
+			for (; j + 4 <= je; j += 4) {
+				int		i = ib;
+				for (; i + 4 <= ie; i += 4) {
+					__m256d		c0 = _mm256_loadu_pd(aColumns[j] + i);
+					__m256d		c1 = _mm256_loadu_pd(aColumns[j + 1] + i);
+					__m256d		c2 = _mm256_loadu_pd(aColumns[j + 2] + i);
+					__m256d		c3 = _mm256_loadu_pd(aColumns[j + 3] + i);
+					__m256d		t0 = _mm256_unpacklo_pd(c0, c1);
+					__m256d		t1 = _mm256_unpackhi_pd(c0, c1);
+					__m256d		t2 = _mm256_unpacklo_pd(c2, c3);
+					__m256d		t3 = _mm256_unpackhi_pd(c2, c3);
+					_mm256_storeu_pd(aResult[i] + j, _mm256_permute2f128_pd(t0, t2, 0x20));
+					_mm256_storeu_pd(aResult[i + 1] + j, _mm256_permute2f128_pd(t1, t3, 0x20));
+					_mm256_storeu_pd(aResult[i + 2] + j, _mm256_permute2f128_pd(t0, t2, 0x31));
+					_mm256_storeu_pd(aResult[i + 3] + j, _mm256_permute2f128_pd(t1, t3, 0x31));
+				}
+				for (; i < ie; ++i) {
+					for (int k = 0; k < 4; ++k) {
+						aResult[i][j + k] = aColumns[j + k][i];
+					}
+				}
+			}
+			for (; j < je; ++j) {
+				for (int i = ib; i < ie; ++i) {
+					aResult[i][j] = aColumns[j][i];
+				}
+			}
+		}
+	}
+}
+#endif
+
+
+/*
+ * This is the blocked product for multiply() with the kernel given.
+ * Each block of the result is loaded into the kernel's block - or
+ * zeros for the first slice of the inner dimension - and stored back
+ * after each slice, so every element is summed in order all the way
+ * down whatever the kernel is.
+ */
+static void blockedMultiply( CKVectorKernel aKernel, int aRows, int aCols, int anInner,
+							 const double * const *anA, bool aTransposeA,
+							 const double * const *aB, double * const *aResult )
+{
+	int		mc = (aRows < CKVECTOR_MC ? aRows : CKVECTOR_MC);
+	int		nc = (aCols < CKVECTOR_NC ? aCols : CKVECTOR_NC);
+	int		kc = (anInner < CKVECTOR_KC ? anInner : CKVECTOR_KC);
+	// the packs are whole panels, so round up to them
+	std::vector<double>	packA(((mc + CKVECTOR_MR - 1) / CKVECTOR_MR) * CKVECTOR_MR * kc);
+	std::vector<double>	packB(((nc + CKVECTOR_NR - 1) / CKVECTOR_NR) * CKVECTOR_NR * kc);
+	double				block[CKVECTOR_MR * CKVECTOR_NR];
+
+	for (int jc = 0; jc < aCols; jc += CKVECTOR_NC) {
+		int		cols = (aCols - jc < CKVECTOR_NC ? aCols - jc : CKVECTOR_NC);
+		for (int pc = 0; pc < anInner; pc += CKVECTOR_KC) {
+			int		depth = (anInner - pc < CKVECTOR_KC ? anInner - pc : CKVECTOR_KC);
+			packColumns(aB, jc, cols, pc, depth, &packB[0]);
+			for (int ic = 0; ic < aRows; ic += CKVECTOR_MC) {
+				int		rows = (aRows - ic < CKVECTOR_MC ? aRows - ic : CKVECTOR_MC);
+				packRows(anA, aTransposeA, ic, rows, pc, depth, &packA[0]);
+				for (int jr = 0; jr < cols; jr += CKVECTOR_NR) {
+					int		nr = (cols - jr < CKVECTOR_NR ? cols - jr : CKVECTOR_NR);
+					for (int ir = 0; ir < rows; ir += CKVECTOR_MR) {
+						int		mr = (rows - ir < CKVECTOR_MR ? rows - ir : CKVECTOR_MR);
+						for (int j = 0; j < CKVECTOR_NR; ++j) {
+							const double	*c = (j < nr ? aResult[jc + jr + j] + ic + ir : NULL);
+							for (int i = 0; i < CKVECTOR_MR; ++i) {
+								block[j * CKVECTOR_MR + i] =
+									((pc > 0) && (c != NULL) && (i < mr) ? c[i] : 0.0);
+							}
+						}
+						(*aKernel)(depth, &packA[ir * depth], &packB[jr * depth], block);
+						for (int j = 0; j < nr; ++j) {
+							double	*c = aResult[jc + jr + j] + ic + ir;
+							for (int i = 0; i < mr; ++i) {
+								c[i] = block[j * CKVECTOR_MR + i];
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+
+/*
+ * These pick the AVX2 kernel if it can be used, and the plain one
+ * if it can't.
+ */
+template <class OP> static void doScalar( double *aValues, int aCount, double anArg )
+{
+#ifdef CKVECTOR_HAVE_AVX2
+	if (CKVectorMath::useSIMD()) {
+		avxScalar<OP>(aValues, aCount, anArg);
+		return;
+	}
+#endif
+	plainScalar<OP>(aValues, aCount, anArg);
+}
+
+
+template <class OP> static void doArray( double *aValues, const double *anArgs, int aCount )
+{
+#ifdef CKVECTOR_HAVE_AVX2
+	if (CKVectorMath::useSIMD()) {
+		avxArray<OP>(aValues, anArgs, aCount);
+		return;
+	}
+#endif
+	plainArray<OP>(aValues, anArgs, aCount);
+}
+
+
+template <class OP> static void doMasked( double *aValues, const unsigned char *aValid,
+										  const double *anArgs, const unsigned char *anArgsValid,
+										  int aCount )
+{
+#ifdef CKVECTOR_HAVE_AVX2
+	if (CKVectorMath::useSIMD()) {
+		avxMasked<OP>(aValues, aValid, anArgs, anArgsValid, aCount);
+		return;
+	}
+#endif
+	plainMasked<OP>(aValues, aValid, anArgs, anArgsValid, aCount);
+}
+
+
+
+/*******************************************************************
+ *
+ *                     Kernel Methods
+ *
+ *******************************************************************/
+/*
+ * This does the operation with the one value on each of the
+ * 'aCount' doubles in the array, so for '-' it's:
+ *     aValues[i] = aValues[i] - anArg
+ */
+void CKVectorMath::apply( char anOp, double *aValues, int aCount, double anArg )
+{
+	checkOp(anOp, "apply(char, double *, int, double)");
+	if (aCount <= 0) {
+		return;
+	}
+	if (aValues == NULL) {
+		throw CKException(__FILE__, __LINE__, "CKVectorMath::apply(char, "
+			"double *, int, double) - the array of values is NULL. Please "
+			"make sure there's something to work on before calling this method.");
+	}
+
+	switch (anOp) {
+		case '+':	doScalar<CKVectorAdd>(aValues, aCount, anArg);			break;
+		case '-':	doScalar<CKVectorSubtract>(aValues, aCount, anArg);		break;
+		case '*':	doScalar<CKVectorMultiply>(aValues, aCount, anArg);		break;
+		case '/':	doScalar<CKVectorDivide>(aValues, aCount, anArg);		break;
+	}
+}
+
+
+/*
+ * This does the operation element by element with the second
+ * array, leaving the results in the first:
+ *     aValues[i] = aValues[i] op anArgs[i]
+ */
+void CKVectorMath::apply( char anOp, double *aValues, const double *anArgs, int aCount )
+{
+	checkOp(anOp, "apply(char, double *, const double *, int)");
+	if (aCount <= 0) {
+		return;
+	}
+	if ((aValues == NULL) || (anArgs == NULL)) {
+		throw CKException(__FILE__, __LINE__, "CKVectorMath::apply(char, "
+			"double *, const double *, int) - one of the arrays is NULL. "
+			"Please make sure there's something to work on before calling "
+			"this method.");
+	}
+
+	switch (anOp) {
+		case '+':	doArray<CKVectorAdd>(aValues, anArgs, aCount);			break;
+		case '-':	doArray<CKVectorSubtract>(aValues, anArgs, aCount);		break;
+		case '*':	doArray<CKVectorMultiply>(aValues, anArgs, aCount);		break;
+		case '/':	doArray<CKVectorDivide>(aValues, anArgs, aCount);		break;
+	}
+}
+
+
+/*
+ * This is the same as the one above, but each of the arrays has a
+ * bitmap saying which of its elements are really there - bit
+ * (i & 7) of byte (i >> 3) - and only the elements that are there
+ * in both are done. The others are left alone.
+ */
+void CKVectorMath::apply( char anOp, double *aValues, const unsigned char *aValid,
+						  const double *anArgs, const unsigned char *anArgsValid,
+						  int aCount )
+{
+	checkOp(anOp, "apply(char, double *, const unsigned char *, const double *, "
+		"const unsigned char *, int)");
+	if (aCount <= 0) {
+		return;
+	}
+	if ((aValues == NULL) || (aValid == NULL) ||
+		(anArgs == NULL) || (anArgsValid == NULL)) {
+		throw CKException(__FILE__, __LINE__, "CKVectorMath::apply(char, "
+			"double *, const unsigned char *, const double *, const unsigned "
+			"char *, int) - one of the arrays or bitmaps is NULL. Please make "
+			"sure there's something to work on before calling this method.");
+	}
+
+	switch (anOp) {
+		case '+':	doMasked<CKVectorAdd>(aValues, aValid, anArgs, anArgsValid, aCount);		break;
+		case '-':	doMasked<CKVectorSubtract>(aValues, aValid, anArgs, anArgsValid, aCount);	break;
+		case '*':	doMasked<CKVectorMultiply>(aValues, aValid, anArgs, anArgsValid, aCount);	break;
+		case '/':	doMasked<CKVectorDivide>(aValues, aValid, anArgs, anArgsValid, aCount);		break;
+	}
+}
+
+
+/*
+ * This takes the inverse of each of the doubles in the array:
+ *     aValues[i] = 1.0 / aValues[i]
+ */
+void CKVectorMath::inverse( double *aValues, int aCount )
+{
+	if (aCount <= 0) {
+		return;
+	}
+	if (aValues == NULL) {
+		throw CKException(__FILE__, __LINE__, "CKVectorMath::inverse(double *, "
+			"int) - the array of values is NULL. Please make sure there's "
+			"something to work on before calling this method.");
+	}
+
+	doScalar<CKVectorInverse>(aValues, aCount, 1.0);
+}
+
+
+/*
+ * This makes 'aResult' the aRows x aCols product of 'anA', which
+ * is aRows x anInner, and 'aB', which is anInner x aCols:
+ *     aResult[j][i] = sum over p of anA[p][i] * aB[j][p]
+ * summed with p going up. If 'aTransposeA' is true, 'anA' is given
+ * the other way around, and it's anA[i][p] that's used.
+ */
+void CKVectorMath::multiply( int aRows, int aCols, int anInner,
+							 const double * const *anA, bool aTransposeA,
+							 const double * const *aB, double * const *aResult )
+{
+	static const char	*method = "multiply(int, int, int, const double * const *, "
+		"bool, const double * const *, double * const *)";
+	if ((aRows <= 0) || (aCols <= 0)) {
+		return;
+	}
+	checkMatrix(aResult, aCols, method);
+	if (anInner <= 0) {
+		// nothing to sum means it's all zeros
+		for (int j = 0; j < aCols; ++j) {
+			for (int i = 0; i < aRows; ++i) {
+				aResult[j][i] = 0.0;
+			}
+		}
+		return;
+	}
+	checkMatrix(anA, (aTransposeA ? aRows : anInner), method);
+	checkMatrix(aB, aCols, method);
+
+	CKVectorKernel	kernel = plainKernel;
+#ifdef CKVECTOR_HAVE_AVX2
+	if (useSIMD()) {
+		kernel = avxKernel;
+	}
+#endif
+	blockedMultiply(kernel, aRows, aCols, anInner, anA, aTransposeA, aB, aResult);
+}
+
+
+/*
+ * This makes 'aResult', which is aCols x aRows, the transpose of
+ * the aRows x aCols matrix:
+ *     aResult[i][j] = aColumns[j][i]
+ */
+void CKVectorMath::transpose( int aRows, int aCols, const double * const *aColumns,
+							  double * const *aResult )
+{
+	static const char	*method = "transpose(int, int, const double * const *, "
+		"double * const *)";
+	if ((aRows <= 0) || (aCols <= 0)) {
+		return;
+	}
+	checkMatrix(aColumns, aCols, method);
+	checkMatrix(aResult, aRows, method);
+
+#ifdef CKVECTOR_HAVE_AVX2
+	if (useSIMD()) {
+		avxTranspose(aRows, aCols, aColumns, aResult);
+		return;
+	}
+#endif
+	plainTranspose(aRows, aCols, aColumns, aResult);
+}
+
+
+/*
+ * This returns true if the AVX2 kernels are built in, the
+ * processor has AVX2, and they haven't been turned off with
+ * setUseSIMD(). The plain loops are used otherwise.
+ */
+bool CKVectorMath::useSIMD()
+{
+#ifdef CKVECTOR_HAVE_AVX2
+	return (mUseSIMD && haveAVX2());
+#else
+	return false;
+#endif
+}
+
+
+/*
+ * This turns the AVX2 kernels on and off for the whole process.
+ * They're on by default when they can be.
+ */
+void CKVectorMath::setUseSIMD( bool aFlag )
+{
+	mUseSIMD = aFlag;
+}
+
+
+/*
+ * This makes sure that the operation is one we know, and throws
+ * a CKException if it isn't.
+ */
+void CKVectorMath::checkOp( char anOp, const char *aMethod )
+{
+	if ((anOp != '+') && (anOp != '-') && (anOp != '*') && (anOp != '/')) {
+		std::ostringstream	msg;
+		msg << "CKVectorMath::" << aMethod << " - the operation '" << anOp <<
+			"' isn't one of '+', '-', '*' or '/'. Please make sure that it is.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+}
+
+
+/*
+ * This makes sure the matrix - the array of its columns, and each of
+ * them - is there, and throws a CKException if it isn't.
+ */
+void CKVectorMath::checkMatrix( const double * const *aMatrix, int aCount,
+								const char *aMethod )
+{
+	bool	ok = (aMatrix != NULL);
+	for (int j = 0; ok && (j < aCount); ++j) {
+		ok = (aMatrix[j] != NULL);
+	}
+	if (!ok) {
+		std::ostringstream	msg;
+		msg << "CKVectorMath::" << aMethod << " - one of the matrices, or one "
+			"of its columns, is NULL. Please make sure there's something to "
+			"work on before calling this method.";
+		throw CKException(__FILE__, __LINE__, msg.str());
+	}
+}
@@ -0,0 +1,143 @@
+/*
+ * CKVectorMath.h - this file defines the kernels that do the simple math
+ *                  on contiguous arrays of doubles - the dense columns of a
+ *                  columnar CKTable, for instance. Each one is a tight pass
+ *                  over the array, and where the compiler can build it and
+ *                  the processor has it, the pass is done four doubles at a
+ *                  time with AVX2. Otherwise, it's a plain loop that does
+ *                  exactly the same IEEE-754 math, so a NAN stays a NAN and
+ *                  a division by zero is an infinity either way. There are
+ *                  also the blocked matrix product and transpose for the
+ *                  matrix methods of CKTable.
+ *
+ * $Id$
+ */
+#ifndef __CKVECTORMATH_H
+#define __CKVECTORMATH_H
+
+//	System Headers
+
+//	Third-Party Headers
+
+//	Other Headers
+
+//	Forward Declarations
+
+//	Public Constants
+/*
+ * The AVX2 kernels need a compiler that can build a single function
+ * for AVX2 without building the whole library for it, and ask the
+ * processor at run-time if it has it. That's GCC 4.9 and later, or
+ * clang, on x86. Defining CKVECTOR_NO_SIMD leaves them out.
+ */
+#if !defined(CKVECTOR_NO_SIMD) && (defined(__i386__) || defined(__x86_64__))
+#if defined(__clang__) || (defined(__GNUC__) && \
+	((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 9))))
+#define CKVECTOR_HAVE_AVX2		1
+#endif
+#endif
+
+//	Public Datatypes
+
+//	Public Data Constants
+
+
+
+/*
+ * This class is just a holder of the kernels - there's nothing to
+ * make an instance of. The operation 'anOp' is one of '+', '-', '*'
+ * or '/', and anything else throws a CKException.
+ */
+class CKVectorMath
+{
+	public:
+		/*
+		 * This does the operation with the one value on each of the
+		 * 'aCount' doubles in the array, so for '-' it's:
+		 *     aValues[i] = aValues[i] - anArg
+		 */
+		static void apply( char anOp, double *aValues, int aCount, double anArg );
+		/*
+		 * This does the operation element by element with the second
+		 * array, leaving the results in the first:
+		 *     aValues[i] = aValues[i] op anArgs[i]
+		 */
+		static void apply( char anOp, double *aValues, const double *anArgs, int aCount );
+		/*
+		 * This is the same as the one above, but each of the arrays has a
+		 * bitmap saying which of its elements are really there - bit
+		 * (i & 7) of byte (i >> 3) - and only the elements that are there
+		 * in both are done. The others are left alone. Runs of eight that
+		 * are all there are done at full speed, so it's only the holes
+		 * that cost anything.
+		 */
+		static void apply( char anOp, double *aValues, const unsigned char *aValid,
+						   const double *anArgs, const unsigned char *anArgsValid,
+						   int aCount );
+		/*
+		 * This takes the inverse of each of the doubles in the array:
+		 *     aValues[i] = 1.0 / aValues[i]
+		 */
+		static void inverse( double *aValues, int aCount );
+
+		/*
+		 * These are the matrix kernels. A matrix is an array of pointers
+		 * to its columns - just the way a columnar CKTable keeps them - so
+		 * the element in row i and column j of 'aColumns' is aColumns[j][i].
+		 * The work is done in blocks that fit in the caches, and with AVX2
+		 * each element is still summed in exactly the same order as the
+		 * plain loops do it, so the results are the same either way.
+		 */
+		/*
+		 * This makes 'aResult' the aRows x aCols product of 'anA', which
+		 * is aRows x anInner, and 'aB', which is anInner x aCols:
+		 *     aResult[j][i] = sum over p of anA[p][i] * aB[j][p]
+		 * summed with p going up. If 'aTransposeA' is true, 'anA' is given
+		 * the other way around - anInner x aRows - and it's the transpose
+		 * of it that's used, anA[i][p], without ever making it.
+		 */
+		static void multiply( int aRows, int aCols, int anInner,
+							  const double * const *anA, bool aTransposeA,
+							  const double * const *aB, double * const *aResult );
+		/*
+		 * This makes 'aResult', which is aCols x aRows, the transpose of
+		 * the aRows x aCols matrix:
+		 *     aResult[i][j] = aColumns[j][i]
+		 */
+		static void transpose( int aRows, int aCols, const double * const *aColumns,
+							   double * const *aResult );
+
+		/*
+		 * This returns true if the AVX2 kernels are built in, the
+		 * processor has AVX2, and they haven't been turned off with
+		 * setUseSIMD(). The plain loops are used otherwise.
+		 */
+		static bool useSIMD();
+		/*
+		 * This turns the AVX2 kernels on and off for the whole process.
+		 * They're on by default when they can be, and turning them on
+		 * when they can't be does nothing. It's really only here so the
+		 * two can be compared.
+		 */
+		static void setUseSIMD( bool aFlag );
+
+	private:
+		/*
+		 * This makes sure that the operation is one we know, and throws
+		 * a CKException if it isn't.
+		 */
+		static void checkOp( char anOp, const char *aMethod );
+		/*
+		 * This makes sure the matrices are there if there's anything to
+		 * do, and throws a CKException if they aren't.
+		 */
+		static void checkMatrix( const double * const *aMatrix, int aCount,
+								 const char *aMethod );
+
+		/*
+		 * This is true if the AVX2 kernels haven't been turned off.
+		 */
+		static volatile bool	mUseSIMD;
+};
+
+#endif	// __CKVECTORMATH_H
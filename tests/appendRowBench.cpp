@@ -0,0 +1,281 @@
+/*
+ * This is a test program for adding rows and columns to a CKTable one at
+ * a time. It checks that appendRow(), appendColumn(), reserveRows() and
+ * growing with resizeTable() give just the table a single resizeTable()
+ * would - in both layouts, with dense columns, after shrinking, and in a
+ * merge - and then times building a big table a row at a time each of
+ * those ways. Run it as:
+ *
+ *     appendRowBench [rows] [cols]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "CKTable.h"
+#include "CKString.h"
+#include "CKException.h"
+#include "benchUtils.h"
+
+/*
+ * This fills in row 'aRow' with its label and values - numbers in all
+ * but the last column, which gets a string every so often.
+ */
+static void fillRow( CKTable & aTable, int aRow )
+{
+	char	buff[64];
+	int		cols = aTable.getNumColumns();
+	snprintf(buff, sizeof(buff), "r%d", aRow);
+	aTable.setRowLabel(aRow, buff);
+	for (int j = 0; j < cols - 1; ++j) {
+		aTable.setDoubleValue(aRow, j, aRow * 0.5 + j);
+	}
+	if ((aRow % 7) == 0) {
+		aTable.setStringValue(aRow, cols - 1, "abc");
+	}
+}
+
+
+/*
+ * This makes the table the old way - all at once - to check the others
+ * against.
+ */
+static CKTable makeTable( int aRows, int aCols )
+{
+	CKTable		table(aRows, aCols);
+	for (int i = 0; i < aRows; ++i) {
+		fillRow(table, i);
+	}
+	return table;
+}
+
+
+/*
+ * This checks that the table matches the one made all at once, and
+ * finds a few of its labels, and returns the number of problems.
+ */
+static int checkTable( const CKTable & aTable, int aRows, int aCols, const char *aName )
+{
+	int			problems = 0;
+	char		last[64];
+	CKTable		expected = makeTable(aRows, aCols);
+	snprintf(last, sizeof(last), "r%d", aRows - 1);
+	if ((aTable.getNumRows() != aRows) || (aTable.getNumColumns() != aCols) ||
+		(aTable.getRowCapacity() < aRows)) {
+		std::cout << "PROBLEM! The " << aName << " table is " << aTable.getNumRows() <<
+			"x" << aTable.getNumColumns() << " with room for " <<
+			aTable.getRowCapacity() << " rows." << std::endl;
+		return 1;
+	}
+	if (aTable != expected) {
+		std::cout << "PROBLEM! The " << aName << " table didn't match." << std::endl;
+		++problems;
+	}
+	if ((aTable.getRowForLabel("r0") != 0) ||
+		(aTable.getRowForLabel(last) != aRows - 1)) {
+		std::cout << "PROBLEM! The " << aName << " table didn't find its labels." << std::endl;
+		++problems;
+	}
+	return problems;
+}
+
+
+/*
+ * This builds tables every way there is to add rows and columns, and
+ * checks each against the one made all at once.
+ */
+static int checkAppends( int aRows )
+{
+	int		problems = 0;
+	int		cols = 4;
+
+	// one row at a time in each layout - and with dense columns
+	for (int layout = 0; layout < 3; ++layout) {
+		CKTable		table(1, cols);
+		if (layout == 1) {
+			table.setColumnar(true);
+		} else if (layout == 2) {
+			for (int j = 0; j < cols - 1; ++j) {
+				table.setColumnType(j, eNumberVariant);
+			}
+		}
+		fillRow(table, 0);
+		for (int i = 1; i < aRows; ++i) {
+			if (table.appendRow() != i) {
+				std::cout << "PROBLEM! appendRow() didn't return " << i << "." << std::endl;
+				++problems;
+				break;
+			}
+			fillRow(table, i);
+		}
+		const char	*names[] = { "row-major", "columnar", "dense" };
+		problems += checkTable(table, aRows, cols, names[layout]);
+		if ((layout == 2) && (table.getColumnType(0) != eNumberVariant)) {
+			std::cout << "PROBLEM! The dense column didn't stay dense." << std::endl;
+			++problems;
+		}
+	}
+
+	// one column at a time in both layouts - the rows are already there
+	for (int layout = 0; layout < 2; ++layout) {
+		CKTable		table(aRows, 1);
+		if (layout == 1) {
+			table.setColumnar(true);
+		}
+		for (int j = 1; j < cols; ++j) {
+			if (table.appendColumn() != j) {
+				std::cout << "PROBLEM! appendColumn() didn't return " << j << "." << std::endl;
+				++problems;
+			}
+		}
+		for (int i = 0; i < aRows; ++i) {
+			fillRow(table, i);
+		}
+		problems += checkTable(table, aRows, cols, (layout == 0 ?
+							"row-major by column" : "columnar by column"));
+	}
+
+	// reserving the room first, and growing with resizeTable()
+	CKTable		reserved(1, cols);
+	reserved.reserveRows(aRows);
+	if (reserved.getRowCapacity() != aRows) {
+		std::cout << "PROBLEM! reserveRows() gave room for " <<
+			reserved.getRowCapacity() << " rows." << std::endl;
+		++problems;
+	}
+	CKTable		resized(1, cols);
+	for (int i = 0; i < aRows; ++i) {
+		if (i > 0) {
+			reserved.appendRow();
+			resized.resizeTable(i + 1, cols);
+		}
+		fillRow(reserved, i);
+		fillRow(resized, i);
+	}
+	problems += checkTable(reserved, aRows, cols, "reserved");
+	problems += checkTable(resized, aRows, cols, "resized");
+
+	// shrinking has to leave nothing behind for the appended rows
+	CKTable		shrunk = makeTable(aRows, cols);
+	int			half = (aRows + 1) / 2;
+	shrunk.resizeTable(half, cols);
+	for (int i = half; i < aRows; ++i) {
+		shrunk.appendRow();
+		if (shrunk.getType(i, 0) != eUnknownVariant) {
+			std::cout << "PROBLEM! The appended row " << i << " wasn't empty." << std::endl;
+			++problems;
+			break;
+		}
+		fillRow(shrunk, i);
+	}
+	problems += checkTable(shrunk, aRows, cols, "shrunk");
+
+	// the labels and headers that are given go in the index
+	CKTable		labelled(1, 1);
+	labelled.setColumnHeader(0, "a");
+	labelled.appendColumn("b");
+	labelled.appendRow("IBM");
+	labelled.setDoubleValue("IBM", "b", 2.5);
+	if ((labelled.getDoubleValue(1, 1) != 2.5) || (labelled.getColumnForHeader("b") != 1)) {
+		std::cout << "PROBLEM! The appended labels weren't found." << std::endl;
+		++problems;
+	}
+
+	// a merge grows the table the same way - the headers line them up
+	CKTable		merged = makeTable(half, cols);
+	CKTable		tail = makeTable(aRows, cols);
+	CKTable		whole = makeTable(aRows, cols);
+	for (int j = 0; j < cols; ++j) {
+		char	buff[16];
+		snprintf(buff, sizeof(buff), "c%d", j);
+		merged.setColumnHeader(j, buff);
+		tail.setColumnHeader(j, buff);
+		whole.setColumnHeader(j, buff);
+	}
+	merged.merge(tail);
+	if (merged != whole) {
+		std::cout << "PROBLEM! The merged table didn't match." << std::endl;
+		++problems;
+	}
+
+	// ...and a table with no storage can't have anything added
+	CKTable		empty;
+	try {
+		empty.appendRow();
+		std::cout << "PROBLEM! An empty table took a row." << std::endl;
+		++problems;
+	} catch (CKException & e) {
+		// this is what we want
+	}
+	return problems;
+}
+
+
+int main(int argc, char *argv[]) {
+	int		rows = (argc > 1 ? atoi(argv[1]) : 1000000);
+	int		cols = (argc > 2 ? atoi(argv[2]) : 4);
+
+	int		problems = 0;
+	try {
+		int		sizes[] = { 1, 2, 15, 16, 17, 100, 1000 };
+		for (unsigned int s = 0; s < sizeof(sizes)/sizeof(int); ++s) {
+			problems += checkAppends(sizes[s]);
+		}
+		if (problems == 0) {
+			std::cout << "The appended tables are OK." << std::endl;
+		}
+
+		/*
+		 * Each run builds the table up a row at a time from one row,
+		 * setting every cell of each row as it's added, the way a table
+		 * is filled in from a feed.
+		 */
+		const char	*runs[] = { "appendRow row-major", "appendRow columnar",
+								"appendRow dense", "reserveRows first",
+								"resizeTable" };
+		std::cout << "Building a " << rows << "x" << cols << " table a row at "
+			"a time:" << std::endl;
+		std::cout << std::fixed << std::setprecision(1);
+		for (int r = 0; r < 5; ++r) {
+			double		start = now();
+			CKTable		table(1, cols);
+			if (r == 1) {
+				table.setColumnar(true);
+			} else if (r == 2) {
+				for (int j = 0; j < cols; ++j) {
+					table.setColumnType(j, eNumberVariant);
+				}
+			} else if (r == 3) {
+				table.reserveRows(rows);
+			}
+			for (int i = 0; i < rows; ++i) {
+				if (i > 0) {
+					if (r == 4) {
+						table.resizeTable(i + 1, cols);
+					} else {
+						table.appendRow();
+					}
+				}
+				for (int j = 0; j < cols; ++j) {
+					table.setDoubleValue(i, j, i + j * 0.25);
+				}
+			}
+			double		elapsed = now() - start;
+
+			if ((table.getNumRows() != rows) ||
+				(table.getDoubleValue(rows - 1, cols - 1) != rows - 1 + (cols - 1) * 0.25)) {
+				std::cout << "PROBLEM! The " << runs[r] << " table wasn't right." << std::endl;
+				++problems;
+			}
+			std::cout << "  " << std::setw(20) << std::left << runs[r] << std::right <<
+				std::setw(9) << (elapsed * 1000.0) << " ms " << std::setw(8) <<
+				(elapsed * 1e9 / rows) << " ns/row" << std::endl;
+		}
+	} catch (CKException & e) {
+		problems += problem(e);
+	}
+
+	return finish(problems, "All the ways of adding rows and columns match.");
+}
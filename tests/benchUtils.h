@@ -0,0 +1,102 @@
+/*
+ * benchUtils.h - this is the handful of things that the benchmarks and
+ *                tests of the tables and variants all need - the wall
+ *                clock to time the runs with, a cell-by-cell comparison
+ *                of two tables that treats a NaN as the same as a NaN,
+ *                and the way they all report a problem and finish up.
+ *                Each of them is a single file, so these are inline.
+ */
+#ifndef __BENCHUTILS_H
+#define __BENCHUTILS_H
+
+//	System Headers
+#include <iostream>
+#include <math.h>
+#include <sys/time.h>
+
+//	Third-Party Headers
+
+//	Other Headers
+#include "CKTable.h"
+#include "CKException.h"
+
+/*
+ * This is the wall clock in seconds for timing the runs.
+ */
+inline double now()
+{
+	timeval		tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec/1000000.0;
+}
+
+
+/*
+ * This compares the tables a cell at a time - unlike operator==(), a
+ * NaN is the same as a NaN, and the tables with missing prices and
+ * times have plenty of them.
+ */
+inline bool sameTable( const CKTable & aTable, const CKTable & anOther )
+{
+	if ((aTable.getNumRows() != anOther.getNumRows()) ||
+		(aTable.getNumColumns() != anOther.getNumColumns())) {
+		return false;
+	}
+	for (int j = 0; j < aTable.getNumColumns(); ++j) {
+		if (aTable.getColumnHeader(j) != anOther.getColumnHeader(j)) {
+			return false;
+		}
+	}
+	for (int i = 0; i < aTable.getNumRows(); ++i) {
+		if (aTable.getRowLabel(i) != anOther.getRowLabel(i)) {
+			return false;
+		}
+		for (int j = 0; j < aTable.getNumColumns(); ++j) {
+			CKVariantType	type = aTable.getType(i, j);
+			if (type != anOther.getType(i, j)) {
+				return false;
+			}
+			if (type == eNumberVariant) {
+				double	a = aTable.getDoubleValue(i, j);
+				double	b = anOther.getDoubleValue(i, j);
+				if ((a != b) && !(isnan(a) && isnan(b))) {
+					return false;
+				}
+			} else if ((type != eUnknownVariant) &&
+					   (aTable.getValueAsString(i, j) != anOther.getValueAsString(i, j))) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+
+/*
+ * This reports an exception that got out of the checks or the timing
+ * and returns the one problem it counts as, so a main() can just say:
+ *
+ *     } catch (CKException & e) {
+ *         problems += problem(e);
+ *     }
+ */
+inline int problem( const CKException & anException )
+{
+	std::cout << "PROBLEM! " << anException.getMessage() << std::endl;
+	return 1;
+}
+
+
+/*
+ * This is the end of every main() - if there weren't any problems it
+ * says so, if there's something to say, and it returns the exit code.
+ */
+inline int finish( int aProblems, const char *anAllGood = NULL )
+{
+	if ((aProblems == 0) && (anAllGood != NULL)) {
+		std::cout << anAllGood << std::endl;
+	}
+	return (aProblems == 0 ? 0 : 1);
+}
+
+#endif	// __BENCHUTILS_H
@@ -0,0 +1,244 @@
+/*
+ * This is a test program that checks that all the values a CKVariant can
+ * hold come back out of their binary codes just as they went in, and that
+ * a bad code is caught. It then times the encoding and decoding of a big
+ * table of mixed values - with the binary codes and with the text codes -
+ * and shows the rates of each. Run it as:
+ *
+ *     binaryBench [rows] [cols] [passes]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "CKVariant.h"
+#include "CKPrice.h"
+#include "CKTable.h"
+#include "CKTimeSeries.h"
+#include "CKTimeTable.h"
+#include "CKString.h"
+#include "CKException.h"
+#include "benchUtils.h"
+
+/*
+ * This fills a table with a mix of strings, numbers, dates and prices.
+ */
+static void fillTable( CKTable & aTable, int aRows, int aCols )
+{
+	char		buff[64];
+	aTable = CKTable(aRows, aCols);
+	for (int j = 0; j < aCols; ++j) {
+		snprintf(buff, sizeof(buff), "col%d", j);
+		aTable.setColumnHeader(j, buff);
+	}
+	for (int i = 0; i < aRows; ++i) {
+		snprintf(buff, sizeof(buff), "row%d", i);
+		aTable.setRowLabel(i, buff);
+		for (int j = 0; j < aCols; ++j) {
+			switch ((i + j) % 4) {
+				case 0:
+					snprintf(buff, sizeof(buff), "SYM%d", i * aCols + j);
+					aTable.setStringValue(i, j, buff);
+					break;
+				case 1:
+					aTable.setDoubleValue(i, j, (i + 1) * 3.14159265358979 / (j + 1));
+					break;
+				case 2:
+					aTable.setDateValue(i, j, 20060101 + (i % 28));
+					break;
+				case 3:
+					{
+						CKPrice		p(i * 0.25, j * 1.5);
+						aTable.setPriceValue(i, j, &p);
+					}
+					break;
+			}
+		}
+	}
+}
+
+
+/*
+ * This checks that the variant comes back out of its binary code the
+ * same, and returns 1 if it doesn't.
+ */
+static int checkRoundTrip( const char *aName, const CKVariant & aValue )
+{
+	CKVariant	back;
+	back.fromBinary(aValue.toBinary());
+	if (back != aValue) {
+		std::cout << "PROBLEM! The " << aName << " didn't come back the same: " <<
+			aValue << " became " << back << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+
+/*
+ * This checks all the kinds of values, and returns the number of problems.
+ */
+static int checkCodes()
+{
+	int		problems = 0;
+
+	// the simple ones - including strings with NULLs and delimiters in them
+	problems += checkRoundTrip("unknown", CKVariant());
+	problems += checkRoundTrip("string", CKVariant("IBM"));
+	problems += checkRoundTrip("empty string", CKVariant(""));
+	CKString	odd("a|b\x01");
+	odd.append('\0');
+	odd.append("c");
+	problems += checkRoundTrip("odd string", CKVariant(&odd));
+	problems += checkRoundTrip("number", CKVariant(0.1 + 0.2));
+	problems += checkRoundTrip("date", CKVariant(20061225L));
+	CKPrice		price(10.25, 13.50);
+	problems += checkRoundTrip("price", CKVariant(&price));
+
+	// a table of everything
+	CKTable		table;
+	fillTable(table, 5, 4);
+	problems += checkRoundTrip("table", CKVariant(&table));
+	CKTable		empty;
+	problems += checkRoundTrip("empty table", CKVariant(&empty));
+
+	// a time series with timestamps the text code would round
+	CKTimeSeries	series;
+	series.put(20060101.0, 1.0);
+	series.put(20060102.123456789, 1.0/3.0);
+	series.put(20060103.5, -2.5e-300);
+	problems += checkRoundTrip("time series", CKVariant(&series));
+
+	// a list holding a table and a list
+	CKVariantList	inner;
+	inner.addToEnd(CKVariant(1.0));
+	inner.addToEnd(CKVariant("two"));
+	CKVariantList	list;
+	list.addToEnd(CKVariant(&table));
+	list.addToEnd(CKVariant(&inner));
+	list.addToEnd(CKVariant(&price));
+	problems += checkRoundTrip("list", CKVariant(&list));
+
+	// a time table with a couple of days
+	CKStringList	rows;
+	rows.addToEnd("a");
+	rows.addToEnd("b");
+	CKStringList	cols;
+	cols.addToEnd("x");
+	CKTimeTable		timeTable(rows, cols);
+	timeTable.setDoubleValue(20060101, "a", "x", 1.5);
+	timeTable.setStringValue(20060102, "b", "x", "MSFT");
+	problems += checkRoundTrip("time table", CKVariant(&timeTable));
+
+	// each class can also make its own code
+	CKTable		tableBack;
+	tableBack.fromBinary(table.toBinary());
+	if (tableBack != table) {
+		std::cout << "PROBLEM! The table didn't come back from its own code." << std::endl;
+		++problems;
+	}
+	CKTimeSeries	seriesBack;
+	seriesBack.fromBinary(series.toBinary());
+	if (seriesBack != series) {
+		std::cout << "PROBLEM! The series didn't come back from its own code." << std::endl;
+		++problems;
+	}
+
+	// a truncated code has to be caught...
+	std::string		code = CKVariant(&list).toBinary();
+	for (int len = 0; len < (int)code.size(); len += 7) {
+		try {
+			CKVariant	v;
+			v.fromBinary(code.data(), len);
+			std::cout << "PROBLEM! The code cut to " << len << " bytes was read." << std::endl;
+			++problems;
+			break;
+		} catch (CKException & e) {
+			// this is what we want
+		}
+	}
+	// ...and so does a code for the wrong kind of value
+	try {
+		CKTable		t;
+		t.fromBinary(series.toBinary());
+		std::cout << "PROBLEM! A series code was read as a table." << std::endl;
+		++problems;
+	} catch (CKException & e) {
+		// this is what we want
+	}
+
+	return problems;
+}
+
+
+int main(int argc, char *argv[]) {
+	int		rows = (argc > 1 ? atoi(argv[1]) : 1000);
+	int		cols = (argc > 2 ? atoi(argv[2]) : 20);
+	int		passes = (argc > 3 ? atoi(argv[3]) : 5);
+
+	int		problems = 0;
+	try {
+		problems = checkCodes();
+	} catch (CKException & e) {
+		problems += problem(e);
+	}
+	if (problems == 0) {
+		std::cout << "All the binary codes came back the same." << std::endl;
+	}
+
+	CKTable		table;
+	fillTable(table, rows, cols);
+	CKTable		back;
+
+	// time the binary codes
+	std::string		bin;
+	double			start = now();
+	for (int p = 0; p < passes; ++p) {
+		bin = table.toBinary();
+	}
+	double			binEncode = (now() - start) / passes;
+	start = now();
+	for (int p = 0; p < passes; ++p) {
+		back.fromBinary(bin);
+	}
+	double			binDecode = (now() - start) / passes;
+	if (back != table) {
+		std::cout << "PROBLEM! The big table didn't come back from its binary code." << std::endl;
+		++problems;
+	}
+
+	// ...and the text codes
+	CKString		text;
+	start = now();
+	for (int p = 0; p < passes; ++p) {
+		text = table.generateCodeFromValues();
+	}
+	double			textEncode = (now() - start) / passes;
+	start = now();
+	for (int p = 0; p < passes; ++p) {
+		back.takeValuesFromCode(text);
+	}
+	double			textDecode = (now() - start) / passes;
+
+	double	cells = (double)rows * cols;
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "A " << rows << "x" << cols << " table is " << bin.size() <<
+		" bytes in binary and " << text.size() << " bytes in text." << std::endl;
+	std::cout << "binary: encode " << (bin.size() / binEncode / 1e9) << " GB/s (" <<
+		std::setprecision(0) << (cells / binEncode) << " cells/sec), decode " <<
+		std::setprecision(3) << (bin.size() / binDecode / 1e9) << " GB/s (" <<
+		std::setprecision(0) << (cells / binDecode) << " cells/sec)" << std::endl;
+	std::cout << std::setprecision(3) << "text:   encode " <<
+		(text.size() / textEncode / 1e9) << " GB/s (" << std::setprecision(0) <<
+		(cells / textEncode) << " cells/sec), decode " << std::setprecision(3) <<
+		(text.size() / textDecode / 1e9) << " GB/s (" << std::setprecision(0) <<
+		(cells / textDecode) << " cells/sec)" << std::endl;
+	std::cout << std::setprecision(1) << "The binary codes are " <<
+		(textEncode / binEncode) << "x faster to encode and " <<
+		(textDecode / binDecode) << "x faster to decode." << std::endl;
+
+	return finish(problems);
+}
@@ -0,0 +1,320 @@
+/*
+ * This is a test program for the columnar layout of CKTable. It checks
+ * that a columnar table holds, shows, codes and does the math on its
+ * values just like the row-major table it came from, that the dense
+ * columns fall back to CKVariants when they have to, and then times the
+ * filling, reading and math on a big table of numbers in each layout.
+ * Run it as:
+ *
+ *     columnTableTest [rows] [cols] [passes]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "CKTable.h"
+#include "CKVariant.h"
+#include "CKPrice.h"
+#include "CKString.h"
+#include "CKException.h"
+#include "benchUtils.h"
+
+/*
+ * This makes a table with a column of numbers, one of dates, one of
+ * strings, one of a mix, and one that's empty - with a few holes in
+ * the numbers and dates.
+ */
+static CKTable makeMixed()
+{
+	char		buff[64];
+	CKTable		table(6, 5);
+	table.setColumnHeader(0, "px");
+	table.setColumnHeader(1, "date");
+	table.setColumnHeader(2, "sym");
+	table.setColumnHeader(3, "mix");
+	table.setColumnHeader(4, "empty");
+	for (int i = 0; i < 6; ++i) {
+		snprintf(buff, sizeof(buff), "r%d", i);
+		table.setRowLabel(i, buff);
+		if (i != 2) {
+			table.setDoubleValue(i, 0, 10.5 * (i + 1));
+		}
+		if (i != 4) {
+			table.setDateValue(i, 1, 20060101 + i);
+		}
+		snprintf(buff, sizeof(buff), "SYM%d", i);
+		table.setStringValue(i, 2, buff);
+		if (i % 2 == 0) {
+			table.setDoubleValue(i, 3, i * 1.5);
+		} else {
+			CKPrice		p(i * 0.25, i * 0.5);
+			table.setPriceValue(i, 3, &p);
+		}
+	}
+	return table;
+}
+
+
+/*
+ * This checks that the two tables agree in every way they can be seen,
+ * and returns 1 if they don't.
+ */
+static int checkSame( const char *aWhat, const CKTable & aRows, const CKTable & aCols )
+{
+	if (aRows != aCols) {
+		std::cout << "PROBLEM! " << aWhat << ": the tables aren't equal:" <<
+			std::endl << aRows << std::endl << aCols << std::endl;
+		return 1;
+	}
+	if (aRows.generateCodeFromValues() != aCols.generateCodeFromValues()) {
+		std::cout << "PROBLEM! " << aWhat << ": the text codes differ." << std::endl;
+		return 1;
+	}
+	if (aRows.toBinary() != aCols.toBinary()) {
+		std::cout << "PROBLEM! " << aWhat << ": the binary codes differ." << std::endl;
+		return 1;
+	}
+	if (aRows.toString() != aCols.toString()) {
+		std::cout << "PROBLEM! " << aWhat << ": the strings differ." << std::endl;
+		return 1;
+	}
+	for (int i = 0; i < aRows.getNumRows(); ++i) {
+		for (int j = 0; j < aRows.getNumColumns(); ++j) {
+			if (aRows.getType(i, j) != aCols.getType(i, j)) {
+				std::cout << "PROBLEM! " << aWhat << ": the types at " << i <<
+					", " << j << " differ." << std::endl;
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+
+/*
+ * This checks the columnar layout against the row-major one, and returns
+ * the number of problems.
+ */
+static int checkColumns()
+{
+	int		problems = 0;
+
+	// the types are found from what's in the columns
+	CKTable		rows = makeMixed();
+	CKTable		cols = rows;
+	cols.setColumnar(true);
+	if (!cols.isColumnar() || rows.isColumnar() ||
+		(cols.getColumnType("px") != eNumberVariant) ||
+		(cols.getColumnType("date") != eDateVariant) ||
+		(cols.getColumnType("sym") != eUnknownVariant) ||
+		(cols.getColumnType("mix") != eUnknownVariant) ||
+		(cols.getColumnType("empty") != eUnknownVariant)) {
+		std::cout << "PROBLEM! The column types weren't found right." << std::endl;
+		++problems;
+	}
+	problems += checkSame("columnar", rows, cols);
+
+	// copies stay columnar, and it all comes back out of the codes
+	CKTable		copy(cols);
+	if (!copy.isColumnar() || (copy.getDoubleColumn(0) == NULL)) {
+		std::cout << "PROBLEM! The copy of the columnar table isn't columnar." << std::endl;
+		++problems;
+	}
+	problems += checkSame("copy", rows, copy);
+	CKTable		back;
+	back.fromBinary(cols.toBinary());
+	problems += checkSame("binary", back, cols);
+	problems += checkSame("text", CKTable(cols.generateCodeFromValues()), cols);
+
+	// the dense arrays are right there
+	const double			*px = cols.getDoubleColumn(0);
+	const unsigned char		*valid = cols.getColumnValidity(0);
+	if ((px == NULL) || (px[5] != 63.0) || ((valid[0] & 0x04) != 0) ||
+		((valid[0] & 0x08) == 0) || (cols.getDateColumn(1)[3] != 20060104) ||
+		(cols.getDoubleColumn(1) != NULL) || (cols.getDoubleColumn(2) != NULL)) {
+		std::cout << "PROBLEM! The dense columns aren't what they should be." << std::endl;
+		++problems;
+	}
+
+	// the math on the values that can take it
+	rows.add(2.0);				cols.add(2.0);
+	rows.multiply(3.0);			cols.multiply(3.0);
+	rows.subtract(1.0);			cols.subtract(1.0);
+	rows.divide(4.0);			cols.divide(4.0);
+	rows.inverse();				cols.inverse();
+	problems += checkSame("math", rows, cols);
+	CKTable		other = makeMixed();
+	rows.add(other);			cols.add(other);
+	problems += checkSame("adding a row-major table", rows, cols);
+	other.setColumnar(true);
+	rows.multiply(other);		cols.multiply(other);
+	problems += checkSame("multiplying a columnar table", rows, cols);
+	CKTable		plain = makeMixed();
+	CKTable		plainToo = makeMixed();
+	plain.subtract(other);		plainToo.subtract(makeMixed());
+	problems += checkSame("subtracting a columnar table", plainToo, plain);
+
+	// empty cells stay empty, and a dense column takes an empty value
+	if ((cols.getType(2, 0) != eUnknownVariant) || (cols.getType(4, 1) != eUnknownVariant)) {
+		std::cout << "PROBLEM! The holes in the dense columns got filled." << std::endl;
+		++problems;
+	}
+	rows.setValue(1, 0, CKVariant());	cols.setValue(1, 0, CKVariant());
+	rows.setDoubleValue(2, 0, 7.0);		cols.setDoubleValue(2, 0, 7.0);
+	problems += checkSame("holes", rows, cols);
+
+	// a value that doesn't fit turns the column into variants
+	rows.setStringValue(3, 0, "oops");	cols.setStringValue(3, 0, "oops");
+	if (cols.getColumnType(0) != eUnknownVariant) {
+		std::cout << "PROBLEM! A string went into a dense column of numbers." << std::endl;
+		++problems;
+	}
+	problems += checkSame("falling back", rows, cols);
+	// ...and so does asking for a reference into one
+	rows.getValue(0, 1).setStringValue("ref");
+	cols.getValue(0, 1).setStringValue("ref");
+	if (cols.getColumnType(1) != eUnknownVariant) {
+		std::cout << "PROBLEM! getValue() didn't turn the column into variants." << std::endl;
+		++problems;
+	}
+	problems += checkSame("getValue", rows, cols);
+
+	// declaring a type that doesn't fit is caught
+	try {
+		cols.setColumnType("sym", eNumberVariant);
+		std::cout << "PROBLEM! A column of strings was made dense." << std::endl;
+		++problems;
+	} catch (CKException & e) {
+		// this is what we want
+	}
+	if (cols.getColumnType("sym") != eUnknownVariant) {
+		std::cout << "PROBLEM! The column of strings was changed." << std::endl;
+		++problems;
+	}
+	// ...but one that does fit is fine
+	cols.setColumnType(4, eDateVariant);
+	cols.setDateValue(0, 4, 20061225);
+	rows.setDateValue(0, 4, 20061225);
+	if (cols.getColumnType(4) != eDateVariant) {
+		std::cout << "PROBLEM! The empty column wasn't made dense." << std::endl;
+		++problems;
+	}
+	problems += checkSame("declared", rows, cols);
+
+	// resizing and merging keep the columns
+	rows.resizeTable(8, 6);			cols.resizeTable(8, 6);
+	cols.setDoubleValue(7, 5, 1.25);	rows.setDoubleValue(7, 5, 1.25);
+	problems += checkSame("growing", rows, cols);
+	rows.resizeTable(4, 5);			cols.resizeTable(4, 5);
+	problems += checkSame("shrinking", rows, cols);
+	if (cols.getColumnType(4) != eDateVariant) {
+		std::cout << "PROBLEM! The resize lost the column type." << std::endl;
+		++problems;
+	}
+	CKTable		more = makeMixed();
+	more.setColumnar(true);
+	rows.merge(more);				cols.merge(more);
+	problems += checkSame("merging", rows, cols);
+
+	// and it all goes back to rows
+	cols.setColumnar(false);
+	if (cols.isColumnar()) {
+		std::cout << "PROBLEM! The table didn't go back to rows." << std::endl;
+		++problems;
+	}
+	problems += checkSame("back to rows", rows, cols);
+
+	return problems;
+}
+
+
+/*
+ * This fills, reads and does the math on a big table of numbers, and
+ * returns the time it took for each.
+ */
+static void timeTable( bool aColumnar, int aRows, int aCols, int aPasses,
+					   double & aFill, double & aRead, double & aMath,
+					   double & aSum )
+{
+	CKTable		table(aRows, aCols);
+	if (aColumnar) {
+		for (int j = 0; j < aCols; ++j) {
+			table.setColumnType(j, eNumberVariant);
+		}
+	}
+	double		start = now();
+	for (int i = 0; i < aRows; ++i) {
+		for (int j = 0; j < aCols; ++j) {
+			table.setDoubleValue(i, j, i * 0.5 + j);
+		}
+	}
+	aFill = now() - start;
+
+	start = now();
+	aSum = 0.0;
+	for (int p = 0; p < aPasses; ++p) {
+		for (int i = 0; i < aRows; ++i) {
+			for (int j = 0; j < aCols; ++j) {
+				aSum += table.getDoubleValue(i, j);
+			}
+		}
+	}
+	aRead = (now() - start) / aPasses;
+
+	start = now();
+	for (int p = 0; p < aPasses; ++p) {
+		table.multiply(1.0001);
+		table.add(0.5);
+	}
+	aMath = (now() - start) / aPasses;
+	aSum += table.getDoubleValue(aRows - 1, aCols - 1);
+}
+
+
+int main(int argc, char *argv[]) {
+	int		rows = (argc > 1 ? atoi(argv[1]) : 100000);
+	int		cols = (argc > 2 ? atoi(argv[2]) : 10);
+	int		passes = (argc > 3 ? atoi(argv[3]) : 5);
+
+	int		problems = 0;
+	try {
+		problems = checkColumns();
+	} catch (CKException & e) {
+		problems += problem(e);
+	}
+	if (problems == 0) {
+		std::cout << "The columnar tables are OK." << std::endl;
+	}
+
+	double		fill[2];
+	double		read[2];
+	double		math[2];
+	double		sum[2];
+	for (int c = 0; c < 2; ++c) {
+		timeTable((c == 1), rows, cols, passes, fill[c], read[c], math[c], sum[c]);
+	}
+	if (sum[0] != sum[1]) {
+		std::cout << "PROBLEM! The two layouts didn't add up the same." << std::endl;
+		++problems;
+	}
+
+	double	cells = (double)rows * cols;
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << "A " << rows << "x" << cols << " table of numbers holds " <<
+		sizeof(CKVariant) << " bytes a cell in rows and " << (8 + 1.0/8) <<
+		" in columns." << std::endl;
+	for (int c = 0; c < 2; ++c) {
+		std::cout << (c == 1 ? "columns" : "rows   ") << ": fill " <<
+			(fill[c] * 1e9 / cells) << " ns/cell, read " << (read[c] * 1e9 / cells) <<
+			" ns/cell, multiply and add " << (math[c] * 1e9 / cells) <<
+			" ns/cell" << std::endl;
+	}
+	std::cout << "The columns were " << (fill[0] / fill[1]) << "x faster to fill, " <<
+		(read[0] / read[1]) << "x faster to read and " << (math[0] / math[1]) <<
+		"x faster to do the math on." << std::endl;
+
+	return finish(problems);
+}
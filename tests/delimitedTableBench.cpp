@@ -0,0 +1,524 @@
+/*
+ * This is a test program for reading and writing CKTables as delimited
+ * text. It writes tables of all kinds - numbers that have to come back
+ * exactly, dates, strings with delimiters, quotes and line breaks in them,
+ * empty cells and mixed columns - as CSV and TSV and reads them back, both
+ * from files and through a pipe that hands them over a bit at a time. It
+ * checks the reader on text written by hand, and its mistakes, with and
+ * without the AVX2 scanner. Then it times writing and reading a big table
+ * next to doing it a line and a cell at a time with setValueAsType(). Run
+ * it as:
+ *
+ *     delimitedTableBench [rows] [file]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+
+#include "CKDelimitedTable.h"
+#include "CKTable.h"
+#include "CKVectorMath.h"
+#include "CKString.h"
+#include "CKException.h"
+#include "benchUtils.h"
+
+/*
+ * These are the columns of the test tables - numbers that are hard to
+ * get exactly right, quantities, dates, strings that have to be quoted,
+ * a column that's mostly empty, and one with a mix of everything.
+ */
+#define	PRICE	0
+#define	QTY		1
+#define	WHEN	2
+#define	NOTE	3
+#define	SPARSE	4
+#define	MIXED	5
+
+/*
+ * This makes a double from random bits - any one that's not a NaN or
+ * infinity - so every kind of number gets written and read.
+ */
+static double randomDouble( unsigned int & aSeed )
+{
+	while (true) {
+		unsigned long long	bits = 0;
+		for (int k = 0; k < 4; ++k) {
+			aSeed = aSeed * 1103515245 + 12345;
+			bits = (bits << 16) | ((aSeed >> 8) & 0xffff);
+		}
+		double	v;
+		memcpy(&v, &bits, sizeof(v));
+		if (!isnan(v) && !isinf(v)) {
+			return v;
+		}
+	}
+}
+
+
+/*
+ * This makes a table of 'aRows' rows. The labels and headers have the
+ * delimiters in them, and the strings are sometimes empty, or look like
+ * numbers, or have quotes and line breaks in them.
+ */
+static CKTable makeTable( int aRows, bool aColumnar, int aSeed )
+{
+	static const double	hard[] = { 0.0, -0.0, 0.1, 1e-320, 5e-324, 1.7976931348623157e308,
+									   123456789012345678.0, 1e22, 1e23, 2.2250738585072014e-308,
+									   NAN, INFINITY, -INFINITY, 0.30000000000000004 };
+	static const char	*notes[] = { "plain", "", "12", "19990101", "a,b", "tab\there",
+									 "say \"hi\"", "two\nlines", "cr\r\nlf", " padded ",
+									 "\"", "nan", "-", "1e5x" };
+	char			buff[64];
+	CKTable			table(aRows, 6);
+	const char		*headers[] = { "price", "qty,\"n\"", "when", "note", "sparse", "mixed\t" };
+	table.setColumnar(aColumnar);
+	for (int j = 0; j < table.getNumColumns(); ++j) {
+		table.setColumnHeader(j, headers[j]);
+	}
+
+	unsigned int	r = aSeed;
+	for (int i = 0; i < aRows; ++i) {
+		r = r * 1103515245 + 12345;
+		unsigned int	v = (r >> 8);
+		snprintf(buff, sizeof(buff), ((i % 3) == 0 ? "row %d, \"x\"" : "row%d"), i);
+		table.setRowLabel(i, buff);
+		if ((v % 4) == 0) {
+			table.setDoubleValue(i, PRICE, hard[(v >> 4) % (sizeof(hard)/sizeof(hard[0]))]);
+		} else {
+			table.setDoubleValue(i, PRICE, randomDouble(r));
+		}
+		if ((v % 7) != 0) {
+			table.setDoubleValue(i, QTY, (double)((int)(v % 20001) - 10000) / ((v & 1) ? 1.0 : 100.0));
+		}
+		if ((v % 5) != 0) {
+			table.setDateValue(i, WHEN, 19900101 + 10000 * ((v >> 3) % 20) + 100 * ((v >> 7) % 12) + (v >> 11) % 28);
+		}
+		table.setStringValue(i, NOTE, notes[(v >> 5) % (sizeof(notes)/sizeof(notes[0]))]);
+		if ((v % 97) == 0) {
+			table.setDoubleValue(i, SPARSE, (double)i);
+		}
+		switch ((v >> 9) % 4) {
+			case 0:
+				table.setDoubleValue(i, MIXED, (v % 1000) / 8.0);
+				break;
+			case 1:
+				table.setDateValue(i, MIXED, 20050101 + (v % 28));
+				break;
+			case 2:
+				table.setStringValue(i, MIXED, notes[(v >> 13) % (sizeof(notes)/sizeof(notes[0]))]);
+				break;
+			default:
+				break;
+		}
+	}
+	return table;
+}
+
+
+/*
+ * This compares the tables a cell at a time - the types have to be the
+ * same, and the numbers exactly the same, with a NaN the same as a NaN.
+ */
+static int compareTables( const CKTable & aTable, const CKTable & anOther,
+						  bool withLabels, const char *aName )
+{
+	if ((aTable.getNumRows() != anOther.getNumRows()) ||
+		(aTable.getNumColumns() != anOther.getNumColumns())) {
+		std::cout << aName << ": the table is " << anOther.getNumRows() << " by " <<
+			anOther.getNumColumns() << " and not " << aTable.getNumRows() << " by " <<
+			aTable.getNumColumns() << std::endl;
+		return 1;
+	}
+	int		problems = 0;
+	for (int j = 0; j < aTable.getNumColumns(); ++j) {
+		if (aTable.getColumnHeader(j) != anOther.getColumnHeader(j)) {
+			std::cout << aName << ": column " << j << " is '" << anOther.getColumnHeader(j) <<
+				"' and not '" << aTable.getColumnHeader(j) << "'" << std::endl;
+			++problems;
+		}
+	}
+	for (int i = 0; (i < aTable.getNumRows()) && (problems < 10); ++i) {
+		if (withLabels && (aTable.getRowLabel(i) != anOther.getRowLabel(i))) {
+			std::cout << aName << ": row " << i << " is '" << anOther.getRowLabel(i) <<
+				"' and not '" << aTable.getRowLabel(i) << "'" << std::endl;
+			++problems;
+		}
+		for (int j = 0; j < aTable.getNumColumns(); ++j) {
+			CKVariantType	type = aTable.getType(i, j);
+			bool			ok = (anOther.getType(i, j) == type);
+			if (ok && (type == eNumberVariant)) {
+				double		a = aTable.getDoubleValue(i, j);
+				double		b = anOther.getDoubleValue(i, j);
+				ok = ((memcmp(&a, &b, sizeof(a)) == 0) || (isnan(a) && isnan(b)));
+			} else if (ok && (type != eUnknownVariant)) {
+				ok = (aTable.getValueAsString(i, j) == anOther.getValueAsString(i, j));
+			}
+			if (!ok) {
+				std::cout << aName << ": cell " << i << ", " << j << " is '" <<
+					anOther.getValueAsString(i, j) << "' (" << anOther.getType(i, j) <<
+					") and not '" << aTable.getValueAsString(i, j) << "' (" << type <<
+					")" << std::endl;
+				++problems;
+			}
+		}
+	}
+	return problems;
+}
+
+
+/*
+ * This reads the file through a pipe, with another process writing it
+ * a few bytes at a time, so the rows keep running off the end of what
+ * the reader has.
+ */
+static CKTable readThroughPipe( const CKString & aFile, char aDelimiter, bool withLabels,
+								int aChunk )
+{
+	int		fds[2];
+	if (pipe(fds) != 0) {
+		throw CKException(__FILE__, __LINE__, "the pipe couldn't be made");
+	}
+	pid_t	pid = fork();
+	if (pid == 0) {
+		close(fds[0]);
+		int		fd = open(aFile.c_str(), O_RDONLY);
+		char	buff[4096];
+		ssize_t	cnt;
+		while ((cnt = ::read(fd, buff, aChunk)) > 0) {
+			if (::write(fds[1], buff, cnt) != cnt) {
+				_exit(1);
+			}
+		}
+		_exit(0);
+	}
+	close(fds[1]);
+	try {
+		CKTable		retval = CKDelimitedTable::read(fds[0], aDelimiter, withLabels);
+		close(fds[0]);
+		waitpid(pid, NULL, 0);
+		return retval;
+	} catch (...) {
+		close(fds[0]);
+		waitpid(pid, NULL, 0);
+		throw;
+	}
+}
+
+
+/*
+ * This writes the text to the file and reads it back.
+ */
+static CKTable readText( const char *aText, const CKString & aFile, char aDelimiter = ',',
+						 bool withLabels = false, int aSampleSize = CKDELIMITEDTABLE_SAMPLE_SIZE )
+{
+	FILE	*fp = fopen(aFile.c_str(), "w");
+	fwrite(aText, 1, strlen(aText), fp);
+	fclose(fp);
+	return CKDelimitedTable::read(aFile, aDelimiter, withLabels, aSampleSize);
+}
+
+
+/*
+ * This makes sure reading the text throws a CKException - it returns 1
+ * if it doesn't.
+ */
+static int checkRefused( const char *aText, const CKString & aFile, const char *aName )
+{
+	try {
+		readText(aText, aFile);
+		std::cout << aName << ": the text was read" << std::endl;
+		return 1;
+	} catch (CKException & e) {
+		return 0;
+	}
+}
+
+
+/*
+ * This checks the reader on text written by hand, and returns the
+ * number of problems.
+ */
+static int checkText( const CKString & aFile )
+{
+	int			problems = 0;
+
+	// line breaks of both kinds, quotes, empty lines, and no line break at the end
+	CKTable		t = readText("a,b,c\r\n1,\"x,\"\"y\"\"\r\nz\",20050101\r\n\r\n"
+							 "2.5,pl\"ain,\n,\"\",19991231\n-3,,", aFile);
+	if ((t.getNumRows() != 4) || (t.getNumColumns() != 3) ||
+		(t.getColumnType(0) != eNumberVariant) || (t.getColumnType(2) != eDateVariant) ||
+		(t.getDoubleValue(1, 0) != 2.5) || (t.getType(2, 0) != eUnknownVariant) ||
+		(t.getDoubleValue(3, 0) != -3.0) || (t.getValueAsString(0, 1) != "x,\"y\"\r\nz") ||
+		(t.getValueAsString(1, 1) != "pl\"ain") || (t.getType(2, 1) != eStringVariant) ||
+		(t.getValueAsString(2, 1) != "") || (t.getType(1, 2) != eUnknownVariant) ||
+		(t.getDateValue(2, 2) != 19991231) || (t.getType(3, 2) != eUnknownVariant)) {
+		std::cout << "the hand-written CSV was read wrong:" << std::endl << t.toString() << std::endl;
+		++problems;
+	}
+
+	// the numbers in every form they can be in
+	const char	*numbers[] = { "0", "-0", "1.", ".5", "+3", "1e5", "1E-5", "-0.0", "00012",
+							   "1.5e+300", "123456789012345678901234567890", "4.9e-324",
+							   "2.2250738585072011e-308", "0.1e1", "1e-400", "1e400", "nan",
+							   "-inf", "Infinity", "9007199254740993", "0.000001234" };
+	std::string	text("n\n");
+	for (unsigned int k = 0; k < sizeof(numbers)/sizeof(numbers[0]); ++k) {
+		text += numbers[k];
+		text += "\n";
+	}
+	t = readText(text.c_str(), aFile);
+	for (unsigned int k = 0; k < sizeof(numbers)/sizeof(numbers[0]); ++k) {
+		double	want = strtod(numbers[k], NULL);
+		double	got = (t.getType(k, 0) == eNumberVariant ? t.getDoubleValue(k, 0) : 0.5);
+		if ((memcmp(&want, &got, sizeof(want)) != 0) && !(isnan(want) && isnan(got))) {
+			std::cout << "'" << numbers[k] << "' was read as " << std::setprecision(17) <<
+				got << std::endl;
+			++problems;
+		}
+	}
+	const char	*strings[] = { "1e", "e5", "1.2.3", "0x10", " 1", "1 ", "+", ".", "--1", "nanx" };
+	text = "s\n";
+	for (unsigned int k = 0; k < sizeof(strings)/sizeof(strings[0]); ++k) {
+		text += strings[k];
+		text += "\n";
+	}
+	t = readText(text.c_str(), aFile);
+	for (unsigned int k = 0; k < sizeof(strings)/sizeof(strings[0]); ++k) {
+		if ((t.getType(k, 0) != eStringVariant) || (t.getValueAsString(k, 0) != strings[k])) {
+			std::cout << "'" << strings[k] << "' wasn't read as a string" << std::endl;
+			++problems;
+		}
+	}
+
+	// a column of numbers that turns out to have something else after the sample
+	t = readText("label\tv\tw\nr1\t1\tx\nr2\t2\ty\nr3\tN/A\t3\nr4\t\"4\"\t4\nr5\t5\t\n", aFile,
+				 '\t', true, 2);
+	if ((t.getNumRows() != 5) || (t.getColumnHeader(0) != "v") ||
+		(t.getRowLabel(4) != "r5") || (t.getDoubleValue(0, 0) != 1.0) ||
+		(t.getValueAsString(2, 0) != "N/A") || (t.getType(3, 0) != eStringVariant) ||
+		(t.getDoubleValue(4, 0) != 5.0) || (t.getType(2, 1) != eStringVariant) ||
+		(t.getType(4, 1) != eUnknownVariant)) {
+		std::cout << "the column that changed was read wrong:" << std::endl << t.toString() << std::endl;
+		++problems;
+	}
+
+	// a table with one column keeps its empty cells, and one with no rows is fine
+	t = readText("only\n1\n\n3\n", aFile);
+	if ((t.getNumRows() != 3) || (t.getType(1, 0) != eUnknownVariant)) {
+		std::cout << "the empty cells of a single column were lost" << std::endl;
+		++problems;
+	}
+	t = readText("a,b\n\n", aFile);
+	if ((t.getNumRows() != 0) || (t.getNumColumns() != 2) || (t.getColumnHeader(1) != "b")) {
+		std::cout << "the table without rows was read wrong" << std::endl;
+		++problems;
+	}
+
+	// a single column with an empty header has to get that header back
+	CKTable		blank(2, 1);
+	blank.setStringValue(0, 0, "a");
+	blank.setDoubleValue(1, 0, 2.0);
+	CKDelimitedTable::write(blank, aFile);
+	problems += compareTables(blank, CKDelimitedTable::read(aFile), false,
+							  "the single column with an empty header");
+
+	// ...and the mistakes
+	problems += checkRefused("a,b\n1,2,3\n", aFile, "too many fields");
+	problems += checkRefused("a,b\n1,\"2\n", aFile, "an open quote");
+	problems += checkRefused("a,b\n1,\"2\"3\n", aFile, "a field after its quote");
+	problems += checkRefused("", aFile, "an empty file");
+	try {
+		CKDelimitedTable::read(aFile, '"');
+		std::cout << "a quote was used as the delimiter" << std::endl;
+		++problems;
+	} catch (CKException & e) {
+	}
+	return problems;
+}
+
+
+/*
+ * This is the way it's been done - a line at a time, each field found
+ * by hand and typed by setValueAsType() - that the reader is timed
+ * against. It only handles the quotes the big table doesn't have.
+ */
+static CKTable readTheOldWay( const CKString & aFile )
+{
+	std::ifstream		in(aFile.c_str());
+	std::string			line;
+	std::getline(in, line);
+	int					cols = 1;
+	for (unsigned int k = 0; k < line.size(); ++k) {
+		cols += (line[k] == ',' ? 1 : 0);
+	}
+	CKTable				table(1, cols);
+	size_t				start = 0;
+	for (int j = 0; j < cols; ++j) {
+		size_t	stop = line.find(',', start);
+		table.setColumnHeader(j, line.substr(start, stop - start).c_str());
+		start = stop + 1;
+	}
+	int					rows = 0;
+	while (std::getline(in, line)) {
+		int		row = (rows == 0 ? 0 : table.appendRow());
+		start = 0;
+		for (int j = 0; j < cols; ++j) {
+			size_t	stop = line.find(',', start);
+			if (stop == std::string::npos) {
+				stop = line.size();
+			}
+			std::string	field = line.substr(start, stop - start);
+			if (!field.empty()) {
+				table.setValueAsType(row, j, eUnknownVariant, field.c_str());
+			}
+			start = stop + 1;
+		}
+		++rows;
+	}
+	return table;
+}
+
+
+int main(int argc, char *argv[]) {
+	int			rows = (argc > 1 ? atoi(argv[1]) : 1000000);
+	CKString	file = (argc > 2 ? argv[2] : "/tmp/delimitedTableBench.csv");
+
+	int		problems = 0;
+	try {
+		// the small tables both ways, with each scanner
+		for (int simd = 0; simd < 2; ++simd) {
+			CKVectorMath::setUseSIMD(simd != 0);
+			problems += checkText(file);
+			int		sizes[] = { 1, 2, 31, 33, 1000, 5000 };
+			for (unsigned int s = 0; s < sizeof(sizes)/sizeof(sizes[0]); ++s) {
+				for (int mode = 0; mode < 8; ++mode) {
+					bool	columnar = ((mode & 1) != 0);
+					char	delimiter = ((mode & 2) != 0 ? '\t' : ',');
+					bool	withLabels = ((mode & 4) != 0);
+					char	name[64];
+					snprintf(name, sizeof(name), "%d rows mode %d%s", sizes[s], mode,
+							 (simd ? " simd" : ""));
+					CKTable		table = makeTable(sizes[s], columnar, s + 1);
+					CKDelimitedTable::write(table, file, delimiter, withLabels);
+					problems += compareTables(table, CKDelimitedTable::read(file, delimiter,
+									withLabels), withLabels, name);
+					if (sizes[s] == 5000) {
+						strcat(name, " piped");
+						problems += compareTables(table, readThroughPipe(file, delimiter,
+										withLabels, 7 + mode), withLabels, name);
+					}
+				}
+			}
+
+			// a field bigger than the reader's buffer
+			CKTable		big = makeTable(3, true, 9);
+			std::string	huge(3 * 1024 * 1024, 'x');
+			for (unsigned int k = 0; k < huge.size(); k += 1001) {
+				huge[k] = ((k % 3) == 0 ? '"' : ',');
+			}
+			big.setStringValue(1, NOTE, huge.c_str());
+			CKDelimitedTable::write(big, file);
+			problems += compareTables(big, CKDelimitedTable::read(file), false, "huge field");
+		}
+		CKVectorMath::setUseSIMD(true);
+		if (problems == 0) {
+			std::cout << "The delimited tables are OK." << std::endl;
+		}
+
+		/*
+		 * The big table is a blotter of trades in columnar layout. It's
+		 * written out as one big string of getValueAsString() of every
+		 * cell, and by the writer. Then it's read back a line and a cell
+		 * at a time with setValueAsType(), and by the reader, with and
+		 * without the AVX2 scanner.
+		 */
+		CKTable		trades(rows, 6);
+		const char	*headers[] = { "price", "qty", "date", "sym", "side", "account" };
+		trades.setColumnar(true);
+		trades.setColumnType(0, eNumberVariant);
+		trades.setColumnType(1, eNumberVariant);
+		trades.setColumnType(2, eDateVariant);
+		for (int j = 0; j < 6; ++j) {
+			trades.setColumnHeader(j, headers[j]);
+		}
+		unsigned int	r = 42;
+		for (int i = 0; i < rows; ++i) {
+			char	buff[64];
+			r = r * 1103515245 + 12345;
+			unsigned int	v = (r >> 8);
+			trades.setDoubleValue(i, 0, (v % 1000000) / 100.0);
+			trades.setDoubleValue(i, 1, (double)(100 * (1 + v % 50)));
+			trades.setDateValue(i, 2, 20050101 + (v % 28));
+			snprintf(buff, sizeof(buff), "SYM%u", (v >> 4) % 3000);
+			trades.setStringValue(i, 3, buff);
+			trades.setStringValue(i, 4, ((v & 1) ? "BUY" : "SELL"));
+			snprintf(buff, sizeof(buff), "ACCT-%05u-%s", (v >> 9) % 5000,
+					 ((v % 3) == 0 ? "PRIMARY" : "SECONDARY"));
+			trades.setStringValue(i, 5, buff);
+		}
+
+		double		start = now();
+		{
+			std::string	out;
+			for (int j = 0; j < 6; ++j) {
+				out += (j > 0 ? "," : "");
+				out += headers[j];
+			}
+			out += "\n";
+			for (int i = 0; i < rows; ++i) {
+				for (int j = 0; j < 6; ++j) {
+					if (j > 0) {
+						out += ",";
+					}
+					out += trades.getValueAsString(i, j).c_str();
+				}
+				out += "\n";
+			}
+			FILE	*fp = fopen(file.c_str(), "w");
+			fwrite(out.data(), 1, out.size(), fp);
+			fclose(fp);
+		}
+		double		oldWriteTime = now() - start;
+		start = now();
+		CKDelimitedTable::write(trades, file);
+		double		writeTime = now() - start;
+
+		start = now();
+		CKTable		old = readTheOldWay(file);
+		double		oldReadTime = now() - start;
+		CKVectorMath::setUseSIMD(false);
+		start = now();
+		CKTable		plain = CKDelimitedTable::read(file);
+		double		plainReadTime = now() - start;
+		CKVectorMath::setUseSIMD(true);
+		start = now();
+		CKTable		fast = CKDelimitedTable::read(file);
+		double		readTime = now() - start;
+		problems += compareTables(trades, old, false, "the old way");
+		problems += compareTables(trades, plain, false, "the plain reader");
+		problems += compareTables(trades, fast, false, "the reader");
+
+		std::cout << std::fixed << std::setprecision(1);
+		std::cout << rows << " rows:" << std::endl;
+		std::cout << "  write: " << oldWriteTime * 1000.0 << " ms a cell at a time, " <<
+			writeTime * 1000.0 << " ms streamed" << std::endl;
+		std::cout << "  read: " << oldReadTime * 1000.0 << " ms with setValueAsType(), " <<
+			plainReadTime * 1000.0 << " ms plain, " << readTime * 1000.0 << " ms with " <<
+			(CKVectorMath::useSIMD() ? "AVX2" : "no AVX2 here") << std::endl;
+		unlink(file.c_str());
+	} catch (CKException & e) {
+		problems += problem(e);
+	}
+
+	return finish(problems);
+}
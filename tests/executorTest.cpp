@@ -0,0 +1,251 @@
+/*
+ * This is a test program that exercises the CKExecutor.
+ */
+
+#include <iostream>
+#include <vector>
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "CKExecutor.h"
+#include "CKException.h"
+
+/*
+ * This task just adds up the numbers from 1 to its limit.
+ */
+class SumTask :
+	public ICKExecutorTask
+{
+	public:
+		SumTask( int aLimit ) : limit(aLimit), sum(0) { }
+		virtual void execute()
+		{
+			for (int i = 1; i <= limit; ++i) {
+				sum += i;
+			}
+		}
+
+		int		limit;
+		long	sum;
+};
+
+
+/*
+ * This task always fails.
+ */
+class BadTask :
+	public ICKExecutorTask
+{
+	public:
+		virtual void execute()
+		{
+			throw CKException(__FILE__, __LINE__, "the bad task went bad");
+		}
+};
+
+
+/*
+ * This body squares the values in its part of the array.
+ */
+class SquareBody :
+	public ICKExecutorRangeTask
+{
+	public:
+		SquareBody( long *aValues ) : values(aValues) { }
+		virtual void execute( int aBegin, int anEnd )
+		{
+			for (int i = aBegin; i < anEnd; ++i) {
+				values[i] = values[i] * values[i];
+			}
+		}
+
+		long	*values;
+};
+
+
+/*
+ * This task runs a parallel for of its own on the pool it's in.
+ */
+class NestedTask :
+	public ICKExecutorTask
+{
+	public:
+		NestedTask( CKExecutor *aPool ) : pool(aPool), ok(false) { }
+		virtual void execute()
+		{
+			long	values[1000];
+			for (int i = 0; i < 1000; ++i) {
+				values[i] = i;
+			}
+			SquareBody	body(values);
+			pool->parallelFor(0, 1000, body, 10);
+			ok = true;
+			for (int i = 0; i < 1000; ++i) {
+				if (values[i] != (long)i * i) {
+					ok = false;
+				}
+			}
+		}
+
+		CKExecutor	*pool;
+		bool		ok;
+};
+
+
+/*
+ * This task tries to shut down the pool it's running in.
+ */
+class ShutdownTask :
+	public ICKExecutorTask
+{
+	public:
+		ShutdownTask( CKExecutor *aPool ) : pool(aPool), threw(false) { }
+		virtual void execute()
+		{
+			try {
+				pool->shutdown();
+			} catch (CKException & e) {
+				threw = true;
+			}
+		}
+
+		CKExecutor	*pool;
+		bool		threw;
+};
+
+
+/*
+ * This task does nothing at all, so one of them can be submitted over
+ * and over without anyone owning it.
+ */
+class NopTask :
+	public ICKExecutorTask
+{
+	public:
+		virtual void execute() { }
+};
+
+static NopTask	sNop;
+
+
+/*
+ * This keeps submitting to the pool until it's told the pool has been
+ * shut down, holding on to all the futures it got.
+ */
+struct Submitter {
+	CKExecutor						*pool;
+	std::vector<CKExecutorFuture>	futures;
+};
+
+static void *submitUntilRefused( void *anArg )
+{
+	Submitter	*me = (Submitter *)anArg;
+	try {
+		while (true) {
+			me->futures.push_back(me->pool->submit(&sNop));
+			if ((me->futures.size() % 8) == 0) {
+				sched_yield();
+			}
+		}
+	} catch (CKException & e) {
+		// the pool was shut down
+	}
+	return NULL;
+}
+
+
+int main(int argc, char *argv[]) {
+	CKExecutor	pool(4);
+	std::cout << "pool has " << pool.getNumberOfThreads() << " threads" << std::endl;
+
+	// submit a bunch of tasks and wait for them all
+	SumTask				*tasks[20];
+	CKExecutorFuture	futures[20];
+	for (int i = 0; i < 20; ++i) {
+		tasks[i] = new SumTask(1000 * (i + 1));
+		futures[i] = pool.submit(tasks[i]);
+	}
+	bool	ok = true;
+	for (int i = 0; i < 20; ++i) {
+		futures[i].get();
+		long	n = 1000 * (i + 1);
+		if (tasks[i]->sum != n * (n + 1) / 2) {
+			std::cout << "task " << i << " got the wrong sum: " << tasks[i]->sum << std::endl;
+			ok = false;
+		}
+		delete tasks[i];
+	}
+	std::cout << "sum tasks " << (ok ? "passed" : "FAILED") << std::endl;
+
+	// make sure the failures come back to us
+	CKExecutorFuture	bad = pool.submit(new BadTask(), true);
+	bad.wait();
+	std::cout << "bad task failed: " << (bad.failed() ? "yes" : "no") << std::endl;
+	try {
+		bad.get();
+		std::cout << "bad task didn't throw from get()!" << std::endl;
+	} catch (CKException & e) {
+		std::cout << "bad task threw from get()" << std::endl;
+	}
+
+	// now a parallel for over a big array
+	long	values[10000];
+	for (int i = 0; i < 10000; ++i) {
+		values[i] = i;
+	}
+	SquareBody	body(values);
+	pool.parallelFor(0, 10000, body);
+	ok = true;
+	for (int i = 0; i < 10000; ++i) {
+		if (values[i] != (long)i * i) {
+			ok = false;
+		}
+	}
+	std::cout << "parallelFor " << (ok ? "passed" : "FAILED") << std::endl;
+
+	// ...and one from inside a task on the pool
+	NestedTask	nested(&pool);
+	pool.submit(&nested).get();
+	std::cout << "nested parallelFor " << (nested.ok ? "passed" : "FAILED") << std::endl;
+
+	// a worker can't shut down its own pool
+	ShutdownTask	self(&pool);
+	pool.submit(&self).get();
+	std::cout << "shutdown from a worker " << (self.threw ? "passed" : "FAILED") << std::endl;
+
+	// shut it down and make sure it won't take more
+	pool.shutdown();
+	try {
+		pool.submit(new BadTask(), true);
+		std::cout << "submit after shutdown didn't throw!" << std::endl;
+	} catch (CKException & e) {
+		std::cout << "submit after shutdown threw" << std::endl;
+	}
+
+	// every task the pool took before a racing shutdown() has to run
+	bool	raced = true;
+	for (int round = 0; raced && (round < 200); ++round) {
+		CKExecutor	racer(2);
+		Submitter	sub;
+		sub.pool = &racer;
+		pthread_t	tid;
+		pthread_create(&tid, NULL, submitUntilRefused, &sub);
+		for (int i = 0; i < round % 5; ++i) {
+			sched_yield();
+		}
+		racer.shutdown();
+		pthread_join(tid, NULL);
+		for (unsigned int i = 0; i < sub.futures.size(); ++i) {
+			if (!sub.futures[i].isDone()) {
+				std::cout << "task " << i << " of round " << round <<
+					" was taken but never run" << std::endl;
+				raced = false;
+				break;
+			}
+		}
+	}
+	std::cout << "submit racing shutdown " << (raced ? "passed" : "FAILED") << std::endl;
+
+	return 0;
+}
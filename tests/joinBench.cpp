@@ -0,0 +1,529 @@
+/*
+ * This is a test program for joining CKTables. It checks join() - inner
+ * and left, on one key and on two, with either table the smaller - and
+ * asOfJoin() against simple versions done with nested loops here, in
+ * both layouts, on the calling thread and split up on a pool. Then it
+ * times them on big tables next to doing it with an STL map and copying
+ * the cells. Run it as:
+ *
+ *     joinBench [rows] [threads]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "CKTable.h"
+#include "CKExecutor.h"
+#include "CKString.h"
+#include "CKException.h"
+#include "benchUtils.h"
+
+/*
+ * These are the columns of the test tables. Both have a symbol, an
+ * account and a time, and then a number and, on the right, a string.
+ */
+#define	SYM		0
+#define	ACCT	1
+#define	TIME	2
+#define	QTY		3
+#define	SECTOR	4
+
+/*
+ * This makes a table of 'aRows' rows with symbols from the first
+ * 'aSymbols' of them. The symbols are sometimes missing, and some are
+ * long and only differ at the end. The account is a number - zero is
+ * sometimes minus zero - and on the right, now and then, the string "1",
+ * which never matches the number. The time is sometimes missing or NaN.
+ */
+static CKTable makeTable( int aRows, int aSymbols, bool aRight, int aSeed )
+{
+	char			buff[64];
+	CKTable			table(aRows, (aRight ? 5 : 4));
+	const char		*headers[] = { "sym", "acct", "time", "qty", "sector" };
+	for (int j = 0; j < table.getNumColumns(); ++j) {
+		table.setColumnHeader(j, headers[j]);
+	}
+	unsigned int	r = aSeed;
+	for (int i = 0; i < aRows; ++i) {
+		r = r * 1103515245 + 12345;
+		unsigned int	v = (r >> 8);
+		snprintf(buff, sizeof(buff), "%s%d", (aRight ? "R" : "L"), i);
+		table.setRowLabel(i, buff);
+		if ((v % 29) != 0) {
+			unsigned int	s = (v >> 4) % aSymbols;
+			snprintf(buff, sizeof(buff), ((s % 4) == 0 ? "INSTRUMENT%u" : "S%u"), s);
+			table.setStringValue(i, SYM, buff);
+		}
+		int		acct = (v >> 9) % 4;
+		if (aRight && ((v % 23) == 0)) {
+			table.setStringValue(i, ACCT, "1");
+		} else if ((v % 19) != 0) {
+			table.setDoubleValue(i, ACCT, ((acct == 0) && (v & 1) ? -0.0 : (double)acct));
+		}
+		if ((v % 17) == 0) {
+			table.setDoubleValue(i, TIME, NAN);
+		} else if ((v % 13) != 0) {
+			table.setDoubleValue(i, TIME, (double)((v >> 3) % 50));
+		}
+		table.setDoubleValue(i, QTY, (double)((v >> 6) % 100));
+		if (aRight) {
+			snprintf(buff, sizeof(buff), "sector%u", (v >> 12) % 7);
+			table.setStringValue(i, SECTOR, buff);
+		}
+	}
+	return table;
+}
+
+
+/*
+ * This is the key of a cell the way a join sees it - a number (or a
+ * date), a string, or nothing at all.
+ */
+struct RefKey {
+	int				kind;
+	double			number;
+	std::string		str;
+};
+
+
+static RefKey keyOf( const CKTable & aTable, int aRow, int aCol )
+{
+	RefKey		key;
+	key.kind = 2;
+	key.number = 0.0;
+	switch (aTable.getType(aRow, aCol)) {
+		case eNumberVariant:
+			key.number = aTable.getDoubleValue(aRow, aCol);
+			key.kind = (isnan(key.number) ? 2 : 0);
+			break;
+		case eDateVariant:
+			key.number = aTable.getDateValue(aRow, aCol);
+			key.kind = 0;
+			break;
+		case eUnknownVariant:
+			break;
+		default:
+			key.str = aTable.getValueAsString(aRow, aCol).c_str();
+			key.kind = 1;
+			break;
+	}
+	return key;
+}
+
+
+static bool sameKeys( const CKTable & aLeft, int aRow, const std::vector<int> & aCols,
+					  const CKTable & aRight, int anOther, const std::vector<int> & anOtherCols )
+{
+	for (unsigned int k = 0; k < aCols.size(); ++k) {
+		RefKey	a = keyOf(aLeft, aRow, aCols[k]);
+		RefKey	b = keyOf(aRight, anOther, anOtherCols[k]);
+		if ((a.kind == 2) || (a.kind != b.kind) ||
+			((a.kind == 0) && (a.number != b.number)) ||
+			((a.kind == 1) && (a.str != b.str))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+/*
+ * This makes the table a join should give from the pairs of rows - the
+ * row of the left table, and of the right or -1 - with all the left
+ * columns, and the right ones that aren't keys.
+ */
+static CKTable expectedTable( const CKTable & aLeft, const CKTable & aRight,
+							  const std::vector<int> & aRows,
+							  const std::vector<int> & anOtherRows,
+							  const std::vector<int> & aKeys )
+{
+	std::vector<int>	keep;
+	for (int j = 0; j < aRight.getNumColumns(); ++j) {
+		if (std::find(aKeys.begin(), aKeys.end(), j) == aKeys.end()) {
+			keep.push_back(j);
+		}
+	}
+	int			lcols = aLeft.getNumColumns();
+	CKTable		table((aRows.empty() ? 1 : aRows.size()), lcols + keep.size());
+	for (int j = 0; j < table.getNumColumns(); ++j) {
+		table.setColumnHeader(j, (j < lcols ? aLeft.getColumnHeader(j) :
+										aRight.getColumnHeader(keep[j - lcols])));
+	}
+	for (unsigned int i = 0; i < aRows.size(); ++i) {
+		table.setRowLabel(i, aLeft.getRowLabel(aRows[i]));
+		for (int j = 0; j < lcols; ++j) {
+			if (aLeft.getType(aRows[i], j) != eUnknownVariant) {
+				table.setValue(i, j, aLeft.getValue(aRows[i], j));
+			}
+		}
+		for (unsigned int k = 0; (anOtherRows[i] >= 0) && (k < keep.size()); ++k) {
+			if (aRight.getType(anOtherRows[i], keep[k]) != eUnknownVariant) {
+				table.setValue(i, lcols + k, aRight.getValue(anOtherRows[i], keep[k]));
+			}
+		}
+	}
+	return table;
+}
+
+
+/*
+ * This checks a join against the one done with nested loops, and
+ * returns the number of problems.
+ */
+static int checkJoin( const CKTable & aLeft, const CKTable & aRight,
+					  const std::vector<int> & aCols, CKTableJoinType aType,
+					  const char *aName )
+{
+	std::vector<int>	rows;
+	std::vector<int>	otherRows;
+	for (int i = 0; i < aLeft.getNumRows(); ++i) {
+		int		found = 0;
+		for (int j = 0; j < aRight.getNumRows(); ++j) {
+			if (sameKeys(aLeft, i, aCols, aRight, j, aCols)) {
+				rows.push_back(i);
+				otherRows.push_back(j);
+				++found;
+			}
+		}
+		if ((found == 0) && (aType == eLeftJoin)) {
+			rows.push_back(i);
+			otherRows.push_back(-1);
+		}
+	}
+
+	CKVector<int>	cols;
+	for (unsigned int k = 0; k < aCols.size(); ++k) {
+		cols.addToEnd(aCols[k]);
+	}
+	CKTable		joined = aLeft.join(aRight, cols, cols, aType);
+	if (rows.empty() ? (joined.getNumRows() != 0) :
+			!sameTable(joined, expectedTable(aLeft, aRight, rows, otherRows, aCols))) {
+		std::cout << "PROBLEM! The " << (aType == eLeftJoin ? "left" : "inner") <<
+			" join of the " << aName << " tables on " << aCols.size() <<
+			" keys didn't match - " << joined.getNumRows() << " rows and not " <<
+			rows.size() << "." << std::endl;
+		return 1;
+	}
+	// the labels are the left's, and the left's headers win
+	if (!rows.empty() &&
+		((joined.getRowLabel(joined.getRowForLabel(joined.getRowLabel(0))) !=
+			joined.getRowLabel(0)) ||
+		 (joined.getColumnForHeader("time") != TIME))) {
+		std::cout << "PROBLEM! The " << aName << " join's indexes were wrong." << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+
+/*
+ * This checks an as-of join against the one done with nested loops,
+ * and returns the number of problems.
+ */
+static int checkAsOf( const CKTable & aLeft, const CKTable & aRight,
+					  const std::vector<int> & aCols, const char *aName )
+{
+	std::vector<int>	rows;
+	std::vector<int>	otherRows;
+	for (int i = 0; i < aLeft.getNumRows(); ++i) {
+		RefKey	t = keyOf(aLeft, i, TIME);
+		int		best = -1;
+		double	bestTime = 0.0;
+		for (int j = 0; (t.kind == 0) && (j < aRight.getNumRows()); ++j) {
+			RefKey	rt = keyOf(aRight, j, TIME);
+			if ((rt.kind == 0) && (rt.number <= t.number) &&
+				sameKeys(aLeft, i, aCols, aRight, j, aCols) &&
+				((best < 0) || (rt.number >= bestTime))) {
+				best = j;
+				bestTime = rt.number;
+			}
+		}
+		rows.push_back(i);
+		otherRows.push_back(best);
+	}
+
+	CKVector<int>	cols;
+	for (unsigned int k = 0; k < aCols.size(); ++k) {
+		cols.addToEnd(aCols[k]);
+	}
+	CKTable		joined = (aCols.empty() ? aLeft.asOfJoin(aRight, TIME, TIME) :
+								aLeft.asOfJoin(aRight, cols, cols, TIME, TIME));
+	if (rows.empty() ? (joined.getNumRows() != 0) :
+			!sameTable(joined, expectedTable(aLeft, aRight, rows, otherRows, aCols))) {
+		std::cout << "PROBLEM! The as-of join of the " << aName << " tables on " <<
+			aCols.size() << " keys didn't match." << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+
+/*
+ * This runs all the checks on a pair of tables.
+ */
+static int checkAll( const CKTable & aLeft, const CKTable & aRight, const char *aName )
+{
+	int					problems = 0;
+	std::vector<int>	one(1, SYM);
+	std::vector<int>	acct(1, ACCT);
+	std::vector<int>	two;
+	two.push_back(SYM);
+	two.push_back(ACCT);
+	for (int type = 0; type < 2; ++type) {
+		CKTableJoinType		t = (type == 0 ? eInnerJoin : eLeftJoin);
+		problems += checkJoin(aLeft, aRight, one, t, aName);
+		problems += checkJoin(aLeft, aRight, acct, t, aName);
+		problems += checkJoin(aLeft, aRight, two, t, aName);
+	}
+	problems += checkAsOf(aLeft, aRight, std::vector<int>(), aName);
+	problems += checkAsOf(aLeft, aRight, one, aName);
+	problems += checkAsOf(aLeft, aRight, two, aName);
+	return problems;
+}
+
+
+/*
+ * This checks the mistakes are caught, and returns the number of
+ * problems.
+ */
+static int checkErrors( const CKTable & aLeft, const CKTable & aRight )
+{
+	int				problems = 0;
+	CKVector<int>	none;
+	CKVector<int>	one;
+	CKVector<int>	two;
+	one.addToEnd(SYM);
+	two.addToEnd(SYM);
+	two.addToEnd(ACCT);
+	for (int test = 0; test < 5; ++test) {
+		try {
+			switch (test) {
+				case 0:	aLeft.join(aRight, none, none);						break;
+				case 1:	aLeft.join(aRight, one, two);						break;
+				case 2:	aLeft.join(aRight, SYM, 9);							break;
+				case 3:	aLeft.join(aRight, CKString("nothing"));			break;
+				case 4:	aLeft.asOfJoin(aRight, TIME, -1);					break;
+			}
+			std::cout << "PROBLEM! Bad join " << test << " wasn't caught." << std::endl;
+			++problems;
+		} catch (CKException & e) {
+			// this is what we want
+		}
+	}
+	return problems;
+}
+
+
+int main(int argc, char *argv[]) {
+	int		rows = (argc > 1 ? atoi(argv[1]) : 1000000);
+	int		threads = (argc > 2 ? atoi(argv[2]) : CKExecutor::getNumberOfProcessors());
+	if (threads < 2) {
+		threads = 2;
+	}
+
+	int		problems = 0;
+	try {
+		CKExecutor	pool(threads);
+
+		// the small tables in each layout, on the calling thread and split up
+		int		sizes[][2] = { { 1, 1 }, { 2, 7 }, { 65, 3 }, { 64, 300 },
+							   { 300, 64 }, { 700, 500 } };
+		for (unsigned int s = 0; s < sizeof(sizes)/sizeof(sizes[0]); ++s) {
+			CKTable		left = makeTable(sizes[s][0], 20, false, s + 1);
+			CKTable		right = makeTable(sizes[s][1], 20, true, s + 101);
+			for (int layout = 0; layout < 4; ++layout) {
+				CKTable		l = left;
+				CKTable		r = right;
+				l.setColumnar((layout & 1) != 0);
+				r.setColumnar((layout & 2) != 0);
+				for (int split = 0; split < 2; ++split) {
+					CKTable::setParallelExecutor(split ? &pool : NULL);
+					CKTable::setParallelThreshold(split ? 1 : 0);
+					char	name[64];
+					snprintf(name, sizeof(name), "%dx%d layout %d%s", sizes[s][0],
+							 sizes[s][1], layout, (split ? " split" : ""));
+					problems += checkAll(l, r, name);
+				}
+			}
+		}
+		// ...a table without any rows, and the mistakes
+		CKTable		left = makeTable(50, 20, false, 7);
+		CKTable		right = makeTable(50, 20, true, 8);
+		CKTable		empty = right;
+		empty.filter(QTY, eLessThanTest, -1.0);
+		problems += checkAll(left, empty, "empty right");
+		problems += checkAll(empty, left, "empty left");
+		problems += checkErrors(left, right);
+		CKTable::setParallelExecutor(NULL);
+		CKTable::setParallelThreshold(0);
+		if (problems == 0) {
+			std::cout << "The joins are OK." << std::endl;
+		}
+
+		/*
+		 * The big tables are a blotter of trades in columnar layout and a
+		 * table of reference data for each symbol - and the quotes, for the
+		 * as-of join. They're joined with an STL map - copying every cell
+		 * out and into a new table - and then with join(), on the calling
+		 * thread and split up on the pool.
+		 */
+		int			symbols = (rows >= 20 ? rows / 20 : 1);
+		int			quoteCnt = (rows >= 4 ? rows / 4 : 1);
+		CKTable		trades = makeTable(rows, symbols, false, 1);
+		CKTable		refs(symbols, 3);
+		refs.setColumnHeader(0, "sym");
+		refs.setColumnHeader(1, "beta");
+		refs.setColumnHeader(2, "sector");
+		for (int s = 0; s < symbols; ++s) {
+			char	buff[64];
+			snprintf(buff, sizeof(buff), ((s % 4) == 0 ? "INSTRUMENT%u" : "S%u"), s);
+			refs.setStringValue(s, 0, buff);
+			refs.setDoubleValue(s, 1, 0.5 + (s % 10) * 0.1);
+			snprintf(buff, sizeof(buff), "sector%u", s % 7);
+			refs.setStringValue(s, 2, buff);
+		}
+		CKTable		quotes = makeTable(quoteCnt, symbols, true, 2);
+		trades.setColumnar(true);
+		refs.setColumnar(true);
+		quotes.setColumnar(true);
+		double		times[3][3];
+
+		double		start = now();
+		{
+			// look up each trade's symbol in a map of the reference rows
+			std::map<std::string, int>	index;
+			for (int s = 0; s < refs.getNumRows(); ++s) {
+				index[refs.getStringValue(s, 0)->c_str()] = s;
+			}
+			std::vector<int>	rowsOut;
+			std::vector<int>	refsOut;
+			for (int i = 0; i < rows; ++i) {
+				if (trades.getType(i, SYM) == eStringVariant) {
+					std::map<std::string, int>::iterator	it =
+							index.find(trades.getStringValue(i, SYM)->c_str());
+					if (it != index.end()) {
+						rowsOut.push_back(i);
+						refsOut.push_back(it->second);
+					}
+				}
+			}
+			CKTable		out(rowsOut.size(), 6);
+			for (unsigned int i = 0; i < rowsOut.size(); ++i) {
+				out.setRowLabel(i, trades.getRowLabel(rowsOut[i]));
+				for (int j = 0; j < 4; ++j) {
+					out.setValue(i, j, trades.getValue(rowsOut[i], j));
+				}
+				for (int j = 1; j < 3; ++j) {
+					out.setValue(i, 3 + j, refs.getValue(refsOut[i], j));
+				}
+			}
+		}
+		times[0][0] = now() - start;
+		start = now();
+		{
+			// a map of the quotes for each symbol and account
+			std::map<std::pair<std::string, double>, std::vector<int> >	index;
+			for (int q = 0; q < quoteCnt; ++q) {
+				if ((quotes.getType(q, SYM) == eStringVariant) &&
+					(quotes.getType(q, ACCT) == eNumberVariant)) {
+					double	acct = quotes.getDoubleValue(q, ACCT);
+					index[std::make_pair(std::string(quotes.getStringValue(q, SYM)->c_str()),
+										 (acct == 0.0 ? 0.0 : acct))].push_back(q);
+				}
+			}
+			std::vector<int>	rowsOut;
+			std::vector<int>	quotesOut;
+			for (int i = 0; i < rows; ++i) {
+				const std::vector<int>	*found = NULL;
+				if ((trades.getType(i, SYM) == eStringVariant) &&
+					(trades.getType(i, ACCT) == eNumberVariant)) {
+					double	acct = trades.getDoubleValue(i, ACCT);
+					std::map<std::pair<std::string, double>, std::vector<int> >::iterator	it =
+						index.find(std::make_pair(std::string(trades.getStringValue(i, SYM)->c_str()),
+												  (acct == 0.0 ? 0.0 : acct)));
+					if (it != index.end()) {
+						found = &it->second;
+					}
+				}
+				if (found == NULL) {
+					rowsOut.push_back(i);
+					quotesOut.push_back(-1);
+				} else {
+					for (unsigned int k = 0; k < found->size(); ++k) {
+						rowsOut.push_back(i);
+						quotesOut.push_back((*found)[k]);
+					}
+				}
+			}
+			CKTable		out(rowsOut.size(), 7);
+			for (unsigned int i = 0; i < rowsOut.size(); ++i) {
+				out.setRowLabel(i, trades.getRowLabel(rowsOut[i]));
+				for (int j = 0; j < 4; ++j) {
+					out.setValue(i, j, trades.getValue(rowsOut[i], j));
+				}
+				for (int j = 2; (quotesOut[i] >= 0) && (j < 5); ++j) {
+					if (quotes.getType(quotesOut[i], j) != eUnknownVariant) {
+						out.setValue(i, 2 + j, quotes.getValue(quotesOut[i], j));
+					}
+				}
+			}
+		}
+		times[1][0] = now() - start;
+		times[2][0] = 0.0;
+
+		CKVector<int>	keys;
+		keys.addToEnd(SYM);
+		keys.addToEnd(ACCT);
+		int		sizesOut[3] = { 0, 0, 0 };
+		for (int run = 1; run < 3; ++run) {
+			CKTable::setParallelExecutor(run == 2 ? &pool : NULL);
+			CKTable::setParallelThreshold(run == 2 ? 1 : 0);
+
+			start = now();
+			CKTable		joined = trades.join(refs, SYM, 0);
+			times[0][run] = now() - start;
+			sizesOut[0] = joined.getNumRows();
+
+			start = now();
+			CKTable		left = trades.join(quotes, keys, keys, eLeftJoin);
+			times[1][run] = now() - start;
+			sizesOut[1] = left.getNumRows();
+
+			start = now();
+			CKTable		asOf = trades.asOfJoin(quotes, keys, keys, TIME, TIME);
+			times[2][run] = now() - start;
+			sizesOut[2] = asOf.getNumRows();
+		}
+		CKTable::setParallelExecutor(NULL);
+
+		const char	*names[] = { "inner 1-key", "left 2-key", "as-of 2-key" };
+		std::cout << "Joining " << rows << " trades with " << symbols << " symbols "
+			"and " << quoteCnt << " quotes (ms):" << std::endl;
+		std::cout << std::setw(14) << "" << std::setw(12) << "STL map" <<
+			std::setw(12) << "serial" << std::setw(12) << threads << " threads" <<
+			std::setw(12) << "rows" << std::endl;
+		std::cout << std::fixed << std::setprecision(1);
+		for (int op = 0; op < 3; ++op) {
+			std::cout << std::setw(14) << names[op];
+			for (int run = 0; run < 3; ++run) {
+				if ((op == 2) && (run == 0)) {
+					std::cout << std::setw(12) << "-";
+				} else {
+					std::cout << std::setw(12) << (times[op][run] * 1000.0);
+				}
+			}
+			std::cout << std::setw(20) << sizesOut[op] << std::endl;
+		}
+	} catch (CKException & e) {
+		problems += problem(e);
+	}
+
+	return finish(problems, "All the joins match.");
+}
@@ -0,0 +1,248 @@
+/*
+ * This is a test program for the hash index of the row labels and column
+ * headers of a CKTable. It checks that CKLabelIndex gives just what a
+ * std::map would for the same puts - replaced values, empty keys, keys
+ * that differ only in length - and that a table finds its labels after
+ * all the ways they can be set. It then times looking up every cell by
+ * label with a std::map, with the table's index, and with handles that
+ * were looked up once. Run it as:
+ *
+ *     labelIndexBench [rows] [cols] [passes]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "CKLabelIndex.h"
+#include "CKTable.h"
+#include "CKString.h"
+#include "CKException.h"
+#include "benchUtils.h"
+
+/*
+ * This puts the same keys in an index and a std::map, replacing some
+ * and growing it many times over, and returns the number of lookups
+ * where they don't agree. The map is of STL strings as CKString's
+ * operator<() has the empty string equal to all the others.
+ */
+static int checkIndex()
+{
+	int							problems = 0;
+	CKLabelIndex				index;
+	std::map<std::string, int>	map;
+	char						buff[64];
+
+	// the empty key, and ones that are prefixes of each other
+	const char	*odd[] = { "", "a", "aa", "aaa", "A", "a a", "\t" };
+	for (unsigned int i = 0; i < sizeof(odd)/sizeof(char *); ++i) {
+		index.put(odd[i], i);
+		map[odd[i]] = i;
+	}
+	for (int i = 0; i < 50000; ++i) {
+		snprintf(buff, sizeof(buff), "key-%d", (i * 7919) % 20000);
+		index.put(buff, i);
+		map[buff] = i;
+	}
+	if (index.size() != (int)map.size()) {
+		std::cout << "PROBLEM! The index has " << index.size() << " keys and "
+			"the map has " << map.size() << "." << std::endl;
+		++problems;
+	}
+	for (std::map<std::string, int>::iterator i = map.begin(); i != map.end(); ++i) {
+		if (index.get(i->first.data(), i->first.size()) != i->second) {
+			std::cout << "PROBLEM! The key '" << i->first << "' is " <<
+				index.get(i->first) << " in the index and " << i->second <<
+				" in the map." << std::endl;
+			++problems;
+		}
+	}
+	// ...and the ones that aren't there at all
+	for (int i = 20000; i < 21000; ++i) {
+		snprintf(buff, sizeof(buff), "key-%d", i);
+		if (index.get(buff) != -1) {
+			std::cout << "PROBLEM! The key '" << buff << "' was found." << std::endl;
+			++problems;
+		}
+	}
+
+	// a copy has to stand on its own
+	CKLabelIndex	copy(index);
+	index.clear();
+	if ((index.get("a") != -1) || (copy.get("a") != 1) || (copy.size() != (int)map.size())) {
+		std::cout << "PROBLEM! The copy of the index isn't right." << std::endl;
+		++problems;
+	}
+	return problems;
+}
+
+
+/*
+ * This checks that a table finds its labels and headers after they've
+ * been set, changed, resized, merged and coded.
+ */
+static int checkTable()
+{
+	int			problems = 0;
+	CKTable		table(3, 2);
+	table.setColumnHeader(0, "px");
+	table.setColumnHeader(1, "qty");
+	table.setRowLabel(0, "IBM");
+	table.setRowLabel(1, "MSFT");
+	table.setRowLabel(2, "GE");
+	table.setDoubleValue("MSFT", "qty", 12.5);
+	if ((table.getDoubleValue(1, 1) != 12.5) || (table.getRowForLabel("GE") != 2) ||
+		(table.getColumnForHeader(CKString("px")) != 0) ||
+		(table.getRowForLabel("AAPL") != -1)) {
+		std::cout << "PROBLEM! The table didn't find its labels." << std::endl;
+		++problems;
+	}
+
+	// resizing keeps the ones that are still there
+	table.resizeTable(2, 3);
+	table.setColumnHeader(2, "side");
+	if ((table.getRowForLabel("MSFT") != 1) || (table.getRowForLabel("GE") != -1) ||
+		(table.getColumnForHeader("side") != 2)) {
+		std::cout << "PROBLEM! The resized table didn't find its labels." << std::endl;
+		++problems;
+	}
+
+	// merging adds the new ones on the end
+	CKTable		other(2, 1);
+	other.setColumnHeader(0, "qty");
+	other.setRowLabel(0, "MSFT");
+	other.setRowLabel(1, "ORCL");
+	other.setDoubleValue(1, 0, 3.0);
+	table.merge(other);
+	if ((table.getRowForLabel("ORCL") != 2) || (table.getDoubleValue("ORCL", "qty") != 3.0)) {
+		std::cout << "PROBLEM! The merged table didn't find its labels." << std::endl;
+		++problems;
+	}
+
+	// the coded one has to have them all too
+	CKTable		coded;
+	coded.takeValuesFromCode(table.generateCodeFromValues());
+	CKStringList	labels;
+	labels.addToEnd("ORCL");
+	labels.addToEnd("nope");
+	labels.addToEnd("IBM");
+	CKVector<int>	rows = coded.getRowsForLabels(labels);
+	if ((rows.size() != 3) || (rows[0] != 2) || (rows[1] != -1) || (rows[2] != 0) ||
+		(coded.getColumnForHeader("side") != 2)) {
+		std::cout << "PROBLEM! The coded table didn't find its labels." << std::endl;
+		++problems;
+	}
+	return problems;
+}
+
+
+int main(int argc, char *argv[]) {
+	int		rows = (argc > 1 ? atoi(argv[1]) : 20000);
+	int		cols = (argc > 2 ? atoi(argv[2]) : 20);
+	int		passes = (argc > 3 ? atoi(argv[3]) : 5);
+
+	int		problems = 0;
+	try {
+		problems += checkIndex();
+		problems += checkTable();
+	} catch (CKException & e) {
+		problems += problem(e);
+	}
+	if (problems == 0) {
+		std::cout << "The index and the table's labels are OK." << std::endl;
+	}
+
+	// make a table with labels that look like the ones we really use
+	char			buff[64];
+	CKTable			table(rows, cols);
+	CKStringList	labels;
+	CKStringList	headers;
+	std::map<CKString, int>		rowMap;
+	std::map<CKString, int>		colMap;
+	for (int j = 0; j < cols; ++j) {
+		snprintf(buff, sizeof(buff), "FIELD_%d", j);
+		table.setColumnHeader(j, buff);
+		headers.addToEnd(buff);
+		colMap[buff] = j;
+	}
+	for (int i = 0; i < rows; ++i) {
+		snprintf(buff, sizeof(buff), "US%07d Equity", i * 37);
+		table.setRowLabel(i, buff);
+		labels.addToEnd(buff);
+		rowMap[buff] = i;
+		for (int j = 0; j < cols; ++j) {
+			table.setDoubleValue(i, j, i + j * 0.5);
+		}
+	}
+	CKString	*rowLabels = new CKString[rows];
+	CKString	*colHeaders = new CKString[cols];
+	for (int i = 0; i < rows; ++i) {
+		rowLabels[i] = table.getRowLabel(i);
+	}
+	for (int j = 0; j < cols; ++j) {
+		colHeaders[j] = table.getColumnHeader(j);
+	}
+
+	/*
+	 * Each pass sums every cell by label - the row label and the column
+	 * header each looked up - first with a std::map like the table used
+	 * to have, then with the table's own index, and then with handles
+	 * resolved once for the batch.
+	 */
+	double	sums[3] = { 0.0, 0.0, 0.0 };
+	double	times[3];
+	double	start = now();
+	for (int p = 0; p < passes; ++p) {
+		for (int i = 0; i < rows; ++i) {
+			for (int j = 0; j < cols; ++j) {
+				sums[0] += table.getDoubleValue(rowMap.find(rowLabels[i])->second,
+												colMap.find(colHeaders[j])->second);
+			}
+		}
+	}
+	times[0] = now() - start;
+
+	start = now();
+	for (int p = 0; p < passes; ++p) {
+		for (int i = 0; i < rows; ++i) {
+			for (int j = 0; j < cols; ++j) {
+				sums[1] += table.getDoubleValue(rowLabels[i], colHeaders[j]);
+			}
+		}
+	}
+	times[1] = now() - start;
+
+	start = now();
+	for (int p = 0; p < passes; ++p) {
+		CKVector<int>	rowHandles = table.getRowsForLabels(labels);
+		CKVector<int>	colHandles = table.getColumnsForHeaders(headers);
+		for (int i = 0; i < rows; ++i) {
+			for (int j = 0; j < cols; ++j) {
+				sums[2] += table.getDoubleValue(rowHandles[i], colHandles[j]);
+			}
+		}
+	}
+	times[2] = now() - start;
+
+	if ((sums[0] != sums[1]) || (sums[0] != sums[2])) {
+		std::cout << "PROBLEM! The sums were " << sums[0] << ", " << sums[1] <<
+			" and " << sums[2] << "." << std::endl;
+		++problems;
+	}
+
+	double	lookups = (double)rows * cols * passes;
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << "Getting each of " << rows << "x" << cols << " cells by label:" << std::endl;
+	std::cout << "  std::map:     " << (times[0] * 1e9 / lookups) << " ns/cell" << std::endl;
+	std::cout << "  hash index:   " << (times[1] * 1e9 / lookups) << " ns/cell" << std::endl;
+	std::cout << "  handles:      " << (times[2] * 1e9 / lookups) << " ns/cell" << std::endl;
+	std::cout << "The hash index was " << (times[0] / times[1]) << "x faster than "
+		"the map, and the handles " << (times[0] / times[2]) << "x." << std::endl;
+
+	delete [] rowLabels;
+	delete [] colHeaders;
+	return finish(problems);
+}
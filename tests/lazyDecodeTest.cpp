@@ -0,0 +1,220 @@
+/*
+ * This is a test program for the lazy decoding of the nested values in
+ * a CKVariant. It loads a lot of tables from their text and binary
+ * codes with and without lazy decoding, and then touches just a few of
+ * them, showing the times of each. It also checks that the values that
+ * are decoded lazily are the same as the ones that aren't, that copies
+ * and codes of a lazy value don't decode it, and that a lot of threads
+ * asking for the same lazy value all get the same one. Run it as:
+ *
+ *     lazyDecodeTest [tables] [touch every]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "CKVariant.h"
+#include "CKTable.h"
+#include "CKPrice.h"
+#include "CKString.h"
+#include "CKException.h"
+#include "benchUtils.h"
+
+/*
+ * This makes a small table with a mix of values in it.
+ */
+static CKTable makeTable( int aSeed )
+{
+	char		buff[64];
+	CKTable		table(8, 4);
+	for (int i = 0; i < 8; ++i) {
+		for (int j = 0; j < 4; ++j) {
+			switch ((i + j + aSeed) % 3) {
+				case 0:
+					snprintf(buff, sizeof(buff), "SYM%d", aSeed + i);
+					table.setStringValue(i, j, buff);
+					break;
+				case 1:
+					table.setDoubleValue(i, j, aSeed * 0.5 + i * j);
+					break;
+				case 2:
+					{
+						CKPrice		p(aSeed * 0.25, j * 1.5);
+						table.setPriceValue(i, j, &p);
+					}
+					break;
+			}
+		}
+	}
+	return table;
+}
+
+
+/*
+ * These are the threads that all ask for the same lazy table at once.
+ */
+static CKVariant		*sShared = NULL;
+static const CKTable	*sSeen[16];
+
+static void *grabTable( void *anArg )
+{
+	long	me = (long)anArg;
+	sSeen[me] = sShared->getTableValue();
+	return NULL;
+}
+
+
+/*
+ * This checks the copies, codes and threads, and returns the number of
+ * problems.
+ */
+static int checkLazy()
+{
+	int		problems = 0;
+	CKTable	table = makeTable(7);
+	CKString	text = CKVariant(&table).generateCodeFromValues();
+	std::string	bin = CKVariant(&table).toBinary();
+
+	CKVariant::setLazyDecoding(true);
+
+	// a lazy value isn't decoded by copying it or writing its code
+	CKVariant	lazy;
+	lazy.takeValuesFromCode(text);
+	CKVariant	copy(lazy);
+	if (lazy.isDecoded() || copy.isDecoded()) {
+		std::cout << "PROBLEM! The lazy table was decoded too soon." << std::endl;
+		++problems;
+	}
+	if (lazy.generateCodeFromValues() != text) {
+		std::cout << "PROBLEM! The code of the lazy table isn't the one it came from." << std::endl;
+		++problems;
+	}
+	if (lazy.isDecoded()) {
+		std::cout << "PROBLEM! Writing the code of the lazy table decoded it." << std::endl;
+		++problems;
+	}
+	// ...but it is when it's used, and it's the same as the original
+	if ((*lazy.getTableValue() != table) || !lazy.isDecoded()) {
+		std::cout << "PROBLEM! The lazy table didn't decode to the original." << std::endl;
+		++problems;
+	}
+	if (copy != lazy) {
+		std::cout << "PROBLEM! The copy of the lazy table isn't the same." << std::endl;
+		++problems;
+	}
+
+	// the same goes for the binary codes
+	CKVariant	lazyBin;
+	lazyBin.fromBinary(bin);
+	if (lazyBin.isDecoded() || (lazyBin.toBinary() != bin) || lazyBin.isDecoded()) {
+		std::cout << "PROBLEM! The binary lazy table was decoded too soon." << std::endl;
+		++problems;
+	}
+	if (lazyBin != CKVariant(&table)) {
+		std::cout << "PROBLEM! The binary lazy table didn't decode to the original." << std::endl;
+		++problems;
+	}
+
+	// a lot of threads all asking for it at once get the same one
+	for (int pass = 0; pass < 50; ++pass) {
+		CKVariant	shared;
+		shared.takeValuesFromCode(text);
+		sShared = &shared;
+		pthread_t	tids[16];
+		for (long t = 0; t < 16; ++t) {
+			pthread_create(&tids[t], NULL, grabTable, (void *)t);
+		}
+		for (int t = 0; t < 16; ++t) {
+			pthread_join(tids[t], NULL);
+		}
+		for (int t = 1; t < 16; ++t) {
+			if ((sSeen[t] == NULL) || (sSeen[t] != sSeen[0])) {
+				std::cout << "PROBLEM! The threads got different tables." << std::endl;
+				++problems;
+				pass = 50;
+				break;
+			}
+		}
+	}
+
+	CKVariant::setLazyDecoding(false);
+	return problems;
+}
+
+
+/*
+ * This loads each of the variants from its code - like a loader does
+ * for the cells of a tree - and then touches every so many of them,
+ * returning the time it all took.
+ */
+static double loadAndTouch( const std::vector<CKString> & aTexts,
+							const std::vector<std::string> & aBins,
+							bool aBinary, int aTouchEvery, double & aChecksum )
+{
+	double					start = now();
+	int						cnt = aTexts.size();
+	std::vector<CKVariant>	vars(cnt);
+	for (int i = 0; i < cnt; ++i) {
+		if (aBinary) {
+			vars[i].fromBinary(aBins[i]);
+		} else {
+			vars[i].takeValuesFromCode(aTexts[i]);
+		}
+	}
+	for (int i = 0; i < cnt; i += aTouchEvery) {
+		aChecksum += vars[i].getTableValue()->getValueAsString(0, 1).size();
+	}
+	return (now() - start);
+}
+
+
+int main(int argc, char *argv[]) {
+	int		tables = (argc > 1 ? atoi(argv[1]) : 20000);
+	int		touchEvery = (argc > 2 ? atoi(argv[2]) : 100);
+
+	int		problems = 0;
+	try {
+		problems = checkLazy();
+	} catch (CKException & e) {
+		problems += problem(e);
+	}
+	if (problems == 0) {
+		std::cout << "The lazy values are OK." << std::endl;
+	}
+
+	// make the codes of a lot of tables
+	std::vector<CKString>		texts;
+	std::vector<std::string>	bins;
+	for (int i = 0; i < tables; ++i) {
+		CKTable		t = makeTable(i);
+		CKVariant	v(&t);
+		texts.push_back(v.generateCodeFromValues());
+		bins.push_back(v.toBinary());
+	}
+
+	std::cout << std::fixed << std::setprecision(3);
+	for (int b = 0; b < 2; ++b) {
+		double		eagerSum = 0.0;
+		double		lazySum = 0.0;
+		CKVariant::setLazyDecoding(false);
+		double		eager = loadAndTouch(texts, bins, (b == 1), touchEvery, eagerSum);
+		CKVariant::setLazyDecoding(true);
+		double		lazy = loadAndTouch(texts, bins, (b == 1), touchEvery, lazySum);
+		CKVariant::setLazyDecoding(false);
+		if (eagerSum != lazySum) {
+			std::cout << "PROBLEM! The lazy tables don't add up to the eager ones." << std::endl;
+			++problems;
+		}
+		std::cout << (b == 1 ? "binary" : "text  ") << ": loading " << tables <<
+			" tables and touching every " << touchEvery << "th took " << eager <<
+			" sec eagerly and " << lazy << " sec lazily (" << std::setprecision(1) <<
+			(eager / lazy) << "x)" << std::setprecision(3) << std::endl;
+	}
+
+	return finish(problems);
+}
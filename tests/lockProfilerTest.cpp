@@ -0,0 +1,133 @@
+/*
+ * This is a test program that exercises the CKLockProfiler - both
+ * by recording sites directly and through the CKStackLocker.
+ */
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <pthread.h>
+
+#include "CKLockProfiler.h"
+#include "CKStackLocker.h"
+#include "CKFWMutex.h"
+#include "CKString.h"
+
+/*
+ * This is one line of the report, pulled apart.
+ */
+struct ReportLine {
+	bool				found;
+	int					rank;
+	unsigned long		locks;
+	unsigned long		contended;
+	unsigned long long	wait;
+	unsigned long long	maxWait;
+	unsigned long long	hold;
+};
+
+
+/*
+ * This finds the line of the report for the site, if it's there, and
+ * where it is in the order.
+ */
+static ReportLine findSite( const CKString & aReport, const std::string & aSite )
+{
+	ReportLine			retval = { false, -1, 0, 0, 0, 0, 0 };
+	std::istringstream	in(aReport.c_str());
+	std::string			line;
+	// skip the header
+	std::getline(in, line);
+	for (int rank = 0; std::getline(in, line); ++rank) {
+		std::string::size_type	at = line.rfind("  ");
+		if ((at != std::string::npos) && (line.substr(at + 2) == aSite)) {
+			std::istringstream	nums(line.substr(0, at));
+			nums >> retval.locks >> retval.contended >> retval.wait >>
+				retval.maxWait >> retval.hold;
+			retval.found = true;
+			retval.rank = rank;
+			break;
+		}
+	}
+	return retval;
+}
+
+
+/*
+ * This records a few locks from another thread, so the report has to
+ * add up the threads' tables.
+ */
+static void *recorder( void *anArg )
+{
+	CKLockProfiler::record("tagA", 0, 10000, 4000);
+	return NULL;
+}
+
+
+int main(int argc, char *argv[]) {
+	bool	ok = true;
+
+	CKLockProfiler::reset();
+	CKLockProfiler::enable();
+
+	// record some sites right here, and one more from another thread
+	for (int i = 0; i < 3; ++i) {
+		CKLockProfiler::record("tagA", 0, 5000, 2000);
+	}
+	CKLockProfiler::record("tagB", 0, 500, 1000);
+	CKLockProfiler::record("file.cpp", 42, 200000, 3000);
+	pthread_t	tid;
+	pthread_create(&tid, NULL, recorder, NULL);
+	pthread_join(tid, NULL);
+
+	CKString	report = CKLockProfiler::getReport();
+	std::cout << report;
+	ReportLine	a = findSite(report, "tagA");
+	ReportLine	b = findSite(report, "tagB");
+	ReportLine	f = findSite(report, "file.cpp:42");
+	bool	pass = a.found && (a.locks == 4) && (a.contended == 4) &&
+				   (a.wait == 25) && (a.maxWait == 10) && (a.hold == 10);
+	std::cout << "recorded tag " << (pass ? "passed" : "FAILED") << std::endl;
+	ok = ok && pass;
+	pass = b.found && (b.locks == 1) && (b.contended == 0) &&
+		   f.found && (f.locks == 1) && (f.wait == 200);
+	std::cout << "recorded sites " << (pass ? "passed" : "FAILED") << std::endl;
+	ok = ok && pass;
+	pass = (f.rank < a.rank) && (a.rank < b.rank);
+	std::cout << "most waiting first " << (pass ? "passed" : "FAILED") << std::endl;
+	ok = ok && pass;
+
+	// the stack lockers record themselves
+	CKFWMutex	m;
+	for (int i = 0; i < 5; ++i) {
+		CKStackLocker	lockem(&m, "lockerTag", 0);
+	}
+	ReportLine	l = findSite(CKLockProfiler::getReport(), "lockerTag");
+	pass = l.found && (l.locks == 5);
+	std::cout << "stack locker " << (pass ? "passed" : "FAILED") << std::endl;
+	ok = ok && pass;
+
+	// ...but not when it's off
+	CKLockProfiler::disable();
+	{
+		CKStackLocker	lockem(&m, "lockerTag", 0);
+	}
+	l = findSite(CKLockProfiler::getReport(), "lockerTag");
+	pass = l.found && (l.locks == 5);
+	std::cout << "disabled " << (pass ? "passed" : "FAILED") << std::endl;
+	ok = ok && pass;
+
+	// resetting clears everything
+	CKLockProfiler::reset();
+	report = CKLockProfiler::getReport();
+	pass = !findSite(report, "tagA").found && !findSite(report, "tagB").found &&
+		   !findSite(report, "file.cpp:42").found && !findSite(report, "lockerTag").found;
+	std::cout << "reset " << (pass ? "passed" : "FAILED") << std::endl;
+	ok = ok && pass;
+
+	if (!ok) {
+		std::cout << "PROBLEM!" << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,300 @@
+/*
+ * This is a test program for the memory-mapped CKTable files. It writes
+ * tables of all kinds - dense and not, row-major and columnar, with empty
+ * cells, NaNs, nested tables and the same label twice - with
+ * CKMappedTable::writeTable(), opens them, and checks every cell, look up
+ * and the table made from the file against the original. Then it makes
+ * sure a file that's been cut short or isn't a table is refused, and
+ * times writing and opening a big table, and scanning a column of it,
+ * next to the binary code of the CKTable. Run it as:
+ *
+ *     mappedTableBench [rows] [file]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "CKMappedTable.h"
+#include "CKTable.h"
+#include "CKString.h"
+#include "CKException.h"
+#include "benchUtils.h"
+
+/*
+ * These are the columns of the test tables - a dense column of numbers
+ * and one of dates, then numbers, dates and strings with empty cells,
+ * and a column of everything.
+ */
+#define	PRICE	0
+#define	WHEN	1
+#define	QTY		2
+#define	SETTLE	3
+#define	SYM		4
+#define	MIXED	5
+
+/*
+ * This makes a table of 'aRows' rows. Every tenth label is the same as
+ * the one before it, and the strings are sometimes empty but there.
+ */
+static CKTable makeTable( int aRows, bool aColumnar, int aSeed )
+{
+	char			buff[64];
+	CKTable			table(aRows, 6);
+	const char		*headers[] = { "price", "when", "qty", "settle", "sym", "mixed" };
+	table.setColumnar(aColumnar);
+	if (aColumnar) {
+		table.setColumnType(PRICE, eNumberVariant);
+		table.setColumnType(WHEN, eDateVariant);
+	}
+	for (int j = 0; j < table.getNumColumns(); ++j) {
+		table.setColumnHeader(j, headers[j]);
+	}
+
+	CKTable			nested(2, 2);
+	nested.setStringValue(0, 0, "inside");
+	nested.setDoubleValue(1, 1, 2.5);
+	unsigned int	r = aSeed;
+	for (int i = 0; i < aRows; ++i) {
+		r = r * 1103515245 + 12345;
+		unsigned int	v = (r >> 8);
+		snprintf(buff, sizeof(buff), "row%d", ((i % 10) == 9 ? i - 1 : i));
+		table.setRowLabel(i, buff);
+		table.setDoubleValue(i, PRICE, ((v % 31) == 0 ? NAN : (v % 10000) / 100.0));
+		table.setDateValue(i, WHEN, 20000101 + (v % 3650));
+		if ((v % 7) != 0) {
+			table.setDoubleValue(i, QTY, (double)((int)(v % 2001) - 1000));
+		}
+		if ((v % 5) != 0) {
+			table.setDateValue(i, SETTLE, 20200101 + (v % 365));
+		}
+		if ((v % 11) == 0) {
+			table.setStringValue(i, SYM, "");
+		} else if ((v % 13) != 0) {
+			snprintf(buff, sizeof(buff), "SYM%u", (v >> 4) % 500);
+			table.setStringValue(i, SYM, buff);
+		}
+		switch ((v >> 3) % 5) {
+			case 0:
+				table.setDoubleValue(i, MIXED, v * 0.5);
+				break;
+			case 1:
+				table.setDateValue(i, MIXED, 20100101 + (v % 100));
+				break;
+			case 2:
+				table.setStringValue(i, MIXED, "text");
+				break;
+			case 3:
+				{
+					CKVariant	value;
+					value.setTableValue(&nested);
+					table.setValue(i, MIXED, value);
+				}
+				break;
+			default:
+				break;
+		}
+	}
+	return table;
+}
+
+
+/*
+ * This writes the table, opens it, and checks everything in the file
+ * against it - and a copy of the view, and the table made from the
+ * file. It returns the number of problems.
+ */
+static int checkTable( const CKTable & aTable, const CKString & aFile, const char *aName )
+{
+	int		problems = 0;
+	CKMappedTable::writeTable(aTable, aFile);
+	CKMappedTable	opened(aFile);
+	CKMappedTable	mapped(opened);
+	int				rows = aTable.getNumRows();
+	int				cols = aTable.getNumColumns();
+
+	if ((mapped.getNumRows() != rows) || (mapped.getNumColumns() != cols)) {
+		std::cout << aName << ": the file is " << mapped.getNumRows() << " by " <<
+			mapped.getNumColumns() << " and not " << rows << " by " << cols << std::endl;
+		return 1;
+	}
+	for (int j = 0; j < cols; ++j) {
+		if ((mapped.getColumnHeader(j) != aTable.getColumnHeader(j)) ||
+			(mapped.getColumnForHeader(aTable.getColumnHeader(j)) !=
+			 aTable.getColumnForHeader(aTable.getColumnHeader(j)))) {
+			std::cout << aName << ": column " << j << " has the wrong header" << std::endl;
+			++problems;
+		}
+	}
+	for (int i = 0; i < rows; ++i) {
+		if ((mapped.getRowLabel(i) != aTable.getRowLabel(i)) ||
+			(mapped.getRowForLabel(aTable.getRowLabel(i)) !=
+			 aTable.getRowForLabel(aTable.getRowLabel(i)))) {
+			std::cout << aName << ": row " << i << " has the wrong label" << std::endl;
+			++problems;
+		}
+		for (int j = 0; j < cols; ++j) {
+			CKVariantType	type = aTable.getType(i, j);
+			bool			ok = (mapped.getType(i, j) == type);
+			if (ok && (type == eNumberVariant)) {
+				double	a = aTable.getDoubleValue(i, j);
+				double	b = mapped.getDoubleValue(i, j);
+				ok = ((a == b) || (isnan(a) && isnan(b)));
+			} else if (ok && (type == eDateVariant)) {
+				ok = (mapped.getDateValue(i, j) == aTable.getDateValue(i, j));
+			} else if (ok && (type == eStringVariant)) {
+				ok = (strcmp(aTable.getStringValue(i, j)->c_str(), mapped.getStringValue(i, j)) == 0);
+			}
+			if (ok && (type != eNumberVariant)) {
+				ok = (mapped.getValueAsString(i, j) == aTable.getValueAsString(i, j));
+			}
+			if (!ok) {
+				std::cout << aName << ": cell " << i << ", " << j << " is '" <<
+					mapped.getValueAsString(i, j) << "' and not '" <<
+					aTable.getValueAsString(i, j) << "'" << std::endl;
+				++problems;
+			}
+		}
+	}
+	if ((mapped.getRowForLabel("no such row") != -1) ||
+		(mapped.getColumnForHeader("no such column") != -1)) {
+		std::cout << aName << ": a missing label was found" << std::endl;
+		++problems;
+	}
+	if ((cols > PRICE) && (rows > 0) && (mapped.getDoubleColumn(PRICE) == NULL)) {
+		std::cout << aName << ": the prices aren't a column of numbers" << std::endl;
+		++problems;
+	}
+	if (!sameTable(mapped.getTable(), aTable)) {
+		std::cout << aName << ": the table from the file isn't the same" << std::endl;
+		++problems;
+	}
+	return problems;
+}
+
+
+/*
+ * This makes sure the file isn't opened - it returns 1 if it is.
+ */
+static int checkRefused( const CKString & aFile, const char *aName )
+{
+	try {
+		CKMappedTable	mapped(aFile);
+		std::cout << aName << ": the file was opened" << std::endl;
+		return 1;
+	} catch (CKException & e) {
+		return 0;
+	}
+}
+
+
+int main(int argc, char *argv[]) {
+	int			rows = (argc > 1 ? atoi(argv[1]) : 1000000);
+	CKString	file = (argc > 2 ? argv[2] : "/tmp/mappedTableBench.tbl");
+
+	int		problems = 0;
+	try {
+		// the small tables in each layout
+		int		sizes[] = { 1, 2, 7, 8, 9, 100, 1000 };
+		for (unsigned int s = 0; s < sizeof(sizes)/sizeof(sizes[0]); ++s) {
+			for (int layout = 0; layout < 2; ++layout) {
+				char	name[64];
+				snprintf(name, sizeof(name), "%d rows%s", sizes[s],
+						 (layout ? " columnar" : ""));
+				problems += checkTable(makeTable(sizes[s], layout != 0, s + 1), file, name);
+			}
+		}
+		// ...a table without any rows, and a column that's all empty
+		CKTable		empty = makeTable(10, true, 3);
+		empty.selectRows(CKVector<int>());
+		problems += checkTable(empty, file, "no rows");
+		CKTable		blank(5, 2);
+		problems += checkTable(blank, file, "all empty");
+
+		// ...and files that aren't whole, or aren't tables
+		CKMappedTable::writeTable(makeTable(100, true, 4), file);
+		CKMappedTable	whole(file);
+		if (truncate(file.c_str(), whole.getFileSize() - 8) != 0) {
+			std::cout << "the file couldn't be cut short" << std::endl;
+			++problems;
+		}
+		problems += checkRefused(file, "cut short");
+		if (whole.getValueAsString(99, SYM) != makeTable(100, true, 4).getValueAsString(99, SYM)) {
+			std::cout << "the open view changed when the file did" << std::endl;
+			++problems;
+		}
+		FILE	*fp = fopen(file.c_str(), "w");
+		fprintf(fp, "This isn't a table, but it's long enough to be one, if it "
+				"had the right header. It has to be at least 120 bytes.\n");
+		fclose(fp);
+		problems += checkRefused(file, "not a table");
+		problems += checkRefused(file + ".missing", "missing");
+		if (problems == 0) {
+			std::cout << "The mapped tables are OK." << std::endl;
+		}
+
+		/*
+		 * The big table is written to the file and opened, and the same
+		 * table is coded in binary and made back from the code. Then the
+		 * column of prices is summed from each.
+		 */
+		CKTable		big = makeTable(rows, true, 5);
+		double		start = now();
+		CKMappedTable::writeTable(big, file);
+		double		writeTime = now() - start;
+		start = now();
+		CKMappedTable	mapped(file);
+		double		openTime = now() - start;
+		start = now();
+		double		sum = 0.0;
+		const double		*prices = mapped.getDoubleColumn(PRICE);
+		const unsigned char	*valid = mapped.getColumnValidity(PRICE);
+		for (int i = 0; i < rows; ++i) {
+			if (((valid[i >> 3] >> (i & 7)) & 1) && !isnan(prices[i])) {
+				sum += prices[i];
+			}
+		}
+		double		scanTime = now() - start;
+
+		start = now();
+		std::string	code = big.toBinary();
+		double		encodeTime = now() - start;
+		start = now();
+		CKTable		decoded;
+		decoded.fromBinary(code);
+		double		decodeTime = now() - start;
+		start = now();
+		double		check = 0.0;
+		for (int i = 0; i < rows; ++i) {
+			if ((decoded.getType(i, PRICE) == eNumberVariant) &&
+				!isnan(decoded.getDoubleValue(i, PRICE))) {
+				check += decoded.getDoubleValue(i, PRICE);
+			}
+		}
+		double		decodedScanTime = now() - start;
+		if (fabs(sum - check) > 1e-6 * fabs(check)) {
+			std::cout << "the sums are " << sum << " and " << check << std::endl;
+			++problems;
+		}
+
+		std::cout << std::fixed << std::setprecision(1);
+		std::cout << rows << " rows:" << std::endl;
+		std::cout << "  mapped file: write " << writeTime * 1000.0 << " ms, " <<
+			mapped.getFileSize() / 1048576.0 << " MB, open " << openTime * 1000.0 <<
+			" ms, scan " << scanTime * 1000.0 << " ms" << std::endl;
+		std::cout << "  binary code: encode " << encodeTime * 1000.0 << " ms, " <<
+			code.size() / 1048576.0 << " MB, decode " << decodeTime * 1000.0 <<
+			" ms, scan " << decodedScanTime * 1000.0 << " ms" << std::endl;
+		unlink(file.c_str());
+	} catch (CKException & e) {
+		problems += problem(e);
+	}
+
+	return finish(problems);
+}
@@ -0,0 +1,468 @@
+/*
+ * This is a test program for the matrix methods of CKTable. It checks
+ * matrixMultiply(), transpose(), covariance() and correlation() against
+ * simple versions done with loops here - the products have to match to
+ * the last bit, as they're summed in the same order - on tables in both
+ * layouts, with and without AVX2, on the calling thread and split up on
+ * a pool. Then it times them on big tables next to the simple loops.
+ * Run it as:
+ *
+ *     matrixBench [size] [threads]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CKTable.h"
+#include "CKExecutor.h"
+#include "CKVectorMath.h"
+#include "CKString.h"
+#include "CKException.h"
+#include "benchUtils.h"
+
+/*
+ * This makes a table of numbers with labels and headers. The numbers
+ * have all their bits, and some are big and some small, so a sum done
+ * in a different order would come out different. The layout is one of:
+ *   0 - row-major CKVariants
+ *   1 - columnar, with dense columns
+ *   2 - columnar, with the first column CKVariants
+ */
+static CKTable makeTable( int aRows, int aCols, int aLayout, unsigned int aSeed )
+{
+	char		buff[64];
+	CKTable		table(aRows, aCols);
+	srand(aSeed);
+	for (int j = 0; j < aCols; ++j) {
+		snprintf(buff, sizeof(buff), "c%d", j);
+		table.setColumnHeader(j, buff);
+	}
+	for (int i = 0; i < aRows; ++i) {
+		snprintf(buff, sizeof(buff), "r%d", i);
+		table.setRowLabel(i, buff);
+		for (int j = 0; j < aCols; ++j) {
+			double	x = (rand() - RAND_MAX/2.0) / RAND_MAX;
+			if ((rand() % 7) == 0) {
+				x *= 1.0e6;
+			}
+			table.setDoubleValue(i, j, x + j);
+		}
+	}
+	if (aLayout > 0) {
+		table.setColumnar(true);
+		if ((aLayout == 2) && (aCols > 0)) {
+			table.setColumnType(0, eUnknownVariant);
+		}
+	}
+	return table;
+}
+
+
+/*
+ * This pulls the numbers out of a table a column at a time.
+ */
+static std::vector< std::vector<double> > getColumns( const CKTable & aTable )
+{
+	std::vector< std::vector<double> >	retval(aTable.getNumColumns());
+	for (int j = 0; j < aTable.getNumColumns(); ++j) {
+		retval[j].resize(aTable.getNumRows());
+		for (int i = 0; i < aTable.getNumRows(); ++i) {
+			retval[j][i] = aTable.getDoubleValue(i, j);
+		}
+	}
+	return retval;
+}
+
+
+/*
+ * This checks that the table is the same size as the columns, and that
+ * each cell has exactly the same bits as the number - so a NAN matches
+ * a NAN. If 'aTolerance' isn't zero, each can be off by that much of
+ * the biggest number in the column instead.
+ */
+static int checkCells( const CKTable & aTable,
+					   const std::vector< std::vector<double> > & aColumns,
+					   const char *aName, double aTolerance = 0.0 )
+{
+	int		cols = aColumns.size();
+	int		rows = (cols > 0 ? aColumns[0].size() : 0);
+	if ((aTable.getNumColumns() != cols) || (aTable.getNumRows() != rows)) {
+		std::cout << "PROBLEM! " << aName << " is " << aTable.getNumRows() << "x" <<
+			aTable.getNumColumns() << " and not " << rows << "x" << cols << std::endl;
+		return 1;
+	}
+	for (int j = 0; j < cols; ++j) {
+		const double	*dense = aTable.getDoubleColumn(j);
+		if (dense == NULL) {
+			std::cout << "PROBLEM! " << aName << " column " << j <<
+				" isn't dense." << std::endl;
+			return 1;
+		}
+		double	biggest = 0.0;
+		for (int i = 0; i < rows; ++i) {
+			biggest = (fabs(aColumns[j][i]) > biggest ? fabs(aColumns[j][i]) : biggest);
+		}
+		for (int i = 0; i < rows; ++i) {
+			double	want = aColumns[j][i];
+			double	got = dense[i];
+			bool	ok = (memcmp(&want, &got, sizeof(double)) == 0) ||
+						 ((aTolerance > 0.0) && (fabs(want - got) <= aTolerance * biggest));
+			if (!ok) {
+				std::cout << "PROBLEM! " << aName << " (" << i << ", " << j << ") is " <<
+					std::setprecision(17) << got << " and not " << want << std::endl;
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+
+/*
+ * These are the simple versions. The product sums each cell in order
+ * from zero, which is what the blocked one has to match exactly.
+ */
+static std::vector< std::vector<double> > simpleMultiply(
+	const std::vector< std::vector<double> > & anA,
+	const std::vector< std::vector<double> > & aB, int aRows )
+{
+	std::vector< std::vector<double> >	retval(aB.size(), std::vector<double>(aRows));
+	for (unsigned int j = 0; j < aB.size(); ++j) {
+		for (int i = 0; i < aRows; ++i) {
+			double	sum = 0.0;
+			for (unsigned int p = 0; p < anA.size(); ++p) {
+				sum = sum + anA[p][i] * aB[j][p];
+			}
+			retval[j][i] = sum;
+		}
+	}
+	return retval;
+}
+
+
+static std::vector< std::vector<double> > simpleCovariance(
+	const std::vector< std::vector<double> > & aColumns )
+{
+	int		cols = aColumns.size();
+	int		rows = (cols > 0 ? aColumns[0].size() : 0);
+	std::vector< std::vector<double> >	centered(aColumns);
+	for (int j = 0; j < cols; ++j) {
+		long double	sum = 0.0;
+		for (int i = 0; i < rows; ++i) {
+			sum += aColumns[j][i];
+		}
+		for (int i = 0; i < rows; ++i) {
+			centered[j][i] = (double)(aColumns[j][i] - sum / rows);
+		}
+	}
+	std::vector< std::vector<double> >	retval(cols, std::vector<double>(cols));
+	for (int a = 0; a < cols; ++a) {
+		for (int b = 0; b < cols; ++b) {
+			long double	sum = 0.0;
+			for (int i = 0; i < rows; ++i) {
+				sum += (long double)centered[a][i] * centered[b][i];
+			}
+			retval[b][a] = (double)(sum / (rows - 1));
+		}
+	}
+	return retval;
+}
+
+
+/*
+ * This checks all the matrix methods on the tables - 'aLeft' is m x k
+ * and 'aRight' is k x n.
+ */
+static int checkAll( const CKTable & aLeft, const CKTable & aRight, const char *aName )
+{
+	int		problems = 0;
+	char	name[128];
+	std::vector< std::vector<double> >	a = getColumns(aLeft);
+	std::vector< std::vector<double> >	b = getColumns(aRight);
+
+	// the product, with its labels
+	CKTable		product = aLeft.matrixMultiply(aRight);
+	snprintf(name, sizeof(name), "%s product", aName);
+	problems += checkCells(product, simpleMultiply(a, b, aLeft.getNumRows()), name);
+	for (int i = 0; (problems == 0) && (i < product.getNumRows()); ++i) {
+		if ((product.getRowLabel(i) != aLeft.getRowLabel(i)) ||
+			(product.getRowForLabel(aLeft.getRowLabel(i)) != i)) {
+			std::cout << "PROBLEM! " << name << " row " << i << " is labelled '" <<
+				product.getRowLabel(i) << "'" << std::endl;
+			++problems;
+		}
+	}
+	for (int j = 0; (problems == 0) && (j < product.getNumColumns()); ++j) {
+		if ((product.getColumnHeader(j) != aRight.getColumnHeader(j)) ||
+			(product.getColumnForHeader(aRight.getColumnHeader(j)) != j)) {
+			std::cout << "PROBLEM! " << name << " column " << j << " is headed '" <<
+				product.getColumnHeader(j) << "'" << std::endl;
+			++problems;
+		}
+	}
+
+	// the transpose
+	CKTable		trans = aLeft.transpose();
+	std::vector< std::vector<double> >	at(aLeft.getNumRows(),
+										   std::vector<double>(aLeft.getNumColumns()));
+	for (int j = 0; j < aLeft.getNumColumns(); ++j) {
+		for (int i = 0; i < aLeft.getNumRows(); ++i) {
+			at[i][j] = a[j][i];
+		}
+	}
+	snprintf(name, sizeof(name), "%s transpose", aName);
+	problems += checkCells(trans, at, name);
+	if ((aLeft.getNumRows() > 0) && (aLeft.getNumColumns() > 0) &&
+		((trans.getRowLabel(0) != aLeft.getColumnHeader(0)) ||
+		 (trans.getColumnHeader(0) != aLeft.getRowLabel(0)))) {
+		std::cout << "PROBLEM! " << name << " has the wrong labels." << std::endl;
+		++problems;
+	}
+
+	// the covariance and correlation, if there's enough for them
+	if (aLeft.getNumRows() >= 2) {
+		CKTable		cov = aLeft.covariance();
+		snprintf(name, sizeof(name), "%s covariance", aName);
+		problems += checkCells(cov, simpleCovariance(a), name, 1.0e-12);
+		CKTable		corr = aLeft.correlation();
+		int			cols = aLeft.getNumColumns();
+		for (int i = 0; i < cols; ++i) {
+			for (int j = 0; j < cols; ++j) {
+				double	x = corr.getDoubleValue(i, j);
+				double	y = cov.getDoubleValue(i, j) /
+							sqrt(cov.getDoubleValue(i, i) * cov.getDoubleValue(j, j));
+				if ((x != corr.getDoubleValue(j, i)) ||
+					(cov.getDoubleValue(i, j) != cov.getDoubleValue(j, i)) ||
+					((i == j) && (x != 1.0)) || (fabs(x - y) > 1.0e-12) ||
+					(fabs(x) > 1.0)) {
+					std::cout << "PROBLEM! " << aName << " correlation (" << i << ", " <<
+						j << ") is " << std::setprecision(17) << x << std::endl;
+					++problems;
+					i = cols;
+					break;
+				}
+			}
+		}
+	}
+	return problems;
+}
+
+
+/*
+ * This checks the things that are special - a column that's all one
+ * number, a matrix without any rows, and the mistakes.
+ */
+static int checkSpecial()
+{
+	int		problems = 0;
+
+	// a column of one number has no correlation with anything
+	CKTable		flat = makeTable(100, 3, 1, 11);
+	for (int i = 0; i < 100; ++i) {
+		flat.setDoubleValue(i, 1, 0.1);
+	}
+	CKTable		cov = flat.covariance();
+	CKTable		corr = flat.correlation();
+	for (int j = 0; j < 3; ++j) {
+		if ((cov.getDoubleValue(1, j) != 0.0) || !isnan(corr.getDoubleValue(1, j)) ||
+			!isnan(corr.getDoubleValue(j, 1))) {
+			std::cout << "PROBLEM! The flat column has a covariance of " <<
+				cov.getDoubleValue(1, j) << " and a correlation of " <<
+				corr.getDoubleValue(1, j) << " with column " << j << std::endl;
+			++problems;
+		}
+	}
+	if (corr.getDoubleValue(0, 0) != 1.0) {
+		std::cout << "PROBLEM! The correlation of column 0 with itself isn't 1." << std::endl;
+		++problems;
+	}
+
+	// a table without rows - the product is empty, and it transposes
+	CKTable		empty = makeTable(10, 4, 1, 12);
+	empty.selectRows(CKVector<int>());
+	CKTable		right = makeTable(4, 3, 1, 13);
+	CKTable		product = empty.matrixMultiply(right);
+	CKTable		trans = empty.transpose();
+	if ((product.getNumRows() != 0) || (product.getNumColumns() != 3) ||
+		(trans.getNumRows() != 4) || (trans.getNumColumns() != 0)) {
+		std::cout << "PROBLEM! The empty product is " << product.getNumRows() << "x" <<
+			product.getNumColumns() << " and the transpose " << trans.getNumRows() <<
+			"x" << trans.getNumColumns() << std::endl;
+		++problems;
+	}
+	// ...and the product over nothing is all zeros
+	CKTable		zeros = empty.transpose().matrixMultiply(empty);
+	for (int i = 0; i < 4; ++i) {
+		for (int j = 0; j < 4; ++j) {
+			if (zeros.getDoubleValue(i, j) != 0.0) {
+				std::cout << "PROBLEM! The product over nothing isn't zero." << std::endl;
+				++problems;
+				i = 4;
+				break;
+			}
+		}
+	}
+
+	// the mistakes
+	CKTable		square = makeTable(5, 5, 0, 14);
+	CKTable		hole = makeTable(5, 5, 1, 15);
+	hole.setValue(3, 2, CKVariant());
+	CKTable		word = makeTable(5, 5, 0, 16);
+	word.setStringValue(1, 4, "abc");
+	CKTable		when = makeTable(5, 5, 2, 17);
+	when.setDateValue(4, 0, 20050101);
+	CKTable		one = makeTable(1, 5, 1, 18);
+	CKTable		none;
+	for (int test = 0; test < 8; ++test) {
+		try {
+			switch (test) {
+				case 0:	square.matrixMultiply(right);		break;
+				case 1:	square.matrixMultiply(hole);		break;
+				case 2:	word.matrixMultiply(square);		break;
+				case 3:	when.transpose();					break;
+				case 4:	hole.covariance();					break;
+				case 5:	one.covariance();					break;
+				case 6:	none.transpose();					break;
+				case 7:	square.matrixMultiply(none);		break;
+			}
+			std::cout << "PROBLEM! Bad matrix " << test << " wasn't caught." << std::endl;
+			++problems;
+		} catch (CKException & e) {
+			// this is what we want
+		}
+	}
+	return problems;
+}
+
+
+/*
+ * This is the simple product on the dense columns - what one would
+ * write to do it by hand - for the timing.
+ */
+static void simpleDense( int aRows, int aCols, int anInner, const double * const *anA,
+						 const double * const *aB, double * const *aResult )
+{
+	for (int j = 0; j < aCols; ++j) {
+		for (int i = 0; i < aRows; ++i) {
+			double	sum = 0.0;
+			for (int p = 0; p < anInner; ++p) {
+				sum += anA[p][i] * aB[j][p];
+			}
+			aResult[j][i] = sum;
+		}
+	}
+}
+
+
+int main(int argc, char *argv[]) {
+	int		size = (argc > 1 ? atoi(argv[1]) : 1000);
+	int		threads = (argc > 2 ? atoi(argv[2]) : CKExecutor::getNumberOfProcessors());
+	if (threads < 2) {
+		threads = 2;
+	}
+
+	int		problems = 0;
+	try {
+		CKExecutor	pool(threads);
+
+		// the small tables in each layout, each way it can be done
+		int		sizes[][3] = { { 1, 1, 1 }, { 2, 3, 1 }, { 7, 9, 5 }, { 8, 4, 4 },
+							   { 33, 17, 65 }, { 300, 3, 259 }, { 129, 300, 70 },
+							   { 520, 260, 300 } };
+		for (unsigned int s = 0; s < sizeof(sizes)/sizeof(sizes[0]); ++s) {
+			for (int layout = 0; layout < 3; ++layout) {
+				CKTable		left = makeTable(sizes[s][0], sizes[s][1], layout, s + 1);
+				CKTable		right = makeTable(sizes[s][1], sizes[s][2], 2 - layout, s + 101);
+				for (int run = 0; run < 4; ++run) {
+					bool	split = ((run & 1) != 0);
+					CKVectorMath::setUseSIMD((run & 2) == 0);
+					CKTable::setParallelExecutor(split ? &pool : NULL);
+					CKTable::setParallelThreshold(split ? 1 : 0);
+					char	name[64];
+					snprintf(name, sizeof(name), "%dx%dx%d layout %d%s%s", sizes[s][0],
+							 sizes[s][1], sizes[s][2], layout, (split ? " split" : ""),
+							 ((run & 2) ? " plain" : ""));
+					problems += checkAll(left, right, name);
+				}
+			}
+		}
+		CKVectorMath::setUseSIMD(true);
+		CKTable::setParallelExecutor(NULL);
+		CKTable::setParallelThreshold(0);
+		problems += checkSpecial();
+		if (problems == 0) {
+			std::cout << "The matrices are OK." << std::endl;
+		}
+
+		/*
+		 * Now time the product of two square tables done by hand on the
+		 * dense columns, and then blocked - plain, with AVX2, and split
+		 * up over the pool - and the transpose and covariance.
+		 */
+		CKTable		left = makeTable(size, size, 1, 1001);
+		CKTable		right = makeTable(size, size, 1, 1002);
+		std::vector<const double *>	a(size);
+		std::vector<const double *>	b(size);
+		std::vector<double *>		c(size);
+		CKTable		byHand = left;
+		for (int j = 0; j < size; ++j) {
+			a[j] = left.getDoubleColumn(j);
+			b[j] = right.getDoubleColumn(j);
+			c[j] = (double *)byHand.getDoubleColumn(j);
+		}
+		double		flops = 2.0 * size * size * size;
+		double		start = now();
+		simpleDense(size, size, size, &a[0], &b[0], &c[0]);
+		double		handTime = now() - start;
+
+		double		times[3];
+		for (int run = 0; run < 3; ++run) {
+			CKVectorMath::setUseSIMD(run > 0);
+			CKTable::setParallelExecutor(run == 2 ? &pool : NULL);
+			CKTable::setParallelThreshold(run == 2 ? 1 : 0);
+			start = now();
+			CKTable		product = left.matrixMultiply(right);
+			times[run] = now() - start;
+			// the one by hand is summed in the same order, so it's the same
+			problems += checkCells(product, getColumns(byHand), "big product");
+		}
+		CKVectorMath::setUseSIMD(true);
+		CKTable::setParallelExecutor(NULL);
+		CKTable::setParallelThreshold(0);
+
+		start = now();
+		CKTable		trans = left.transpose();
+		double		transTime = now() - start;
+		CKTable		tall = makeTable(100 * size, 20, 1, 1003);
+		start = now();
+		CKTable		cov = tall.covariance();
+		double		covTime = now() - start;
+
+		std::cout << std::fixed << std::setprecision(1);
+		std::cout << size << "x" << size << " product:" << std::endl;
+		std::cout << "  by hand:     " << std::setw(9) << (handTime * 1000.0) << " ms, " <<
+			(flops / handTime / 1.0e9) << " GFLOPS" << std::endl;
+		const char	*names[] = { "plain:       ", "AVX2:        ", "split up:    " };
+		for (int run = 0; run < 3; ++run) {
+			std::cout << "  " << names[run] << std::setw(9) << (times[run] * 1000.0) <<
+				" ms, " << (flops / times[run] / 1.0e9) << " GFLOPS" << std::endl;
+		}
+		std::cout << size << "x" << size << " transpose: " << (transTime * 1000.0) <<
+			" ms" << std::endl;
+		std::cout << (100 * size) << "x20 covariance: " << (covTime * 1000.0) <<
+			" ms" << std::endl;
+		if (trans.getNumRows() != size) {
+			++problems;
+		}
+	} catch (CKException & e) {
+		problems += problem(e);
+	}
+
+	return finish(problems, "All the matrices match.");
+}
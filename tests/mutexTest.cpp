@@ -0,0 +1,184 @@
+/*
+ * This is a test program that exercises the spinning and the
+ * statistics of the CKFWMutex.
+ */
+
+#include <iostream>
+#include <string>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "CKFWMutex.h"
+#include "CKString.h"
+
+static const int	THREADS = 4;
+static const int	LOCKS = 20000;
+
+/*
+ * Each of the lockers just locks and unlocks the mutex over and over,
+ * giving up the CPU while holding it now and then so that the others
+ * find it busy - even on a box with only one CPU.
+ */
+static CKFWMutex	*gMutex = NULL;
+static volatile long	gCount = 0;
+static volatile bool	gDone = false;
+
+static void *locker( void *anArg )
+{
+	for (int i = 0; i < LOCKS; ++i) {
+		gMutex->lock();
+		++gCount;
+		if ((i % 64) == 0) {
+			sched_yield();
+		}
+		gMutex->unlock();
+	}
+	return NULL;
+}
+
+
+/*
+ * This one keeps turning the statistics on and off while the lockers
+ * are at it.
+ */
+static void *toggler( void *anArg )
+{
+	while (!gDone) {
+		gMutex->enableStatistics("toggled");
+		sched_yield();
+		gMutex->disableStatistics();
+	}
+	return NULL;
+}
+
+
+/*
+ * These all try to be the one to turn the statistics on first.
+ */
+static void *enabler( void *anArg )
+{
+	gMutex->enableStatistics("raced");
+	return NULL;
+}
+
+
+/*
+ * This counts the lines of the dump for the mutexes with this name.
+ */
+static int countInDump( const char *aName )
+{
+	std::string	dump = CKFWMutexStats::dumpAll().c_str();
+	std::string	key = std::string(aName) + ": ";
+	int			cnt = 0;
+	for (std::string::size_type i = dump.find(key); i != std::string::npos;
+		 i = dump.find(key, i + 1)) {
+		if ((i == 0) || (dump[i - 1] == '\n')) {
+			++cnt;
+		}
+	}
+	return cnt;
+}
+
+
+int main(int argc, char *argv[]) {
+	bool		ok = true;
+	pthread_t	tids[THREADS + 1];
+
+	// the spin counts are clamped - and always zero with only one CPU
+	{
+		bool		multi = (sysconf(_SC_NPROCESSORS_ONLN) > 1);
+		CKFWMutex	m;
+		m.setSpinCount(-5);
+		bool	pass = (m.getSpinCount() == 0);
+		m.setSpinCount(1000);
+		pass = pass && (m.getSpinCount() == (multi ? 1000 : 0));
+		int		def = CKFWMutex::getDefaultSpinCount();
+		CKFWMutex::setDefaultSpinCount(-3);
+		pass = pass && (CKFWMutex::getDefaultSpinCount() == 0);
+		CKFWMutex::setDefaultSpinCount(def);
+		std::cout << "spin count clamping " << (pass ? "passed" : "FAILED") << std::endl;
+		ok = ok && pass;
+	}
+
+	// the counts move under contention
+	{
+		CKFWMutex	m;
+		m.setSpinCount(100);
+		m.enableStatistics("contended");
+		gMutex = &m;
+		gCount = 0;
+		for (int t = 0; t < THREADS; ++t) {
+			pthread_create(&tids[t], NULL, locker, NULL);
+		}
+		for (int t = 0; t < THREADS; ++t) {
+			pthread_join(tids[t], NULL);
+		}
+		const CKFWMutexStats	*stats = m.getStatistics();
+		bool	pass = (gCount == THREADS * LOCKS) && (stats != NULL) &&
+					   (stats->getAcquisitionCount() == (unsigned long)(THREADS * LOCKS)) &&
+					   (stats->getContendedCount() > 0) &&
+					   (stats->getContendedCount() <= stats->getAcquisitionCount()) &&
+					   (stats->getSpinAcquisitionCount() <= stats->getContendedCount()) &&
+					   (stats->getTotalWaitNanos() > 0);
+		std::cout << stats->toString() << std::endl;
+		std::cout << "statistics under contention " << (pass ? "passed" : "FAILED") << std::endl;
+		ok = ok && pass;
+
+		// turning them off keeps them, but stops the counting
+		m.disableStatistics();
+		unsigned long	locks = stats->getAcquisitionCount();
+		m.lock();
+		m.unlock();
+		pass = (m.getStatistics() == stats) && (stats->getAcquisitionCount() == locks);
+		std::cout << "disabled statistics " << (pass ? "passed" : "FAILED") << std::endl;
+		ok = ok && pass;
+	}
+
+	// turning them on and off while it's being locked is safe
+	{
+		CKFWMutex	m;
+		gMutex = &m;
+		gCount = 0;
+		gDone = false;
+		pthread_create(&tids[THREADS], NULL, toggler, NULL);
+		for (int t = 0; t < THREADS; ++t) {
+			pthread_create(&tids[t], NULL, locker, NULL);
+		}
+		for (int t = 0; t < THREADS; ++t) {
+			pthread_join(tids[t], NULL);
+		}
+		gDone = true;
+		pthread_join(tids[THREADS], NULL);
+		bool	pass = (gCount == THREADS * LOCKS) && (countInDump("toggled") == 1) &&
+					   (m.getStatistics()->getAcquisitionCount() <= (unsigned long)(THREADS * LOCKS));
+		std::cout << "toggling statistics " << (pass ? "passed" : "FAILED") << std::endl;
+		ok = ok && pass;
+	}
+
+	// ...and only one of the racing enables wins
+	{
+		CKFWMutex	m;
+		gMutex = &m;
+		for (int t = 0; t < THREADS; ++t) {
+			pthread_create(&tids[t], NULL, enabler, NULL);
+		}
+		for (int t = 0; t < THREADS; ++t) {
+			pthread_join(tids[t], NULL);
+		}
+		bool	pass = (m.getStatistics() != NULL) && (countInDump("raced") == 1);
+		std::cout << "racing enables " << (pass ? "passed" : "FAILED") << std::endl;
+		ok = ok && pass;
+	}
+	// once the mutexes are gone, so are their stats
+	bool	gone = (countInDump("contended") == 0) && (countInDump("toggled") == 0) &&
+				   (countInDump("raced") == 0);
+	std::cout << "statistics unregistered " << (gone ? "passed" : "FAILED") << std::endl;
+	ok = ok && gone;
+
+	if (!ok) {
+		std::cout << "PROBLEM!" << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,256 @@
+/*
+ * This is a test program for splitting up the work on big CKTables. It
+ * does the simple math, merge(), generateCodeFromValues(),
+ * takeValuesFromCode() and operator==() on tables in both layouts - on
+ * the calling thread and then on pools of one thread up to many - and
+ * checks that every answer is exactly what the calling thread got. It
+ * then prints the time each took so the scaling can be seen. Run it as:
+ *
+ *     parallelTableBench [rows] [cols] [maxThreads]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "CKTable.h"
+#include "CKExecutor.h"
+#include "CKVariant.h"
+#include "CKString.h"
+#include "CKException.h"
+#include "benchUtils.h"
+
+/*
+ * This makes a table of numbers with labels and headers, and every so
+ * often a string or an empty cell so the math has to skip some. The
+ * numbers are all quarters so they come back exactly from a code. The
+ * labels start at 'aFirstRow' so two of them can overlap in a merge.
+ */
+static CKTable makeTable( int aRows, int aCols, int aFirstRow, int aSeed )
+{
+	char		buff[64];
+	CKTable		table(aRows, aCols);
+	for (int j = 0; j < aCols; ++j) {
+		snprintf(buff, sizeof(buff), "c%d", j);
+		table.setColumnHeader(j, buff);
+	}
+	for (int i = 0; i < aRows; ++i) {
+		snprintf(buff, sizeof(buff), "r%d", aFirstRow + i);
+		table.setRowLabel(i, buff);
+		for (int j = 0; j < aCols; ++j) {
+			int		n = i * aCols + j + aSeed;
+			if ((n % 97) == 0) {
+				table.setStringValue(i, j, "abc");
+			} else if ((n % 89) != 0) {
+				table.setDoubleValue(i, j, 1.0 + (n % 1000) * 0.25);
+			}
+		}
+	}
+	return table;
+}
+
+
+/*
+ * These are the answers and times of one run of all the operations.
+ */
+struct Results {
+	CKTable		math;
+	CKTable		columnMath;
+	CKTable		merged;
+	CKString	code;
+	CKTable		parsed;
+	bool		same;
+	bool		differ;
+	double		times[6];
+};
+
+
+/*
+ * This does all the operations on copies of the tables with whatever
+ * executor and threshold are set right now.
+ */
+static void runAll( const CKTable & aTable, const CKTable & anOther,
+					const CKTable & aTail, Results & aResults )
+{
+	double		start = now();
+	aResults.math = aTable;
+	aResults.math.add(1.5);
+	aResults.math.multiply(anOther);
+	aResults.math.subtract(anOther);
+	aResults.math.inverse();
+	aResults.times[0] = now() - start;
+
+	aResults.columnMath = aTable;
+	aResults.columnMath.setColumnar(true);
+	CKTable		other = anOther;
+	other.setColumnar(true);
+	start = now();
+	aResults.columnMath.add(1.5);
+	aResults.columnMath.multiply(other);
+	aResults.columnMath.subtract(other);
+	aResults.columnMath.inverse();
+	aResults.times[1] = now() - start;
+
+	aResults.merged = aTable;
+	start = now();
+	aResults.merged.merge(aTail);
+	aResults.times[2] = now() - start;
+
+	start = now();
+	aResults.code = aTable.generateCodeFromValues();
+	aResults.times[3] = now() - start;
+
+	start = now();
+	aResults.parsed.takeValuesFromCode(aResults.code);
+	aResults.times[4] = now() - start;
+
+	CKTable		copy = aTable;
+	start = now();
+	aResults.same = (copy == aTable);
+	aResults.times[5] = now() - start;
+	copy.setDoubleValue(copy.getNumRows() - 1, copy.getNumColumns() - 1, -1.0);
+	aResults.differ = (copy != aTable);
+}
+
+
+/*
+ * This checks one run against the one done on the calling thread, and
+ * returns the number of answers that don't match. The comparing is done
+ * on the calling thread so it's not checking itself.
+ */
+static int check( const Results & aRun, const Results & aSerial, const char *aName )
+{
+	int		saved = CKTable::getParallelThreshold();
+	CKTable::setParallelThreshold(0);
+
+	int		problems = 0;
+	if (aRun.math != aSerial.math) {
+		std::cout << "PROBLEM! The math on " << aName << " didn't match." << std::endl;
+		++problems;
+	}
+	if (aRun.columnMath != aSerial.columnMath) {
+		std::cout << "PROBLEM! The columnar math on " << aName << " didn't match." << std::endl;
+		++problems;
+	}
+	if (aRun.merged != aSerial.merged) {
+		std::cout << "PROBLEM! The merge on " << aName << " didn't match." << std::endl;
+		++problems;
+	}
+	if (aRun.code != aSerial.code) {
+		std::cout << "PROBLEM! The code on " << aName << " didn't match." << std::endl;
+		++problems;
+	}
+	if (aRun.parsed != aSerial.parsed) {
+		std::cout << "PROBLEM! The parsed table on " << aName << " didn't match." << std::endl;
+		++problems;
+	}
+	if (!aRun.same || !aRun.differ) {
+		std::cout << "PROBLEM! The equality on " << aName << " was wrong." << std::endl;
+		++problems;
+	}
+
+	CKTable::setParallelThreshold(saved);
+	return problems;
+}
+
+
+/*
+ * This checks the small cases - tables that are one block, that end in
+ * a partial block, and the code of one that round-trips - with every
+ * table split up, no matter how small.
+ */
+static int checkSmall( CKExecutor & aPool )
+{
+	int		problems = 0;
+	int		sizes[] = { 1, 63, 64, 65, 130, 301 };
+	for (unsigned int s = 0; s < sizeof(sizes)/sizeof(int); ++s) {
+		CKTable		a = makeTable(sizes[s], 7, 0, 3);
+		CKTable		b = makeTable(sizes[s], 7, 0, 11);
+		CKTable		tail = makeTable(sizes[s], 7, sizes[s] / 2, 5);
+
+		CKTable::setParallelThreshold(0);
+		Results		serial;
+		runAll(a, b, tail, serial);
+
+		CKTable::setParallelExecutor(&aPool);
+		CKTable::setParallelThreshold(1);
+		Results		run;
+		runAll(a, b, tail, run);
+		CKTable::setParallelExecutor(NULL);
+
+		char	name[64];
+		snprintf(name, sizeof(name), "%dx7", sizes[s]);
+		problems += check(run, serial, name);
+		if (serial.parsed != a) {
+			std::cout << "PROBLEM! The code of " << name << " didn't round-trip." << std::endl;
+			++problems;
+		}
+	}
+	return problems;
+}
+
+
+int main(int argc, char *argv[]) {
+	int		rows = (argc > 1 ? atoi(argv[1]) : 20000);
+	int		cols = (argc > 2 ? atoi(argv[2]) : 50);
+	int		maxThreads = (argc > 3 ? atoi(argv[3]) : CKExecutor::getNumberOfProcessors());
+	if (maxThreads < 4) {
+		maxThreads = 4;
+	}
+
+	int		problems = 0;
+	try {
+		CKExecutor	pool(3);
+		problems += checkSmall(pool);
+		if (problems == 0) {
+			std::cout << "The small tables are OK." << std::endl;
+		}
+
+		// the big tables are done on the calling thread, and then on each pool
+		CKTable		a = makeTable(rows, cols, 0, 3);
+		CKTable		b = makeTable(rows, cols, 0, 11);
+		CKTable		tail = makeTable(rows / 2, cols, rows / 4, 5);
+
+		CKTable::setParallelThreshold(0);
+		Results		serial;
+		runAll(a, b, tail, serial);
+
+		std::vector<Results>	runs(maxThreads);
+		for (int n = 1; n <= maxThreads; ++n) {
+			CKExecutor	threads(n);
+			CKTable::setParallelExecutor(&threads);
+			CKTable::setParallelThreshold(1);
+			runAll(a, b, tail, runs[n - 1]);
+			CKTable::setParallelExecutor(NULL);
+
+			char	name[64];
+			snprintf(name, sizeof(name), "%d threads", n);
+			problems += check(runs[n - 1], serial, name);
+		}
+
+		const char	*ops[] = { "row-major math", "columnar math", "merge",
+							   "generateCode", "takeValues", "operator==" };
+		std::cout << "On a " << rows << "x" << cols << " table with " <<
+			CKExecutor::getNumberOfProcessors() << " processors (ms):" << std::endl;
+		std::cout << std::setw(16) << "" << std::setw(9) << "serial";
+		for (int n = 1; n <= maxThreads; ++n) {
+			std::cout << std::setw(8) << n << "t";
+		}
+		std::cout << std::endl << std::fixed << std::setprecision(1);
+		for (int op = 0; op < 6; ++op) {
+			std::cout << std::setw(16) << ops[op] << std::setw(9) <<
+				(serial.times[op] * 1000.0);
+			for (int n = 1; n <= maxThreads; ++n) {
+				std::cout << std::setw(9) << (runs[n - 1].times[op] * 1000.0);
+			}
+			std::cout << std::endl;
+		}
+	} catch (CKException & e) {
+		problems += problem(e);
+	}
+
+	return finish(problems, "The split up operations all match the calling thread.");
+}
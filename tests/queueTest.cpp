@@ -9,6 +9,7 @@
 #include "CKLIFOCoalescingQueue.h"
 #include "CKFIFOQueue.h"
 #include "CKFIFOCoalescingQueue.h"
+#include "CKDelayQueue.h"
 
 int main(int argc, char *argv[]) {
 	CKFIFOQueue<int>	a;
@@ -24,6 +25,16 @@ int main(int argc, char *argv[]) {
 		std::cout << "a had: " << a.pop() << std::endl;
 	}
 
+	a.push(5);
+	a.push(6);
+	a.push(7);
+	CKVector<int>	some = a.popBatch(2, 0);
+	std::cout << "a batch had: " << some.size() << " elements" << std::endl;
+	some = a.popBatch(2, 0);
+	std::cout << "a batch had: " << some.size() << " elements" << std::endl;
+	some = a.popBatch(2, 100);
+	std::cout << "a batch (timed out) had: " << some.size() << " elements" << std::endl;
+
 	CKLIFOCoalescingQueue<int, CKString>	b;
 	b.push(1,"pig");
 	b.push(2,"cow");
@@ -33,4 +44,69 @@ int main(int argc, char *argv[]) {
 	while (!b.empty()) {
 		std::cout << "b had: " << b.pop() << std::endl;
 	}
+
+	CKFIFOCoalescingQueue<int, CKString>	c;
+	c.enableStatistics("c");
+	c.push(1,"pig");
+	c.push(2,"cow");
+	c.push(3,"cat");
+	c.push(1,"dog");
+	c.push(4,"rat");
+	std::cout << "c.size = " << c.size() << std::endl;
+	CKVector<CKString>	batch;
+	std::cout << "c drained: " << c.drain(batch, 2) << std::endl;
+	std::cout << "c drained: " << c.drain(batch) << std::endl;
+	for (int i = 0; i < batch.size(); ++i) {
+		std::cout << "c had: " << batch[i] << std::endl;
+	}
+	std::cout << "c.size = " << c.size() << std::endl;
+	std::cout << "c coalesced: " << c.getStatistics()->getCoalesceCount() << std::endl;
+
+	CKFIFOQueue<int>	e;
+	e.enableStatistics("e");
+	for (int i = 0; i < 20; ++i) {
+		e.push(i);
+	}
+	e.pop(15);
+	std::cout << CKQueueStats::dumpAll();
+	// turning them off just stops the counting - the stats stay put
+	const CKQueueStats	*es = e.getStatistics();
+	e.disableStatistics();
+	e.push(20);
+	std::cout << "e enqueued while off: " << es->getEnqueueCount() << std::endl;
+	e.enableStatistics("e");
+	e.push(21);
+	std::cout << "e enqueued back on: " << es->getEnqueueCount() <<
+		(e.getStatistics() == es ? " (same stats)" : " (new stats!)") << std::endl;
+
+	// the total wait has to hold more than 2^32 usec - about 71 minutes
+	CKQueueStats	w("w");
+	for (int i = 0; i < 3; ++i) {
+		w.dequeued(-1, 3000.0);
+	}
+	std::cout << "w total wait (sec): " << (long)w.getTotalWaitTime() << std::endl;
+
+	CKDelayQueue<CKString>	d;
+	d.schedule("later", 200);
+	CKDelayQueueHandle		h = d.schedule("never", 100);
+	d.schedule("sooner", 50);
+	d.schedule("urgent", 50, 10);
+	std::cout << d.toString() << std::endl;
+	std::cout << "d cancelled: " << d.cancel(h) << std::endl;
+	std::cout << "d cancelled again: " << d.cancel(h) << std::endl;
+	CKString	val;
+	std::cout << "d polled early: " << d.poll(val) << std::endl;
+	while (!d.empty()) {
+		std::cout << "d had: " << d.take() << std::endl;
+	}
+	std::cout << "d timed out: " << !d.take(val, 20) << std::endl;
+	std::cout << d.toString() << std::endl;
+
+	CKPriorityQueue<int>	p;
+	p.push(1, 1);
+	p.push(2, 5);
+	p.push(3, 1);
+	while (!p.empty()) {
+		std::cout << "p had: " << p.take() << std::endl;
+	}
 }
@@ -0,0 +1,133 @@
+/*
+ * This is a test program that measures the read throughput of the plain
+ * CKFWRWMutex and the CKFWShardedRWMutex from one thread up to twice the
+ * number of CPUs, with a writer coming in every now and then. Run it as:
+ *
+ *     rwmutexBench [seconds per run]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+#include "CKFWRWMutex.h"
+#include "CKFWShardedRWMutex.h"
+#include "CKStackLocker.h"
+
+/*
+ * This is what all the readers are reading and the one writer is
+ * updating - the writer keeps the two values the same, so if a reader
+ * ever sees them different, the lock isn't doing its job.
+ */
+static volatile long	sFirst = 0;
+static volatile long	sSecond = 0;
+static volatile bool	sRunning = false;
+static volatile bool	sBroken = false;
+
+
+struct Reader {
+	CKFWRWMutex		*mutex;
+	pthread_t		thread;
+	long			reads;
+};
+
+
+static void *readLoop( void *anArg )
+{
+	Reader	*me = (Reader *)anArg;
+	while (sRunning) {
+		CKStackLocker	lockem(me->mutex);
+		if (sFirst != sSecond) {
+			sBroken = true;
+		}
+		++me->reads;
+	}
+	return NULL;
+}
+
+
+static void *writeLoop( void *anArg )
+{
+	CKFWRWMutex		*mutex = (CKFWRWMutex *)anArg;
+	while (sRunning) {
+		{
+			CKStackLocker	lockem(mutex, false);
+			++sFirst;
+			++sSecond;
+		}
+		usleep(10000);
+	}
+	return NULL;
+}
+
+
+static double now()
+{
+	timeval		tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec/1000000.0;
+}
+
+
+/*
+ * This runs the given number of readers against the mutex for the
+ * given time and returns the reads per second.
+ */
+static double run( CKFWRWMutex *aMutex, int aThreadCount, double aSeconds )
+{
+	Reader		*readers = new Reader[aThreadCount];
+	pthread_t	writer;
+
+	sRunning = true;
+	double	start = now();
+	for (int i = 0; i < aThreadCount; ++i) {
+		readers[i].mutex = aMutex;
+		readers[i].reads = 0;
+		pthread_create(&readers[i].thread, NULL, readLoop, &readers[i]);
+	}
+	pthread_create(&writer, NULL, writeLoop, aMutex);
+	usleep((useconds_t)(aSeconds * 1000000));
+	sRunning = false;
+
+	long	total = 0;
+	for (int i = 0; i < aThreadCount; ++i) {
+		pthread_join(readers[i].thread, NULL);
+		total += readers[i].reads;
+	}
+	pthread_join(writer, NULL);
+	double	elapsed = now() - start;
+	delete [] readers;
+
+	return total / elapsed;
+}
+
+
+int main(int argc, char *argv[]) {
+	double	seconds = (argc > 1 ? atof(argv[1]) : 0.5);
+	int		cpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+	CKFWRWMutex			plain;
+	CKFWShardedRWMutex	sharded;
+	std::cout << "sharded mutex has " << sharded.getShardCount() << " shards" << std::endl;
+	std::cout << "threads    pthread reads/s    sharded reads/s    speedup" << std::endl;
+	// go up by powers of two to the number of CPUs, and then twice that
+	int		n = 1;
+	while (true) {
+		double	p = run(&plain, n, seconds);
+		double	s = run(&sharded, n, seconds);
+		std::cout << std::setw(7) << n << std::setw(19) << (long)p <<
+			std::setw(19) << (long)s << std::setw(11) << std::setprecision(3) <<
+			(s / p) << std::endl;
+		if (n >= 2 * cpus) {
+			break;
+		}
+		n = (2 * n < cpus ? 2 * n : (n < cpus ? cpus : 2 * cpus));
+	}
+
+	std::cout << "consistency " << (sBroken ? "FAILED" : "passed") << std::endl;
+	return 0;
+}
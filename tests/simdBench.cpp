@@ -0,0 +1,350 @@
+/*
+ * This is a test program for the vector kernels behind the math on the
+ * dense columns of a CKTable. It checks that the AVX2 kernels give just
+ * what the plain loops do - NANs, infinities, holes in the bitmaps, odd
+ * lengths and all - and that the point by point math on time series is
+ * still right. It then times the math on two big tables of numbers with
+ * the kernels on and off, and on a row-major table for comparison. Run
+ * it as:
+ *
+ *     simdBench [rows] [cols] [passes]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <string>
+#include <vector>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "CKVectorMath.h"
+#include "CKTable.h"
+#include "CKTimeSeries.h"
+#include "CKString.h"
+#include "CKException.h"
+#include "benchUtils.h"
+
+/*
+ * These are two doubles that are the same, where all NANs are the same.
+ */
+static bool same( double a, double b )
+{
+	return ((isnan(a) && isnan(b)) || (a == b));
+}
+
+
+/*
+ * This fills the array with numbers, and every so often a zero, a NAN
+ * or an infinity.
+ */
+static void fillOdd( std::vector<double> & anArray, int aSeed )
+{
+	for (int i = 0; i < (int)anArray.size(); ++i) {
+		switch ((i * 7 + aSeed) % 13) {
+			case 0:		anArray[i] = 0.0;			break;
+			case 1:		anArray[i] = NAN;			break;
+			case 2:		anArray[i] = INFINITY;		break;
+			case 3:		anArray[i] = -INFINITY;		break;
+			default:	anArray[i] = (i - 50) * 0.37 + aSeed;	break;
+		}
+	}
+}
+
+
+/*
+ * This runs one of the kernels with AVX2 and without on the same data,
+ * at the given offset into the arrays so they aren't always aligned,
+ * and returns 1 if the two don't agree.
+ */
+static int checkKernel( char anOp, int aKind, int aCount, int anOffset )
+{
+	// one extra at the end so even an empty run has an array to point at
+	std::vector<double>			a(aCount + anOffset + 1);
+	std::vector<double>			b(aCount + anOffset + 1);
+	std::vector<unsigned char>	va((aCount + 7) / 8 + 1);
+	std::vector<unsigned char>	vb((aCount + 7) / 8 + 1);
+	fillOdd(a, 1);
+	fillOdd(b, 5);
+	for (int i = 0; i < (int)va.size(); ++i) {
+		va[i] = (i % 3 == 0 ? 0xff : (unsigned char)(0x5a + i));
+		vb[i] = (i % 4 == 1 ? (unsigned char)0xf7 : 0xff);
+	}
+
+	std::vector<double>		results[2];
+	for (int simd = 0; simd < 2; ++simd) {
+		std::vector<double>		v(a);
+		CKVectorMath::setUseSIMD(simd == 1);
+		switch (aKind) {
+			case 0:
+				CKVectorMath::apply(anOp, &v[anOffset], aCount, 2.5);
+				break;
+			case 1:
+				CKVectorMath::apply(anOp, &v[anOffset], &b[anOffset], aCount);
+				break;
+			case 2:
+				CKVectorMath::apply(anOp, &v[anOffset], &va[0], &b[anOffset], &vb[0], aCount);
+				break;
+			case 3:
+				CKVectorMath::inverse(&v[anOffset], aCount);
+				break;
+		}
+		results[simd] = v;
+	}
+	CKVectorMath::setUseSIMD(true);
+
+	for (int i = 0; i < aCount + anOffset; ++i) {
+		// the plain loops have to be right, too
+		double	want = a[i];
+		if (i >= anOffset) {
+			int		k = i - anOffset;
+			double	arg = (aKind == 0 ? 2.5 : b[i]);
+			bool	doIt = ((aKind != 2) ||
+						(((va[k >> 3] & vb[k >> 3]) >> (k & 7)) & 1));
+			if (aKind == 3) {
+				want = 1.0 / a[i];
+			} else if (doIt) {
+				switch (anOp) {
+					case '+':	want = a[i] + arg;	break;
+					case '-':	want = a[i] - arg;	break;
+					case '*':	want = a[i] * arg;	break;
+					case '/':	want = a[i] / arg;	break;
+				}
+			}
+		}
+		if (!same(results[0][i], want) || !same(results[1][i], want)) {
+			std::cout << "PROBLEM! The kernel '" << anOp << "' of kind " << aKind <<
+				" on " << aCount << " at " << anOffset << " gave " << results[0][i] <<
+				" and " << results[1][i] << " at " << i << " and not " << want << std::endl;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+
+/*
+ * This checks the point by point math on two time series against the
+ * simple map lookups it used to be, and returns 1 if it's off.
+ */
+static int checkSeries( char anOp, int aMine, int aHis, int aStride )
+{
+	CKTimeSeries				mine;
+	CKTimeSeries				his;
+	std::map<double, double>	want;
+	std::map<double, double>	theirs;
+	for (int i = 0; i < aMine; ++i) {
+		double	d = 20000101.0 + i * 2;
+		mine.put(d, i * 0.5);
+		want[d] = i * 0.5;
+	}
+	for (int i = 0; i < aHis; ++i) {
+		double	d = 20000100.0 + i * aStride;
+		his.put(d, i + 1.0);
+		theirs[d] = i + 1.0;
+	}
+	for (std::map<double, double>::iterator i = theirs.begin(); i != theirs.end(); ++i) {
+		std::map<double, double>::iterator	j = want.find((*i).first);
+		if (j != want.end()) {
+			switch (anOp) {
+				case '+':	(*j).second += (*i).second;	break;
+				case '-':	(*j).second -= (*i).second;	break;
+				case '*':	(*j).second *= (*i).second;	break;
+				case '/':	(*j).second /= (*i).second;	break;
+			}
+		} else if (anOp == '+') {
+			want[(*i).first] = (*i).second;
+		} else if (anOp == '-') {
+			want[(*i).first] = -1.0 * (*i).second;
+		}
+	}
+	switch (anOp) {
+		case '+':	mine.add(his);		break;
+		case '-':	mine.subtract(his);	break;
+		case '*':	mine.multiply(his);	break;
+		case '/':	mine.divide(his);	break;
+	}
+
+	CKTimeSeries	expected;
+	for (std::map<double, double>::iterator i = want.begin(); i != want.end(); ++i) {
+		expected.put((*i).first, (*i).second);
+	}
+	if (mine != expected) {
+		std::cout << "PROBLEM! The time series '" << anOp << "' of " << aMine <<
+			" and " << aHis << " points every " << aStride << " isn't right." << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+
+/*
+ * This checks the kernels, the tables and the time series, and returns
+ * the number of problems.
+ */
+static int checkAll()
+{
+	int			problems = 0;
+	const char	*ops = "+-*/";
+
+	for (int o = 0; o < 4; ++o) {
+		for (int kind = 0; kind < 4; ++kind) {
+			for (int cnt = 0; cnt < 40; ++cnt) {
+				problems += checkKernel(ops[o], kind, cnt, cnt % 3);
+			}
+			problems += checkKernel(ops[o], kind, 1027, 1);
+		}
+	}
+
+	// a bad operation is caught
+	try {
+		double	x = 1.0;
+		CKVectorMath::apply('%', &x, 1, 2.0);
+		std::cout << "PROBLEM! The operation '%' was done." << std::endl;
+		++problems;
+	} catch (CKException & e) {
+		// this is what we want
+	}
+
+	// the columnar tables get the same answers as the row-major ones
+	CKTable		rows(37, 3);
+	CKTable		cols(37, 3, eNumberVariant);
+	CKTable		other(37, 3);
+	for (int i = 0; i < 37; ++i) {
+		for (int j = 0; j < 3; ++j) {
+			double	v = ((i + j) % 11 == 0 ? NAN : (i - 18) * 0.25 + j);
+			if ((i + j) % 7 != 3) {
+				rows.setDoubleValue(i, j, v);
+				cols.setDoubleValue(i, j, v);
+			}
+			if ((i * j) % 5 != 4) {
+				other.setDoubleValue(i, j, i + 0.5);
+			}
+		}
+	}
+	CKTable		denseOther(other);
+	denseOther.setColumnar(true);
+	rows.multiply(1.5);		cols.multiply(1.5);
+	rows.subtract(other);	cols.subtract(denseOther);
+	rows.inverse();			cols.inverse();
+	rows.divide(other);		cols.divide(denseOther);
+	if (rows.generateCodeFromValues() != cols.generateCodeFromValues()) {
+		std::cout << "PROBLEM! The columnar table didn't get the same answers:" <<
+			std::endl << rows << std::endl << cols << std::endl;
+		++problems;
+	}
+
+	// the point by point time series math, with all kinds of overlap
+	for (int o = 0; o < 4; ++o) {
+		problems += checkSeries(ops[o], 100, 100, 1);
+		problems += checkSeries(ops[o], 100, 30, 2);
+		problems += checkSeries(ops[o], 5000, 10, 997);
+		problems += checkSeries(ops[o], 10, 500, 3);
+		problems += checkSeries(ops[o], 0, 20, 1);
+		problems += checkSeries(ops[o], 20, 0, 1);
+	}
+
+	return problems;
+}
+
+
+/*
+ * This does a pass of the math on the table - each of the scalar
+ * operations, the inverse, and adding and multiplying by the other
+ * table - and returns the time it took.
+ */
+static double mathPass( CKTable & aTable, const CKTable & anOther )
+{
+	double	start = now();
+	aTable.multiply(1.0001);
+	aTable.add(0.5);
+	aTable.inverse();
+	aTable.add(anOther);
+	aTable.multiply(anOther);
+	return (now() - start);
+}
+
+
+int main(int argc, char *argv[]) {
+	int		rows = (argc > 1 ? atoi(argv[1]) : 10000);
+	int		cols = (argc > 2 ? atoi(argv[2]) : 1000);
+	int		passes = (argc > 3 ? atoi(argv[3]) : 5);
+
+	int		problems = 0;
+	try {
+		problems = checkAll();
+	} catch (CKException & e) {
+		problems += problem(e);
+	}
+	if (problems == 0) {
+		std::cout << "The kernels are OK." << std::endl;
+	}
+	std::cout << "The AVX2 kernels are " << (CKVectorMath::useSIMD() ? "" : "NOT ") <<
+		"being used." << std::endl;
+
+	// two big columnar tables of numbers
+	CKTable		table(rows, cols, eNumberVariant);
+	CKTable		other(rows, cols, eNumberVariant);
+	for (int i = 0; i < rows; ++i) {
+		for (int j = 0; j < cols; ++j) {
+			table.setDoubleValue(i, j, 1.0 + (i % 97) * 0.01 + j);
+			other.setDoubleValue(i, j, 2.0 - (j % 89) * 0.01);
+		}
+	}
+
+	// ...with the kernels on and off
+	double		times[2] = { 0.0, 0.0 };
+	for (int p = 0; p < passes; ++p) {
+		for (int simd = 0; simd < 2; ++simd) {
+			CKVectorMath::setUseSIMD(simd == 1);
+			times[simd] += mathPass(table, other);
+		}
+	}
+	CKVectorMath::setUseSIMD(true);
+
+	// ...and a row-major table with a tenth of the columns to compare
+	int			smallCols = (cols >= 10 ? cols / 10 : 1);
+	CKTable		rowTable(rows, smallCols);
+	CKTable		rowOther(rows, smallCols);
+	for (int i = 0; i < rows; ++i) {
+		for (int j = 0; j < smallCols; ++j) {
+			rowTable.setDoubleValue(i, j, 1.0 + (i % 97) * 0.01 + j);
+			rowOther.setDoubleValue(i, j, 2.0 - (j % 89) * 0.01);
+		}
+	}
+	double		rowTime = 0.0;
+	for (int p = 0; p < passes; ++p) {
+		rowTime += mathPass(rowTable, rowOther);
+	}
+
+	// ...and a couple of big time series added point by point
+	CKTimeSeries	series;
+	CKTimeSeries	deltas;
+	for (int i = 0; i < rows * 10; ++i) {
+		series.put(20000101.0 + i, i * 0.5);
+		deltas.put(20000101.0 + i + (i % 2), 1.0);
+	}
+	double		start = now();
+	series.add(deltas);
+	series.multiply(deltas);
+	double		seriesTime = now() - start;
+
+	double	cells = (double)rows * cols * passes * 5;
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << "Five operations on a " << rows << "x" << cols << " table:" << std::endl;
+	std::cout << "  AVX2 kernels:  " << (times[1] * 1e9 / cells) << " ns/cell (" <<
+		(cells / times[1] / 1e6) << "M cells/sec)" << std::endl;
+	std::cout << "  plain loops:   " << (times[0] * 1e9 / cells) << " ns/cell (" <<
+		(cells / times[0] / 1e6) << "M cells/sec)" << std::endl;
+	double	rowCells = (double)rows * smallCols * passes * 5;
+	std::cout << "  row-major:     " << (rowTime * 1e9 / rowCells) << " ns/cell (" <<
+		(rowCells / rowTime / 1e6) << "M cells/sec)" << std::endl;
+	std::cout << std::setprecision(1) << "The kernels were " << (times[0] / times[1]) <<
+		"x the plain loops and " << ((rowTime / rowCells) / (times[1] / cells)) <<
+		"x the row-major table." << std::endl;
+	std::cout << std::setprecision(3) << "Adding and multiplying two series of " <<
+		(rows * 10) << " points took " << seriesTime << " sec." << std::endl;
+
+	return finish(problems);
+}
@@ -0,0 +1,603 @@
+/*
+ * This is a test program for sorting, filtering and grouping CKTables.
+ * It checks getSortedRows(), sortBy(), getRowsMatching(), filter(),
+ * selectRows(), getRows() and groupBy().aggregate() against simple
+ * versions done a cell at a time here - in both layouts, and split up on
+ * a pool of threads - and then times each on a big table next to pulling
+ * the values out into STL containers and doing it there. Run it as:
+ *
+ *     tableQueryBench [rows] [threads]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "CKTable.h"
+#include "CKTableGroups.h"
+#include "CKExecutor.h"
+#include "CKString.h"
+#include "CKException.h"
+#include "benchUtils.h"
+
+/*
+ * These are the columns of the test tables.
+ */
+#define	SYM		0
+#define	QTY		1
+#define	PX		2
+#define	BUCKET	3
+
+/*
+ * This makes a table that looks like a blotter - a symbol, a quantity
+ * that's sometimes missing or not a number, a price in quarters, and a
+ * bucket number. The price and bucket are always numbers, so they go
+ * dense in a columnar table.
+ */
+static CKTable makeTable( int aRows, int aSeed )
+{
+	char		buff[64];
+	CKTable		table(aRows, 4);
+	table.setColumnHeader(SYM, "sym");
+	table.setColumnHeader(QTY, "qty");
+	table.setColumnHeader(PX, "px");
+	table.setColumnHeader(BUCKET, "bucket");
+	unsigned int	r = aSeed;
+	for (int i = 0; i < aRows; ++i) {
+		r = r * 1103515245 + 12345;
+		unsigned int	v = (r >> 8);
+		snprintf(buff, sizeof(buff), "id%d", i);
+		table.setRowLabel(i, buff);
+		if ((v % 31) != 0) {
+			// some symbols are long, and only differ after the first few bytes
+			snprintf(buff, sizeof(buff), ((v % 3) == 0 ? "SYMBOL%u" : "S%u"), (v >> 4) % 50);
+			table.setStringValue(i, SYM, buff);
+		}
+		if ((v % 17) == 0) {
+			table.setStringValue(i, QTY, "n/a");
+		} else if ((v % 13) != 0) {
+			table.setDoubleValue(i, QTY, (double)((v >> 6) % 100));
+		}
+		table.setDoubleValue(i, PX, 10.0 + ((v >> 10) % 400) * 0.25);
+		table.setDoubleValue(i, BUCKET, (double)((v >> 3) % 10));
+	}
+	return table;
+}
+
+
+/*
+ * This is the order the sort should give - done with getType() and the
+ * getters on each cell, and a stable sort.
+ */
+struct RefOrder {
+	const CKTable	*table;
+	int				cols[2];
+	bool			asc[2];
+	int				keys;
+
+	int kind( int aRow, int aCol ) const
+	{
+		CKVariantType	t = table->getType(aRow, aCol);
+		if (t == eUnknownVariant) {
+			return 2;
+		}
+		return ((t == eNumberVariant) || (t == eDateVariant) ? 0 : 1);
+	}
+
+	bool operator()( int a, int b ) const
+	{
+		for (int k = 0; k < keys; ++k) {
+			int		ka = kind(a, cols[k]);
+			int		kb = kind(b, cols[k]);
+			if (ka != kb) {
+				return (ka < kb);
+			}
+			if (ka == 0) {
+				double	x = table->getDoubleValue(a, cols[k]);
+				double	y = table->getDoubleValue(b, cols[k]);
+				if (x != y) {
+					return (asc[k] ? (x < y) : (x > y));
+				}
+			} else if (ka == 1) {
+				std::string	x = table->getStringValue(a, cols[k])->c_str();
+				std::string	y = table->getStringValue(b, cols[k])->c_str();
+				if (x != y) {
+					return (asc[k] ? (x < y) : (x > y));
+				}
+			}
+		}
+		return false;
+	}
+};
+
+
+static std::vector<int> refSort( const CKTable & aTable, int aCol1, bool anAsc1,
+								 int aCol2 = -1, bool anAsc2 = true )
+{
+	RefOrder	order;
+	order.table = &aTable;
+	order.cols[0] = aCol1;
+	order.asc[0] = anAsc1;
+	order.cols[1] = aCol2;
+	order.asc[1] = anAsc2;
+	order.keys = (aCol2 < 0 ? 1 : 2);
+	std::vector<int>	rows(aTable.getNumRows());
+	for (int i = 0; i < (int)rows.size(); ++i) {
+		rows[i] = i;
+	}
+	std::stable_sort(rows.begin(), rows.end(), order);
+	return rows;
+}
+
+
+/*
+ * This is the filter for the rows of one symbol.
+ */
+class SymbolFilter :
+	public ICKTableRowFilter
+{
+	public:
+		SymbolFilter( const char *aSymbol ) : mSymbol(aSymbol) { }
+		virtual bool keepRow( const CKTable & aTable, int aRow ) const
+		{
+			return ((aTable.getType(aRow, SYM) == eStringVariant) &&
+					(*aTable.getStringValue(aRow, SYM) == mSymbol));
+		}
+
+	private:
+		CKString	mSymbol;
+};
+
+
+/*
+ * These compare a CKVector of rows with the STL one, and a table with
+ * the rows of another it should have in it.
+ */
+static bool sameRows( const CKVector<int> & aRows, const std::vector<int> & anExpected )
+{
+	if (aRows.size() != (int)anExpected.size()) {
+		return false;
+	}
+	for (int i = 0; i < aRows.size(); ++i) {
+		if (aRows[i] != anExpected[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+static bool hasRows( const CKTable & aTable, const CKTable & aSource,
+					 const std::vector<int> & aRows )
+{
+	if ((aTable.getNumRows() != (int)aRows.size()) ||
+		(aTable.getNumColumns() != aSource.getNumColumns())) {
+		return false;
+	}
+	for (int i = 0; i < (int)aRows.size(); ++i) {
+		// a label that's there twice is found at one of them
+		const CKString	& label = aTable.getRowLabel(i);
+		if ((label != aSource.getRowLabel(aRows[i])) ||
+			(aTable.getRowLabel(aTable.getRowForLabel(label)) != label)) {
+			return false;
+		}
+		for (int j = 0; j < aTable.getNumColumns(); ++j) {
+			if (aTable.getValue(i, j) != aSource.getValue(aRows[i], j)) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+
+/*
+ * This is the key a cell is grouped by, done here the long way - its
+ * type, and then its value, with -0 the same as 0. An empty cell has
+ * no type at all, so it's never the same as an empty string.
+ */
+static std::string refKey( const CKTable & aTable, int aRow, int aCol )
+{
+	char	buff[64];
+	switch (aTable.getType(aRow, aCol)) {
+		case eUnknownVariant:
+			return "";
+		case eNumberVariant:
+			{
+				double	x = aTable.getDoubleValue(aRow, aCol);
+				snprintf(buff, sizeof(buff), "n%.15g", (x == 0.0 ? 0.0 : x));
+			}
+			return buff;
+		case eDateVariant:
+			snprintf(buff, sizeof(buff), "d%ld", aTable.getDateValue(aRow, aCol));
+			return buff;
+		default:
+			return std::string("s") + aTable.getStringValue(aRow, aCol)->c_str();
+	}
+}
+
+
+/*
+ * This is the label the group for the key gets - just its value.
+ */
+static std::string refLabel( const std::string & aKey )
+{
+	return (aKey.empty() ? aKey : aKey.substr(1));
+}
+
+
+/*
+ * This checks one aggregate of one column against doing it with maps.
+ */
+static int checkAggregate( const CKTable & aTable, int aGroupCol, int aCol,
+						   CKTableAggregate anOp, const char *aName )
+{
+	std::vector<std::string>		order;
+	std::map<std::string, double>	sums;
+	std::map<std::string, double>	mins;
+	std::map<std::string, double>	maxs;
+	std::map<std::string, int>		counts;
+	for (int i = 0; i < aTable.getNumRows(); ++i) {
+		std::string	key = refKey(aTable, i, aGroupCol);
+		if (counts.find(key) == counts.end()) {
+			order.push_back(key);
+			counts[key] = 0;
+			sums[key] = 0.0;
+		}
+		if (aTable.getType(i, aCol) == eNumberVariant) {
+			double	x = aTable.getDoubleValue(i, aCol);
+			if ((counts[key] == 0) || (x < mins[key])) {
+				mins[key] = x;
+			}
+			if ((counts[key] == 0) || (x > maxs[key])) {
+				maxs[key] = x;
+			}
+			sums[key] += x;
+			++counts[key];
+		}
+	}
+
+	CKTable		result = aTable.groupBy(aGroupCol).aggregate(aCol, anOp);
+	if ((result.getNumRows() != (int)order.size()) || (result.getNumColumns() != 1) ||
+		(result.getColumnHeader(0) != aTable.getColumnHeader(aCol))) {
+		std::cout << "PROBLEM! The " << aName << " aggregate was " <<
+			result.getNumRows() << "x" << result.getNumColumns() << " and not " <<
+			order.size() << "x1." << std::endl;
+		return 1;
+	}
+	for (int g = 0; g < (int)order.size(); ++g) {
+		const std::string	& key = order[g];
+		bool	has = true;
+		double	expected = 0.0;
+		switch (anOp) {
+			case eSumAggregate:		expected = sums[key]; break;
+			case eCountAggregate:	expected = counts[key]; break;
+			case eMeanAggregate:	has = (counts[key] > 0);
+									expected = (has ? sums[key] / counts[key] : 0.0); break;
+			case eMinAggregate:		has = (counts[key] > 0); expected = mins[key]; break;
+			case eMaxAggregate:		has = (counts[key] > 0); expected = maxs[key]; break;
+		}
+		if ((result.getRowLabel(g) != refLabel(key).c_str()) ||
+			(has != (result.getType(g, 0) == eNumberVariant)) ||
+			(has && (result.getDoubleValue(g, 0) != expected))) {
+			std::cout << "PROBLEM! The " << aName << " aggregate of group '" << key <<
+				"' was wrong." << std::endl;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+
+/*
+ * This checks all the operations on one table against the simple
+ * versions.
+ */
+static int checkAll( const CKTable & aTable, const char *aName )
+{
+	int		problems = 0;
+
+	// sorting one column each way, and two columns
+	if (!sameRows(aTable.getSortedRows(PX), refSort(aTable, PX, true)) ||
+		!sameRows(aTable.getSortedRows(QTY, false), refSort(aTable, QTY, false)) ||
+		!sameRows(aTable.getSortedRows(SYM), refSort(aTable, SYM, true))) {
+		std::cout << "PROBLEM! The sorted rows of the " << aName << " table were wrong." << std::endl;
+		++problems;
+	}
+	CKVector<int>	cols;
+	CKVector<bool>	asc;
+	cols.addToEnd(SYM);
+	cols.addToEnd(QTY);
+	asc.addToEnd(true);
+	asc.addToEnd(false);
+	std::vector<int>	expected = refSort(aTable, SYM, true, QTY, false);
+	if (!sameRows(aTable.getSortedRows(cols, asc), expected)) {
+		std::cout << "PROBLEM! The two-column sort of the " << aName << " table was wrong." << std::endl;
+		++problems;
+	}
+	CKTable		sorted = aTable;
+	sorted.sortBy(cols, asc);
+	if (!hasRows(sorted, aTable, expected) ||
+		(sorted.isColumnar() != aTable.isColumnar())) {
+		std::cout << "PROBLEM! The sortBy() of the " << aName << " table was wrong." << std::endl;
+		++problems;
+	}
+
+	// filtering with a test, and with a filter
+	std::vector<int>	cheap;
+	std::vector<int>	s7;
+	for (int i = 0; i < aTable.getNumRows(); ++i) {
+		if ((aTable.getType(i, QTY) == eNumberVariant) && (aTable.getDoubleValue(i, QTY) >= 50.0)) {
+			cheap.push_back(i);
+		}
+		if ((aTable.getType(i, SYM) == eStringVariant) && (*aTable.getStringValue(i, SYM) == "S7")) {
+			s7.push_back(i);
+		}
+	}
+	SymbolFilter	filter("S7");
+	if (!sameRows(aTable.getRowsMatching(QTY, eGreaterOrEqualTest, 50.0), cheap) ||
+		!sameRows(aTable.getRowsMatching(filter), s7)) {
+		std::cout << "PROBLEM! The matching rows of the " << aName << " table were wrong." << std::endl;
+		++problems;
+	}
+	CKTable		filtered = aTable;
+	filtered.filter(filter);
+	if (!hasRows(filtered, aTable, s7)) {
+		std::cout << "PROBLEM! The filter() of the " << aName << " table was wrong." << std::endl;
+		++problems;
+	}
+
+	// nothing passing leaves the columns, and rows can come back
+	CKTable		none = aTable;
+	none.filter(PX, eLessThanTest, 0.0);
+	CKTable		copy = none;
+	if ((none.getNumRows() != 0) || (copy.getNumRows() != 0) ||
+		(copy.getNumColumns() != 4) || (copy.getColumnForHeader("px") != PX)) {
+		std::cout << "PROBLEM! The empty " << aName << " table was " <<
+			none.getNumRows() << "x" << none.getNumColumns() << "." << std::endl;
+		++problems;
+	} else {
+		copy.appendRow("new");
+		copy.setDoubleValue("new", "px", 1.5);
+		if ((copy.getNumRows() != 1) || (copy.getDoubleValue(0, PX) != 1.5)) {
+			std::cout << "PROBLEM! A row couldn't be added to the empty " << aName <<
+				" table." << std::endl;
+			++problems;
+		}
+	}
+
+	// taking rows more than once
+	std::vector<int>	picks;
+	picks.push_back(aTable.getNumRows() - 1);
+	picks.push_back(0);
+	picks.push_back(aTable.getNumRows() - 1);
+	picks.push_back(aTable.getNumRows() / 2);
+	CKVector<int>		pickList;
+	for (unsigned int i = 0; i < picks.size(); ++i) {
+		pickList.addToEnd(picks[i]);
+	}
+	CKTable		picked = aTable;
+	picked.selectRows(pickList);
+	if (!hasRows(picked, aTable, picks) || !hasRows(aTable.getRows(pickList), aTable, picks)) {
+		std::cout << "PROBLEM! The picked rows of the " << aName << " table were wrong." << std::endl;
+		++problems;
+	}
+
+	// grouping by a string column and a number column
+	const char	*ops[] = { "sum", "mean", "min", "max", "count" };
+	for (int op = eSumAggregate; op <= eCountAggregate; ++op) {
+		char	name[64];
+		snprintf(name, sizeof(name), "%s %s", aName, ops[op]);
+		problems += checkAggregate(aTable, SYM, QTY, (CKTableAggregate)op, name);
+		problems += checkAggregate(aTable, BUCKET, PX, (CKTableAggregate)op, name);
+	}
+	CKTableGroups	groups = aTable.groupBy("sym");
+	CKTable			all = groups.aggregate(eSumAggregate);
+	if ((all.getNumColumns() != 3) || (all.getColumnHeader(0) != "qty") ||
+		(all.getNumRows() != groups.getNumGroups()) ||
+		(groups.getRowsInGroup(groups.getGroupOfRow(0)).size() !=
+			groups.getGroupSize(groups.getGroupOfRow(0)))) {
+		std::cout << "PROBLEM! The groups of the " << aName << " table were wrong." << std::endl;
+		++problems;
+	}
+	return problems;
+}
+
+
+/*
+ * This checks the groups of a column with the same-looking values of
+ * different types - an empty cell and an empty string, the number,
+ * date and string 1, and 0 and -0 - in both layouts.
+ */
+static int checkTypedGroups()
+{
+	CKTable		table(7, 2);
+	table.setColumnHeader(0, "key");
+	table.setColumnHeader(1, "qty");
+	table.setStringValue(1, 0, "");
+	table.setDoubleValue(2, 0, 1.0);
+	table.setStringValue(3, 0, "1");
+	table.setDateValue(4, 0, 1);
+	table.setDoubleValue(5, 0, 0.0);
+	table.setDoubleValue(6, 0, -0.0);
+	for (int i = 0; i < 7; ++i) {
+		table.setDoubleValue(i, 1, 1 << i);
+	}
+
+	int		problems = 0;
+	for (int layout = 0; layout < 2; ++layout) {
+		table.setColumnar(layout == 1);
+		const char	*name = (layout == 1 ? "typed columnar" : "typed");
+		if (table.groupBy(0).getNumGroups() != 6) {
+			std::cout << "PROBLEM! The " << name << " table had " <<
+				table.groupBy(0).getNumGroups() << " groups and not 6." << std::endl;
+			++problems;
+		}
+		for (int op = eSumAggregate; op <= eCountAggregate; ++op) {
+			problems += checkAggregate(table, 0, 1, (CKTableAggregate)op, name);
+		}
+	}
+	return problems;
+}
+
+
+int main(int argc, char *argv[]) {
+	int		rows = (argc > 1 ? atoi(argv[1]) : 1000000);
+	int		threads = (argc > 2 ? atoi(argv[2]) : CKExecutor::getNumberOfProcessors());
+	if (threads < 2) {
+		threads = 2;
+	}
+
+	int		problems = 0;
+	try {
+		CKExecutor	pool(threads);
+
+		// the small tables in each layout, on the calling thread and split up
+		int		sizes[] = { 1, 2, 63, 64, 65, 300, 5000 };
+		for (unsigned int s = 0; s < sizeof(sizes)/sizeof(int); ++s) {
+			CKTable		table = makeTable(sizes[s], s + 1);
+			CKTable		columnar = table;
+			columnar.setColumnar(true);
+			for (int split = 0; split < 2; ++split) {
+				CKTable::setParallelExecutor(split ? &pool : NULL);
+				CKTable::setParallelThreshold(split ? 1 : 0);
+				char	name[64];
+				snprintf(name, sizeof(name), "%d-row%s", sizes[s], (split ? " split" : ""));
+				problems += checkAll(table, name);
+				snprintf(name, sizeof(name), "%d-row columnar%s", sizes[s], (split ? " split" : ""));
+				problems += checkAll(columnar, name);
+			}
+		}
+		CKTable::setParallelExecutor(NULL);
+		CKTable::setParallelThreshold(0);
+		problems += checkTypedGroups();
+		if (problems == 0) {
+			std::cout << "The sorts, filters and groups are OK." << std::endl;
+		}
+
+		/*
+		 * The big table is done the way it used to be - pulling the values
+		 * out into STL containers and back - and then with the table's own
+		 * methods on the calling thread, and split up on the pool.
+		 */
+		CKTable		big = makeTable(rows, 7);
+		big.setColumnar(true);
+		int			cols = big.getNumColumns();
+		double		times[4][3];
+
+		double		start = now();
+		{
+			// sort by price, copying every cell out and back
+			std::vector< std::pair<double, int> >	keys(rows);
+			for (int i = 0; i < rows; ++i) {
+				keys[i] = std::make_pair(big.getDoubleValue(i, PX), i);
+			}
+			std::stable_sort(keys.begin(), keys.end());
+			CKTable		out(rows, cols);
+			for (int i = 0; i < rows; ++i) {
+				out.setRowLabel(i, big.getRowLabel(keys[i].second));
+				for (int j = 0; j < cols; ++j) {
+					out.setValue(i, j, big.getValue(keys[i].second, j));
+				}
+			}
+		}
+		times[0][0] = now() - start;
+		start = now();
+		{
+			// filter on quantity, copying the rows that pass
+			std::vector<int>	keep;
+			for (int i = 0; i < rows; ++i) {
+				if ((big.getType(i, QTY) == eNumberVariant) && (big.getDoubleValue(i, QTY) >= 50.0)) {
+					keep.push_back(i);
+				}
+			}
+			CKTable		out((int)keep.size(), cols);
+			for (unsigned int i = 0; i < keep.size(); ++i) {
+				out.setRowLabel(i, big.getRowLabel(keep[i]));
+				for (int j = 0; j < cols; ++j) {
+					out.setValue(i, j, big.getValue(keep[i], j));
+				}
+			}
+		}
+		times[1][0] = now() - start;
+		start = now();
+		{
+			// the sum of quantity and price for each symbol
+			std::map<std::string, std::pair<double, double> >	sums;
+			for (int i = 0; i < rows; ++i) {
+				std::pair<double, double>	& sum = sums[big.getValueAsString(i, SYM).c_str()];
+				if (big.getType(i, QTY) == eNumberVariant) {
+					sum.first += big.getDoubleValue(i, QTY);
+				}
+				sum.second += big.getDoubleValue(i, PX);
+			}
+		}
+		times[2][0] = now() - start;
+		start = now();
+		{
+			// a two-column sort, copying every cell out
+			std::vector< std::pair<std::string, std::pair<double, int> > >	keys(rows);
+			for (int i = 0; i < rows; ++i) {
+				keys[i].first = big.getValueAsString(i, SYM).c_str();
+				keys[i].second = std::make_pair(-big.getDoubleValue(i, PX), i);
+			}
+			std::stable_sort(keys.begin(), keys.end());
+		}
+		times[3][0] = now() - start;
+
+		CKVector<int>	keyCols;
+		CKVector<bool>	asc;
+		keyCols.addToEnd(SYM);
+		keyCols.addToEnd(PX);
+		asc.addToEnd(true);
+		asc.addToEnd(false);
+		CKVector<int>	aggCols;
+		aggCols.addToEnd(QTY);
+		aggCols.addToEnd(PX);
+		for (int run = 1; run < 3; ++run) {
+			CKTable::setParallelExecutor(run == 2 ? &pool : NULL);
+			CKTable::setParallelThreshold(run == 2 ? 1 : 0);
+
+			CKTable		table = big;
+			start = now();
+			table.sortBy(PX);
+			times[0][run] = now() - start;
+
+			table = big;
+			start = now();
+			table.filter(QTY, eGreaterOrEqualTest, 50.0);
+			times[1][run] = now() - start;
+
+			start = now();
+			CKTable		sums = big.groupBy(SYM).aggregate(aggCols, eSumAggregate);
+			times[2][run] = now() - start;
+
+			start = now();
+			CKVector<int>	order = big.getSortedRows(keyCols, asc);
+			times[3][run] = now() - start;
+		}
+		CKTable::setParallelExecutor(NULL);
+
+		const char	*names[] = { "sort", "filter", "group sum", "2-key order" };
+		std::cout << "On a " << rows << "x" << cols << " columnar table (ms):" << std::endl;
+		std::cout << std::setw(14) << "" << std::setw(12) << "STL copy" <<
+			std::setw(12) << "serial" << std::setw(12) << threads << " threads" << std::endl;
+		std::cout << std::fixed << std::setprecision(1);
+		for (int op = 0; op < 4; ++op) {
+			std::cout << std::setw(14) << names[op];
+			for (int run = 0; run < 3; ++run) {
+				std::cout << std::setw(12) << (times[op][run] * 1000.0);
+			}
+			std::cout << std::endl;
+		}
+	} catch (CKException & e) {
+		problems += problem(e);
+	}
+
+	return finish(problems, "All the sorts, filters and groups match.");
+}
@@ -0,0 +1,247 @@
+/*
+ * This is a test program that exercises the CKFWThread - the affinity
+ * and naming it puts on the thread as it's started, and the metrics it
+ * keeps on its run loop.
+ */
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "CKFWThread.h"
+#include "CKString.h"
+
+/*
+ * This thread just reads back the affinity and name the kernel has for
+ * it, and then it's done.
+ */
+class ProbeThread :
+	public CKFWThread
+{
+	public:
+		ProbeThread() :
+			CKFWThread(cDefaultPolicy, cDefaultPriority, cDefaultScope, 0)
+		{
+			CPU_ZERO(&mask);
+			name[0] = '\0';
+		}
+
+		virtual int process()
+		{
+			pthread_getaffinity_np(pthread_self(), sizeof(mask), &mask);
+			pthread_getname_np(pthread_self(), name, sizeof(name));
+			return cDone;
+		}
+
+		cpu_set_t	mask;
+		char		name[16];
+};
+
+
+/*
+ * This thread sleeps a few milliseconds in each call to process(), and
+ * after the last one it waits to be let go, so that we can look at it
+ * while it's still in the list of running threads.
+ */
+static const int	ITERATIONS = 5;
+static const int	NAP_USEC = 5000;
+
+class NappingThread :
+	public CKFWThread
+{
+	public:
+		NappingThread() :
+			CKFWThread(cDefaultPolicy, cDefaultPriority, cDefaultScope, 0),
+			calls(0),
+			finished(false),
+			release(false)
+		{
+		}
+
+		virtual int process()
+		{
+			usleep(NAP_USEC);
+			if (++calls < ITERATIONS) {
+				return cSuccess;
+			}
+			finished = true;
+			while (!release) {
+				usleep(1000);
+			}
+			return cDone;
+		}
+
+		volatile int	calls;
+		volatile bool	finished;
+		volatile bool	release;
+};
+
+
+/*
+ * This starts the thread, waits for it to finish, and then checks that
+ * it had exactly the CPUs it was supposed to.
+ */
+static bool ranOn( ProbeThread & aThread, const cpu_set_t & anExpected )
+{
+	aThread.start();
+	aThread.join();
+	return CPU_EQUAL(&aThread.mask, &anExpected);
+}
+
+
+int main(int argc, char *argv[]) {
+	bool	ok = true;
+
+	// find the CPUs that we're allowed to use
+	cpu_set_t			all;
+	std::vector<int>	cpus;
+	CPU_ZERO(&all);
+	sched_getaffinity(0, sizeof(all), &all);
+	for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+		if (CPU_ISSET(cpu, &all)) {
+			cpus.push_back(cpu);
+		}
+	}
+	std::cout << "there are " << cpus.size() << " CPUs to use" << std::endl;
+
+	// pinned to one CPU
+	{
+		ProbeThread	t;
+		t.setAffinity(cpus[0]);
+		cpu_set_t	want;
+		CPU_ZERO(&want);
+		CPU_SET(cpus[0], &want);
+		bool	pass = t.hasAffinity() && t.isInAffinity(cpus[0]) && ranOn(t, want);
+		std::cout << "single CPU affinity " << (pass ? "passed" : "FAILED") << std::endl;
+		ok = ok && pass;
+	}
+
+	// ...or a few of them
+	if (cpus.size() > 1) {
+		ProbeThread	t;
+		t.addToAffinity(cpus[0]);
+		t.addToAffinity(cpus[cpus.size() - 1]);
+		cpu_set_t	want;
+		CPU_ZERO(&want);
+		CPU_SET(cpus[0], &want);
+		CPU_SET(cpus[cpus.size() - 1], &want);
+		bool	pass = ranOn(t, want);
+		std::cout << "multi CPU affinity " << (pass ? "passed" : "FAILED") << std::endl;
+		ok = ok && pass;
+	}
+
+	// clearing it leaves the thread wherever the process can be
+	{
+		ProbeThread	t;
+		t.setAffinity(cpus[0]);
+		t.clearAffinity();
+		bool	pass = !t.hasAffinity() && ranOn(t, all);
+		std::cout << "cleared affinity " << (pass ? "passed" : "FAILED") << std::endl;
+		ok = ok && pass;
+	}
+
+	// spreading a few threads around the CPUs
+	{
+		const int	cnt = 3;
+		ProbeThread	t[cnt];
+		CKFWThread	*list[cnt];
+		for (int i = 0; i < cnt; ++i) {
+			list[i] = &t[i];
+		}
+		CKFWThread::pinRoundRobin(list, cnt, &cpus[0], (int)cpus.size());
+		bool	pass = true;
+		for (int i = 0; i < cnt; ++i) {
+			cpu_set_t	want;
+			CPU_ZERO(&want);
+			CPU_SET(cpus[i % cpus.size()], &want);
+			pass = pass && ranOn(t[i], want);
+		}
+		std::cout << "round robin affinity " << (pass ? "passed" : "FAILED") << std::endl;
+		ok = ok && pass;
+	}
+
+	// the tag is the name - what the kernel can hold of it
+	{
+		ProbeThread	t;
+		t.setTag("probeThreadWithALongName");
+		t.start();
+		t.join();
+		bool	pass = (strcmp(t.name, "probeThreadWith") == 0);
+		std::cout << "thread name " << (pass ? "passed" : "FAILED") << std::endl;
+		ok = ok && pass;
+	}
+
+	// the run loop metrics, and the list of running threads
+	{
+		NappingThread	t;
+		t.setTag("napper");
+		int		before = CKFWThread::getLiveThreadCount();
+		t.start();
+		while (!t.finished) {
+			usleep(1000);
+		}
+		std::string	dump = CKFWThread::dumpAll().c_str();
+		bool	pass = (CKFWThread::getLiveThreadCount() == before + 1) &&
+					   CKFWThread::getLiveThreadTags().contains(CKString("napper")) &&
+					   (dump.find("napper") != std::string::npos);
+		std::cout << "registered while running " << (pass ? "passed" : "FAILED") << std::endl;
+		ok = ok && pass;
+
+		t.release = true;
+		t.join();
+		pass = (CKFWThread::getLiveThreadCount() == before) &&
+			   !CKFWThread::getLiveThreadTags().contains(CKString("napper")) &&
+			   (std::string(CKFWThread::dumpAll().c_str()).find("napper") == std::string::npos);
+		std::cout << "unregistered when done " << (pass ? "passed" : "FAILED") << std::endl;
+		ok = ok && pass;
+
+		/*
+		 * Every call slept at least NAP_USEC, so they all have to be in
+		 * the bucket for that or above - bucket i holds calls under 2^i
+		 * usec.
+		 */
+		int				napBucket = 0;
+		while ((NAP_USEC >> napBucket) > 0) {
+			++napBucket;
+		}
+		unsigned long	total = 0;
+		unsigned long	napping = 0;
+		for (int b = 0; b < CKFW_THREAD_HISTOGRAM_BUCKETS; ++b) {
+			total += t.getProcessCount(b);
+			if (b >= napBucket) {
+				napping += t.getProcessCount(b);
+			}
+		}
+		std::cout << t.getMetricsString() << std::endl;
+		pass = (t.getIterationCount() == (unsigned long)ITERATIONS) &&
+			   (total == (unsigned long)ITERATIONS) &&
+			   (napping == (unsigned long)ITERATIONS) &&
+			   (t.getProcessTime() >= ITERATIONS * NAP_USEC / 1.0e6);
+		std::cout << "process histogram " << (pass ? "passed" : "FAILED") << std::endl;
+		ok = ok && pass;
+
+		double	busy = t.getBusyRatio();
+		pass = (busy >= 0.0) && (busy <= 1.0) &&
+			   (t.getElapsedTime() >= t.getProcessTime());
+		std::cout << "busy ratio (" << busy << ") " << (pass ? "passed" : "FAILED") << std::endl;
+		ok = ok && pass;
+
+		t.resetMetrics();
+		pass = (t.getIterationCount() == 0) && (t.getProcessTime() == 0.0);
+		for (int b = 0; b < CKFW_THREAD_HISTOGRAM_BUCKETS; ++b) {
+			pass = pass && (t.getProcessCount(b) == 0);
+		}
+		std::cout << "reset metrics " << (pass ? "passed" : "FAILED") << std::endl;
+		ok = ok && pass;
+	}
+
+	if (!ok) {
+		std::cout << "PROBLEM!" << std::endl;
+		return 1;
+	}
+	return 0;
+}
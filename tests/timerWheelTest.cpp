@@ -0,0 +1,116 @@
+/*
+ * This is a test program that exercises the CKFWTimerWheel - first turned
+ * by hand as an event loop would, and then by its own thread with the
+ * tasks run on a CKExecutor.
+ */
+
+#include <iostream>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "CKFWTimerWheel.h"
+#include "CKExecutor.h"
+
+/*
+ * This task records how late it was in firing.
+ */
+class LateTask :
+	public ICKExecutorTask
+{
+	public:
+		LateTask( unsigned long long aStart, int aDelay ) :
+			start(aStart), delay(aDelay), late(-1) { }
+		virtual void execute()
+		{
+			late = (long)(CKFWTimerWheel::nowInMillis() - start) - delay;
+		}
+
+		unsigned long long	start;
+		int					delay;
+		long				late;
+};
+
+
+/*
+ * This task just counts the times it's been run - it's the heartbeat.
+ */
+class CountTask :
+	public ICKExecutorTask
+{
+	public:
+		CountTask() : count(0) { }
+		virtual void execute()
+		{
+			++count;
+		}
+
+		volatile long	count;
+};
+
+
+int main(int argc, char *argv[]) {
+	// first, turn the wheel by hand like an event loop would
+	CKFWTimerWheel		a;
+	unsigned long long	start = CKFWTimerWheel::nowInMillis();
+	int					delays[] = { 0, 5, 300, 1200 };
+	LateTask			*tasks[4];
+	for (int i = 0; i < 4; ++i) {
+		tasks[i] = new LateTask(start, delays[i]);
+		a.schedule(tasks[i], delays[i]);
+	}
+	CKFWTimerHandle		h = a.schedule(new LateTask(start, 50), 50, 0, true);
+	std::cout << "a.size = " << a.size() << std::endl;
+	std::cout << "cancel: " << a.cancel(h) << ", again: " << a.cancel(h) << std::endl;
+	while (a.size() > 0) {
+		usleep(a.getMillisUntilNextTimer() * 1000);
+		a.runExpired();
+	}
+	bool	ok = true;
+	for (int i = 0; i < 4; ++i) {
+		std::cout << "timer " << delays[i] << " msec was " << tasks[i]->late <<
+			" msec late" << std::endl;
+		ok = ok && (tasks[i]->late >= 0);
+		delete tasks[i];
+	}
+
+	/*
+	 * A timer can never go off before its delay - even when it's set
+	 * part of the way into a long tick, where counting from the start
+	 * of the tick would have it a tick early.
+	 */
+	CKFWTimerWheel		c(10);
+	bool				onTime = true;
+	for (int i = 0; i < 20; ++i) {
+		usleep((i % 10) * 1000);
+		LateTask	t(CKFWTimerWheel::nowInMillis(), 10);
+		c.schedule(&t, 10);
+		while (c.size() > 0) {
+			usleep(c.getMillisUntilNextTimer() * 1000);
+			c.runExpired();
+		}
+		if (t.late < 0) {
+			std::cout << "a 10 msec timer on a 10 msec tick went off after " <<
+				(10 + t.late) << " msec" << std::endl;
+			onTime = false;
+		}
+	}
+	std::cout << "minimum delay " << (onTime ? "passed" : "FAILED") << std::endl;
+	ok = ok && onTime;
+
+	// now let the wheel's thread turn it with the tasks on a pool
+	CKExecutor			pool(2);
+	CKFWTimerWheel		b(1, &pool);
+	CountTask			beat;
+	b.start();
+	h = b.schedule(&beat, 10, 10);
+	usleep(505000);
+	b.cancel(h);
+	b.stop();
+	std::cout << "heartbeat ran " << beat.count << " times (about 50)" << std::endl;
+
+	if (!ok) {
+		std::cout << "PROBLEM!" << std::endl;
+		return 1;
+	}
+	return 0;
+}
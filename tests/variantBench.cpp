@@ -0,0 +1,143 @@
+/*
+ * This is a test program that measures how fast we can populate a tree of
+ * CKDataNodes with the typical mix of variables - short strings, numbers
+ * and prices - and how fast a std::vector of CKVariants can be grown and
+ * shuffled. It also checks that swap() (and the moves, if the compiler
+ * has them) leave the variants holding what they should. Run it as:
+ *
+ *     variantBench [nodes] [vars per node]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "CKDataNode.h"
+#include "CKVariant.h"
+#include "CKPrice.h"
+#include "CKTable.h"
+#include "CKString.h"
+#include "benchUtils.h"
+
+/*
+ * This checks the swaps and moves, and returns the number of problems.
+ */
+static int checkSwaps()
+{
+	int		problems = 0;
+
+	// two strings just swap their buffers
+	CKVariant	a("alpha");
+	CKVariant	b("a much longer string than the first one");
+	a.swap(b);
+	if ((a != "a much longer string than the first one") || (b != "alpha")) {
+		std::cout << "PROBLEM! The strings didn't swap: a=" << a << " b=" << b << std::endl;
+		++problems;
+	}
+
+	// a price and a table swap through the other path
+	CKPrice		p(1.5, 2.5);
+	CKTable		t(2, 2);
+	t.setDoubleValue(1, 1, 42.0);
+	CKVariant	c(&p);
+	CKVariant	d(&t);
+	c.swap(d);
+	if ((c.getType() != eTableVariant) || (c.getTableValue()->getDoubleValue(1, 1) != 42.0) ||
+		(d.getType() != ePriceVariant) || (*d.getPriceValue() != p)) {
+		std::cout << "PROBLEM! The price and table didn't swap: c=" << c << " d=" << d << std::endl;
+		++problems;
+	}
+
+	// ...and a string and a number
+	CKVariant	e("seven");
+	CKVariant	f(7.0);
+	e.swap(f);
+	if ((e.getType() != eNumberVariant) || (e.getDoubleValue() != 7.0) || (f != "seven")) {
+		std::cout << "PROBLEM! The string and number didn't swap: e=" << e << " f=" << f << std::endl;
+		++problems;
+	}
+
+#if __cplusplus >= 201103L
+	// a move leaves the source empty
+	CKVariant	g(std::move(c));
+	if ((g.getType() != eTableVariant) || (c.getType() != eUnknownVariant)) {
+		std::cout << "PROBLEM! The move constructor didn't take the table." << std::endl;
+		++problems;
+	}
+	CKVariant	h;
+	h = std::move(b);
+	if ((h != "alpha") || (b.getType() != eUnknownVariant)) {
+		std::cout << "PROBLEM! The move assignment didn't take the string." << std::endl;
+		++problems;
+	}
+#endif
+
+	return problems;
+}
+
+
+int main(int argc, char *argv[]) {
+	int		nodes = (argc > 1 ? atoi(argv[1]) : 2000);
+	int		vars = (argc > 2 ? atoi(argv[2]) : 50);
+
+	int		problems = checkSwaps();
+	if (problems == 0) {
+		std::cout << "Swaps and moves are OK." << std::endl;
+	}
+
+	// populate the tree with a mix of values
+	char			name[64];
+	CKPrice			price(10.25, 13.50);
+	double			start = now();
+	CKDataNode		*root = new CKDataNode();
+	root->setName("root");
+	for (int n = 0; n < nodes; ++n) {
+		snprintf(name, sizeof(name), "node%d", n);
+		CKDataNode	*kid = new CKDataNode(root, name);
+		for (int v = 0; v < vars; ++v) {
+			snprintf(name, sizeof(name), "var%d", v);
+			switch (v % 3) {
+				case 0:
+					kid->putVar(name, CKVariant("IBM"));
+					break;
+				case 1:
+					kid->putVar(name, CKVariant((double)v));
+					break;
+				case 2:
+					kid->putVar(name, CKVariant(&price));
+					break;
+			}
+		}
+	}
+	double			fill = now() - start;
+	start = now();
+	CKDataNode::deleteNodeDeep(root);
+	double			clean = now() - start;
+
+	long	total = (long)nodes * vars;
+	std::cout << std::fixed << std::setprecision(0);
+	std::cout << "Populated " << nodes << " nodes with " << total << " vars at " <<
+		(total/fill) << " vars/sec, and deleted them at " << (total/clean) <<
+		" vars/sec." << std::endl;
+
+	// grow a vector of strings and prices, and reverse it with swaps
+	start = now();
+	std::vector<CKVariant>	list;
+	for (long i = 0; i < total; ++i) {
+		if (i % 2 == 0) {
+			list.push_back(CKVariant("MSFT"));
+		} else {
+			list.push_back(CKVariant(&price));
+		}
+	}
+	for (long i = 0, j = (long)list.size() - 1; i < j; ++i, --j) {
+		list[i].swap(list[j]);
+	}
+	double			grow = now() - start;
+	std::cout << "Grew and reversed a vector of " << total << " variants at " <<
+		(total/grow) << " variants/sec." << std::endl;
+
+	return finish(problems);
+}
@@ -0,0 +1,220 @@
+/*
+ * This is a test program that exercises the CKVariantList by doing a
+ * long run of random operations on it and on a std::deque of the same
+ * values, and making sure the two always agree.
+ */
+
+#include <iostream>
+#include <deque>
+#include <stdlib.h>
+
+#include "CKVariant.h"
+#include "CKException.h"
+
+// the put*() methods are deprecated, but they still have to work
+#if defined(__GNUC__)
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+#endif
+
+/*
+ * This checks that the list has the values of the deque, in order,
+ * walking it from the head, from the tail, and by index.
+ */
+static bool same( const CKVariantList & aList, const std::deque<double> & aDeque )
+{
+	if (aList.size() != (int)aDeque.size()) {
+		return false;
+	}
+	int		i = 0;
+	for (CKVariantNode *n = aList.getHead(); n != NULL; n = n->getNext()) {
+		if ((i >= (int)aDeque.size()) || (n->getDoubleValue() != aDeque[i])) {
+			return false;
+		}
+		++i;
+	}
+	if (i != (int)aDeque.size()) {
+		return false;
+	}
+	for (CKVariantNode *n = aList.getTail(); n != NULL; n = n->getPrev()) {
+		if ((--i < 0) || (n->getDoubleValue() != aDeque[i])) {
+			return false;
+		}
+	}
+	if (i != 0) {
+		return false;
+	}
+	for (i = 0; i < (int)aDeque.size(); ++i) {
+		if (aList[i].getDoubleValue() != aDeque[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+/*
+ * This makes a list and a deque of a few random values.
+ */
+static void fill( CKVariantList & aList, std::deque<double> & aDeque, int aCount )
+{
+	for (int i = 0; i < aCount; ++i) {
+		double	v = rand() % 1000;
+		aList.addToEnd(CKVariant(v));
+		aDeque.push_back(v);
+	}
+}
+
+
+int main(int argc, char *argv[]) {
+	bool	ok = true;
+	srand(42);
+
+	// do a long run of random operations on both
+	CKVariantList		list;
+	std::deque<double>	deque;
+	int					maxCap = 0;
+	for (int step = 0; ok && (step < 20000); ++step) {
+		double	v = rand() % 1000;
+		switch (rand() % 11) {
+			case 0:
+			case 1:
+				list.addToFront(CKVariant(v));
+				deque.push_front(v);
+				break;
+			case 2:
+			case 3:
+				list.addToEnd(CKVariant(v));
+				deque.push_back(v);
+				break;
+			case 4:
+				list.putOnFront(new CKVariantNode(CKVariant(v)));
+				deque.push_front(v);
+				break;
+			case 5:
+				list.putOnEnd(new CKVariantNode(CKVariant(v)));
+				deque.push_back(v);
+				break;
+			case 6:
+				{
+					CKVariantList		other;
+					std::deque<double>	more;
+					fill(other, more, rand() % 20);
+					list.spliceOnFront(other);
+					deque.insert(deque.begin(), more.begin(), more.end());
+					if (!other.empty()) {
+						std::cout << "spliceOnFront left values in the other list" << std::endl;
+						ok = false;
+					}
+				}
+				break;
+			case 7:
+				{
+					CKVariantList		other;
+					std::deque<double>	more;
+					fill(other, more, rand() % 20);
+					list.spliceOnEnd(other);
+					deque.insert(deque.end(), more.begin(), more.end());
+					if (!other.empty()) {
+						std::cout << "spliceOnEnd left values in the other list" << std::endl;
+						ok = false;
+					}
+				}
+				break;
+			case 8:
+				{
+					CKVariantList		other;
+					std::deque<double>	more;
+					fill(other, more, rand() % 20);
+					if (rand() % 2 == 0) {
+						list.copyToFront(other);
+						deque.insert(deque.begin(), more.begin(), more.end());
+					} else {
+						list.copyToEnd(other);
+						deque.insert(deque.end(), more.begin(), more.end());
+					}
+					if (!same(other, more)) {
+						std::cout << "copyTo*() changed the other list" << std::endl;
+						ok = false;
+					}
+				}
+				break;
+			case 9:
+				{
+					int		cap = list.size() + rand() % 50;
+					list.reserve(cap);
+					if (list.capacity() < cap) {
+						std::cout << "reserve(" << cap << ") left the capacity at "
+							<< list.capacity() << std::endl;
+						ok = false;
+					}
+				}
+				break;
+			case 10:
+				if (rand() % 4 == 0) {
+					list.clear();
+					deque.clear();
+				}
+				break;
+		}
+		if (list.capacity() > maxCap) {
+			maxCap = list.capacity();
+		}
+		if (!same(list, deque)) {
+			std::cout << "the list and deque differ after step " << step << std::endl;
+			ok = false;
+		}
+	}
+	std::cout << "random operations " << (ok ? "passed" : "FAILED") << std::endl;
+
+	// the capacity has to stay in line with the most it ever held
+	bool	capOK = (maxCap <= 4 * 500);
+	std::cout << "bounded capacity (" << maxCap << ") "
+		<< (capOK ? "passed" : "FAILED") << std::endl;
+	ok = ok && capOK;
+
+	// reusing it after clear() over and over mustn't grow it
+	bool	reuseOK = true;
+	CKVariantList	again;
+	for (int i = 0; i < 1000; ++i) {
+		again.clear();
+		std::deque<double>	d;
+		for (int j = 0; j < 5; ++j) {
+			again.addToFront(CKVariant((double)j));
+			d.push_front(j);
+		}
+		if (!same(again, d) || (again.capacity() > 16)) {
+			reuseOK = false;
+		}
+	}
+	std::cout << "reuse after clear() " << (reuseOK ? "passed" : "FAILED") << std::endl;
+	ok = ok && reuseOK;
+
+	// the nodes of a list can't be taken out of it
+	bool	threw = false;
+	try {
+		list.clear();
+		list.addToEnd(CKVariant(1.0));
+		list.getHead()->removeFromList();
+	} catch (CKException & e) {
+		threw = true;
+	}
+	std::cout << "removeFromList() on a list node " << (threw ? "passed" : "FAILED") << std::endl;
+	ok = ok && threw && (list.size() == 1);
+
+	// ...but a free-standing one is fine
+	CKVariantNode	*a = new CKVariantNode(CKVariant(1.0));
+	CKVariantNode	*b = new CKVariantNode(CKVariant(2.0), a, NULL);
+	a->setNext(b);
+	b->removeFromList();
+	bool	freeOK = (a->getNext() == NULL) && (b->getPrev() == NULL);
+	delete a;
+	delete b;
+	std::cout << "removeFromList() on a free node " << (freeOK ? "passed" : "FAILED") << std::endl;
+	ok = ok && freeOK;
+
+	if (!ok) {
+		std::cout << "PROBLEM!" << std::endl;
+		return 1;
+	}
+	return 0;
+}